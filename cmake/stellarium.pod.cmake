@@ -62,6 +62,28 @@ instead of the default (which is $HOME on *nix operating systems).
 
 Specify name of startup script.
 
+=item B<--headless>
+
+Render to an offscreen surface without showing a window, e.g. for batch 
+rendering on machines without a display. The "offscreen" Qt platform is 
+used unless the QT_QPA_PLATFORM environment variable is set. The program 
+quits when the startup script has finished.
+
+=item B<--frame-step> I<seconds>
+
+Advance the simulation by I<seconds> per rendered frame instead of by the 
+system clock, and render as fast as possible. Script waits count simulated 
+time. Defaults to 1/30 with B<--headless>; 0 follows the system clock.
+
+=item B<--frame-size> I<width>xI<height>
+
+Size of the offscreen surface with B<--headless>, e.g. 1920x1080.
+
+=item B<--frame-sequence> I<prefix>
+
+Save every rendered frame into the screenshot directory, with file names 
+starting with I<prefix>.
+
 =item B<--home-planet> I<planet-name>
 
 Specify observer planet. I<planet-name> is an English name, and should 
@@ -30,6 +30,7 @@
 #include "StelSkyDrawer.hpp"
 #include "StelLocaleMgr.hpp"
 #include "StarMgr.hpp"
+#include "StelMarkerBatch.hpp"
 
 #include <QTextStream>
 #include <QDebug>
@@ -73,6 +74,7 @@ Exoplanet::Exoplanet(const QVariantMap& map)
 	starProperName = map.value("starProperName").toString();
 	RA = StelUtils::getDecAngle(map.value("RA").toString());
 	DE = StelUtils::getDecAngle(map.value("DE").toString());
+	StelUtils::spheToRect(RA, DE, XYZ);
 	distance = map.value("distance").toFloat();
 	stype = map.value("stype").toString();
 	smass = map.value("smass").toFloat();
@@ -607,7 +609,7 @@ void Exoplanet::update(double deltaTime)
 	labelsFader.update((int)(deltaTime*1000));
 }
 
-void Exoplanet::draw(StelCore* core, StelPainter *painter)
+void Exoplanet::draw(StelCore* core, StelPainter *painter, StelMarkerBatch& batch)
 {
 	bool visible;
 	StelSkyDrawer* sd = core->getSkyDrawer();
@@ -617,12 +619,6 @@ void Exoplanet::draw(StelCore* core, StelPainter *painter)
 	if (hasHabitableExoplanets)
 		color = habitableExoplanetMarkerColor;
 
-	StelUtils::spheToRect(RA, DE, XYZ);
-	double mag = getVMagnitudeWithExtinction(core);
-
-	painter->setBlending(true, GL_ONE, GL_ONE);
-	painter->setColor(color[0], color[1], color[2], 1);
-
 	if (timelineMode)
 	{
 		visible = isDiscovered(core);
@@ -638,24 +634,25 @@ void Exoplanet::draw(StelCore* core, StelPainter *painter)
 			return;
 	}
 
-	Vec3d win;
-	// Check visibility of exoplanet system
-	if(!visible || !(painter->getProjector()->projectCheck(XYZ, win))) {return;}
+	if (!visible)
+		return;
 
+	double mag = getVMagnitudeWithExtinction(core);
 	float mlimit = sd->getLimitMagnitude();
 
 	if (mag <= mlimit)
 	{		
-		Exoplanet::markerTexture->bind();
 		float size = getAngularSize(Q_NULLPTR)*M_PI/180.*painter->getProjector()->getPixelPerRadAtCenter();
 		float shift = 5.f + size/1.6f;
 
-		painter->drawSprite2dMode(XYZ, distributionMode ? 4.f : 5.f);
+		// Check visibility of exoplanet system
+		if (!batch.addMarker(XYZ, distributionMode ? 4.f : 5.f, color))
+			return;
 
 		float coeff = 4.5f + std::log10(sradius + 0.1f);
 		if (labelsFader.getInterstate()<=0.f && !distributionMode && (mag+coeff)<mlimit && smgr->getFlagLabels() && showDesignations)
 		{
-			painter->drawText(XYZ, getNameI18n(), 0, shift, shift, false);
+			batch.addLabel(XYZ, getNameI18n(), color, shift);
 		}
 	}
 }
@@ -51,6 +51,7 @@ typedef struct
 } exoplanetData;
 
 class StelPainter;
+class StelMarkerBatch;
 
 //! @class Exoplanet
 //! A exoplanet object represents one planetary system on the sky.
@@ -197,7 +198,8 @@ private:
 	static bool habitableMode;
 	static bool showDesignations;
 
-	void draw(StelCore* core, StelPainter *painter);
+	//! Add the marker and label of the exoplanetary system to the batch.
+	void draw(StelCore* core, StelPainter *painter, StelMarkerBatch& batch);
 
 	int EPCount;
 	int PHEPCount;
@@ -119,6 +119,7 @@ Exoplanets::~Exoplanets()
 void Exoplanets::deinit()
 {
 	ep.clear();
+	visibleEp.clear();
 	Exoplanet::markerTexture.clear();
 	texPointer.clear();
 }
@@ -226,12 +227,16 @@ void Exoplanets::draw(StelCore* core)
 	StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 	StelPainter painter(prj);
 	painter.setFont(font);
-	
-	foreach (const ExoplanetP& eps, ep)
-	{
-		if (eps && eps->initialized)
-			eps->draw(core, &painter);
-	}
+
+	// Only the systems inside the viewport are drawn. The margin keeps the markers of systems just outside.
+	const float margin = 20.f*prj->getDevicePixelsPerPixel();
+	const SphericalRegionP viewport = prj->getViewportConvexPolygon(margin, margin);
+	ep.findInRegion(viewport.data(), visibleEp);
+
+	markerBatch.begin(prj);
+	foreach (const ExoplanetP& eps, visibleEp)
+		eps->draw(core, &painter, markerBatch);
+	markerBatch.draw(painter, Exoplanet::markerTexture);
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
 		drawPointer(core, painter);
@@ -266,22 +271,9 @@ QList<StelObjectP> Exoplanets::searchAround(const Vec3d& av, double limitFov, co
 	if (!flagShowExoplanets)
 		return result;
 
-	Vec3d v(av);
-	v.normalize();
-	double cosLimFov = cos(limitFov * M_PI/180.);
-	Vec3d equPos;
-
-	foreach(const ExoplanetP& eps, ep)
+	foreach(const ExoplanetP& eps, ep.searchAround(av, limitFov))
 	{
-		if (eps->initialized)
-		{
-			equPos = eps->XYZ;
-			equPos.normalize();
-			if (equPos[0]*v[0] + equPos[1]*v[1] + equPos[2]*v[2]>=cosLimFov)
-			{
-				result.append(qSharedPointerCast<StelObject>(eps));
-			}
-		}
+		result.append(qSharedPointerCast<StelObject>(eps));
 	}
 
 	return result;
@@ -292,39 +284,13 @@ StelObjectP Exoplanets::searchByName(const QString& englishName) const
 	if (!flagShowExoplanets)
 		return Q_NULLPTR;
 
-	foreach(const ExoplanetP& eps, ep)
-	{
-		if (eps->getEnglishName().toUpper() == englishName.toUpper() || eps->getDesignation().toUpper() == englishName.toUpper())
-			return qSharedPointerCast<StelObject>(eps);
-
-		QStringList ppn = eps->getExoplanetsEnglishNames();
-		if (!ppn.isEmpty())
-		{
-			foreach (const QString &str, ppn)
-			{
-				if (str.toUpper() == englishName.toUpper())
-					return qSharedPointerCast<StelObject>(eps);
-			}
-		}
-
-		ppn = eps->getExoplanetsDesignations();
-		if (!ppn.isEmpty())
-		{
-			foreach (const QString &str, ppn)
-			{
-				if (str.toUpper() == englishName.toUpper())
-					return qSharedPointerCast<StelObject>(eps);
-			}
-		}
-
-	}
-
-	return Q_NULLPTR;
+	// The names of the systems and of their planets are all in the index
+	return qSharedPointerCast<StelObject>(ep.searchByName(englishName));
 }
 
 StelObjectP Exoplanets::searchByID(const QString &id) const
 {
-	foreach(const ExoplanetP& eps, ep)
+	foreach(const ExoplanetP& eps, ep.getObjects())
 	{
 		if(eps->getID() == id)
 			return qSharedPointerCast<StelObject>(eps);
@@ -337,7 +303,8 @@ StelObjectP Exoplanets::searchByNameI18n(const QString& nameI18n) const
 	if (!flagShowExoplanets)
 		return Q_NULLPTR;
 
-	foreach(const ExoplanetP& eps, ep)
+	// The translated names depend on the language, so they are not indexed
+	foreach(const ExoplanetP& eps, ep.getObjects())
 	{
 		if (eps->getNameI18n().toUpper() == nameI18n.toUpper() || eps->getDesignation().toUpper() == nameI18n.toUpper())
 			return qSharedPointerCast<StelObject>(eps);
@@ -364,7 +331,7 @@ QStringList Exoplanets::listMatchingObjects(const QString& objPrefix, int maxNbI
 		return result;
 	}
 
-	foreach(const ExoplanetP& eps, ep)
+	foreach(const ExoplanetP& eps, ep.getObjects())
 	{
 		QStringList names;
 		if (inEnglish)
@@ -404,17 +371,17 @@ QStringList Exoplanets::listAllObjects(bool inEnglish) const
 	if (!flagShowExoplanets)
 		return result;
 
-	foreach (const ExoplanetP& planet, ep)
+	foreach (const ExoplanetP& planet, ep.getObjects())
 		result << planet->getExoplanetsDesignations();
 
 	if (inEnglish)
 	{
-		foreach (const ExoplanetP& planet, ep)
+		foreach (const ExoplanetP& planet, ep.getObjects())
 			result << planet->getExoplanetsEnglishNames();
 	}
 	else
 	{
-		foreach (const ExoplanetP& planet, ep)
+		foreach (const ExoplanetP& planet, ep.getObjects())
 			result << planet->getExoplanetsNamesI18n();
 	}
 	return result;
@@ -573,7 +540,8 @@ void Exoplanets::setEPMap(const QVariantMap& map)
 		ExoplanetP eps(new Exoplanet(epsData));
 		if (eps->initialized)
 		{
-			ep.append(eps);
+			ep.insert(eps, eps->XYZ, QStringList() << eps->getEnglishName() << eps->getDesignation()
+						      << eps->getExoplanetsEnglishNames() << eps->getExoplanetsDesignations());
 			EPEccentricityAll.append(eps->getData(0));
 			EPSemiAxisAll.append(eps->getData(1));
 			EPMassAll.append(eps->getData(2));
@@ -644,9 +612,9 @@ bool Exoplanets::checkJsonFileFormat() const
 
 ExoplanetP Exoplanets::getByID(const QString& id)
 {
-	foreach(const ExoplanetP& eps, ep)
+	foreach(const ExoplanetP& eps, ep.getObjects())
 	{
-		if (eps->initialized && eps->designation == id)
+		if (eps->designation == id)
 			return eps;
 	}
 	return ExoplanetP();
@@ -23,6 +23,8 @@
 #include "StelObject.hpp"
 #include "StelFader.hpp"
 #include "StelTextureTypes.hpp"
+#include "StelCatalogIndex.hpp"
+#include "StelMarkerBatch.hpp"
 #include "Exoplanet.hpp"
 #include <QFont>
 #include <QVariantMap>
@@ -361,7 +363,11 @@ private:
 		      EPRAHostStarAll, EPDecHostStarAll, EPDistanceHostStarAll, EPMassHostStarAll, EPRadiusHostStarAll;
 
 	StelTextureSP texPointer;
-	QList<ExoplanetP> ep;
+	//! The exoplanetary systems of the catalog, indexed by position and English names
+	StelCatalogIndex<Exoplanet> ep;
+	//! The exoplanetary systems inside the viewport in the current frame
+	QVector<ExoplanetP> visibleEp;
+	StelMarkerBatch markerBatch;
 
 	// variables and functions for the updater
 	UpdateState updateState;
@@ -174,7 +174,7 @@ MeteorShower::MeteorShower(MeteorShowersMgr* mgr, const QVariantMap& map)
 			QVariantMap colorMap = ms.toMap();
 			QString color = colorMap.value("color").toString();
 			int intensity = colorMap.value("intensity").toInt();
-			m_colors.append(Meteor::ColorPair(color, intensity));
+			m_colors.append(MeteorPool::ColorPair(color, intensity));
 			totalIntensity += intensity;
 		}
 
@@ -188,7 +188,7 @@ MeteorShower::MeteorShower(MeteorShowersMgr* mgr, const QVariantMap& map)
 	}
 
 	if (m_colors.isEmpty()) {
-		m_colors.push_back(Meteor::ColorPair("white", 100));
+		m_colors.push_back(MeteorPool::ColorPair("white", 100));
 	}
 
 	m_status = UNDEFINED;
@@ -196,8 +196,6 @@ MeteorShower::MeteorShower(MeteorShowersMgr* mgr, const QVariantMap& map)
 
 MeteorShower::~MeteorShower()
 {
-	qDeleteAll(m_activeMeteors);
-	m_activeMeteors.clear();
 	m_colors.clear();
 }
 
@@ -265,16 +263,8 @@ void MeteorShower::update(StelCore* core, double deltaTime)
 		m_radiantDelta += m_driftDelta * daysToPeak;
 	}
 
-	// step through and update all active meteors
-	foreach (MeteorObj* m, m_activeMeteors)
-	{
-		if (!m->update(deltaTime))
-		{
-			//important to delete when no longer active
-			delete m;
-			m_activeMeteors.removeOne(m);
-		}
-	}
+	// update all active meteors, dead ones free their slot in the pool
+	m_meteors.update(core, deltaTime);
 
 	// paused | forward | backward ?
 	// don't create new meteors
@@ -303,15 +293,28 @@ void MeteorShower::update(StelCore* core, double deltaTime)
 		float prob = (float) qrand() / (float) RAND_MAX;
 		if (prob < rate)
 		{
-			MeteorObj *m = new MeteorObj(core, m_speed, m_radiantAlpha, m_radiantDelta,
-						     m_pidx, m_colors, m_mgr->getBolideTexture());
-			if (m->isAlive())
+			// if speed is zero, use a random value
+			int speed = m_speed;
+			if (!speed)
 			{
-				m_activeMeteors.append(m);
+				speed = 11 + (double)qrand() / ((double)RAND_MAX + 1) * 61;  // abs range 11-72 km/s
 			}
-			else
+
+			const int slot = m_meteors.spawn(core, m_radiantAlpha, m_radiantDelta, speed, m_colors);
+
+			// implements the population index (pidx) - usually a decimal between 2 and 4
+			if (slot >= 0 && m_pidx > 1.f)
 			{
-				delete m;
+				// higher pidx implies a larger fraction of faint meteors than average
+				float faintProb = (float) qrand() / ((float) RAND_MAX + 1);
+				if (faintProb > 1.f / m_pidx)
+				{
+					// Increase the absolute magnitude ([-3; 4.5]) in 1.5!
+					// As we are working on a 0-1 scale (where 1 is brighter),
+					// more 1.5 means less 0.2!
+					MeteorPool& pool = m_meteors.getPool();
+					pool.setAbsMag(slot, pool.getAbsMag(slot) - 0.2f);
+				}
 			}
 		}
 	}
@@ -388,12 +391,10 @@ void MeteorShower::drawMeteors(StelCore *core)
 		return;
 	}
 
-	// step through and draw all active meteors
+	// draw all active meteors at once
 	StelPainter painter(core->getProjection(StelCore::FrameAltAz));
-	foreach (MeteorObj* m, m_activeMeteors)
-	{
-		m->draw(core, painter);
-	}
+	m_meteors.setBolideTexture(m_mgr->getBolideTexture());
+	m_meteors.draw(core, painter);
 }
 
 MeteorShower::Activity MeteorShower::hasGenericShower(QDate date, bool &found) const
@@ -27,6 +27,7 @@
 #include "StarMgr.hpp"
 #include "StelLocaleMgr.hpp"
 #include "StelPainter.hpp"
+#include "StelMarkerBatch.hpp"
 
 #include <QTextStream>
 #include <QDebug>
@@ -72,6 +73,7 @@ Nova::Nova(const QVariantMap& map)
 	m9 = map.value("m9", -1).toInt();
 	RA = StelUtils::getDecAngle(map.value("RA").toString());
 	Dec = StelUtils::getDecAngle(map.value("Dec").toString());	
+	StelUtils::spheToRect(RA, Dec, XYZ);
 	distance = map.value("distance").toDouble();
 
 	initialized = true;
@@ -324,7 +326,7 @@ void Nova::update(double deltaTime)
 	labelsFader.update((int)(deltaTime*1000));
 }
 
-void Nova::draw(StelCore* core, StelPainter* painter)
+void Nova::draw(StelCore* core, StelPainter* painter, StelMarkerBatch& batch)
 {
 	StelSkyDrawer* sd = core->getSkyDrawer();
 	StarMgr* smgr = GETSTELMODULE(StarMgr); // It's need for checking displaying of labels for stars
@@ -334,24 +336,19 @@ void Nova::draw(StelCore* core, StelPainter* painter)
 	float size, shift;
 	double mag;
 
-	StelUtils::spheToRect(RA, Dec, XYZ);
 	mag = getVMagnitudeWithExtinction(core);
-	sd->preDrawPointSource(painter);
 	float mlimit = sd->getLimitMagnitude();
 
 	if (mag <= mlimit)
 	{
 		sd->computeRCMag(mag, &rcMag);
 		sd->drawPointSource(painter, Vec3f(XYZ[0],XYZ[1],XYZ[2]), rcMag, color, false);
-		painter->setColor(color[0], color[1], color[2], 1.f);
 		size = getAngularSize(Q_NULLPTR)*M_PI/180.*painter->getProjector()->getPixelPerRadAtCenter();
 		shift = 6.f + size/1.8f;
 		if (labelsFader.getInterstate()<=0.f && (mag+5.f)<mlimit && smgr->getFlagLabels())
 		{
 			QString name = novaName.isEmpty() ? designation : novaName;
-			painter->drawText(XYZ, name, 0, shift, shift, false);
+			batch.addLabel(XYZ, name, color, shift);
 		}
 	}
-
-	sd->postDrawPointSource(painter);
 }
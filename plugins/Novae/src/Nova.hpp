@@ -31,6 +31,7 @@
 #include "StelProjectorType.hpp"
 
 class StelPainter;
+class StelMarkerBatch;
 
 //! @class Nova
 //! A Nova object represents one nova on the sky.
@@ -97,7 +98,9 @@ private:
 
 	Vec3d XYZ;                         // holds J2000 position
 
-	void draw(StelCore* core, StelPainter* painter);
+	//! Draw the nova as a point source and add its label to the batch.
+	//! Must be called between StelSkyDrawer::preDrawPointSource() and postDrawPointSource().
+	void draw(StelCore* core, StelPainter* painter, StelMarkerBatch& batch);
 
 	// Nova
 	QString designation;		//! The ID of the nova
@@ -27,6 +27,7 @@
 #include "StelJsonParser.hpp"
 #include "StelFileMgr.hpp"
 #include "StelUtils.hpp"
+#include "StelSkyDrawer.hpp"
 #include "StelPainter.hpp"
 #include "StelTranslator.hpp"
 #include "StelTextureMgr.hpp"
@@ -194,14 +195,21 @@ void Novae::draw(StelCore* core)
 	StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 	StelPainter painter(prj);
 	painter.setFont(font);
-	
-	foreach (const NovaP& n, nova)
+
+	// Only the novae inside the viewport are drawn. The margin keeps the halos of novae just outside.
+	const float margin = 20.f*prj->getDevicePixelsPerPixel();
+	const SphericalRegionP viewport = prj->getViewportConvexPolygon(margin, margin);
+	nova.findInRegion(viewport.data(), visibleNovae);
+
+	StelSkyDrawer* sd = core->getSkyDrawer();
+	markerBatch.begin(prj);
+	sd->preDrawPointSource(&painter);
+	foreach (const NovaP& n, visibleNovae)
 	{
-		if (n && n->initialized)
-		{
-			n->draw(core, &painter);
-		}
+		n->draw(core, &painter, markerBatch);
 	}
+	sd->postDrawPointSource(&painter);
+	markerBatch.draw(painter, StelTextureSP());
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
 	{
@@ -234,22 +242,9 @@ QList<StelObjectP> Novae::searchAround(const Vec3d& av, double limitFov, const S
 {
 	QList<StelObjectP> result;
 
-	Vec3d v(av);
-	v.normalize();
-	double cosLimFov = cos(limitFov * M_PI/180.);
-	Vec3d equPos;
-
-	foreach(const NovaP& n, nova)
+	foreach(const NovaP& n, nova.searchAround(av, limitFov))
 	{
-		if (n->initialized)
-		{
-			equPos = n->XYZ;
-			equPos.normalize();
-			if (equPos[0]*v[0] + equPos[1]*v[1] + equPos[2]*v[2]>=cosLimFov)
-			{
-				result.append(qSharedPointerCast<StelObject>(n));
-			}
-		}
+		result.append(qSharedPointerCast<StelObject>(n));
 	}
 
 	return result;
@@ -257,18 +252,13 @@ QList<StelObjectP> Novae::searchAround(const Vec3d& av, double limitFov, const S
 
 StelObjectP Novae::searchByName(const QString& englishName) const
 {
-	foreach(const NovaP& n, nova)
-	{
-		if (n->getEnglishName().toUpper() == englishName.toUpper() || n->getDesignation().toUpper() == englishName.toUpper())
-			return qSharedPointerCast<StelObject>(n);
-	}
-
-	return Q_NULLPTR;
+	return qSharedPointerCast<StelObject>(nova.searchByName(englishName));
 }
 
 StelObjectP Novae::searchByNameI18n(const QString& nameI18n) const
 {
-	foreach(const NovaP& n, nova)
+	// The translated names depend on the language, so they are not indexed
+	foreach(const NovaP& n, nova.getObjects())
 	{
 		if (n->getNameI18n().toUpper() == nameI18n.toUpper() || n->getDesignation().toUpper() == nameI18n.toUpper())
 			return qSharedPointerCast<StelObject>(n);
@@ -288,7 +278,7 @@ QStringList Novae::listMatchingObjects(const QString& objPrefix, int maxNbItem,
 	QStringList names;
 	if (inEnglish)
 	{
-		foreach(const NovaP& n, nova)
+		foreach(const NovaP& n, nova.getObjects())
 		{
 			names.append(n->getEnglishName());
 			names.append(n->getDesignation());
@@ -296,7 +286,7 @@ QStringList Novae::listMatchingObjects(const QString& objPrefix, int maxNbItem,
 	}
 	else
 	{
-		foreach(const NovaP& n, nova)
+		foreach(const NovaP& n, nova.getObjects())
 		{
 			names.append(n->getNameI18n());
 		}
@@ -325,14 +315,14 @@ QStringList Novae::listAllObjects(bool inEnglish) const
 	QStringList result;
 	if (inEnglish)
 	{
-		foreach (const NovaP& n, nova)
+		foreach (const NovaP& n, nova.getObjects())
 		{
 			result << n->getEnglishName();
 		}
 	}
 	else
 	{
-		foreach (const NovaP& n, nova)
+		foreach (const NovaP& n, nova.getObjects())
 		{
 			result << n->getNameI18n();
 		}
@@ -439,6 +429,7 @@ QVariantMap Novae::loadNovaeMap(QString path)
 void Novae::setNovaeMap(const QVariantMap& map)
 {
 	nova.clear();
+	visibleNovae.clear();
 	novalist.clear();
 	NovaCnt=0;
 	QVariantMap novaeMap = map.value("nova").toMap();
@@ -452,7 +443,7 @@ void Novae::setNovaeMap(const QVariantMap& map)
 
 		NovaP n(new Nova(novaeData));
 		if (n->initialized)
-			nova.append(n);
+			nova.insert(n, n->XYZ, QStringList() << n->getEnglishName() << n->getDesignation());
 
 	}
 }
@@ -505,11 +496,9 @@ bool Novae::checkJsonFileFormat() const
 
 NovaP Novae::getByID(const QString& id) const
 {
-	foreach(const NovaP& n, nova)
-	{
-		if (n->initialized && n->designation == id)
-			return n;
-	}
+	const NovaP n = nova.searchByName(id);
+	if (n && n->designation == id)
+		return n;
 	return NovaP();
 }
 
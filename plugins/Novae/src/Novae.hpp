@@ -24,6 +24,8 @@
 #include "StelFader.hpp"
 #include "Nova.hpp"
 #include "StelTextureTypes.hpp"
+#include "StelCatalogIndex.hpp"
+#include "StelMarkerBatch.hpp"
 #include <QFont>
 #include <QVariantMap>
 #include <QDateTime>
@@ -226,7 +228,11 @@ private:
 	int NovaCnt;
 
 	StelTextureSP texPointer;
-	QList<NovaP> nova;
+	//! The novae of the catalog, indexed by position, name and designation
+	StelCatalogIndex<Nova> nova;
+	//! The novae inside the viewport in the current frame
+	QVector<NovaP> visibleNovae;
+	StelMarkerBatch markerBatch;
 	QHash<QString, double> novalist;
 
 	// variables and functions for the updater
@@ -105,6 +105,8 @@ Observability::Observability()
 	, lastJDMoon(0.)	
 	, ObserverLoc(0.)
 	, myPlanet(Q_NULLPTR)
+	, yearlyScanNeeded(false)
+	, yearlyLinesDirty(false)
 	, nDays(0)
 	, dmyFormat(false)
 	, hasRisen(false)
@@ -159,6 +161,7 @@ Observability::Observability()
 	memset(objectSidT, 0, 2*366*sizeof(double));
 	memset(objectH0,   0,   366*sizeof(double));
 
+	connect(&yearlyScan, SIGNAL(resultReady()), this, SLOT(yearlyScanFinished()));
 }
 
 Observability::~Observability()
@@ -312,7 +315,8 @@ void Observability::draw(StelCore* core)
 	{
 		yearChanged = true;
 		curYear = auxy;
-		updateSunData(core);
+		updateYearDays(core);
+		yearlyScanNeeded = true;
 	}
 	else
 	{
@@ -653,10 +657,18 @@ void Observability::draw(StelCore* core)
 	}
 	else if (!isMoon && show_Year)
 	{
+		// The ephemeris of the Sun and of moving objects are computed in the background:
+		if (yearlyScanNeeded || (!isStar && souChanged))
+		{
+			startYearlyScan(core, !isStar);
+			yearlyScanNeeded = false;
+			lineBestNight.clear();
+			lineObservableRange.clear();
+			lineAcroCos.clear();
+			lineHeli.clear();
+		}
 
-		if (!isStar && (souChanged || yearChanged)) // Object moves.
-			updatePlanetData(core); // Re-compute ephemeris.
-		else
+		if (isStar)
 		{ // Object is fixed on the sky.
 			double auxH = calculateHourAngle(mylat,refractedHorizonAlt,selDec);
 			double auxSidT1 = toUnsignedRA(selRA - auxH); 
@@ -670,9 +682,13 @@ void Observability::draw(StelCore* core)
 			};
 		};
 
-// Determine source observability (only if something changed):
-		if ((souChanged || locChanged || yearChanged))
+		if (souChanged || locChanged || yearChanged)
+			yearlyLinesDirty = true;
+
+// Determine source observability (only if something changed, and the ephemeris are ready):
+		if (yearlyLinesDirty && !yearlyScan.isRunning())
 		{
+			yearlyLinesDirty = false;
 			lineBestNight.clear();
 			lineObservableRange.clear();
 
@@ -893,17 +909,7 @@ double Observability::calculateHourAngle(double latitude,
                                          double elevation,
                                          double declination)
 {
-	double denom = std::cos(latitude)*std::cos(declination);
-	double numer = (std::sin(elevation)-std::sin(latitude)*std::sin(declination));
-
-	if ( qAbs(numer) > qAbs(denom) )
-	{
-		return -0.5/86400.; // Source doesn't reach that altitude.
-	}
-	else
-	{
-		return Rad2Hr * std::acos(numer/denom);
-	}
+	return ObservabilityYear::calculateHourAngle(latitude, elevation, declination);
 }
 ////////////////////////////////////
 
@@ -945,15 +951,7 @@ void Observability::double2hms(double hfloat, int &h1, int &h2, int &h3)
 // Adds/subtracts 24hr to ensure a RA between 0 and 24hr:
 double Observability::toUnsignedRA(double RA)
 {
-	double tempRA,tempmod;	
-	if (RA<0.0)
-	{
-		tempmod = std::modf(-RA/24.,&tempRA);
-		RA += 24.*(tempRA+1.0)+0.0*tempmod;
-	};
-	double auxRA = 24.*std::modf(RA/24.,&tempRA);
-	auxRA += (auxRA<0.0)?24.0:((auxRA>24.0)?-24.0:0.0);
-	return auxRA;
+	return ObservabilityYear::toUnsignedRA(RA);
 }
 ////////////////////////////////////
 
@@ -1007,27 +1005,9 @@ QString Observability::formatAsDateRange(int startDay, int endDay)
 }
 //////////////////////////////////////////////
 
-// Compute planet's position for each day of the current year:
-void Observability::updatePlanetData(StelCore *core)
-{
-	double tempH;
-	for (int i=0; i<nDays; i++)
-	{
-		getPlanetCoords(core, yearJD[i], objectRA[i], objectDec[i], false);
-		tempH = calculateHourAngle(mylat, refractedHorizonAlt, objectDec[i]);
-		objectH0[i] = tempH;
-		objectSidT[0][i] = toUnsignedRA(objectRA[i]-tempH);
-		objectSidT[1][i] = toUnsignedRA(objectRA[i]+tempH);
-	}
-
-// Return the planet to its current time:
-	getPlanetCoords(core, myJD, objectRA[0], objectDec[0], true);
-}
-
 /////////////////////////////////////////////////
-// Computes the Sun's RA and Dec (and the JD) for 
-// each day of the current year.
-void Observability::updateSunData(StelCore* core) 
+// Computes the JD (and JDE) for each day of the current year.
+void Observability::updateYearDays(StelCore* core)
 {
 	int day, month, year, sameYear;
 // Get current date:
@@ -1039,24 +1019,83 @@ void Observability::updateSunData(StelCore* core)
 // Check if we are on a leap year:
 	StelUtils::getDateFromJulianDay(Jan1stJD+365., &sameYear, &month, &day);
 	nDays = (year==sameYear)?366:365;
-	
-// Compute Earth's position throughout the year:
-	Vec3d pos, sunPos;
+
 	for (int i=0; i<nDays; i++)
 	{
 		yearJD[i].first = Jan1stJD + (double)i;
 		yearJD[i].second = yearJD[i].first+core->computeDeltaT(yearJD[i].first)/86400.0;
-		myEarth->computePosition(yearJD[i].second);
-		myEarth->computeTransMatrix(yearJD[i].first, yearJD[i].second);
-		pos = myEarth->getHeliocentricEclipticPos();
-		sunPos = core->j2000ToEquinoxEqu((StelCore::matVsop87ToJ2000)*(-pos), StelCore::RefractionOff);
-		EarthPos[i] = -pos;
-		toRADec(sunPos,sunRA[i],sunDec[i]);
 	};
+}
+///////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////
+// Starts computing the Sun's (and planet's) RA and Dec for each day
+// of the current year. The planets themselves are not moved: the
+// positions are computed on copies of their state in a worker thread.
+void Observability::startYearlyScan(StelCore* core, bool withPlanet)
+{
+	ObservabilityYear::Input input;
+	input.days.reserve(nDays);
+	for (int i=0; i<nDays; i++)
+		input.days.append(yearJD[i]);
+
+// Precession to the equinox of the current date, taken from the core:
+	const Vec3d ex = core->j2000ToEquinoxEqu(Vec3d(1.,0.,0.), StelCore::RefractionOff);
+	const Vec3d ey = core->j2000ToEquinoxEqu(Vec3d(0.,1.,0.), StelCore::RefractionOff);
+	const Vec3d ez = core->j2000ToEquinoxEqu(Vec3d(0.,0.,1.), StelCore::RefractionOff);
+	const Mat4d matJ2000ToEquinoxEqu(ex[0], ex[1], ex[2], 0.,
+	                                 ey[0], ey[1], ey[2], 0.,
+	                                 ez[0], ez[1], ez[2], 0.,
+	                                 0., 0., 0., 1.);
+	input.matVsop87ToEquinoxEqu = matJ2000ToEquinoxEqu*StelCore::matVsop87ToJ2000;
+	input.latitude = mylat;
+	input.horizonAltitude = refractedHorizonAlt;
+
+// The shared pointers keep the planets alive while the scan runs:
+	SolarSystem* ssystem = GETSTELMODULE(SolarSystem);
+	PlanetP earth = ssystem->getEarth();
+	input.earthPos = [earth](double jde) { return earth->computeHeliocentricEclipticPos(jde); };
+	if (withPlanet && myPlanet)
+	{
+		PlanetP planet = ssystem->searchByEnglishName(myPlanet->getEnglishName());
+		if (planet)
+			input.planetPos = [planet](double jde) { return planet->computeHeliocentricEclipticPos(jde); };
+	}
+
+	yearlyScan.start(input);
+}
+///////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////
+// Copies the yearly ephemeris once they have been computed.
+void Observability::yearlyScanFinished()
+{
+	const ObservabilityYear::Result& result = yearlyScan.getResult();
+	const int n = qMin(nDays, result.sunRA.size());
+	for (int i=0; i<n; i++)
+	{
+		sunRA[i] = result.sunRA.at(i);
+		sunDec[i] = result.sunDec.at(i);
+		EarthPos[i] = result.earthPos.at(i);
+	}
+
+// The planet's data are only used if it is still selected:
+	if (result.hasPlanet && !isStar && !isMoon && !isSun)
+	{
+		for (int i=0; i<n; i++)
+		{
+			objectRA[i] = result.objectRA.at(i);
+			objectDec[i] = result.objectDec.at(i);
+			objectH0[i] = result.objectH0.at(i);
+			objectSidT[0][i] = result.objectSidT[0].at(i);
+			objectSidT[1][i] = result.objectSidT[1].at(i);
+		}
+	}
 
-//Return the Earth to its current time:
-	myEarth->computePosition(myJD.second);
-	myEarth->computeTransMatrix(myJD.first, myJD.second);
+	updateSunH();
+	yearlyLinesDirty = true;
 }
 ///////////////////////////////////////////////////
 
@@ -1255,9 +1294,7 @@ int Observability::calculateAcroCos(int &acroRise, int &acroSet,
 // Convert an Equatorial Vec3d into RA and Dec:
 void Observability::toRADec(Vec3d vec3d, double& ra, double &dec)
 {
-	vec3d.normalize();
-	dec = std::asin(vec3d[2]); // in radians
-	ra = toUnsignedRA(std::atan2(vec3d[1],vec3d[0])*Rad2Hr); // in hours.
+	ObservabilityYear::toRADec(vec3d, ra, dec);
 }
 ////////////////////////////////////////////
 
@@ -26,6 +26,7 @@
 #include "SolarSystem.hpp"
 #include "Planet.hpp"
 #include "StelFader.hpp"
+#include "ObservabilityYear.hpp"
 
 class QPixmap;
 class StelButton;
@@ -150,6 +151,9 @@ private slots:
 	//! Retranslates the user-visible strings when the language is changed. 
 	void updateMessageText();
 
+	//! Copies the yearly ephemeris computed in the background, and updates the Sun's sidereal times.
+	void yearlyScanFinished();
+
 	
 private:
 	//! Configuration window.
@@ -260,15 +264,16 @@ private:
 	//! @param RA right ascension (in hours).
 	double toUnsignedRA(double RA);
 
-	//! Prepare arrays with data for the selected object for each day of the year.
-	//! Computes the RA, Dec and rise/set sidereal times of the selected planet
-	//! for each day of the current year.
-	//! @param core the current Stellarium core.
-	void updatePlanetData(StelCore* core);
-
-	//! Computes the Sun's RA and Dec for each day of a given year.
+	//! Computes the Julian dates of the days of the current year.
 	//! @param core current Stellarium core.
-	void updateSunData(StelCore* core);
+	void updateYearDays(StelCore* core);
+
+	//! Starts computing the Sun's RA and Dec for each day of the current year in the background.
+	//! If the selected object is a planet, also computes its RA, Dec and rise/set sidereal times.
+	//! The results are copied by yearlyScanFinished().
+	//! @param core the current Stellarium core.
+	//! @param withPlanet whether to compute the ephemeris of the selected planet.
+	void startYearlyScan(StelCore* core, bool withPlanet);
 
 	//! Computes the Sun's Sid. Times at astronomical twilight (for each year's day)
 	void updateSunH();
@@ -345,6 +350,13 @@ private:
 	Planet* myMoon;
 	Planet* myPlanet;
 
+	//! Background computation of the yearly ephemeris.
+	ObservabilityYear yearlyScan;
+	//! The Sun's ephemeris must be computed again (e.g. the year changed).
+	bool yearlyScanNeeded;
+	//! The yearly report must be updated once the ephemeris are available.
+	bool yearlyLinesDirty;
+
 	//! Current simulation year.
 	int curYear;
 	//! Days in the current year (366 on leap years).
@@ -0,0 +1,154 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "ObservabilityYear.hpp"
+
+#include <QtConcurrent>
+
+#include <cmath>
+
+ObservabilityYear::ObservabilityYear(QObject* parent)
+	: QObject(parent)
+	, cancelled(0)
+	, running(false)
+{
+	connect(&watcher, SIGNAL(finished()), this, SLOT(scanFinished()));
+}
+
+ObservabilityYear::~ObservabilityYear()
+{
+	cancel();
+}
+
+void ObservabilityYear::start(const Input& newInput)
+{
+	// The running scan stops after the day it is computing, so this does not block for long.
+	cancel();
+	input = newInput;
+	cancelled.store(0);
+	running = true;
+	const Input* in = &input;
+	const QAtomicInt* flag = &cancelled;
+	watcher.setFuture(QtConcurrent::run(&ObservabilityYear::run, in, flag));
+}
+
+void ObservabilityYear::cancel()
+{
+	running = false;
+	if (watcher.isRunning())
+	{
+		cancelled.store(1);
+		watcher.waitForFinished();
+	}
+}
+
+void ObservabilityYear::scanFinished()
+{
+	if (!running)
+		return; // Cancelled in the meantime.
+	Result r = watcher.result();
+	if (!r.complete)
+		return;
+	running = false;
+	result = r;
+	emit resultReady();
+}
+
+ObservabilityYear::Result ObservabilityYear::run(const Input* input, const QAtomicInt* cancelled)
+{
+	return compute(*input, cancelled);
+}
+
+ObservabilityYear::Result ObservabilityYear::compute(const Input& input, const QAtomicInt* cancelled)
+{
+	Result r;
+	const int nDays = input.days.size();
+	r.hasPlanet = static_cast<bool>(input.planetPos);
+	r.sunRA.resize(nDays);
+	r.sunDec.resize(nDays);
+	r.earthPos.resize(nDays);
+	if (r.hasPlanet)
+	{
+		r.objectRA.resize(nDays);
+		r.objectDec.resize(nDays);
+		r.objectH0.resize(nDays);
+		r.objectSidT[0].resize(nDays);
+		r.objectSidT[1].resize(nDays);
+	}
+
+	for (int i=0; i<nDays; i++)
+	{
+		if (cancelled && cancelled->load())
+			return r;
+
+		const double jde = input.days.at(i).second;
+		const Vec3d earthPos = input.earthPos(jde);
+		r.earthPos[i] = -earthPos;
+		toRADec(input.matVsop87ToEquinoxEqu*(-earthPos), r.sunRA[i], r.sunDec[i]);
+
+		if (r.hasPlanet)
+		{
+			const Vec3d planetPos = input.planetPos(jde);
+			toRADec(input.matVsop87ToEquinoxEqu*(planetPos-earthPos), r.objectRA[i], r.objectDec[i]);
+			const double h = calculateHourAngle(input.latitude, input.horizonAltitude, r.objectDec[i]);
+			r.objectH0[i] = h;
+			r.objectSidT[0][i] = toUnsignedRA(r.objectRA[i]-h);
+			r.objectSidT[1][i] = toUnsignedRA(r.objectRA[i]+h);
+		}
+	}
+
+	r.complete = true;
+	return r;
+}
+
+double ObservabilityYear::calculateHourAngle(double latitude, double elevation, double declination)
+{
+	double denom = std::cos(latitude)*std::cos(declination);
+	double numer = (std::sin(elevation)-std::sin(latitude)*std::sin(declination));
+
+	if ( qAbs(numer) > qAbs(denom) )
+	{
+		return -0.5/86400.; // Source doesn't reach that altitude.
+	}
+	else
+	{
+		return 12./M_PI * std::acos(numer/denom);
+	}
+}
+
+double ObservabilityYear::toUnsignedRA(double RA)
+{
+	double tempRA,tempmod;
+	if (RA<0.0)
+	{
+		tempmod = std::modf(-RA/24.,&tempRA);
+		RA += 24.*(tempRA+1.0)+0.0*tempmod;
+	};
+	double auxRA = 24.*std::modf(RA/24.,&tempRA);
+	auxRA += (auxRA<0.0)?24.0:((auxRA>24.0)?-24.0:0.0);
+	return auxRA;
+}
+
+void ObservabilityYear::toRADec(Vec3d vec3d, double& ra, double &dec)
+{
+	vec3d.normalize();
+	dec = std::asin(vec3d[2]); // in radians
+	ra = toUnsignedRA(std::atan2(vec3d[1],vec3d[0])*12./M_PI); // in hours.
+}
@@ -0,0 +1,129 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef OBSERVABILITYYEAR_HPP_
+#define OBSERVABILITYYEAR_HPP_
+
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPair>
+#include <QVector>
+
+#include <functional>
+
+#include "VecMath.hpp"
+
+//! @class ObservabilityYear
+//! Computes the positions of the Sun and of a planet for every day of a year, and the sidereal times
+//! at which the planet crosses the horizon, for the yearly part of the %Observability report.
+//!
+//! The scan runs in a background task. It only gets copies of the data it needs from the main thread
+//! and computes the positions with functions which leave the shared Planet objects untouched, so
+//! the main thread can go on drawing meanwhile. Starting a new scan cancels the running one.
+//! The result is published with the resultReady() signal in the thread of this object.
+//! @ingroup observability
+class ObservabilityYear : public QObject
+{
+	Q_OBJECT
+
+public:
+	//! Returns the heliocentric ecliptic position (VSOP87 frame, AU) of a body at a JDE.
+	//! Must be thread safe, e.g. Planet::computeHeliocentricEclipticPos().
+	typedef std::function<Vec3d(double)> PositionFunc;
+
+	//! Everything a scan needs, copied from the main thread.
+	struct Input
+	{
+		Input() : latitude(0.), horizonAltitude(0.) {}
+		//! JD(UT) and JDE of each day of the year
+		QVector<QPair<double, double> > days;
+		//! Transformation from the VSOP87 frame to the equatorial frame of the date
+		Mat4d matVsop87ToEquinoxEqu;
+		//! Latitude of the observer (radians)
+		double latitude;
+		//! Geometric altitude of the refraction-corrected horizon (radians)
+		double horizonAltitude;
+		PositionFunc earthPos;
+		//! Position of the planet, or an empty function for the Sun only.
+		PositionFunc planetPos;
+	};
+
+	//! The yearly ephemeris. RA are in hours, declinations and hour angles in radians and hours
+	//! as in the Observability class.
+	struct Result
+	{
+		Result() : hasPlanet(false), complete(false) {}
+		QVector<double> sunRA, sunDec;
+		QVector<Vec3d> earthPos;
+		//! Only filled if the input has a planet.
+		QVector<double> objectRA, objectDec, objectH0;
+		QVector<double> objectSidT[2];
+		bool hasPlanet;
+		//! false if the scan was cancelled.
+		bool complete;
+	};
+
+	ObservabilityYear(QObject* parent=Q_NULLPTR);
+	//! Cancels the running scan and waits for it.
+	~ObservabilityYear();
+
+	//! Compute the yearly ephemeris in the calling thread.
+	//! @param cancelled if given, the scan stops when it becomes non-zero.
+	static Result compute(const Input& input, const QAtomicInt* cancelled=Q_NULLPTR);
+
+	//! Cancel the running scan, if any, and start a new one in the background.
+	void start(const Input& input);
+	//! Cancel the running scan. Its result will not be published.
+	void cancel();
+	//! Whether a scan is running (or its result was not published yet).
+	bool isRunning() const { return running; }
+
+	//! The result of the last completed scan.
+	const Result& getResult() const { return result; }
+
+	//! Hour angle (hours) at which a body with the given declination reaches an altitude,
+	//! or a small negative value if it never does.
+	static double calculateHourAngle(double latitude, double elevation, double declination);
+	//! Bring a RA (or hour angle) into 0-24h.
+	static double toUnsignedRA(double RA);
+	//! Convert an equatorial position vector to RA (hours) and Dec (radians).
+	static void toRADec(Vec3d vec3d, double& ra, double& dec);
+
+signals:
+	//! Emitted when a scan finished and its result is available with getResult().
+	void resultReady();
+
+private slots:
+	void scanFinished();
+
+private:
+	static Result run(const Input* input, const QAtomicInt* cancelled);
+
+	//! The input of the running scan. It stays here until the scan has finished,
+	//! so the worker never holds the last reference to anything.
+	Input input;
+	QAtomicInt cancelled;
+	bool running;
+	QFutureWatcher<Result> watcher;
+	Result result;
+};
+
+#endif /* OBSERVABILITYYEAR_HPP_ */
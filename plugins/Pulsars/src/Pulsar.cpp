@@ -28,6 +28,7 @@
 #include "StelModuleMgr.hpp"
 #include "StelSkyDrawer.hpp"
 #include "StelProjector.hpp"
+#include "StelMarkerBatch.hpp"
 
 #include <QTextStream>
 #include <QDebug>
@@ -85,6 +86,7 @@ Pulsar::Pulsar(const QVariantMap& map)
 	eccentricity = map.value("eccentricity").toDouble();
 	RA = StelUtils::getDecAngle(map.value("RA").toString());
 	DE = StelUtils::getDecAngle(map.value("DE").toString());
+	StelUtils::spheToRect(RA, DE, XYZ);
 	w50 = map.value("w50").toFloat();
 	s400 = map.value("s400").toFloat();
 	s600 = map.value("s600").toFloat();
@@ -405,36 +407,26 @@ void Pulsar::update(double deltaTime)
 	labelsFader.update((int)(deltaTime*1000));
 }
 
-void Pulsar::draw(StelCore* core, StelPainter *painter)
+void Pulsar::draw(StelCore* core, StelPainter *painter, StelMarkerBatch& batch)
 {
 	StelSkyDrawer* sd = core->getSkyDrawer();
 	double mag = getVMagnitudeWithExtinction(core);
-	StelUtils::spheToRect(RA, DE, XYZ);
-
-	Vec3d win;
-	// Check visibility of pulsar
-	if (!(painter->getProjector()->projectCheck(XYZ, win)))
-		return;
-
-	painter->setBlending(true, GL_ONE, GL_ONE);
 
-	if (glitch>0 && glitchFlag)
-		painter->setColor(glitchColor[0], glitchColor[1], glitchColor[2], 1.f);
-	else
-		painter->setColor(markerColor[0], markerColor[1], markerColor[2], 1.f);
+	const Vec3f& color = (glitch>0 && glitchFlag) ? glitchColor : markerColor;
 	float mlimit = sd->getLimitMagnitude();
 
 	if (mag <= mlimit)
 	{		
-		Pulsar::markerTexture->bind();
 		float size = getAngularSize(Q_NULLPTR)*M_PI/180.*painter->getProjector()->getPixelPerRadAtCenter();
 		float shift = 5.f + size/1.6f;		
 
-		painter->drawSprite2dMode(XYZ, distributionMode ? 4.f : 5.f);
+		// Check visibility of pulsar
+		if (!batch.addMarker(XYZ, distributionMode ? 4.f : 5.f, color))
+			return;
 
 		if (labelsFader.getInterstate()<=0.f && !distributionMode && (mag+2.f)<mlimit)
 		{
-			painter->drawText(XYZ, designation, 0, shift, shift, false);
+			batch.addLabel(XYZ, designation, color, shift);
 		}
 	}
 }
@@ -31,6 +31,7 @@
 #include "StelFader.hpp"
 
 class StelPainter;
+class StelMarkerBatch;
 
 //! @class Pulsar
 //! A Pulsar object represents one pulsar on the sky.
@@ -124,7 +125,8 @@ private:
 	static Vec3f markerColor;
 	static Vec3f glitchColor;
 
-	void draw(StelCore* core, StelPainter *painter);
+	//! Add the marker and label of the pulsar to the batch.
+	void draw(StelCore* core, StelPainter *painter, StelMarkerBatch& batch);
 
 	//! Variables for description of properties of pulsars
 	QString designation;	//! The designation of the pulsar (J2000 pulsar name)
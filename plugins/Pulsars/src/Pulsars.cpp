@@ -121,6 +121,7 @@ Pulsars::~Pulsars()
 void Pulsars::deinit()
 {
 	psr.clear();
+	visiblePsr.clear();
 	Pulsar::markerTexture.clear();
 	texPointer.clear();
 }
@@ -230,12 +231,16 @@ void Pulsars::draw(StelCore* core)
 	StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 	StelPainter painter(prj);
 	painter.setFont(font);
-	
-	foreach (const PulsarP& pulsar, psr)
-	{
-		if (pulsar && pulsar->initialized)
-			pulsar->draw(core, &painter);
-	}
+
+	// Only the pulsars inside the viewport are drawn. The margin keeps the markers of pulsars just outside.
+	const float margin = 20.f*prj->getDevicePixelsPerPixel();
+	const SphericalRegionP viewport = prj->getViewportConvexPolygon(margin, margin);
+	psr.findInRegion(viewport.data(), visiblePsr);
+
+	markerBatch.begin(prj);
+	foreach (const PulsarP& pulsar, visiblePsr)
+		pulsar->draw(core, &painter, markerBatch);
+	markerBatch.draw(painter, Pulsar::markerTexture);
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
 		drawPointer(core, painter);
@@ -272,22 +277,9 @@ QList<StelObjectP> Pulsars::searchAround(const Vec3d& av, double limitFov, const
 	if (!flagShowPulsars)
 		return result;
 
-	Vec3d v(av);
-	v.normalize();
-	double cosLimFov = cos(limitFov * M_PI/180.);
-	Vec3d equPos;
-
-	foreach(const PulsarP& pulsar, psr)
+	foreach(const PulsarP& pulsar, psr.searchAround(av, limitFov))
 	{
-		if (pulsar->initialized)
-		{
-			equPos = pulsar->XYZ;
-			equPos.normalize();
-			if (equPos[0]*v[0] + equPos[1]*v[1] + equPos[2]*v[2]>=cosLimFov)
-			{
-				result.append(qSharedPointerCast<StelObject>(pulsar));
-			}
-		}
+		result.append(qSharedPointerCast<StelObject>(pulsar));
 	}
 
 	return result;
@@ -298,13 +290,7 @@ StelObjectP Pulsars::searchByName(const QString& englishName) const
 	if (!flagShowPulsars)
 		return Q_NULLPTR;
 
-	foreach(const PulsarP& pulsar, psr)
-	{
-		if (pulsar->getEnglishName().toUpper() == englishName.toUpper())
-			return qSharedPointerCast<StelObject>(pulsar);
-	}
-
-	return Q_NULLPTR;
+	return qSharedPointerCast<StelObject>(psr.searchByName(englishName));
 }
 
 StelObjectP Pulsars::searchByNameI18n(const QString& nameI18n) const
@@ -312,13 +298,8 @@ StelObjectP Pulsars::searchByNameI18n(const QString& nameI18n) const
 	if (!flagShowPulsars)
 		return Q_NULLPTR;
 
-	foreach(const PulsarP& pulsar, psr)
-	{
-		if (pulsar->getNameI18n().toUpper() == nameI18n.toUpper())
-			return qSharedPointerCast<StelObject>(pulsar);
-	}
-
-	return Q_NULLPTR;
+	// The designations are not translated
+	return qSharedPointerCast<StelObject>(psr.searchByName(nameI18n));
 }
 
 QStringList Pulsars::listMatchingObjects(const QString& objPrefix, int maxNbItem, bool useStartOfWords, bool inEnglish) const
@@ -339,14 +320,14 @@ QStringList Pulsars::listAllObjects(bool inEnglish) const
 
 	if (inEnglish)
 	{
-		foreach(const PulsarP& pulsar, psr)
+		foreach(const PulsarP& pulsar, psr.getObjects())
 		{
 			result << pulsar->getEnglishName();
 		}
 	}
 	else
 	{
-		foreach(const PulsarP& pulsar, psr)
+		foreach(const PulsarP& pulsar, psr.getObjects())
 		{
 			result << pulsar->getNameI18n();
 		}
@@ -464,7 +445,7 @@ void Pulsars::setPSRMap(const QVariantMap& map)
 
 		PulsarP pulsar(new Pulsar(psrData));
 		if (pulsar->initialized)
-			psr.append(pulsar);
+			psr.insert(pulsar, pulsar->XYZ, QStringList(pulsar->designation));
 
 	}
 }
@@ -517,11 +498,9 @@ bool Pulsars::checkJsonFileFormat()
 
 PulsarP Pulsars::getByID(const QString& id) const
 {
-	foreach(const PulsarP& pulsar, psr)
-	{
-		if (pulsar->initialized && pulsar->designation == id)
-			return pulsar;
-	}
+	const PulsarP pulsar = psr.searchByName(id);
+	if (pulsar && pulsar->designation == id)
+		return pulsar;
 	return PulsarP();
 }
 
@@ -23,6 +23,8 @@
 #include "StelObject.hpp"
 #include "StelFader.hpp"
 #include "StelTextureTypes.hpp"
+#include "StelCatalogIndex.hpp"
+#include "StelMarkerBatch.hpp"
 #include "Pulsar.hpp"
 #include <QFont>
 #include <QVariantMap>
@@ -269,7 +271,11 @@ private:
 	QString jsonCatalogPath;
 
 	StelTextureSP texPointer;
-	QList<PulsarP> psr;
+	//! The pulsars of the catalog, indexed by position and designation
+	StelCatalogIndex<Pulsar> psr;
+	//! The pulsars inside the viewport in the current frame
+	QVector<PulsarP> visiblePsr;
+	StelMarkerBatch markerBatch;
 
 	int PsrCount;
 
@@ -27,6 +27,7 @@
 #include "StelTranslator.hpp"
 #include "StelModuleMgr.hpp"
 #include "StelSkyDrawer.hpp"
+#include "StelMarkerBatch.hpp"
 
 #include <QTextStream>
 #include <QDebug>
@@ -65,6 +66,7 @@ Quasar::Quasar(const QVariantMap& map)
 	qRA = StelUtils::getDecAngle(map.value("RA").toString());
 	qDE = StelUtils::getDecAngle(map.value("DE").toString());
 	redshift = map.value("z").toFloat();
+	StelUtils::spheToRect(qRA, qDE, XYZ);
 
 	initialized = true;
 }
@@ -169,7 +171,7 @@ void Quasar::update(double deltaTime)
 	labelsFader.update((int)(deltaTime*1000));
 }
 
-void Quasar::draw(StelCore* core, StelPainter& painter)
+void Quasar::draw(StelCore* core, StelPainter& painter, StelMarkerBatch& batch)
 {
 	StelSkyDrawer* sd = core->getSkyDrawer();
 
@@ -178,39 +180,28 @@ void Quasar::draw(StelCore* core, StelPainter& painter)
 	float size, shift=0;
 	double mag;
 
-	StelUtils::spheToRect(qRA, qDE, XYZ);
-	mag = getVMagnitudeWithExtinction(core);	
-
 	if (distributionMode)
 	{
-		painter.setBlending(true, GL_ONE, GL_ONE);
-		painter.setColor(markerColor[0], markerColor[1], markerColor[2], 1);
-
-		Quasar::markerTexture->bind();
 		//size = getAngularSize(Q_NULLPTR)*M_PI/180.*painter.getProjector()->getPixelPerRadAtCenter();
 		if (labelsFader.getInterstate()<=0.f)
 		{
-			painter.drawSprite2dMode(XYZ, 4);			
+			batch.addMarker(XYZ, 4, markerColor);
 		}
 	}
 	else
 	{
-		sd->preDrawPointSource(&painter);
-	
+		mag = getVMagnitudeWithExtinction(core);
 		if (mag <= sd->getLimitMagnitude())
 		{
 			sd->computeRCMag(mag, &rcMag);
 			sd->drawPointSource(&painter, Vec3f(XYZ[0],XYZ[1],XYZ[2]), rcMag, sd->indexToColor(BvToColorIndex(bV)), true);
-			painter.setColor(color[0], color[1], color[2], 1);
 			size = getAngularSize(Q_NULLPTR)*M_PI/180.*painter.getProjector()->getPixelPerRadAtCenter();
 			shift = 6.f + size/1.8f;
 			if (labelsFader.getInterstate()<=0.f)
 			{
-				painter.drawText(XYZ, designation, 0, shift, shift, false);
+				batch.addLabel(XYZ, designation, color, shift);
 			}
 		}
-
-		sd->postDrawPointSource(&painter);
 	}
 }
 
@@ -31,6 +31,7 @@
 #include "StelFader.hpp"
 
 class StelPainter;
+class StelMarkerBatch;
 
 //! @class Quasar
 //! A Quasar object represents one Quasar on the sky.
@@ -108,7 +109,9 @@ private:
 	static bool distributionMode;
 	static Vec3f markerColor;
 
-	void draw(StelCore* core, StelPainter& painter);
+	//! Draw the quasar as a point source, or add its marker to the batch in distribution mode.
+	//! Must be called between StelSkyDrawer::preDrawPointSource() and postDrawPointSource(). The label is added to the batch.
+	void draw(StelCore* core, StelPainter& painter, StelMarkerBatch& batch);
 	//! Calculate a color of quasar
 	//! @param b_v value of B-V color index
 	unsigned char BvToColorIndex(float b_v);
@@ -30,6 +30,7 @@
 #include "StelJsonParser.hpp"
 #include "StelFileMgr.hpp"
 #include "StelUtils.hpp"
+#include "StelSkyDrawer.hpp"
 #include "StelTranslator.hpp"
 #include "LabelMgr.hpp"
 #include "Quasar.hpp"
@@ -123,6 +124,7 @@ Quasars::~Quasars()
 void Quasars::deinit()
 {
 	QSO.clear();
+	visibleQSO.clear();
 	Quasar::markerTexture.clear();
 	texPointer.clear();
 }
@@ -232,12 +234,19 @@ void Quasars::draw(StelCore* core)
 	StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 	StelPainter painter(prj);
 	painter.setFont(font);
-	
-	foreach (const QuasarP& quasar, QSO)
-	{
-		if (quasar && quasar->initialized)
-			quasar->draw(core, painter);
-	}
+
+	// Only the quasars inside the viewport are drawn. The margin keeps the halos of quasars just outside.
+	const float margin = 20.f*prj->getDevicePixelsPerPixel();
+	const SphericalRegionP viewport = prj->getViewportConvexPolygon(margin, margin);
+	QSO.findInRegion(viewport.data(), visibleQSO);
+
+	StelSkyDrawer* sd = core->getSkyDrawer();
+	markerBatch.begin(prj);
+	sd->preDrawPointSource(&painter);
+	foreach (const QuasarP& quasar, visibleQSO)
+		quasar->draw(core, painter, markerBatch);
+	sd->postDrawPointSource(&painter);
+	markerBatch.draw(painter, Quasar::markerTexture);
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
 		drawPointer(core, painter);
@@ -274,22 +283,9 @@ QList<StelObjectP> Quasars::searchAround(const Vec3d& av, double limitFov, const
 	if (!flagShowQuasars)
 		return result;
 
-	Vec3d v(av);
-	v.normalize();
-	double cosLimFov = cos(limitFov * M_PI/180.);
-	Vec3d equPos;
-
-	foreach(const QuasarP& quasar, QSO)
+	foreach(const QuasarP& quasar, QSO.searchAround(av, limitFov))
 	{
-		if (quasar->initialized)
-		{
-			equPos = quasar->XYZ;
-			equPos.normalize();
-			if (equPos[0]*v[0] + equPos[1]*v[1] + equPos[2]*v[2]>=cosLimFov)
-			{
-				result.append(qSharedPointerCast<StelObject>(quasar));
-			}
-		}
+		result.append(qSharedPointerCast<StelObject>(quasar));
 	}
 
 	return result;
@@ -300,13 +296,7 @@ StelObjectP Quasars::searchByName(const QString& englishName) const
 	if (!flagShowQuasars)
 		return Q_NULLPTR;
 
-	foreach(const QuasarP& quasar, QSO)
-	{
-		if (quasar->getEnglishName().toUpper() == englishName.toUpper())
-			return qSharedPointerCast<StelObject>(quasar);
-	}
-
-	return Q_NULLPTR;
+	return qSharedPointerCast<StelObject>(QSO.searchByName(englishName));
 }
 
 StelObjectP Quasars::searchByNameI18n(const QString& nameI18n) const
@@ -314,13 +304,8 @@ StelObjectP Quasars::searchByNameI18n(const QString& nameI18n) const
 	if (!flagShowQuasars)
 		return Q_NULLPTR;
 
-	foreach(const QuasarP& quasar, QSO)
-	{
-		if (quasar->getNameI18n().toUpper() == nameI18n.toUpper())
-			return qSharedPointerCast<StelObject>(quasar);
-	}
-
-	return Q_NULLPTR;
+	// The designations are not translated
+	return qSharedPointerCast<StelObject>(QSO.searchByName(nameI18n));
 }
 
 QStringList Quasars::listMatchingObjects(const QString& objPrefix, int maxNbItem, bool useStartOfWords, bool inEnglish) const
@@ -342,14 +327,14 @@ QStringList Quasars::listAllObjects(bool inEnglish) const
 
 	if (inEnglish)
 	{
-		foreach (const QuasarP& quasar, QSO)
+		foreach (const QuasarP& quasar, QSO.getObjects())
 		{
 			result << quasar->getEnglishName();
 		}
 	}
 	else
 	{
-		foreach (const QuasarP& quasar, QSO)
+		foreach (const QuasarP& quasar, QSO.getObjects())
 		{
 			result << quasar->getNameI18n();
 		}
@@ -468,7 +453,7 @@ void Quasars::setQSOMap(const QVariantMap& map)
 
 		QuasarP quasar(new Quasar(qsoData));
 		if (quasar->initialized)
-			QSO.append(quasar);
+			QSO.insert(quasar, quasar->XYZ, QStringList(quasar->designation));
 
 	}
 }
@@ -521,11 +506,9 @@ bool Quasars::checkJsonFileFormat()
 
 QuasarP Quasars::getByID(const QString& id) const
 {
-	foreach(const QuasarP& quasar, QSO)
-	{
-		if (quasar->initialized && quasar->designation == id)
-			return quasar;
-	}
+	const QuasarP quasar = QSO.searchByName(id);
+	if (quasar && quasar->designation == id)
+		return quasar;
 	return QuasarP();
 }
 
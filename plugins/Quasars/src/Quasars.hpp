@@ -22,6 +22,8 @@
 #include "StelObjectModule.hpp"
 #include "StelObject.hpp"
 #include "StelTextureTypes.hpp"
+#include "StelCatalogIndex.hpp"
+#include "StelMarkerBatch.hpp"
 #include "Quasar.hpp"
 #include <QFont>
 #include <QVariantMap>
@@ -261,7 +263,11 @@ private:
 	int QsrCount;
 
 	StelTextureSP texPointer;
-	QList<QuasarP> QSO;
+	//! The quasars of the catalog, indexed by position and designation
+	StelCatalogIndex<Quasar> QSO;
+	//! The quasars inside the viewport in the current frame
+	QVector<QuasarP> visibleQSO;
+	StelMarkerBatch markerBatch;
 
 	// variables and functions for the updater
 	UpdateState updateState;
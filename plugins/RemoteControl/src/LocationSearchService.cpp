@@ -96,9 +96,33 @@ void LocationSearchService::get(const QByteArray& operation, const APIParameters
 
 		response.writeJSON(QJsonDocument(QJsonArray::fromStringList(results.keys())));
 	}
+	else if(operation=="nearest")
+	{
+		QString sPlanet = QString::fromUtf8(parameters.value("planet"));
+		QString sLatitude = QString::fromUtf8(parameters.value("latitude"));
+		QString sLongitude = QString::fromUtf8(parameters.value("longitude"));
+		QString sCount = QString::fromUtf8(parameters.value("count"));
+
+		float latitude = sLatitude.toFloat();
+		float longitude = sLongitude.toFloat();
+		bool ok;
+		int count = sCount.toInt(&ok);
+		if(!ok)
+			count = 1;
+
+		locMgrMutex.lock();
+		LocationList results = locMgr.pickNearestLocations(sPlanet,longitude,latitude,count);
+		locMgrMutex.unlock();
+
+		QJsonArray ids;
+		for(LocationList::const_iterator it = results.constBegin();it!=results.constEnd();++it)
+			ids.append(it->getID());
+
+		response.writeJSON(QJsonDocument(ids));
+	}
 	else
 	{
 		//TODO some sort of service description?
-		response.writeRequestError("unsupported operation. GET: search,nearby");
+		response.writeRequestError("unsupported operation. GET: search,nearby,nearest");
 	}
 }
@@ -21,6 +21,7 @@
 #include "RemoteSyncDialog.hpp"
 
 #include "SyncServer.hpp"
+#include "SyncServerEventSenders.hpp"
 #include "SyncClient.hpp"
 
 #include "CLIProcessor.hpp"
@@ -60,6 +61,8 @@ StelPluginInfo RemoteSyncStelPluginInterface::getPluginInfo() const
 RemoteSync::RemoteSync()
 	: clientServerPort(20180)
 	, serverPort(20180)
+	, serverCoalescedReplication(false)
+	, serverBundleCompression(true)
 	, connectionLostBehavior(ClientBehavior::RECONNECT)
 	, quitBehavior(ClientBehavior::NONE)
 	, state(IDLE)
@@ -167,6 +170,24 @@ void RemoteSync::setServerPort(const int port)
 	}
 }
 
+void RemoteSync::setServerCoalescedReplication(const bool b)
+{
+	if(b != serverCoalescedReplication)
+	{
+		serverCoalescedReplication = b;
+		emit serverCoalescedReplicationChanged(b);
+	}
+}
+
+void RemoteSync::setServerBundleCompression(const bool b)
+{
+	if(b != serverBundleCompression)
+	{
+		serverBundleCompression = b;
+		emit serverBundleCompressionChanged(b);
+	}
+}
+
 void RemoteSync::setClientSyncOptions(SyncClient::SyncOptions options)
 {
 	if(options!=syncOptions)
@@ -208,6 +229,14 @@ void RemoteSync::startServer()
 	if(state == IDLE)
 	{
 		server = new SyncServer(this);
+		server->setCoalescedReplication(serverCoalescedReplication);
+		server->setBundleCompression(serverBundleCompression);
+		server->addSender(new TimeEventSender());
+		server->addSender(new LocationEventSender());
+		server->addSender(new SelectionEventSender());
+		server->addSender(new StelPropertyEventSender());
+		server->addSender(new ViewEventSender());
+		server->addSender(new FovEventSender());
 		if(server->start(serverPort))
 			setState(SERVER);
 		else
@@ -320,6 +349,8 @@ void RemoteSync::loadSettings()
 	setClientServerHost(conf->value("clientServerHost","127.0.0.1").toString());
 	setClientServerPort(conf->value("clientServerPort",20180).toInt());
 	setServerPort(conf->value("serverPort",20180).toInt());
+	setServerCoalescedReplication(conf->value("serverCoalescedReplication",false).toBool());
+	setServerBundleCompression(conf->value("serverBundleCompression",true).toBool());
 	setClientSyncOptions(SyncClient::SyncOptions(conf->value("clientSyncOptions", SyncClient::ALL).toInt()));
 	setStelPropFilter(unpackStringList(conf->value("stelPropFilter").toString()));
 	setConnectionLostBehavior(static_cast<ClientBehavior>(conf->value("connectionLostBehavior",1).toInt()));
@@ -334,6 +365,8 @@ void RemoteSync::saveSettings()
 	conf->setValue("clientServerHost",clientServerHost);
 	conf->setValue("clientServerPort",clientServerPort);
 	conf->setValue("serverPort",serverPort);
+	conf->setValue("serverCoalescedReplication",serverCoalescedReplication);
+	conf->setValue("serverBundleCompression",serverBundleCompression);
 	conf->setValue("clientSyncOptions",static_cast<int>(syncOptions));
 	conf->setValue("stelPropFilter", packStringList(stelPropFilter));
 	conf->setValue("connectionLostBehavior", connectionLostBehavior);
@@ -87,6 +87,8 @@ public:
 	QString getClientServerHost() const { return clientServerHost; }
 	int getClientServerPort() const { return clientServerPort; }
 	int getServerPort() const { return serverPort; }
+	bool getServerCoalescedReplication() const { return serverCoalescedReplication; }
+	bool getServerBundleCompression() const { return serverBundleCompression; }
 	SyncClient::SyncOptions getClientSyncOptions() const { return syncOptions; }
 	QStringList getStelPropFilter() const { return stelPropFilter; }
 	ClientBehavior getConnectionLostBehavior() const { return connectionLostBehavior; }
@@ -98,6 +100,12 @@ public slots:
 	void setClientServerHost(const QString& clientServerHost);
 	void setClientServerPort(const int port);
 	void setServerPort(const int port);
+	//! If true, the server sends the state changes of each frame as one bundle, containing only the
+	//! state each client does not have yet. Takes effect when the server is started.
+	//! @see SyncServer::setCoalescedReplication()
+	void setServerCoalescedReplication(const bool b);
+	//! If true, the server compresses its bundles. Takes effect when the server is started.
+	void setServerBundleCompression(const bool b);
 	void setClientSyncOptions(SyncClient::SyncOptions options);
 	void setStelPropFilter(const QStringList& stelPropFilter);
 	void setConnectionLostBehavior(const ClientBehavior bh);
@@ -141,6 +149,8 @@ signals:
 	void clientServerHostChanged(const QString& clientServerHost);
 	void clientServerPortChanged(const int port);
 	void serverPortChanged(const int port);
+	void serverCoalescedReplicationChanged(const bool b);
+	void serverBundleCompressionChanged(const bool b);
 	void clientSyncOptionsChanged(const SyncClient::SyncOptions options);
 	void stelPropFilterChanged(const QStringList& stelPropFilter);
 	void connectionLostBehaviorChanged(const ClientBehavior bh);
@@ -166,6 +176,9 @@ private:
 	int clientServerPort;
 	//the port used in server mode
 	int serverPort;
+	//replication options used in server mode
+	bool serverCoalescedReplication;
+	bool serverBundleCompression;
 	SyncClient::SyncOptions syncOptions;
 	QStringList stelPropFilter;
 	ClientBehavior connectionLostBehavior;
@@ -19,6 +19,7 @@
 
 #include "SyncClient.hpp"
 #include "SyncClientHandlers.hpp"
+#include "SyncClientProtocolHandlers.hpp"
 #include "SyncMessages.hpp"
 
 #include "StelTranslator.hpp"
@@ -41,9 +42,14 @@ SyncClient::SyncClient(SyncOptions options, const QStringList &excludeProperties
 {
 	handlerList.resize(MSGTYPE_SIZE);
 	handlerList[ERROR] = new ClientErrorHandler(this);
-	handlerList[SERVER_CHALLENGE] = new ClientAuthHandler(this);
-	handlerList[SERVER_CHALLENGERESPONSEVALID] = new ClientAuthHandler(this);
+	ClientAuthHandler* authHandler = new ClientAuthHandler();
+	connect(authHandler, SIGNAL(authenticated()), this, SIGNAL(connected()));
+	handlerList[SERVER_CHALLENGE] = authHandler;
+	authHandler = new ClientAuthHandler();
+	connect(authHandler, SIGNAL(authenticated()), this, SIGNAL(connected()));
+	handlerList[SERVER_CHALLENGERESPONSEVALID] = authHandler;
 	handlerList[ALIVE] = new ClientAliveHandler();
+	handlerList[BUNDLE] = new ClientBundleHandler(handlerList);
 
 	//these are the actual sync handlers
 	if(options.testFlag(SyncTime))
@@ -60,7 +66,7 @@ SyncClient::SyncClient(SyncOptions options, const QStringList &excludeProperties
 		handlerList[FOV] = new ClientFovHandler();
 
 	//fill unused handlers with dummies
-	for(int t = TIME;t<MSGTYPE_SIZE;++t)
+	for(int t = TIME;t<=FOV;++t)
 	{
 		if(!handlerList[t]) handlerList[t] = new DummyMessageHandler();
 	}
@@ -63,103 +63,6 @@ bool ClientErrorHandler::handleMessage(QDataStream &stream, SyncProtocol::tPaylo
 	return ok;
 }
 
-ClientAuthHandler::ClientAuthHandler(SyncClient *client)
-	: ClientHandler(client)
-{
-	connect(this, SIGNAL(authenticated()),client,SIGNAL(connected()));
-}
-
-
-bool ClientAuthHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
-{
-	//get message type
-	SyncMessageType type = SyncMessageType(peer.msgHeader.msgType);
-
-	if(type == SERVER_CHALLENGE)
-	{
-		if(peer.isAuthenticated())
-		{
-			//we are already authenticated, another challenge is an error
-			qWarning()<<"[SyncClient] received server challenge when not expecting one";
-			return false;
-		}
-
-		ServerChallenge msg;
-		bool ok = msg.deserialize(stream,dataSize);
-
-		if(!ok)
-		{
-			qWarning()<<"[SyncClient] invalid server challenge received";
-			return false;
-		}
-
-		//check challenge for validity
-		if(msg.protocolVersion != SYNC_PROTOCOL_VERSION)
-		{
-			qWarning()<<"[SyncClient] invalid protocol version, dropping connection";
-			return false;
-		}
-
-		const quint32 expectedPluginVersion = (REMOTESYNC_MAJOR << 16) | (REMOTESYNC_MINOR << 8) | (REMOTESYNC_PATCH);
-		const quint32 expectedStellariumVersion =(STELLARIUM_MAJOR << 16) | (STELLARIUM_MINOR<<8) | (STELLARIUM_PATCH);
-
-		if(expectedPluginVersion != msg.remoteSyncVersion)
-		{
-			//This is only a warning here
-			QString str("[SyncClient] RemoteSync plugin version mismatch! Expected: 0x%1, Got: 0x%2");
-			qWarning()<<str.arg(expectedPluginVersion,0,16).arg(msg.remoteSyncVersion,0,16);
-		}
-		if(expectedStellariumVersion != msg.stellariumVersion)
-		{
-			//This is only a warning here
-			QString str("[SyncClient] Stellarium version mismatch! Expected: 0x%1, Got: 0x%2");
-			qWarning()<<str.arg(expectedStellariumVersion,0,16).arg(msg.stellariumVersion,0,16);
-		}
-
-		qDebug()<<"[SyncClient] Received server challenge, sending response";
-
-		//we have to answer with the response
-		ClientChallengeResponse response;
-		//only need to set this
-		response.clientId = msg.clientId;
-
-		peer.authResponseSent = true;
-		peer.writeMessage(response);
-
-		return true;
-	}
-	else if (type == SERVER_CHALLENGERESPONSEVALID)
-	{
-		//this message has no data body, no need to deserialize
-		if(peer.authResponseSent)
-		{
-			//we authenticated correctly, yay!
-			peer.authenticated = true;
-			qDebug()<<"[SyncClient] Connection authenticated";
-			emit authenticated();
-			return true;
-		}
-		else
-		{
-			//we got a confirmation without sending a response, error
-			qWarning()<<"[SyncClient] Got SERVER_CHALLENGERESPONSEVALID message without awaiting it";
-			return false;
-		}
-	}
-	else
-	{
-		//should never happen except the message type<-->handler config was somehow messed up
-		Q_ASSERT(false);
-		return false;
-	}
-}
-
-bool ClientAliveHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
-{
-	Alive p;
-	return p.deserialize(stream,dataSize);
-}
-
 bool ClientTimeHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
 {
 	Time msg;
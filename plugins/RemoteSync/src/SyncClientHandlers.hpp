@@ -48,23 +48,6 @@ public:
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
 };
 
-//! Reacts to Server challenge and challenge OK on the client
-class ClientAuthHandler : public ClientHandler
-{
-	Q_OBJECT
-public:
-	ClientAuthHandler(SyncClient* client);
-	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
-signals:
-	void authenticated();
-};
-
-class ClientAliveHandler : public SyncMessageHandler
-{
-public:
-	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
-};
-
 class ClientTimeHandler : public ClientHandler
 {
 public:
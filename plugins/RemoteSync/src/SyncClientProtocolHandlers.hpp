@@ -0,0 +1,59 @@
+/*
+ * Stellarium Remote Sync plugin
+ * Copyright (C) 2015 Florian Schaukowitsch
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef SYNCCLIENTPROTOCOLHANDLERS_HPP_
+#define SYNCCLIENTPROTOCOLHANDLERS_HPP_
+
+#include "SyncProtocol.hpp"
+
+#include <QVector>
+
+//! Reacts to Server challenge and challenge OK on the client
+class ClientAuthHandler : public QObject, public SyncMessageHandler
+{
+	Q_OBJECT
+	Q_INTERFACES(SyncMessageHandler)
+public:
+	ClientAuthHandler();
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+signals:
+	void authenticated();
+};
+
+class ClientAliveHandler : public SyncMessageHandler
+{
+public:
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+};
+
+//! Applies the state changes of a BUNDLE with the handlers of their message types, and acknowledges it
+class ClientBundleHandler : public SyncMessageHandler
+{
+public:
+	//! The handlers of the message types in a bundle are looked up in @p handlerList, which must outlive this handler
+	ClientBundleHandler(const QVector<SyncMessageHandler*>& handlerList);
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+	//! The frame of the last bundle which was applied completely, 0 before the first one
+	quint32 getAppliedFrame() const { return appliedFrame; }
+private:
+	const QVector<SyncMessageHandler*>& handlerList;
+	quint32 appliedFrame;
+};
+
+#endif
@@ -137,6 +137,8 @@ class StelPropertyUpdate : public SyncMessage
 {
 public:
 	SyncMessageType getMessageType() const Q_DECL_OVERRIDE { return SyncProtocol::STELPROPERTY; }
+	//! Each property is replicated on its own
+	QString getStateKey() const Q_DECL_OVERRIDE { return propId; }
 
 	void serialize(QDataStream &stream) const Q_DECL_OVERRIDE;
 	bool deserialize(QDataStream &stream, SyncProtocol::tPayloadSize dataSize) Q_DECL_OVERRIDE;
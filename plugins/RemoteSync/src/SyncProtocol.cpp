@@ -26,25 +26,6 @@
 
 using namespace SyncProtocol;
 
-namespace SyncProtocol
-{
-
-QDataStream& operator<<(QDataStream& out, const SyncHeader& header)
-{
-	out<<header.msgType;
-	out<<header.dataSize;
-	return out;
-}
-
-QDataStream& operator>>(QDataStream& in, SyncHeader& header)
-{
-	in>>header.msgType;
-	in>>header.dataSize;
-	return in;
-}
-
-}
-
 qint64 SyncMessage::createFullMessage(QByteArray &target) const
 {
 	//we serialize into a byte buffer first so that we can get message size easily
@@ -103,7 +84,7 @@ QString SyncMessage::readString(QDataStream &stream)
 
 SyncRemotePeer::SyncRemotePeer(QAbstractSocket *socket, bool isServer, const QVector<SyncMessageHandler *> &handlerList)
 	: sock(socket), stream(sock), expectDisconnect(false), isPeerAServer(isServer), authenticated(false), authResponseSent(false), waitingForBody(false),
-	  handlerList(handlerList)
+	  handlerList(handlerList), bytesSent(0), messagesSent(0), bytesReceived(0), messagesReceived(0)
 {
 	Q_ASSERT(sock);
 	sock->setParent(this); //reparent
@@ -128,7 +109,7 @@ SyncRemotePeer::SyncRemotePeer(QAbstractSocket *socket, bool isServer, const QVe
 
 SyncRemotePeer::~SyncRemotePeer()
 {
-	peerLog()<<"Destroyed";
+	peerLog()<<"Destroyed, sent"<<messagesSent<<"messages ("<<bytesSent<<"bytes), received"<<messagesReceived<<"messages ("<<bytesReceived<<"bytes)";
 	delete sock;
 }
 
@@ -243,6 +224,8 @@ void SyncRemotePeer::receiveMessage()
 		{
 			waitingForBody = false;
 			peerLog()<<"received body, processing";
+			bytesReceived += SYNC_HEADER_SIZE + msgHeader.dataSize;
+			++messagesReceived;
 
 			//full packet available, pass to handler
 			SyncMessageHandler* handler = handlerList[msgHeader.msgType];
@@ -295,8 +278,11 @@ void SyncRemotePeer::writeData(const QByteArray &data, int size)
 	//Only write if connected
 	if(sock->state() == QAbstractSocket::ConnectedState)
 	{
-		stream.writeRawData(data.constData(),size>0?size:data.size());
+		const int dataSize = size>0?size:data.size();
+		stream.writeRawData(data.constData(),dataSize);
 		lastSendTime = QDateTime::currentMSecsSinceEpoch();
+		bytesSent += dataSize;
+		++messagesSent;
 	}
 	else
 		peerLog("Can't write message, not connected");
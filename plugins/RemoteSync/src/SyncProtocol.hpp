@@ -32,7 +32,7 @@ namespace SyncProtocol
 //Important: All data should use the sized typedefs provided by Qt (i.e. qint32 instead of 4 byte int on x86)
 
 //! Should be changed with every breaking change
-const quint8 SYNC_PROTOCOL_VERSION = 2;
+const quint8 SYNC_PROTOCOL_VERSION = 3;
 const QDataStream::Version SYNC_DATASTREAM_VERSION = QDataStream::Qt_5_0;
 //! Magic value for protocol used during connection. Should NEVER change.
 const QByteArray SYNC_MAGIC_VALUE = "StellariumSyncPluginProtocol";
@@ -47,9 +47,20 @@ struct SyncHeader
 };
 
 //! Write a SyncHeader to a DataStream
-QDataStream& operator<<(QDataStream& out, const SyncHeader& header);
+inline QDataStream& operator<<(QDataStream& out, const SyncHeader& header)
+{
+	out<<header.msgType;
+	out<<header.dataSize;
+	return out;
+}
+
 //! Read a SyncHeader from a DataStream
-QDataStream& operator>>(QDataStream& in, SyncHeader& header);
+inline QDataStream& operator>>(QDataStream& in, SyncHeader& header)
+{
+	in>>header.msgType;
+	in>>header.dataSize;
+	return in;
+}
 
 const qint64 SYNC_HEADER_SIZE = sizeof(quint8) + sizeof(tPayloadSize); //3 byte
 const qint64 SYNC_MAX_PAYLOAD_SIZE = (2<<15) - 1; // 65535
@@ -72,8 +83,10 @@ enum SyncMessageType
 	STELPROPERTY, //stelproperty updates
 	VIEW, //view change
 	FOV, //fov change
+	BUNDLE, //coalesced state changes of a frame, see SyncStateReplicator
+	BUNDLE_ACK, //sent from the client after it has applied a BUNDLE
 
-	MSGTYPE_MAX = FOV,
+	MSGTYPE_MAX = BUNDLE_ACK,
 	MSGTYPE_SIZE = MSGTYPE_MAX+1
 };
 
@@ -113,6 +126,12 @@ inline QDebug& operator<<(QDebug& deb, SyncMessageType msg)
 		case SyncProtocol::ALIVE:
 			deb<<"ALIVE";
 			break;
+		case SyncProtocol::BUNDLE:
+			deb<<"BUNDLE";
+			break;
+		case SyncProtocol::BUNDLE_ACK:
+			deb<<"BUNDLE_ACK";
+			break;
 		default:
 			deb<<"UNKNOWN("<<int(msg)<<')';
 			break;
@@ -140,6 +159,11 @@ public:
 	//! The default implementation expects a zero dataSize, and reads nothing.
 	virtual bool deserialize(QDataStream& stream, SyncProtocol::tPayloadSize dataSize);
 
+	//! Messages of a type which describes several independent states (like STELPROPERTY)
+	//! should return which state they describe. Used to coalesce state updates, see SyncStateReplicator.
+	//! The default returns an empty string.
+	virtual QString getStateKey() const { return QString(); }
+
 	//! Subclasses can override this to provide proper debug output.
 	//! The default just prints the message type.
 	virtual QDebug debugOutput(QDebug dbg) const
@@ -191,6 +215,12 @@ public:
 	void disconnectPeer();
 
 	QString getError() const { return errorString; }
+
+	//! Traffic statistics of this connection, counting full messages including their headers
+	quint64 getBytesSent() const { return bytesSent; }
+	quint64 getMessagesSent() const { return messagesSent; }
+	quint64 getBytesReceived() const { return bytesReceived; }
+	quint64 getMessagesReceived() const { return messagesReceived; }
 signals:
 	void disconnected(bool cleanDisconnect);
 private slots:
@@ -216,6 +246,10 @@ private:
 	qint64 lastSendTime; //The time the last data was written to this peer
 	QVector<SyncMessageHandler*> handlerList;
 	QByteArray msgWriteBuffer; //Byte array used to construct messages before writing them
+	quint64 bytesSent;
+	quint64 messagesSent;
+	quint64 bytesReceived;
+	quint64 messagesReceived;
 
 	friend class ServerAuthHandler;
 	friend class ClientAuthHandler;
@@ -32,7 +32,7 @@ Q_LOGGING_CATEGORY(syncServer,"stel.plugin.remoteSync.server")
 using namespace SyncProtocol;
 
 SyncServer::SyncServer(QObject* parent)
-	: QObject(parent), stopping(false), timeoutTimerId(-1)
+	: QObject(parent), stopping(false), timeoutTimerId(-1), coalescedReplication(false)
 {
 	qserver = new QTcpServer(this);
 	connect(qserver,SIGNAL(newConnection()), this, SLOT(handleNewConnection()));
@@ -43,12 +43,21 @@ SyncServer::SyncServer(QObject* parent)
 	handlerList[ERROR] =  new ServerErrorHandler();
 	handlerList[CLIENT_CHALLENGE_RESPONSE] = new ServerAuthHandler(this, false);
 	handlerList[ALIVE] = new ServerAliveHandler();
+	handlerList[BUNDLE_ACK] = new ServerBundleAckHandler(this);
 }
 
 SyncServer::~SyncServer()
 {
 	stop();
 
+	//delete senders
+	foreach(SyncServerEventSender* s, senderList)
+	{
+		if(s)
+			delete s;
+	}
+	senderList.clear();
+
 	//delete handlers
 	foreach(SyncMessageHandler* h, handlerList)
 	{
@@ -72,13 +81,16 @@ bool SyncServer::start(int port)
 
 		timeoutTimerId = startTimer(5000,Qt::VeryCoarseTimer);
 
-		//create senders
-		addSender(new TimeEventSender());
-		addSender(new LocationEventSender());
-		addSender(new SelectionEventSender());
-		addSender(new StelPropertyEventSender());
-		addSender(new ViewEventSender());
-		addSender(new FovEventSender());
+		if(coalescedReplication)
+		{
+			qCDebug(syncServer)<<"Using coalesced replication, compression"<<replicator.getCompressionEnabled();
+			//the replicated state has to be complete before the first client connects
+			foreach(SyncServerEventSender* s, senderList)
+			{
+				s->broadcastFullState();
+			}
+			replicator.commitFrame();
+		}
 	}
 	else
 		qCCritical(syncServer)<<"Error while starting:"<<qserver->errorString();
@@ -93,6 +105,16 @@ void SyncServer::addSender(SyncServerEventSender *snd)
 
 void SyncServer::broadcastMessage(const SyncMessage &msg)
 {
+	if(coalescedReplication)
+	{
+		if(!replicator.setField(msg))
+		{
+			qCCritical(syncServer)<<"A message is too large for replication:"<<msg;
+			stop();
+		}
+		return;
+	}
+
 	qCDebug(syncServer)<<"Broadcast message"<<msg;
 	qint64 size = msg.createFullMessage(broadcastBuffer);
 
@@ -126,13 +148,7 @@ void SyncServer::stop()
 
 		qserver->close();
 
-		//delete senders
-		foreach(SyncServerEventSender* s, senderList)
-		{
-			if(s)
-				delete s;
-		}
-		senderList.clear();
+		replicator.clear();
 
 		for(tClientList::iterator it = clients.begin();it!=clients.end(); )
 		{
@@ -153,6 +169,33 @@ void SyncServer::update()
 	{
 		s->update();
 	}
+
+	if(coalescedReplication)
+		sendBundles();
+}
+
+void SyncServer::sendBundles()
+{
+	replicator.commitFrame();
+
+	for(tClientList::iterator it = clients.begin();it!=clients.end();++it)
+	{
+		SyncRemotePeer* client = *it;
+		if(!client->isAuthenticated())
+			continue;
+
+		bundleBuffer.clear();
+		replicator.createBundle(client->getID(), bundleBuffer);
+		foreach(const QByteArray& part, bundleBuffer)
+		{
+			client->writeData(part);
+		}
+	}
+}
+
+void SyncServer::bundleAcknowledged(SyncRemotePeer &peer, quint32 frame)
+{
+	replicator.acknowledge(peer.getID(), frame);
 }
 
 void SyncServer::timerEvent(QTimerEvent *evt)
@@ -186,6 +229,11 @@ void SyncServer::checkStopState()
 	}
 }
 
+quint16 SyncServer::getPort() const
+{
+	return qserver->serverPort();
+}
+
 QString SyncServer::errorString() const
 {
 	return qserver->errorString();
@@ -214,6 +262,13 @@ void SyncServer::handleNewConnection()
 void SyncServer::clientAuthenticated(SyncRemotePeer &peer)
 {
 	//we have to send the client the current app state
+	if(coalescedReplication)
+	{
+		//the first bundle of a new client is a snapshot of the replicated state
+		replicator.addClient(peer.getID());
+		return;
+	}
+
 	foreach(SyncServerEventSender* s, senderList)
 	{
 		s->newClientConnected(peer);
@@ -229,6 +284,7 @@ void SyncServer::clientDisconnected(bool clean)
 		qCWarning(syncServer)<<"Client disconnected with error"<<peer->getError();
 	}
 	clients.removeAll(peer);
+	replicator.removeClient(peer->getID());
 	peer->deleteLater();
 	qCDebug(syncServer)<<clients.size()<<"current connections";
 	checkStopState();
@@ -21,6 +21,7 @@
 #define SYNCSERVER_HPP_
 
 #include "SyncProtocol.hpp"
+#include "SyncStateReplicator.hpp"
 #include <QObject>
 #include <QAbstractSocket>
 #include <QDateTime>
@@ -44,8 +45,27 @@ public:
 	//! This should be called in the StelModule::update function
 	void update();
 
-	//! Broadcasts this message to all connected and authenticated clients
+	//! Adds a sender which notifies the clients of state changes, the server takes ownership of it.
+	//! Senders should be added before start().
+	void addSender(SyncServerEventSender* snd);
+
+	//! Broadcasts this message to all connected and authenticated clients.
+	//! With coalesced replication, the message only updates the replicated state,
+	//! which is sent at the end of the frame.
 	void broadcastMessage(const SyncProtocol::SyncMessage& msg);
+
+	//! If enabled, state changes are not broadcast immediately. Instead, the changes of a frame are sent
+	//! to each client as one BUNDLE containing only the state which changed since the client's last bundle,
+	//! and new clients get a snapshot of the full state. Must be set before start().
+	void setCoalescedReplication(bool b) { coalescedReplication = b; }
+	bool getCoalescedReplication() const { return coalescedReplication; }
+	//! Whether bundles are compressed, see SyncStateReplicator
+	void setBundleCompression(bool b) { replicator.setCompressionEnabled(b); }
+	bool getBundleCompression() const { return replicator.getCompressionEnabled(); }
+	//! Returns the port the server listens on, which is chosen by the system when started on port 0
+	quint16 getPort() const;
+	//! Returns the number of connected clients, including the ones which are not authenticated yet
+	int getClientCount() const { return clients.size(); }
 public slots:
 	//! Starts the SyncServer on the specified port. If the server is already running, stops it first.
 	//! Returns true if successful (false usually means port was in use, use getErrorString)
@@ -68,7 +88,9 @@ private slots:
 	void clientDisconnected(bool clean);
 
 private:
-	void addSender(SyncServerEventSender* snd);
+	//! Sends the bundles of the current frame to the clients
+	void sendBundles();
+	void bundleAcknowledged(SyncRemotePeer& peer, quint32 frame);
 	void checkTimeouts();
 	void checkStopState();
 	//use composition instead of inheritance, cleaner interfaace this way
@@ -85,7 +107,13 @@ private:
 
 	QByteArray broadcastBuffer;
 	int timeoutTimerId;
+
+	bool coalescedReplication;
+	SyncStateReplicator replicator;
+	QVector<QByteArray> bundleBuffer;
+
 	friend class ServerAuthHandler;
+	friend class ServerBundleAckHandler;
 };
 
 #endif
@@ -141,6 +141,16 @@ void StelPropertyEventSender::newClientConnected(SyncRemotePeer &client)
 	}
 }
 
+void StelPropertyEventSender::broadcastFullState()
+{
+	QList<StelProperty*> propList = propMgr->getAllProperties();
+	foreach(StelProperty* prop, propList)
+	{
+		if(prop->isSynchronizable())
+			sendStelPropChange(prop, prop->getValue());
+	}
+}
+
 ViewEventSender::ViewEventSender()
 	: lastView(0.0)
 {
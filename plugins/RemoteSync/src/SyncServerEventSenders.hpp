@@ -48,6 +48,12 @@ protected slots:
 	//! The default implementation does nothing.
 	virtual void newClientConnected(SyncRemotePeer& client) { Q_UNUSED(client); }
 protected:
+	//! This is called by the SyncServer when it starts with coalesced replication.
+	//! Use this to broadcast the complete current state, which is then sent to each new client instead of
+	//! calling newClientConnected().
+	//! The default implementation does nothing.
+	virtual void broadcastFullState() {}
+
 	//! This is guaranteed to be called once per frame (usually after all other StelModules have been updated).
 	//! It is can be used to defer state broadcasts until the frame is finished to only send a single message.
 	//! Default implentation does nothing.
@@ -76,6 +82,9 @@ protected:
 	//! Uses constructMessage() to send a message to the new client.
 	virtual void newClientConnected(SyncRemotePeer& client) Q_DECL_OVERRIDE;
 
+	//! Uses constructMessage() to broadcast the current state.
+	virtual void broadcastFullState() Q_DECL_OVERRIDE;
+
 	//! If isDirty is true, broadcasts a message to all using constructMessage() and broadcastMessage,
 	//! and resets isDirty.
 	virtual void update() Q_DECL_OVERRIDE;
@@ -87,6 +96,12 @@ void TypedSyncServerEventSender<T>::newClientConnected(SyncRemotePeer& client)
 	client.writeMessage(constructMessage());
 }
 
+template<class T>
+void TypedSyncServerEventSender<T>::broadcastFullState()
+{
+	broadcastMessage(constructMessage());
+}
+
 template<class T>
 void TypedSyncServerEventSender<T>::update()
 {
@@ -139,6 +154,9 @@ protected slots:
 	//! Sends all current StelProperties to the client
 	virtual void newClientConnected(SyncRemotePeer& client) Q_DECL_OVERRIDE;
 	void sendStelPropChange(StelProperty* prop, const QVariant& val);
+protected:
+	//! Broadcasts all current StelProperties
+	virtual void broadcastFullState() Q_DECL_OVERRIDE;
 private:
 	StelPropertyMgr* propMgr;
 };
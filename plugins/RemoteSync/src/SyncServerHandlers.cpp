@@ -19,6 +19,7 @@
 
 #include "SyncServerHandlers.hpp"
 #include "SyncServer.hpp"
+#include "SyncStateReplicator.hpp"
 
 using namespace SyncProtocol;
 
@@ -105,3 +106,19 @@ bool ServerAliveHandler::handleMessage(QDataStream &stream, SyncProtocol::tPaylo
 	Alive p;
 	return p.deserialize(stream,dataSize);
 }
+
+ServerBundleAckHandler::ServerBundleAckHandler(SyncServer *server)
+	: ServerHandler(server)
+{
+
+}
+
+bool ServerBundleAckHandler::handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer)
+{
+	quint32 frame;
+	if(!SyncStateReplicator::readAck(stream, dataSize, frame))
+		return false;
+
+	server->bundleAcknowledged(peer, frame);
+	return true;
+}
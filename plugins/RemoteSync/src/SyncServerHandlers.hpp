@@ -58,4 +58,13 @@ public:
 	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
 };
 
+//! Passes the acknowledged bundles of a client on to the server's SyncStateReplicator
+class ServerBundleAckHandler : public ServerHandler
+{
+	Q_OBJECT
+public:
+	ServerBundleAckHandler(SyncServer* server);
+	bool handleMessage(QDataStream &stream, SyncProtocol::tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE;
+};
+
 #endif
@@ -0,0 +1,251 @@
+/*
+ * Stellarium Remote Sync plugin
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "SyncStateReplicator.hpp"
+
+#include <QDebug>
+
+using namespace SyncProtocol;
+
+const int SyncStateReplicator::BUNDLE_HEADER_SIZE;
+const int SyncStateReplicator::FIELD_HEADER_SIZE;
+const int SyncStateReplicator::MAX_PART_SIZE;
+
+SyncStateReplicator::SyncStateReplicator()
+	: frame(0)
+	, changed(false)
+	, compressionEnabled(true)
+	, maxFramesInFlight(4)
+{
+}
+
+bool SyncStateReplicator::setField(const SyncMessage &msg)
+{
+	QByteArray payload;
+	QDataStream stream(&payload, QIODevice::WriteOnly);
+	stream.setVersion(SYNC_DATASTREAM_VERSION);
+	msg.serialize(stream);
+	return setField(static_cast<quint8>(msg.getMessageType()), msg.getStateKey(), payload);
+}
+
+bool SyncStateReplicator::setField(quint8 msgType, const QString &key, const QByteArray &payload)
+{
+	if(payload.size() > MAX_PART_SIZE - FIELD_HEADER_SIZE)
+	{
+		qWarning()<<"[SyncStateReplicator] State of"<<SyncMessageType(msgType)<<key<<"is too large for a bundle:"<<payload.size()<<"bytes";
+		return false;
+	}
+
+	const QPair<quint8, QString> fieldKey(msgType, key);
+	QHash<QPair<quint8, QString>, int>::const_iterator it = fieldIndex.constFind(fieldKey);
+	if(it == fieldIndex.constEnd())
+	{
+		FieldState field;
+		field.msgType = msgType;
+		field.payload = payload;
+		field.changedFrame = frame + 1;
+		fieldIndex.insert(fieldKey, fields.size());
+		fields.append(field);
+		changed = true;
+	}
+	else
+	{
+		FieldState& field = fields[it.value()];
+		if(field.payload != payload)
+		{
+			field.payload = payload;
+			field.changedFrame = frame + 1;
+			changed = true;
+		}
+	}
+	return true;
+}
+
+bool SyncStateReplicator::commitFrame()
+{
+	if(!changed)
+		return false;
+
+	++frame;
+	changed = false;
+	bundleCache.clear();
+	return true;
+}
+
+void SyncStateReplicator::addClient(const QUuid &id)
+{
+	clients.insert(id, ClientState());
+}
+
+void SyncStateReplicator::removeClient(const QUuid &id)
+{
+	clients.remove(id);
+}
+
+void SyncStateReplicator::acknowledge(const QUuid &id, quint32 ackFrame)
+{
+	QHash<QUuid, ClientState>::iterator it = clients.find(id);
+	if(it == clients.end())
+		return;
+
+	//a client can only acknowledge what it was sent
+	if(ackFrame > it->ackedFrame && ackFrame <= it->sentFrame)
+		it->ackedFrame = ackFrame;
+}
+
+int SyncStateReplicator::createBundle(const QUuid &id, QVector<QByteArray> &messages)
+{
+	QHash<QUuid, ClientState>::iterator it = clients.find(id);
+	if(it == clients.end() || it->sentFrame == frame)
+		return 0;
+
+	//TCP delivers the bundles in order, so the client will be at sentFrame once it has applied the bundles in flight.
+	//The acknowledgements only throttle clients which can't keep up.
+	if(it->sentFrame - it->ackedFrame >= static_cast<quint32>(maxFramesInFlight))
+		return 0;
+
+	const quint32 baseFrame = it->sentFrame;
+	QHash<quint32, QVector<QByteArray> >::iterator cached = bundleCache.find(baseFrame);
+	if(cached == bundleCache.end())
+	{
+		cached = bundleCache.insert(baseFrame, QVector<QByteArray>());
+		encodeBundle(baseFrame, *cached);
+	}
+
+	it->sentFrame = frame;
+	messages += *cached;
+	return cached->size();
+}
+
+void SyncStateReplicator::clear()
+{
+	fields.clear();
+	fieldIndex.clear();
+	clients.clear();
+	bundleCache.clear();
+	frame = 0;
+	changed = false;
+}
+
+void SyncStateReplicator::encodeBundle(quint32 baseFrame, QVector<QByteArray> &parts) const
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(SYNC_DATASTREAM_VERSION);
+
+	foreach(const FieldState& field, fields)
+	{
+		if(field.changedFrame <= baseFrame)
+			continue;
+
+		if(data.size() + FIELD_HEADER_SIZE + field.payload.size() > MAX_PART_SIZE)
+		{
+			//fields are never split, so each part can be applied on its own
+			appendPart(data, baseFrame, false, parts);
+			stream.device()->seek(0);
+			data.clear();
+		}
+
+		stream<<field.msgType;
+		stream<<static_cast<tPayloadSize>(field.payload.size());
+		stream.writeRawData(field.payload.constData(), field.payload.size());
+	}
+
+	appendPart(data, baseFrame, true, parts);
+}
+
+void SyncStateReplicator::appendPart(const QByteArray &data, quint32 baseFrame, bool last, QVector<QByteArray> &parts) const
+{
+	quint8 flags = last ? LastPart : 0;
+	QByteArray fieldData = data;
+	if(compressionEnabled)
+	{
+		QByteArray compressed = qCompress(data);
+		if(compressed.size() < data.size())
+		{
+			fieldData = compressed;
+			flags |= Compressed;
+		}
+	}
+
+	SyncHeader header = { static_cast<quint8>(BUNDLE), static_cast<tPayloadSize>(BUNDLE_HEADER_SIZE + fieldData.size()) };
+	QByteArray msg;
+	msg.reserve(SYNC_HEADER_SIZE + header.dataSize);
+	QDataStream stream(&msg, QIODevice::WriteOnly);
+	stream.setVersion(SYNC_DATASTREAM_VERSION);
+	stream<<header;
+	stream<<frame;
+	stream<<baseFrame;
+	stream<<flags;
+	stream<<fieldData;
+	parts.append(msg);
+}
+
+bool SyncStateReplicator::readBundle(QDataStream &stream, tPayloadSize dataSize, BundlePart &part)
+{
+	QByteArray data;
+	stream>>part.frame;
+	stream>>part.baseFrame;
+	stream>>part.flags;
+	stream>>data;
+	if(stream.status() || BUNDLE_HEADER_SIZE + data.size() != dataSize)
+		return false;
+
+	if(part.flags & Compressed)
+	{
+		data = qUncompress(data);
+		if(data.isEmpty())
+			return false;
+	}
+
+	part.fields.clear();
+	QDataStream fieldStream(data);
+	fieldStream.setVersion(SYNC_DATASTREAM_VERSION);
+	while(!fieldStream.atEnd())
+	{
+		Field field;
+		tPayloadSize size;
+		fieldStream>>field.msgType;
+		fieldStream>>size;
+		field.payload.resize(size);
+		if(fieldStream.readRawData(field.payload.data(), size) != size)
+			return false;
+		part.fields.append(field);
+	}
+	return !fieldStream.status();
+}
+
+QByteArray SyncStateReplicator::createAck(quint32 ackFrame)
+{
+	SyncHeader header = { static_cast<quint8>(BUNDLE_ACK), static_cast<tPayloadSize>(sizeof(quint32)) };
+	QByteArray msg;
+	QDataStream stream(&msg, QIODevice::WriteOnly);
+	stream.setVersion(SYNC_DATASTREAM_VERSION);
+	stream<<header;
+	stream<<ackFrame;
+	return msg;
+}
+
+bool SyncStateReplicator::readAck(QDataStream &stream, tPayloadSize dataSize, quint32 &ackFrame)
+{
+	if(dataSize != sizeof(quint32))
+		return false;
+	stream>>ackFrame;
+	return !stream.status();
+}
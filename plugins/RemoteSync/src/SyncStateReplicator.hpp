@@ -0,0 +1,157 @@
+/*
+ * Stellarium Remote Sync plugin
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef SYNCSTATEREPLICATOR_HPP_
+#define SYNCSTATEREPLICATOR_HPP_
+
+#include "SyncProtocol.hpp"
+
+#include <QHash>
+#include <QPair>
+#include <QUuid>
+#include <QVector>
+
+//! Keeps the replicated state of a SyncServer, and creates the BUNDLE messages which bring clients up to date.
+//! The state consists of fields. A field is the last message of a type, or for message types which describe
+//! several states (like STELPROPERTY) the last message with the same SyncMessage::getStateKey().
+//! Changes are collected during a frame, and commitFrame() stamps them with a new frame number.
+//!
+//! For each client, the replicator remembers the frame it was last sent and the frame it last acknowledged.
+//! A bundle contains the fields which changed since the frame last sent to the client, so a field which changed
+//! several times in between is sent only once. A new client has frame 0, and gets a full snapshot of the state.
+//! Clients which have not acknowledged the last few bundles get nothing until they catch up, and then a single delta.
+//!
+//! Bundles larger than a message are split into several parts, which can be decoded independently.
+//! The fields of a part are optionally compressed with qCompress.
+//!
+//! BUNDLE payload: quint32 frame, quint32 base frame (0 for a snapshot), quint8 flags, QByteArray fields.
+//! Each field is a quint8 message type, a quint16 size and the serialized message.
+//! BUNDLE_ACK payload: quint32 frame.
+class SyncStateReplicator
+{
+public:
+	enum BundleFlag
+	{
+		Compressed	= 0x01, //the fields are compressed with qCompress
+		LastPart	= 0x02  //last part of the bundle of this frame
+	};
+
+	struct Field
+	{
+		quint8 msgType;
+		QByteArray payload;
+	};
+
+	//! A decoded BUNDLE message
+	struct BundlePart
+	{
+		quint32 frame;
+		quint32 baseFrame;
+		quint8 flags;
+		QVector<Field> fields;
+	};
+
+	SyncStateReplicator();
+
+	//! Whether bundle parts are compressed when this makes them smaller. Enabled by default.
+	void setCompressionEnabled(bool b) { compressionEnabled = b; }
+	bool getCompressionEnabled() const { return compressionEnabled; }
+
+	//! The number of bundles a client may not have acknowledged before it is skipped
+	void setMaxFramesInFlight(int frames) { maxFramesInFlight = qMax(1, frames); }
+	int getMaxFramesInFlight() const { return maxFramesInFlight; }
+
+	//! Store the current state described by a message.
+	//! @return false if the message is too large to be part of a bundle
+	bool setField(const SyncProtocol::SyncMessage& msg);
+	//! Store the serialized message @param payload as the current state of the field (@param msgType, @param key).
+	//! Nothing changes if the field already has this value.
+	bool setField(quint8 msgType, const QString& key, const QByteArray& payload);
+	int getFieldCount() const { return fields.size(); }
+
+	//! Finish the current frame. If a field has changed, the frame number is incremented.
+	//! @return true if a new frame was started
+	bool commitFrame();
+	//! The number of the last committed frame
+	quint32 getFrame() const { return frame; }
+
+	//! Start replicating to a client, which will get a full snapshot
+	void addClient(const QUuid& id);
+	void removeClient(const QUuid& id);
+	bool hasClient(const QUuid& id) const { return clients.contains(id); }
+	//! Called when a client acknowledges that it has applied the bundle of @param frame
+	void acknowledge(const QUuid& id, quint32 frame);
+	//! The last frame acknowledged by a client
+	quint32 getAcknowledgedFrame(const QUuid& id) const { return clients.value(id).ackedFrame; }
+
+	//! Append the messages (with headers) of the bundle which brings the client up to the current frame.
+	//! The bundles are cached, so clients at the same frame share them.
+	//! @return the number of appended messages, 0 if the client is up to date or has too many bundles in flight.
+	int createBundle(const QUuid& id, QVector<QByteArray>& messages);
+
+	//! Remove all fields and clients, and start again at frame 0
+	void clear();
+
+	//! Decode a BUNDLE message from the stream. The current position is after the header.
+	static bool readBundle(QDataStream& stream, SyncProtocol::tPayloadSize dataSize, BundlePart& part);
+	//! Create a BUNDLE_ACK message (with header) for @param frame
+	static QByteArray createAck(quint32 frame);
+	//! Decode a BUNDLE_ACK message from the stream. The current position is after the header.
+	static bool readAck(QDataStream& stream, SyncProtocol::tPayloadSize dataSize, quint32& frame);
+
+	//! Size of the bundle payload before the fields: frame, base frame, flags and the size of the fields array
+	static const int BUNDLE_HEADER_SIZE = 4 + 4 + 1 + 4;
+	//! Size of a field before the message: message type and size
+	static const int FIELD_HEADER_SIZE = 1 + 2;
+	//! Maximal size of the fields of one bundle part
+	static const int MAX_PART_SIZE = SyncProtocol::SYNC_MAX_PAYLOAD_SIZE - BUNDLE_HEADER_SIZE;
+
+private:
+	struct FieldState
+	{
+		quint8 msgType;
+		QByteArray payload;
+		//! frame in which the field changed last
+		quint32 changedFrame;
+	};
+
+	struct ClientState
+	{
+		ClientState() : sentFrame(0), ackedFrame(0) {}
+		quint32 sentFrame;
+		quint32 ackedFrame;
+	};
+
+	//! Encode the fields which changed after @param baseFrame into bundle parts
+	void encodeBundle(quint32 baseFrame, QVector<QByteArray>& parts) const;
+	void appendPart(const QByteArray& data, quint32 baseFrame, bool last, QVector<QByteArray>& parts) const;
+
+	QVector<FieldState> fields;
+	QHash<QPair<quint8, QString>, int> fieldIndex;
+	QHash<QUuid, ClientState> clients;
+	//! Encoded bundles of the current frame, by base frame
+	QHash<quint32, QVector<QByteArray> > bundleCache;
+
+	quint32 frame;
+	bool changed;
+	bool compressionEnabled;
+	int maxFramesInFlight;
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "Frustum.hpp"
 #include "GLFuncs.hpp"
 #include <limits>
+#include <QMatrix4x4>
 
 Frustum::Frustum()
 {
@@ -118,7 +119,50 @@ void Frustum::calcFrustum(Vec3d p, Vec3d l, Vec3d u)
 	}
 }
 
-int Frustum::pointInFrustum(const Vec3f& p)
+void Frustum::setFromMatrix(const QMatrix4x4 &mvp)
+{
+	//extract the planes from the rows of the matrix (Gribb & Hartmann)
+	//a point is inside if -w <= x,y,z <= w in clip space
+	const QVector4D r0 = mvp.row(0);
+	const QVector4D r1 = mvp.row(1);
+	const QVector4D r2 = mvp.row(2);
+	const QVector4D r3 = mvp.row(3);
+
+	QVector4D eqs[PLANECOUNT];
+	eqs[NEARP] = r3 + r2;
+	eqs[FARP] = r3 - r2;
+	eqs[LEFT] = r3 + r0;
+	eqs[RIGHT] = r3 - r0;
+	eqs[BOTTOM] = r3 + r1;
+	eqs[TOP] = r3 - r1;
+
+	for(unsigned int i=0; i<PLANECOUNT; i++)
+	{
+		const QVector4D& e = eqs[i];
+		float len = e.toVector3D().length();
+		if(len <= 0.0f)
+			len = 1.0f;
+		//normals point inside, like in calcFrustum
+		planes[i]->normal = Vec3f(e.x() / len, e.y() / len, e.z() / len);
+		planes[i]->distance = -e.w() / len;
+	}
+
+	//the corners are the unit cube transformed back into world space
+	const QMatrix4x4 inv = mvp.inverted();
+	static const float ndc[CORNERCOUNT][3] = {
+		{-1.f, -1.f, -1.f}, { 1.f, -1.f, -1.f}, { 1.f,  1.f, -1.f}, {-1.f,  1.f, -1.f},
+		{-1.f, -1.f,  1.f}, { 1.f, -1.f,  1.f}, { 1.f,  1.f,  1.f}, {-1.f,  1.f,  1.f} };
+
+	bbox.reset();
+	for(unsigned int i=0; i<CORNERCOUNT; i++)
+	{
+		QVector3D c = inv.map(QVector3D(ndc[i][0], ndc[i][1], ndc[i][2]));
+		corners[i] = Vec3f(c.x(), c.y(), c.z());
+		bbox.expand(corners[i]);
+	}
+}
+
+int Frustum::pointInFrustum(const Vec3f& p) const
 {
 	int result = INSIDE;
 	for(int i=0; i<PLANECOUNT; i++)
@@ -132,7 +176,7 @@ int Frustum::pointInFrustum(const Vec3f& p)
 	return result;
 }
 
-int Frustum::boxInFrustum(const AABBox &bbox)
+int Frustum::boxInFrustum(const AABBox &bbox) const
 {
 	int result = INSIDE;
 	for(unsigned int i=0; i<PLANECOUNT; i++)
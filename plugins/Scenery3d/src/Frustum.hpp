@@ -25,6 +25,8 @@
 #include "Plane.hpp"
 #include "GeomMath.hpp"
 
+class QMatrix4x4;
+
 class Frustum
 {
 public:
@@ -60,10 +62,13 @@ public:
 	}
 
 	void calcFrustum(Vec3d p, Vec3d l, Vec3d u);
+	//! Sets the planes, corners and bbox to the clip volume of the given model-view-projection matrix.
+	//! This works for perspective as well as orthographic (e.g. light) projections.
+	void setFromMatrix(const QMatrix4x4& mvp);
 	const Vec3f &getCorner(Corner corner) const;
 	const Plane &getPlane(FrustumPlane plane) const;
-	int pointInFrustum(const Vec3f &p);
-	int boxInFrustum(const AABBox &bbox);
+	int pointInFrustum(const Vec3f &p) const;
+	int boxInFrustum(const AABBox &bbox) const;
 
 	void drawFrustum() const;
 	void saveDrawingCorners();
@@ -25,18 +25,52 @@
 #include "GeomMath.hpp"
 
 #include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
 
 #define INF (std::numeric_limits<float>::max())
 #define NO_HEIGHT (-INF)
 
-Heightmap::Heightmap() : rootNode(Q_NULLPTR), grid(Q_NULLPTR), nullHeight(0.0)
+namespace
+{
+	//! Orders triangles by the center of their bounds along one axis, for splitting BVH nodes
+	struct TriangleCenterLess
+	{
+		explicit TriangleCenterLess(int axis) : axis(axis) {}
+		template<typename T> bool operator()(const T& a, const T& b) const
+		{
+			return a.min[axis] + a.max[axis] < b.min[axis] + b.max[axis];
+		}
+		int axis;
+	};
+
+	//! The depth of the BVH is at most log2 of the triangle count, because nodes are split at the median
+	const int MAX_TREE_DEPTH = 64;
+
+	//! A block of a getHeights() batch, processed by a single thread
+	struct HeightBlock
+	{
+		const Heightmap* heightmap;
+		const float* x;
+		const float* y;
+		float* heights;
+		int begin, end;
+	};
+
+	void queryBlock(HeightBlock& block)
+	{
+		for(int i = block.begin; i<block.end; ++i)
+			block.heights[i] = block.heightmap->getHeight(block.x[i], block.y[i]);
+	}
+}
+
+Heightmap::Heightmap() : nullHeight(0.0)
 {
 }
 
 Heightmap::~Heightmap()
 {
-	delete rootNode;
-	delete[] grid;
 }
 
 void Heightmap::setMeshData(const IdxList &indexList, const PosList &posList, const AABBox* bbox)
@@ -66,12 +100,9 @@ void Heightmap::setMeshData(const IdxList &indexList, const PosList &posList, co
 	range = max - min;
 
 	QElapsedTimer timer;
-	/*timer.start();
-	this->initQuadtree();
-	qDebug()<<"initQuadtree\t"<<qSetFieldWidth(12)<<right<<timer.nsecsElapsed();*/
 	timer.start();
-	this->initGrid();
-	qDebug()<<"initGrid\t\t"<<qSetFieldWidth(12)<<right<<timer.nsecsElapsed();
+	this->initBVH();
+	qDebug()<<"initBVH\t\t"<<qSetFieldWidth(12)<<right<<timer.nsecsElapsed()<<qSetFieldWidth(0)<<"ns,"<<triangles.size()<<"triangles,"<<nodes.size()<<"nodes";
 }
 
 /**
@@ -81,148 +112,169 @@ void Heightmap::setMeshData(const IdxList &indexList, const PosList &posList, co
  */
 float Heightmap::getHeight(const float x, const float y) const
 {
-	/*QElapsedTimer timer;
-	timer.start();
-	if(!rootNode)
-		return nullHeight;
-	float height = rootNode->getHeightAtPoint(Vec2f(x,y),posList);
-	qint64 qtTime = timer.nsecsElapsed();
-	timer.start();*/
-
-	Heightmap::GridSpace* space = getSpace(x, y);
-	if (space == Q_NULLPTR)
+	float h = getHeightInTree(x, y);
+	if (h == NO_HEIGHT)
 	{
 		return nullHeight;
 	}
 	else
 	{
-		float h = space->getHeight(posList, x, y);
-		//qint64 gridTime = timer.nsecsElapsed();
-		//qDebug()<<"qt"<<qtTime<<"grid"<<gridTime;
-		//Q_ASSERT(height == h);
-		if (h == NO_HEIGHT)
-		{
-			return nullHeight;
-		}
-		else
-		{
-			return h;
-		}
+		return h;
 	}
 }
 
-/**
- * Height query within a single grid space. The list of faces to check
- * for intersection with the observer coords is limited to faces
- * intersecting this grid space.
- */
-float Heightmap::GridSpace::getHeight(const PosList& posList, const float x, const float y) const
+void Heightmap::getHeights(const float *x, const float *y, float *heights, int count) const
 {
-	float h = NO_HEIGHT;
-
-	// this was actually broken for a very long time
-	// and checked ALL faces instead of only the ones in the grid cell...
-	for(int i=0; i<faces.size(); ++i)
+	if(count < PARALLEL_BATCH_SIZE)
 	{
-		//points into the index list
-		const unsigned int* pTriangle = faces[i];
-
-		float face_h = face_height_at(posList, pTriangle, x, y);
-		if(face_h > h)
-		{
-			h = face_h;
-		}
+		for(int i = 0; i<count; ++i)
+			heights[i] = getHeight(x[i], y[i]);
+		return;
 	}
 
-	return h;
-}
-
-void Heightmap::initQuadtree()
-{
-	delete rootNode;
-	//TODO enforce square aspect ratio?
-	rootNode = new QuadTreeNode(min,max);
-
-	//add all triangles to the tree
-	for(int i = 0;i<indexList.size();i+=3)
+	//the queries are independent and the tree is read-only, so blocks can be processed in parallel
+	const int blockSize = PARALLEL_BATCH_SIZE/4;
+	QVector<HeightBlock> blocks;
+	blocks.reserve(count/blockSize + 1);
+	for(int i = 0; i<count; i+=blockSize)
 	{
-		rootNode->putTriangle(&indexList.at(i),posList);
+		HeightBlock block = { this, x, y, heights, i, std::min(count, i+blockSize) };
+		blocks.append(block);
 	}
+	QtConcurrent::blockingMap(blocks, &queryBlock);
 }
 
 /**
- * Fills every grid space with
- * pointers to the faces in that space.
+ * Walks down all BVH nodes containing x/y, and returns the maximal height
+ * of the triangles in the leaves.
  */
-void Heightmap::initGrid()
+float Heightmap::getHeightInTree(const float x, const float y) const
 {
-	delete[] grid;
-	grid = new GridSpace[GRID_LENGTH*GRID_LENGTH];
+	float h = NO_HEIGHT;
+	if(nodes.isEmpty())
+		return h;
 
-	for(int i = 0;i<indexList.size(); i+=3)
-	{
-		const unsigned int* pTriangle = &(indexList.at(i));
-		//determine the triangle BBox
-		Vec2f triMin(std::numeric_limits<float>::max()), triMax(-std::numeric_limits<float>::max());
-		for(int t=0; t<3; ++t)
-		{
-			const Vec3f& pos = posList.at(pTriangle[t]);
-			triMin[0] = std::min(triMin[0], pos[0]);
-			triMin[1] = std::min(triMin[1], pos[1]);
-			triMax[0] = std::max(triMax[0], pos[0]);
-			triMax[1] = std::max(triMax[1], pos[1]);
-		}
+	const BVHNode* pNodes = nodes.constData();
+	const Triangle* pTriangles = triangles.constData();
 
-		//determine the grid faces the BBox overlaps with
-		//convert to grid-coordinate system
-		triMin = (triMin - min) / range;
-		triMax = (triMax - min) / range;
-		//convert to indices and clamp
-		Vec2i minIdx(triMin * GRID_LENGTH);
-		minIdx = minIdx.clamp(Vec2i(0),Vec2i(GRID_LENGTH-1));
-		Vec2i maxIdx(triMax * GRID_LENGTH);
-		maxIdx = maxIdx.clamp(Vec2i(0),Vec2i(GRID_LENGTH-1));
-		//now iterate over the candidates
-		for(int y = minIdx[1];y<=maxIdx[1];++y)
+	int stack[MAX_TREE_DEPTH];
+	int stackSize = 0;
+	int cur = 0;
+	while(true)
+	{
+		const BVHNode& node = pNodes[cur];
+		if(x>=node.min[0] && x<=node.max[0] && y>=node.min[1] && y<=node.max[1])
 		{
-			for(int x = minIdx[0];x<=maxIdx[0];++x)
+			if(node.count == 0)
 			{
-				//bounds of the current area
-				Vec2f rectMin = min + (Vec2f(x,y) * range) / GRID_LENGTH;
-				Vec2f rectMax = min + (Vec2f(x+1,y+1) * range) / GRID_LENGTH;
+				//visit the first child next, and the second one later
+				Q_ASSERT(stackSize < MAX_TREE_DEPTH);
+				stack[stackSize++] = node.offset;
+				++cur;
+				continue;
+			}
 
-				//the three triangle points without Z
-				const Vec2f t1(posList.at(pTriangle[0]).data());
-				const Vec2f t2(posList.at(pTriangle[1]).data());
-				const Vec2f t3(posList.at(pTriangle[2]).data());
+			for(int i = node.offset; i<node.offset+node.count; ++i)
+			{
+				const Triangle& tri = pTriangles[i];
+				if(x<tri.min[0] || x>tri.max[0] || y<tri.min[1] || y>tri.max[1])
+					continue;
 
-				//more expensive check for intersection
-				if(triangle_intersects_bbox(t1,t2,t3,rectMin,rectMax))
+				float face_h = face_height_at(posList, tri.pTriangle, x, y);
+				if(face_h > h)
 				{
-					FaceVector* faces = &grid[y*GRID_LENGTH + x].faces;
-					faces->push_back(pTriangle);
+					h = face_h;
 				}
 			}
 		}
+
+		if(stackSize == 0)
+			break;
+		cur = stack[--stackSize];
 	}
+
+	return h;
 }
 
 /**
- * Returns the GridSpace which covers the area around x/y.
+ * Builds the BVH over the 2D bounds of all faces.
  */
-Heightmap::GridSpace* Heightmap::getSpace(const float x, const float y) const
+void Heightmap::initBVH()
+{
+	nodes.clear();
+	triangles.clear();
+	triangles.reserve(indexList.size()/3);
+
+	for(int i = 0;i<indexList.size(); i+=3)
+	{
+		Triangle tri;
+		tri.pTriangle = &(indexList.at(i));
+
+		const Vec3f& p0 = posList.at(tri.pTriangle[0]);
+		const Vec3f& p1 = posList.at(tri.pTriangle[1]);
+		const Vec3f& p2 = posList.at(tri.pTriangle[2]);
+
+		//faces which are vertical (like walls) have no area in x/y and can never be hit
+		const float det_T = (p1[1]-p2[1]) * (p0[0]-p2[0]) + (p2[0]-p1[0]) * (p0[1]-p2[1]);
+		if(det_T == 0.0f)
+			continue;
+
+		tri.min = Vec2f(std::min(p0[0], std::min(p1[0], p2[0])), std::min(p0[1], std::min(p1[1], p2[1])));
+		tri.max = Vec2f(std::max(p0[0], std::max(p1[0], p2[0])), std::max(p0[1], std::max(p1[1], p2[1])));
+		triangles.append(tri);
+	}
+
+	if(triangles.isEmpty())
+		return;
+
+	//a balanced tree has about 2*n/MAX_LEAF_SIZE nodes
+	nodes.reserve(2 * triangles.size() / MAX_LEAF_SIZE + 1);
+	buildNode(0, triangles.size());
+}
+
+int Heightmap::buildNode(int begin, int end)
 {
-	int ix = (x - min[0]) / (range[0]) * GRID_LENGTH;
-	int iy = (y - min[1]) / (range[1]) * GRID_LENGTH;
+	const int nodeIdx = nodes.size();
+	nodes.append(BVHNode());
+
+	BVHNode node;
+	node.min = triangles.at(begin).min;
+	node.max = triangles.at(begin).max;
+	Vec2f centerMin(INF), centerMax(-INF);
+	for(int i = begin; i<end; ++i)
+	{
+		const Triangle& tri = triangles.at(i);
+		node.min[0] = std::min(node.min[0], tri.min[0]);
+		node.min[1] = std::min(node.min[1], tri.min[1]);
+		node.max[0] = std::max(node.max[0], tri.max[0]);
+		node.max[1] = std::max(node.max[1], tri.max[1]);
+
+		const Vec2f center = (tri.min + tri.max) * 0.5f;
+		centerMin[0] = std::min(centerMin[0], center[0]);
+		centerMin[1] = std::min(centerMin[1], center[1]);
+		centerMax[0] = std::max(centerMax[0], center[0]);
+		centerMax[1] = std::max(centerMax[1], center[1]);
+	}
 
-	if ((ix < 0) || (ix >= GRID_LENGTH) || (iy < 0) || (iy >= GRID_LENGTH))
+	if(end - begin <= MAX_LEAF_SIZE)
 	{
-		return Q_NULLPTR;
+		node.offset = begin;
+		node.count = end - begin;
 	}
 	else
 	{
-		return &grid[iy*GRID_LENGTH + ix];
+		//split at the median along the axis where the triangles are spread out most
+		const int axis = (centerMax[0] - centerMin[0]) >= (centerMax[1] - centerMin[1]) ? 0 : 1;
+		const int mid = begin + (end - begin) / 2;
+		std::nth_element(triangles.begin() + begin, triangles.begin() + mid, triangles.begin() + end, TriangleCenterLess(axis));
+
+		buildNode(begin, mid);
+		node.offset = buildNode(mid, end);
+		node.count = 0;
 	}
+
+	nodes[nodeIdx] = node;
+	return nodeIdx;
 }
 
 /**
@@ -270,227 +322,3 @@ void Heightmap::cartesian_to_barycentric(const Vec2f &t1, const Vec2f &t2, const
 
 	*l3 = 1.0f - *l1 - *l2;
 }
-
-/**
- * Returns true if the given face intersects the given area.
- */
-bool Heightmap::triangle_intersects_bbox(const Vec2f& t1, const Vec2f& t2, const Vec2f& t3, const Vec2f& rMin, const Vec2f& rMax)
-{
-	// test if ANY point is contained inside the other shape, if yes, we certainly intersect
-	// This may also be true if no lines intersect (one shape fully inside the other)!
-	//test if t1 is inside the rectangle
-	if(t1[0]>=rMin[0] && t1[0]<=rMax[0] && t1[1]>=rMin[1] && t1[1]<=rMax[1])
-		return true;
-	//test if rMin is inside the triangle (barycentric coords)
-	float l1,l2,l3;
-	cartesian_to_barycentric(t1,t2,t3,rMin,&l1,&l2,&l3);
-	if ((l1 >= 0) && (l2 >= 0) && (l3 >= 0))
-		return true;
-
-	//a triangle intersects the rectangle if any lines intersect each other
-	//there are probably faster methods, but as this is not used during each frame it should be ok
-	if(!line_intersects_triangle(t1,t2,t3,rMin,Vec2f(rMin[0],rMax[1])))
-		if(!line_intersects_triangle(t1,t2,t3,rMin,Vec2f(rMax[0],rMin[1])))
-			if(!line_intersects_triangle(t1,t2,t3,rMax,Vec2f(rMin[0],rMax[1])))
-				if(!line_intersects_triangle(t1,t2,t3,rMax,Vec2f(rMax[0],rMin[1])))
-				{
-					return false; //no line intersects, so we have no intersection
-				}
-	//line intersection true
-	return true;
-}
-
-bool Heightmap::sameSide(const Vec2f &p, const Vec2f &q, const Vec2f &a, const Vec2f &b)
-{
-	float z1 = (b[0] - a[0]) * (p[1] - a[1]) - (p[0] - a[0]) * (b[1] - a[1]);
-	float z2 = (b[0] - a[0]) * (q[1] - a[1]) - (q[0] - a[0]) * (b[1] - a[1]);
-	return z1 * z2 > .0f; //positive if on same side
-}
-
-bool Heightmap::line_intersects_triangle(const Vec2f &t0, const Vec2f &t1, const Vec2f &t2, const Vec2f &p0, const Vec2f &p1)
-{
-	//line/tri intersection from https://gamedev.stackexchange.com/revisions/21110/2
-	if (sameSide(t0, t1, p0, p1) && sameSide(t0, t2, p0, p1)) return false;
-	if (!sameSide(p0, t2, t0, t1) && !sameSide(p1, t2, t0, t1)) return false;
-	if (!sameSide(p0, t0, t1, t2) && !sameSide(p1, t0, t1, t2)) return false;
-	if (!sameSide(p0, t1, t2, t0) && !sameSide(p1, t1, t2, t0)) return false;
-
-	return true;
-}
-
-Heightmap::QuadTreeNode::QuadTreeNode(const Vec2f &min, const Vec2f &max)
-	: parent(Q_NULLPTR), children(Q_NULLPTR), level(-1), depth(-1), nodecount(-1)
-{
-	init(Q_NULLPTR,min,max);
-}
-
-Heightmap::QuadTreeNode::QuadTreeNode()
-	: parent(Q_NULLPTR), children(Q_NULLPTR), level(-1), depth(-1), nodecount(-1)
-{
-
-}
-
-void Heightmap::QuadTreeNode::init(QuadTreeNode* parent, const Vec2f& min, const Vec2f& max)
-{
-	this->parent = parent;
-	this->min = min;
-	this->max = max;
-	//the midpoint of the quadrant
-	this->mid = min + (max-min)/2.0f;
-
-	//the depth of all parents will get incremented in the subdivide() call later
-	depth = 1;
-	nodecount = 1;
-
-	if(parent)
-	{
-		this->level = parent->level+1;
-	}
-	else
-	{
-		level = 0;
-	}
-
-}
-
-Heightmap::QuadTreeNode::~QuadTreeNode()
-{
-	delete[] children;
-}
-
-void Heightmap::QuadTreeNode::putTriangle(const unsigned int *pTriangle, const PosList &posList, int maxLevel)
-{
-	//we ignore the Z coordinates of the triangles
-	Vec2f p1(posList.at(pTriangle[0]).data());
-	Vec2f p2(posList.at(pTriangle[1]).data());
-	Vec2f p3(posList.at(pTriangle[2]).data());
-	Quadrant q1 = getQuadrantForPoint(p1);
-	Quadrant q2 = getQuadrantForPoint(p2);
-	Quadrant q3 = getQuadrantForPoint(p3);
-
-	//if this happens something went wrong
-	Q_ASSERT(q1 != INVALID);
-	Q_ASSERT(q2 != INVALID);
-	Q_ASSERT(q3 != INVALID);
-
-	//if all three vertices lie in the same quadrant, it gets put into there!
-	if(q1==q2 && q2==q3)
-	{
-		//check depth limit
-		if(level<maxLevel)
-		{
-			//ensure child nodes exist
-			subdivide();
-			children[q1].putTriangle(pTriangle,posList);
-			return;
-		}
-	}
-	//it gets put into the current node
-	faces.append(pTriangle);
-}
-
-float Heightmap::QuadTreeNode::getHeightAtPoint(const Vec2f &point, const Heightmap::PosList& posList) const
-{
-	float height = NO_HEIGHT;
-
-	//lets avoid recursion here
-	const QuadTreeNode* curNode = this;
-	while(true)
-	{
-		Quadrant q = curNode->getQuadrantForPoint(point);
-		if(q==INVALID) //outside bounds
-			break;
-
-		//iterate through all current faces,
-		//calculate barycentric coordinates of point on the 2D-projected triangle,
-		//and finally, if the point is inside, the height on the triangle
-		for(int i=0;i<curNode->faces.size();++i)
-		{
-			const unsigned int* pTriangle = curNode->faces[i];
-			height = std::max(height,face_height_at(posList,pTriangle,point[0],point[1]));
-		}
-
-		if(curNode->children)
-			curNode = &(curNode->children[q]);
-		else
-			break;
-	}
-	return height;
-}
-
-Heightmap::FaceVector Heightmap::QuadTreeNode::getTriangleCandidatesAtPoint(const Vec2f &point) const
-{
-	FaceVector ret;
-
-	//lets avoid recursion here
-	const QuadTreeNode* curNode = this;
-	while(true)
-	{
-		Quadrant q = curNode->getQuadrantForPoint(point);
-		if(q==INVALID) //outside bounds
-			break;
-
-		//append all current node faces
-		ret<<curNode->faces;
-		if(children)
-			curNode = &children[q];
-		else
-			break;
-	}
-	return ret;
-}
-
-void Heightmap::QuadTreeNode::subdivide()
-{
-	if(children)
-		return; //already subdivided
-
-	children = new QuadTreeNode[4]();
-	children[MinMin].init(this,min,mid);
-	children[MinMax].init(this,Vec2f(min[0],mid[1]),Vec2f(mid[0],max[1]));
-	children[MaxMin].init(this,Vec2f(mid[0],min[1]),Vec2f(max[0],mid[1]));
-	children[MaxMax].init(this,mid,max);
-
-	//go back up the parent relations and update the depth, if required
-	QuadTreeNode* curNode = this;
-
-	do
-	{
-		//the node depth is the maximum depth of its subnodes + 1
-		int maxDepth = 1;
-		for(int i = 0;i<4;++i)
-		{
-			maxDepth = std::max(maxDepth,curNode->children[i].depth);
-		}
-		maxDepth+=1;
-		if(maxDepth>curNode->depth)
-		{
-			//update depth
-			curNode->depth = maxDepth;
-		}
-		//update nodecount
-		curNode->nodecount+=4;
-		//continue upwards to root
-		curNode=curNode->parent;
-	} while(curNode!=Q_NULLPTR);
-}
-
-Heightmap::QuadTreeNode::Quadrant Heightmap::QuadTreeNode::getQuadrantForPoint(const Vec2f &point) const
-{
-	//check if the point lies within our bounds first
-	if(point[0]<min[0] || point[0]>max[0] || point[1]<min[1] || point[1]>max[1])
-		return INVALID;
-
-	if(point[0]<mid[0]) //left half
-	{
-		if(point[1]<mid[1])
-			return MinMin; //bottom left
-		return MinMax; //upper left
-	}
-	else //right half
-	{
-		if(point[1]<mid[1])
-			return MaxMin; //bottom right
-		return MaxMax; //upper right
-	}
-}
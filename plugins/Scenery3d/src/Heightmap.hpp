@@ -23,7 +23,9 @@
 
 #include "StelOBJ.hpp"
 
-//! This represents a heightmap for viewer-ground collision
+//! This represents a heightmap for viewer-ground collision.
+//! The triangles are stored in a bounding volume hierarchy over their 2D (x/y) footprints,
+//! which adapts to the triangle density, so dense parts of a terrain mesh do not slow down queries.
 class Heightmap
 {
 
@@ -47,6 +49,14 @@ public:
         //! @return z-Value at position given by x and y
         float getHeight(const float x, const float y) const;
 
+	//! Get the z values of many points, e.g. when sampling a path.
+	//! Large batches are split up between multiple threads.
+	//! @param x array of x-values
+	//! @param y array of y-values
+	//! @param heights receives the z-values, same as getHeight() for each point
+	//! @param count the size of the arrays
+	void getHeights(const float* x, const float* y, float* heights, int count) const;
+
         //! set/retrieve default height
         void setNullHeight(float h){nullHeight=h;}
         float getNullHeight() const {return nullHeight;}
@@ -55,72 +65,41 @@ private:
 	IdxList indexList;
 	PosList posList;
 
-        static const int GRID_LENGTH = 60; // # of grid spaces is GRID_LENGTH^2
-
-	typedef QVector<const unsigned int*> FaceVector; //points to first index in Index list for a face
-
-	struct QuadTreeNode
+	//! A node of the BVH. Nodes are stored depth-first, so the first child of an inner node directly follows it.
+	struct BVHNode
 	{
-		//! Constructs a root node
-		QuadTreeNode(const Vec2f& min, const Vec2f& max);
-		//deletes all child nodes
-		~QuadTreeNode();
-
-		//indexes the child nodes, INVALID means outside the current node
-		enum Quadrant { MinMin, MinMax, MaxMin, MaxMax, INVALID };
-
-		//Stores the index of the given triangle in the QuadTree
-		void putTriangle(const unsigned int* pTriangle, const PosList& posList, int maxLevel = 7);
-
-		float getHeightAtPoint(const Vec2f& point, const PosList &posList) const;
-
-		//Recursively retrieves all triangles which *potentially* lie at the given point
-		FaceVector getTriangleCandidatesAtPoint(const Vec2f& point) const;
-
-	private:
-		//! Constructs a child node
-		QuadTreeNode();
-		void init(QuadTreeNode* parent, const Vec2f& min, const Vec2f& max);
-
-		//turns this node from a leaf node into a normal node by adding 4 children
-		void subdivide();
-
-		//gets the subquadrant in which the specified point lies
-		Quadrant getQuadrantForPoint(const Vec2f& point) const;
-
-		//the parent node in case of a non-root node
-		QuadTreeNode* parent;
-		//either Q_NULLPTR in case of a leaf, or array of size 4
-		QuadTreeNode* children;
-
-		//! The level of this node, starting with 0 for the root node
-		int level;
-		//! The total depth of this sub-tree, starting with 1 for the root node without children
-		int depth;
-		//! The total nodecount of this sub-tree, including this node
-		int nodecount;
-		//contains faces which do not fit wholly in a subnode
-		FaceVector faces;
+		//! The 2D bounds of all triangles below this node
+		Vec2f min, max;
+		//! For leaves the index of the first triangle, for inner nodes the index of the second child
+		int offset;
+		//! The number of triangles of a leaf, 0 for inner nodes
+		int count;
+	};
+
+	//! A triangle with its 2D bounds
+	struct Triangle
+	{
+		Vec2f min, max;
+		//! points to the first index of the face in the index list
+		const unsigned int* pTriangle;
+	};
 
-		Vec2f min, max, mid;
-	} *rootNode;
+	//! Maximal number of triangles in a leaf node
+	static const int MAX_LEAF_SIZE = 4;
+	//! Batches of getHeights() larger than this are processed in parallel
+	static const int PARALLEL_BATCH_SIZE = 4096;
 
-        struct GridSpace {
-                FaceVector faces;
-		float getHeight(const PosList &posList, const float x, const float y) const;
-        };
+	QVector<BVHNode> nodes;
+	QVector<Triangle> triangles;
 
-        GridSpace* grid;
 	Vec2f min, max, range;
-        float nullHeight; // return value for areas outside grid
-
-	void initQuadtree();
-        void initGrid();
-        GridSpace* getSpace(const float x, const float y) const ;
-	static bool triangle_intersects_bbox(const Vec2f &t1, const Vec2f &t2, const Vec2f &t3, const Vec2f &rMin, const Vec2f &rMax);
-	//! Check whether points p and q lie on the same side of line ab, helper for line_intersects_triangle
-	inline static bool sameSide(const Vec2f& p, const Vec2f& q, const Vec2f& a, const Vec2f& b);
-	static bool line_intersects_triangle(const Vec2f &t1, const Vec2f &t2, const Vec2f &t3, const Vec2f &p0, const Vec2f &p1);
+        float nullHeight; // return value for areas outside the mesh
+
+	void initBVH();
+	//! Builds the sub-tree for triangles [begin,end) and returns the index of its root node
+	int buildNode(int begin, int end);
+	//! Returns the maximal height of all triangles at x/y, or -inf if there are none
+	float getHeightInTree(const float x, const float y) const;
 	//! Computes the barycentric coordinates of p inside the triangle t1,t2,t3
 	static void cartesian_to_barycentric(const Vec2f& t1, const Vec2f& t2, const Vec2f& t3, const Vec2f& p, float* l1, float* l2, float* l3);
 	static float face_height_at(const PosList &obj, const unsigned int *pTriangle, const float x, const float y);
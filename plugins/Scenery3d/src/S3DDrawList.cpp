@@ -0,0 +1,119 @@
+/*
+ * Stellarium Scenery3d Plug-in
+ *
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "S3DDrawList.hpp"
+#include "Frustum.hpp"
+
+#include <algorithm>
+
+bool S3DDrawList::SortEntry::operator<(const SortEntry &other) const
+{
+	if(key != other.key)
+		return key < other.key;
+	//keep the order of the index buffer within a material
+	return group->startIndex < other.group->startIndex;
+}
+
+bool S3DDrawList::DepthEntry::operator<(const DepthEntry &other) const
+{
+	//furthest first, we can avoid taking the sqrt here
+	return distSq > other.distSq;
+}
+
+S3DDrawList::S3DDrawList() : culledCount(0)
+{
+}
+
+void S3DDrawList::clear()
+{
+	opaqueEntries.clear();
+	transparentEntries.clear();
+	opaque.clear();
+	transparent.clear();
+	culledCount = 0;
+}
+
+void S3DDrawList::build(const StelOBJ::ObjectList &objects, const QVector<MaterialMode> &modes, const QVector<uint> &keys,
+			const Frustum *frustum, const Vec3f &eye)
+{
+	Q_ASSERT(modes.size() == keys.size());
+
+	clear();
+
+	for(int i=0; i<objects.size(); ++i)
+	{
+		const StelOBJ::Object& obj = objects.at(i);
+
+		//test the whole object first, most objects are either completely inside or outside
+		bool testGroups = false;
+		if(frustum)
+		{
+			if(frustum->boxInFrustum(obj.boundingbox) == Frustum::OUTSIDE)
+			{
+				for(int j=0; j<obj.groups.size(); ++j)
+				{
+					if(modes.at(obj.groups.at(j).materialIndex) != Skip)
+						++culledCount;
+				}
+				continue;
+			}
+			testGroups = obj.groups.size() > 1;
+		}
+
+		for(int j=0; j<obj.groups.size(); ++j)
+		{
+			const StelOBJ::MaterialGroup& grp = obj.groups.at(j);
+			const MaterialMode mode = modes.at(grp.materialIndex);
+			if(mode == Skip)
+				continue;
+
+			if(testGroups && frustum->boxInFrustum(grp.boundingbox) == Frustum::OUTSIDE)
+			{
+				++culledCount;
+				continue;
+			}
+
+			if(mode == Opaque)
+			{
+				SortEntry e;
+				e.key = (static_cast<quint64>(keys.at(grp.materialIndex)) << 32) | static_cast<quint32>(grp.materialIndex);
+				e.group = &grp;
+				opaqueEntries.append(e);
+			}
+			else
+			{
+				DepthEntry e;
+				e.distSq = (grp.centroid - eye).lengthSquared();
+				e.group = &grp;
+				transparentEntries.append(e);
+			}
+		}
+	}
+
+	std::sort(opaqueEntries.begin(), opaqueEntries.end());
+	std::sort(transparentEntries.begin(), transparentEntries.end());
+
+	opaque.reserve(opaqueEntries.size());
+	for(int i=0; i<opaqueEntries.size(); ++i)
+		opaque.append(opaqueEntries.at(i).group);
+	transparent.reserve(transparentEntries.size());
+	for(int i=0; i<transparentEntries.size(); ++i)
+		transparent.append(transparentEntries.at(i).group);
+}
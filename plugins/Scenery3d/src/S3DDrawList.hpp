@@ -0,0 +1,87 @@
+/*
+ * Stellarium Scenery3d Plug-in
+ *
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef S3DDRAWLIST_HPP
+#define S3DDRAWLIST_HPP
+
+#include "StelOBJ.hpp"
+
+#include <QVector>
+
+class Frustum;
+
+//! Builds the list of material groups which are drawn in a single render pass.
+//! Groups whose bounding box is outside of the view volume of the pass are culled,
+//! opaque groups are sorted by a state key and their material to minimize state changes,
+//! and transparent groups are sorted back to front.
+//! This does not use OpenGL, S3DRenderer issues the actual draw calls.
+class S3DDrawList
+{
+public:
+	//! How the groups of a material are handled in a pass
+	enum MaterialMode
+	{
+		Skip,		//!< the material is not drawn
+		Opaque,		//!< drawn first, sorted by state
+		Transparent	//!< drawn last, sorted by distance to the eye
+	};
+
+	S3DDrawList();
+
+	//! Rebuilds the list from all material groups of the objects.
+	//! @param modes the MaterialMode of each material, indexed by StelOBJ::MaterialGroup::materialIndex
+	//! @param keys a sort key for each material, usually the shader flags, so that groups using
+	//! the same shader are drawn together. Groups are further sorted by material within the same key.
+	//! @param frustum if not null, groups whose bounding box is completely outside are culled
+	//! @param eye the position used for sorting the transparent groups
+	void build(const StelOBJ::ObjectList& objects, const QVector<MaterialMode>& modes, const QVector<uint>& keys,
+		   const Frustum* frustum, const Vec3f& eye);
+
+	//! The opaque groups of the last build(), in drawing order
+	const QVector<const StelOBJ::MaterialGroup*>& getOpaqueGroups() const { return opaque; }
+	//! The transparent groups of the last build(), in drawing order (furthest first)
+	const QVector<const StelOBJ::MaterialGroup*>& getTransparentGroups() const { return transparent; }
+	//! The number of groups culled by the frustum in the last build()
+	int getCulledCount() const { return culledCount; }
+
+	void clear();
+
+private:
+	struct SortEntry
+	{
+		quint64 key;
+		const StelOBJ::MaterialGroup* group;
+		bool operator<(const SortEntry& other) const;
+	};
+	struct DepthEntry
+	{
+		float distSq;
+		const StelOBJ::MaterialGroup* group;
+		bool operator<(const DepthEntry& other) const;
+	};
+
+	QVector<SortEntry> opaqueEntries;
+	QVector<DepthEntry> transparentEntries;
+	QVector<const StelOBJ::MaterialGroup*> opaque;
+	QVector<const StelOBJ::MaterialGroup*> transparent;
+	int culledCount;
+};
+
+#endif // S3DDRAWLIST_HPP
@@ -77,7 +77,7 @@ S3DRenderer::S3DRenderer(QObject *parent)
       cubemapSize(1024),shadowmapSize(1024),wasMovedInLastDrawCall(false),
       core(Q_NULLPTR), landscapeMgr(Q_NULLPTR),
       backfaceCullState(true), blendEnabled(false), lastMaterial(Q_NULLPTR), curShader(Q_NULLPTR),
-      drawnTriangles(0), drawnModels(0), materialSwitches(0), shaderSwitches(0),
+      drawnTriangles(0), drawnModels(0), materialSwitches(0), shaderSwitches(0), culledModels(0),
       requiresCubemap(false), cubemappingUsedLastFrame(false),
       lazyDrawing(false), updateOnlyDominantOnMoving(true), updateSecondDominantOnMoving(true), needsMovementEndUpdate(false),
       needsCubemapUpdate(true), needsMovementUpdate(false), lazyInterval(2.0), lastCubemapUpdate(0.0), lastCubemapUpdateRealTime(0), lastMovementEndRealTime(0),
@@ -273,16 +273,6 @@ void S3DRenderer::setupMaterialUniforms(QOpenGLShaderProgram* shader, const S3DS
 	}
 }
 
-//depth sort helper
-Vec3f zSortValue;
-bool zSortFunction(const StelOBJ::MaterialGroup* const & mLeft, const StelOBJ::MaterialGroup* const & mRight)
-{
-	//we can avoid taking the sqrt here
-	float dist1 = (mLeft->centroid - zSortValue).lengthSquared();
-	float dist2 = (mRight->centroid - zSortValue).lengthSquared();
-	return dist1>dist2;
-}
-
 bool S3DRenderer::drawArrays(bool shading, bool blendAlphaAdditive)
 {
 	//override some shader Params
@@ -310,62 +300,58 @@ bool S3DRenderer::drawArrays(bool shading, bool blendAlphaAdditive)
 	lastMaterial = Q_NULLPTR;
 	curShader = Q_NULLPTR;
 	initializedShaders.clear();
-	transparentGroups.clear();
 	bool success = true;
 
-	//TODO optimize: clump models with same material together when first loading to minimize state changes
-
-	const S3DScene::ObjectList& objectList = currentScene->getObjects();
-	for(int i=0; i<objectList.size(); ++i)
+	//decide how each material is drawn in this pass, and find the shader it will use
+	const S3DScene::MaterialList& materialList = currentScene->getMaterialList();
+	materialModes.resize(materialList.size());
+	materialKeys.resize(materialList.size());
+	for(int i=0; i<materialList.size(); ++i)
 	{
-		const StelOBJ::Object& obj = objectList.at(i);
-		const StelOBJ::MaterialGroupList& matGroups = obj.groups;
+		const S3DScene::Material& mat = materialList.at(i);
+		S3DDrawList::MaterialMode mode = S3DDrawList::Opaque;
 
-		for(int j = 0; j < matGroups.size();++j)
+		if(mat.traits.isFullyTransparent)
+			mode = S3DDrawList::Skip; //dont render fully invisible objects
+		else if(shading)
 		{
-			const StelOBJ::MaterialGroup& matGroup = matGroups.at(j);
-			const S3DScene::Material* pMaterial = &currentScene->getMaterial(matGroup.materialIndex);
-			Q_ASSERT(pMaterial);
-
-			if(pMaterial->traits.isFullyTransparent)
-				continue; //dont render fully invisible objects
-
-			if(shading)
-			{
-				if(pMaterial->traits.hasTransparency || pMaterial->traits.isFading)
-				{
-					//process transparent objects later, with Z sorting
-					transparentGroups.append(&matGroup);
-					continue;
-				}
-			}
-			else
-			{
-				//objects start casting shadows with at least 0.2 opacity
-				if(pMaterial->d * pMaterial->vis_fadeValue < 0.2)
-					continue;
-			}
-
-			success = drawMaterialGroup(matGroup,shading,blendAlphaAdditive);
-			if(!success)
-				break;
+			//transparent objects are drawn last, with Z sorting
+			if(mat.traits.hasTransparency || mat.traits.isFading)
+				mode = S3DDrawList::Transparent;
+		}
+		else
+		{
+			//objects start casting shadows with at least 0.2 opacity
+			if(mat.d * mat.vis_fadeValue < 0.2)
+				mode = S3DDrawList::Skip;
 		}
+
+		materialModes[i] = mode;
+		//materials with the same shader are drawn together, backface culling state is the next most expensive switch
+		materialKeys[i] = shaderManager.getShaderFlags(renderShaderParameters,&mat) << 1 | (mat.bBackface ? 1u : 0u);
 	}
 
-	//sort and render transparent objects
-	if(transparentGroups.size()>0)
+	//cull against the clip volume of this pass, which for the shadow passes is the cropped light frustum,
+	//so only casters which can end up in the shadow map remain.
+	//The geometry shader renders all cubemap faces at once, so nothing can be culled there.
+	const Frustum* frustum = Q_NULLPTR;
+	if(!renderShaderParameters.geometryShader)
 	{
-		zSortValue = currentScene->getEyePosition().toVec3f();
-		std::sort(transparentGroups.begin(),transparentGroups.end(),zSortFunction);
-
-		for(int i = 0; i<transparentGroups.size();++i)
-		{
-			success = drawMaterialGroup(*transparentGroups[i],shading,blendAlphaAdditive);
-			if(!success)
-				break;
-		}
+		passFrustum.setFromMatrix(projectionMatrix * modelViewMatrix);
+		frustum = &passFrustum;
 	}
 
+	drawList.build(currentScene->getObjects(),materialModes,materialKeys,frustum,currentScene->getEyePosition().toVec3f());
+	culledModels += drawList.getCulledCount();
+
+	const QVector<const StelOBJ::MaterialGroup*>& opaqueGroups = drawList.getOpaqueGroups();
+	for(int i = 0; i<opaqueGroups.size() && success;++i)
+		success = drawMaterialGroup(*opaqueGroups.at(i),shading,blendAlphaAdditive);
+
+	const QVector<const StelOBJ::MaterialGroup*>& transparentGroups = drawList.getTransparentGroups();
+	for(int i = 0; i<transparentGroups.size() && success;++i)
+		success = drawMaterialGroup(*transparentGroups.at(i),shading,blendAlphaAdditive);
+
 	//release last used shader and VAO
 	if(curShader)
 		curShader->release();
@@ -1586,6 +1572,9 @@ void S3DRenderer::drawDebug()
 	str = QString("%1 mats, %2 shaders").arg(materialSwitches).arg(shaderSwitches);
 	painter.drawText(screen_x, screen_y, str);
 	screen_y -= 15.0f;
+	str = QString("%1 mdls culled").arg(culledModels);
+	painter.drawText(screen_x, screen_y, str);
+	screen_y -= 15.0f;
 	str = "View Pos";
 	painter.drawText(screen_x, screen_y, str);
 	screen_y -= 15.0f;
@@ -2373,7 +2362,7 @@ void S3DRenderer::draw(StelCore* core, S3DScene &scene)
 	currentScene = &scene;
 
 	//reset render statistic
-	drawnTriangles = drawnModels = materialSwitches = shaderSwitches = 0;
+	drawnTriangles = drawnModels = materialSwitches = shaderSwitches = culledModels = 0;
 
 	requiresCubemap = core->getCurrentProjectionType() != StelCore::ProjectionPerspective;
 	//update projector from core
@@ -32,6 +32,7 @@
 #include "Heightmap.hpp"
 #include "Frustum.hpp"
 #include "Polyhedron.hpp"
+#include "S3DDrawList.hpp"
 #include "S3DEnum.hpp"
 #include "SceneInfo.hpp"
 #include "ShaderManager.hpp"
@@ -178,11 +179,16 @@ private:
 	const S3DScene::Material* lastMaterial;
 	QOpenGLShaderProgram* curShader;
 	QSet<QOpenGLShaderProgram*> initializedShaders;
-	QVector<const StelOBJ::MaterialGroup*> transparentGroups;
+	// per-pass material state and the resulting culled + sorted groups
+	QVector<S3DDrawList::MaterialMode> materialModes;
+	QVector<uint> materialKeys;
+	Frustum passFrustum;
+	S3DDrawList drawList;
 
 	// debug info
 	int drawnTriangles,drawnModels;
 	int materialSwitches, shaderSwitches;
+	int culledModels;
 
 	/// ---- Cubemapping variables ----
 	bool requiresCubemap; //true if cubemapping is required (if projection is anything else than Perspective)
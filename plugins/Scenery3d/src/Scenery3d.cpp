@@ -459,7 +459,8 @@ S3DScene* Scenery3d::loadSceneBackground(const SceneInfo& scene) const
 	StelOBJ modelOBJ;
 	QString modelFile = StelFileMgr::findFile( scene.fullPath+ "/" + scene.modelScenery);
 	qCDebug(scenery3d)<<"Loading scene from "<<modelFile;
-	if(!modelOBJ.load(modelFile, scene.vertexOrderEnum))
+	//scenes can be large, use the binary cache to avoid parsing them each time
+	if(!modelOBJ.load(modelFile, scene.vertexOrderEnum, true))
 	{
 	    qCCritical(scenery3d)<<"Failed to load OBJ file"<<modelFile;
 	    return Q_NULLPTR;
@@ -486,7 +487,7 @@ S3DScene* Scenery3d::loadSceneBackground(const SceneInfo& scene) const
 		StelOBJ groundOBJ;
 		modelFile = StelFileMgr::findFile(scene.fullPath + "/" + scene.modelGround);
 		qCDebug(scenery3d)<<"Loading ground from"<<modelFile;
-		if(!groundOBJ.load(modelFile, scene.vertexOrderEnum))
+		if(!groundOBJ.load(modelFile, scene.vertexOrderEnum, true))
 		{
 			qCCritical(scenery3d)<<"Failed to load ground model"<<modelFile;
 			return Q_NULLPTR;
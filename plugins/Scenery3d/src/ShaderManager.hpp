@@ -122,6 +122,10 @@ public:
 	//! Returns a shader that supports the specified operations. Must be called within a GL context.
 	inline QOpenGLShaderProgram* getShader(const GlobalShaderParameters &globals, const S3DScene::Material *mat = Q_NULLPTR);
 
+	//! Returns the feature flags of the shader getShader() would return. This does not need a GL context,
+	//! and can be used to group materials which share the same shader.
+	inline uint getShaderFlags(const GlobalShaderParameters &globals, const S3DScene::Material *mat = Q_NULLPTR) const;
+
 	//! Returns the Frustum/Boundingbox Debug shader
 	inline QOpenGLShaderProgram* getDebugShader();
 
@@ -216,6 +220,11 @@ private:
 };
 
 QOpenGLShaderProgram* ShaderMgr::getShader(const GlobalShaderParameters& globals,const S3DScene::Material* mat)
+{
+	return findOrLoadShader(getShaderFlags(globals,mat));
+}
+
+uint ShaderMgr::getShaderFlags(const GlobalShaderParameters& globals,const S3DScene::Material* mat) const
 {
 	//Build bitflags from bools. Some stuff requires pixelLighting to be enabled, so check it too.
 
@@ -257,7 +266,7 @@ QOpenGLShaderProgram* ShaderMgr::getShader(const GlobalShaderParameters& globals
 			flags|= HEIGHT;
 	}
 
-	return findOrLoadShader(flags);
+	return flags;
 }
 
 QOpenGLShaderProgram* ShaderMgr::getDebugShader()
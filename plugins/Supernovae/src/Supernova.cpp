@@ -28,6 +28,7 @@
 #include "StelSkyDrawer.hpp"
 #include "StelLocaleMgr.hpp"
 #include "StarMgr.hpp"
+#include "StelMarkerBatch.hpp"
 
 #include <QTextStream>
 #include <QDebug>
@@ -62,6 +63,7 @@ Supernova::Supernova(const QVariantMap& map)
 	peakJD = map.value("peakJD").toDouble();
 	snra = StelUtils::getDecAngle(map.value("alpha").toString());
 	snde = StelUtils::getDecAngle(map.value("delta").toString());
+	StelUtils::spheToRect(snra, snde, XYZ);
 	note = map.value("note").toString();
 	distance = map.value("distance").toDouble();
 
@@ -250,7 +252,7 @@ void Supernova::update(double deltaTime)
 	labelsFader.update((int)(deltaTime*1000));
 }
 
-void Supernova::draw(StelCore* core, StelPainter& painter)
+void Supernova::draw(StelCore* core, StelPainter& painter, StelMarkerBatch& batch)
 {
 	StelSkyDrawer* sd = core->getSkyDrawer();
 	StarMgr* smgr = GETSTELMODULE(StarMgr); // It's need for checking displaying of labels for stars
@@ -260,23 +262,18 @@ void Supernova::draw(StelCore* core, StelPainter& painter)
 	float size, shift;
 	double mag;
 
-	StelUtils::spheToRect(snra, snde, XYZ);
 	mag = getVMagnitudeWithExtinction(core);
-	sd->preDrawPointSource(&painter);
 	float mlimit = sd->getLimitMagnitude();
 	
 	if (mag <= mlimit)
 	{
 		sd->computeRCMag(mag, &rcMag);		
 		sd->drawPointSource(&painter, Vec3f(XYZ[0],XYZ[1],XYZ[2]), rcMag, color, false);
-		painter.setColor(color[0], color[1], color[2], 1.f);
 		size = getAngularSize(Q_NULLPTR)*M_PI/180.*painter.getProjector()->getPixelPerRadAtCenter();
 		shift = 6.f + size/1.8f;
 		if (labelsFader.getInterstate()<=0.f && (mag+5.f)<mlimit && smgr->getFlagLabels())
 		{
-			painter.drawText(XYZ, designation, 0, shift, shift, false);
+			batch.addLabel(XYZ, designation, color, shift);
 		}
 	}
-
-	sd->postDrawPointSource(&painter);
 }
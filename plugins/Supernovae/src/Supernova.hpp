@@ -31,6 +31,7 @@
 #include "StelFader.hpp"
 
 class StelPainter;
+class StelMarkerBatch;
 
 //! @class Supernova
 //! A Supernova object represents one supernova on the sky.
@@ -99,7 +100,9 @@ private:
 
 	static StelTextureSP hintTexture;
 
-	void draw(StelCore* core, StelPainter& painter);
+	//! Draw the supernova as a point source and add its label to the batch.
+	//! Must be called between StelSkyDrawer::preDrawPointSource() and postDrawPointSource().
+	void draw(StelCore* core, StelPainter& painter, StelMarkerBatch& batch);
 
 	// Supernova
 	QString designation;               //! The ID of the supernova
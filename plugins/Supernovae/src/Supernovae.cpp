@@ -29,6 +29,7 @@
 #include "StelJsonParser.hpp"
 #include "StelFileMgr.hpp"
 #include "StelUtils.hpp"
+#include "StelSkyDrawer.hpp"
 #include "StelTranslator.hpp"
 #include "LabelMgr.hpp"
 #include "Supernova.hpp"
@@ -200,12 +201,19 @@ void Supernovae::draw(StelCore* core)
 	StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 	StelPainter painter(prj);
 	painter.setFont(font);
-	
-	foreach (const SupernovaP& sn, snstar)
-	{
-		if (sn && sn->initialized)
-			sn->draw(core, painter);
-	}
+
+	// Only the supernovae inside the viewport are drawn. The margin keeps the halos of supernovae just outside.
+	const float margin = 20.f*prj->getDevicePixelsPerPixel();
+	const SphericalRegionP viewport = prj->getViewportConvexPolygon(margin, margin);
+	snstar.findInRegion(viewport.data(), visibleSnstar);
+
+	StelSkyDrawer* sd = core->getSkyDrawer();
+	markerBatch.begin(prj);
+	sd->preDrawPointSource(&painter);
+	foreach (const SupernovaP& sn, visibleSnstar)
+		sn->draw(core, painter, markerBatch);
+	sd->postDrawPointSource(&painter);
+	markerBatch.draw(painter, StelTextureSP());
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer())
 		drawPointer(core, painter);
@@ -237,22 +245,9 @@ QList<StelObjectP> Supernovae::searchAround(const Vec3d& av, double limitFov, co
 {
 	QList<StelObjectP> result;
 
-	Vec3d v(av);
-	v.normalize();
-	double cosLimFov = cos(limitFov * M_PI/180.);
-	Vec3d equPos;
-
-	foreach(const SupernovaP& sn, snstar)
+	foreach(const SupernovaP& sn, snstar.searchAround(av, limitFov))
 	{
-		if (sn->initialized)
-		{
-			equPos = sn->XYZ;
-			equPos.normalize();
-			if (equPos[0]*v[0] + equPos[1]*v[1] + equPos[2]*v[2]>=cosLimFov)
-			{
-				result.append(qSharedPointerCast<StelObject>(sn));
-			}
-		}
+		result.append(qSharedPointerCast<StelObject>(sn));
 	}
 
 	return result;
@@ -260,18 +255,13 @@ QList<StelObjectP> Supernovae::searchAround(const Vec3d& av, double limitFov, co
 
 StelObjectP Supernovae::searchByName(const QString& englishName) const
 {
-	foreach(const SupernovaP& sn, snstar)
-	{
-		if (sn->getEnglishName().toUpper() == englishName.toUpper())
-			return qSharedPointerCast<StelObject>(sn);
-	}
-
-	return Q_NULLPTR;
+	return qSharedPointerCast<StelObject>(snstar.searchByName(englishName));
 }
 
 StelObjectP Supernovae::searchByNameI18n(const QString& nameI18n) const
 {
-	foreach(const SupernovaP& sn, snstar)
+	// The translated names depend on the language, so they are not indexed
+	foreach(const SupernovaP& sn, snstar.getObjects())
 	{
 		if (sn->getNameI18n().toUpper() == nameI18n.toUpper())
 			return qSharedPointerCast<StelObject>(sn);
@@ -285,14 +275,14 @@ QStringList Supernovae::listAllObjects(bool inEnglish) const
 	QStringList result;
 	if (inEnglish)
 	{
-		foreach (const SupernovaP& sn, snstar)
+		foreach (const SupernovaP& sn, snstar.getObjects())
 		{
 			result << sn->getEnglishName();
 		}
 	}
 	else
 	{
-		foreach (const SupernovaP& sn, snstar)
+		foreach (const SupernovaP& sn, snstar.getObjects())
 		{
 			result << sn->getNameI18n();
 		}
@@ -399,6 +389,7 @@ QVariantMap Supernovae::loadSNeMap(QString path)
 void Supernovae::setSNeMap(const QVariantMap& map)
 {
 	snstar.clear();
+	visibleSnstar.clear();
 	snlist.clear();
 	SNCount = 0;
 	QVariantMap sneMap = map.value("supernova").toMap();
@@ -412,7 +403,7 @@ void Supernovae::setSNeMap(const QVariantMap& map)
 
 		SupernovaP sn(new Supernova(sneData));
 		if (sn->initialized)
-			snstar.append(sn);
+			snstar.insert(sn, sn->XYZ, QStringList(sn->getEnglishName()));
 
 	}
 }
@@ -486,9 +477,9 @@ float Supernovae::getLowerLimitBrightness() const
 
 SupernovaP Supernovae::getByID(const QString& id) const
 {
-	foreach(const SupernovaP& sn, snstar)
+	foreach(const SupernovaP& sn, snstar.getObjects())
 	{
-		if (sn->initialized && sn->designation == id)
+		if (sn->designation == id)
 			return sn;
 	}
 	return SupernovaP();
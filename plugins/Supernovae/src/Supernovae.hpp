@@ -23,6 +23,8 @@
 #include "StelObject.hpp"
 #include "StelFader.hpp"
 #include "StelTextureTypes.hpp"
+#include "StelCatalogIndex.hpp"
+#include "StelMarkerBatch.hpp"
 #include "Supernova.hpp"
 #include <QFont>
 #include <QVariantMap>
@@ -223,7 +225,11 @@ private:
 	int SNCount;
 
 	StelTextureSP texPointer;
-	QList<SupernovaP> snstar;
+	//! The supernovae of the catalog, indexed by position and English name
+	StelCatalogIndex<Supernova> snstar;
+	//! The supernovae inside the viewport in the current frame
+	QVector<SupernovaP> visibleSnstar;
+	StelMarkerBatch markerBatch;
 	QHash<QString, double> snlist;
 
 	// variables and functions for the updater
@@ -58,6 +58,7 @@
 #include <QStringList>
 #include <QDir>
 #include <QSignalMapper>
+#include <QThread>
 
 #include <QDebug>
 
@@ -90,6 +91,7 @@ StelPluginInfo TelescopeControlStelPluginInterface::getPluginInfo() const
 // Constructor and destructor
 TelescopeControl::TelescopeControl()
 	: toolbarButton(Q_NULLPTR)
+	, ioThread(Q_NULLPTR)
 	, useTelescopeServerLogs(false)
 	, useServerExecutables(false)
 	, telescopeDialog(Q_NULLPTR)
@@ -147,6 +149,11 @@ void TelescopeControl::init()
 			because LandscapeMgr::getCallOrder() depended on the module's
 			existence to return a value.*/
 		
+		//The clients communicate with the telescopes in this thread
+		ioThread = new QThread(this);
+		ioThread->setObjectName("TelescopeControl I/O");
+		ioThread->start();
+
 		//Load and start all telescope clients
 		loadTelescopes();
 		
@@ -234,6 +241,11 @@ void TelescopeControl::deinit()
 {
 	//Destroy all clients first in order to avoid displaying a TCP error
 	deleteAllTelescopes();
+	if (ioThread)
+	{
+		ioThread->quit();
+		ioThread->wait();
+	}
 
 	QHash<int, QProcess*>::const_iterator iterator = telescopeServerProcess.constBegin();
 	while(iterator != telescopeServerProcess.constEnd())
@@ -447,6 +459,8 @@ void TelescopeControl::communicate(void)
 		QMap<int, TelescopeClientP>::const_iterator telescope = telescopeClients.constBegin();
 		while (telescope != telescopeClients.end())
 		{
+			//Most clients communicate in the I/O thread, and only hand over the positions they have received
+			telescope.value()->receivePositions();
 			logAtSlot(telescope.key());//If there's no log, it will be ignored
 			if(telescope.value()->prepareCommunication())
 			{
@@ -1307,6 +1321,7 @@ bool TelescopeControl::startClientAtSlot(int slotNumber, ConnectionType connecti
 				newTelescope->addOcular(circles[i]);
 
 		telescopeClients.insert(slotNumber, TelescopeClientP(newTelescope));
+		newTelescope->startCommunication(ioThread);
 		return true;
 	}
 
@@ -297,7 +297,8 @@ private:
 	//! Draw a nice animated pointer around the object if it's selected
 	void drawPointer(const StelProjectorP& prj, const StelCore* core, StelPainter& sPainter);
 
-	//! Perform the communication with the telescope servers
+	//! Take the positions received by the clients, and perform the communication of the clients
+	//! which communicate in the main thread
 	void communicate(void);
 	
 	LinearFader labelFader;
@@ -323,6 +324,8 @@ private:
 	
 	//! Contains the initialized telescope client objects representing the telescopes that Stellarium is connected to or attempting to connect to.
 	QMap<int, TelescopeClientP> telescopeClients;
+	//! Thread in which the clients communicate with the telescopes, so that slow connections don't delay the frames
+	class QThread* ioThread;
 	//! Contains QProcess objects of the currently running telescope server processes that have been launched by Stellarium.
 	QHash<int, QProcess*> telescopeServerProcess;
 	QStringList telescopeServers;
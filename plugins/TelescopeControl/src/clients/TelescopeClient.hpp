@@ -36,10 +36,10 @@
 #include "StelApp.hpp"
 #include "StelObject.hpp"
 #include "InterpolatedPosition.hpp"
+#include "TelescopeTransport.hpp"
 
 class StelCore;
-
-qint64 getNow(void);
+class QThread;
 
 enum Equinox {
 	EquinoxJ2000,
@@ -56,7 +56,7 @@ class TelescopeClient : public QObject, public StelObject
 public:
 	static const QString TELESCOPECLIENT_TYPE;
 	static TelescopeClient *create(const QString &url);
-	virtual ~TelescopeClient(void) {}
+	virtual ~TelescopeClient(void);
 	
 	// Method inherited from StelObject
 	QString getEnglishName(void) const {return name;}
@@ -85,14 +85,29 @@ public:
 	void addOcular(double fov) {if (fov>=0.0) oculars.push_back(fov);}
 	const QList<double> &getOculars(void) const {return oculars;}
 	
+	//! Communication with the telescope in the main thread, once per frame.
+	//! Clients with a transport communicate in the I/O thread instead.
 	virtual bool prepareCommunication() {return false;}
 	virtual void performCommunication() {}
 
+	//! Start the transport of the client, if it has one, in the I/O thread @param thread.
+	void startCommunication(QThread* thread);
+	//! Take over the positions received by the transport. Called in the main thread once per frame.
+	virtual void receivePositions() {}
+
 protected:
 	TelescopeClient(const QString &name);
 	QString nameI18n;
 	const QString name;
 
+	//! Add the positions received by the transport to @param interpolatedPosition,
+	//! converted from @param equinox to J2000. The old positions are forgotten when the connection was lost meanwhile.
+	void takePositions(InterpolatedPosition& interpolatedPosition, Equinox equinox);
+	//! Stop and delete the transport. Clients whose transport uses the client itself call this in their destructor.
+	void stopCommunication();
+	//! Communicates with the telescope in the I/O thread. May be Q_NULLPTR.
+	TelescopeTransport* transport;
+
 	virtual QString getTelescopeInfoString(const StelCore* core, const InfoStringGroup& flags) const
 	{
 		Q_UNUSED(core);
@@ -104,6 +119,8 @@ private:
 	float getSelectPriority(const StelCore* core) const {Q_UNUSED(core); return -10.f;}
 private:
 	QList<double> oculars; // fov of the oculars
+	//! The disconnection count of the transport when the positions were last taken
+	int disconnections;
 };
 
 //! Example Telescope class. A physical telescope does not exist.
@@ -165,39 +182,26 @@ class TelescopeTCP : public TelescopeClient
 	Q_OBJECT
 public:
 	TelescopeTCP(const QString &name, const QString &params, Equinox eq = EquinoxJ2000);
-	~TelescopeTCP(void)
+	bool isConnected(void) const
 	{
-		hangup();
+		return (transport && transport->isConnected());
 	}
-	bool isConnected(void) const
+	void receivePositions()
 	{
-		//return (tcpSocket->isValid() && !wait_for_connection_establishment);
-		return (tcpSocket->state() == QAbstractSocket::ConnectedState);
+		takePositions(interpolatedPosition, equinox);
 	}
 	
 private:
 	Vec3d getJ2000EquatorialPos(const StelCore* core=Q_NULLPTR) const;
-	bool prepareCommunication();
-	void performCommunication();
 	void telescopeGoto(const Vec3d &j2000Pos, StelObjectP selectObject);
 	bool isInitialized(void) const
 	{
 		return (!address.isNull());
 	}
-	void performReading(void);
-	void performWriting(void);
 	
 private:
-	void hangup(void);
 	QHostAddress address;
 	unsigned int port;
-	QTcpSocket * tcpSocket;
-	bool wait_for_connection_establishment;
-	qint64 end_of_timeout;
-	char readBuffer[120];
-	char *readBufferEnd;
-	char writeBuffer[120];
-	char *writeBufferEnd;
 	int time_delay;
 
 	InterpolatedPosition interpolatedPosition;
@@ -207,10 +211,6 @@ private:
 	}
 
 	Equinox equinox;
-	
-private slots:
-	void socketConnected(void);
-	void socketFailed(QAbstractSocket::SocketError socketError);
 };
 
 #endif // _TELESCOPE_HPP_
@@ -29,6 +29,7 @@
 #include "Lx200Connection.hpp"
 #include "Lx200Command.hpp"
 #include "LogFile.hpp"
+#include "TelescopeServerTransport.hpp"
 #include "StelCore.hpp"
 
 #include <QRegExp>
@@ -89,6 +90,7 @@ TelescopeClientDirectLx200::TelescopeClientDirectLx200 (const QString &name, con
 	
 	// lx200 will be deleted in the destructor of Server
 	addConnection(lx200);
+	transport = new TelescopeServerTransport(*this, log_file);
 	
 	long_format_used = false; // unknown
 	last_ra = 0;
@@ -97,7 +99,7 @@ TelescopeClientDirectLx200::TelescopeClientDirectLx200 (const QString &name, con
 	answers_received = false;
 }
 
-//! queues a GOTO command
+//! queues a GOTO command in the I/O thread
 void TelescopeClientDirectLx200::telescopeGoto(const Vec3d &j2000Pos, StelObjectP selectObject)
 {
 	Q_UNUSED(selectObject);
@@ -122,7 +124,7 @@ void TelescopeClientDirectLx200::telescopeGoto(const Vec3d &j2000Pos, StelObject
 		unsigned int ra_int = (unsigned int)floor(0.5 + ra*(((unsigned int)0x80000000)/M_PI));
 		int dec_int = (int)floor(0.5 + dec*(((unsigned int)0x80000000)/M_PI));
 
-		gotoReceived(ra_int, dec_int);
+		QMetaObject::invokeMethod(transport, "sendGoto", Qt::QueuedConnection, Q_ARG(unsigned int, ra_int), Q_ARG(int, dec_int));
 	}
 	/*
 		else
@@ -145,17 +147,6 @@ Vec3d TelescopeClientDirectLx200::getJ2000EquatorialPos(const StelCore*) const
 	return interpolatedPosition.get(now);
 }
 
-bool TelescopeClientDirectLx200::prepareCommunication()
-{
-	//TODO: Nothing to prepare?
-	return true;
-}
-
-void TelescopeClientDirectLx200::performCommunication()
-{
-	step(10000);
-}
-
 void TelescopeClientDirectLx200::communicationResetReceived(void)
 {
 	long_format_used = false;
@@ -222,12 +213,12 @@ void TelescopeClientDirectLx200::step(long long int timeout_micros)
 
 bool TelescopeClientDirectLx200::isConnected(void) const
 {
-	return (!lx200->isClosed());//TODO
+	return (transport && transport->isConnected());
 }
 
 bool TelescopeClientDirectLx200::isInitialized(void) const
 {
-	return (!lx200->isClosed());
+	return (lx200 && !lx200->isClosed());
 }
 
 //Merged from Connection::sendPosition() and TelescopeTCP::performReading()
@@ -239,11 +230,6 @@ void TelescopeClientDirectLx200::sendPosition(unsigned int ra_int, int dec_int,
 	const double dec = dec_int * (M_PI/(unsigned int)0x80000000);
 	const double cdec = cos(dec);
 	Vec3d position(cos(ra)*cdec, sin(ra)*cdec, sin(dec));
-	Vec3d j2000Position = position;
-	if (equinox == EquinoxJNow)
-	{
-		const StelCore* core = StelApp::getInstance().getCore();
-		j2000Position = core->equinoxEquToJ2000(position, StelCore::RefractionOff);
-	}
-	interpolatedPosition.add(j2000Position, getNow(), server_micros, status);
+	// called in the I/O thread, the client converts the position to J2000 when it takes it
+	static_cast<TelescopeServerTransport*>(transport)->reportPosition(position, server_micros, status);
 }
@@ -47,12 +47,17 @@ public:
 	TelescopeClientDirectLx200(const QString &name, const QString &parameters, Equinox eq = EquinoxJ2000);
 	~TelescopeClientDirectLx200(void)
 	{
-		//hangup();
+		// the transport steps this server in the I/O thread
+		stopCommunication();
 	}
 	
 	//======================================================================
 	// Methods inherited from TelescopeClient
 	bool isConnected(void) const;
+	void receivePositions()
+	{
+		takePositions(interpolatedPosition, equinox);
+	}
 	
 	//======================================================================
 	// Methods inherited from Server
@@ -66,8 +71,6 @@ private:
 	//======================================================================
 	// Methods inherited from TelescopeClient
 	Vec3d getJ2000EquatorialPos(const StelCore* core=Q_NULLPTR) const;
-	bool prepareCommunication();
-	void performCommunication();
 	void telescopeGoto(const Vec3d &j2000Pos, StelObjectP selectObject);
 	bool isInitialized(void) const;
 	
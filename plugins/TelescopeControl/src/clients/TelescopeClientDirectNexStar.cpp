@@ -29,6 +29,7 @@
 #include "NexStarConnection.hpp"
 #include "NexStarCommand.hpp"
 #include "LogFile.hpp"
+#include "TelescopeServerTransport.hpp"
 #include "StelCore.hpp"
 
 #include <QRegExp>
@@ -87,13 +88,14 @@ TelescopeClientDirectNexStar::TelescopeClientDirectNexStar(const QString &name,
 	
 	//This connection will be deleted in the destructor of Server
 	addConnection(nexstar);
+	transport = new TelescopeServerTransport(*this, log_file);
 	
 	last_ra = 0;
 	queue_get_position = true;
 	next_pos_time = -0x8000000000000000LL;
 }
 
-//! queues a GOTO command
+//! queues a GOTO command in the I/O thread
 void TelescopeClientDirectNexStar::telescopeGoto(const Vec3d &j2000Pos, StelObjectP selectObject)
 {
 	Q_UNUSED(selectObject);
@@ -118,7 +120,7 @@ void TelescopeClientDirectNexStar::telescopeGoto(const Vec3d &j2000Pos, StelObje
 		unsigned int ra_int = (unsigned int)floor(0.5 + ra*(((unsigned int)0x80000000)/M_PI));
 		int dec_int = (int)floor(0.5 + dec*(((unsigned int)0x80000000)/M_PI));
 
-		gotoReceived(ra_int, dec_int);
+		QMetaObject::invokeMethod(transport, "sendGoto", Qt::QueuedConnection, Q_ARG(unsigned int, ra_int), Q_ARG(int, dec_int));
 	}
 	/*
 		else
@@ -141,17 +143,6 @@ Vec3d TelescopeClientDirectNexStar::getJ2000EquatorialPos(const StelCore*) const
 	return interpolatedPosition.get(now);
 }
 
-bool TelescopeClientDirectNexStar::prepareCommunication()
-{
-	//TODO: Nothing to prepare?
-	return true;
-}
-
-void TelescopeClientDirectNexStar::performCommunication()
-{
-	step(10000);
-}
-
 void TelescopeClientDirectNexStar::communicationResetReceived(void)
 {
 	queue_get_position = true;
@@ -197,12 +188,12 @@ void TelescopeClientDirectNexStar::step(long long int timeout_micros)
 
 bool TelescopeClientDirectNexStar::isConnected(void) const
 {
-	return (!nexstar->isClosed());//TODO
+	return (transport && transport->isConnected());
 }
 
 bool TelescopeClientDirectNexStar::isInitialized(void) const
 {
-	return (!nexstar->isClosed());
+	return (nexstar && !nexstar->isClosed());
 }
 
 //Merged from Connection::sendPosition() and TelescopeTCP::performReading()
@@ -214,11 +205,6 @@ void TelescopeClientDirectNexStar::sendPosition(unsigned int ra_int, int dec_int
 	const double dec = dec_int * (M_PI/(unsigned int)0x80000000);
 	const double cdec = cos(dec);
 	Vec3d position(cos(ra)*cdec, sin(ra)*cdec, sin(dec));
-	Vec3d j2000Position = position;
-	if (equinox == EquinoxJNow)
-	{
-		const StelCore* core = StelApp::getInstance().getCore();
-		j2000Position = core->equinoxEquToJ2000(position, StelCore::RefractionOff);
-	}
-	interpolatedPosition.add(j2000Position, getNow(), server_micros, status);
+	// called in the I/O thread, the client converts the position to J2000 when it takes it
+	static_cast<TelescopeServerTransport*>(transport)->reportPosition(position, server_micros, status);
 }
@@ -48,12 +48,17 @@ public:
 	TelescopeClientDirectNexStar(const QString &name, const QString &parameters, Equinox eq = EquinoxJ2000);
 	~TelescopeClientDirectNexStar(void)
 	{
-		//hangup();
+		// the transport steps this server in the I/O thread
+		stopCommunication();
 	}
 	
 	//======================================================================
 	// Methods inherited from TelescopeClient
 	bool isConnected(void) const;
+	void receivePositions()
+	{
+		takePositions(interpolatedPosition, equinox);
+	}
 	
 	//======================================================================
 	// Methods inherited from Server
@@ -66,8 +71,6 @@ private:
 	//======================================================================
 	// Methods inherited from TelescopeClient
 	Vec3d getJ2000EquatorialPos(const StelCore* core=Q_NULLPTR) const;
-	bool prepareCommunication();
-	void performCommunication();
 	void telescopeGoto(const Vec3d &j2000Pos, StelObjectP selectObject);
 	bool isInitialized(void) const;
 	
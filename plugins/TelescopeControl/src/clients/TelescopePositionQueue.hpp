@@ -0,0 +1,83 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TELESCOPE_POSITION_QUEUE_HPP_
+#define _TELESCOPE_POSITION_QUEUE_HPP_
+
+#include "InterpolatedPosition.hpp"
+
+#include <QAtomicInt>
+
+//! A lock-free queue which passes the positions received from a telescope from the I/O thread to the main thread.
+//! There must be only one thread which pushes positions, and only one thread which pops them.
+//! Drawing never waits for the communication this way, and the communication never waits for drawing.
+class TelescopePositionQueue
+{
+public:
+	//! The queue is emptied every frame, and telescopes send a few positions per second.
+	static const int CAPACITY = 64;
+
+	TelescopePositionQueue() : head(0), tail(0), dropped(0) {}
+
+	//! Append a position. Called by the producer thread.
+	//! @return false if the queue is full, and the position was dropped.
+	bool push(const Position& position)
+	{
+		const int t = tail.load();
+		const int next = (t + 1) % (CAPACITY + 1);
+		if (next == head.loadAcquire())
+		{
+			dropped.ref();
+			return false;
+		}
+		positions[t] = position;
+		tail.storeRelease(next);
+		return true;
+	}
+
+	//! Take the oldest position out of the queue. Called by the consumer thread.
+	//! @return false if the queue is empty.
+	bool pop(Position& position)
+	{
+		const int h = head.load();
+		if (h == tail.loadAcquire())
+			return false;
+		position = positions[h];
+		head.storeRelease((h + 1) % (CAPACITY + 1));
+		return true;
+	}
+
+	bool isEmpty() const { return head.loadAcquire() == tail.loadAcquire(); }
+	//! The number of positions dropped because the queue was full
+	int getDroppedCount() const { return dropped.load(); }
+
+private:
+	//! One slot stays free, to tell a full queue from an empty one
+	Position positions[CAPACITY + 1];
+	//! Next position to pop, only written by the consumer
+	QAtomicInt head;
+	//! Next free slot, only written by the producer
+	QAtomicInt tail;
+	QAtomicInt dropped;
+
+	TelescopePositionQueue(const TelescopePositionQueue&);
+	const TelescopePositionQueue& operator=(const TelescopePositionQueue&);
+};
+
+#endif // _TELESCOPE_POSITION_QUEUE_HPP_
@@ -0,0 +1,79 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "TelescopeServerTransport.hpp"
+
+#include "LogFile.hpp"
+#include "Server.hpp"
+
+#include <QTimer>
+
+const int TelescopeServerTransport::STEP_INTERVAL;
+
+TelescopeServerTransport::TelescopeServerTransport(Server& server, QTextStream* logStream)
+	: server(server)
+	, logStream(logStream)
+	, stepTimer(Q_NULLPTR)
+	, running(false)
+{
+	setConnected(server.hasConnections());
+}
+
+void TelescopeServerTransport::start()
+{
+	if (running)
+		return;
+	running = true;
+	stepTimer = new QTimer(this);
+	connect(stepTimer, SIGNAL(timeout()), this, SLOT(step()));
+	stepTimer->start(STEP_INTERVAL);
+}
+
+void TelescopeServerTransport::stop()
+{
+	if (!running)
+		return;
+	running = false;
+	stepTimer->stop();
+}
+
+void TelescopeServerTransport::sendGoto(unsigned int raInt, int decInt)
+{
+	if (!running || !isConnected())
+		return;
+	log_file = logStream;
+	server.gotoReceived(raInt, decInt);
+}
+
+void TelescopeServerTransport::step()
+{
+	if (!running)
+		return;
+	if (!server.hasConnections())
+	{
+		// the serial port has been closed, and there is nothing left to do
+		setConnected(false);
+		stepTimer->stop();
+		return;
+	}
+	// log_file is per thread, the servers of all slots share the I/O thread
+	log_file = logStream;
+	server.step(0);
+	setConnected(server.hasConnections());
+}
@@ -0,0 +1,63 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TELESCOPE_SERVER_TRANSPORT_HPP_
+#define _TELESCOPE_SERVER_TRANSPORT_HPP_
+
+#include "TelescopeTransport.hpp"
+
+class QTextStream;
+class QTimer;
+class Server;
+
+//! Runs the telescope server of a client which controls a telescope directly through a serial port
+//! (TelescopeClientDirectLx200, TelescopeClientDirectNexStar) in the I/O thread.
+//! The servers multiplex their serial port with select(), which used to wait up to 10 ms per frame in the main thread.
+//! Here the server is stepped with a zero timeout every STEP_INTERVAL ms, and the client reports the positions
+//! it decodes with reportPosition().
+class TelescopeServerTransport : public TelescopeTransport
+{
+	Q_OBJECT
+public:
+	//! @param server the client, which must call destroy() before it is destroyed
+	//! @param logStream the log of the telescope slot, used as log_file in the I/O thread
+	TelescopeServerTransport(Server& server, QTextStream* logStream);
+
+	//! Interval of the polls of the serial port
+	static const int STEP_INTERVAL = 5;
+
+	//! Queue a position decoded by the server. Called in the I/O thread.
+	void reportPosition(const Vec3d& position, qint64 serverMicros, int status) { addPosition(position, serverMicros, status); }
+
+public slots:
+	void start() Q_DECL_OVERRIDE;
+	void stop() Q_DECL_OVERRIDE;
+	void sendGoto(unsigned int raInt, int decInt) Q_DECL_OVERRIDE;
+
+private slots:
+	void step();
+
+private:
+	Server& server;
+	QTextStream* logStream;
+	QTimer* stepTimer;
+	bool running;
+};
+
+#endif // _TELESCOPE_SERVER_TRANSPORT_HPP_
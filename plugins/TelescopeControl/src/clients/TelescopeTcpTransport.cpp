@@ -0,0 +1,244 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "TelescopeTcpTransport.hpp"
+
+#include <cmath>
+
+#include <QDebug>
+#include <QTcpSocket>
+#include <QTimer>
+
+const int TelescopeTcpTransport::RECONNECT_INTERVAL;
+
+//! Largest packet of the protocol
+static const int MAX_PACKET_SIZE = 120;
+
+TelescopeTcpTransport::TelescopeTcpTransport(const QString& name, const QHostAddress& address, quint16 port)
+	: name(name)
+	, address(address)
+	, port(port)
+	, tcpSocket(Q_NULLPTR)
+	, reconnectTimer(Q_NULLPTR)
+	, running(false)
+{
+}
+
+void TelescopeTcpTransport::start()
+{
+	if (running)
+		return;
+	running = true;
+
+	// created here, so that they belong to the I/O thread
+	tcpSocket = new QTcpSocket(this);
+	connect(tcpSocket, SIGNAL(connected()), this, SLOT(socketConnected()));
+	connect(tcpSocket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
+	connect(tcpSocket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketFailed(QAbstractSocket::SocketError)));
+	connect(tcpSocket, SIGNAL(readyRead()), this, SLOT(readData()));
+
+	reconnectTimer = new QTimer(this);
+	reconnectTimer->setSingleShot(true);
+	connect(reconnectTimer, SIGNAL(timeout()), this, SLOT(connectToServer()));
+
+	connectToServer();
+}
+
+void TelescopeTcpTransport::stop()
+{
+	if (!running)
+		return;
+	running = false;
+	reconnectTimer->stop();
+	tcpSocket->disconnect(this);
+	tcpSocket->abort();
+	setConnected(false);
+}
+
+void TelescopeTcpTransport::connectToServer()
+{
+	if (!running)
+		return;
+
+	if (tcpSocket->state() != QAbstractSocket::UnconnectedState)
+	{
+		// still not connected after RECONNECT_INTERVAL
+		qDebug() << "TelescopeTCP(" << name << ")::connectToServer: Connection attempt timed out";
+		hangup();
+		return;
+	}
+
+	qDebug() << "TelescopeTCP(" << name << ")::connectToServer: Attempting to connect to host" << address.toString() << "at port" << port;
+	reconnectTimer->start(RECONNECT_INTERVAL);
+	tcpSocket->connectToHost(address, port);
+}
+
+void TelescopeTcpTransport::socketConnected()
+{
+	reconnectTimer->stop();
+	qDebug() << "TelescopeTCP(" << name << "): Connection established, turning off Nagle algorithm.";
+	tcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	readBuffer.clear();
+	setConnected(true);
+}
+
+void TelescopeTcpTransport::socketDisconnected()
+{
+	if (!isConnected())
+		return;
+	qDebug() << "TelescopeTCP(" << name << "): server has closed the connection";
+	hangup();
+}
+
+//TODO: More informative error messages?
+void TelescopeTcpTransport::socketFailed(QAbstractSocket::SocketError)
+{
+	qDebug() << "TelescopeTCP(" << name << "): TCP socket error:\n" << tcpSocket->errorString();
+	hangup();
+}
+
+void TelescopeTcpTransport::hangup()
+{
+	setConnected(false);
+	readBuffer.clear();
+	if (tcpSocket->state() != QAbstractSocket::UnconnectedState)
+		tcpSocket->abort();
+	if (running)
+		reconnectTimer->start(RECONNECT_INTERVAL);
+}
+
+//! sends a GOTO command with the specified position.
+//! For the data format of the command see the
+//! "Stellarium telescope control protocol" text file
+void TelescopeTcpTransport::sendGoto(unsigned int raInt, int decInt)
+{
+	if (!running || !isConnected())
+		return;
+
+	if (tcpSocket->bytesToWrite() + 20 > MAX_PACKET_SIZE)
+	{
+		qDebug() << "TelescopeTCP(" << name << ")::telescopeGoto: "<< "communication is too slow, I will ignore this command";
+		return;
+	}
+
+	char packet[20];
+	char* p = packet;
+	// length of packet:
+	*p++ = 20;
+	*p++ = 0;
+	// type of packet:
+	*p++ = 0;
+	*p++ = 0;
+	// client_micros:
+	qint64 now = getNow();
+	for (int i=0; i<8; ++i, now>>=8)
+		*p++ = now;
+	// ra:
+	for (int i=0; i<4; ++i, raInt>>=8)
+		*p++ = raInt;
+	// dec:
+	for (int i=0; i<4; ++i, decInt>>=8)
+		*p++ = decInt;
+
+	if (tcpSocket->write(packet, sizeof(packet)) < 0)
+	{
+		//TODO: Better error message. See the Qt documentation.
+		qDebug() << "TelescopeTCP(" << name << ")::sendGoto: " << "write failed: " << tcpSocket->errorString();
+		hangup();
+	}
+}
+
+//! decodes the packets received from the telescope server
+void TelescopeTcpTransport::readData()
+{
+	if (!isConnected())
+		return;
+
+	readBuffer += tcpSocket->readAll();
+	const char* p = readBuffer.constData();
+	const char* const end = p + readBuffer.size();
+	while (end - p >= 2)
+	{
+		const int size = (int)(((unsigned char)(p[0])) | (((unsigned int)(unsigned char)(p[1])) << 8));
+		if (size > MAX_PACKET_SIZE || size < 4)
+		{
+			qDebug() << "TelescopeTCP(" << name << ")::readData: " << "bad packet size: " << size;
+			hangup();
+			return;
+		}
+		if (size > end - p)
+		{
+			// wait for complete packet
+			break;
+		}
+		const int type = (int)(((unsigned char)(p[2])) | (((unsigned int)(unsigned char)(p[3])) << 8));
+		// dispatch:
+		switch (type)
+		{
+			case 0:
+			{
+			// We have received position information.
+			// For the data format of the message see the
+			// "Stellarium telescope control protocol"
+				if (size < 24)
+				{
+					qDebug() << "TelescopeTCP(" << name << ")::readData: " << "type 0: bad packet size: " << size;
+					hangup();
+					return;
+				}
+				const qint64 server_micros = (qint64)
+					(((quint64)(unsigned char)(p[ 4])) |
+					(((quint64)(unsigned char)(p[ 5])) <<  8) |
+					(((quint64)(unsigned char)(p[ 6])) << 16) |
+					(((quint64)(unsigned char)(p[ 7])) << 24) |
+					(((quint64)(unsigned char)(p[ 8])) << 32) |
+					(((quint64)(unsigned char)(p[ 9])) << 40) |
+					(((quint64)(unsigned char)(p[10])) << 48) |
+					(((quint64)(unsigned char)(p[11])) << 56));
+				const unsigned int ra_int =
+					((unsigned int)(unsigned char)(p[12])) |
+					(((unsigned int)(unsigned char)(p[13])) <<  8) |
+					(((unsigned int)(unsigned char)(p[14])) << 16) |
+					(((unsigned int)(unsigned char)(p[15])) << 24);
+				const int dec_int =
+					(int)(((unsigned int)(unsigned char)(p[16])) |
+					     (((unsigned int)(unsigned char)(p[17])) <<  8) |
+					     (((unsigned int)(unsigned char)(p[18])) << 16) |
+					     (((unsigned int)(unsigned char)(p[19])) << 24));
+				const int status =
+					(int)(((unsigned int)(unsigned char)(p[20])) |
+					     (((unsigned int)(unsigned char)(p[21])) <<  8) |
+					     (((unsigned int)(unsigned char)(p[22])) << 16) |
+					     (((unsigned int)(unsigned char)(p[23])) << 24));
+
+				const double ra  =  ra_int * (M_PI/(unsigned int)0x80000000);
+				const double dec = dec_int * (M_PI/(unsigned int)0x80000000);
+				const double cdec = cos(dec);
+				addPosition(Vec3d(cos(ra)*cdec, sin(ra)*cdec, sin(dec)), server_micros, status);
+			}
+			break;
+			default:
+				qDebug() << "TelescopeTCP(" << name << ")::readData: " << "ignoring unknown packet, type: " << type;
+			break;
+		}
+		p += size;
+	}
+	// keep the incomplete packet
+	readBuffer.remove(0, p - readBuffer.constData());
+}
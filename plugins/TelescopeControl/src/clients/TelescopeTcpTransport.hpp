@@ -0,0 +1,71 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TELESCOPE_TCP_TRANSPORT_HPP_
+#define _TELESCOPE_TCP_TRANSPORT_HPP_
+
+#include "TelescopeTransport.hpp"
+
+#include <QAbstractSocket>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+
+class QTcpSocket;
+class QTimer;
+
+//! Talks the "Stellarium telescope control protocol" with a telescope server over TCP/IP.
+//! The socket is driven by its signals in the I/O thread: positions are decoded as soon as they arrive,
+//! and a lost connection is attempted again every few seconds.
+class TelescopeTcpTransport : public TelescopeTransport
+{
+	Q_OBJECT
+public:
+	//! @param name the name of the telescope, for the log
+	TelescopeTcpTransport(const QString& name, const QHostAddress& address, quint16 port);
+
+	//! Time to wait for a connection, and between connection attempts
+	static const int RECONNECT_INTERVAL = 5000;
+
+public slots:
+	void start() Q_DECL_OVERRIDE;
+	void stop() Q_DECL_OVERRIDE;
+	void sendGoto(unsigned int raInt, int decInt) Q_DECL_OVERRIDE;
+
+private slots:
+	void connectToServer();
+	void socketConnected();
+	void socketDisconnected();
+	void socketFailed(QAbstractSocket::SocketError socketError);
+	void readData();
+
+private:
+	//! Close the connection, and try again after RECONNECT_INTERVAL
+	void hangup();
+
+	QString name;
+	QHostAddress address;
+	quint16 port;
+	QTcpSocket* tcpSocket;
+	QTimer* reconnectTimer;
+	QByteArray readBuffer;
+	bool running;
+};
+
+#endif // _TELESCOPE_TCP_TRANSPORT_HPP_
@@ -0,0 +1,93 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "TelescopeTransport.hpp"
+
+#include <QDebug>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+	#include <windows.h> // GetSystemTimeAsFileTime()
+#else
+	#include <sys/time.h>
+#endif
+
+//! returns the current system time in microseconds since the Epoch
+//! Prior to revision 6308, it was necessary to put put this method in an
+//! #ifdef block, as duplicate function definition caused errors during static
+//! linking.
+qint64 getNow(void)
+{
+// At the moment this can't be done in a platform-independent way with Qt
+// (QDateTime and QTime don't support microsecond precision)
+	qint64 t;
+#ifdef Q_OS_WIN
+	FILETIME file_time;
+	GetSystemTimeAsFileTime(&file_time);
+	t = (*((__int64*)(&file_time))/10) - 86400000000LL*134774;
+#else
+	struct timeval tv;
+	gettimeofday(&tv,0);
+	t = tv.tv_sec * 1000000LL + tv.tv_usec;
+#endif
+	// GZ JDfix for 0.14 I am 99.9% sure we no longer need the anti-correction
+	//return t - core->getDeltaT(StelUtils::getJDFromSystem())*1000000; // Delta T anti-correction
+	return t;
+}
+
+TelescopeTransport::TelescopeTransport()
+	: connected(0)
+	, disconnections(0)
+{
+}
+
+void TelescopeTransport::startInThread(QThread* thread)
+{
+	if (thread)
+		moveToThread(thread);
+	QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+}
+
+void TelescopeTransport::destroy()
+{
+	if (thread() == QThread::currentThread())
+		stop();
+	else if (thread()->isRunning())
+		QMetaObject::invokeMethod(this, "stop", Qt::BlockingQueuedConnection);
+	// If the thread has already finished, nothing runs the transport any more, and it is left to the end of the program.
+	deleteLater();
+}
+
+void TelescopeTransport::setConnected(bool b)
+{
+	const int was = connected.fetchAndStoreOrdered(b ? 1 : 0);
+	if (was && !b)
+		disconnections.ref();
+}
+
+void TelescopeTransport::addPosition(const Vec3d& position, qint64 serverMicros, int status)
+{
+	Position p;
+	p.server_micros = serverMicros;
+	p.client_micros = getNow();
+	p.pos = position;
+	p.status = status;
+	if (!positions.push(p) && positions.getDroppedCount() == 1)
+		qDebug() << "TelescopeTransport: the main thread doesn't take the positions, dropping them";
+}
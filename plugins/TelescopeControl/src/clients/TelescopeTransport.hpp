@@ -0,0 +1,76 @@
+/*
+ * Stellarium Telescope Control Plug-in
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _TELESCOPE_TRANSPORT_HPP_
+#define _TELESCOPE_TRANSPORT_HPP_
+
+#include "TelescopePositionQueue.hpp"
+
+#include <QAtomicInt>
+#include <QObject>
+
+//! Returns the current system time in microseconds since the Epoch
+qint64 getNow(void);
+
+//! Communicates with a telescope in the I/O thread of TelescopeControl.
+//! A transport is created by its TelescopeClient in the main thread, moved to the I/O thread and started there.
+//! The positions it receives are passed to the main thread through a TelescopePositionQueue, and commands
+//! are passed to it with queued calls of its slots, so the main thread never waits for a socket or a serial port.
+//! The positions are in the equinox of the telescope, the client converts them when it takes them.
+class TelescopeTransport : public QObject
+{
+	Q_OBJECT
+public:
+	TelescopeTransport();
+	virtual ~TelescopeTransport() {}
+
+	//! The positions received from the telescope. Only the main thread may pop them.
+	TelescopePositionQueue& getPositions() { return positions; }
+	//! Can be called from any thread.
+	bool isConnected() const { return connected.load() != 0; }
+	//! The number of lost connections. When it changes, the positions received before are outdated.
+	//! Can be called from any thread.
+	int getDisconnectionCount() const { return disconnections.load(); }
+
+	//! Move the transport to @param thread and start it there.
+	void startInThread(class QThread* thread);
+	//! Stop the transport and delete it. If it runs in another thread, this waits until it has stopped,
+	//! so the transport doesn't use its client any more when this returns.
+	void destroy();
+
+public slots:
+	//! Start communicating. Called in the thread of the transport.
+	virtual void start() = 0;
+	//! Stop communicating. Commands received afterwards are ignored.
+	virtual void stop() = 0;
+	//! Move the telescope to the given position in its equinox, in the units of the "Stellarium telescope control protocol".
+	virtual void sendGoto(unsigned int raInt, int decInt) = 0;
+
+protected:
+	void setConnected(bool b);
+	//! Queue a position received now from the telescope
+	void addPosition(const Vec3d& position, qint64 serverMicros, int status);
+
+private:
+	TelescopePositionQueue positions;
+	QAtomicInt connected;
+	QAtomicInt disconnections;
+};
+
+#endif // _TELESCOPE_TRANSPORT_HPP_
@@ -38,6 +38,7 @@ public:
 
 QTextStream &operator<<(QTextStream &o, const Now &now);
 
-extern QTextStream *log_file;
+//! The log of the telescope slot whose server is running in the current thread
+extern thread_local QTextStream *log_file;
 
 #endif
@@ -49,6 +49,8 @@ public:
 	Server(int port);
 	virtual ~Server(void) {}
 	virtual void step(long long int timeout_micros);
+	//! Returns false when all the connections have been closed
+	bool hasConnections(void) const {return !socket_list.empty();}
 	
 protected:
 	void sendPosition(unsigned int ra_int, int dec_int, int status);
@@ -69,6 +71,7 @@ private:
 	  // called by Connection:
 	virtual void gotoReceived(unsigned int ra_int, int dec_int) = 0;
 	friend class Connection;
+	friend class TelescopeServerTransport;
 	
 	class SocketList : public list<Socket*>
 	{
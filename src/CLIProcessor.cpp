@@ -29,6 +29,7 @@
 #include <QGuiApplication>
 #include <QStandardPaths>
 #include <QDir>
+#include <QSize>
 
 #include <stdio.h>
 
@@ -79,6 +80,17 @@ void CLIProcessor::parseCLIArgsPreConfig(const QStringList& argList)
 			#endif
 			#endif
 			  << "--screenshot-dir        : Specify directory to save screenshots\n"
+			  << "--headless              : Batch rendering without user interaction: no splash screen\n"
+			  << "                          or message boxes, fixed frame steps, quits when the startup\n"
+			  << "                          script has finished. OpenGL still needs a display, on\n"
+			  << "                          machines without one use a virtual X server, e.g.\n"
+			  << "                          xvfb-run -s \"-screen 0 1920x1080x24\" stellarium --headless\n"
+			  << "--frame-step            : Advance the simulation by this many seconds per frame\n"
+			  << "                          and render as fast as possible (default 1/30 with\n"
+			  << "                          --headless, 0 follows the system clock)\n"
+			  << "--frame-size            : Size of the window with --headless, e.g. 1920x1080\n"
+			  << "--frame-sequence        : Save every frame into the screenshot directory, with\n"
+			  << "                          the file name prefix passed as parameter to option\n"
 			  << "--startup-script        : Specify name of startup script\n"
 			  << "--home-planet           : Specify observer planet (English name)\n"
 			  << "--altitude              : Specify observer altitude in meters\n"
@@ -109,6 +121,10 @@ void CLIProcessor::parseCLIArgsPreConfig(const QStringList& argList)
 	{
 		qApp->setProperty("text_texture", true); // Will be observed in StelPainter::drawText()
 	}
+	if (argsGetOption(argList, "", "--headless"))
+	{
+		qApp->setProperty("onetime_headless", true); // main() has already checked for a display
+	}
 	#ifdef Q_OS_WIN
 	if (argsGetOption(argList, "-s", "--safe-mode"))
 	{
@@ -173,6 +189,8 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 	float fov;
 	QString landscapeId, homePlanet, longitude, latitude, skyDate, skyTime;
 	QString projectionType, screenshotDir, multiresImage, startupScript;
+	QString frameSize, frameSequence;
+	double frameStep;
 #ifdef ENABLE_SPOUT
 	QString spoutStr, spoutName;
 #endif
@@ -193,6 +211,9 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 		screenshotDir = argsGetOptionWithArg(argList, "", "--screenshot-dir", "").toString();
 		multiresImage = argsGetOptionWithArg(argList, "", "--multires-image", "").toString();
 		startupScript = argsGetOptionWithArg(argList, "", "--startup-script", "").toString();
+		frameStep = argsGetOptionWithArg(argList, "", "--frame-step", -1.).toDouble();
+		frameSize = argsGetOptionWithArg(argList, "", "--frame-size", "").toString();
+		frameSequence = argsGetOptionWithArg(argList, "", "--frame-sequence", "").toString();
 #ifdef ENABLE_SPOUT
 		// For now, we default to spout=sky when no extra option is given. Later, we should also accept "all".
 		// Unfortunately, this still throws an exception when no optarg string is given.
@@ -266,6 +287,20 @@ void CLIProcessor::parseCLIArgsPostConfig(const QStringList& argList, QSettings*
 		qApp->setProperty("onetime_startup_script", startupScript);
 	}
 
+	// Batch rendering options are only valid for this run, so they are not stored in the config file
+	if (frameStep>=0.)
+		qApp->setProperty("onetime_frame_step", frameStep);
+	if (!frameSize.isEmpty())
+	{
+		QRegExp sizeRx("(\\d+)x(\\d+)");
+		if (sizeRx.exactMatch(frameSize) && sizeRx.cap(1).toInt()>0 && sizeRx.cap(2).toInt()>0)
+			qApp->setProperty("onetime_frame_size", QSize(sizeRx.cap(1).toInt(), sizeRx.cap(2).toInt()));
+		else
+			qWarning() << "WARNING: --frame-size argument has unrecognised format (I want WIDTHxHEIGHT)";
+	}
+	if (!frameSequence.isEmpty())
+		qApp->setProperty("onetime_frame_sequence", frameSequence);
+
 	if (fov>0.0) confSettings->setValue("navigation/init_fov", fov);
 	if (!projectionType.isEmpty()) confSettings->setValue("projection/type", projectionType);
 	if (!screenshotDir.isEmpty())
@@ -45,6 +45,7 @@
 #include <QGraphicsAnchorLayout>
 #include <QGraphicsWidget>
 #include <QGraphicsEffect>
+#include <QFile>
 #include <QFileInfo>
 #include <QIcon>
 #include <QMoveEvent>
@@ -65,6 +66,9 @@
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFramebufferObject>
 #include <QOpenGLPaintDevice>
+#include <QOpenGLBuffer>
+#include <QThreadPool>
+#include <QtConcurrent>
 #ifdef OPENGL_DEBUG_LOGGING
 #include <QOpenGLDebugLogger>
 #endif
@@ -343,7 +347,7 @@ protected:
 		Q_ASSERT(mainView->glContext() == QOpenGLContext::currentContext());
 
 		const double now = StelApp::getTotalRunTime();
-		double dt = now - previousPaintTime;
+		double dt = mainView->advanceFrameTime(now - previousPaintTime);
 		//qDebug()<<"dt"<<dt;
 		previousPaintTime = now;
 
@@ -553,8 +557,25 @@ StelMainView::StelMainView(QSettings* settings)
 	  flagOverwriteScreenshots(false),
 	  screenShotPrefix("stellarium-"),
 	  screenShotDir(""),
+	  screenShotFormat("png"),
+	  screenShotFbo(Q_NULLPTR),
+	  screenShotPboIndex(0),
+	  screenShotReadbackPending(false),
+	  screenShotPendingInvert(false),
+	  screenShotRendering(false),
+	  flagHeadless(qApp->property("onetime_headless").toBool()),
+	  frameStep(0.),
+	  simulatedTime(0.),
+	  frameSequenceShotPending(false),
 	  cursorTimeout(-1.f), flagCursorTimeout(false), maxfps(10000.f)
 {
+	screenShotPbo[0] = screenShotPbo[1] = Q_NULLPTR;
+	// Encoding a full-size PNG takes longer than rendering a frame, so use several threads when writing frame sequences.
+	screenShotThreadPool = new QThreadPool(this);
+	screenShotThreadPool->setMaxThreadCount(qMax(1, QThread::idealThreadCount()-1));
+	// one job waiting for each thread
+	screenShotSlots.release(2*screenShotThreadPool->maxThreadCount());
+
 	setAttribute(Qt::WA_OpaquePaintEvent);
 	setAttribute(Qt::WA_AcceptTouchEvents);
 	setAttribute(Qt::WA_TouchPadAcceptSingleTouchEvents);
@@ -600,7 +621,8 @@ StelMainView::StelMainView(QSettings* settings)
 	// Qt: https://bugreports.qt.io/browse/QTBUG-53273
 	vsdef = false; // use vsync=false by default on macOS
 	#endif
-	if (configuration->value("video/vsync", vsdef).toBool())
+	// Offscreen batch rendering must never wait for a display refresh
+	if (!flagHeadless && configuration->value("video/vsync", vsdef).toBool())
 		glFormat.setSwapInterval(1);
 	else
 		glFormat.setSwapInterval(0);
@@ -745,8 +767,8 @@ void StelMainView::init()
 
 	QSettings* conf = configuration;
 
-	// Should be check of requirements disabled?
-	if (conf->value("main/check_requirements", true).toBool())
+	// Should be check of requirements disabled? Nobody could answer its message boxes in headless mode.
+	if (!flagHeadless && conf->value("main/check_requirements", true).toBool())
 	{
 		// Find out lots of debug info about supported version of OpenGL and vendor/renderer.
 		processOpenGLdiagnosticsAndWarnings(conf, QOpenGLContext::currentContext());
@@ -763,6 +785,20 @@ void StelMainView::init()
 	//also immediately set the current values
 	stelApp->glWindowHasBeenResized(stelScene->sceneRect());
 
+	// Batch rendering advances the simulation by a fixed step per frame instead of by the wall clock,
+	// so the rendered frames do not depend on how fast the renderer is.
+	if (qApp->property("onetime_frame_step").isValid())
+		frameStep = qMax(0., qApp->property("onetime_frame_step").toDouble());
+	else if (flagHeadless)
+		frameStep = 1./30.;
+	stelApp->getCore()->setFlagFixedTimeStep(frameStep>0.);
+	frameSequencePrefix = qApp->property("onetime_frame_sequence").toString();
+#ifndef USE_OLD_QGLWIDGET
+	// The frame is complete when the widget is composed into the window, including the GUI drawn over the sky
+	if (!frameSequencePrefix.isEmpty())
+		connect(glWidget, SIGNAL(aboutToCompose()), this, SLOT(grabFrameSequenceShot()));
+#endif
+
 	StelActionMgr *actionMgr = stelApp->getStelActionManager();
 	actionMgr->addAction("actionSave_Screenshot_Global", N_("Miscellaneous"), N_("Save screenshot"), this, "saveScreenShot()", "Ctrl+S");
 	actionMgr->addAction("actionReload_Shaders", N_("Miscellaneous"), N_("Reload shaders (for development)"), this, "reloadShaders()", "Ctrl+R, P");
@@ -792,6 +828,13 @@ void StelMainView::init()
 		     conf->value("video/screen_h", screenGeom.height()).toInt());
 
 	bool fullscreen = conf->value("video/fullscreen", true).toBool();
+	if (flagHeadless)
+	{
+		// An offscreen surface has no screen to fill
+		if (qApp->property("onetime_frame_size").isValid())
+			size = qApp->property("onetime_frame_size").toSize();
+		fullscreen = false;
+	}
 
 	// Without this, the screen is not shown on a Mac + we should use resize() for correct work of fullscreen/windowed mode switch. --AW WTF???
 	resize(size);
@@ -815,6 +858,7 @@ void StelMainView::init()
 	}
 
 	flagInvertScreenShotColors = conf->value("main/invert_screenshots_colors", false).toBool();
+	setScreenShotFormat(conf->value("main/screenshot_format", "png").toString());
 	setFlagCursorTimeout(conf->value("gui/flag_mouse_cursor_timeout", false).toBool());
 	setCursorTimeout(conf->value("gui/mouse_cursor_timeout", 10.f).toFloat());
 	setMaxFps(conf->value("video/maximum_fps",10000.f).toFloat());
@@ -1219,6 +1263,14 @@ void StelMainView::dumpOpenGLdiagnostics() const
 void StelMainView::deinit()
 {
 	glContextMakeCurrent();
+	waitForScreenShots();
+	delete screenShotFbo;
+	screenShotFbo = Q_NULLPTR;
+	for (int i=0; i<2; ++i)
+	{
+		delete screenShotPbo[i];
+		screenShotPbo[i] = Q_NULLPTR;
+	}
 	deinitGL();
 	delete stelApp;
 	stelApp = Q_NULLPTR;
@@ -1261,8 +1313,26 @@ void StelMainView::setFullScreen(bool b)
 
 void StelMainView::drawEnded()
 {
+	// Re-rendering the scene for a screenshot is not a new frame
+	if (screenShotRendering)
+		return;
+
 	updateQueued = false;
 
+	// A screenshot readback issued before this frame has had a whole frame to complete, so it can be mapped without stalling.
+	if (screenShotReadbackPending)
+		finishScreenShotReadback();
+
+	if (!frameSequencePrefix.isEmpty())
+	{
+#ifdef USE_OLD_QGLWIDGET
+		// Queued before the next draw, so that exactly this frame is saved
+		QMetaObject::invokeMethod(this, "saveFrameSequenceShot", Qt::QueuedConnection);
+#else
+		frameSequenceShotPending = true;
+#endif
+	}
+
 	//requeue the next draw
 	if(needsMaxFPS())
 	{
@@ -1311,6 +1381,10 @@ void StelMainView::thereWasAnEvent()
 
 bool StelMainView::needsMaxFPS() const
 {
+	// Batch rendering runs as fast as the renderer allows
+	if (flagHeadless || frameStep>0.)
+		return true;
+
 	const double now = StelApp::getTotalRunTime();
 
 	// Determines when the next display will need to be triggered
@@ -1321,6 +1395,15 @@ bool StelMainView::needsMaxFPS() const
 	return (now - lastEventTimeSec < 2.5) || fabs(timeRate) > StelCore::JD_SECOND;
 }
 
+double StelMainView::advanceFrameTime(double wallClockDt)
+{
+	double dt = wallClockDt;
+	if (frameStep>0.)
+		dt = screenShotRendering ? 0. : frameStep;
+	simulatedTime += dt;
+	return dt;
+}
+
 void StelMainView::moveEvent(QMoveEvent * event)
 {
 	Q_UNUSED(event);
@@ -1358,30 +1441,107 @@ void StelMainView::saveScreenShot(const QString& filePrefix, const QString& save
 	emit(screenshotRequested());
 }
 
-void StelMainView::doScreenshot(void)
+void StelMainView::setScreenShotFormat(const QString& format)
 {
-	QFileInfo shotDir;
-#ifdef USE_OLD_QGLWIDGET
-	QImage im = glWidget->grabFrameBuffer();
-#else
-	glWidget->makeCurrent();
-	QOpenGLFramebufferObjectFormat fbFormat;
-	fbFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
-	QOpenGLFramebufferObject * fbObj = new QOpenGLFramebufferObject(stelScene->width(), stelScene->height(), fbFormat);
-	fbObj->bind();
-	QOpenGLPaintDevice fbObjPaintDev(stelScene->width(), stelScene->height());
-	QPainter painter(&fbObjPaintDev);
-	painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
-	stelScene->render(&painter);
-	painter.end();
-	QImage im = fbObj->toImage();
-	fbObj->release();
-	delete fbObj;
+	screenShotFormat = format.toLower();
+	if (screenShotFormat=="jpeg")
+		screenShotFormat = "jpg";
+}
+
+namespace
+{
+	struct ScreenShotJob
+	{
+		QImage image;
+		QByteArray pixels;
+		QSize size;
+		QString path;
+		QString format;
+		bool invert;
+		//! Released when the job is done
+		QSemaphore* freeSlots;
+	};
+
+	// Runs in StelMainView's screenshot thread pool
+	void writeScreenShot(ScreenShotJob job)
+	{
+		QImage im = job.image;
+		if (im.isNull())
+		{
+			// OpenGL delivers the rows bottom-up
+			im = QImage(reinterpret_cast<const uchar*>(job.pixels.constData()), job.size.width(), job.size.height(),
+				    QImage::Format_RGBA8888_Premultiplied).mirrored();
+		}
+		if (job.invert)
+			im.invertPixels();
+
+		bool ok;
+		if (job.format=="raw")
+		{
+			im = im.convertToFormat(QImage::Format_RGBA8888);
+			QFile file(job.path);
+			ok = file.open(QIODevice::WriteOnly);
+			for (int y=0; ok && y<im.height(); ++y)
+				ok = file.write(reinterpret_cast<const char*>(im.constScanLine(y)), im.width()*4) == im.width()*4;
+		}
+		else
+			ok = im.save(job.path, job.format.toLatin1().constData());
+
+		if (!ok)
+			qWarning() << "WARNING failed to write screenshot to: " << QDir::toNativeSeparators(job.path);
+		job.freeSlots->release();
+	}
+}
+
+void StelMainView::queueScreenShotWrite(const QImage& image, const QByteArray& pixels, const QSize& size, const QString& path, bool invert)
+{
+	ScreenShotJob job;
+	job.image = image;
+	job.pixels = pixels;
+	job.size = size;
+	job.path = path;
+	job.format = screenShotFormat;
+	job.invert = invert;
+
+	// Do not let unwritten frames pile up in memory when encoding is slower than rendering:
+	// wait until one of the queued jobs is done.
+	screenShotSlots.acquire();
+	job.freeSlots = &screenShotSlots;
+	QtConcurrent::run(screenShotThreadPool, writeScreenShot, job);
+}
+
+void StelMainView::waitForScreenShots()
+{
+#ifndef USE_OLD_QGLWIDGET
+	if (screenShotReadbackPending)
+	{
+		glWidget->makeCurrent();
+		finishScreenShotReadback();
+	}
 #endif
+	screenShotThreadPool->waitForDone();
+}
 
-	if (flagInvertScreenShotColors)
-		im.invertPixels();
+void StelMainView::finishScreenShotReadback()
+{
+	QOpenGLBuffer* pbo = screenShotPbo[screenShotPboIndex];
+	screenShotReadbackPending = false;
+	pbo->bind();
+	const uchar* data = static_cast<const uchar*>(pbo->map(QOpenGLBuffer::ReadOnly));
+	if (data)
+	{
+		const QByteArray pixels(reinterpret_cast<const char*>(data), screenShotPendingSize.width()*screenShotPendingSize.height()*4);
+		pbo->unmap();
+		queueScreenShotWrite(QImage(), pixels, screenShotPendingSize, screenShotPendingPath, screenShotPendingInvert);
+	}
+	else
+		qWarning() << "WARNING could not map screenshot buffer, screenshot lost: " << QDir::toNativeSeparators(screenShotPendingPath);
+	pbo->release();
+}
 
+QString StelMainView::getNextScreenShotPath()
+{
+	QFileInfo shotDir;
 	if (StelFileMgr::getScreenshotDir().isEmpty())
 	{
 		qWarning() << "Oops, the directory for screenshots is not set! Let's try create and set it...";
@@ -1412,33 +1572,137 @@ void StelMainView::doScreenshot(void)
 	if (!shotDir.isDir())
 	{
 		qWarning() << "ERROR requested screenshot directory is not a directory: " << QDir::toNativeSeparators(shotDir.filePath());
-		return;
+		return QString();
 	}
 	else if (!shotDir.isWritable())
 	{
 		qWarning() << "ERROR requested screenshot directory is not writable: " << QDir::toNativeSeparators(shotDir.filePath());
-		return;
+		return QString();
 	}
 
+	const QString extension = "." + screenShotFormat;
 	QFileInfo shotPath;
 	if (flagOverwriteScreenshots)
 	{
-		shotPath = QFileInfo(shotDir.filePath() + "/" + screenShotPrefix + ".png");
+		shotPath = QFileInfo(shotDir.filePath() + "/" + screenShotPrefix + extension);
 	}
 	else
 	{
-		for (int j=0; j<100000; ++j)
+		// Continue after the last number used for this prefix: files of earlier shots may still be written by the encoder threads.
+		const QString counterKey = shotDir.filePath() + "/" + screenShotPrefix + extension;
+		int j = screenShotCounters.value(counterKey, 0);
+		for (; j<100000; ++j)
 		{
-			shotPath = QFileInfo(shotDir.filePath() + "/" + screenShotPrefix + QString("%1").arg(j, 3, 10, QLatin1Char('0')) + ".png");
+			shotPath = QFileInfo(shotDir.filePath() + "/" + screenShotPrefix + QString("%1").arg(j, 3, 10, QLatin1Char('0')) + extension);
 			if (!shotPath.exists())
 				break;
 		}
+		screenShotCounters.insert(counterKey, j+1);
+	}
+	return shotPath.filePath();
+}
+
+void StelMainView::doScreenshot(void)
+{
+	const QString shotPath = getNextScreenShotPath();
+	if (shotPath.isEmpty())
+		return;
+	qDebug() << "INFO Saving screenshot in file: " << QDir::toNativeSeparators(shotPath);
+
+#ifdef USE_OLD_QGLWIDGET
+	queueScreenShotWrite(glWidget->grabFrameBuffer(), QByteArray(), QSize(), shotPath, flagInvertScreenShotColors);
+#else
+	glWidget->makeCurrent();
+	const QSize size(stelScene->width(), stelScene->height());
+	if (!screenShotFbo || screenShotFbo->size()!=size)
+	{
+		delete screenShotFbo;
+		QOpenGLFramebufferObjectFormat fbFormat;
+		fbFormat.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+		screenShotFbo = new QOpenGLFramebufferObject(size, fbFormat);
+	}
+	screenShotFbo->bind();
+	QOpenGLPaintDevice fbObjPaintDev(size);
+	QPainter painter(&fbObjPaintDev);
+	painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+	screenShotRendering = true;
+	stelScene->render(&painter);
+	screenShotRendering = false;
+	painter.end();
+	screenShotFbo->bind();
+	readScreenShotPixels(size, shotPath);
+	screenShotFbo->release();
+#endif
+}
+
+#ifndef USE_OLD_QGLWIDGET
+void StelMainView::readScreenShotPixels(const QSize& size, const QString& shotPath)
+{
+	QOpenGLContext* ctx = glWidget->context();
+	QOpenGLFunctions* gl = ctx->functions();
+	gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	// Pixel pack buffers let glReadPixels return immediately, the pixels are mapped after the next frame (or the next screenshot).
+	const bool asyncReadback = !ctx->isOpenGLES() && ctx->format().version() >= qMakePair(2,1);
+	if (asyncReadback)
+	{
+		const int nextIndex = screenShotReadbackPending ? 1-screenShotPboIndex : screenShotPboIndex;
+		QOpenGLBuffer*& pbo = screenShotPbo[nextIndex];
+		if (!pbo)
+		{
+			pbo = new QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+			pbo->setUsagePattern(QOpenGLBuffer::StreamRead);
+			pbo->create();
+		}
+		pbo->bind();
+		if (pbo->size() != size.width()*size.height()*4)
+			pbo->allocate(size.width()*size.height()*4);
+		gl->glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, Q_NULLPTR);
+		pbo->release();
+
+		// While the new readback is in flight, collect the previous one.
+		if (screenShotReadbackPending)
+			finishScreenShotReadback();
+		screenShotPboIndex = nextIndex;
+		screenShotReadbackPending = true;
+		screenShotPendingPath = shotPath;
+		screenShotPendingSize = size;
+		screenShotPendingInvert = flagInvertScreenShotColors;
 	}
-	qDebug() << "INFO Saving screenshot in file: " << QDir::toNativeSeparators(shotPath.filePath());
-	if (!im.save(shotPath.filePath())) {
-		qWarning() << "WARNING failed to write screenshot to: " << QDir::toNativeSeparators(shotPath.filePath());
+	else
+	{
+		QByteArray pixels(size.width()*size.height()*4, Qt::Uninitialized);
+		gl->glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		queueScreenShotWrite(QImage(), pixels, size, shotPath, flagInvertScreenShotColors);
 	}
 }
+#endif
+
+void StelMainView::saveFrameSequenceShot()
+{
+	saveScreenShot(frameSequencePrefix);
+}
+
+void StelMainView::grabFrameSequenceShot()
+{
+#ifndef USE_OLD_QGLWIDGET
+	if (!frameSequenceShotPending)
+		return;
+	frameSequenceShotPending = false;
+
+	screenShotPrefix = frameSequencePrefix;
+	screenShotDir = "";
+	flagOverwriteScreenshots = false;
+	const QString shotPath = getNextScreenShotPath();
+	if (shotPath.isEmpty())
+		return;
+
+	// The widget renders without multisampling, so its framebuffer can be read directly.
+	// The frame is not rendered a second time like for an interactive screenshot.
+	glWidget->makeCurrent();
+	readScreenShotPixels(glWidget->size()*glWidget->devicePixelRatio(), shotPath);
+#endif
+}
 
 QPoint StelMainView::getMousePos()
 {
@@ -25,6 +25,8 @@
 #include <QEventLoop>
 #include <QOpenGLContext>
 #include <QTimer>
+#include <QHash>
+#include <QSemaphore>
 #ifdef OPENGL_DEBUG_LOGGING
 #include <QOpenGLDebugMessage>
 #endif
@@ -36,6 +38,9 @@ class QResizeEvent;
 class StelGuiBase;
 class QMoveEvent;
 class QSettings;
+class QOpenGLBuffer;
+class QOpenGLFramebufferObject;
+class QThreadPool;
 
 //! @class StelMainView
 //! Reimplement a QGraphicsView for Stellarium.
@@ -95,6 +100,17 @@ public:
 
 	//! Returns the information about the GL context, this does not require the context to be active.
 	GLInfo getGLInformation() const { return glInfo; }
+
+	//! Returns true if Stellarium was started with --headless, i.e. renders for batch processing without user interaction.
+	bool getFlagHeadless() const { return flagHeadless; }
+	//! Returns the fixed simulation time step per frame in seconds, or 0 if frames advance by wall-clock time.
+	double getFrameStep() const { return frameStep; }
+	//! Returns the time in seconds the simulation has advanced since startup.
+	//! With a fixed frame step this is decoupled from the wall clock, so scripts use it for waiting.
+	double getSimulatedTime() const { return simulatedTime; }
+	//! Called once for every rendered frame with the elapsed wall-clock time.
+	//! @return the time step the application should be updated with.
+	double advanceFrameTime(double wallClockDt);
 public slots:
 
 	//! Set whether fullscreen is activated or not
@@ -124,6 +140,16 @@ public slots:
 	//! Set whether existing files are overwritten when saving screenshot
 	void setFlagOverwriteScreenShots(bool b) {flagOverwriteScreenshots=b;}
 
+	//! Get the file format used when saving screenshots
+	QString getScreenShotFormat() const {return screenShotFormat;}
+	//! Set the file format used when saving screenshots.
+	//! @param format any image format supported by QImageWriter (e.g. "png", "jpg"), or "raw" to write
+	//! the uncompressed RGBA pixels (top row first, 4 bytes per pixel) without any header, which is fastest.
+	void setScreenShotFormat(const QString& format);
+
+	//! Block until all screenshots which are still read back or encoded have been written to disk.
+	void waitForScreenShots();
+
 	//! Get the state of the mouse cursor timeout flag
 	bool getFlagCursorTimeout() {return flagCursorTimeout;}
 	//! Get the mouse cursor timeout in seconds
@@ -188,6 +214,12 @@ signals:
 private slots:
 	// Do the actual screenshot generation in the main thread with this method.
 	void doScreenshot(void);
+	//! Save the frame which was just drawn as the next image of the --frame-sequence, by rendering it again.
+	//! Only used with USE_OLD_QGLWIDGET, whose grabFrameBuffer() reads the drawn frame.
+	void saveFrameSequenceShot();
+	//! Read back the frame which was just drawn from the framebuffer of the widget, when it is composed,
+	//! and save it as the next image of the --frame-sequence.
+	void grabFrameSequenceShot();
 	void minFPSUpdate();
 #ifdef OPENGL_DEBUG_LOGGING
 	void logGLMessage(const QOpenGLDebugMessage& debugMessage);
@@ -200,6 +232,17 @@ private slots:
 private:
 	//! The graphics scene notifies us when a draw finished, so that we can queue the next one
 	void drawEnded();
+	//! Find the file name for the next screenshot, or an empty string if the screenshot directory is not usable.
+	QString getNextScreenShotPath();
+	//! Map the pixel buffer of a pending asynchronous screenshot readback and hand it to the encoder threads.
+	//! Requires the GL context to be current.
+	void finishScreenShotReadback();
+	//! Hand a captured screenshot to the encoder threads. Either @param image is valid, or @param pixels
+	//! contains bottom-up RGBA pixels of the given @param size, as read back by OpenGL.
+	void queueScreenShotWrite(const QImage& image, const QByteArray& pixels, const QSize& size, const QString& path, bool invert);
+	//! Read the pixels of the bound framebuffer for a screenshot saved to @param shotPath.
+	//! Where pixel pack buffers are available the readback completes after the next frame. Not used with USE_OLD_QGLWIDGET.
+	void readScreenShotPixels(const QSize& size, const QString& shotPath);
 	//! Returns the desired OpenGL format settings,
 	//! on desktop this corresponds to a GL 2.1 context,
 	//! with 32bit RGBA buffer and 24/8 depth/stencil buffer
@@ -236,6 +279,36 @@ private:
 
 	QString screenShotPrefix;
 	QString screenShotDir;
+	QString screenShotFormat;
+
+	//! Next free number for each screenshot directory and prefix, to avoid probing existing files from 000 every time.
+	QHash<QString, int> screenShotCounters;
+	//! Offscreen target for screenshots, kept as long as the view size does not change
+	QOpenGLFramebufferObject* screenShotFbo;
+	//! Two pixel pack buffers used alternately for asynchronous readback (only if supported by the GL context)
+	QOpenGLBuffer* screenShotPbo[2];
+	int screenShotPboIndex;
+	//! Whether screenShotPbo[screenShotPboIndex] contains a readback which has not yet been mapped
+	bool screenShotReadbackPending;
+	QString screenShotPendingPath;
+	QSize screenShotPendingSize;
+	bool screenShotPendingInvert;
+	//! Threads encoding and writing screenshots
+	QThreadPool* screenShotThreadPool;
+	//! Free places for screenshot jobs, which are running or waiting for a thread
+	QSemaphore screenShotSlots;
+	//! Set while the scene is re-rendered into screenShotFbo, which is not a new frame
+	bool screenShotRendering;
+
+	//! Batch rendering without user interaction (--headless)
+	bool flagHeadless;
+	//! Fixed simulation time step per frame in seconds (--frame-step), 0 to follow the wall clock
+	double frameStep;
+	double simulatedTime;
+	//! If not empty, every frame is saved as a screenshot with this prefix (--frame-sequence)
+	QString frameSequencePrefix;
+	//! Set when a frame was drawn which still has to be grabbed for the --frame-sequence
+	bool frameSequenceShotPending;
 
 	// Number of second before the mouse cursor disappears
 	float cursorTimeout;
@@ -0,0 +1,163 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "ExtinctionShading.hpp"
+
+#include <QOpenGLShaderProgram>
+#include <algorithm>
+#include <cmath>
+
+// The same limits as in RefractionExtinction.cpp: Saemundsson's formula is used down to -3.54 degrees,
+// and faded out linearly down to -5 degrees.
+static const float MIN_GEO_ALTITUDE_DEG=-3.54f;
+static const float TRANSITION_WIDTH_GEO_DEG=1.46f;
+
+ExtinctionShading::ExtinctionShading()
+	: zenith(0.f, 0.f, 1.f)
+	, refractionFactor(0.f)
+	, coefficient(0.f)
+	, magnitudeFactor(1.f)
+	, scale(1.f)
+	, undergroundMode(Extinction::UndergroundExtinctionMirror)
+{
+}
+
+void ExtinctionShading::setExtinction(const Extinction& extinction, float factor, float s)
+{
+	coefficient = extinction.getExtinctionCoefficient();
+	undergroundMode = extinction.getUndergroundExtinctionMode();
+	magnitudeFactor = factor;
+	scale = s;
+}
+
+void ExtinctionShading::disable()
+{
+	coefficient = 0.f;
+	magnitudeFactor = 1.f;
+	scale = 1.f;
+}
+
+void ExtinctionShading::setZenith(const Vec3d& z)
+{
+	zenith.set(z[0], z[1], z[2]);
+	zenith.normalize();
+}
+
+void ExtinctionShading::setRefraction(const Refraction& refraction)
+{
+	refractionFactor = refraction.getPressure()/1010.f * 283.f/(273.f+refraction.getTemperature()) / 60.f;
+}
+
+// Keep in sync with the GLSL code below, and with Refraction::refractedSine()
+float ExtinctionShading::refractedSine(float sinGeo) const
+{
+	if (refractionFactor==0.f)
+		return sinGeo;
+	float alt = std::asin(std::max(-1.f, std::min(1.f, sinGeo)))*180.f/M_PI;
+	if (alt>MIN_GEO_ALTITUDE_DEG)
+	{
+		const float r = refractionFactor*(1.02f/std::tan((alt+10.3f/(alt+5.11f))*M_PI/180.f)+0.0019279f);
+		alt = std::min(90.f, alt+r);
+	}
+	else if (alt>MIN_GEO_ALTITUDE_DEG-TRANSITION_WIDTH_GEO_DEG)
+	{
+		const float rMin = refractionFactor*(1.02f/std::tan((MIN_GEO_ALTITUDE_DEG+10.3f/(MIN_GEO_ALTITUDE_DEG+5.11f))*M_PI/180.f)+0.0019279f);
+		alt += rMin*(alt-(MIN_GEO_ALTITUDE_DEG-TRANSITION_WIDTH_GEO_DEG))/TRANSITION_WIDTH_GEO_DEG;
+	}
+	else
+		return sinGeo;
+	return std::sin(alt*M_PI/180.f);
+}
+
+// Keep in sync with the GLSL code below
+float ExtinctionShading::airmass(float cosZ) const
+{
+	if (cosZ<-0.035f)
+	{
+		if (undergroundMode==Extinction::UndergroundExtinctionZero)
+			return 0.f;
+		if (undergroundMode==Extinction::UndergroundExtinctionMax)
+			return 42.f;
+		cosZ = std::min(1.f, -0.035f - (cosZ+0.035f));
+	}
+	// Young 1994, as in Extinction::airmass()
+	const float nom=(1.002432f*cosZ+0.148386f)*cosZ+0.0096467f;
+	const float denum=((cosZ+0.149864f)*cosZ+0.0102963f)*cosZ+0.000303978f;
+	return nom/denum;
+}
+
+float ExtinctionShading::getAttenuation(const Vec3f& pos) const
+{
+	if (coefficient==0.f)
+		return scale;
+	return std::pow(magnitudeFactor, coefficient*airmass(refractedSine(zenith*pos)))*scale;
+}
+
+const char* ExtinctionShading::getShaderSource()
+{
+	return
+		"uniform highp vec3 extinctionZenith;\n"
+		"uniform highp float extinctionCoefficient;\n"
+		"uniform highp float extinctionMagnitudeFactor;\n"
+		"uniform highp float extinctionScale;\n"
+		"uniform highp float extinctionUndergroundMode;\n"
+		"uniform highp float extinctionRefractionFactor;\n"
+		"highp float extinctionRefractedSine(highp float sinGeo)\n"
+		"{\n"
+		"    if (extinctionRefractionFactor==0.)\n"
+		"        return sinGeo;\n"
+		"    highp float alt = degrees(asin(clamp(sinGeo, -1., 1.)));\n"
+		"    if (alt>-3.54)\n"
+		"        alt = min(90., alt+extinctionRefractionFactor*(1.02/tan(radians(alt+10.3/(alt+5.11)))+0.0019279));\n"
+		"    else if (alt>-5.)\n"
+		"        alt += extinctionRefractionFactor*(1.02/tan(radians(-3.54+10.3/(-3.54+5.11)))+0.0019279)*(alt+5.)/1.46;\n"
+		"    else\n"
+		"        return sinGeo;\n"
+		"    return sin(radians(alt));\n"
+		"}\n"
+		"highp float extinctionAirmass(highp float cosZ)\n"
+		"{\n"
+		"    if (cosZ<-0.035)\n"
+		"    {\n"
+		"        if (extinctionUndergroundMode<0.5)\n"
+		"            return 0.;\n"
+		"        if (extinctionUndergroundMode<1.5)\n"
+		"            return 42.;\n"
+		"        cosZ = min(1., -0.035 - (cosZ+0.035));\n"
+		"    }\n"
+		"    highp float nom = (1.002432*cosZ+0.148386)*cosZ+0.0096467;\n"
+		"    highp float denum = ((cosZ+0.149864)*cosZ+0.0102963)*cosZ+0.000303978;\n"
+		"    return nom/denum;\n"
+		"}\n"
+		"highp float extinctionAttenuation(highp vec3 pos)\n"
+		"{\n"
+		"    return pow(extinctionMagnitudeFactor, extinctionCoefficient*extinctionAirmass(extinctionRefractedSine(dot(extinctionZenith, pos))))*extinctionScale;\n"
+		"}\n";
+}
+
+void ExtinctionShading::setUniforms(QOpenGLShaderProgram& program) const
+{
+	program.setUniformValue("extinctionZenith", zenith[0], zenith[1], zenith[2]);
+	program.setUniformValue("extinctionCoefficient", coefficient);
+	program.setUniformValue("extinctionMagnitudeFactor", magnitudeFactor);
+	program.setUniformValue("extinctionScale", scale);
+	program.setUniformValue("extinctionUndergroundMode", static_cast<float>(undergroundMode));
+	program.setUniformValue("extinctionRefractionFactor", refractionFactor);
+}
@@ -0,0 +1,76 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _EXTINCTIONSHADING_HPP_
+#define _EXTINCTIONSHADING_HPP_
+
+#include "RefractionExtinction.hpp"
+#include "VecMath.hpp"
+
+class QOpenGLShaderProgram;
+
+//! @class ExtinctionShading
+//! Attenuates fixed sky meshes like the Milky Way by atmospheric extinction in the vertex shader.
+//! The vertices keep their positions, e.g. in J2000 coordinates, and the shader derives their
+//! geometric altitude from the direction of the zenith in the same frame. So the vertex data
+//! never changes, only a few uniforms are set in each frame. With setRefraction(), the extinction
+//! depends on the apparent altitude, like for positions transformed with StelCore::RefractionOn.
+//! A vertex with an extinction of m magnitudes is attenuated by magnitudeFactor^m*scale.
+//! getAttenuation() computes the same on the CPU, for drawing without the shader.
+class ExtinctionShading
+{
+public:
+	ExtinctionShading();
+
+	//! Attenuate by the given extinction.
+	void setExtinction(const Extinction& extinction, float magnitudeFactor, float scale);
+	//! Don't attenuate, e.g. without atmosphere.
+	void disable();
+	//! Set the direction of the zenith in the frame of the vertices, without refraction.
+	void setZenith(const Vec3d& zenith);
+	//! Refract the altitudes with Saemundsson's formula like Refraction::forward(), for the pressure and
+	//! temperature of @param refraction. Without this, the geometric altitudes are used.
+	void setRefraction(const Refraction& refraction);
+
+	//! The attenuation of a vertex at the normalized position @param pos, as computed by the shader.
+	float getAttenuation(const Vec3f& pos) const;
+
+	//! GLSL code declaring the uniforms and the function "highp float extinctionAttenuation(highp vec3 pos)".
+	//! To be inserted in vertex shaders before their main().
+	static const char* getShaderSource();
+	//! Set the uniforms declared by getShaderSource() in a bound shader program.
+	void setUniforms(QOpenGLShaderProgram& program) const;
+
+private:
+	//! Geometrical airmass like Extinction::forward(), for the cosine of the zenith angle
+	float airmass(float cosZ) const;
+	//! The sine of the apparent altitude for the sine of the geometric altitude
+	float refractedSine(float sinGeo) const;
+
+	Vec3f zenith;
+	//! Refraction in degrees per arcminute of the standard atmosphere, 0 without refraction
+	float refractionFactor;
+	float coefficient;
+	float magnitudeFactor;
+	float scale;
+	int undergroundMode;
+};
+
+#endif // _EXTINCTIONSHADING_HPP_
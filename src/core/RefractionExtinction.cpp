@@ -25,6 +25,22 @@
 
 Extinction::Extinction() : ext_coeff(50), undergroundExtinctionMode(UndergroundExtinctionMirror)
 {
+	updateAirmassTable();
+}
+
+void Extinction::setUndergroundExtinctionMode(UndergroundExtinctionMode mode)
+{
+	if (mode==undergroundExtinctionMode)
+		return;
+	undergroundExtinctionMode=mode;
+	updateAirmassTable();
+}
+
+void Extinction::updateAirmassTable()
+{
+	airmassTable.resize(AIRMASS_TABLE_SIZE+1);
+	for (int i=0; i<=AIRMASS_TABLE_SIZE; ++i)
+		airmassTable[i]=airmass(2.f*i/AIRMASS_TABLE_SIZE-1.f, false);
 }
 
 // airmass computation for cosine of zenith angle z
@@ -74,6 +90,11 @@ static const float TRANSITION_WIDTH_GEO_DEG=1.46f;
 static const float TRANSITION_WIDTH_APP_DEG=1.78217f;
 static const float MIN_GEO_ALTITUDE_SIN=std::sin(MIN_GEO_ALTITUDE_DEG*M_PI/180.f);
 static const float MIN_APP_ALTITUDE_SIN=std::sin(MIN_APP_ALTITUDE_DEG*M_PI/180.f);
+// Forward refraction is tabulated from the bottom of the transition zone (no effect below) up to the zenith.
+// With 4096 intervals the interpolation error stays below 0.03 arcminutes.
+static const int REFRACTION_TABLE_SIZE=4096;
+static const double REFRACTION_TABLE_MIN_SIN=std::sin((MIN_GEO_ALTITUDE_DEG-TRANSITION_WIDTH_GEO_DEG)*M_PI/180.);
+static const double REFRACTION_TABLE_SCALE=REFRACTION_TABLE_SIZE/(1.-REFRACTION_TABLE_MIN_SIN);
 
 Refraction::Refraction() : pressure(1013.f), temperature(10.f),
 	preTransfoMat(Mat4d::identity()), invertPreTransfoMat(Mat4d::identity()), preTransfoMatf(Mat4f::identity()), invertPreTransfoMatf(Mat4f::identity()),
@@ -107,23 +128,18 @@ void Refraction::setPostTransfoMat(const Mat4d& m)
 void Refraction::updatePrecomputed()
 {
 	press_temp_corr=pressure/1010.f * 283.f/(273.f+temperature) / 60.f;
-}
 
-void Refraction::innerRefractionForward(Vec3d& altAzPos) const
-{
-	const double length = altAzPos.length();
-	if (length==0.0)
+	sinShiftTable.resize(REFRACTION_TABLE_SIZE+1);
+	for (int i=0; i<=REFRACTION_TABLE_SIZE; ++i)
 	{
-		// Under some circumstances there are zero coordinates. Just leave them alone.
-		//qDebug() << "Refraction::innerRefractionForward(): Zero vector detected - Continue with zero vector.";
-		return;
+		const double sinGeo=REFRACTION_TABLE_MIN_SIN+i/REFRACTION_TABLE_SCALE;
+		sinShiftTable[i]=refractedSine(sinGeo)-sinGeo;
 	}
+}
 
-	Q_ASSERT(length>0.0);
-	const double sinGeo = altAzPos[2]/length;
-	Q_ASSERT(fabs(sinGeo)<=1.0);
-	double geom_alt_rad = std::asin(sinGeo);
-	float geom_alt_deg = 180./M_PI*geom_alt_rad;
+double Refraction::refractedSine(double sinGeo) const
+{
+	float geom_alt_deg = 180./M_PI*std::asin(qBound(-1., sinGeo, 1.));
 	if (geom_alt_deg > MIN_GEO_ALTITUDE_DEG)
 	{
 		// refraction from Saemundsson, S&T1986 p70 / in Meeus, Astr.Alg.
@@ -138,13 +154,34 @@ void Refraction::innerRefractionForward(Vec3d& altAzPos) const
 		float r_m5=press_temp_corr * ( 1.02f / std::tan((MIN_GEO_ALTITUDE_DEG+10.3f/(MIN_GEO_ALTITUDE_DEG+5.11f))*M_PI/180.f) + 0.0019279f);
 		geom_alt_deg += r_m5*(geom_alt_deg-(MIN_GEO_ALTITUDE_DEG-TRANSITION_WIDTH_GEO_DEG))/TRANSITION_WIDTH_GEO_DEG;
 	}
-	else return;
-	// At this point we have corrected geometric altitude. Note that if we just change altAzPos[2], we would change vector length, so this would change our angles.
-	// We have to shorten X,Y components of the vector as well by the change in cosines of altitude, or (sqrt(1-sin(alt))
+	else return sinGeo;
+	return std::sin(geom_alt_deg*M_PI/180.);
+}
 
-	const double refr_alt_rad=geom_alt_deg*M_PI/180.;
-	const double sinRef=std::sin(refr_alt_rad);
+void Refraction::innerRefractionForward(Vec3d& altAzPos) const
+{
+	const double length = altAzPos.length();
+	if (length==0.0)
+	{
+		// Under some circumstances there are zero coordinates. Just leave them alone.
+		//qDebug() << "Refraction::innerRefractionForward(): Zero vector detected - Continue with zero vector.";
+		return;
+	}
 
+	Q_ASSERT(length>0.0);
+	const double sinGeo = altAzPos[2]/length;
+	Q_ASSERT(fabs(sinGeo)<=1.0);
+	if (sinGeo <= REFRACTION_TABLE_MIN_SIN)
+		return;
+
+	// Interpolate the refracted altitude from the table instead of evaluating Saemundsson's formula.
+	const double f=(sinGeo-REFRACTION_TABLE_MIN_SIN)*REFRACTION_TABLE_SCALE;
+	const int i=qMin(static_cast<int>(f), REFRACTION_TABLE_SIZE-1);
+	const double* t=sinShiftTable.constData()+i;
+	const double sinRef=qMin(1., sinGeo+t[0]+(t[1]-t[0])*(f-i));
+
+	// At this point we have corrected geometric altitude. Note that if we just change altAzPos[2], we would change vector length, so this would change our angles.
+	// We have to shorten X,Y components of the vector as well by the change in cosines of altitude, or (sqrt(1-sin(alt))
 	const double shortenxy=((fabs(sinGeo)>=1.0) ? 1.0 :
 			std::sqrt((1.-sinRef*sinRef)/(1.-sinGeo*sinGeo))); // we need double's mantissa length here, sorry!
 
@@ -238,12 +275,16 @@ void Refraction::backward(Vec3f& altAzPos) const
 
 void Refraction::setPressure(float p)
 {
+	if (p==pressure)
+		return;
 	pressure=p;
 	updatePrecomputed();
 }
 
 void Refraction::setTemperature(float t)
 {
+	if (t==temperature)
+		return;
 	temperature=t;
 	updatePrecomputed();
 }
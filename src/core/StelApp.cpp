@@ -44,6 +44,7 @@
 #include "StelActionMgr.hpp"
 #include "StelPropertyMgr.hpp"
 #include "StelProgressController.hpp"
+#include "StelProfiler.hpp"
 #include "StelModuleMgr.hpp"
 #include "StelLocaleMgr.hpp"
 #include "StelSkyCultureMgr.hpp"
@@ -66,6 +67,8 @@
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFont>
 #include <QMouseEvent>
 #include <QNetworkAccessManager>
 #include <QNetworkDiskCache>
@@ -214,6 +217,7 @@ StelApp::StelApp(StelMainView *parent)
 	, skyCultureMgr(Q_NULLPTR)
 	, actionMgr(Q_NULLPTR)
 	, propMgr(Q_NULLPTR)
+	, profiler(Q_NULLPTR)
 	, textureMgr(Q_NULLPTR)
 	, stelObjectMgr(Q_NULLPTR)
 	, planetLocationMgr(Q_NULLPTR)
@@ -295,6 +299,7 @@ StelApp::~StelApp()
 	delete moduleMgr; moduleMgr=Q_NULLPTR; // Delete the secondary instance
 	delete actionMgr; actionMgr = Q_NULLPTR;
 	delete propMgr; propMgr = Q_NULLPTR;
+	delete profiler; profiler = Q_NULLPTR;
 
 	Q_ASSERT(singleton);
 	singleton = Q_NULLPTR;
@@ -385,6 +390,9 @@ void StelApp::initScriptMgr()
 		startupScript = qApp->property("onetime_startup_script").toString();
 	else
 		startupScript = confSettings->value("scripts/startup_script", "startup.ssc").toString();
+	// A headless batch render is done when its script is
+	if (qApp->property("onetime_headless").toBool())
+		connect(scriptMgr, SIGNAL(scriptStopped()), this, SLOT(quit()), Qt::QueuedConnection);
 	// Use a queued slot call to start the script only once the main qApp event loop is running...
 	QMetaObject::invokeMethod(scriptMgr,
 				  "runScript",
@@ -410,6 +418,10 @@ void StelApp::init(QSettings* conf)
 		qDebug() << "Detected a high resolution device! Device pixel ratio:" << devicePixelsPerPixel;
 
 	setBaseFontSize(confSettings->value("gui/base_font_size", 13).toInt());
+
+	// Files added to the search paths without StelFileMgr, e.g. by plugins, are found again when the watcher sees them.
+	if (confSettings->value("main/flag_watch_data_dirs", true).toBool())
+		StelFileMgr::setFileSystemWatcher(new QFileSystemWatcher(this));
 	
 	core = new StelCore();
 	if (saveProjW!=-1 && saveProjH!=-1)
@@ -433,6 +445,8 @@ void StelApp::init(QSettings* conf)
 
 	//create non-StelModule managers
 	propMgr = new StelPropertyMgr();
+	profiler = new StelProfiler();
+	propMgr->registerObject(profiler);
 	localeMgr = new StelLocaleMgr();
 	skyCultureMgr = new StelSkyCultureMgr();
 	propMgr->registerObject(skyCultureMgr);
@@ -552,6 +566,8 @@ void StelApp::init(QSettings* conf)
 
 	// Init actions.
 	actionMgr->addAction("actionShow_Night_Mode", N_("Display Options"), N_("Night mode"), this, "nightMode", "Ctrl+N");
+	actionMgr->addAction("actionShow_Profiler", N_("Miscellaneous"), N_("Frame profiler"), profiler, "overlayDisplayed");
+	actionMgr->addAction("actionSave_Profiler_Trace", N_("Miscellaneous"), N_("Save frame profiler trace"), this, "saveProfilerTrace()");
 
 	setFlagShowDecimalDegrees(confSettings->value("gui/flag_show_decimal_degrees", false).toBool());
 	setFlagSouthAzimuthUsage(confSettings->value("gui/flag_use_azimuth_from_south", false).toBool());
@@ -659,6 +675,8 @@ void StelApp::update(double deltaTime)
 	if (!initialized)
 		return;
 
+	profiler->beginFrame();
+
 	++frame;
 	frameTimeAccum+=deltaTime;
 	if (frameTimeAccum > 1.)
@@ -669,17 +687,29 @@ void StelApp::update(double deltaTime)
 		frameTimeAccum=0.;
 	}
 		
-	core->update(deltaTime);
+	{
+		StelProfiler::Scope scope("StelCore");
+		core->update(deltaTime);
+	}
 
 	moduleMgr->update();
 
 	// Send the event to every StelModule
 	foreach (StelModule* i, moduleMgr->getCallOrders(StelModule::ActionUpdate))
 	{
+		StelProfiler::Scope scope(i->objectName());
 		i->update(deltaTime);
 	}
 
-	stelObjectMgr->update(deltaTime);
+	{
+		StelProfiler::Scope scope(stelObjectMgr->objectName());
+		stelObjectMgr->update(deltaTime);
+	}
+
+#ifndef DISABLE_SCRIPTING
+	// A script waiting for the simulation continues once this frame is done
+	scriptMgr->update();
+#endif
 }
 
 void StelApp::prepareRenderBuffer()
@@ -721,6 +751,7 @@ void StelApp::draw()
 	const QList<StelModule*> modules = moduleMgr->getCallOrders(StelModule::ActionDraw);
 	foreach(StelModule* module, modules)
 	{
+		StelProfiler::Scope scope(module->objectName(), StelProfiler::Draw);
 		module->draw(core);
 	}
 	core->postDraw();
@@ -731,6 +762,34 @@ void StelApp::draw()
 #endif
 	applyRenderBuffer(drawFbo);
 
+	profiler->endFrame();
+	if (profiler->getFlagOverlayDisplayed())
+		drawProfilerOverlay();
+}
+
+void StelApp::drawProfilerOverlay()
+{
+	const QStringList lines = profiler->getSummary();
+	StelProjectorP prj = core->getProjection2d();
+	StelPainter sPainter(prj);
+	QFont font("Monospace");
+	font.setStyleHint(QFont::TypeWriter);
+	font.setPixelSize(getBaseFontSize());
+	sPainter.setFont(font);
+	sPainter.setColor(1.f, 1.f, 0.6f, 0.9f);
+	sPainter.setBlending(true);
+	const float lineHeight = 1.3f*font.pixelSize();
+	for (int i=0; i<lines.size(); ++i)
+		sPainter.drawText(10.f, prj->getViewportHeight() - 40.f - i*lineHeight, lines.at(i));
+}
+
+void StelApp::saveProfilerTrace(const QString& fileName)
+{
+	QString path = fileName;
+	if (path.isEmpty())
+		path = StelFileMgr::getUserDir() + "/profiler-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json";
+	if (profiler->saveTrace(path))
+		qDebug() << "Saved profiler trace in file:" << QDir::toNativeSeparators(path);
 }
 
 /*************************************************************************
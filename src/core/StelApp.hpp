@@ -49,6 +49,7 @@ class StelScriptMgr;
 class StelActionMgr;
 class StelPropertyMgr;
 class StelProgressController;
+class StelProfiler;
 
 #ifdef 	ENABLE_SPOUT
 class SpoutSender;
@@ -144,6 +145,9 @@ public:
 	//! Return the property manager
 	StelPropertyMgr* getStelPropertyManager() {return propMgr;}
 
+	//! Get the frame profiler, which times the modules of each frame.
+	StelProfiler* getProfiler() {return profiler;}
+
 	//! Get the video manager
 	StelVideoMgr* getStelVideoMgr() {return videoMgr;}
 
@@ -276,6 +280,10 @@ public slots:
 
 	//! do some cleanup and call QCoreApplication::exit(0)
 	void quit();
+
+	//! Save the frames recorded by the profiler as a Chrome trace file.
+	//! @param fileName the file to write, by default profiler-<date>-<time>.json in the user directory
+	void saveProfilerTrace(const QString& fileName="");
 signals:
 	void visionNightModeChanged(bool);
 	void colorSchemeChanged(const QString&);
@@ -305,6 +313,8 @@ private:
 	//! Used internally to set the viewport effects.
 	//! @param drawFbo the OpenGL fbo we need to render into.
 	void applyRenderBuffer(quint32 drawFbo=0);
+	//! Draw the summary of the profiler in the upper left corner
+	void drawProfilerOverlay();
 
 	// The StelApp singleton
 	static StelApp* singleton;
@@ -330,6 +340,9 @@ private:
 	//Property manager for the application
 	StelPropertyMgr* propMgr;
 
+	// Frame profiler for the application
+	StelProfiler* profiler;
+
 	// Textures manager for the application
 	StelTextureMgr* textureMgr;
 
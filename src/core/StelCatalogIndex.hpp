@@ -0,0 +1,141 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _STELCATALOGINDEX_HPP_
+#define _STELCATALOGINDEX_HPP_
+
+#include "StelSphericalIndex.hpp"
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <cmath>
+
+//! @class StelCatalogIndex
+//! Spatial index for the point objects of a catalog, e.g. the quasars or pulsars of a plugin.
+//! The objects are stored in a StelSphericalIndex by their J2000 position, so the objects inside
+//! the viewport or around a position are found without testing every object of the catalog.
+//! The upper case names of the objects are also kept in a hash table for searches by name.
+//!
+//! The positions are given when inserting the objects and must not change afterwards.
+//! T can be any class, the index only keeps shared pointers to the objects.
+template<class T> class StelCatalogIndex
+{
+public:
+	typedef QSharedPointer<T> TP;
+
+	StelCatalogIndex(int maxObjectsPerNode=100, int maxLevel=7) : grid(maxObjectsPerNode, maxLevel) {}
+
+	//! Insert an object.
+	//! @param obj the object
+	//! @param j2000Pos the unit vector of its position in the J2000 equatorial frame
+	//! @param names the names under which searchByName() finds the object.
+	//! If several objects have the same name, the first inserted one is found.
+	void insert(const TP& obj, const Vec3d& j2000Pos, const QStringList& names=QStringList())
+	{
+		const int index = objects.size();
+		objects.append(obj);
+		grid.insert(StelRegionObjectP(new Entry(index, j2000Pos)));
+		foreach (const QString& name, names)
+		{
+			const QString key = name.toUpper();
+			if (!key.isEmpty() && !nameIndex.contains(key))
+				nameIndex.insert(key, index);
+		}
+	}
+
+	//! Remove all the objects.
+	void clear()
+	{
+		grid.clear();
+		objects.clear();
+		nameIndex.clear();
+	}
+
+	int size() const { return objects.size(); }
+	bool isEmpty() const { return objects.isEmpty(); }
+	//! All the objects, in insertion order.
+	const QVector<TP>& getObjects() const { return objects; }
+
+	//! Find the objects whose position is inside a region.
+	//! @param region the region, in the J2000 equatorial frame
+	//! @param result is cleared, then receives the objects. Reuse it between frames to avoid allocations.
+	void findInRegion(const SphericalRegion* region, QVector<TP>& result) const
+	{
+		result.clear();
+		Collector func(objects, result);
+		grid.processIntersectingPointInRegions(region, func);
+	}
+
+	//! Find the objects less than limitFov degrees away from a position.
+	//! @param v the position in the J2000 equatorial frame, it does not need to be normalized.
+	QVector<TP> searchAround(const Vec3d& v, double limitFov) const
+	{
+		Vec3d n(v);
+		n.normalize();
+		const SphericalCap cap(n, std::cos(limitFov*M_PI/180.));
+		QVector<TP> result;
+		findInRegion(&cap, result);
+		return result;
+	}
+
+	//! Find an object by one of the names given to insert(), ignoring the case.
+	//! @return the object, or a null pointer if there is none.
+	TP searchByName(const QString& name) const
+	{
+		const int index = nameIndex.value(name.toUpper(), -1);
+		return index<0 ? TP() : objects.at(index);
+	}
+
+private:
+	Q_DISABLE_COPY(StelCatalogIndex)
+
+	//! The element stored in the spherical index: the index of the object and its position.
+	class Entry : public StelRegionObject
+	{
+	public:
+		Entry(int index, const Vec3d& pos) : index(index), pos(pos) {}
+		virtual SphericalRegionP getRegion() const Q_DECL_OVERRIDE { return SphericalRegionP(new SphericalPoint(pos)); }
+		virtual Vec3d getPointInRegion() const Q_DECL_OVERRIDE { return pos; }
+		const int index;
+		const Vec3d pos;
+	};
+
+	struct Collector
+	{
+		Collector(const QVector<TP>& objects, QVector<TP>& result) : objects(objects), result(result) {}
+		void operator()(const StelRegionObject* obj)
+		{
+			result.append(objects.at(static_cast<const Entry*>(obj)->index));
+		}
+		const QVector<TP>& objects;
+		QVector<TP>& result;
+	};
+
+	StelSphericalIndex grid;
+	QVector<TP> objects;
+	//! Index in objects by upper case name
+	QHash<QString, int> nameIndex;
+};
+
+#endif // _STELCATALOGINDEX_HPP_
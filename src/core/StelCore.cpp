@@ -39,6 +39,7 @@
 #include "StelActionMgr.hpp"
 #include "StelPropertyMgr.hpp"
 #include "StelFileMgr.hpp"
+#include "StelTimeZoneCache.hpp"
 #include "StelMainView.hpp"
 #include "EphemWrapper.hpp"
 #include "NomenclatureItem.hpp"
@@ -85,6 +86,8 @@ StelCore::StelCore()
 	, presetSkyTime(0.)
 	, milliSecondsOfLastJDUpdate(0.)
 	, jdOfLastJDUpdate(0.)
+	, flagFixedTimeStep(false)
+	, fixedStepClockMSecs(0.)
 	, flagUseDST(true)
 	, flagUseCTZ(false)
 	, deltaTCustomNDot(-26.0)
@@ -1077,6 +1080,21 @@ qint64 StelCore::getMilliSecondsOfLastJDUpdate() const
 	return milliSecondsOfLastJDUpdate;
 }
 
+void StelCore::setFlagFixedTimeStep(bool b)
+{
+	if (b==flagFixedTimeStep)
+		return;
+	// Continue from the system clock, so that milliSecondsOfLastJDUpdate stays meaningful for e.g. RemoteSync
+	fixedStepClockMSecs = QDateTime::currentMSecsSinceEpoch();
+	flagFixedTimeStep = b;
+	resetSync();
+}
+
+double StelCore::getClockMSecs() const
+{
+	return flagFixedTimeStep ? fixedStepClockMSecs : QDateTime::currentMSecsSinceEpoch();
+}
+
 void StelCore::setJD(double newJD)
 {
 	JD.first=newJD;
@@ -1290,32 +1308,45 @@ void StelCore::moveObserverTo(const StelLocation& target, double duration, doubl
 	emit locationChanged(getCurrentLocation());
 }
 
+// Shared by all callers of getUTCOffset(), see StelTimeZoneCache
+static StelTimeZoneCache timeZoneCache;
+
 float StelCore::getUTCOffset(const double JD) const
 {
-	int year, month, day, hour, minute, second;
-	StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
-	StelUtils::getTimeFromJulianDay(JD, &hour, &minute, &second);
-	// as analogous to second statement in getJDFromDate, nkerr
-	if ( year <= 0 )
-	{
-		year = year - 1;
-	}
-	//getTime/DateFromJulianDay returns UTC time, not local time
-	QDateTime universal(QDate(year, month, day), QTime(hour, minute, second), Qt::UTC);
-	if (!universal.isValid())
+	const StelLocation& loc = getCurrentLocation();
+	const QString tzName = getCurrentTimeZone();
+
+	int shiftInSeconds = 0;
+	bool tzValid = false;
+	// The first adoption of a standard time was on December 1, 1847 in Great Britain
+	const bool useTimeZone = loc.planetName=="Earth" && (JD>=StelCore::TZ_ERA_BEGINNING || getUseCustomTimeZone());
+	if (tzName!="system_default")
 	{
-		//qWarning() << "JD " << QString("%1").arg(JD) << " out of bounds of QT help with GMT shift, using current datetime";
-		// Assumes the GMT shift was always the same before year -4710
-		universal = QDateTime(QDate(-4710, month, day), QTime(hour, minute, second), Qt::UTC);
+		// Dates outside the tabulated range of the cache are not clamped to it, their offsets are computed by the QTimeZone.
+		// This includes dates before -4710, for which the QDate based code below would need a substitute year.
+		tzValid = timeZoneCache.offset(tzName, StelTimeZoneCache::jdToMSecsSinceEpoch(JD), getUseDST(), &shiftInSeconds);
+		if (!tzValid || !useTimeZone)
+			shiftInSeconds = 0;
 	}
 
-	StelLocation loc = getCurrentLocation();
-	QString tzName = getCurrentTimeZone();
-	QTimeZone* tz = new QTimeZone(tzName.toUtf8());
-
-	int shiftInSeconds = 0;
-	if (tzName=="system_default" || (loc.planetName=="Earth" && !tz->isValid() && !QString("LMST LTST").contains(tzName)))
+	if (tzName=="system_default" || (loc.planetName=="Earth" && !tzValid && !QString("LMST LTST").contains(tzName)))
 	{
+		int year, month, day, hour, minute, second;
+		StelUtils::getDateFromJulianDay(JD, &year, &month, &day);
+		StelUtils::getTimeFromJulianDay(JD, &hour, &minute, &second);
+		// as analogous to second statement in getJDFromDate, nkerr
+		if ( year <= 0 )
+		{
+			year = year - 1;
+		}
+		//getTime/DateFromJulianDay returns UTC time, not local time
+		QDateTime universal(QDate(year, month, day), QTime(hour, minute, second), Qt::UTC);
+		if (!universal.isValid())
+		{
+			//qWarning() << "JD " << QString("%1").arg(JD) << " out of bounds of QT help with GMT shift, using current datetime";
+			// Assumes the GMT shift was always the same before year -4710
+			universal = QDateTime(QDate(-4710, month, day), QTime(hour, minute, second), Qt::UTC);
+		}
 		QDateTime local = universal.toLocalTime();
 		//Both timezones should be interpreted as UTC because secsTo() converts both
 		//times to UTC if their zones have different daylight saving time rules.
@@ -1324,25 +1355,13 @@ float StelCore::getUTCOffset(const double JD) const
 	}
 	else
 	{
-		// The first adoption of a standard time was on December 1, 1847 in Great Britain
-		if (tz->isValid() && loc.planetName=="Earth" && (JD>=StelCore::TZ_ERA_BEGINNING || getUseCustomTimeZone()))
-		{
-			if (getUseDST())
-				shiftInSeconds = tz->offsetFromUtc(universal);
-			else
-				shiftInSeconds = tz->standardTimeOffset(universal);
-		}
-		else
+		if (!(tzValid && useTimeZone))
 			shiftInSeconds = (loc.longitude/15.f)*3600.f; // Local Mean Solar Time
 
 		if (tzName=="LTST")
 			shiftInSeconds += getSolutionEquationOfTime(JD)*60;
-
 	}
 
-	delete tz;
-	tz = Q_NULLPTR;
-
 	float shiftInHours = shiftInSeconds / 3600.0f;
 	return shiftInHours;
 }
@@ -1825,13 +1844,16 @@ bool StelCore::getRealTimeSpeed() const
 // Increment time
 void StelCore::updateTime(double deltaTime)
 {
+	if (flagFixedTimeStep)
+		fixedStepClockMSecs += deltaTime*1000.;
+
 	if (getRealTimeSpeed())
 	{
-		JD.first = jdOfLastJDUpdate + (QDateTime::currentMSecsSinceEpoch() - milliSecondsOfLastJDUpdate) / 1000.0 * JD_SECOND;
+		JD.first = jdOfLastJDUpdate + (getClockMSecs() - milliSecondsOfLastJDUpdate) / 1000.0 * JD_SECOND;
 	}
 	else
 	{
-		JD.first = jdOfLastJDUpdate + (QDateTime::currentMSecsSinceEpoch() - milliSecondsOfLastJDUpdate) / 1000.0 * timeSpeed;
+		JD.first = jdOfLastJDUpdate + (getClockMSecs() - milliSecondsOfLastJDUpdate) / 1000.0 * timeSpeed;
 	}
 
 	// Fix time limits to -100000 to +100000 to prevent bugs
@@ -1868,7 +1890,7 @@ void StelCore::resetSync()
 	//use currentMsecsSinceEpoch directly instead of StelApp::getTotalRuntime,
 	//because the StelApp::startMSecs gets subtracted anyways in update()
 	//also changed to qint64 to increase precision
-	milliSecondsOfLastJDUpdate = QDateTime::currentMSecsSinceEpoch();
+	milliSecondsOfLastJDUpdate = getClockMSecs();
 	emit timeSyncOccurred(jdOfLastJDUpdate);
 }
 
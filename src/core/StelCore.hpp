@@ -442,6 +442,12 @@ public slots:
 	//! Returns the system date of the last time resetSync() was called
 	qint64 getMilliSecondsOfLastJDUpdate() const;
 
+	//! Set whether the simulation time advances only by the time steps passed to update(),
+	//! instead of by the system clock. Used for deterministic batch rendering.
+	void setFlagFixedTimeStep(bool b);
+	//! Get whether the simulation time advances only by the time steps passed to update()
+	bool getFlagFixedTimeStep() const { return flagFixedTimeStep; }
+
 	//! Set the current date in Julian Day (UT)
 	void setJD(double newJD);
 	//! Set the current date in Julian Day (TT).
@@ -762,6 +768,8 @@ private:
 	void updateTime(double deltaTime);
 	void updateMaximumFov();
 	void resetSync();
+	//! The clock the simulation time follows, in milliseconds: the system clock, or the sum of all update() time steps
+	double getClockMSecs() const;
 
 	void registerMathMetaTypes();
 
@@ -802,6 +810,8 @@ private:
 	QString startupTimeMode;
 	double milliSecondsOfLastJDUpdate;    // Time in seconds when the time rate or time last changed
 	double jdOfLastJDUpdate;         // JD when the time rate or time last changed
+	bool flagFixedTimeStep;          // Advance the time by the update() time steps only
+	double fixedStepClockMSecs;      // Clock in milliseconds accumulated from the update() time steps
 
 	QString currentTimeZone;	
 	bool flagUseDST;
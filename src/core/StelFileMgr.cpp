@@ -22,7 +22,10 @@
 #include <cstdlib>
 #include <QCoreApplication>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QDir>
+#include <QMutexLocker>
+#include <QThread>
 #include <QString>
 #include <QDebug>
 #include <QStandardPaths>
@@ -44,6 +47,40 @@ QStringList StelFileMgr::fileLocations;
 QString StelFileMgr::userDir;
 QString StelFileMgr::screenshotDir;
 QString StelFileMgr::installDir;
+QHash<QString, QString> StelFileMgr::resolvedPaths;
+QHash<QString, QHash<QString, bool> > StelFileMgr::directoryContents;
+QHash<QString, bool> StelFileMgr::watchedDirectories;
+QMutex StelFileMgr::cacheMutex;
+bool StelFileMgr::cacheEnabled = true;
+QPointer<QFileSystemWatcher> StelFileMgr::fileSystemWatcher;
+QAtomicInt StelFileMgr::fileSystemQueryCount;
+
+namespace
+{
+	//! Whether a path is made of plain names separated by '/', which can be looked up in the cached directory contents
+	bool isPlainRelativePath(const QString& path)
+	{
+		if (path.contains('\\') || path.contains(':'))
+			return false;
+		foreach (const QString& name, path.split('/'))
+		{
+			if (name.isEmpty() || name=="." || name=="..")
+				return false;
+		}
+		return true;
+	}
+
+	//! Key of a directory entry in the cached directory contents
+	inline QString entryKey(const QString& name)
+	{
+#if defined(Q_OS_WIN) || defined(Q_OS_MAC)
+		// case insensitive file systems
+		return name.toLower();
+#else
+		return name;
+#endif
+	}
+}
 
 void StelFileMgr::init()
 {
@@ -75,6 +112,7 @@ void StelFileMgr::init()
 
 	// OK, now we have the userDir set, add it to the search path
 	fileLocations.append(userDir);
+	invalidateCache();
 
 	
 	// Determine install data directory location
@@ -140,6 +178,7 @@ void StelFileMgr::init()
 
 	// Then add the installation directory to the search path
 	fileLocations.append(installDir);	
+	invalidateCache();
 }
 
 
@@ -180,13 +219,38 @@ QString StelFileMgr::findFile(const QString& path, Flags flags)
 		}
 	}
 	
+	// Lookups with these flags depend on more than the existence and type of the files
+	const bool cached = cacheEnabled && !(flags & (Writable|New));
+	const QString cacheKey = QString::number(flags) + '|' + path;
+	if (cached)
+	{
+		QMutexLocker lock(&cacheMutex);
+		QHash<QString, QString>::const_iterator it = resolvedPaths.constFind(cacheKey);
+		if (it != resolvedPaths.constEnd())
+			return it.value();
+	}
+
+	// Only remembered if the file was not found in the earlier search paths because of watched directories:
+	// a file added to a directory which is not watched could be found, or override the result, later.
+	bool cacheable = cached;
+	QString result;
 	foreach (const QString& i, fileLocations)
 	{
-		const QFileInfo finfo(i + "/" + path);
-		if (fileFlagsCheck(finfo, flags))
-			return i + "/" + path;
+		if (fileFlagsCheck(i, path, flags, &cacheable))
+		{
+			result = i + "/" + path;
+			break;
+		}
 	}
 
+	if (cacheable)
+	{
+		QMutexLocker lock(&cacheMutex);
+		resolvedPaths.insert(cacheKey, result);
+	}
+	if (!result.isEmpty())
+		return result;
+
 	//FIXME: This line give false positive values for static plugins (trying search dynamic plugin first)
 	//qWarning() << QString("file not found: %1").arg(path);
 	return "";
@@ -224,8 +288,7 @@ QStringList StelFileMgr::findFileInAllPaths(const QString &path, const Flags &fl
 
 	foreach (const QString& locationPath, fileLocations)
 	{
-		const QFileInfo finfo(locationPath + "/" + path);
-		if (fileFlagsCheck(finfo, flags))
+		if (fileFlagsCheck(locationPath, path, flags))
 			filePaths.append(locationPath + "/" + path);
 	}
 
@@ -279,6 +342,7 @@ QSet<QString> StelFileMgr::listContents(const QString& path, const StelFileMgr::
 void StelFileMgr::setSearchPaths(const QStringList& paths)
 {
 	fileLocations = paths;
+	invalidateCache();
 }
 
 bool StelFileMgr::exists(const QString& path)
@@ -313,7 +377,9 @@ qint64 StelFileMgr::size(const QString& path)
 
 bool StelFileMgr::mkDir(const QString& path)
 {
-	return QDir("/").mkpath(path);
+	const bool ok = QDir("/").mkpath(path);
+	invalidateCache();
+	return ok;
 }
 
 QString StelFileMgr::dirName(const QString& path)
@@ -367,6 +433,110 @@ bool StelFileMgr::fileFlagsCheck(const QFileInfo& thePath, const Flags& flags)
 	return true;
 }
 
+bool StelFileMgr::fileFlagsCheck(const QString& location, const QString& path, const Flags& flags, bool* cacheable)
+{
+	if (!cacheEnabled || (flags & (Writable|New)) || !isPlainRelativePath(path))
+	{
+		fileSystemQueryCount.ref();
+		const bool match = fileFlagsCheck(QFileInfo(location + "/" + path), flags);
+		if (!match && cacheable)
+			*cacheable = false;
+		return match;
+	}
+
+	// Walk down the cached directories
+	QMutexLocker lock(&cacheMutex);
+	const QStringList names = path.split('/');
+	QString dirPath = location;
+	for (int i=0; i<names.size(); ++i)
+	{
+		const QHash<QString, bool>& contents = getDirectoryContents(dirPath);
+		QHash<QString, bool>::const_iterator entry = contents.constFind(entryKey(names.at(i)));
+		if (entry == contents.constEnd())
+			break;
+		const bool isDir = entry.value();
+		if (i==names.size()-1)
+			return !((flags & Directory) && !isDir) && !((flags & File) && isDir);
+		if (!isDir)
+			return false;
+		dirPath += "/" + names.at(i);
+	}
+
+	// The name is missing in the listing of dirPath. Only a watched directory is known to be still without it,
+	// in others the file may have been created since the listing without StelFileMgr.
+	if (watchedDirectories.value(dirPath, false))
+		return false;
+	if (cacheable)
+		*cacheable = false;
+	fileSystemQueryCount.ref();
+	return fileFlagsCheck(QFileInfo(location + "/" + path), flags);
+}
+
+const QHash<QString, bool>& StelFileMgr::getDirectoryContents(const QString& dirPath)
+{
+	// The watcher can only be used from its own thread. Directories listed first in other threads
+	// are added when they are used in the thread of the watcher. A directory is listed again after it
+	// was added, so that no change between the listing and the start of watching is missed.
+	if (fileSystemWatcher && fileSystemWatcher->thread()==QThread::currentThread() && !watchedDirectories.contains(dirPath))
+	{
+		fileSystemQueryCount.ref();
+		const bool watched = QFileInfo(dirPath).isDir() && fileSystemWatcher->addPath(dirPath);
+		watchedDirectories.insert(dirPath, watched);
+		if (watched)
+			directoryContents.remove(dirPath);
+	}
+
+	QHash<QString, QHash<QString, bool> >::iterator it = directoryContents.find(dirPath);
+	if (it == directoryContents.end())
+	{
+		// One listing instead of a query for each file looked up in the directory.
+		// Broken symbolic links are not listed, like findFile() does not find them.
+		fileSystemQueryCount.ref();
+		QHash<QString, bool> contents;
+		const QDir dir(dirPath);
+		foreach (const QFileInfo& info, dir.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::NoDotAndDotDot))
+			contents.insert(entryKey(info.fileName()), info.isDir());
+		it = directoryContents.insert(dirPath, contents);
+	}
+	return it.value();
+}
+
+void StelFileMgr::invalidateCache()
+{
+	QMutexLocker lock(&cacheMutex);
+	resolvedPaths.clear();
+	directoryContents.clear();
+	// Directories which could not be watched may exist now
+	QHash<QString, bool>::iterator it = watchedDirectories.begin();
+	while (it != watchedDirectories.end())
+	{
+		if (it.value())
+			++it;
+		else
+			it = watchedDirectories.erase(it);
+	}
+}
+
+void StelFileMgr::setCacheEnabled(bool b)
+{
+	cacheEnabled = b;
+	invalidateCache();
+}
+
+void StelFileMgr::setFileSystemWatcher(QFileSystemWatcher* watcher)
+{
+	if (fileSystemWatcher)
+		QObject::disconnect(fileSystemWatcher.data(), SIGNAL(directoryChanged(QString)), Q_NULLPTR, Q_NULLPTR);
+	fileSystemWatcher = watcher;
+	{
+		QMutexLocker lock(&cacheMutex);
+		watchedDirectories.clear();
+	}
+	if (watcher)
+		QObject::connect(watcher, &QFileSystemWatcher::directoryChanged, [](const QString&) { invalidateCache(); });
+	invalidateCache();
+}
+
 QString StelFileMgr::getDesktopDir()
 {
 
@@ -391,6 +561,7 @@ void StelFileMgr::setUserDir(const QString& newDir)
 	QFileInfo userDirFI(newDir);
 	userDir = userDirFI.filePath();
 	fileLocations.replace(0, userDir);
+	invalidateCache();
 }
 
 QString StelFileMgr::getInstallationDir()
@@ -452,7 +623,9 @@ void StelFileMgr::makeSureDirExistsAndIsWritable(const QString& dirFullPath)
 	{
 		// The modules directory doesn't exist, lets create it.
 		qDebug() << "Creating directory " << QDir::toNativeSeparators(uDir.filePath());
-		if (!QDir("/").mkpath(uDir.filePath()))
+		const bool created = QDir("/").mkpath(uDir.filePath());
+		invalidateCache();
+		if (!created)
 		{
 			throw std::runtime_error(QString("Could not create directory: " +uDir.filePath()).toStdString());
 		}
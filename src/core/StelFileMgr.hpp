@@ -23,11 +23,16 @@
 #define CHECK_FILE "data/ssystem_major.ini"
 
 #include <stdexcept>
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
 #include <QSet>
 #include <QString>
 #include <QStringList>
 
 class QFileInfo;
+class QFileSystemWatcher;
 
 //! Provides utilities for locating and handling files.
 //! StelFileMgr provides functions for locating files.  It maintains a list of
@@ -73,6 +78,9 @@ public:
 	//! @param path the name of the file to search for, for example "textures/fog.png".
 	//! @param flags options which constrain the result.
 	//! @return returns a full path of the file if found, else return an empty path.
+	//! @note Unless the Writable or New flags are given, the results and the contents of the directories
+	//! of the search paths are cached. Files which are not found are only cached for directories watched
+	//! by the file system watcher, others are looked up again. See invalidateCache().
 	static QString findFile(const QString& path, Flags flags=(Flags)0);
 
 	//! List all paths within the search paths that match the argument.
@@ -194,6 +202,21 @@ public:
 	//! @return the path to the locale directory or "" if the locale directory could not be found.
 	static QString getLocaleDir();
 
+	//! Forget the results of findFile() and findFileInAllPaths() and the directory contents they were found in.
+	//! Files and directories created or removed with StelFileMgr invalidate the cache, and new files are found
+	//! without it. Call this after removing or replacing files in the search paths by other means,
+	//! if no file system watcher is set.
+	static void invalidateCache();
+	//! Enable the cache of findFile() and findFileInAllPaths(). It is enabled by default.
+	static void setCacheEnabled(bool b);
+	static bool getCacheEnabled() { return cacheEnabled; }
+	//! Invalidate the cache when one of the cached directories changes.
+	//! The cached directories are added to @param watcher, which must live in the main thread.
+	//! @param watcher the watcher, or Q_NULLPTR to stop watching.
+	static void setFileSystemWatcher(QFileSystemWatcher* watcher);
+	//! Number of file information queries and directory listings made to find files, for testing.
+	static int getFileSystemQueryCount() { return fileSystemQueryCount.load(); }
+
 private:
 
 	//! No one can create an instance.
@@ -206,8 +229,27 @@ private:
 	//! @exception misc
 	static bool fileFlagsCheck(const QFileInfo& thePath, const Flags& flags=(Flags)0);
 
+	//! Check if the relative path @param path within the search path @param location matches a set of flags.
+	//! Uses the cached directory contents when the flags do not need more than the type of the file.
+	//! @param cacheable is set to false if a negative answer does not come from a watched directory.
+	static bool fileFlagsCheck(const QString& location, const QString& path, const Flags& flags, bool* cacheable=Q_NULLPTR);
+	//! Get the names of the entries of a directory, and whether they are directories.
+	//! The cache mutex must be locked.
+	static const QHash<QString, bool>& getDirectoryContents(const QString& dirPath);
+
 	static QStringList fileLocations;
 
+	//! Results of findFile(), by flags and path
+	static QHash<QString, QString> resolvedPaths;
+	//! Contents of the directories of the search paths, by directory path
+	static QHash<QString, QHash<QString, bool> > directoryContents;
+	//! Directories which were added to the file system watcher, with false if that failed
+	static QHash<QString, bool> watchedDirectories;
+	static QMutex cacheMutex;
+	static bool cacheEnabled;
+	static QPointer<QFileSystemWatcher> fileSystemWatcher;
+	static QAtomicInt fileSystemQueryCount;
+
 	//! Used to store the user data directory
 	static QString userDir;
 
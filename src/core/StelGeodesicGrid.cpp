@@ -35,6 +35,7 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include "StelGeodesicGrid.hpp"
 
 #include <QDebug>
+#include <QMutexLocker>
 #include <cmath>
 #include <cstdlib>
 
@@ -88,7 +89,10 @@ static const TopLevelTriangle icosahedron_triangles[20] =
         {{ 8, 9, 5}}  //  8
     };
 
-StelGeodesicGrid::StelGeodesicGrid(const int lev) : maxLevel(lev<0?0:lev), lastMaxSearchlevel(-1)
+const int StelGeodesicGrid::SearchCacheSize;
+
+StelGeodesicGrid::StelGeodesicGrid(const int lev)
+	: maxLevel(lev<0?0:lev), searchMargin(0.00005), searchCacheHits(0), searchCacheMisses(0)
 {
 	if (maxLevel > 0)
 	{
@@ -112,7 +116,6 @@ StelGeodesicGrid::StelGeodesicGrid(const int lev) : maxLevel(lev<0?0:lev), lastM
 	{
 		triangles = 0;
 	}
-	cacheSearchResult = new GeodesicSearchResult(*this);
 }
 
 StelGeodesicGrid::~StelGeodesicGrid(void)
@@ -122,8 +125,6 @@ StelGeodesicGrid::~StelGeodesicGrid(void)
 		for (int i=maxLevel-1;i>=0;i--) delete[] triangles[i];
 		delete[] triangles;
 	}
-	delete cacheSearchResult;
-	cacheSearchResult = Q_NULLPTR;
 }
 
 void StelGeodesicGrid::getTriangleCorners(int lev,int index,
@@ -310,10 +311,17 @@ int StelGeodesicGrid::getZoneNumberForPoint(const Vec3f &v,int searchLevel) cons
 }
 
 
+// 1: v is inside the half space by more than margin, -1: outside by more than margin, 0: on the border
+static inline signed char classifyCorner(const SphericalCap& half_space, const Vec3f& v, double margin)
+{
+	const double dist = v[0]*half_space.n[0]+v[1]*half_space.n[1]+v[2]*half_space.n[2]-half_space.d;
+	return (dist >= margin) ? 1 : ((dist < -margin) ? -1 : 0);
+}
+
 // First iteration on the icosahedron base triangles
 void StelGeodesicGrid::searchZones(const QVector<SphericalCap>& convex,
-                               int **inside_list,int **border_list,
-                               int maxSearchLevel) const
+                               QVector<int> *inside_list,QVector<int> *border_list,
+                               int maxSearchLevel,double margin) const
 {
 	if (maxSearchLevel < 0) maxSearchLevel = 0;
 	else if (maxSearchLevel > maxLevel) maxSearchLevel = maxLevel;
@@ -324,17 +332,17 @@ void StelGeodesicGrid::searchZones(const QVector<SphericalCap>& convex,
 #endif
 	for (int h=0;h<(int)convex.size();h++) {halfs_used[h] = h;}
 #if defined __STRICT_ANSI__ || !defined __GNUC__
-	bool *corner_inside[12];
-	for(int ci=0; ci < 12; ci++) corner_inside[ci]= new bool[convex.size()];
+	signed char *corner_inside[12];
+	for(int ci=0; ci < 12; ci++) corner_inside[ci]= new signed char[convex.size()];
 #else
-	bool corner_inside[12][convex.size()];
+	signed char corner_inside[12][convex.size()];
 #endif
 	for (int h=0;h<convex.size();h++)
 	{
 		const SphericalCap& half_space(convex.at(h));
 		for (int i=0;i<12;i++)
 		{
-			corner_inside[i][h] = half_space.contains(icosahedron_corners[i]);
+			corner_inside[i][h] = classifyCorner(half_space, icosahedron_corners[i], margin);
 		}
 	}
 	for (int i=0;i<20;i++)
@@ -344,7 +352,7 @@ void StelGeodesicGrid::searchZones(const QVector<SphericalCap>& convex,
 		            corner_inside[icosahedron_triangles[i].corners[0]],
 		            corner_inside[icosahedron_triangles[i].corners[1]],
 		            corner_inside[icosahedron_triangles[i].corners[2]],
-		            inside_list,border_list,maxSearchLevel);
+		            inside_list,border_list,maxSearchLevel,margin);
 	}
 #if defined __STRICT_ANSI__ || !defined __GNUC__
 	delete[] halfs_used;
@@ -356,11 +364,11 @@ void StelGeodesicGrid::searchZones(int lev,int index,
 								   const QVector<SphericalCap>&convex,
                                const int *indexOfUsedSphericalCaps,
                                const int halfSpacesUsed,
-                               const bool *corner0_inside,
-                               const bool *corner1_inside,
-                               const bool *corner2_inside,
-                               int **inside_list,int **border_list,
-                               const int maxSearchLevel) const
+                               const signed char *corner0_inside,
+                               const signed char *corner1_inside,
+                               const signed char *corner2_inside,
+                               QVector<int> *inside_list,QVector<int> *border_list,
+                               const int maxSearchLevel,const double margin) const
 {
 #if defined __STRICT_ANSI__ || !defined __GNUC__
 	int *halfs_used = new int[halfSpacesUsed];
@@ -371,12 +379,12 @@ void StelGeodesicGrid::searchZones(int lev,int index,
 	for (int h=0;h<halfSpacesUsed;h++)
 	{
 		const int i = indexOfUsedSphericalCaps[h];
-		if (!corner0_inside[i] && !corner1_inside[i] && !corner2_inside[i])
+		if (corner0_inside[i] < 0 && corner1_inside[i] < 0 && corner2_inside[i] < 0)
 		{
 			// totally outside this SphericalCap
 			goto end;
 		}
-		else if (corner0_inside[i] && corner1_inside[i] && corner2_inside[i])
+		else if (corner0_inside[i] > 0 && corner1_inside[i] > 0 && corner2_inside[i] > 0)
 		{
 			// totally inside this SphericalCap
 		}
@@ -389,13 +397,11 @@ void StelGeodesicGrid::searchZones(int lev,int index,
 	if (halfs_used_count == 0)
 	{
 		// this triangle(lev,index) lies inside all halfspaces
-		**inside_list = index;
-		(*inside_list)++;
+		inside_list->append(index);
 	}
 	else
 	{
-		(*border_list)--;
-		**border_list = index;
+		border_list->append(index);
 		if (lev < maxSearchLevel)
 		{
 			const Triangle &t(triangles[lev][index]);
@@ -404,38 +410,38 @@ void StelGeodesicGrid::searchZones(int lev,int index,
 			inside_list++;
 			border_list++;
 #if defined __STRICT_ANSI__ || !defined __GNUC__
-			bool *edge0_inside = new bool[convex.size()];
-			bool *edge1_inside = new bool[convex.size()];
-			bool *edge2_inside = new bool[convex.size()];
+			signed char *edge0_inside = new signed char[convex.size()];
+			signed char *edge1_inside = new signed char[convex.size()];
+			signed char *edge2_inside = new signed char[convex.size()];
 #else
-			bool edge0_inside[convex.size()];
-			bool edge1_inside[convex.size()];
-			bool edge2_inside[convex.size()];
+			signed char edge0_inside[convex.size()];
+			signed char edge1_inside[convex.size()];
+			signed char edge2_inside[convex.size()];
 #endif
 			for (int h=0;h<halfs_used_count;h++)
 			{
 				const int i = halfs_used[h];
 				const SphericalCap& half_space(convex.at(i));
-				edge0_inside[i] = half_space.contains(t.e0);
-				edge1_inside[i] = half_space.contains(t.e1);
-				edge2_inside[i] = half_space.contains(t.e2);
+				edge0_inside[i] = classifyCorner(half_space, t.e0, margin);
+				edge1_inside[i] = classifyCorner(half_space, t.e1, margin);
+				edge2_inside[i] = classifyCorner(half_space, t.e2, margin);
 			}
 			searchZones(lev,index+0,
 			            convex,halfs_used,halfs_used_count,
 			            corner0_inside,edge2_inside,edge1_inside,
-			            inside_list,border_list,maxSearchLevel);
+			            inside_list,border_list,maxSearchLevel,margin);
 			searchZones(lev,index+1,
 			            convex,halfs_used,halfs_used_count,
 			            edge2_inside,corner1_inside,edge0_inside,
-			            inside_list,border_list,maxSearchLevel);
+			            inside_list,border_list,maxSearchLevel,margin);
 			searchZones(lev,index+2,
 			            convex,halfs_used,halfs_used_count,
 			            edge1_inside,edge0_inside,corner2_inside,
-			            inside_list,border_list,maxSearchLevel);
+			            inside_list,border_list,maxSearchLevel,margin);
 			searchZones(lev,index+3,
 			            convex,halfs_used,halfs_used_count,
 			            edge0_inside,edge1_inside,edge2_inside,
-			            inside_list,border_list,maxSearchLevel);
+			            inside_list,border_list,maxSearchLevel,margin);
 #if defined __STRICT_ANSI__ || !defined __GNUC__
 			delete[] edge0_inside;
 			delete[] edge1_inside;
@@ -450,64 +456,119 @@ end:
 	return;
 }
 
+// Whether the half spaces of the two regions differ by at most margin
+static bool isWithinMargin(const QVector<SphericalCap>& r1, const QVector<SphericalCap>& r2, double margin)
+{
+	if (r1.size()!=r2.size())
+		return false;
+	for (int i=0;i<r1.size();i++)
+	{
+		const SphericalCap& c1 = r1.at(i);
+		const SphericalCap& c2 = r2.at(i);
+		if ((c1.n-c2.n).length()+std::fabs(c1.d-c2.d) > margin)
+			return false;
+	}
+	return true;
+}
+
 /*************************************************************************
  Return a search result matching the given spatial region
 *************************************************************************/
-const GeodesicSearchResult* StelGeodesicGrid::search(const QVector<SphericalCap>& convex, int maxSearchLevel) const
+GeodesicSearchResultP StelGeodesicGrid::search(const QVector<SphericalCap>& convex, int maxSearchLevel) const
 {
-	// Try to use the cached version
-	if (maxSearchLevel==lastMaxSearchlevel && convex==lastSearchRegion)
+	double margin;
 	{
-		return cacheSearchResult;
+		QMutexLocker locker(&searchCacheMutex);
+		margin = searchMargin;
+		// Try to use a cached version
+		for (int i=0;i<searchCache.size();i++)
+		{
+			const CachedSearch& entry = searchCache.at(i);
+			if (entry.maxSearchLevel==maxSearchLevel && isWithinMargin(entry.region, convex, margin))
+			{
+				searchCacheHits++;
+				if (i>0)
+					searchCache.move(i, 0);
+				return searchCache.first().result;
+			}
+		}
+		searchCacheMisses++;
 	}
-	// Else recompute it and update cache parameters
-	lastMaxSearchlevel = maxSearchLevel;
-	lastSearchRegion = convex;
-	cacheSearchResult->search(convex, maxSearchLevel);
-	return cacheSearchResult;
-}
 
+	// Else recompute it without holding the lock, so that other threads can still use the cache
+	GeodesicSearchResult* result = new GeodesicSearchResult(*this);
+	result->search(*this, convex, maxSearchLevel, margin);
+	CachedSearch entry;
+	entry.region = convex;
+	entry.maxSearchLevel = maxSearchLevel;
+	entry.result = GeodesicSearchResultP(result);
 
-GeodesicSearchResult::GeodesicSearchResult(const StelGeodesicGrid &grid)
-		:grid(grid),
-		zones(new int*[grid.getMaxLevel()+1]),
-		inside(new int*[grid.getMaxLevel()+1]),
-		border(new int*[grid.getMaxLevel()+1])
-{
-	for (int i=0;i<=grid.getMaxLevel();i++)
+	QMutexLocker locker(&searchCacheMutex);
+	// Results computed with another margin can't be reused
+	if (margin==searchMargin)
 	{
-		zones[i] = new int[StelGeodesicGrid::nrOfZones(i)];
+		searchCache.prepend(entry);
+		while (searchCache.size()>SearchCacheSize)
+			searchCache.removeLast();
 	}
+	return entry.result;
 }
 
-GeodesicSearchResult::~GeodesicSearchResult(void)
+void StelGeodesicGrid::setSearchMargin(double margin)
 {
-	for (int i=grid.getMaxLevel();i>=0;i--)
+	QMutexLocker locker(&searchCacheMutex);
+	if (margin<0.)
+		margin = 0.;
+	if (margin!=searchMargin)
 	{
-		delete[] zones[i];
+		searchMargin = margin;
+		searchCache.clear();
 	}
-	delete[] border;
-	delete[] inside;
-	delete[] zones;
 }
 
-void GeodesicSearchResult::search(const QVector<SphericalCap>& convex, int maxSearchLevel)
+double StelGeodesicGrid::getSearchMargin(void) const
+{
+	QMutexLocker locker(&searchCacheMutex);
+	return searchMargin;
+}
+
+int StelGeodesicGrid::getSearchCacheHits(void) const
+{
+	QMutexLocker locker(&searchCacheMutex);
+	return searchCacheHits;
+}
+
+int StelGeodesicGrid::getSearchCacheMisses(void) const
+{
+	QMutexLocker locker(&searchCacheMutex);
+	return searchCacheMisses;
+}
+
+
+GeodesicSearchResult::GeodesicSearchResult(const StelGeodesicGrid &grid)
+		:maxLevel(grid.getMaxLevel()),
+		inside(grid.getMaxLevel()+1),
+		border(grid.getMaxLevel()+1)
+{
+}
+
+void GeodesicSearchResult::search(const StelGeodesicGrid &grid, const QVector<SphericalCap>& convex, int maxSearchLevel, double margin)
 {
-	for (int i=grid.getMaxLevel();i>=0;i--)
+	for (int i=maxLevel;i>=0;i--)
 	{
-		inside[i] = zones[i];
-		border[i] = zones[i]+StelGeodesicGrid::nrOfZones(i);
+		inside[i].clear();
+		border[i].clear();
 	}
-	grid.searchZones(convex,inside,border,maxSearchLevel);
+	grid.searchZones(convex,inside.data(),border.data(),maxSearchLevel,margin);
 }
 
 void GeodesicSearchInsideIterator::reset(void)
 {
 	level = 0;
 	maxCount = 1<<(maxLevel<<1); // 4^maxLevel
-	indexP = r.zones[0];
-	endP = r.inside[0];
-	index = (*indexP) * maxCount;
+	indexP = r.inside[0].constData();
+	endP = indexP+r.inside[0].size();
+	index = (indexP < endP) ? (*indexP) * maxCount : 0;
 	count = (indexP < endP) ? 0 : maxCount;
 }
 
@@ -525,8 +586,8 @@ int GeodesicSearchInsideIterator::next(void)
 	{
 		level++;
 		maxCount >>= 2;
-		indexP = r.zones[level];
-		endP = r.inside[level];
+		indexP = r.inside[level].constData();
+		endP = indexP+r.inside[level].size();
 		if (indexP < endP)
 		{
 			index = (*indexP) * maxCount;
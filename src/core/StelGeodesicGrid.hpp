@@ -37,7 +37,12 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 
 #include "StelSphereGeometry.hpp"
 
+#include <QList>
+#include <QMutex>
+
 class GeodesicSearchResult;
+//! Search results are never modified once computed, so they can be shared between threads
+typedef QSharedPointer<const GeodesicSearchResult> GeodesicSearchResultP;
 
 //! @class StelGeodesicGrid
 //! Grid of triangles (zones) on the sphere with radius 1, generated by subdividing the icosahedron.
@@ -77,9 +82,27 @@ public:
 	int getPartnerTriangle(int lev, int index) const;
 	
 	//! Return a search result matching the given spatial region
-	//! The result is cached, meaning that it is very fast to search the same region consecutively
+	//! The results of the last SearchCacheSize searches are cached, meaning that it is very fast to search
+	//! the same regions again, or regions which moved by less than the search margin (see setSearchMargin()).
+	//! This method can be called from several threads at the same time.
 	//! @return a GeodesicSearchResult instance which must be used with GeodesicSearchBorderIterator and GeodesicSearchInsideIterator
-	const GeodesicSearchResult* search(const QVector<SphericalCap>& convex, int maxSearchLevel) const;
+	GeodesicSearchResultP search(const QVector<SphericalCap>& convex, int maxSearchLevel) const;
+
+	//! Set the margin of the search, in units of the half space parameters.
+	//! A zone is only classified as inside (outside) a half space when its corners are inside (outside)
+	//! by more than the margin, the others are border zones. A search result then remains valid for all
+	//! regions whose half spaces differ by less than the margin (|n'-n|+|d'-d| <= margin), so that a slowly
+	//! moving viewport reuses the result of the previous frame. Set 0 to only reuse results of identical regions.
+	//! Changing the margin clears the cache.
+	void setSearchMargin(double margin);
+	double getSearchMargin(void) const;
+
+	//! Number of searches answered from the cache, and number of searches computed
+	int getSearchCacheHits(void) const;
+	int getSearchCacheMisses(void) const;
+
+	//! Maximum number of cached search results
+	static const int SearchCacheSize = 8;
 
 private:
 	friend class GeodesicSearchResult;
@@ -90,17 +113,16 @@ private:
 	//! each half space. If this is not the case,
 	//! the result may be inaccurate, because it is assumed, that
 	//! a zone lies in a half space when its 3 corners lie in this half space.
-	//! inside[l] points to the begin of an integer array of size nrOfZones(l),
-	//! border[l] points to one after the end of the same integer array.
-	//! The array will be filled from the beginning with the inside zone numbers
-	//! and from the end with the border zone numbers of the given level l
+	//! inside[l] and border[l] receive the inside and border zone numbers of the given level l
 	//! for 0<=l<=getMaxLevel().
 	//! inside[l] will not contain zones that are already contained
 	//! in inside[l1] for some l1 < l.
 	//! In order to restrict search depth set maxSearchLevel < maxLevel,
-	//! for full search depth set maxSearchLevel = maxLevel,
+	//! for full search depth set maxSearchLevel = maxLevel.
+	//! Corners closer than margin to the border of a half space are considered to be on the border.
 	void searchZones(const QVector<SphericalCap>& convex,
-					 int **inside,int **border,int maxSearchLevel) const;
+					 QVector<int> *inside,QVector<int> *border,
+					 int maxSearchLevel,double margin) const;
 	
 	const Vec3f& getTriangleCorner(int lev, int index, int cornerNumber) const;
 	void initTriangle(int lev,int index,
@@ -118,10 +140,11 @@ private:
 	                 const QVector<SphericalCap>& convex,
 	                 const int *indexOfUsedSphericalCaps,
 	                 const int halfSpacesUsed,
-	                 const bool *corner0_inside,
-	                 const bool *corner1_inside,
-	                 const bool *corner2_inside,
-	                 int **inside,int **border,int maxSearchLevel) const;
+	                 const signed char *corner0_inside,
+	                 const signed char *corner1_inside,
+	                 const signed char *corner2_inside,
+	                 QVector<int> *inside,QVector<int> *border,
+	                 int maxSearchLevel,double margin) const;
 
 	const int maxLevel;
 	struct Triangle
@@ -132,41 +155,50 @@ private:
 	// 20*(4^0+4^1+...+4^n)=20*(4*(4^n)-1)/3 triangles total
 	// 2+10*4^n corners
 	
-	//! A cached search result used to avoid doing twice the same search
-	mutable GeodesicSearchResult* cacheSearchResult;
-	mutable int lastMaxSearchlevel;
-	mutable QVector<SphericalCap> lastSearchRegion;
+	struct CachedSearch
+	{
+		QVector<SphericalCap> region;
+		int maxSearchLevel;
+		GeodesicSearchResultP result;
+	};
+	//! The cached search results used to avoid doing twice the same search, most recently used first
+	mutable QList<CachedSearch> searchCache;
+	//! Protects the cache, the margin and the counters
+	mutable QMutex searchCacheMutex;
+	double searchMargin;
+	mutable int searchCacheHits;
+	mutable int searchCacheMisses;
 };
 
 class GeodesicSearchResult
 {
 public:
 	GeodesicSearchResult(const StelGeodesicGrid &grid);
-	~GeodesicSearchResult(void);
 	void print(void) const;
 private:
 	friend class GeodesicSearchInsideIterator;
 	friend class GeodesicSearchBorderIterator;
 	friend class StelGeodesicGrid;
 	
-	void search(const QVector<SphericalCap>& convex, int maxSearchLevel);
+	void search(const StelGeodesicGrid &grid, const QVector<SphericalCap>& convex, int maxSearchLevel, double margin);
 	
-	const StelGeodesicGrid &grid;
-	int **const zones;
-	int **const inside;
-	int **const border;
+	//! The grid may be deleted before its search results, so only its level is kept
+	const int maxLevel;
+	//! The inside and border zones of each level
+	QVector<QVector<int> > inside;
+	QVector<QVector<int> > border;
 };
 
 class GeodesicSearchBorderIterator
 {
 public:
 	GeodesicSearchBorderIterator(const GeodesicSearchResult &ar,int alevel)
-		: r(ar),level((alevel<0)?0:(alevel>ar.grid.getMaxLevel())
-			             ?ar.grid.getMaxLevel():alevel),
-			end(ar.zones[GeodesicSearchBorderIterator::level]+
-			    StelGeodesicGrid::nrOfZones(GeodesicSearchBorderIterator::level))
+		: r(ar),level((alevel<0)?0:(alevel>ar.maxLevel)
+			             ?ar.maxLevel:alevel),
+			end(ar.border[GeodesicSearchBorderIterator::level].constData()+
+			    ar.border[GeodesicSearchBorderIterator::level].size())
 	{reset();}
-	void reset(void) {index = r.border[level];}
+	void reset(void) {index = r.border[level].constData();}
 	int next(void) // returns -1 when finished
 	{if (index < end) {return *index++;} return -1;}
 private:
@@ -182,7 +214,7 @@ class GeodesicSearchInsideIterator
 public:
 	GeodesicSearchInsideIterator(const GeodesicSearchResult &ar,int alevel)
 		: 	r(ar), 
-			maxLevel((alevel<0)?0:(alevel>ar.grid.getMaxLevel())?ar.grid.getMaxLevel():alevel)
+			maxLevel((alevel<0)?0:(alevel>ar.maxLevel)?ar.maxLevel:alevel)
 	{reset();}
 	void reset(void);
 	int next(void); // returns -1 when finished
@@ -191,8 +223,8 @@ private:
 	const int maxLevel;
 	int level;
 	int maxCount;
-	int *indexP;
-	int *endP;
+	const int *indexP;
+	const int *endP;
 	int index;
 	int count;
 };
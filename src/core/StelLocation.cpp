@@ -17,8 +17,10 @@
  */
 
 #include "StelLocation.hpp"
+#ifndef UNIT_TEST
 #include "StelLocationMgr.hpp"
 #include "StelLocaleMgr.hpp"
+#endif
 #include "StelUtils.hpp"
 #include <QTimeZone>
 #include <QStringList>
@@ -33,6 +35,8 @@ int StelLocation::initMetaType()
 	return id;
 }
 
+#ifndef UNIT_TEST
+// NOTE: The line format needs the location database, tests only use the data stream serialization
 // Output the location as a string ready to be stored in the user_location file
 QString StelLocation::serializeToLine() const
 {
@@ -51,6 +55,7 @@ QString StelLocation::serializeToLine() const
 			.arg(planetName)
 			.arg(landscapeKey);
 }
+#endif
 
 QString StelLocation::getID() const
 {
@@ -76,6 +81,7 @@ QDataStream& operator>>(QDataStream& in, StelLocation& loc)
 	return in;
 }
 
+#ifndef UNIT_TEST
 // Parse a location from a line serialization
 StelLocation StelLocation::createFromLine(const QString& rawline)
 {
@@ -146,6 +152,7 @@ StelLocation StelLocation::createFromLine(const QString& rawline)
 	}
 	return loc;
 }
+#endif
 
 // Compute great-circle distance between two locations
 float StelLocation::distanceDegrees(const float long1, const float lat1, const float long2, const float lat2)
@@ -0,0 +1,176 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "StelLocationIndex.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Grid used by the spatial index: rows of 1 degree in latitude, columns of 1 degree in longitude.
+static const int GRID_ROWS=180;
+static const int GRID_COLS=360;
+
+static inline int gridRow(float latitude)
+{
+	return qBound(0, static_cast<int>(std::floor(latitude+90.f)), GRID_ROWS-1);
+}
+
+static inline int gridCol(float longitude)
+{
+	float lng=std::fmod(longitude+180.f, 360.f);
+	if (lng<0.f)
+		lng+=360.f;
+	return qBound(0, static_cast<int>(lng), GRID_COLS-1);
+}
+
+static bool cellLessThan(const QPair<int, int>& a, const QPair<int, int>& b)
+{
+	return a.first<b.first;
+}
+
+float StelLocationIndex::squaredChord(const float degrees)
+{
+	const float s=2.f*std::sin(0.5f*degrees*static_cast<float>(M_PI/180.));
+	return s*s;
+}
+
+void StelLocationIndex::clear()
+{
+	locationGrids.clear();
+	countryIndex.clear();
+}
+
+void StelLocationIndex::build(const QMap<QString, StelLocation>& locations)
+{
+	clear();
+
+	// Gather entries per planet, keeping their cell number for sorting.
+	const float DEGREES=M_PI/180.0f;
+	QHash<QString, QVector<IndexedLocation> > entries;
+	QHash<QString, QVector<QPair<int, int> > > cells;
+	for (QMap<QString, StelLocation>::ConstIterator iter=locations.constBegin();iter!=locations.constEnd();++iter)
+	{
+		const StelLocation& loc=iter.value();
+		IndexedLocation e;
+		e.id=iter.key();
+		const float cosLat=std::cos(loc.latitude*DEGREES);
+		e.x=cosLat*std::cos(loc.longitude*DEGREES);
+		e.y=cosLat*std::sin(loc.longitude*DEGREES);
+		e.z=std::sin(loc.latitude*DEGREES);
+		QVector<IndexedLocation>& planetEntries=entries[loc.planetName];
+		cells[loc.planetName].append(qMakePair(gridRow(loc.latitude)*GRID_COLS+gridCol(loc.longitude), planetEntries.size()));
+		planetEntries.append(e);
+		countryIndex[loc.country].append(iter.key());
+	}
+
+	for (QHash<QString, QVector<IndexedLocation> >::ConstIterator iter=entries.constBegin();iter!=entries.constEnd();++iter)
+	{
+		QVector<QPair<int, int> >& planetCells=cells[iter.key()];
+		std::stable_sort(planetCells.begin(), planetCells.end(), cellLessThan);
+
+		LocationGrid& grid=locationGrids[iter.key()];
+		grid.entries.reserve(planetCells.size());
+		grid.cellStart.fill(0, GRID_ROWS*GRID_COLS+1);
+		for (int i=0; i<planetCells.size(); ++i)
+		{
+			grid.entries.append(iter.value().at(planetCells.at(i).second));
+			grid.cellStart[planetCells.at(i).first+1]++;
+		}
+		for (int c=0; c<GRID_ROWS*GRID_COLS; ++c)
+			grid.cellStart[c+1]+=grid.cellStart[c];
+	}
+}
+
+QVector<QPair<float, QString> > StelLocationIndex::findWithin(const QString& planetName, const float longitude, const float latitude, const float radiusDegrees) const
+{
+	QVector<QPair<float, QString> > results;
+	QHash<QString, LocationGrid>::ConstIterator gridIter=locationGrids.constFind(planetName);
+	if (gridIter==locationGrids.constEnd() || radiusDegrees<0.f)
+		return results;
+	const LocationGrid& grid=gridIter.value();
+
+	const float DEGREES=M_PI/180.0f;
+	const float cosLat=std::cos(latitude*DEGREES);
+	const float x=cosLat*std::cos(longitude*DEGREES);
+	const float y=cosLat*std::sin(longitude*DEGREES);
+	const float z=std::sin(latitude*DEGREES);
+	const bool acceptAll=(radiusDegrees>=180.f);
+	const float maxChord=squaredChord(radiusDegrees);
+
+	// Rows covered by the search cap, and its half-width in longitude (all columns if it contains a pole).
+	const int rowMin=gridRow(latitude-radiusDegrees);
+	const int rowMax=gridRow(latitude+radiusDegrees);
+	float halfWidth=180.f;
+	if (!acceptAll && std::fabs(latitude)+radiusDegrees<90.f)
+		halfWidth=std::asin(qMin(1.f, std::sin(radiusDegrees*DEGREES)/cosLat))/DEGREES;
+	const bool allCols=(halfWidth>=179.f);
+	const int colMin=allCols ? 0 : static_cast<int>(std::floor(longitude-halfWidth+180.f));
+	const int colMax=allCols ? GRID_COLS-1 : static_cast<int>(std::floor(longitude+halfWidth+180.f));
+
+	for (int row=rowMin; row<=rowMax; ++row)
+	{
+		for (int col=colMin; col<=colMax; ++col)
+		{
+			const int cell=row*GRID_COLS+((col%GRID_COLS)+GRID_COLS)%GRID_COLS;
+			for (int i=grid.cellStart.at(cell); i<grid.cellStart.at(cell+1); ++i)
+			{
+				const IndexedLocation& e=grid.entries.at(i);
+				// The chord is computed from the differences, so that nearby positions do not lose
+				// their precision like the cosine of their distance does.
+				const float dx=x-e.x;
+				const float dy=y-e.y;
+				const float dz=z-e.z;
+				const float chord=dx*dx+dy*dy+dz*dz;
+				if (acceptAll || chord<=maxChord)
+					results.append(qMakePair(chord, e.id));
+			}
+		}
+	}
+	return results;
+}
+
+QStringList StelLocationIndex::findNearest(const QString& planetName, const float longitude, const float latitude, const int count) const
+{
+	QStringList results;
+	if (count<=0 || !locationGrids.contains(planetName))
+		return results;
+
+	// Grow the search radius until enough locations are found. Everything outside the radius is farther away
+	// than everything inside, so the closest ones of the last search are the closest overall.
+	QVector<QPair<float, QString> > found;
+	float radius=1.f;
+	while (true)
+	{
+		found=findWithin(planetName, longitude, latitude, radius);
+		if (found.size()>=count || radius>=180.f)
+			break;
+		radius=qMin(180.f, radius*4.f);
+	}
+	// Equally distant locations are sorted by their ID.
+	std::sort(found.begin(), found.end());
+	for (int i=0; i<qMin(count, found.size()); ++i)
+		results.append(found.at(i).second);
+	return results;
+}
+
+QStringList StelLocationIndex::findInCountry(const QString& country) const
+{
+	return countryIndex.value(country);
+}
@@ -0,0 +1,81 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _STELLOCATIONINDEX_HPP_
+#define _STELLOCATIONINDEX_HPP_
+
+#include "StelLocation.hpp"
+
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//! @class StelLocationIndex
+//! Spatial and country index over the locations of the StelLocationMgr.
+//! The locations of each planet are sorted into a latitude/longitude grid of 1x1 degree cells,
+//! so that radius queries only test the locations in the grid cells overlapped by the search cap.
+class StelLocationIndex
+{
+public:
+	//! Rebuild the index for the given locations, mapped by their ID.
+	void build(const QMap<QString, StelLocation>& locations);
+	//! Remove all locations from the index.
+	void clear();
+
+	//! Find the locations of @param planetName within @param radiusDegrees of the given coordinates.
+	//! Returned pairs contain the squared chord length between the unit vectors of both positions
+	//! (see squaredChord()) and the location ID, in no particular order.
+	QVector<QPair<float, QString> > findWithin(const QString& planetName, const float longitude, const float latitude, const float radiusDegrees) const;
+	//! Find the IDs of the @param count locations of @param planetName closest to the given coordinates,
+	//! sorted by increasing distance. Returns all locations of the planet if there are fewer.
+	QStringList findNearest(const QString& planetName, const float longitude, const float latitude, const int count) const;
+	//! Find the IDs of the locations in @param country.
+	QStringList findInCountry(const QString& country) const;
+
+	//! Squared chord length between unit vectors which are @param degrees apart.
+	//! Unlike the cosine, it keeps its precision in floats for nearby positions.
+	static float squaredChord(const float degrees);
+
+private:
+	//! An entry of the spatial index: location ID and its position as unit vector on the planet.
+	struct IndexedLocation
+	{
+		QString id;
+		float x, y, z;
+	};
+	//! Spatial index of the locations of one planet.
+	struct LocationGrid
+	{
+		//! Locations sorted by grid cell.
+		QVector<IndexedLocation> entries;
+		//! Index of the first entry of each cell in entries (GRID_ROWS*GRID_COLS+1 values).
+		QVector<int> cellStart;
+	};
+
+	//! Per-planet spatial index over locations
+	QHash<QString, LocationGrid> locationGrids;
+	//! Country name -> IDs of all locations in that country
+	QHash<QString, QStringList> countryIndex;
+};
+
+#endif // _STELLOCATIONINDEX_HPP_
@@ -296,7 +296,7 @@ void NMEALookupHelper::nmeaTimeout()
 #endif
 
 StelLocationMgr::StelLocationMgr()
-	: nmeaHelper(Q_NULLPTR), libGpsHelper(Q_NULLPTR)
+	: indexDirty(true), nmeaHelper(Q_NULLPTR), libGpsHelper(Q_NULLPTR)
 {
 	// initialize the static QMap first if necessary.
 	if (locationDBToIANAtranslations.count()==0)
@@ -359,7 +359,7 @@ StelLocationMgr::~StelLocationMgr()
 }
 
 StelLocationMgr::StelLocationMgr(const LocationList &locations)
-	: nmeaHelper(Q_NULLPTR), libGpsHelper(Q_NULLPTR)
+	: indexDirty(true), nmeaHelper(Q_NULLPTR), libGpsHelper(Q_NULLPTR)
 {
 	setLocations(locations);
 
@@ -374,6 +374,7 @@ void StelLocationMgr::setLocations(const LocationList &locations)
 	{
 		this->locations.insert(it->getID(),*it);
 	}
+	indexDirty=true;
 
 	emit locationListChanged();
 }
@@ -597,6 +598,7 @@ bool StelLocationMgr::saveUserLocation(const StelLocation& loc)
 
 	// Add in the program
 	locations[loc.getID()]=loc;
+	indexDirty=true;
 
 	//emit before saving the list
 	emit locationListChanged();
@@ -655,6 +657,7 @@ bool StelLocationMgr::deleteUserLocation(const QString& id)
 		return false;
 
 	locations.remove(id);
+	indexDirty=true;
 
 	//emit before saving the list
 	emit locationListChanged();
@@ -813,19 +816,34 @@ void StelLocationMgr::changeLocationFromNetworkLookup()
 	networkReply->deleteLater();
 }
 
+void StelLocationMgr::updateIndex()
+{
+	if (!indexDirty)
+		return;
+	locationIndex.build(locations);
+	indexDirty=false;
+}
+
 LocationMap StelLocationMgr::pickLocationsNearby(const QString planetName, const float longitude, const float latitude, const float radiusDegrees)
 {
 	QMap<QString, StelLocation> results;
-	QMapIterator<QString, StelLocation> iter(locations);
-	while (iter.hasNext())
+	updateIndex();
+	const QVector<QPair<float, QString> >& found=locationIndex.findWithin(planetName, longitude, latitude, radiusDegrees);
+	for (QVector<QPair<float, QString> >::ConstIterator iter=found.constBegin();iter!=found.constEnd();++iter)
 	{
-		iter.next();
-		const StelLocation *loc=&iter.value();
-		if ( (loc->planetName == planetName) &&
-				(StelLocation::distanceDegrees(longitude, latitude, loc->longitude, loc->latitude) <= radiusDegrees) )
-		{
-			results.insert(iter.key(), iter.value());
-		}
+		results.insert(iter->second, locations.value(iter->second));
+	}
+	return results;
+}
+
+LocationList StelLocationMgr::pickNearestLocations(const QString planetName, const float longitude, const float latitude, const int count)
+{
+	LocationList results;
+	updateIndex();
+	const QStringList& ids=locationIndex.findNearest(planetName, longitude, latitude, count);
+	for (QStringList::ConstIterator iter=ids.constBegin();iter!=ids.constEnd();++iter)
+	{
+		results.append(locations.value(*iter));
 	}
 	return results;
 }
@@ -833,15 +851,11 @@ LocationMap StelLocationMgr::pickLocationsNearby(const QString planetName, const
 LocationMap StelLocationMgr::pickLocationsInCountry(const QString country)
 {
 	QMap<QString, StelLocation> results;
-	QMapIterator<QString, StelLocation> iter(locations);
-	while (iter.hasNext())
+	updateIndex();
+	const QStringList& ids=locationIndex.findInCountry(country);
+	for (QStringList::ConstIterator iter=ids.constBegin();iter!=ids.constEnd();++iter)
 	{
-		iter.next();
-		const StelLocation *loc=&iter.value();
-		if (loc->country == country)
-		{
-			results.insert(iter.key(), iter.value());
-		}
+		results.insert(*iter, locations.value(*iter));
 	}
 	return results;
 }
@@ -20,6 +20,7 @@
 #define _STELLOCATIONMGR_HPP_
 
 #include "StelLocation.hpp"
+#include "StelLocationIndex.hpp"
 #include <QString>
 #include <QObject>
 #include <QMetaType>
@@ -79,7 +80,10 @@ public:
 	bool deleteUserLocation(const QString& id);
 
 	//! Find list of locations within @param radiusDegrees of selected (usually screen-clicked) coordinates.
+	//! Uses a latitude/longitude grid index, so that only locations in nearby grid cells are tested.
 	LocationMap pickLocationsNearby(const QString planetName, const float longitude, const float latitude, const float radiusDegrees);
+	//! Find the @param count locations closest to the given coordinates, sorted by increasing distance.
+	LocationList pickNearestLocations(const QString planetName, const float longitude, const float latitude, const int count);
 	//! Find list of locations in a particular country only.
 	LocationMap pickLocationsInCountry(const QString country);
 
@@ -134,8 +138,15 @@ private:
 	static LocationMap loadCities(const QString& fileName, bool isUserLocation);
 	static LocationMap loadCitiesBin(const QString& fileName);
 
+	//! Rebuild the spatial and country indices if the list of locations has been changed.
+	void updateIndex();
+
 	//! The list of all loaded locations
 	LocationMap locations;
+	//! Spatial and country index over locations
+	StelLocationIndex locationIndex;
+	//! Set when locations changed, so that indices get rebuilt before the next query
+	bool indexDirty;
 	//! A Map which has to be used to replace, system- and Qt-version dependent,
 	//! timezone names from our location database to the code names currently used by Qt.
 	//! Required to avoid https://bugs.launchpad.net/stellarium/+bug/1662132,
@@ -0,0 +1,97 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "StelMarkerBatch.hpp"
+#include "StelApp.hpp"
+#include "StelPainter.hpp"
+#include "StelProjector.hpp"
+#include "StelTexture.hpp"
+
+StelMarkerBatch::StelMarkerBatch()
+	: radiusScale(1.f)
+{
+}
+
+void StelMarkerBatch::begin(const StelProjectorP& projector)
+{
+	prj = projector;
+	radiusScale = prj->getDevicePixelsPerPixel()*StelApp::getInstance().getGlobalScalingRatio();
+	vertices.clear();
+	texCoords.clear();
+	colors.clear();
+	labels.clear();
+}
+
+bool StelMarkerBatch::addMarker(const Vec3d& pos, float radius, const Vec3f& color)
+{
+	Q_ASSERT(prj);
+	Vec3d win;
+	if (!prj->project(pos, win))
+		return false;
+
+	const float x = win[0];
+	const float y = win[1];
+	const float r = radius*radiusScale;
+	const Vec4f c(color[0], color[1], color[2], 1.f);
+
+	vertices << Vec2f(x-r, y-r) << Vec2f(x+r, y-r) << Vec2f(x-r, y+r)
+		 << Vec2f(x+r, y-r) << Vec2f(x+r, y+r) << Vec2f(x-r, y+r);
+	texCoords << Vec2f(0.f, 0.f) << Vec2f(1.f, 0.f) << Vec2f(0.f, 1.f)
+		  << Vec2f(1.f, 0.f) << Vec2f(1.f, 1.f) << Vec2f(0.f, 1.f);
+	for (int i=0; i<6; ++i)
+		colors << c;
+	return true;
+}
+
+void StelMarkerBatch::addLabel(const Vec3d& pos, const QString& text, const Vec3f& color, float shift)
+{
+	Label label;
+	label.pos = pos;
+	label.text = text;
+	label.color = color;
+	label.shift = shift;
+	labels << label;
+}
+
+void StelMarkerBatch::draw(StelPainter& painter, const StelTextureSP& texture)
+{
+	if (!vertices.isEmpty() && texture)
+	{
+		painter.setBlending(true, GL_ONE, GL_ONE);
+		texture->bind();
+		painter.enableClientStates(true, true, true);
+		painter.setVertexPointer(2, GL_FLOAT, vertices.constData());
+		painter.setTexCoordPointer(2, GL_FLOAT, texCoords.constData());
+		painter.setColorPointer(4, GL_FLOAT, colors.constData());
+		painter.drawFromArray(StelPainter::Triangles, vertices.size(), 0, false);
+		painter.enableClientStates(false);
+	}
+
+	Vec3f lastColor(-1.f, -1.f, -1.f);
+	foreach (const Label& label, labels)
+	{
+		if (label.color != lastColor)
+		{
+			painter.setColor(label.color[0], label.color[1], label.color[2], 1.f);
+			lastColor = label.color;
+		}
+		painter.drawText(label.pos, label.text, 0, label.shift, label.shift, false);
+	}
+}
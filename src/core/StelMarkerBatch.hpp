@@ -0,0 +1,90 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _STELMARKERBATCH_HPP_
+#define _STELMARKERBATCH_HPP_
+
+#include "StelProjectorType.hpp"
+#include "StelTextureTypes.hpp"
+#include "VecMath.hpp"
+
+#include <QString>
+#include <QVector>
+
+class StelPainter;
+
+//! @class StelMarkerBatch
+//! Collects the markers and labels of many objects and draws them together.
+//! A marker is a textured square of fixed size on screen, like those drawn with StelPainter::drawSprite2dMode().
+//! All markers of a batch use the same texture and are drawn with a single draw call,
+//! each one with its own color. The labels are drawn after the markers.
+//!
+//! Typical use in the draw() method of a catalog plugin:
+//! @code
+//! batch.begin(prj);
+//! foreach (visible object)
+//! 	batch.addMarker(pos, 5.f, color);
+//! batch.draw(painter, markerTexture);
+//! @endcode
+class StelMarkerBatch
+{
+public:
+	StelMarkerBatch();
+
+	//! Start a new batch for the given projector. Removes the markers and labels of the previous batch.
+	void begin(const StelProjectorP& prj);
+
+	//! Add a marker.
+	//! @param pos the position of the marker in the frame of the projector
+	//! @param radius the half size of the marker in pixels, before the device pixel ratio and global scaling
+	//! @param color the color of the marker
+	//! @return false if the position is not visible, then no marker is added.
+	bool addMarker(const Vec3d& pos, float radius, const Vec3f& color);
+
+	//! Add a label, drawn like StelPainter::drawText(pos, text, 0, shift, shift, false).
+	void addLabel(const Vec3d& pos, const QString& text, const Vec3f& color, float shift);
+
+	//! Draw the markers and labels of the batch. The font of the painter is used for the labels.
+	//! @param texture the marker texture. If it is null, only the labels are drawn.
+	void draw(StelPainter& painter, const StelTextureSP& texture);
+
+	int getMarkerCount() const { return vertices.size()/6; }
+	int getLabelCount() const { return labels.size(); }
+
+private:
+	struct Label
+	{
+		Vec3d pos;
+		QString text;
+		Vec3f color;
+		float shift;
+	};
+
+	StelProjectorP prj;
+	//! Scale of 2D sizes, see StelPainter::drawSprite2dMode()
+	float radiusScale;
+	//! Two triangles per marker, in window coordinates
+	QVector<Vec2f> vertices;
+	QVector<Vec2f> texCoords;
+	QVector<Vec4f> colors;
+	QVector<Label> labels;
+};
+
+#endif // _STELMARKERBATCH_HPP_
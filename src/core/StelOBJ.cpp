@@ -19,22 +19,105 @@
  */
 
 #include "StelApp.hpp"
+#include "StelFileMgr.hpp"
 #include "StelOBJ.hpp"
 #include "StelTextureMgr.hpp"
 #include "StelUtils.hpp"
 
 #include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QRegularExpression>
+#include <QSaveFile>
 #include <QTextStream>
+#include <QThread>
+#include <QtConcurrent>
 
 Q_LOGGING_CATEGORY(stelOBJ,"stel.OBJ")
 
+const quint32 StelOBJ::CACHE_VERSION;
+const int StelOBJ::MIN_CHUNK_SIZE;
+
+//! Identifies StelOBJ cache files
+static const quint32 CACHE_MAGIC = 0x534F424A; // "SOBJ"
+
+//! A line-aligned part of an OBJ file, which is parsed by a worker thread.
+//! The vertex data and the faces are parsed completely. All other statements depend on
+//! the state of the parser (like the current material), so they are only collected, and
+//! handled together with the faces in file order once all chunks are parsed.
+struct StelOBJ::ParseChunk
+{
+	//! The vertex references of a face corner, as given in the file.
+	//! The indices start with 1, are negative if relative, and 0 if not given.
+	struct Corner
+	{
+		int pos;
+		int tex;
+		int norm;
+	};
+
+	struct Face
+	{
+		int lineNr;
+		int firstCorner;
+		int cornerCount;
+		//the numbers of positions, texture coordinates and normals of the chunk before the face,
+		//to resolve relative references
+		int posCount;
+		int texCount;
+		int normCount;
+	};
+
+	//! A statement which is neither vertex data nor a face
+	struct Statement
+	{
+		//the number of faces of the chunk before the statement
+		int faceCount;
+		int lineNr;
+		QString line;
+	};
+
+	ParseChunk()
+		: data(Q_NULLPTR), size(0), vertexOrder(XYZ),
+		  ok(true), errorLineNr(0), lineCount(0), vertexWLine(-1), textureWLine(-1),
+		  posOffset(0), normOffset(0), texOffset(0), lineOffset(0)
+	{
+	}
+
+	const char* data;
+	int size;
+	VertexOrder vertexOrder;
+
+	V3Vec posList;
+	V3Vec normalList;
+	V2Vec texList;
+	QVector<Corner> corners;
+	QVector<Face> faces;
+	QVector<Statement> statements;
+
+	bool ok;
+	int errorLineNr;
+	QString errorLine;
+	int lineCount;
+	//first line with a vertex or texture w coordinate which is not supported
+	int vertexWLine;
+	int textureWLine;
+
+	//the numbers of positions, normals, texture coordinates and lines in the chunks before this one
+	int posOffset;
+	int normOffset;
+	int texOffset;
+	int lineOffset;
+};
+
 StelOBJ::StelOBJ()
 	: m_isLoaded(false)
+	, m_isLoadedFromCache(false)
 {
 
 }
@@ -50,7 +133,7 @@ void StelOBJ::clear()
 	*this = StelOBJ();
 }
 
-bool StelOBJ::load(const QString& filename, const VertexOrder vertexOrder)
+bool StelOBJ::load(const QString& filename, const VertexOrder vertexOrder, bool useCache)
 {
 	qCDebug(stelOBJ)<<"Loading"<<filename;
 
@@ -60,6 +143,17 @@ bool StelOBJ::load(const QString& filename, const VertexOrder vertexOrder)
 	//construct base path
 	QFileInfo fi(filename);
 
+	QString cacheFile;
+	if(useCache)
+	{
+		cacheFile = getCacheFileName(filename);
+		if(loadCache(cacheFile, fi, vertexOrder))
+		{
+			qCDebug(stelOBJ)<<"Loaded from cache"<<cacheFile<<"in"<<timer.elapsed()<<"ms";
+			return true;
+		}
+	}
+
 	//try to open the file
 	QFile file(filename);
 	if(!file.open(QIODevice::ReadOnly))
@@ -89,11 +183,26 @@ bool StelOBJ::load(const QString& filename, const VertexOrder vertexOrder)
 		buf.open(QIODevice::ReadOnly);
 
 		//perform actual load
-		return load(buf,fi.canonicalPath(),vertexOrder);
+		if(!load(buf,fi.canonicalPath(),vertexOrder))
+			return false;
 	}
+	else if(!load(file,fi.canonicalPath(),vertexOrder)) //perform actual load
+		return false;
+
+	if(useCache)
+		saveCache(cacheFile, fi, vertexOrder);
+	return true;
+}
+
+QString StelOBJ::getCacheFileName(const QString &filename)
+{
+	QFileInfo fi(filename);
+	if(QFileInfo(fi.absolutePath()).isWritable())
+		return fi.absoluteFilePath() + ".cache";
 
-	//perform actual load
-	return load(file,fi.canonicalPath(),vertexOrder);
+	//for example models in the installation directory
+	const QByteArray hash = QCryptographicHash::hash(fi.absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+	return StelFileMgr::getCacheDir() + "/models/" + QString::fromLatin1(hash) + ".cache";
 }
 
 //macro to test out different ways of comparison and their performance
@@ -280,9 +389,36 @@ int StelOBJ::getCurrentMaterialIndex(CurrentParserState &state)
 	return 0;
 }
 
-bool StelOBJ::parseFace(const ParseParams& params, const V3Vec& posList, const V3Vec& normList, const V2Vec& texList,
-			CurrentParserState& state,
-			VertexCache& vertCache)
+void StelOBJ::reorder(Vec3f &vec, const VertexOrder vertexOrder)
+{
+	switch(vertexOrder)
+	{
+		case XYZ:
+			//no change
+			break;
+		case XZY:
+			vec.set(vec[0],-vec[2],vec[1]);
+			break;
+		case YXZ:
+			vec.set(vec[1],vec[0],vec[2]);
+			break;
+		case YZX:
+			vec.set(vec[1],vec[2],vec[0]);
+			break;
+		case ZXY:
+			vec.set(vec[2],vec[0],vec[1]);
+			break;
+		case ZYX:
+			vec.set(vec[2],vec[1],vec[0]);
+			break;
+		default:
+			Q_ASSERT_X(0,"StelOBJ::load","invalid vertex order found");
+			qCWarning(stelOBJ) << "Vertex order"<<vertexOrder<<"not implemented, assuming XYZ";
+			break;
+	}
+}
+
+bool StelOBJ::parseFace(const ParseParams& params, int lineNr, ParseChunk& chunk)
 {
 	//The face definition can have 4 different variants
 	//Mode 1: Only position:		f v1 v2 v3
@@ -290,11 +426,6 @@ bool StelOBJ::parseFace(const ParseParams& params, const V3Vec& posList, const V
 	//Mode 3: Position+texcoords+normals:	f v1/t1/n1 v2/t2/n2 v3/t3/n3
 	//Mode 4: Position+normals:		f v1//n1 v2//n2 v3//n3
 
-	// Zero is actually invalid in the face definition, so we use it for default values
-	int posIdx=0, texIdx=0, normIdx=0;
-	// Contains the vertex indices
-	QVarLengthArray<unsigned int,16> vIdx;
-
 	if(params.size()<4)
 	{
 		qCCritical(stelOBJ)<<"Invalid number of vertices in face statement"<<params;
@@ -302,6 +433,7 @@ bool StelOBJ::parseFace(const ParseParams& params, const V3Vec& posList, const V
 	}
 
 	int vtxAmount = params.size()-1;
+	const int firstCorner = chunk.corners.size();
 
 	//parse each one seperately
 	int mode = 0;
@@ -310,54 +442,78 @@ bool StelOBJ::parseFace(const ParseParams& params, const V3Vec& posList, const V
 	#define CHK_MODE(a) if(mode && mode!=a) { qCCritical(stelOBJ)<<"Inconsistent face statement"<<params; return false; } else {mode = a;}
 	//a macro for checking number pasing
 	#define CHK_OK(a) do{ a; if(!ok) { qCCritical(stelOBJ)<<"Could not parse number in face statement"<<params; return false; } } while(0)
-	//negative indices indicate relative data, i.e. -1 would mean the last position/texture/normal that was parsed
-	//this macro fixes it up so that it always uses absolute numbers
-	//note: the indices start with 1, this is fixed up later
-	#define FIX_REL(a, list) if(a<0) {a += list.size()+1; }
 
 	//loop to parse each section seperately
 	for(int i =0; i<vtxAmount;++i)
 	{
+		// Zero is actually invalid in the face definition, so we use it for default values
+		ParseChunk::Corner& corner = INC_LIST(chunk.corners);
+		corner.pos = corner.tex = corner.norm = 0;
+
 		//split on slash
 		QVector<QStringRef> split = params.at(i+1).split('/');
 		switch(split.size())
 		{
 			case 1: //no slash, only position
 				CHK_MODE(1);
-				CHK_OK(posIdx = split.at(0).toInt(&ok));
-				FIX_REL(posIdx, posList);
+				CHK_OK(corner.pos = split.at(0).toInt(&ok));
 				break;
 			case 2: //single slash, vert/tex
 				CHK_MODE(2);
-				CHK_OK(posIdx = split.at(0).toInt(&ok));
-				FIX_REL(posIdx, posList);
-				CHK_OK(texIdx = split.at(1).toInt(&ok));
-				FIX_REL(texIdx, texList);
+				CHK_OK(corner.pos = split.at(0).toInt(&ok));
+				CHK_OK(corner.tex = split.at(1).toInt(&ok));
 				break;
 			case 3: //2 slashes, either v/t/n or v//n
 				if(!split.at(1).isEmpty())
 				{
 					CHK_MODE(3);
-					CHK_OK(posIdx = split.at(0).toInt(&ok));
-					FIX_REL(posIdx, posList);
-					CHK_OK(texIdx = split.at(1).toInt(&ok));
-					FIX_REL(texIdx, texList);
-					CHK_OK(normIdx = split.at(2).toInt(&ok));
-					FIX_REL(normIdx, normList);
+					CHK_OK(corner.pos = split.at(0).toInt(&ok));
+					CHK_OK(corner.tex = split.at(1).toInt(&ok));
+					CHK_OK(corner.norm = split.at(2).toInt(&ok));
 				}
 				else
 				{
 					CHK_MODE(4);
-					CHK_OK(posIdx = split.at(0).toInt(&ok));
-					FIX_REL(posIdx, posList);
-					CHK_OK(normIdx = split.at(2).toInt(&ok));
-					FIX_REL(normIdx, normList);
+					CHK_OK(corner.pos = split.at(0).toInt(&ok));
+					CHK_OK(corner.norm = split.at(2).toInt(&ok));
 				}
 				break;
 			default: //invalid line
 				qCCritical(stelOBJ)<<"Invalid face statement"<<params;
 				return false;
 		}
+	}
+
+	ParseChunk::Face face = { lineNr, firstCorner, vtxAmount, chunk.posList.size(), chunk.texList.size(), chunk.normalList.size() };
+	chunk.faces.append(face);
+	return true;
+}
+
+bool StelOBJ::addFace(const ParseChunk &chunk, int face, const V3Vec& posList, const V3Vec& normList, const V2Vec& texList,
+		      CurrentParserState& state,
+		      VertexCache& vertCache)
+{
+	const ParseChunk::Face& f = chunk.faces.at(face);
+	// Contains the vertex indices
+	QVarLengthArray<unsigned int,16> vIdx;
+
+	//negative indices indicate relative data, i.e. -1 would mean the last position/texture/normal that was parsed before the face
+	//this macro fixes it up so that it always uses absolute numbers
+	//note: the indices start with 1, this is fixed up later
+	#define FIX_REL(a, count) if(a<0) {a += count+1; }
+	//a macro to check references to vertex data which has not been defined
+	#define CHK_RANGE(a, list) if(a<0 || a>list.size()) { qCCritical(stelOBJ)<<"Invalid vertex data reference"<<a<<"in face statement"; return false; }
+
+	for(int i = 0; i<f.cornerCount; ++i)
+	{
+		const ParseChunk::Corner& corner = chunk.corners.at(f.firstCorner+i);
+		int posIdx = corner.pos, texIdx = corner.tex, normIdx = corner.norm;
+		FIX_REL(posIdx, chunk.posOffset + f.posCount);
+		FIX_REL(texIdx, chunk.texOffset + f.texCount);
+		FIX_REL(normIdx, chunk.normOffset + f.normCount);
+		CHK_RANGE(posIdx, posList);
+		CHK_RANGE(texIdx, texList);
+		CHK_RANGE(normIdx, normList);
 
 		//create a temporary Vertex by copying the info from the lists
 		//zero initialize!
@@ -400,7 +556,7 @@ bool StelOBJ::parseFace(const ParseParams& params, const V3Vec& posList, const V
 
 	//vertex data has been loaded, create the faces
 	//we use triangle-fan triangulation
-	for(int i=2;i<vtxAmount;++i)
+	for(int i=2;i<f.cornerCount;++i)
 	{
 		//the first one is always the same
 		m_indices.append(vIdx[0]);
@@ -702,241 +858,328 @@ void StelOBJ::addObject(const QString &name, CurrentParserState &state)
 	state.currentMaterialGroup = Q_NULLPTR;
 }
 
-bool StelOBJ::load(QIODevice& device, const QString &basePath, const VertexOrder vertexOrder)
+void StelOBJ::parseChunk(ParseChunk &chunk)
 {
-	clear();
-
-	QDir baseDir(basePath);
-
-	QElapsedTimer timer;
-	timer.start();
-	QTextStream stream(&device);
-
-	bool smoothGroupWarned = false;
-	bool vertexWWarned = false;
-	bool textureWWarned = false;
-
-	//contains the parsed vertex positions
-	V3Vec posList;
-	//contains the parsed normals
-	V3Vec normalList;
-	//contains the parsed texture coords
-	V2Vec texList;
-
-	VertexCache vertCache;
-	CurrentParserState state = CurrentParserState();
 	const QRegularExpression separator("\\s");
 	separator.optimize();
 
-	int lineNr=0;
+	const char* pos = chunk.data;
+	const char* const end = chunk.data + chunk.size;
+	int lineNr = 0;
 
-	//read file line by line
-	while(!stream.atEnd())
+	//read chunk line by line
+	while(pos<end)
 	{
+		const char* eol = static_cast<const char*>(memchr(pos, '\n', end-pos));
+		if(!eol)
+			eol = end;
 		++lineNr;
 		//ignore front/back whitespace
-		QString line = stream.readLine().trimmed();
+		QString line = QString::fromUtf8(pos, static_cast<int>(eol-pos)).trimmed();
+		pos = eol + 1;
 
 		//split line by whitespace
 		QVector<QStringRef> splits = line.splitRef(separator,QString::SkipEmptyParts);
-		if(!splits.isEmpty())
-		{
-			const QStringRef& cmd = splits.at(0);
+		if(splits.isEmpty())
+			continue;
 
-			bool ok = true;
+		const QStringRef& cmd = splits.at(0);
 
-			if(CMD_CMP("f"))
-			{
-				ok = parseFace(splits,posList,normalList,texList,state,vertCache);
-			}
-			else if(CMD_CMP("v"))
-			{
-				//we have to handle the vertex order
-				Vec3f& target = INC_LIST(posList);
-				ok = parseVec3(splits,target);
-				//check the optional w coord if we have a vec4, must be 1
-				if(splits.size()>4)
-				{
-					float w;
-					parseFloat(splits,w,4);
-					if((!qFuzzyCompare(w,1.0f)) && (!vertexWWarned))
-					{
-						qWarning(stelOBJ)<<"Vertex w coordinates different from 1.0 are not supported, changed to 1.0, starting on line"<<lineNr;
-						vertexWWarned=true;
-					}
-				}
-				switch(vertexOrder)
-				{
-					case XYZ:
-						//no change
-						break;
-					case XZY:
-						target.set(target[0],-target[2],target[1]);
-						break;
-					case YXZ:
-						target.set(target[1],target[0],target[2]);
-						break;
-					case YZX:
-						target.set(target[1],target[2],target[0]);
-						break;
-					case ZXY:
-						target.set(target[2],target[0],target[1]);
-						break;
-					case ZYX:
-						target.set(target[2],target[1],target[0]);
-						break;
-					default:
-						Q_ASSERT_X(0,"StelOBJ::load","invalid vertex order found");
-						qCWarning(stelOBJ) << "Vertex order"<<vertexOrder<<"not implemented, assuming XYZ";
-						break;
-				}
-			}
-			else if(CMD_CMP("vt"))
+		bool ok = true;
+
+		if(CMD_CMP("f"))
+		{
+			ok = parseFace(splits,lineNr,chunk);
+		}
+		else if(CMD_CMP("v"))
+		{
+			//we have to handle the vertex order
+			Vec3f& target = INC_LIST(chunk.posList);
+			ok = parseVec3(splits,target);
+			//check the optional w coord if we have a vec4, must be 1
+			if(splits.size()>4 && chunk.vertexWLine<0)
 			{
-				ok = parseVec2(splits,INC_LIST(texList));
-				//check the optional w coord if we have a vec3, must be 0
-				if(splits.size()>3)
-				{
-					float w;
-					parseFloat(splits,w,3);
-					if( (!qFuzzyIsNull(w)) && (!textureWWarned))
-					{
-						qWarning(stelOBJ)<<"Texture w coordinates are not supported, starting on line"<<lineNr;
-						textureWWarned=true;
-					}
-				}
+				float w;
+				parseFloat(splits,w,4);
+				if(!qFuzzyCompare(w,1.0f))
+					chunk.vertexWLine = lineNr;
 			}
-			else if(CMD_CMP("vn"))
+			reorder(target, chunk.vertexOrder);
+		}
+		else if(CMD_CMP("vt"))
+		{
+			ok = parseVec2(splits,INC_LIST(chunk.texList));
+			//check the optional w coord if we have a vec3, must be 0
+			if(splits.size()>3 && chunk.textureWLine<0)
 			{
-				//we have to handle the vertex order
-				Vec3f& target = INC_LIST(normalList);
-				ok = parseVec3(splits,target);
-				switch(vertexOrder)
-				{
-					case XYZ:
-						//no change
-						break;
-					case XZY:
-						target.set(target[0],-target[2],target[1]);
-						break;
-					case YXZ:
-						target.set(target[1],target[0],target[2]);
-						break;
-					case YZX:
-						target.set(target[1],target[2],target[0]);
-						break;
-					case ZXY:
-						target.set(target[2],target[0],target[1]);
-						break;
-					case ZYX:
-						target.set(target[2],target[1],target[0]);
-						break;
-					default:
-						Q_ASSERT_X(0,"StelOBJ::load","invalid vertex order found");
-						qCWarning(stelOBJ) << "Vertex order"<<vertexOrder<<"not implemented, assuming XYZ";
-						break;
-				}
-				//normalize is usually not needed so we skip it
-				//target.normalize();
+				float w;
+				parseFloat(splits,w,3);
+				if(!qFuzzyIsNull(w))
+					chunk.textureWLine = lineNr;
 			}
-			else if(CMD_CMP("usemtl"))
+		}
+		else if(CMD_CMP("vn"))
+		{
+			//we have to handle the vertex order
+			Vec3f& target = INC_LIST(chunk.normalList);
+			ok = parseVec3(splits,target);
+			reorder(target, chunk.vertexOrder);
+			//normalize is usually not needed so we skip it
+			//target.normalize();
+		}
+		else if(!cmd.startsWith('#'))
+		{
+			//handled in file order after all chunks are parsed
+			ParseChunk::Statement& statement = INC_LIST(chunk.statements);
+			statement.faceCount = chunk.faces.size();
+			statement.lineNr = lineNr;
+			statement.line = line;
+		}
+
+		if(!ok)
+		{
+			chunk.ok = false;
+			chunk.errorLineNr = lineNr;
+			chunk.errorLine = line;
+			break;
+		}
+	}
+
+	chunk.lineCount = lineNr;
+}
+
+bool StelOBJ::parseStatement(const QString &line, const QDir &baseDir, CurrentParserState &state, bool &smoothGroupWarned)
+{
+	int cmdLength = 0;
+	while(cmdLength<line.size() && !line.at(cmdLength).isSpace())
+		++cmdLength;
+	const QStringRef cmd = line.leftRef(cmdLength);
+
+	bool ok = true;
+
+	if(CMD_CMP("usemtl"))
+	{
+		//use the rest of the string
+		QString mtl = getRestOfString(QStringLiteral("usemtl"),line);
+		ok = !mtl.isEmpty();
+		if(ok)
+		{
+			if(m_materialMap.contains(mtl))
 			{
-				//use the rest of the string
-				QString mtl = getRestOfString(QStringLiteral("usemtl"),line);
-				ok = !mtl.isEmpty();
-				if(ok)
-				{
-					if(m_materialMap.contains(mtl))
-					{
-						//set material as active
-						state.currentMaterialIdx = m_materialMap.value(mtl);
-					}
-					else
-					{
-						ok = false;
-						qCCritical(stelOBJ)<<"Unknown material"<<mtl<<"has been referenced";
-					}
-				}
-				else
-					qCCritical(stelOBJ)<<"No material name given";
+				//set material as active
+				state.currentMaterialIdx = m_materialMap.value(mtl);
 			}
-			else if(CMD_CMP("mtllib"))
+			else
 			{
-				//use the rest of the string
-				QString fileName = getRestOfString(QStringLiteral("mtllib"),line);
-				ok = !fileName.isEmpty();
-				if(ok)
-				{
-					//load external material file
-					MaterialList newMaterials = Material::loadFromFile(baseDir.absoluteFilePath(fileName));
-					foreach(const Material& m, newMaterials)
-					{
-						m_materials.append(m);
-						//the map has the index of the material
-						//because pointers may change during parsing
-						//because of list resizeing
-						m_materialMap.insert(m.name,m_materials.size()-1);
-					}
-					qCDebug(stelOBJ)<<newMaterials.size()<<"materials loaded from MTL file"<<fileName;
-				}
-				else
-					qCCritical(stelOBJ)<<"No material file name given";
+				ok = false;
+				qCCritical(stelOBJ)<<"Unknown material"<<mtl<<"has been referenced";
 			}
-			else if(CMD_CMP("o"))
+		}
+		else
+			qCCritical(stelOBJ)<<"No material name given";
+	}
+	else if(CMD_CMP("mtllib"))
+	{
+		//use the rest of the string
+		QString fileName = getRestOfString(QStringLiteral("mtllib"),line);
+		ok = !fileName.isEmpty();
+		if(ok)
+		{
+			//load external material file
+			const QString mtlPath = baseDir.absoluteFilePath(fileName);
+			MaterialList newMaterials = Material::loadFromFile(mtlPath);
+			foreach(const Material& m, newMaterials)
 			{
-				//use the rest of the string
-				QString objName = getRestOfString(QStringLiteral("o"),line);
-				ok = !objName.isEmpty();
-				if(ok)
-				{
-					addObject(objName, state);
-				}
-				else
-					qCCritical(stelOBJ)<<"Object name is required";
+				m_materials.append(m);
+				//the map has the index of the material
+				//because pointers may change during parsing
+				//because of list resizeing
+				m_materialMap.insert(m.name,m_materials.size()-1);
 			}
-			else if(CMD_CMP("g"))
+			//the cache depends on the material file
+			if(QFileInfo::exists(mtlPath))
+				m_materialFiles.append(mtlPath);
+			qCDebug(stelOBJ)<<newMaterials.size()<<"materials loaded from MTL file"<<fileName;
+		}
+		else
+			qCCritical(stelOBJ)<<"No material file name given";
+	}
+	else if(CMD_CMP("o"))
+	{
+		//use the rest of the string
+		QString objName = getRestOfString(QStringLiteral("o"),line);
+		ok = !objName.isEmpty();
+		if(ok)
+		{
+			addObject(objName, state);
+		}
+		else
+			qCCritical(stelOBJ)<<"Object name is required";
+	}
+	else if(CMD_CMP("g"))
+	{
+		//use the rest of the string
+		QString objName = getRestOfString(QStringLiteral("g"),line);
+		ok = !objName.isEmpty();
+		if(ok)
+		{
+			addObject(objName, state);
+		}
+		else
+			qCCritical(stelOBJ)<<"Group name is required";
+	}
+	else if(CMD_CMP("s"))
+	{
+		if(!smoothGroupWarned)
+		{
+			qCWarning(stelOBJ)<<"Smoothing groups are not supported, consider re-exporting your model from blender";
+			smoothGroupWarned = true;
+		}
+	}
+	else
+	{
+		//unknown command, warn
+		qCWarning(stelOBJ)<<"Unknown OBJ statement:"<<line;
+	}
+
+	return ok;
+}
+
+bool StelOBJ::load(QIODevice& device, const QString &basePath, const VertexOrder vertexOrder)
+{
+	clear();
+
+	QDir baseDir(basePath);
+
+	QElapsedTimer timer;
+	timer.start();
+
+	//read the whole file, and split it into line-aligned chunks for the worker threads
+	const QByteArray data = device.readAll();
+	device.close();
+
+	QVector<ParseChunk> chunks;
+	const int chunkCount = qBound(1, data.size() / MIN_CHUNK_SIZE, QThread::idealThreadCount());
+	const char* const dataEnd = data.constData() + data.size();
+	const char* chunkStart = data.constData();
+	for(int i = 0; i<chunkCount && chunkStart<dataEnd; ++i)
+	{
+		const char* chunkEnd = qMax(chunkStart, data.constData() + static_cast<qint64>(data.size()) * (i+1) / chunkCount);
+		if(chunkEnd<dataEnd)
+		{
+			//include the rest of the line
+			const char* eol = static_cast<const char*>(memchr(chunkEnd, '\n', dataEnd-chunkEnd));
+			chunkEnd = eol ? eol+1 : dataEnd;
+		}
+
+		ParseChunk& chunk = INC_LIST(chunks);
+		chunk.data = chunkStart;
+		chunk.size = static_cast<int>(chunkEnd-chunkStart);
+		chunk.vertexOrder = vertexOrder;
+		chunkStart = chunkEnd;
+	}
+
+	if(chunks.size()>1)
+		QtConcurrent::blockingMap(chunks, &StelOBJ::parseChunk);
+	else if(!chunks.isEmpty())
+		parseChunk(chunks.first());
+
+	qCDebug(stelOBJ)<<"Parsed"<<chunks.size()<<"chunks in"<<timer.restart()<<"ms";
+
+	//contains the parsed vertex positions
+	V3Vec posList;
+	//contains the parsed normals
+	V3Vec normalList;
+	//contains the parsed texture coords
+	V2Vec texList;
+
+	//join the vertex data of the chunks
+	int posCount = 0, normCount = 0, texCount = 0, lineCount = 0;
+	for(int i = 0; i<chunks.size(); ++i)
+	{
+		ParseChunk& chunk = chunks[i];
+		chunk.posOffset = posCount;
+		chunk.normOffset = normCount;
+		chunk.texOffset = texCount;
+		chunk.lineOffset = lineCount;
+		if(!chunk.ok)
+		{
+			qCCritical(stelOBJ)<<"Critical error on OBJ line"<<lineCount+chunk.errorLineNr<<", cannot load OBJ data: "<<chunk.errorLine;
+			return false;
+		}
+		posCount += chunk.posList.size();
+		normCount += chunk.normalList.size();
+		texCount += chunk.texList.size();
+		lineCount += chunk.lineCount;
+	}
+	posList.reserve(posCount);
+	normalList.reserve(normCount);
+	texList.reserve(texCount);
+	bool vertexWWarned = false;
+	bool textureWWarned = false;
+	for(int i = 0; i<chunks.size(); ++i)
+	{
+		ParseChunk& chunk = chunks[i];
+		posList += chunk.posList;
+		normalList += chunk.normalList;
+		texList += chunk.texList;
+		chunk.posList.clear();
+		chunk.normalList.clear();
+		chunk.texList.clear();
+
+		if(chunk.vertexWLine>=0 && !vertexWWarned)
+		{
+			qWarning(stelOBJ)<<"Vertex w coordinates different from 1.0 are not supported, changed to 1.0, starting on line"<<chunk.lineOffset+chunk.vertexWLine;
+			vertexWWarned=true;
+		}
+		if(chunk.textureWLine>=0 && !textureWWarned)
+		{
+			qWarning(stelOBJ)<<"Texture w coordinates are not supported, starting on line"<<chunk.lineOffset+chunk.textureWLine;
+			textureWWarned=true;
+		}
+	}
+
+	VertexCache vertCache;
+	CurrentParserState state = CurrentParserState();
+	bool smoothGroupWarned = false;
+
+	//create the vertices and faces, and handle the other statements in file order
+	for(int i = 0; i<chunks.size(); ++i)
+	{
+		const ParseChunk& chunk = chunks.at(i);
+		int face = 0;
+		for(int s = 0; s<=chunk.statements.size(); ++s)
+		{
+			//first the faces before the statement
+			const int faceEnd = s<chunk.statements.size() ? chunk.statements.at(s).faceCount : chunk.faces.size();
+			for(; face<faceEnd; ++face)
 			{
-				//use the rest of the string
-				QString objName = getRestOfString(QStringLiteral("g"),line);
-				ok = !objName.isEmpty();
-				if(ok)
+				if(!addFace(chunk,face,posList,normalList,texList,state,vertCache))
 				{
-					addObject(objName, state);
+					qCCritical(stelOBJ)<<"Critical error on OBJ line"<<chunk.lineOffset+chunk.faces.at(face).lineNr<<", cannot load OBJ data";
+					return false;
 				}
-				else
-					qCCritical(stelOBJ)<<"Group name is required";
 			}
-			else if(CMD_CMP("s"))
+
+			if(s<chunk.statements.size())
 			{
-				if(!smoothGroupWarned)
+				const ParseChunk::Statement& statement = chunk.statements.at(s);
+				if(!parseStatement(statement.line,baseDir,state,smoothGroupWarned))
 				{
-					qCWarning(stelOBJ)<<"Smoothing groups are not supported, consider re-exporting your model from blender";
-					smoothGroupWarned = true;
+					qCCritical(stelOBJ)<<"Critical error on OBJ line"<<chunk.lineOffset+statement.lineNr<<", cannot load OBJ data: "<<statement.line;
+					return false;
 				}
 			}
-			else if(!cmd.startsWith('#'))
-			{
-				//unknown command, warn
-				qCWarning(stelOBJ)<<"Unknown OBJ statement:"<<line;
-			}
-
-			if(!ok)
-			{
-				qCCritical(stelOBJ)<<"Critical error on OBJ line"<<lineNr<<", cannot load OBJ data: "<<line;
-				return false;
-			}
 		}
 	}
 
-	device.close();
-
 	//finished loading, squeeze the arrays to save some memory
 	m_vertices.squeeze();
 	m_indices.squeeze();
 
 	Q_ASSERT(m_indices.size() % 3 == 0);
 
-	qCDebug(stelOBJ)<<"Loaded OBJ in"<<timer.elapsed()<<"ms";
+	qCDebug(stelOBJ)<<"Created OBJ data in"<<timer.elapsed()<<"ms";
 	qCDebug(stelOBJ, "Parsed %d positions, %d normals, %d texture coordinates, %d materials",
 		posList.size(), normalList.size(), texList.size(), m_materials.size());
 	qCDebug(stelOBJ, "Created %d vertices, %d faces, %d objects", m_vertices.size(), getFaceCount(), m_objects.size());
@@ -947,6 +1190,208 @@ bool StelOBJ::load(QIODevice& device, const QString &basePath, const VertexOrder
 	return true;
 }
 
+static void writeBox(QDataStream& stream, const AABBox& box)
+{
+	stream<<box.min<<box.max;
+}
+
+static void readBox(QDataStream& stream, AABBox& box)
+{
+	stream>>box.min>>box.max;
+}
+
+bool StelOBJ::saveCache(const QString &cacheFile, const QFileInfo &source, const VertexOrder vertexOrder) const
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	//everything except the vertex and index arrays is serialized with QDataStream,
+	//the arrays are written as they are in memory, after the header
+	QByteArray header;
+	QDataStream stream(&header, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_4);
+	stream<<CACHE_MAGIC<<CACHE_VERSION;
+	stream<<static_cast<quint8>(QSysInfo::ByteOrder)<<static_cast<quint32>(sizeof(Vertex))<<static_cast<quint32>(sizeof(IndexList::value_type));
+
+	//the cache is only valid for the same files and load options
+	stream<<source.size()<<source.lastModified().toMSecsSinceEpoch()<<static_cast<qint32>(vertexOrder);
+	stream<<static_cast<qint32>(m_materialFiles.size());
+	foreach(const QString& path, m_materialFiles)
+	{
+		const QFileInfo fi(path);
+		stream<<path<<fi.size()<<fi.lastModified().toMSecsSinceEpoch();
+	}
+
+	stream<<static_cast<qint32>(m_materials.size());
+	foreach(const Material& mat, m_materials)
+	{
+		stream<<mat.name<<static_cast<qint32>(mat.illum);
+		stream<<mat.Ka<<mat.Kd<<mat.Ks<<mat.Ke<<mat.Ns<<mat.d;
+		stream<<mat.map_Ka<<mat.map_Kd<<mat.map_Ks<<mat.map_Ke<<mat.map_bump<<mat.map_height;
+		stream<<mat.additionalParams;
+	}
+	stream<<m_materialMap;
+
+	stream<<static_cast<qint32>(m_objects.size());
+	foreach(const Object& obj, m_objects)
+	{
+		stream<<obj.isDefaultObject<<obj.name<<obj.centroid;
+		writeBox(stream, obj.boundingbox);
+		stream<<static_cast<qint32>(obj.groups.size());
+		foreach(const MaterialGroup& grp, obj.groups)
+		{
+			stream<<grp.startIndex<<grp.indexCount<<grp.objectIndex<<grp.materialIndex<<grp.centroid;
+			writeBox(stream, grp.boundingbox);
+		}
+	}
+	stream<<m_objectMap;
+
+	writeBox(stream, m_bbox);
+	stream<<m_centroid;
+	stream<<static_cast<qint32>(m_vertices.size())<<static_cast<qint32>(m_indices.size());
+
+	//align the arrays
+	header.append(QByteArray((16 - header.size() % 16) % 16, '\0'));
+
+	QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+	QSaveFile file(cacheFile);
+	if(!file.open(QIODevice::WriteOnly))
+	{
+		qCWarning(stelOBJ)<<"Could not write OBJ cache"<<cacheFile<<file.errorString();
+		return false;
+	}
+	file.write(header);
+	file.write(reinterpret_cast<const char*>(m_vertices.constData()), sizeof(Vertex) * m_vertices.size());
+	file.write(reinterpret_cast<const char*>(m_indices.constData()), sizeof(IndexList::value_type) * m_indices.size());
+	if(!file.commit())
+	{
+		qCWarning(stelOBJ)<<"Could not write OBJ cache"<<cacheFile<<file.errorString();
+		return false;
+	}
+
+	qCDebug(stelOBJ)<<"Wrote OBJ cache"<<cacheFile<<"in"<<timer.elapsed()<<"ms";
+	return true;
+}
+
+bool StelOBJ::loadCache(const QString &cacheFile, const QFileInfo &source, const VertexOrder vertexOrder)
+{
+	QFile file(cacheFile);
+	if(!file.exists() || !file.open(QIODevice::ReadOnly))
+		return false;
+
+	//map the whole file, the arrays are copied from there
+	qint64 size = file.size();
+	const char* data = reinterpret_cast<const char*>(file.map(0, size));
+	QByteArray contents;
+	if(!data)
+	{
+		contents = file.readAll();
+		data = contents.constData();
+		size = contents.size();
+	}
+
+	QDataStream stream(QByteArray::fromRawData(data, static_cast<int>(size)));
+	stream.setVersion(QDataStream::Qt_5_4);
+
+	quint32 magic, version, vertexSize, indexSize;
+	quint8 byteOrder;
+	stream>>magic>>version>>byteOrder>>vertexSize>>indexSize;
+	if(stream.status()!=QDataStream::Ok || magic!=CACHE_MAGIC || version!=CACHE_VERSION || byteOrder!=QSysInfo::ByteOrder
+			|| vertexSize!=sizeof(Vertex) || indexSize!=sizeof(IndexList::value_type))
+	{
+		qCDebug(stelOBJ)<<"OBJ cache"<<cacheFile<<"has an incompatible format";
+		return false;
+	}
+
+	qint64 sourceSize, sourceTime;
+	qint32 order, fileCount;
+	stream>>sourceSize>>sourceTime>>order>>fileCount;
+	bool valid = sourceSize==source.size() && sourceTime==source.lastModified().toMSecsSinceEpoch() && order==vertexOrder;
+	QStringList materialFiles;
+	for(int i = 0; valid && i<fileCount && stream.status()==QDataStream::Ok; ++i)
+	{
+		QString path;
+		qint64 fileSize, fileTime;
+		stream>>path>>fileSize>>fileTime;
+		const QFileInfo fi(path);
+		valid = fi.exists() && fi.size()==fileSize && fi.lastModified().toMSecsSinceEpoch()==fileTime;
+		materialFiles.append(path);
+	}
+	if(!valid || stream.status()!=QDataStream::Ok)
+	{
+		qCDebug(stelOBJ)<<"OBJ cache"<<cacheFile<<"is outdated";
+		return false;
+	}
+
+	clear();
+	m_materialFiles = materialFiles;
+
+	qint32 count;
+	stream>>count;
+	for(int i = 0; i<count && stream.status()==QDataStream::Ok; ++i)
+	{
+		Material& mat = INC_LIST(m_materials);
+		qint32 illum;
+		stream>>mat.name>>illum;
+		mat.illum = static_cast<Material::Illum>(illum);
+		stream>>mat.Ka>>mat.Kd>>mat.Ks>>mat.Ke>>mat.Ns>>mat.d;
+		stream>>mat.map_Ka>>mat.map_Kd>>mat.map_Ks>>mat.map_Ke>>mat.map_bump>>mat.map_height;
+		stream>>mat.additionalParams;
+	}
+	stream>>m_materialMap;
+
+	stream>>count;
+	for(int i = 0; i<count && stream.status()==QDataStream::Ok; ++i)
+	{
+		Object& obj = INC_LIST(m_objects);
+		qint32 groupCount;
+		stream>>obj.isDefaultObject>>obj.name>>obj.centroid;
+		readBox(stream, obj.boundingbox);
+		stream>>groupCount;
+		for(int j = 0; j<groupCount && stream.status()==QDataStream::Ok; ++j)
+		{
+			MaterialGroup& grp = INC_LIST(obj.groups);
+			stream>>grp.startIndex>>grp.indexCount>>grp.objectIndex>>grp.materialIndex>>grp.centroid;
+			readBox(stream, grp.boundingbox);
+		}
+	}
+	stream>>m_objectMap;
+
+	readBox(stream, m_bbox);
+	stream>>m_centroid;
+	qint32 vertexCount, indexCount;
+	stream>>vertexCount>>indexCount;
+
+	const qint64 offset = (stream.device()->pos() + 15) / 16 * 16;
+	if(stream.status()!=QDataStream::Ok || vertexCount<0 || indexCount<0
+			|| offset + static_cast<qint64>(sizeof(Vertex)) * vertexCount + static_cast<qint64>(sizeof(IndexList::value_type)) * indexCount != size)
+	{
+		qCWarning(stelOBJ)<<"OBJ cache"<<cacheFile<<"is damaged";
+		clear();
+		return false;
+	}
+
+	m_vertices.resize(vertexCount);
+	memcpy(m_vertices.data(), data + offset, sizeof(Vertex) * vertexCount);
+	m_indices.resize(indexCount);
+	memcpy(m_indices.data(), data + offset + sizeof(Vertex) * vertexCount, sizeof(IndexList::value_type) * indexCount);
+
+	//don't trust the indices blindly
+	for(int i = 0; i<indexCount; ++i)
+	{
+		if(m_indices.at(i)>=static_cast<unsigned int>(vertexCount))
+		{
+			qCWarning(stelOBJ)<<"OBJ cache"<<cacheFile<<"is damaged";
+			clear();
+			return false;
+		}
+	}
+
+	m_isLoaded = true;
+	m_isLoadedFromCache = true;
+	return true;
+}
+
 void StelOBJ::Object::postprocess(const StelOBJ &obj, Vec3d &centroid)
 {
 	const VertexList& vList = obj.getVertexList();
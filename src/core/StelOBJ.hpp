@@ -29,6 +29,10 @@
 #include <QIODevice>
 #include <QVector>
 #include <QHash>
+#include <QStringList>
+
+class QDir;
+class QFileInfo;
 
 Q_DECLARE_LOGGING_CATEGORY(stelOBJ)
 
@@ -243,9 +247,12 @@ public:
 
 	//! Loads an .obj file by name. Supports .gz decompression, and
 	//! then calls load(QIODevice) for the actual loading.
+	//! @param useCache If true, the loaded data is stored in a binary cache file (see getCacheFileName()),
+	//! which is read instead of the .obj file as long as neither the .obj file nor its .mtl files change.
 	//! @return true if load was successful
-	bool load(const QString& filename, const VertexOrder vertexOrder = VertexOrder::XYZ);
+	bool load(const QString& filename, const VertexOrder vertexOrder = VertexOrder::XYZ, bool useCache = false);
 	//! Loads an .obj file from the specified device.
+	//! Large files are split into line-aligned chunks, which are parsed in parallel.
 	//! @param device The device to load OBJ data from
 	//! @param basePath The path to use to find additional files (like material definitions)
 	//! @param vertexOrder The order to use for vertex positions
@@ -254,6 +261,12 @@ public:
 
 	//! Returns true if this object contains valid data from a load() method
 	bool isLoaded() const { return m_isLoaded; }
+	//! Returns true if the data was read from the binary cache by the last load()
+	bool isLoadedFromCache() const { return m_isLoadedFromCache; }
+
+	//! Returns the binary cache file of the .obj file @p filename. This is the file name with a \c .cache suffix,
+	//! or a file in the cache directory if the directory of the model is not writable.
+	static QString getCacheFileName(const QString& filename);
 
 	//! Rebuilds vertex normals as the average of face normals.
 	void rebuildNormals();
@@ -299,6 +312,12 @@ public:
 private:
 	typedef QVector<QStringRef> ParseParams;
 	typedef QHash<Vertex, int> VertexCache;
+	//! A part of the file parsed by a worker thread, defined in StelOBJ.cpp
+	struct ParseChunk;
+	//! Version of the binary cache format, increase when the format or the processing of the data changes
+	static const quint32 CACHE_VERSION = 1;
+	//! Files smaller than this are parsed in a single chunk
+	static const int MIN_CHUNK_SIZE = 1 << 20;
 
 	struct CurrentParserState
 	{
@@ -308,6 +327,7 @@ private:
 	};
 
 	bool m_isLoaded;
+	bool m_isLoadedFromCache;
 	//all vertex data is contained in this list
 	VertexList m_vertices;
 	//all index data is contained in this list
@@ -317,6 +337,8 @@ private:
 	MaterialMap m_materialMap;
 	ObjectList m_objects;
 	ObjectMap m_objectMap;
+	//the .mtl files which have been loaded, with absolute paths
+	QStringList m_materialFiles;
 
 	//global bounding box
 	AABBox m_bbox;
@@ -348,11 +370,25 @@ private:
 	//! Only requirement is that operator[] is defined.
 	template<typename T>
 	inline static bool parseVec2(const ParseParams& params, T& out, int paramsStart=1);
-	inline bool parseFace(const ParseParams& params, const V3Vec& posList, const V3Vec& normList, const V2Vec& texList,
-			      CurrentParserState &state, VertexCache& vertCache);
+	//! Applies the vertex order to a parsed position or normal
+	inline static void reorder(Vec3f& vec, const VertexOrder vertexOrder);
+	//! Parses the vertex references of a face statement into the chunk
+	inline static bool parseFace(const ParseParams& params, int lineNr, ParseChunk& chunk);
+	//! Parses the vertex data and faces of a chunk, and collects its other statements. Runs in worker threads.
+	static void parseChunk(ParseChunk& chunk);
+	//! Creates the vertices and triangles of face number @p face of the chunk
+	inline bool addFace(const ParseChunk& chunk, int face, const V3Vec& posList, const V3Vec& normList, const V2Vec& texList,
+			    CurrentParserState &state, VertexCache& vertCache);
+	//! Handles a statement which changes the state of the parser (like materials or objects)
+	bool parseStatement(const QString& line, const QDir& baseDir, CurrentParserState& state, bool& smoothGroupWarned);
 
 	inline void addObject(const QString& name, CurrentParserState& state);
 
+	//! Loads the cache file, if it is valid for the source file
+	bool loadCache(const QString& cacheFile, const QFileInfo& source, const VertexOrder vertexOrder);
+	//! Writes the loaded data into the cache file
+	bool saveCache(const QString& cacheFile, const QFileInfo& source, const VertexOrder vertexOrder) const;
+
 	//! Regenerate all normals in the vertex list
 	void generateNormals();
 
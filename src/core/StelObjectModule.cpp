@@ -22,6 +22,7 @@
 
 StelObjectModule::StelObjectModule()
  : StelModule()
+ , nameIndexEnabled(false)
 {
 }
 
@@ -31,14 +32,19 @@ StelObjectModule::~StelObjectModule()
 
 bool StelObjectModule::matchObjectName(const QString& objName, const QString& objPrefix, bool useStartOfWords) const
 {
-	if (useStartOfWords)
-	{
-		return objName.startsWith(objPrefix, Qt::CaseInsensitive);
-	}
-	else
-	{
-		return objName.contains(objPrefix, Qt::CaseInsensitive);
-	}
+	return StelObjectNameIndex::matchName(objName, objPrefix, useStartOfWords);
+}
+
+void StelObjectModule::setNameIndexEnabled(bool b)
+{
+	nameIndexEnabled = b;
+	invalidateNameIndex();
+}
+
+void StelObjectModule::invalidateNameIndex()
+{
+	englishNameIndex.clear();
+	localizedNameIndex.clear();
 }
 
 QStringList StelObjectModule::listMatchingObjects(const QString &objPrefix, int maxNbItem, bool useStartOfWords, bool inEnglish) const
@@ -49,6 +55,14 @@ QStringList StelObjectModule::listMatchingObjects(const QString &objPrefix, int
 		return result;
 	}
 
+	if (nameIndexEnabled)
+	{
+		StelObjectNameIndex& index = inEnglish ? englishNameIndex : localizedNameIndex;
+		if (!index.isValid())
+			index.setNames(listAllObjects(inEnglish));
+		return index.listMatching(objPrefix, maxNbItem, useStartOfWords);
+	}
+
 	QStringList names = listAllObjects(inEnglish);
 	foreach(const QString& name, names)
 	{
@@ -23,6 +23,7 @@
 
 #include "StelModule.hpp"
 #include "StelObjectType.hpp"
+#include "StelObjectNameIndex.hpp"
 #include "VecMath.hpp"
 
 #include <QList>
@@ -92,6 +93,20 @@ public:
 	//! @param useStartOfWords decide if start of word is searched
 	//! @return true if it matches
 	bool matchObjectName(const QString& objName, const QString& objPrefix, bool useStartOfWords) const;
+
+protected:
+	//! Make listMatchingObjects() look up the names of listAllObjects() in an index instead of scanning them.
+	//! A module which enables the index must call invalidateNameIndex() when it adds, removes or renames
+	//! objects, and when it translates their names.
+	void setNameIndexEnabled(bool b);
+	//! Build the name index again when it is next used.
+	void invalidateNameIndex();
+
+private:
+	bool nameIndexEnabled;
+	mutable StelObjectNameIndex englishNameIndex;
+	//! Names in the current language
+	mutable StelObjectNameIndex localizedNameIndex;
 };
 
 #endif // _STELOBJECTMODULE_HPP_
@@ -0,0 +1,211 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "StelObjectNameIndex.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	//! Compare the null terminated text at @param s with the start of @param key.
+	//! @return 0 if the text starts with the key, a negative value if it is sorted before the key, a positive value after it
+	int comparePrefix(const QChar* s, const QString& key)
+	{
+		for (int i=0; i<key.size(); ++i)
+		{
+			// the null character which ends the text is before all others
+			if (s[i]!=key.at(i))
+				return s[i].unicode()<key.at(i).unicode() ? -1 : 1;
+		}
+		return 0;
+	}
+
+	bool lessText(const QChar* a, const QChar* b)
+	{
+		while (*a==*b && !a->isNull())
+		{
+			++a;
+			++b;
+		}
+		return a->unicode()<b->unicode();
+	}
+
+	//! Find the range of @param order whose text starts with @param key. @param start gives the position of the text of an entry.
+	template<class Start>
+	void findRange(const QVector<int>& order, const QChar* text, Start start, const QString& key,
+		       QVector<int>::const_iterator& begin, QVector<int>::const_iterator& end)
+	{
+		begin = std::lower_bound(order.constBegin(), order.constEnd(), key, [&](int entry, const QString& k) {
+			return comparePrefix(text+start(entry), k)<0;
+		});
+		end = std::upper_bound(begin, order.constEnd(), key, [&](const QString& k, int entry) {
+			return comparePrefix(text+start(entry), k)>0;
+		});
+	}
+}
+
+StelObjectNameIndex::StelObjectNameIndex()
+	: valid(false)
+{
+}
+
+void StelObjectNameIndex::setNames(const QStringList& newNames)
+{
+	clear();
+	names = newNames;
+	nameStarts.reserve(names.size());
+	foreach (const QString& name, names)
+	{
+		nameStarts.append(foldedText.size());
+		foldedText += foldName(name);
+		foldedText += QChar(0);
+	}
+	valid = true;
+}
+
+void StelObjectNameIndex::clear()
+{
+	names.clear();
+	foldedText.clear();
+	nameStarts.clear();
+	sortedNames.clear();
+	suffixes.clear();
+	valid = false;
+}
+
+bool StelObjectNameIndex::matchName(const QString& objName, const QString& objPrefix, bool useStartOfWords)
+{
+	if (useStartOfWords)
+		return objName.startsWith(objPrefix, Qt::CaseInsensitive);
+	else
+		return objName.contains(objPrefix, Qt::CaseInsensitive);
+}
+
+QString StelObjectNameIndex::foldName(const QString& name)
+{
+	QString folded(name.size(), Qt::Uninitialized);
+	for (int i=0; i<name.size(); ++i)
+	{
+		QChar c = name.at(i).toCaseFolded();
+		// The first character of the canonical decomposition is the letter without its diacritics
+		while (c.decompositionTag()==QChar::Canonical)
+			c = c.decomposition().at(0).toCaseFolded();
+		folded[i] = c;
+	}
+	return folded;
+}
+
+QStringList StelObjectNameIndex::listMatching(const QString& objPrefix, int maxNbItem, bool useStartOfWords) const
+{
+	QStringList result;
+	if (maxNbItem<=0)
+		return result;
+
+	QVector<int> candidates;
+	if (findCandidates(foldName(objPrefix), useStartOfWords, candidates))
+	{
+		// the names are returned in the same order as when scanning them
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+		foreach (int i, candidates)
+		{
+			const QString& name = names.at(i);
+			if (!matchName(name, objPrefix, useStartOfWords))
+				continue;
+			result.append(name);
+			if (result.size()>=maxNbItem)
+				break;
+		}
+	}
+	else
+	{
+		foreach (const QString& name, names)
+		{
+			if (!matchName(name, objPrefix, useStartOfWords))
+				continue;
+			result.append(name);
+			if (result.size()>=maxNbItem)
+				break;
+		}
+	}
+
+	result.sort();
+	return result;
+}
+
+bool StelObjectNameIndex::findCandidates(const QString& key, bool useStartOfWords, QVector<int>& candidates) const
+{
+	// Common text matches many names, which are found quickly by scanning them
+	const int maxCandidates = qMax(64, names.size()/8);
+	if (key.isEmpty() || key.contains(QChar(0)) || names.size()<=maxCandidates)
+		return false;
+
+	QVector<int>::const_iterator begin, end;
+	if (useStartOfWords)
+	{
+		buildSortedNames();
+		findRange(sortedNames, foldedText.constData(), [this](int entry) { return nameStarts.at(entry); }, key, begin, end);
+		if (end-begin>maxCandidates)
+			return false;
+		for (QVector<int>::const_iterator it=begin; it!=end; ++it)
+			candidates.append(*it);
+	}
+	else
+	{
+		buildSuffixArray();
+		findRange(suffixes, foldedText.constData(), [](int entry) { return entry; }, key, begin, end);
+		if (end-begin>maxCandidates)
+			return false;
+		for (QVector<int>::const_iterator it=begin; it!=end; ++it)
+			candidates.append(static_cast<int>(std::upper_bound(nameStarts.constBegin(), nameStarts.constEnd(), *it) - nameStarts.constBegin()) - 1);
+	}
+	return true;
+}
+
+void StelObjectNameIndex::buildSortedNames() const
+{
+	if (sortedNames.size()==names.size())
+		return;
+
+	sortedNames.resize(names.size());
+	for (int i=0; i<names.size(); ++i)
+		sortedNames[i] = i;
+	const QChar* text = foldedText.constData();
+	std::sort(sortedNames.begin(), sortedNames.end(), [&](int a, int b) {
+		return lessText(text+nameStarts.at(a), text+nameStarts.at(b));
+	});
+}
+
+void StelObjectNameIndex::buildSuffixArray() const
+{
+	if (!suffixes.isEmpty() || names.isEmpty())
+		return;
+
+	suffixes.reserve(foldedText.size()-names.size());
+	const QChar* text = foldedText.constData();
+	for (int i=0; i<foldedText.size(); ++i)
+	{
+		if (!text[i].isNull())
+			suffixes.append(i);
+	}
+	std::sort(suffixes.begin(), suffixes.end(), [text](int a, int b) {
+		return lessText(text+a, text+b);
+	});
+}
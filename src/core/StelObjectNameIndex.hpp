@@ -0,0 +1,79 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _STELOBJECTNAMEINDEX_HPP_
+#define _STELOBJECTNAMEINDEX_HPP_
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//! @class StelObjectNameIndex
+//! Index of object names, used to find the names matching the text typed in the search dialog without
+//! comparing the text with every name.
+//! For the lookup, the names are folded to case folded characters without diacritics. Lookups of the start
+//! of names use the folded names in sorted order, and lookups of text anywhere in a name use a suffix array
+//! of the folded names. Both are built when they are first needed.
+//! The names found in the index are then checked with matchName(), so a lookup returns the same names as
+//! scanning the list of names.
+class StelObjectNameIndex
+{
+public:
+	StelObjectNameIndex();
+
+	//! Replace the indexed names. Their order is the order in which lookups find them.
+	void setNames(const QStringList& names);
+	//! Remove all names. The index is invalid until names are set again.
+	void clear();
+	//! Whether names were set since the index was created or cleared
+	bool isValid() const { return valid; }
+	int size() const { return names.size(); }
+
+	//! Find the first @param maxNbItem names matching @param objPrefix as matchName() does.
+	//! @return the matching names, sorted
+	QStringList listMatching(const QString& objPrefix, int maxNbItem, bool useStartOfWords) const;
+
+	//! Whether @param objName contains @param objPrefix, ignoring case.
+	//! If @param useStartOfWords is true, the name must start with it.
+	static bool matchName(const QString& objName, const QString& objPrefix, bool useStartOfWords);
+	//! Case fold each character of @param name and remove its diacritics.
+	//! The folded name has the same length as @param name, and names which match ignoring case have the same folded form.
+	static QString foldName(const QString& name);
+
+private:
+	//! Find the numbers of the names which may match @param key.
+	//! @return false if so many names may match that scanning them is faster
+	bool findCandidates(const QString& key, bool useStartOfWords, QVector<int>& candidates) const;
+	void buildSortedNames() const;
+	void buildSuffixArray() const;
+
+	QStringList names;
+	bool valid;
+	//! The folded names, each followed by a null character
+	QString foldedText;
+	//! Position of each folded name in foldedText
+	QVector<int> nameStarts;
+	//! Numbers of the names in the order of their folded names
+	mutable QVector<int> sortedNames;
+	//! Positions in foldedText in the order of the folded text which starts there
+	mutable QVector<int> suffixes;
+};
+
+#endif // _STELOBJECTNAMEINDEX_HPP_
@@ -0,0 +1,410 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StelProfiler.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QOpenGLContext>
+#ifndef QT_OPENGL_ES_2
+#include <QOpenGLTimerQuery>
+#endif
+
+#include <algorithm>
+
+StelProfiler* StelProfiler::singleton = Q_NULLPTR;
+bool StelProfiler::recording = false;
+
+namespace
+{
+	struct ScopeStat
+	{
+		ScopeStat() : nameId(0), category(StelProfiler::Update), cpuNs(0), gpuNs(0), gpuFrames(0) {}
+		int nameId;
+		StelProfiler::Category category;
+		qint64 cpuNs;
+		qint64 gpuNs;
+		int gpuFrames;
+	};
+
+	bool biggerCpuTime(const ScopeStat& a, const ScopeStat& b)
+	{
+		return a.cpuNs > b.cpuNs;
+	}
+
+	QString jsonEscaped(QString str)
+	{
+		return str.replace('\\', "\\\\").replace('"', "\\\"");
+	}
+
+	QString toMicroSeconds(qint64 ns)
+	{
+		return QString::number(ns/1000., 'f', 3);
+	}
+}
+
+StelProfiler::StelProfiler(QObject* parent)
+	: QObject(parent)
+	, flagEnabled(false)
+	, flagOverlayDisplayed(false)
+	, history(HistorySize)
+	, currentIndex(HistorySize-1)
+	, frameSerial(0)
+	, frameOpen(false)
+	, gpuTimerState(0)
+	, gpuSlotIndex(0)
+	, summaryTimeNs(-1)
+{
+	setObjectName("StelProfiler");
+	Q_ASSERT(!singleton);
+	singleton = this;
+	timer.start();
+}
+
+StelProfiler::~StelProfiler()
+{
+	recording = false;
+	singleton = Q_NULLPTR;
+	deleteGpuQueries();
+}
+
+bool StelProfiler::isInRecordingThread() const
+{
+	return QThread::currentThread()==thread();
+}
+
+void StelProfiler::setFlagEnabled(bool b)
+{
+	if (b==flagEnabled)
+		return;
+	if (!b)
+	{
+		endFrame();
+		setFlagOverlayDisplayed(false);
+	}
+	flagEnabled = b;
+	emit flagEnabledChanged(b);
+}
+
+void StelProfiler::setFlagOverlayDisplayed(bool b)
+{
+	if (b==flagOverlayDisplayed)
+		return;
+	flagOverlayDisplayed = b;
+	if (b)
+		setFlagEnabled(true);
+	emit flagOverlayDisplayedChanged(b);
+}
+
+int StelProfiler::getNameId(const QString& name)
+{
+	QHash<QString, int>::const_iterator it = nameIds.constFind(name);
+	if (it!=nameIds.constEnd())
+		return it.value();
+	const int id = names.size();
+	names.append(name);
+	nameIds.insert(name, id);
+	return id;
+}
+
+StelProfiler::Frame* StelProfiler::findFrame(qint64 serial)
+{
+	const qint64 age = frameSerial - serial;
+	if (serial<=0 || age<0 || age>=HistorySize)
+		return Q_NULLPTR;
+	Frame& f = history[(currentIndex - age + HistorySize) % HistorySize];
+	return f.serial==serial ? &f : Q_NULLPTR;
+}
+
+void StelProfiler::beginFrame()
+{
+	if (!flagEnabled || !isInRecordingThread())
+		return;
+	endFrame();
+
+	if (gpuTimerState==0)
+		initGpuTimer();
+
+	currentIndex = (currentIndex+1) % HistorySize;
+	Frame& f = history[currentIndex];
+	f.serial = ++frameSerial;
+	f.startNs = timer.nsecsElapsed();
+	f.durationNs = 0;
+	f.gpuDurationNs = -1;
+	f.events.resize(0);
+	openEvents.resize(0);
+	frameOpen = true;
+	recording = true;
+
+	if (gpuTimerState>0)
+	{
+		// The queries of the frame recorded GpuLatency frames ago are available by now
+		gpuSlotIndex = (gpuSlotIndex+1) % GpuLatency;
+		GpuSlot& slot = gpuSlots[gpuSlotIndex];
+		if (slot.frameSerial)
+			collectGpuSlot(slot);
+		slot.frameSerial = f.serial;
+		recordGpuTimestamp(); // always query 0, the start of the frame
+	}
+}
+
+void StelProfiler::endFrame()
+{
+	if (!frameOpen)
+		return;
+	while (!openEvents.isEmpty())
+		end();
+	Frame& f = history[currentIndex];
+	f.durationNs = timer.nsecsElapsed() - f.startNs;
+	if (gpuTimerState>0 && gpuSlots[gpuSlotIndex].frameSerial==f.serial)
+		gpuSlots[gpuSlotIndex].frameEndQuery = recordGpuTimestamp();
+	frameOpen = false;
+	recording = false;
+}
+
+void StelProfiler::begin(const QString& name, Category category)
+{
+	if (!frameOpen)
+		return;
+	Frame& f = history[currentIndex];
+	Event e;
+	e.nameId = getNameId(name);
+	e.category = category;
+	e.depth = openEvents.size();
+	e.startNs = timer.nsecsElapsed() - f.startNs;
+	e.durationNs = 0;
+	e.gpuStartNs = -1;
+	e.gpuDurationNs = -1;
+	e.gpuBeginQuery = (category==Draw && gpuTimerState>0) ? recordGpuTimestamp() : -1;
+	e.gpuEndQuery = -1;
+	openEvents.append(f.events.size());
+	f.events.append(e);
+}
+
+void StelProfiler::end()
+{
+	if (!frameOpen || openEvents.isEmpty())
+		return;
+	Frame& f = history[currentIndex];
+	Event& e = f.events[openEvents.takeLast()];
+	e.durationNs = timer.nsecsElapsed() - f.startNs - e.startNs;
+	if (e.gpuBeginQuery>=0)
+		e.gpuEndQuery = recordGpuTimestamp();
+}
+
+void StelProfiler::initGpuTimer()
+{
+	QOpenGLContext* ctx = QOpenGLContext::currentContext();
+	if (!ctx)
+		return;
+	bool supported = false;
+#ifndef QT_OPENGL_ES_2
+	supported = !ctx->isOpenGLES() && (ctx->format().version() >= qMakePair(3,3) || ctx->hasExtension("GL_ARB_timer_query"));
+#endif
+	gpuTimerState = supported ? 1 : -1;
+	qDebug() << "StelProfiler: GPU timing" << (supported ? "enabled" : "not supported by the OpenGL context");
+}
+
+int StelProfiler::recordGpuTimestamp()
+{
+#ifndef QT_OPENGL_ES_2
+	GpuSlot& slot = gpuSlots[gpuSlotIndex];
+	if (slot.used==slot.queries.size())
+	{
+		if (slot.used>=MaxGpuQueries)
+			return -1;
+		QOpenGLTimerQuery* query = new QOpenGLTimerQuery();
+		if (!query->create())
+		{
+			delete query;
+			qWarning() << "StelProfiler: cannot create OpenGL timer query, GPU timing disabled";
+			gpuTimerState = -1;
+			return -1;
+		}
+		slot.queries.append(query);
+	}
+	slot.queries[slot.used]->recordTimestamp();
+	return slot.used++;
+#else
+	return -1;
+#endif
+}
+
+void StelProfiler::collectGpuSlot(GpuSlot& slot)
+{
+#ifndef QT_OPENGL_ES_2
+	Frame* f = findFrame(slot.frameSerial);
+	if (f && slot.used>0)
+	{
+		const qint64 base = slot.queries[0]->waitForResult();
+		if (slot.frameEndQuery>0)
+			f->gpuDurationNs = qint64(slot.queries[slot.frameEndQuery]->waitForResult()) - base;
+		for (int i=0; i<f->events.size(); ++i)
+		{
+			Event& e = f->events[i];
+			if (e.gpuBeginQuery<0 || e.gpuEndQuery<0)
+				continue;
+			const qint64 begin = slot.queries[e.gpuBeginQuery]->waitForResult();
+			e.gpuStartNs = begin - base;
+			e.gpuDurationNs = qint64(slot.queries[e.gpuEndQuery]->waitForResult()) - begin;
+		}
+	}
+#endif
+	slot.used = 0;
+	slot.frameSerial = 0;
+	slot.frameEndQuery = -1;
+}
+
+void StelProfiler::deleteGpuQueries()
+{
+	for (int i=0; i<GpuLatency; ++i)
+	{
+		qDeleteAll(gpuSlots[i].queries);
+		gpuSlots[i].queries.clear();
+		gpuSlots[i].used = 0;
+		gpuSlots[i].frameSerial = 0;
+	}
+}
+
+void StelProfiler::clear()
+{
+	endFrame();
+	for (int i=0; i<HistorySize; ++i)
+	{
+		history[i].serial = 0;
+		history[i].events.clear();
+	}
+	summary.clear();
+	summaryTimeNs = -1;
+}
+
+QStringList StelProfiler::getSummary(int maxScopes)
+{
+	const qint64 now = timer.nsecsElapsed();
+	if (summaryTimeNs>=0 && now-summaryTimeNs<500000000)
+		return summary;
+	summaryTimeNs = now;
+
+	int frames = 0, gpuFrames = 0;
+	qint64 frameNs = 0, maxFrameNs = 0, gpuFrameNs = 0;
+	QHash<int, ScopeStat> stats;
+	for (int i=0; i<HistorySize; ++i)
+	{
+		const Frame& f = history[i];
+		if (f.serial==0 || (frameOpen && i==currentIndex))
+			continue;
+		++frames;
+		frameNs += f.durationNs;
+		maxFrameNs = qMax(maxFrameNs, f.durationNs);
+		if (f.gpuDurationNs>=0)
+		{
+			++gpuFrames;
+			gpuFrameNs += f.gpuDurationNs;
+		}
+		foreach (const Event& e, f.events)
+		{
+			ScopeStat& s = stats[e.nameId*2 + e.category];
+			s.nameId = e.nameId;
+			s.category = e.category;
+			s.cpuNs += e.durationNs;
+			if (e.gpuDurationNs>=0)
+			{
+				s.gpuNs += e.gpuDurationNs;
+				++s.gpuFrames;
+			}
+		}
+	}
+
+	summary.clear();
+	if (frames==0)
+	{
+		summary << "Profiler: no frames recorded";
+		return summary;
+	}
+	QString frameLine = QString("Frame: %1 ms CPU (max %2 ms)").arg(frameNs/1e6/frames, 0, 'f', 2).arg(maxFrameNs/1e6, 0, 'f', 2);
+	if (gpuFrames>0)
+		frameLine += QString(", %1 ms GPU").arg(gpuFrameNs/1e6/gpuFrames, 0, 'f', 2);
+	summary << frameLine + QString(", average of %1 frames").arg(frames);
+	summary << QString("%1 %2  scope").arg("CPU ms", 7).arg("GPU ms", 7);
+
+	QVector<ScopeStat> sorted;
+	sorted.reserve(stats.size());
+	foreach (const ScopeStat& s, stats)
+		sorted.append(s);
+	std::sort(sorted.begin(), sorted.end(), biggerCpuTime);
+	for (int i=0; i<sorted.size() && i<maxScopes; ++i)
+	{
+		const ScopeStat& s = sorted.at(i);
+		const QString gpu = s.gpuFrames>0 ? QString::number(s.gpuNs/1e6/s.gpuFrames, 'f', 3) : QString("-");
+		summary << QString("%1 %2  %3 %4").arg(s.cpuNs/1e6/frames, 7, 'f', 3).arg(gpu, 7)
+			   .arg(s.category==Draw ? "draw  " : "update").arg(names.at(s.nameId));
+	}
+	return summary;
+}
+
+bool StelProfiler::saveTrace(const QString& fileName) const
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning() << "StelProfiler: cannot write trace file" << fileName << ":" << file.errorString();
+		return false;
+	}
+	QTextStream out(&file);
+	out.setCodec("UTF-8");
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Stellarium\"}},\n";
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	// GPU timestamps have their own clock, they are shown relative to the CPU start of their frame.
+	out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+	// Oldest frame first
+	for (int i=1; i<=HistorySize; ++i)
+	{
+		const int index = (currentIndex+i) % HistorySize;
+		const Frame& f = history[index];
+		if (f.serial==0 || (frameOpen && index==currentIndex))
+			continue;
+		out << ",\n{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << toMicroSeconds(f.startNs)
+		    << ",\"dur\":" << toMicroSeconds(f.durationNs) << ",\"args\":{\"frame\":" << f.serial << "}}";
+		if (f.gpuDurationNs>=0)
+			out << ",\n{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":" << toMicroSeconds(f.startNs)
+			    << ",\"dur\":" << toMicroSeconds(f.gpuDurationNs) << ",\"args\":{\"frame\":" << f.serial << "}}";
+		foreach (const Event& e, f.events)
+		{
+			const QString name = jsonEscaped(names.at(e.nameId));
+			const char* category = e.category==Draw ? "draw" : "update";
+			out << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+			    << toMicroSeconds(f.startNs+e.startNs) << ",\"dur\":" << toMicroSeconds(e.durationNs) << "}";
+			if (e.gpuDurationNs>=0)
+				out << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":"
+				    << toMicroSeconds(f.startNs+e.gpuStartNs) << ",\"dur\":" << toMicroSeconds(e.gpuDurationNs) << "}";
+		}
+	}
+	out << "\n]}\n";
+	out.flush();
+	if (out.status()!=QTextStream::Ok || file.error()!=QFile::NoError)
+	{
+		qWarning() << "StelProfiler: error while writing trace file" << fileName << ":" << file.errorString();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,212 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STELPROFILER_HPP_
+#define _STELPROFILER_HPP_
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QElapsedTimer>
+
+class QOpenGLTimerQuery;
+
+//! @class StelProfiler
+//! Records how much time the modules, and some expensive phases inside them, take in every frame.
+//! CPU times are measured with a monotonic clock. Scopes of the Draw category are also measured on the GPU
+//! with OpenGL timestamp queries, if the context supports them (OpenGL 3.3 or GL_ARB_timer_query).
+//! The query results are only collected a few frames later, so profiling does not stall the GPU pipeline.
+//!
+//! The last HistorySize frames are kept in a ring buffer. They can be summarized for the on-screen
+//! overlay (see getSummary()) and exported as a Chrome trace file, which can be opened in
+//! chrome://tracing or https://ui.perfetto.dev.
+//!
+//! Profiling is disabled by default, then a scope only costs a branch. Only scopes of the main thread are recorded.
+//! To time a block of code, put a Scope object at its beginning:
+//! @code
+//! StelProfiler::Scope scope("StarMgr: zones", StelProfiler::Draw);
+//! @endcode
+class StelProfiler : public QObject
+{
+	Q_OBJECT
+	Q_PROPERTY(bool enabled READ getFlagEnabled WRITE setFlagEnabled NOTIFY flagEnabledChanged)
+	Q_PROPERTY(bool overlayDisplayed READ getFlagOverlayDisplayed WRITE setFlagOverlayDisplayed NOTIFY flagOverlayDisplayedChanged)
+
+public:
+	//! The phase of the frame a scope belongs to. Draw scopes are also timed on the GPU.
+	enum Category
+	{
+		Update,
+		Draw
+	};
+
+	//! Number of frames kept in the history ring buffer
+	static const int HistorySize = 600;
+
+	//! Times the enclosing block if the profiler is recording.
+	class Scope
+	{
+	public:
+		Scope(const char* name, Category category=Update) : active(StelProfiler::isRecording())
+		{
+			if (active)
+				singleton->begin(QString::fromLatin1(name), category);
+		}
+		Scope(const QString& name, Category category=Update) : active(StelProfiler::isRecording())
+		{
+			if (active)
+				singleton->begin(name, category);
+		}
+		~Scope()
+		{
+			if (active)
+				singleton->end();
+		}
+	private:
+		Q_DISABLE_COPY(Scope)
+		bool active;
+	};
+
+	StelProfiler(QObject* parent=Q_NULLPTR);
+	~StelProfiler();
+
+	//! Returns true if frames are being recorded, and we are in the thread which records them.
+	static bool isRecording() { return recording && singleton->isInRecordingThread(); }
+
+	//! Start recording a new frame. Finishes the previous frame if necessary.
+	//! If an OpenGL context is current, the GPU results of older frames are collected.
+	void beginFrame();
+	//! Finish recording the current frame.
+	void endFrame();
+	//! Start timing a scope, which ends with the matching call to end(). Prefer using a Scope object.
+	void begin(const QString& name, Category category=Update);
+	//! End the scope started with the last call to begin().
+	void end();
+
+	bool getFlagEnabled() const { return flagEnabled; }
+	bool getFlagOverlayDisplayed() const { return flagOverlayDisplayed; }
+
+	//! Returns the lines of the overlay: average and maximum frame times, then the scopes with the largest
+	//! average CPU times over the history, with their GPU times where available.
+	//! The summary is recomputed at most twice per second.
+	//! @param maxScopes the maximal number of scope lines
+	QStringList getSummary(int maxScopes=30);
+
+	//! Write the recorded frame history as a Chrome trace (JSON trace event format).
+	//! CPU scopes are shown as one thread, GPU scopes as another one.
+	//! @return false if the file could not be written.
+	bool saveTrace(const QString& fileName) const;
+
+	//! Discard the recorded history
+	void clear();
+
+public slots:
+	//! Enable or disable the recording of frames. Disabling keeps the history.
+	void setFlagEnabled(bool b);
+	//! Show or hide the overlay. Showing the overlay enables the recording.
+	void setFlagOverlayDisplayed(bool b);
+
+signals:
+	void flagEnabledChanged(bool b);
+	void flagOverlayDisplayedChanged(bool b);
+
+private:
+	struct Event
+	{
+		int nameId;
+		Category category;
+		int depth;
+		//! CPU start relative to the start of the frame, and duration, in nanoseconds
+		qint64 startNs;
+		qint64 durationNs;
+		//! GPU start relative to the start of the frame on the GPU, and duration, in nanoseconds. -1 if not measured (yet)
+		qint64 gpuStartNs;
+		qint64 gpuDurationNs;
+		//! Indices of the timestamp queries in the GPU slot of the frame, or -1
+		int gpuBeginQuery;
+		int gpuEndQuery;
+	};
+
+	struct Frame
+	{
+		Frame() : serial(0), startNs(0), durationNs(0), gpuDurationNs(-1) {}
+		//! Unique frame number, 0 for unused history entries
+		qint64 serial;
+		//! CPU start since the profiler was created, and duration, in nanoseconds
+		qint64 startNs;
+		qint64 durationNs;
+		//! GPU duration in nanoseconds, -1 if not measured (yet)
+		qint64 gpuDurationNs;
+		QVector<Event> events;
+	};
+
+	//! Timestamp queries of one frame whose results have not been collected yet
+	struct GpuSlot
+	{
+		GpuSlot() : used(0), frameSerial(0), frameEndQuery(-1) {}
+		QVector<QOpenGLTimerQuery*> queries;
+		int used;
+		qint64 frameSerial;
+		int frameEndQuery;
+	};
+	//! Number of frames between issuing the GPU queries and collecting their results
+	static const int GpuLatency = 3;
+	//! Maximal number of timestamp queries per frame
+	static const int MaxGpuQueries = 1024;
+
+	bool isInRecordingThread() const;
+	int getNameId(const QString& name);
+	//! Record a GPU timestamp in the slot of the current frame, and return its index or -1
+	int recordGpuTimestamp();
+	//! Copy the GPU results of the frame recorded in @param slot into the history, and release the slot
+	void collectGpuSlot(GpuSlot& slot);
+	void initGpuTimer();
+	void deleteGpuQueries();
+	//! Return the history frame with the given serial number, or Q_NULLPTR if it was overwritten
+	Frame* findFrame(qint64 serial);
+
+	static StelProfiler* singleton;
+	static bool recording;
+
+	bool flagEnabled;
+	bool flagOverlayDisplayed;
+
+	QElapsedTimer timer;
+	QVector<Frame> history;
+	int currentIndex;
+	qint64 frameSerial;
+	bool frameOpen;
+	//! Indices of the open events of the current frame
+	QVector<int> openEvents;
+
+	QHash<QString, int> nameIds;
+	QVector<QString> names;
+
+	//! GPU timing state: 0 not checked yet, 1 supported, -1 not supported
+	int gpuTimerState;
+	GpuSlot gpuSlots[GpuLatency];
+	int gpuSlotIndex;
+
+	QStringList summary;
+	qint64 summaryTimeNs;
+};
+
+#endif // _STELPROFILER_HPP_
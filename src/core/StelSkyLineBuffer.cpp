@@ -0,0 +1,219 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "StelSkyLineBuffer.hpp"
+#include "StelPainter.hpp"
+#include "StelProjector.hpp"
+
+#include <QDebug>
+#include <QOpenGLShaderProgram>
+
+StelSkyLineBuffer::StelSkyLineBuffer(double maxSegmentAngle)
+	: maxSegmentAngle(maxSegmentAngle)
+	, boundingCapsDirty(false)
+	, projectedBuffer(QOpenGLBuffer::VertexBuffer)
+	, shaderProgram(Q_NULLPTR)
+	, shaderFailed(false)
+{
+	projectedBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+}
+
+StelSkyLineBuffer::~StelSkyLineBuffer()
+{
+	delete shaderProgram;
+	shaderProgram = Q_NULLPTR;
+}
+
+void StelSkyLineBuffer::clear()
+{
+	vertices.clear();
+	projected.clear();
+	groups.clear();
+	boundingCapsDirty = false;
+}
+
+int StelSkyLineBuffer::beginGroup()
+{
+	Group group;
+	group.first = vertices.size();
+	group.count = 0;
+	group.visible = false;
+	groups.append(group);
+	return groups.size()-1;
+}
+
+void StelSkyLineBuffer::addArc(const Vec3d& p1, const Vec3d& p2)
+{
+	Q_ASSERT(!groups.isEmpty());
+	const double cosAngle = qBound(-1., p1*p2, 1.);
+	const double angle = std::acos(cosAngle);
+	const double sinAngle = std::sin(angle);
+	// The arc between antipodal points is undefined
+	if (sinAngle<1e-9 && cosAngle<0.)
+		return;
+
+	const int nbSegments = qMax(1, static_cast<int>(std::ceil(angle/maxSegmentAngle)));
+	Vec3f prev(p1[0], p1[1], p1[2]);
+	for (int i=1; i<=nbSegments; ++i)
+	{
+		Vec3d p = p2;
+		if (i<nbSegments)
+		{
+			// interpolate along the great circle
+			const double t = static_cast<double>(i)/nbSegments;
+			p = p1*(std::sin((1.-t)*angle)/sinAngle) + p2*(std::sin(t*angle)/sinAngle);
+		}
+		const Vec3f next(p[0], p[1], p[2]);
+		vertices << prev << next;
+		prev = next;
+	}
+	groups.last().count = vertices.size()-groups.last().first;
+	boundingCapsDirty = true;
+}
+
+void StelSkyLineBuffer::updateBoundingCaps()
+{
+	for (int g=0; g<groups.size(); ++g)
+	{
+		Group& group = groups[g];
+		Vec3d center(0.);
+		for (int i=group.first; i<group.first+group.count; ++i)
+			center += Vec3d(vertices.at(i)[0], vertices.at(i)[1], vertices.at(i)[2]);
+		if (center.lengthSquared()<1e-12)
+		{
+			// the whole sphere
+			group.boundingCap = SphericalCap(Vec3d(1., 0., 0.), -1.);
+			continue;
+		}
+		center.normalize();
+		double d = 1.;
+		for (int i=group.first; i<group.first+group.count; ++i)
+			d = qMin(d, center[0]*vertices.at(i)[0]+center[1]*vertices.at(i)[1]+center[2]*vertices.at(i)[2]);
+		// A cap larger than a hemisphere doesn't contain the arcs between its points, use the whole sphere then.
+		// The small margin covers the rounding of the float vertices.
+		group.boundingCap = SphericalCap(center, d<0. ? -1. : d-0.0001);
+	}
+	boundingCapsDirty = false;
+}
+
+bool StelSkyLineBuffer::initShader()
+{
+	if (shaderProgram)
+		return true;
+	if (shaderFailed)
+		return false;
+
+	QOpenGLShader vShader(QOpenGLShader::Vertex);
+	const char *vsrc =
+		"attribute highp vec4 vertex;\n"
+		"uniform mediump mat4 projectionMatrix;\n"
+		"varying mediump float projected;\n"
+		"void main(void)\n"
+		"{\n"
+		"    gl_Position = projectionMatrix*vec4(vertex.xyz, 1.);\n"
+		"    projected = vertex.w;\n"
+		"}\n";
+	QOpenGLShader fShader(QOpenGLShader::Fragment);
+	// Segments with an end which could not be projected are interpolated from 0 and are discarded
+	const char *fsrc =
+		"uniform mediump vec4 color;\n"
+		"varying mediump float projected;\n"
+		"void main(void)\n"
+		"{\n"
+		"    if (projected<0.999)\n"
+		"        discard;\n"
+		"    gl_FragColor = color;\n"
+		"}\n";
+	if (!vShader.compileSourceCode(vsrc) || !fShader.compileSourceCode(fsrc))
+	{
+		qWarning() << "StelSkyLineBuffer: error while compiling shaders:" << vShader.log() << fShader.log();
+		shaderFailed = true;
+		return false;
+	}
+	shaderProgram = new QOpenGLShaderProgram();
+	shaderProgram->addShader(&vShader);
+	shaderProgram->addShader(&fShader);
+	if (!StelPainter::linkProg(shaderProgram, "skyLineBuffer"))
+	{
+		delete shaderProgram;
+		shaderProgram = Q_NULLPTR;
+		shaderFailed = true;
+		return false;
+	}
+	shaderVars.projectionMatrix = shaderProgram->uniformLocation("projectionMatrix");
+	shaderVars.color = shaderProgram->uniformLocation("color");
+	shaderVars.vertex = shaderProgram->attributeLocation("vertex");
+	return true;
+}
+
+bool StelSkyLineBuffer::project(StelPainter& painter)
+{
+	const StelProjectorP& prj = painter.getProjector();
+	if (prj->hasDiscontinuity() || !initShader())
+		return false;
+	if (!projectedBuffer.isCreated() && !projectedBuffer.create())
+		return false;
+
+	if (boundingCapsDirty)
+		updateBoundingCaps();
+	const SphericalCap& viewportCap = prj->getBoundingCap();
+	projected.resize(vertices.size());
+	Vec3f win;
+	for (int g=0; g<groups.size(); ++g)
+	{
+		Group& group = groups[g];
+		group.visible = group.count>0 && group.boundingCap.intersects(viewportCap);
+		if (!group.visible)
+			continue;
+		for (int i=group.first; i<group.first+group.count; ++i)
+		{
+			const bool ok = prj->project(vertices.at(i), win);
+			projected[i].set(win[0], win[1], win[2], ok ? 1.f : 0.f);
+		}
+	}
+
+	projectedBuffer.bind();
+	projectedBuffer.allocate(projected.constData(), projected.size()*sizeof(Vec4f));
+	projectedBuffer.release();
+
+	const Mat4f& m = prj->getProjectionMatrix();
+	projectionMatrix = QMatrix4x4(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]);
+	return true;
+}
+
+void StelSkyLineBuffer::draw(StelPainter& painter, int group)
+{
+	Q_ASSERT(shaderProgram);
+	const Group& g = groups.at(group);
+	if (!g.visible)
+		return;
+
+	const Vec4f color = painter.getColor();
+	shaderProgram->bind();
+	projectedBuffer.bind();
+	shaderProgram->setAttributeBuffer(shaderVars.vertex, GL_FLOAT, 0, 4);
+	shaderProgram->enableAttributeArray(shaderVars.vertex);
+	shaderProgram->setUniformValue(shaderVars.projectionMatrix, projectionMatrix);
+	shaderProgram->setUniformValue(shaderVars.color, color[0], color[1], color[2], color[3]);
+	painter.glFuncs()->glDrawArrays(GL_LINES, g.first, g.count);
+	shaderProgram->disableAttributeArray(shaderVars.vertex);
+	projectedBuffer.release();
+	shaderProgram->release();
+}
@@ -0,0 +1,111 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _STELSKYLINEBUFFER_HPP_
+#define _STELSKYLINEBUFFER_HPP_
+
+#include "StelSphereGeometry.hpp"
+#include "VecMath.hpp"
+
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QVector>
+
+class QOpenGLShaderProgram;
+class StelPainter;
+
+//! @class StelSkyLineBuffer
+//! A fixed set of great circle arcs on the sky, like constellation lines or boundaries, which is drawn in groups.
+//! The arcs are subdivided once into short segments when they are added, instead of calling
+//! StelPainter::drawGreatCircleArc() for each arc in each frame. Per frame, the segments of all visible
+//! groups are projected and uploaded into a single vertex buffer, and each group is drawn with one draw call
+//! with its color as uniform.
+//! Segments with an end which can't be projected are not drawn. Projections with discontinuities
+//! are not supported, project() then returns false and the arcs must be drawn the usual way.
+//!
+//! Typical use:
+//! @code
+//! if (buffer.project(painter))
+//! {
+//! 	painter.setColor(r, g, b, fade);
+//! 	buffer.draw(painter, group);
+//! }
+//! @endcode
+class StelSkyLineBuffer
+{
+public:
+	//! @param maxSegmentAngle arcs are subdivided into segments of at most this angle (in radians)
+	StelSkyLineBuffer(double maxSegmentAngle = 0.5*M_PI/180.);
+	~StelSkyLineBuffer();
+
+	//! Remove all groups.
+	void clear();
+	//! Start a new group. The following arcs are added to this group.
+	//! @return the index of the group
+	int beginGroup();
+	//! Add the great circle arc between the normalized vectors p1 and p2 to the current group.
+	void addArc(const Vec3d& p1, const Vec3d& p2);
+
+	int getGroupCount() const {return groups.size();}
+	//! Number of segment ends, i.e. twice the number of segments
+	int getVertexCount() const {return vertices.size();}
+
+	//! Project the segments of all groups visible in the viewport of the painter.
+	//! Must be called in each frame before draw().
+	//! @return false if the buffer can't be drawn with this projection.
+	bool project(StelPainter& painter);
+	//! Draw a group with the current color of the painter.
+	void draw(StelPainter& painter, int group);
+
+private:
+	struct Group
+	{
+		int first;
+		int count;
+		SphericalCap boundingCap;
+		bool visible;
+	};
+
+	//! Compute the bounding caps of the groups
+	void updateBoundingCaps();
+	bool initShader();
+
+	const double maxSegmentAngle;
+	//! Pairs of segment ends in the frame of the arcs
+	QVector<Vec3f> vertices;
+	//! Projected segment ends, the 4th component is 1 if the point could be projected and 0 otherwise
+	QVector<Vec4f> projected;
+	QVector<Group> groups;
+	bool boundingCapsDirty;
+
+	QOpenGLBuffer projectedBuffer;
+	QOpenGLShaderProgram* shaderProgram;
+	bool shaderFailed;
+	QMatrix4x4 projectionMatrix;
+	struct ShaderVars
+	{
+		int projectionMatrix;
+		int color;
+		int vertex;
+	};
+	ShaderVars shaderVars;
+};
+
+#endif // _STELSKYLINEBUFFER_HPP_
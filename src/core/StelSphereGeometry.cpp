@@ -852,6 +852,11 @@ bool SphericalConvexPolygon::checkValidContour(const QVector<Vec3d>& contour)
 
 //! Return the area of the region in steradians.
 double SphericalConvexPolygon::getArea() const
+{
+	return cache.getArea([this]() {return computeArea();});
+}
+
+double SphericalConvexPolygon::computeArea() const
 {
 	double area = 0.;
 	Vec3d ar[3];
@@ -998,6 +1003,7 @@ bool SphericalConvexPolygon::intersects(const SphericalPolygon& poly) const
 void SphericalConvexPolygon::updateBoundingCap()
 {
 	Q_ASSERT(contour.size()>2);
+	cache.clear();
 	// Use this crapy algorithm instead
 	cachedBoundingCap.n.set(0,0,0);
 	foreach (const Vec3d& v, contour)
@@ -27,6 +27,7 @@
 #include <QVector>
 #include <QVariant>
 #include <QDebug>
+#include <QMutex>
 #include <QSharedPointer>
 #include <QVarLengthArray>
 #include <QDataStream>
@@ -126,6 +127,72 @@ QDataStream& operator<<(QDataStream& out, const SphericalRegionP& region);
 //! Load the SphericalRegionP from a binary blob.
 QDataStream& operator>>(QDataStream& in, SphericalRegionP& region);
 
+//! @class SphericalRegionCache
+//! Memoises the geometry derived from a region: its OctahedronPolygon and its area.
+//! The values are computed on first use, and kept until the region calls clear() because its shape has changed.
+//! It can be used by several threads at the same time. The values are computed outside of the lock, and a value
+//! computed before a call to clear() is not stored. Clearing only drops the reference of the cache, so a polygon which
+//! another thread is still reading stays valid. Copies of a region start with an empty cache.
+class SphericalRegionCache
+{
+public:
+	SphericalRegionCache() : area(-1.), generation(0) {;}
+	SphericalRegionCache(const SphericalRegionCache&) : area(-1.), generation(0) {;}
+	SphericalRegionCache& operator=(const SphericalRegionCache&) {clear(); return *this;}
+
+	//! Return the cached OctahedronPolygon, calling @param compute to create it if needed.
+	template<class Compute> OctahedronPolygon getOctahedronPolygon(Compute compute) const
+	{
+		QSharedPointer<const OctahedronPolygon> poly;
+		quint32 gen;
+		{
+			QMutexLocker locker(&mutex);
+			poly = octahedronPolygon;
+			gen = generation;
+		}
+		if (poly.isNull())
+		{
+			poly = QSharedPointer<const OctahedronPolygon>(new OctahedronPolygon(compute()));
+			QMutexLocker locker(&mutex);
+			if (gen==generation && octahedronPolygon.isNull())
+				octahedronPolygon = poly;
+		}
+		return *poly;
+	}
+
+	//! Return the cached area, calling @param compute to compute it if needed.
+	template<class Compute> double getArea(Compute compute) const
+	{
+		quint32 gen;
+		{
+			QMutexLocker locker(&mutex);
+			if (area>=0.)
+				return area;
+			gen = generation;
+		}
+		const double a = compute();
+		QMutexLocker locker(&mutex);
+		if (gen==generation)
+			area = a;
+		return a;
+	}
+
+	//! Forget all values, to be called when the region changes.
+	void clear()
+	{
+		QMutexLocker locker(&mutex);
+		octahedronPolygon.clear();
+		area = -1.;
+		++generation;
+	}
+
+private:
+	mutable QMutex mutex;
+	mutable QSharedPointer<const OctahedronPolygon> octahedronPolygon;
+	mutable double area;
+	quint32 generation;
+};
+
 //! @class SphericalRegion
 //! Abstract class defining a region of the sphere. It provides default implementation for the general non-convex polygon
 //! which can extend on more than 180 deg based on the OctahedronPolygon class.
@@ -562,6 +629,7 @@ public:
 
 	virtual SphericalRegionType getType() const {return SphericalRegion::Polygon;}
 	virtual OctahedronPolygon getOctahedronPolygon() const {return octahedronPolygon;}
+	virtual double getArea() const {return cache.getArea([this]() {return octahedronPolygon.getArea();});}
 
 	//! Serialize the region into a QVariant map matching the JSON format.
 	//! The format is:
@@ -599,11 +667,11 @@ public:
 	//! Set the contours defining the SphericalPolygon.
 	//! @param contours the list of contours defining the polygon area. The contours are combined using
 	//! the positive winding rule, meaning that the polygon is the union of the positive contours minus the negative ones.
-	void setContours(const QVector<QVector<Vec3d> >& contours) {octahedronPolygon = OctahedronPolygon(contours);}
+	void setContours(const QVector<QVector<Vec3d> >& contours) {octahedronPolygon = OctahedronPolygon(contours); cache.clear();}
 
 	//! Set a single contour defining the SphericalPolygon.
 	//! @param contour a contour defining the polygon area.
-	void setContour(const QVector<Vec3d>& contour) {octahedronPolygon = OctahedronPolygon(contour);}
+	void setContour(const QVector<Vec3d>& contour) {octahedronPolygon = OctahedronPolygon(contour); cache.clear();}
 
 	//! Return the list of closed contours defining the polygon boundaries.
 	QVector<QVector<Vec3d> > getClosedOutlineContours() const {Q_ASSERT(0); return QVector<QVector<Vec3d> >();}
@@ -619,6 +687,8 @@ public:
 
 private:
 	OctahedronPolygon octahedronPolygon;
+	//! The area, which is computed from the triangles of octahedronPolygon.
+	SphericalRegionCache cache;
 };
 
 
@@ -644,7 +714,7 @@ public:
 	SphericalConvexPolygon(const Vec3d &e0,const Vec3d &e1,const Vec3d &e2, const Vec3d &e3)  {contour << e0 << e1 << e2 << e3; updateBoundingCap();}
 
 	virtual SphericalRegionType getType() const {return SphericalRegion::ConvexPolygon;}
-	virtual OctahedronPolygon getOctahedronPolygon() const {return OctahedronPolygon(contour);}
+	virtual OctahedronPolygon getOctahedronPolygon() const {return cache.getOctahedronPolygon([this]() {return OctahedronPolygon(contour);});}
 	virtual StelVertexArray getFillVertexArray() const {return StelVertexArray(contour, StelVertexArray::TriangleFan);}
 	virtual StelVertexArray getOutlineVertexArray() const {return StelVertexArray(contour, StelVertexArray::LineLoop);}
 	virtual double getArea() const;
@@ -715,9 +785,15 @@ protected:
 	//! Cache the bounding cap.
 	SphericalCap cachedBoundingCap;
 
-	//! Update the bounding cap from the vertex list.
+	//! Cache the tesselated OctahedronPolygon and the area.
+	SphericalRegionCache cache;
+
+	//! Update the bounding cap from the vertex list, and forget the other cached geometry.
 	void updateBoundingCap();
 
+	//! Compute the area with Girard's theorem for each triangle of the fan.
+	double computeArea() const;
+
 	//! Computes whether the passed points are all outside of at least one SphericalCap defining the polygon boundary.
 	//! @param thisContour the vertices defining the contour.
 	//! @param nbThisContour nb of vertice of the contour.
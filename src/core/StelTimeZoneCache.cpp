@@ -0,0 +1,84 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "StelTimeZoneCache.hpp"
+
+#include <QDateTime>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <cmath>
+
+const qint64 StelTimeZoneCache::CACHE_BEGIN=Q_INT64_C(-5364662400000);
+const qint64 StelTimeZoneCache::CACHE_END=Q_INT64_C(7258118400000);
+
+bool StelTimeZoneCache::offset(const QString& tzName, qint64 msecsUtc, bool useDST, int* shiftInSeconds)
+{
+	QMutexLocker locker(&mutex);
+	QHash<QString, Zone>::ConstIterator iter=zones.constFind(tzName);
+	if (iter==zones.constEnd())
+		iter=zones.insert(tzName, build(tzName));
+	const Zone& z=iter.value();
+	if (!z.tz.isValid())
+		return false;
+
+	if (!z.tabulated || msecsUtc<CACHE_BEGIN || msecsUtc>=CACHE_END)
+	{
+		const QDateTime universal=QDateTime::fromMSecsSinceEpoch(msecsUtc, Qt::UTC);
+		*shiftInSeconds = useDST ? z.tz.offsetFromUtc(universal) : z.tz.standardTimeOffset(universal);
+		return true;
+	}
+
+	const int i=std::upper_bound(z.validFrom.constBegin(), z.validFrom.constEnd(), msecsUtc)-z.validFrom.constBegin()-1;
+	*shiftInSeconds = useDST ? z.offsetFromUtc.at(i) : z.standardTimeOffset.at(i);
+	return true;
+}
+
+qint64 StelTimeZoneCache::jdToMSecsSinceEpoch(double JD)
+{
+	// JD 2440587.5 is 1970-01-01T00:00:00 UTC
+	return static_cast<qint64>(std::floor((JD-2440587.5)*86400.+0.5))*1000;
+}
+
+StelTimeZoneCache::Zone StelTimeZoneCache::build(const QString& tzName)
+{
+	Zone z;
+	z.tz=QTimeZone(tzName.toUtf8());
+	z.tabulated=z.tz.isValid() && z.tz.hasTransitions();
+	if (!z.tabulated)
+		return z;
+
+	const QDateTime begin=QDateTime::fromMSecsSinceEpoch(CACHE_BEGIN, Qt::UTC);
+	z.validFrom.append(CACHE_BEGIN);
+	z.offsetFromUtc.append(z.tz.offsetFromUtc(begin));
+	z.standardTimeOffset.append(z.tz.standardTimeOffset(begin));
+
+	const QTimeZone::OffsetDataList transitions=z.tz.transitions(begin, QDateTime::fromMSecsSinceEpoch(CACHE_END, Qt::UTC));
+	for (QTimeZone::OffsetDataList::ConstIterator t=transitions.constBegin(); t!=transitions.constEnd(); ++t)
+	{
+		const qint64 atUtc=t->atUtc.toMSecsSinceEpoch();
+		if (atUtc<=z.validFrom.last())
+			continue;
+		z.validFrom.append(atUtc);
+		z.offsetFromUtc.append(t->offsetFromUtc);
+		z.standardTimeOffset.append(t->standardTimeOffset);
+	}
+	return z;
+}
@@ -0,0 +1,75 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _STELTIMEZONECACHE_HPP_
+#define _STELTIMEZONECACHE_HPP_
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QTimeZone>
+#include <QVector>
+
+//! @class StelTimeZoneCache
+//! Cache of time zones and their UTC offset transitions, used by StelCore::getUTCOffset().
+//! Constructing a QTimeZone and querying its offset is expensive (it parses the zone data), and getUTCOffset()
+//! is called for every date label of ephemeris tables and graphs. Here each zone is constructed only once,
+//! and for dates between CACHE_BEGIN and CACHE_END its offsets are found by a binary search
+//! over the precomputed transitions. Other dates, and zones without transition data, are looked up
+//! in the cached QTimeZone, so the offsets are the same as those of the QTimeZone for all dates.
+//! All methods are thread-safe.
+class StelTimeZoneCache
+{
+public:
+	//! 1800-01-01 and 2200-01-01 UTC, in milliseconds since the Unix epoch
+	static const qint64 CACHE_BEGIN;
+	static const qint64 CACHE_END;
+
+	//! Get the offset from UTC of a time zone.
+	//! @param tzName the IANA name of the zone
+	//! @param msecsUtc the UTC time in milliseconds since the Unix epoch
+	//! @param useDST if false, the offset of the standard time is returned
+	//! @param shiftInSeconds receives the offset in seconds
+	//! @return false if tzName is not a valid zone, then shiftInSeconds is unchanged
+	bool offset(const QString& tzName, qint64 msecsUtc, bool useDST, int* shiftInSeconds);
+
+	//! Convert a Julian Day (UTC) to milliseconds since the Unix epoch, rounded to the second.
+	static qint64 jdToMSecsSinceEpoch(double JD);
+
+private:
+	struct Zone
+	{
+		QTimeZone tz;
+		//! false if the zone provides no transitions, then offsets are queried from tz directly
+		bool tabulated;
+		//! UTC times (msecs since epoch) from which the offsets at the same index are valid.
+		//! The first entry is CACHE_BEGIN.
+		QVector<qint64> validFrom;
+		QVector<int> offsetFromUtc;
+		QVector<int> standardTimeOffset;
+	};
+
+	static Zone build(const QString& tzName);
+
+	QMutex mutex;
+	QHash<QString, Zone> zones;
+};
+
+#endif // _STELTIMEZONECACHE_HPP_
@@ -32,6 +32,7 @@
 
 // Init static members
 QMap<QString, QString> StelTranslator::iso639codes;
+const int StelTranslator::MAX_MEMO_SIZE;
 QString StelTranslator::systemLangName;
 
 // Use system locale language by default
@@ -59,12 +60,53 @@ QString StelTranslator::qtranslate(const QString& s, const QString& c, int n) co
 {
 	if (s.isEmpty())
 		return "";
+
+	const MemoKey key = { s, c, n };
+	{
+		QReadLocker locker(&memoLock);
+		QHash<MemoKey, QString>::const_iterator it = memo.constFind(key);
+		if (it != memo.constEnd())
+			return it.value();
+	}
+
 	QString res = translator->translate("", s.toUtf8().constData(), c.toUtf8().constData(), n);
 	if (res.isEmpty())
-		return s;
+		res = s;
+
+	QWriteLocker locker(&memoLock);
+	if (memo.size() >= MAX_MEMO_SIZE)
+		memo.clear();
+	memo.insert(key, res);
 	return res;
 }
 
+QString StelTranslator::qtranslateLiteral(const char* s, const char* c, int n) const
+{
+	if (*s == '\0')
+		return "";
+
+	const LiteralKey key = { s, c, n };
+	{
+		QReadLocker locker(&memoLock);
+		QHash<LiteralKey, LiteralEntry>::const_iterator it = literalMemo.constFind(key);
+		if (it != literalMemo.constEnd() && qstrcmp(it->source, s)==0 && qstrcmp(it->context, c)==0)
+			return it->translation;
+	}
+
+	LiteralEntry entry;
+	entry.source = s;
+	entry.context = c;
+	entry.translation = translator->translate("", s, c, n);
+	if (entry.translation.isEmpty())
+		entry.translation = QString::fromUtf8(s);
+
+	QWriteLocker locker(&memoLock);
+	if (literalMemo.size() >= MAX_MEMO_SIZE)
+		literalMemo.clear();
+	literalMemo.insert(key, entry);
+	return entry.translation;
+}
+
 QString StelTranslator::tryQtranslate(const QString &s, const QString &c) const
 {
 	return translator->translate("", s.toUtf8().constData(),c.toUtf8().constData());
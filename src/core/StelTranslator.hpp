@@ -23,7 +23,9 @@
 //! @file StelTranslator.hpp
 //! Define some translation macros.
 
+#include <QHash>
 #include <QMap>
+#include <QReadWriteLock>
 #include <QString>
 
 //! @def q_(str)
@@ -78,6 +80,21 @@ public:
 	//! @return The translated QString
 	QString qtranslate(const QString& s, const QString& c = QString(), int n = -1) const;
 
+	//! Translate a string literal, like the q_() and qn_() macros with a literal do.
+	//! Literals are memoised by their address, so repeated calls skip the conversions to QString and UTF-8.
+	template <size_t N>
+	QString qtranslate(const char (&s)[N]) const
+	{
+		return qtranslateLiteral(s, "", -1);
+	}
+
+	//! Translate a string literal in a context given as a literal, like the qc_() and qcn_() macros do.
+	template <size_t N, size_t M>
+	QString qtranslate(const char (&s)[N], const char (&c)[M], int n = -1) const
+	{
+		return qtranslateLiteral(s, c, n);
+	}
+
 	//! Try to translate input message and return it as a QString. If no translation
 	//! exist for the current StelTranslator language, a null string is returned.
 	//! @param s input string in english.
@@ -123,6 +140,41 @@ private:
 	//! Get available language codes from passed locales directory
 	QStringList getAvailableIso639_1Codes(const QString& localeDir="") const;
 
+	//! Translate a null terminated UTF-8 string, using the memo of literals.
+	QString qtranslateLiteral(const char* s, const char* c, int n) const;
+
+	//! Key of the memo of translated QStrings
+	struct MemoKey
+	{
+		QString source;
+		QString context;
+		int n;
+		bool operator==(const MemoKey& other) const { return n==other.n && source==other.source && context==other.context; }
+		friend uint qHash(const MemoKey& key, uint seed = 0) { return qHash(key.source, seed) ^ qHash(key.context, seed + 1) ^ uint(key.n); }
+	};
+
+	//! Key of the memo of translated literals. The addresses of literals are unique, which interns them for free.
+	struct LiteralKey
+	{
+		const char* source;
+		const char* context;
+		int n;
+		bool operator==(const LiteralKey& other) const { return n==other.n && source==other.source && context==other.context; }
+		friend uint qHash(const LiteralKey& key, uint seed = 0) { return qHash(quintptr(key.source), seed) ^ qHash(quintptr(key.context), seed + 1) ^ uint(key.n); }
+	};
+
+	//! A translated literal. The strings are kept to check that the address still holds the same string,
+	//! because a character array passed to qtranslate() is not necessarily a literal.
+	struct LiteralEntry
+	{
+		QByteArray source;
+		QByteArray context;
+		QString translation;
+	};
+
+	//! The memos are cleared when they reach this size, as plural forms with arbitrary n make them grow without bound.
+	static const int MAX_MEMO_SIZE = 20000;
+
 	//! The domain name
 	QString domain;
 
@@ -132,6 +184,13 @@ private:
 	//! QTranslator instance
 	class QTranslator* translator;
 
+	//! Memoised translations. A StelTranslator is created for each language, so the memos are per locale,
+	//! and they are dropped together with the translator when the language changes.
+	mutable QHash<MemoKey, QString> memo;
+	mutable QHash<LiteralKey, LiteralEntry> literalMemo;
+	//! Translations are used from worker threads too
+	mutable QReadWriteLock memoLock;
+
 	//! Try to determine system language from system configuration
 	static void initSystemLanguage(void);
 	
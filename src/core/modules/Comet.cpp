@@ -38,17 +38,8 @@
 #include <QRegExp>
 #include <QDebug>
 
-// for compute tail shape
-#define COMET_TAIL_SLICES 16 // segments around the perimeter
-#define COMET_TAIL_STACKS 16 // cuts along the rotational axis
-
-// These are to avoid having index arrays for each comet when all are equal.
-bool Comet::createTailIndices=true;
-bool Comet::createTailTextureCoords=true;
 StelTextureSP Comet::comaTexture;
 StelTextureSP Comet::tailTexture;
-QVector<float> Comet::tailTexCoordArr; // computed only once for all Comets.
-QVector<unsigned short> Comet::tailIndices; // computed only once for all Comets.
 
 Comet::Comet(const QString& englishName,
 	     double radius,
@@ -93,6 +84,7 @@ Comet::Comet(const QString& englishName,
 	  tailFactors(-1., -1.), // mark "invalid"
 	  tailActive(false),
 	  tailBright(false),
+	  tailShapeDirty(false),
 	  deltaJDEtail(15.0*StelCore::JD_MINUTE), // update tail geometry every 15 minutes only
 	  lastJDEtail(0.0),
 	  dustTailWidthFactor(dustTailWidthFact),
@@ -104,8 +96,6 @@ Comet::Comet(const QString& englishName,
 {
 	this->outgas_intensity =outgas_intensity;
 	this->outgas_falloff   =outgas_falloff;
-	gastailVertexArr.clear();
-	dusttailVertexArr.clear();
 	comaVertexArr.clear();
 	gastailColorArr.clear();
 	dusttailColorArr.clear();
@@ -302,6 +292,14 @@ double Comet::getSiderealPeriod() const
 	return period;
 }
 
+Vec3d Comet::computeHeliocentricEclipticPos(const double dateJDE) const
+{
+	// Comets orbit the Sun. The CometOrbit is in fact available in orbitPtr!
+	Vec3d pos;
+	static_cast<CometOrbit*>(orbitPtr)->positionAtTimevInVSOP87Coordinates(dateJDE, pos, false);
+	return pos;
+}
+
 float Comet::getVMagnitude(const StelCore* core) const
 {
 	//If the two parameter system is not used,
@@ -353,11 +351,6 @@ void Comet::update(int deltaTime)
 	{
 		lastJDEtail=dateJDE;
 
-		// The CometOrbit is in fact available in userDataPtr!
-		CometOrbit* orbit=(CometOrbit*)orbitPtr;
-		Q_ASSERT(orbit);
-		if (!orbit->objectDateValid(dateJDE)) return; // out of useful date range. This should allow having hundreds of comet elements.
-
 		if (orbit->getUpdateTails()){
 			// Compute lengths and orientations from orbit object, but only if required.
 			tailFactors=getComaDiameterAndTailLengthAU();
@@ -366,52 +359,32 @@ void Comet::update(int deltaTime)
 			computeComa(1.0f*tailFactors[0]); // TBD: APPARENTLY NO SCALING? REMOVE 1.0 and note above.
 
 			tailActive = (tailFactors[1] > tailFactors[0]); // Inhibit tails drawing if too short. Would be nice to include geometric projection angle, but this is too costly.
+			tailShapeDirty = tailActive;
 
-			if (tailActive)
-			{
-				float gasTailEndRadius=qMax(tailFactors[0], 0.025f*tailFactors[1]) ; // This avoids too slim gas tails for bright comets like Hale-Bopp.
-				float gasparameter=gasTailEndRadius*gasTailEndRadius/(2.0f*tailFactors[1]); // parabola formula: z=r²/2p, so p=r²/2z
-				// The dust tail is thicker and usually shorter. The factors can be configured in the elements.
-				float dustparameter=gasTailEndRadius*gasTailEndRadius*dustTailWidthFactor*dustTailWidthFactor/(2.0f*dustTailLengthFactor*tailFactors[1]);
-
-				// Find valid parameters to create paraboloid vertex arrays: dustTail, gasTail.
-				computeParabola(gasparameter, gasTailEndRadius, -0.5f*gasparameter, gastailVertexArr,  tailTexCoordArr, tailIndices);
-				//gastailColorArr.fill(Vec3f(0.3,0.3,0.3), gastailVertexArr.length());
-				// Now we make a skewed parabola. Skew factor (xOffset, last arg) is rather ad-hoc/empirical. TBD later: Find physically correct solution.
-				computeParabola(dustparameter, dustTailWidthFactor*gasTailEndRadius, -0.5f*dustparameter, dusttailVertexArr, tailTexCoordArr, tailIndices, 25.0f*orbit->getVelocity().length());
-				//dusttailColorArr.fill(Vec3f(0.3,0.3,0.3), dusttailVertexArr.length());
-
-
-				// 2014-08 for 0.13.1 Moved from drawTail() to save lots of computation per frame (There *are* folks downloading all 730 MPC current comet elements...)
-				// Find rotation matrix from 0/0/1 to eclipticPosition: crossproduct for axis (normal vector), dotproduct for angle.
-				Vec3d eclposNrm=eclipticPos; eclposNrm.normalize();
-				gasTailRot=Mat4d::rotation(Vec3d(0.0, 0.0, 1.0)^(eclposNrm), std::acos(Vec3d(0.0, 0.0, 1.0).dot(eclposNrm)) );
-
-				Vec3d velocity=orbit->getVelocity(); // [AU/d]
-				// This was a try to rotate a straight parabola somewhat away from the antisolar direction.
-				//Mat4d dustTailRot=Mat4d::rotation(eclposNrm^(-velocity), 0.15f*std::acos(eclposNrm.dot(-velocity))); // GZ: This scale factor of 0.15 is empirical from photos of Halley and Hale-Bopp.
-				// The curved tail is curved towards positive X. We first rotate around the Z axis into a direction opposite of the motion vector, then again the antisolar rotation applies.
-				// In addition, we let the dust tail already start with a light tilt.
-				dustTailRot=gasTailRot * Mat4d::zrotation(atan2(velocity[1], velocity[0]) + M_PI) * Mat4d::yrotation(5.0f*velocity.length());
-
-				// Rotate vertex arrays:
-				Vec3d* gasVertices=(Vec3d*) (gastailVertexArr.data());
-				Vec3d* dustVertices=(Vec3d*) (dusttailVertexArr.data());
-				for (int i=0; i<COMET_TAIL_SLICES*COMET_TAIL_STACKS+1; ++i)
-				{
-					gasVertices[i].transfo4d(gasTailRot);
-					dustVertices[i].transfo4d(dustTailRot);
-				}
-			}
 			orbit->setUpdateTails(false); // don't update until position has been recalculated elsewhere
 		}
 	}
 
+	// If comet is too faint to be seen, its tails are not drawn (see draw()), so don't spend any time on them.
+	// (Massive speedup if people have hundreds of comet elements!)
+	const float vMag=getVMagnitude(core);
+	if (!tailActive || hidden || (vMag-3.0f) > core->getSkyDrawer()->getLimitMagnitude())
+	{
+		tailBright=false;
+		return;
+	}
+
+	if (tailShapeDirty)
+	{
+		computeTails(orbit->getVelocity());
+		tailShapeDirty=false;
+	}
+
 	// And also update magnitude and tail brightness/extinction here.
 	const bool withAtmosphere=(core->getSkyDrawer()->getFlagHasAtmosphere());
 
 	StelToneReproducer* eye = core->getToneReproducer();
-	float lum = core->getSkyDrawer()->surfaceBrightnessToLuminance(getVMagnitude(core)+13.0f); // How to calibrate?
+	float lum = core->getSkyDrawer()->surfaceBrightnessToLuminance(vMag+13.0f); // How to calibrate?
 	// Get the luminance scaled between 0 and 1
 	float aLum =eye->adaptLuminanceScaled(lum);
 
@@ -446,42 +419,66 @@ void Comet::update(int deltaTime)
 		// Below this brightness, the tail brightness loss by this method is insignificant:
 		// Just counting through the vertices might make a spiral apperance. Maybe even better than stackwise? Let's see...
 		const float avgAtmLum=GETSTELMODULE(LandscapeMgr)->getAtmosphereAverageLuminance();
-		const float brightnessDecreasePerVertexFromHead=1.0f/(COMET_TAIL_SLICES*COMET_TAIL_STACKS)  * avgAtmLum;
+		const float brightnessDecreasePerVertexFromHead=1.0f/(CometTailGeometry::Slices*CometTailGeometry::Stacks)  * avgAtmLum;
 		float brightnessPerVertexFromHead=1.0f;
 
-		gastailColorArr.clear();
-		dusttailColorArr.clear();
-		for (int i=0; i<gastailVertexArr.size(); ++i)
+		gastailColorArr.resize(CometTailGeometry::VertexCount);
+		dusttailColorArr.resize(CometTailGeometry::VertexCount);
+		for (int i=0; i<CometTailGeometry::VertexCount; ++i)
 		{
 			// Gastail extinction:
-			Vec3d vertAltAz=core->j2000ToAltAz(gastailVertexArr.at(i), StelCore::RefractionOn);
+			Vec3d vertAltAz=core->j2000ToAltAz(gasTail.getVertex(i), StelCore::RefractionOn);
 			vertAltAz.normalize();
 			Q_ASSERT(fabs(vertAltAz.lengthSquared()-1.0) < 0.001);
 			float oneMag=0.0f;
 			extinction.forward(vertAltAz, &oneMag);
 			float extinctionFactor=std::pow(0.4f, oneMag); // drop of one magnitude: factor 2.5 or 40%
-			gastailColorArr.append(gasColor*extinctionFactor* brightnessPerVertexFromHead*intensityFovScale);
+			gastailColorArr[i]=gasColor*extinctionFactor* brightnessPerVertexFromHead*intensityFovScale;
 
 			// dusttail extinction:
-			vertAltAz=core->j2000ToAltAz(dusttailVertexArr.at(i), StelCore::RefractionOn);
+			vertAltAz=core->j2000ToAltAz(dustTail.getVertex(i), StelCore::RefractionOn);
 			vertAltAz.normalize();
 			Q_ASSERT(fabs(vertAltAz.lengthSquared()-1.0) < 0.001);
 			oneMag=0.0f;
 			extinction.forward(vertAltAz, &oneMag);
 			extinctionFactor=std::pow(0.4f, oneMag); // drop of one magnitude: factor 2.5 or 40%
-			dusttailColorArr.append(dustColor*extinctionFactor * brightnessPerVertexFromHead*intensityFovScale);
+			dusttailColorArr[i]=dustColor*extinctionFactor * brightnessPerVertexFromHead*intensityFovScale;
 
 			brightnessPerVertexFromHead-=brightnessDecreasePerVertexFromHead;
 		}
 	}
 	else // no atmosphere: set all vertices to same brightness.
 	{
-		gastailColorArr.fill(gasColor  *intensityFovScale, gastailVertexArr.length());
-		dusttailColorArr.fill(dustColor*intensityFovScale, dusttailVertexArr.length());
+		gastailColorArr.fill(gasColor  *intensityFovScale, CometTailGeometry::VertexCount);
+		dusttailColorArr.fill(dustColor*intensityFovScale, CometTailGeometry::VertexCount);
 	}
 	//qDebug() << "Comet " << getEnglishName() <<  "JDE: " << date << "gasR" << gasColor[0] << " dustR" << dustColor[0];
 }
 
+void Comet::computeTails(const Vec3d& velocity)
+{
+	float gasTailEndRadius=qMax(tailFactors[0], 0.025f*tailFactors[1]) ; // This avoids too slim gas tails for bright comets like Hale-Bopp.
+	float gasparameter=gasTailEndRadius*gasTailEndRadius/(2.0f*tailFactors[1]); // parabola formula: z=r²/2p, so p=r²/2z
+	// The dust tail is thicker and usually shorter. The factors can be configured in the elements.
+	float dustparameter=gasTailEndRadius*gasTailEndRadius*dustTailWidthFactor*dustTailWidthFactor/(2.0f*dustTailLengthFactor*tailFactors[1]);
+
+	// 2014-08 for 0.13.1 Moved from drawTail() to save lots of computation per frame (There *are* folks downloading all 730 MPC current comet elements...)
+	// Find rotation matrix from 0/0/1 to eclipticPosition: crossproduct for axis (normal vector), dotproduct for angle.
+	Vec3d eclposNrm=eclipticPos; eclposNrm.normalize();
+	gasTailRot=Mat4d::rotation(Vec3d(0.0, 0.0, 1.0)^(eclposNrm), std::acos(Vec3d(0.0, 0.0, 1.0).dot(eclposNrm)) );
+
+	// This was a try to rotate a straight parabola somewhat away from the antisolar direction.
+	//Mat4d dustTailRot=Mat4d::rotation(eclposNrm^(-velocity), 0.15f*std::acos(eclposNrm.dot(-velocity))); // GZ: This scale factor of 0.15 is empirical from photos of Halley and Hale-Bopp.
+	// The curved tail is curved towards positive X. We first rotate around the Z axis into a direction opposite of the motion vector, then again the antisolar rotation applies.
+	// In addition, we let the dust tail already start with a light tilt.
+	dustTailRot=gasTailRot * Mat4d::zrotation(atan2(velocity[1], velocity[0]) + M_PI) * Mat4d::yrotation(5.0f*velocity.length());
+
+	// The paraboloid meshes are shared with the other comets, only the matrices which scale and rotate them are our own.
+	gasTail.setShape(gasparameter, gasTailEndRadius, 0.0f, gasTailRot);
+	// Now we make a skewed parabola. Skew factor (xOffset) is rather ad-hoc/empirical. TBD later: Find physically correct solution.
+	dustTail.setShape(dustparameter, dustTailWidthFactor*gasTailEndRadius, 25.0f*velocity.length(), dustTailRot);
+}
+
 
 // Draw the Comet and all the related infos: name, circle etc... GZ: Taken from Planet.cpp 2013-11-05 and extended
 void Comet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFont)
@@ -566,20 +563,22 @@ void Comet::draw(StelCore* core, float maxMagLabels, const QFont& planetNameFont
 
 void Comet::drawTail(StelCore* core, StelProjector::ModelViewTranformP transfo, bool gas)
 {	
-	StelPainter sPainter(core->getProjection(transfo));
+	const CometTailGeometry& tail = gas ? gasTail : dustTail;
+	if (!tail.isValid())
+		return;
+
+	// The shared unit paraboloid is scaled and rotated into this tail by the modelview matrix.
+	StelProjector::ModelViewTranformP transfo2 = transfo->clone();
+	transfo2->combine(tail.getMatrix());
+	StelPainter sPainter(core->getProjection(transfo2));
 	sPainter.setBlending(true, GL_ONE, GL_ONE);
 	sPainter.setCullFace(false);
 
 	tailTexture->bind();
 
-	if (gas) {
-		sPainter.setArrays((Vec3d*)gastailVertexArr.constData(), (Vec2f*)tailTexCoordArr.constData(), (Vec3f*)gastailColorArr.constData());
-		sPainter.drawFromArray(StelPainter::Triangles, tailIndices.size(), 0, true, tailIndices.constData());
-
-	} else {
-		sPainter.setArrays((Vec3d*)dusttailVertexArr.constData(), (Vec2f*)tailTexCoordArr.constData(), (Vec3f*)dusttailColorArr.constData());
-		sPainter.drawFromArray(StelPainter::Triangles, tailIndices.size(), 0, true, tailIndices.constData());
-	}
+	const QVector<unsigned short>& tailIndices = CometTailGeometry::getIndices();
+	sPainter.setArrays(tail.getUnitVertices().constData(), (Vec2f*)CometTailGeometry::getTexCoords().constData(), (gas ? gastailColorArr : dusttailColorArr).constData());
+	sPainter.drawFromArray(StelPainter::Triangles, tailIndices.size(), 0, true, tailIndices.constData());
 	sPainter.setBlending(false);
 }
 
@@ -625,76 +624,3 @@ void Comet::computeComa(const float diameter)
 {
 	StelPainter::computeFanDisk(0.5f*diameter, 3, 3, comaVertexArr, comaTexCoordArr);
 }
-
-//! create parabola shell to represent a tail. Designed for slices=16, stacks=16, but should work with other sizes as well.
-//! (Maybe slices must be an even number.)
-// Parabola equation: z=x²/2p.
-// xOffset for the dust tail, this may introduce a bend. Units are x per sqrt(z).
-void Comet::computeParabola(const float parameter, const float radius, const float zshift,
-			    QVector<Vec3d>& vertexArr, QVector<float>& texCoordArr, QVector<unsigned short> &indices, const float xOffset) {
-
-	// keep the array and replace contents. However, using replace() is only slightly faster.
-	if (vertexArr.length() < ((COMET_TAIL_SLICES*COMET_TAIL_STACKS+1)))
-		vertexArr.resize((COMET_TAIL_SLICES*COMET_TAIL_STACKS+1));
-	if (createTailIndices) indices.clear();
-	if (createTailTextureCoords) texCoordArr.clear();
-	int i;
-	// The parabola has triangular faces with vertices on two circles that are rotated against each other. 
-	float xa[2*COMET_TAIL_SLICES];
-	float ya[2*COMET_TAIL_SLICES];
-	float x, y, z;
-	
-	// fill xa, ya with sin/cosines. TBD: make more efficient with index mirroring etc.
-	float da=M_PI/COMET_TAIL_SLICES; // full circle/2slices
-	for (i=0; i<2*COMET_TAIL_SLICES; ++i){
-		xa[i]=-sin(i*da);
-		ya[i]=cos(i*da);
-	}
-	
-	vertexArr.replace(0, Vec3d(0.0, 0.0, zshift));
-	int vertexArrIndex=1;
-	if (createTailTextureCoords) texCoordArr << 0.5f << 0.5f;
-	// define the indices lying on circles, starting at 1: odd rings have 1/slices+1/2slices, even-numbered rings straight 1/slices
-	// inner ring#1
-	int ring;
-	for (ring=1; ring<=COMET_TAIL_STACKS; ++ring){
-		z=ring*radius/COMET_TAIL_STACKS; z=z*z/(2*parameter) + zshift;
-		float xShift= xOffset*z*z;
-		for (i=ring & 1; i<2*COMET_TAIL_SLICES; i+=2) { // i.e., ring1 has shifted vertices, ring2 has even ones.
-			x=xa[i]*radius*ring/COMET_TAIL_STACKS;
-			y=ya[i]*radius*ring/COMET_TAIL_STACKS;
-			vertexArr.replace(vertexArrIndex++, Vec3d(x+xShift, y, z));
-			if (createTailTextureCoords) texCoordArr << 0.5+ 0.5*x/radius << 0.5+0.5*y/radius;
-		}
-	}
-	// now link the faces with indices.
-	if (createTailIndices)
-	{
-		for (i=1; i<COMET_TAIL_SLICES; ++i) indices << 0 << i << i+1;
-		indices << 0 << COMET_TAIL_SLICES << 1; // close inner fan.
-		// The other slices are a repeating pattern of 2 possibilities. Index @ring always is on the inner ring (slices-agon)
-		for (ring=1; ring<COMET_TAIL_STACKS; ring+=2) { // odd rings
-			const int first=(ring-1)*COMET_TAIL_SLICES+1;
-			for (i=0; i<COMET_TAIL_SLICES-1; ++i){
-				indices << first+i << first+COMET_TAIL_SLICES+i << first+COMET_TAIL_SLICES+1+i;
-				indices << first+i << first+COMET_TAIL_SLICES+1+i << first+1+i;
-			}
-			// closing slice: mesh with other indices...
-			indices << ring*COMET_TAIL_SLICES << (ring+1)*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1;
-			indices << ring*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1 << first;
-		}
-
-		for (ring=2; ring<COMET_TAIL_STACKS; ring+=2) { // even rings: different sequence.
-			const int first=(ring-1)*COMET_TAIL_SLICES+1;
-			for (i=0; i<COMET_TAIL_SLICES-1; ++i){
-				indices << first+i << first+COMET_TAIL_SLICES+i << first+1+i;
-				indices << first+1+i << first+COMET_TAIL_SLICES+i << first+COMET_TAIL_SLICES+1+i;
-			}
-			// closing slice: mesh with other indices...
-			indices << ring*COMET_TAIL_SLICES << (ring+1)*COMET_TAIL_SLICES << first;
-			indices << first << (ring+1)*COMET_TAIL_SLICES << ring*COMET_TAIL_SLICES+1;
-		}
-	}
-	createTailIndices=false;
-	createTailTextureCoords=false;
-}
@@ -22,6 +22,7 @@
 #define _COMET_HPP_
 
 #include "Planet.hpp"
+#include "CometTailGeometry.hpp"
 
 /*! \class Comet
 	\author Bogdan Marinov, Georg Zotti (orbit computation enhancements, tails)
@@ -107,6 +108,9 @@ public:
 	//! get sidereal period for comet, days, or returns 0 if not possible (paraboloid, hyperboloid orbit)
 	virtual double getSiderealPeriod() const;
 
+	//! re-implementation of Planet's computeHeliocentricEclipticPos() which leaves the velocity used for the tails untouched.
+	virtual Vec3d computeHeliocentricEclipticPos(const double dateJDE) const;
+
 	//! re-implementation of Planet's draw()
 	virtual void draw(StelCore* core, float maxMagLabels, const QFont& planetNameFont);
 
@@ -124,17 +128,8 @@ private:
 	//! @param diameter Diameter of Coma [AU]
 	void computeComa(const float diameter);
 
-	//! compute tail shape. This is a paraboloid shell with triangular mesh (indexed vertices).
-	//! Try to call not for every frame...
-	//! To be more efficient, the arrays are only computed if they are empty.
-	//! @param parameter the parameter p of the parabola. z=r²/2p (r²=x²+y²)
-	//! @param lengthfactor The parabola will be lengthened. This shifts the visible focus, so it must be here.
-	//! @param vertexArr vertex array, collects x0, y0, z0, x1, y1, z1, ...
-	//! @param texCoordArr texture coordinates u0, v0, u1, v1, ...
-	//! @param colorArr vertex colors (if not textured) r0, g0, b0, r1, g1, b1, ...
-	//! @param indices into the former arrays (zero-starting), triplets forming triangles: t0,0, t0,1, t0,2, t1,0, t1,1, t1,2, ...
-	//! @param xOffset for the dust tail, this may introduce a bend. Units are x per sqrt(z).
-	void computeParabola(const float parameter, const float topradius, const float zshift, QVector<Vec3d>& vertexArr, QVector<float>& texCoordArr, QVector<unsigned short>& indices, const float xOffset=0.0f);
+	//! compute size and orientation of both tails from tailFactors, eclipticPos and the orbital velocity.
+	void computeTails(const Vec3d& velocity);
 
 	float slopeParameter;
 	double semiMajorAxis;
@@ -145,6 +140,7 @@ private:
 	Vec2f tailFactors; // result of latest call to getComaDiameterAndTailLengthAU(); Results cached here for infostring. [0]=Coma diameter, [1] gas tail length.
 	bool tailActive;		//! true if there is a tail long enough to be worth drawing. Drawing tails is quite costly.
 	bool tailBright;		//! true if tail is bright enough to draw.
+	bool tailShapeDirty;		//! true if tailFactors have changed since the tail shapes were computed. Only visible tails are updated.
 	double deltaJDEtail;            //! like deltaJDE, but time difference between tail geometry updates.
 	double lastJDEtail;             //! like lastJDE, but time of last tail geometry update.
 	Mat4d gasTailRot;		//! rotation matrix for gas tail parabola
@@ -159,17 +155,10 @@ private:
 	float intensityMinFov;
 	float intensityMaxFov;
 
-
-	// These are to avoid having index arrays for each comet when all are equal.
-	static bool createTailIndices;
-	static bool createTailTextureCoords;
-
-	QVector<Vec3d> gastailVertexArr;  // computed frequently, describes parabolic shape (along z axis) of gas tail.
-	QVector<Vec3d> dusttailVertexArr; // computed frequently, describes parabolic shape (along z axis) of dust tail.
+	CometTailGeometry gasTail;   // parabolic shape (along z axis) of gas tail, and its orientation.
+	CometTailGeometry dustTail;  // parabolic shape (along z axis) of dust tail, and its orientation.
 	QVector<Vec3f> gastailColorArr;    // NEW computed for every 5 mins, modulates gas tail brightness for extinction
 	QVector<Vec3f> dusttailColorArr;   // NEW computed for every 5 mins, modulates dust tail brightness for extinction
-	static QVector<float> tailTexCoordArr; // computed only once for all comets!
-	static QVector<unsigned short> tailIndices; // computed only once for all comets!
 	static StelTextureSP comaTexture;
 	static StelTextureSP tailTexture;      // it seems not really necessary to have different textures. gas tail is just painted blue.
 };
@@ -0,0 +1,192 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "CometTailGeometry.hpp"
+
+#include <climits>
+#include <cmath>
+
+const int CometTailGeometry::Slices;
+const int CometTailGeometry::Stacks;
+const int CometTailGeometry::VertexCount;
+const int CometTailGeometry::MaxCacheSize;
+
+QHash<CometTailGeometry::MeshKey, QVector<Vec3d> > CometTailGeometry::meshCache;
+quint64 CometTailGeometry::meshCount = 0;
+
+namespace
+{
+	// quantisation steps per factor e, i.e. steps of 0.5%
+	const double stepsPerE = 200.;
+	// smaller values have no visible effect on the shape
+	const double minValue = 1e-6;
+
+	// sines and cosines around the perimeter. The vertices of odd rings are rotated by half a slice.
+	struct Perimeter
+	{
+		Perimeter()
+		{
+			const double da=M_PI/CometTailGeometry::Slices; // full circle/2slices
+			for (int i=0; i<2*CometTailGeometry::Slices; ++i)
+			{
+				xa[i]=-std::sin(i*da);
+				ya[i]=std::cos(i*da);
+			}
+		}
+		double xa[2*CometTailGeometry::Slices];
+		double ya[2*CometTailGeometry::Slices];
+	};
+
+	const Perimeter& perimeter()
+	{
+		static const Perimeter p;
+		return p;
+	}
+}
+
+CometTailGeometry::CometTailGeometry()
+	: meshKey(INT_MIN, INT_MIN)
+	, matrix(Mat4d::identity())
+{
+}
+
+void CometTailGeometry::setShape(float parameter, float radius, float xOffset, const Mat4d& rotation)
+{
+	if (parameter<=0.f || radius<=0.f)
+	{
+		unitVertices.clear();
+		return;
+	}
+
+	const double p=parameter;
+	const double r=radius;
+	const double length=r*r/(2.*p);
+	const double shift=p/(2.*length);
+	const double bend=xOffset*length*length/r;
+
+	// The shift only matters for the bent tails.
+	MeshKey key(INT_MIN, INT_MIN);
+	if (std::fabs(bend)>=minValue)
+		key=MeshKey(quantise(shift), quantise(bend));
+
+	if (key!=meshKey || unitVertices.isEmpty())
+	{
+		QHash<MeshKey, QVector<Vec3d> >::const_iterator it=meshCache.constFind(key);
+		if (it==meshCache.constEnd())
+		{
+			// The tails keep (implicitly shared) copies of their meshes, so clearing only stops sharing of old shapes.
+			if (meshCache.size()>=MaxCacheSize)
+				meshCache.clear();
+			it=meshCache.insert(key, computeUnitMesh(dequantise(key.first), dequantise(key.second)));
+		}
+		unitVertices=it.value();
+		meshKey=key;
+	}
+	matrix=rotation * Mat4d::translation(Vec3d(0., 0., -0.5*p)) * Mat4d::scaling(Vec3d(r, r, length));
+}
+
+int CometTailGeometry::quantise(double value)
+{
+	// The bend is positive for the tails of Stellarium, but keep the sign for other uses.
+	const double a=std::fabs(value);
+	if (a<minValue)
+		return INT_MIN;
+	const int q=qRound(std::log(a/minValue)*stepsPerE)+1;
+	return value<0. ? -q : q;
+}
+
+double CometTailGeometry::dequantise(int key)
+{
+	if (key==INT_MIN)
+		return 0.;
+	const double a=minValue*std::exp((std::abs(key)-1)/stepsPerE);
+	return key<0 ? -a : a;
+}
+
+QVector<Vec3d> CometTailGeometry::computeUnitMesh(double shift, double bend)
+{
+	++meshCount;
+	const Perimeter& per=perimeter();
+	QVector<Vec3d> vertices(VertexCount);
+	vertices[0].set(0., 0., 0.);
+	int vertexIndex=1;
+	for (int ring=1; ring<=Stacks; ++ring)
+	{
+		const double u=static_cast<double>(ring)/Stacks;
+		const double z=u*u;
+		const double xShift=bend*(z-shift)*(z-shift);
+		for (int i=ring & 1; i<2*Slices; i+=2) // i.e., ring1 has shifted vertices, ring2 has even ones.
+			vertices[vertexIndex++].set(per.xa[i]*u+xShift, per.ya[i]*u, z);
+	}
+	Q_ASSERT(vertexIndex==VertexCount);
+	return vertices;
+}
+
+const QVector<float>& CometTailGeometry::getTexCoords()
+{
+	static QVector<float> texCoords;
+	if (texCoords.isEmpty())
+	{
+		const Perimeter& per=perimeter();
+		texCoords.reserve(2*VertexCount);
+		texCoords << 0.5f << 0.5f;
+		for (int ring=1; ring<=Stacks; ++ring)
+		{
+			const double u=static_cast<double>(ring)/Stacks;
+			for (int i=ring & 1; i<2*Slices; i+=2)
+				texCoords << 0.5+0.5*per.xa[i]*u << 0.5+0.5*per.ya[i]*u;
+		}
+	}
+	return texCoords;
+}
+
+const QVector<unsigned short>& CometTailGeometry::getIndices()
+{
+	static QVector<unsigned short> indices;
+	if (indices.isEmpty())
+	{
+		int i, ring;
+		for (i=1; i<Slices; ++i) indices << 0 << i << i+1;
+		indices << 0 << Slices << 1; // close inner fan.
+		// The other slices are a repeating pattern of 2 possibilities. Index @ring always is on the inner ring (slices-agon)
+		for (ring=1; ring<Stacks; ring+=2) { // odd rings
+			const int first=(ring-1)*Slices+1;
+			for (i=0; i<Slices-1; ++i){
+				indices << first+i << first+Slices+i << first+Slices+1+i;
+				indices << first+i << first+Slices+1+i << first+1+i;
+			}
+			// closing slice: mesh with other indices...
+			indices << ring*Slices << (ring+1)*Slices << ring*Slices+1;
+			indices << ring*Slices << ring*Slices+1 << first;
+		}
+
+		for (ring=2; ring<Stacks; ring+=2) { // even rings: different sequence.
+			const int first=(ring-1)*Slices+1;
+			for (i=0; i<Slices-1; ++i){
+				indices << first+i << first+Slices+i << first+1+i;
+				indices << first+1+i << first+Slices+i << first+Slices+1+i;
+			}
+			// closing slice: mesh with other indices...
+			indices << ring*Slices << (ring+1)*Slices << first;
+			indices << first << (ring+1)*Slices << ring*Slices+1;
+		}
+	}
+	return indices;
+}
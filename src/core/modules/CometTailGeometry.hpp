@@ -0,0 +1,96 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _COMETTAILGEOMETRY_HPP_
+#define _COMETTAILGEOMETRY_HPP_
+
+#include "VecMath.hpp"
+
+#include <QHash>
+#include <QPair>
+#include <QVector>
+
+//! @class CometTailGeometry
+//! The shape of a comet tail: a paraboloid shell with a triangular mesh (indexed vertices), opening along the z axis.
+//! The parabola is z=r²/2p-p/2 (r²=x²+y²), up to the radius of the tail end. A dust tail may be bent towards positive x.
+//!
+//! The geometry is split into a unit mesh and a matrix. The unit mesh has radius and length 1, and only depends on
+//! the bend of the tail relative to its size. The matrix scales it to the size of the tail and rotates it into its direction.
+//! Unit meshes are cached, keyed by the quantised bend, and shared by all tails of the same shape: all gas tails use
+//! the same mesh. When a tail grows or turns, only its matrix changes, and its mesh is only looked up again when its shape
+//! has changed by more than the quantisation step.
+//! The texture coordinates and indices are the same for all tails.
+class CometTailGeometry
+{
+public:
+	static const int Slices = 16; //!< segments around the perimeter. Must be an even number.
+	static const int Stacks = 16; //!< cuts along the rotational axis
+	static const int VertexCount = Slices*Stacks+1;
+
+	CometTailGeometry();
+
+	//! Set the shape of the tail.
+	//! @param parameter the parameter p of the parabola. z=r²/2p (r²=x²+y²), shifted by -p/2 along z.
+	//! @param radius the radius of the tail end
+	//! @param xOffset for the dust tail, this introduces a bend: x is shifted by xOffset*z².
+	//! @param rotation rotation from the z axis into the direction of the tail
+	void setShape(float parameter, float radius, float xOffset, const Mat4d& rotation);
+	//! false until a shape with positive parameter and radius is set
+	bool isValid() const { return !unitVertices.isEmpty(); }
+
+	//! The vertices of the unit mesh, to be transformed with getMatrix()
+	const QVector<Vec3d>& getUnitVertices() const { return unitVertices; }
+	//! Transformation from the unit mesh to the tail
+	const Mat4d& getMatrix() const { return matrix; }
+	//! A vertex of the tail (with getMatrix() applied)
+	Vec3d getVertex(int i) const { return matrix*unitVertices.at(i); }
+
+	//! Texture coordinates u0, v0, u1, v1, ... shared by all tails
+	static const QVector<float>& getTexCoords();
+	//! Triplets of indices forming triangles, shared by all tails
+	static const QVector<unsigned short>& getIndices();
+
+	//! Number of unit meshes in the cache
+	static int getCacheSize() { return meshCache.size(); }
+	//! Number of unit meshes computed so far, i.e. cache misses
+	static quint64 getMeshCount() { return meshCount; }
+	static void clearCache() { meshCache.clear(); }
+
+	//! Maximal number of unit meshes in the cache. The cache is cleared when this is reached.
+	static const int MaxCacheSize = 512;
+
+private:
+	typedef QPair<int, int> MeshKey;
+
+	//! Quantise a positive value in steps of about 0.5%. Values below a minimum are all treated as 0.
+	static int quantise(double value);
+	static double dequantise(int key);
+	//! Compute the unit mesh of a tail with shift s=p/2L and bend=xOffset*L²/R (L: length, R: end radius)
+	static QVector<Vec3d> computeUnitMesh(double shift, double bend);
+
+	QVector<Vec3d> unitVertices;
+	MeshKey meshKey;
+	Mat4d matrix;
+
+	static QHash<MeshKey, QVector<Vec3d> > meshCache;
+	static quint64 meshCount;
+};
+
+#endif // _COMETTAILGEOMETRY_HPP_
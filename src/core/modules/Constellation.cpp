@@ -29,6 +29,7 @@
 #include "StelModuleMgr.hpp"
 #include "StelTranslator.hpp"
 #include "ConstellationMgr.hpp"
+#include "StelSkyLineBuffer.hpp"
 
 #include <algorithm>
 #include <QString>
@@ -131,6 +132,32 @@ void Constellation::drawOptim(StelPainter& sPainter, const StelCore* core, const
 	}
 }
 
+void Constellation::drawOptim(StelPainter& sPainter, StelSkyLineBuffer& lines, int group) const
+{
+	if (lineFader.getInterstate()<=0.0001f)
+		return;
+
+	if (checkVisibility())
+	{
+		sPainter.setColor(lineColor[0], lineColor[1], lineColor[2], lineFader.getInterstate());
+		lines.draw(sPainter, group);
+	}
+}
+
+void Constellation::addLines(StelSkyLineBuffer& lines, const StelCore* core) const
+{
+	Vec3d star1;
+	Vec3d star2;
+	for (unsigned int i=0;i<numberOfSegments;++i)
+	{
+		star1=constellation[2*i]->getJ2000EquatorialPos(core);
+		star2=constellation[2*i+1]->getJ2000EquatorialPos(core);
+		star1.normalize();
+		star2.normalize();
+		lines.addArc(star1, star2);
+	}
+}
+
 void Constellation::drawName(StelPainter& sPainter, ConstellationMgr::ConstellationDisplayStyle style) const
 {
 	if (!nameFader.getInterstate())
@@ -248,6 +275,34 @@ void Constellation::drawBoundaryOptim(StelPainter& sPainter) const
 	}
 }
 
+void Constellation::drawBoundaryOptim(StelPainter& sPainter, StelSkyLineBuffer& boundaries, int sharedGroup, int isolatedGroup) const
+{
+	if (!boundaryFader.getInterstate())
+		return;
+
+	sPainter.setBlending(true);
+	sPainter.setColor(boundaryColor[0], boundaryColor[1], boundaryColor[2], boundaryFader.getInterstate());
+	boundaries.draw(sPainter, singleSelected ? isolatedGroup : sharedGroup);
+}
+
+void Constellation::addBoundaries(StelSkyLineBuffer& boundaries, bool isolated) const
+{
+	const std::vector<std::vector<Vec3f> *>& segments = isolated ? isolatedBoundarySegments : sharedBoundarySegments;
+	Vec3f pt1, pt2;
+	for (size_t i=0;i<segments.size();i++)
+	{
+		const std::vector<Vec3f>* points = segments[i];
+		for (size_t j=0;j+1<points->size();j++)
+		{
+			pt1 = points->at(j);
+			pt2 = points->at(j+1);
+			if (pt1*pt2>0.9999999f)
+				continue;
+			boundaries.addArc(Vec3d(pt1[0], pt1[1], pt1[2]), Vec3d(pt2[0], pt2[1], pt2[2]));
+		}
+	}
+}
+
 bool Constellation::checkVisibility() const
 {
 	// Is supported seasonal rules by current starlore?
@@ -33,6 +33,8 @@
 #include <QString>
 #include <QFont>
 
+class StelSkyLineBuffer;
+
 class StarMgr;
 class StelPainter;
 
@@ -89,6 +91,12 @@ private:
 	void drawArt(StelPainter& sPainter) const;
 	//! Draw the constellation boundary
 	void drawBoundaryOptim(StelPainter& sPainter) const;
+	//! Draw the constellation boundary from a projected buffer filled by addBoundaries().
+	//! @param sharedGroup, isolatedGroup the groups with the shared and isolated boundary segments.
+	void drawBoundaryOptim(StelPainter& sPainter, StelSkyLineBuffer& boundaries, int sharedGroup, int isolatedGroup) const;
+	//! Add the boundary segments to the current group of a buffer.
+	//! @param isolated whether to add the isolated segments, or the shared ones.
+	void addBoundaries(StelSkyLineBuffer& boundaries, bool isolated) const;
 
 	//! Test if a star is part of a Constellation.
 	//! This member tests to see if a star is one of those which make up
@@ -113,6 +121,10 @@ private:
 	//! This method uses the coords of the stars (optimized for use through
 	//! the class ConstellationMgr only).
 	void drawOptim(StelPainter& sPainter, const StelCore* core, const SphericalCap& viewportHalfspace) const;
+	//! Draw the lines from a projected buffer filled by addLines().
+	void drawOptim(StelPainter& sPainter, StelSkyLineBuffer& lines, int group) const;
+	//! Add the lines at the epoch given by the StelCore to the current group of a buffer.
+	void addLines(StelSkyLineBuffer& lines, const StelCore* core) const;
 	//! Draw the art texture, optimized function to be called through a constellation manager only.
 	void drawArtOptim(StelPainter& sPainter, const SphericalRegion& region) const;
 	//! Update fade levels according to time since various events.
@@ -53,6 +53,9 @@ ConstellationMgr::ConstellationMgr(StarMgr *_hip_stars)
 	: hipStarMgr(_hip_stars),
 	  isolateSelected(false),
 	  constellationPickEnabled(false),
+	  linesBufferJDE(0.),
+	  linesBufferDirty(true),
+	  boundariesBufferDirty(true),
 	  constellationDisplayStyle(ConstellationMgr::constellationsTranslated),
 	  artFadeDuration(2.),
 	  artIntensity(0),
@@ -384,6 +387,9 @@ void ConstellationMgr::setConstellationLineThickness(const int thickness)
 
 void ConstellationMgr::loadLinesAndArt(const QString &fileName, const QString &artfileName, const QString& cultureName)
 {
+	linesBufferDirty = true;
+	boundariesBufferDirty = true;
+
 	QFile in(fileName);
 	if (!in.open(QIODevice::ReadOnly | QIODevice::Text))
 	{
@@ -584,6 +590,7 @@ void ConstellationMgr::draw(StelCore* core)
 	const StelProjectorP prj = core->getProjection(StelCore::FrameJ2000);
 	StelPainter sPainter(prj);
 	sPainter.setFont(asterFont);
+	updateLineBuffers(core);
 	drawLines(sPainter, core);
 	drawNames(sPainter);
 	drawArt(sPainter);
@@ -606,19 +613,55 @@ void ConstellationMgr::drawArt(StelPainter& sPainter) const
 	sPainter.setCullFace(false);
 }
 
+void ConstellationMgr::updateLineBuffers(const StelCore* core)
+{
+	// The star positions include proper motion, which is only visible after years
+	const double jde = core->getJDE();
+	if (linesBufferDirty || std::fabs(jde-linesBufferJDE)>365.25)
+	{
+		linesBuffer.clear();
+		vector < Constellation * >::const_iterator iter;
+		for (iter = constellations.begin(); iter != constellations.end(); ++iter)
+		{
+			linesBuffer.beginGroup();
+			(*iter)->addLines(linesBuffer, core);
+		}
+		linesBufferJDE = jde;
+		linesBufferDirty = false;
+	}
+
+	if (boundariesBufferDirty)
+	{
+		boundariesBuffer.clear();
+		vector < Constellation * >::const_iterator iter;
+		for (iter = constellations.begin(); iter != constellations.end(); ++iter)
+		{
+			boundariesBuffer.beginGroup();
+			(*iter)->addBoundaries(boundariesBuffer, false);
+			boundariesBuffer.beginGroup();
+			(*iter)->addBoundaries(boundariesBuffer, true);
+		}
+		boundariesBufferDirty = false;
+	}
+}
+
 // Draw constellations lines
-void ConstellationMgr::drawLines(StelPainter& sPainter, const StelCore* core) const
+void ConstellationMgr::drawLines(StelPainter& sPainter, const StelCore* core)
 {
 	sPainter.setBlending(true);
 	if (constellationLineThickness>1)
 		sPainter.setLineWidth(constellationLineThickness); // set line thickness
 	sPainter.setLineSmooth(true);
 
+	// Projections with discontinuities need the clipping of drawGreatCircleArc()
+	const bool useBuffer = linesBuffer.project(sPainter);
 	const SphericalCap& viewportHalfspace = sPainter.getProjector()->getBoundingCap();
-	vector < Constellation * >::const_iterator iter;
-	for (iter = constellations.begin(); iter != constellations.end(); ++iter)
+	for (unsigned int i=0; i<constellations.size(); ++i)
 	{
-		(*iter)->drawOptim(sPainter, core, viewportHalfspace);
+		if (useBuffer)
+			constellations[i]->drawOptim(sPainter, linesBuffer, i);
+		else
+			constellations[i]->drawOptim(sPainter, core, viewportHalfspace);
 	}
 	if (constellationLineThickness>1)
 		sPainter.setLineWidth(1); // restore line thickness
@@ -1245,6 +1288,8 @@ bool ConstellationMgr::loadBoundaries(const QString& boundaryFile)
 	Constellation *cons = Q_NULLPTR;
 	unsigned int i, j;
 
+	boundariesBufferDirty = true;
+
 	// delete existing boundaries if any exist
 	vector<vector<Vec3f> *>::iterator iter;
 	for (iter = allBoundarySegments.begin(); iter != allBoundarySegments.end(); ++iter)
@@ -1346,13 +1391,16 @@ bool ConstellationMgr::loadBoundaries(const QString& boundaryFile)
 	return true;
 }
 
-void ConstellationMgr::drawBoundaries(StelPainter& sPainter) const
+void ConstellationMgr::drawBoundaries(StelPainter& sPainter)
 {
 	sPainter.setBlending(false);
-	vector < Constellation * >::const_iterator iter;
-	for (iter = constellations.begin(); iter != constellations.end(); ++iter)
+	const bool useBuffer = boundariesBuffer.project(sPainter);
+	for (unsigned int i=0; i<constellations.size(); ++i)
 	{
-		(*iter)->drawBoundaryOptim(sPainter);
+		if (useBuffer)
+			constellations[i]->drawBoundaryOptim(sPainter, boundariesBuffer, 2*i, 2*i+1);
+		else
+			constellations[i]->drawBoundaryOptim(sPainter);
 	}
 }
 
@@ -24,6 +24,7 @@
 #include "StelObjectType.hpp"
 #include "StelObjectModule.hpp"
 #include "StelProjectorType.hpp"
+#include "StelSkyLineBuffer.hpp"
 
 #include <vector>
 #include <QString>
@@ -337,14 +338,16 @@ private:
 	//! @param rulesFile Name of the file containing the seasonal rules
 	void loadSeasonalRules(const QString& rulesFile);
 
+	//! Rebuild the line buffers when the constellations changed, or the lines when the stars moved.
+	void updateLineBuffers(const StelCore* core);
 	//! Draw the constellation lines at the epoch given by the StelCore.
-	void drawLines(StelPainter& sPainter, const StelCore* core) const;
+	void drawLines(StelPainter& sPainter, const StelCore* core);
 	//! Draw the constellation art.
 	void drawArt(StelPainter& sPainter) const;
 	//! Draw the constellation name labels.
 	void drawNames(StelPainter& sPainter) const;
 	//! Draw the constellation boundaries.
-	void drawBoundaries(StelPainter& sPainter) const;
+	void drawBoundaries(StelPainter& sPainter);
 	//! Handle single and multi-constellation selections.
 	void setSelectedConst(Constellation* c);
 	//! Handle unselecting a single constellation.
@@ -375,6 +378,15 @@ private:
 	bool constellationPickEnabled;
 	std::vector<std::vector<Vec3f> *> allBoundarySegments;
 
+	//! The lines of all constellations, a group per constellation
+	StelSkyLineBuffer linesBuffer;
+	//! The boundaries of all constellations, two groups per constellation with the shared and the isolated segments
+	StelSkyLineBuffer boundariesBuffer;
+	//! The epoch of the star positions in linesBuffer
+	double linesBufferJDE;
+	bool linesBufferDirty;
+	bool boundariesBufferDirty;
+
 	QString lastLoadedSkyCulture;	// Store the last loaded sky culture directory name
 
 	//! this controls how constellations (and also star names) are printed: Abbreviated/as-given/translated
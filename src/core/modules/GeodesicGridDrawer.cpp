@@ -45,7 +45,7 @@ double StelGeodesicGridDrawer::draw(StelCore* core, int maxSearchLevel)
 	StelPainter sPainter(prj);
 	StelGeodesicGrid* geodesicGrid = core->getGeodesicGrid();
 
-	const GeodesicSearchResult* geodesic_search_result = geodesicGrid->search(prj->unprojectViewport(), maxSearchLevel);
+	GeodesicSearchResultP geodesic_search_result = geodesicGrid->search(prj->unprojectViewport(), maxSearchLevel);
 	
 	glDisable(GL_TEXTURE_2D);
 	glEnable(GL_BLEND);	
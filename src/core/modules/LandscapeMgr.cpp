@@ -34,6 +34,7 @@
 #include "StelIniParser.hpp"
 #include "StelSkyDrawer.hpp"
 #include "StelPainter.hpp"
+#include "StelProfiler.hpp"
 #include "qzipreader.h"
 
 #include <QDebug>
@@ -241,9 +242,12 @@ void LandscapeMgr::update(double deltaTime)
 		lunarPhaseAngle=0.0f;
 	}
 	// GZ: First parameter in next call is used for particularly earth-bound computations in Schaefer's sky brightness model. Difference DeltaT makes no difference here.
-	atmosphere->computeColor(core->getJDE(), sunPos, moonPos, lunarPhaseAngle, lunarMagnitude,
-		core, core->getCurrentLocation().latitude, core->getCurrentLocation().altitude,
-		15.f, 40.f);	// Temperature = 15c, relative humidity = 40%
+	{
+		StelProfiler::Scope scope("Atmosphere: compute color");
+		atmosphere->computeColor(core->getJDE(), sunPos, moonPos, lunarPhaseAngle, lunarMagnitude,
+			core, core->getCurrentLocation().latitude, core->getCurrentLocation().altitude,
+			15.f, 40.f);	// Temperature = 15c, relative humidity = 40%
+	}
 
 	core->getSkyDrawer()->reportLuminanceInFov(3.75+atmosphere->getAverageLuminance()*3.5, true);
 
@@ -367,7 +371,10 @@ void LandscapeMgr::update(double deltaTime)
 void LandscapeMgr::draw(StelCore* core)
 {
 	// Draw the atmosphere
-	atmosphere->draw(core);
+	{
+		StelProfiler::Scope scope("Atmosphere: draw", StelProfiler::Draw);
+		atmosphere->draw(core);
+	}
 
 	// Draw the landscape
 	if (oldLandscape)
@@ -1141,6 +1148,7 @@ QString LandscapeMgr::installLandscapeFromArchive(QString sourceFilePath, const
 		}
 	}
 	reader.close();
+	StelFileMgr::invalidateCache();
 	//If necessary, make the new landscape the current landscape
 	if (display)
 	{
@@ -1196,6 +1204,7 @@ bool LandscapeMgr::removeLandscape(const QString landscapeID)
 		return false;
 	}
 
+	StelFileMgr::invalidateCache();
 	qDebug() << "LandscapeMgr: Successfully removed" << QDir::toNativeSeparators(landscapePath);
 
 	//If the landscape has been selected, revert to the default one
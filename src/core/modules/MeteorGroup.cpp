@@ -0,0 +1,106 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "MeteorGroup.hpp"
+#include "StelCore.hpp"
+#include "StelMovementMgr.hpp"
+#include "StelPainter.hpp"
+#include "StelSkyDrawer.hpp"
+#include "StelTexture.hpp"
+#include "StelUtils.hpp"
+
+MeteorGroup::MeteorGroup(int capacity)
+	: pool(capacity)
+{
+}
+
+int MeteorGroup::spawn(const StelCore* core, float radiantAlpha, float radiantDelta, float speed, const QList<MeteorPool::ColorPair>& colors)
+{
+	// find the radiant in horizontal coordinates
+	Vec3d radiantAltAz;
+	StelUtils::spheToRect(radiantAlpha, radiantDelta, radiantAltAz);
+	return spawnAltAz(core, core->j2000ToAltAz(radiantAltAz), speed, colors);
+}
+
+int MeteorGroup::spawnAltAz(const StelCore* core, const Vec3d& radiantAltAz, float speed, const QList<MeteorPool::ColorPair>& colors)
+{
+	// select random magnitude [-3; 4.5]
+	float mag = (float) qrand() / ((float) RAND_MAX + 1) * 7.5f - 3.f;
+
+	// compute RMag and CMag
+	RCMag rcMag;
+	core->getSkyDrawer()->computeRCMag(mag, &rcMag);
+	const float absMag = rcMag.radius <= 1.2f ? 0.f : rcMag.luminance;
+
+	return pool.spawn(radiantAltAz, speed, absMag, colors);
+}
+
+void MeteorGroup::update(const StelCore* core, double deltaTime)
+{
+	pool.update(deltaTime, core->getRealTimeSpeed());
+}
+
+void MeteorGroup::draw(const StelCore* core, StelPainter& sPainter)
+{
+	if (pool.getActiveCount() == 0)
+	{
+		return;
+	}
+
+	float thickness, bolideSize;
+	const StelMovementMgr* mvMgr = core->getMovementMgr();
+	MeteorPool::calculateThickness(mvMgr->getCurrentFov(), mvMgr->getMaxFov(), thickness, bolideSize);
+	if (!bolideTexture)
+	{
+		bolideSize = 0.f;
+	}
+	pool.buildGeometry(thickness, bolideSize);
+
+	// trains of all meteors
+	sPainter.setBlending(true);
+	sPainter.enableClientStates(true, false, true);
+	const QVector<Vec3d>& trainVertices = pool.getTrainVertices();
+	if (!trainVertices.isEmpty())
+	{
+		sPainter.setColorPointer(4, GL_FLOAT, pool.getTrainColors().constData());
+		sPainter.setVertexPointer(3, GL_DOUBLE, trainVertices.constData());
+		sPainter.drawFromArray(StelPainter::TriangleStrip, trainVertices.size(), 0, true);
+	}
+	const QVector<Vec3d>& lineVertices = pool.getLineVertices();
+	sPainter.setColorPointer(4, GL_FLOAT, pool.getLineColors().constData());
+	sPainter.setVertexPointer(3, GL_DOUBLE, lineVertices.constData());
+	sPainter.drawFromArray(StelPainter::Lines, lineVertices.size(), 0, true);
+
+	// bolides of all meteors
+	const QVector<Vec3d>& bolideVertices = pool.getBolideVertices();
+	if (!bolideVertices.isEmpty())
+	{
+		sPainter.setBlending(true, GL_ONE, GL_ONE);
+		sPainter.enableClientStates(true, true, true);
+		bolideTexture->bind();
+		sPainter.setTexCoordPointer(2, GL_FLOAT, pool.getBolideTexCoords().constData());
+		sPainter.setColorPointer(4, GL_FLOAT, pool.getBolideColors().constData());
+		sPainter.setVertexPointer(3, GL_DOUBLE, bolideVertices.constData());
+		sPainter.drawFromArray(StelPainter::TriangleStrip, bolideVertices.size(), 0, true);
+	}
+
+	sPainter.setBlending(false);
+	sPainter.enableClientStates(false);
+}
@@ -0,0 +1,69 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _METEORGROUP_HPP_
+#define _METEORGROUP_HPP_
+
+#include "MeteorPool.hpp"
+#include "StelTextureTypes.hpp"
+
+class StelCore;
+class StelPainter;
+
+//! @class MeteorGroup
+//! The meteors of one shower, or the sporadic meteors.
+//! Meteors are stored in a MeteorPool, and all of them are drawn with one call per primitive type.
+class MeteorGroup
+{
+public:
+	//! @param capacity the maximal number of meteors alive at the same time
+	MeteorGroup(int capacity=1024);
+
+	//! Set the texture used to draw the bolides.
+	void setBolideTexture(const StelTextureSP& texture) { bolideTexture = texture; }
+
+	//! Start a meteor with a random trajectory and magnitude.
+	//! @param radiantAlpha the radiant right ascension (J2000) in rad.
+	//! @param radiantDelta the radiant declination (J2000) in rad.
+	//! @param speed meteor speed in km/s.
+	//! @param colors the colors of the train.
+	//! @return the slot of the meteor in the pool, or -1 if the meteor is not visible.
+	int spawn(const StelCore* core, float radiantAlpha, float radiantDelta, float speed, const QList<MeteorPool::ColorPair>& colors);
+	//! Same as spawn(), with the radiant in the horizontal system.
+	int spawnAltAz(const StelCore* core, const Vec3d& radiantAltAz, float speed, const QList<MeteorPool::ColorPair>& colors);
+
+	//! Updates the positions of the meteors, and expires them if necessary.
+	//! @param deltaTime the time increment in seconds since the last call.
+	void update(const StelCore* core, double deltaTime);
+
+	//! Draws all meteors. The painter must use the horizontal frame.
+	void draw(const StelCore* core, StelPainter& sPainter);
+
+	//! Remove all meteors.
+	void clear() { pool.clear(); }
+
+	MeteorPool& getPool() { return pool; }
+
+private:
+	MeteorPool pool;
+	StelTextureSP bolideTexture;
+};
+
+#endif // _METEORGROUP_HPP_
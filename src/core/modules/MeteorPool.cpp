@@ -0,0 +1,439 @@
+/*
+ * Stellarium
+ * Copyright (C) 2014-2015 Marcos Cardinot
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "MeteorPool.hpp"
+
+#include <QtMath>
+
+#include <algorithm>
+
+namespace
+{
+	inline float randomUnit()
+	{
+		return (float) qrand() / ((float) RAND_MAX + 1);
+	}
+}
+
+MeteorPool::MeteorPool(int capacity)
+	: capacity(capacity)
+	, droppedCount(0)
+{
+	Q_ASSERT(capacity>0);
+}
+
+void MeteorPool::allocate()
+{
+	speed.resize(capacity);
+	matAltAzToRadiant.resize(capacity);
+	position.resize(capacity);
+	trainZ.resize(capacity);
+	initialZ.resize(capacity);
+	finalZ.resize(capacity);
+	minDist.resize(capacity);
+	absMag.resize(capacity);
+	aptMag.resize(capacity);
+	segmentColors.resize(capacity*Segments);
+	activeSlots.reserve(capacity);
+	freeSlots.reserve(capacity);
+	clear();
+}
+
+void MeteorPool::clear()
+{
+	if (speed.isEmpty())
+	{
+		return;
+	}
+	activeSlots.resize(0);
+	freeSlots.resize(0);
+	// Pop the low slots first
+	for (int slot=capacity-1; slot>=0; --slot)
+		freeSlots.append(slot);
+}
+
+int MeteorPool::spawn(const Vec3d& radiantAltAz, float meteorSpeed, float meteorAbsMag, const QList<ColorPair>& colors)
+{
+	if (meteorAbsMag == 0.f || colors.isEmpty())
+	{
+		return -1;
+	}
+
+	// S is zero, E is 90 degrees (SDSS)
+	const float radiantAlt = qAsin(radiantAltAz[2] / radiantAltAz.length());
+	const float radiantAz = qAtan2(radiantAltAz[1], radiantAltAz[0]);
+
+	// meteors won't be visible if radiant is below 0degrees
+	if (radiantAlt < 0.f)
+	{
+		return -1;
+	}
+
+	// define the radiant coordinate system
+	// rotation matrix to align z axis with radiant
+	const Mat4d matrix = Mat4d::zrotation(radiantAz) * Mat4d::yrotation(M_PI_2 - radiantAlt);
+
+	// select a random initial meteor altitude in the horizontal system [MIN_ALTITUDE, MAX_ALTITUDE]
+	float initialAlt = MIN_ALTITUDE + (MAX_ALTITUDE - MIN_ALTITUDE) * randomUnit();
+
+	// calculates the max z-coordinate for the currrent radiant
+	float maxZ = meteorZ(M_PI_2 - radiantAlt, initialAlt);
+
+	// meteor trajectory
+	// select a random xy position in polar coordinates (radiant system)
+	float xyDist = maxZ * randomUnit(); // [0, maxZ]
+	float theta = 2 * M_PI * randomUnit(); // [0, 2pi]
+
+	// initial meteor coordinates (radiant system)
+	Vec3d pos(xyDist * qCos(theta), xyDist * qSin(theta), maxZ);
+
+	// find the initial meteor coordinates in the horizontal system
+	Vec3d positionAltAz = pos;
+	positionAltAz.transfo4d(matrix);
+
+	// find the angle from horizon to meteor
+	float meteorAlt = qAsin(positionAltAz[2] / positionAltAz.length());
+
+	// this meteor should not be visible if it is above the maximum altitude
+	// or if it's below the horizon!
+	if (positionAltAz[2] > MAX_ALTITUDE || meteorAlt <= 0.f)
+	{
+		return -1;
+	}
+
+	// determine the final z-component and the min distance between meteor and observer
+	float endZ, dist;
+	if (radiantAlt < 0.0262f) // (<1.5 degrees) earth grazing meteor ?
+	{
+		// earth-grazers are rare!
+		// introduce a probabilistic factor just to make them a bit harder to occur
+		if (randomUnit() > 0.3f) {
+			return -1;
+		}
+
+		// limit lifetime to 12sec
+		endZ = qMax(pos[2] - meteorSpeed * 12.f, -pos[2]);
+		dist = xyDist;
+	}
+	else
+	{
+		// limit lifetime to 12sec
+		endZ = meteorZ(M_PI_2 - meteorAlt, MIN_ALTITUDE);
+		endZ = qMax(pos[2] - meteorSpeed * 12.f, (double) endZ);
+		dist = qSqrt(endZ * endZ + xyDist * xyDist);
+	}
+
+	// a meteor cannot hit the observer!
+	if (dist < MIN_ALTITUDE) {
+		return -1;
+	}
+
+	if (speed.isEmpty())
+	{
+		allocate();
+	}
+
+	if (freeSlots.isEmpty())
+	{
+		++droppedCount;
+		return -1;
+	}
+	const int slot = freeSlots.last();
+	freeSlots.removeLast();
+	activeSlots.append(slot);
+
+	speed[slot] = meteorSpeed;
+	matAltAzToRadiant[slot] = matrix;
+	position[slot] = pos;
+	trainZ[slot] = pos[2];
+	initialZ[slot] = pos[2];
+	finalZ[slot] = endZ;
+	minDist[slot] = dist;
+
+	// most visible meteors are under about 184km distant
+	// scale max mag down if outside this range
+	float scale = qPow(184.0 / dist, 2);
+	absMag[slot] = meteorAbsMag * qMin(scale, 1.0f);
+	aptMag[slot] = absMag[slot];
+
+	// build the color vector
+	buildColorVector(slot, colors);
+
+	return slot;
+}
+
+void MeteorPool::update(double deltaTime, bool burning)
+{
+	// step through and update all active meteors
+	for (int i = 0; i < activeSlots.size();)
+	{
+		const int slot = activeSlots.at(i);
+
+		if (!burning || position[slot][2] < finalZ[slot])
+		{
+			// burning has stopped so magnitude fades out
+			// assume linear fade out
+			absMag[slot] -= deltaTime * 2.f;
+		}
+
+		// no longer visible: free the slot, and move the last meteor to this place
+		if (absMag[slot] <= 0.f)
+		{
+			freeSlots.append(slot);
+			activeSlots[i] = activeSlots.last();
+			activeSlots.removeLast();
+			continue;
+		}
+
+		const float v = speed[slot];
+		position[slot][2] -= v * deltaTime;
+
+		// train doesn't extend beyond start of burn
+		if (position[slot][2] + v * 0.5f > initialZ[slot])
+		{
+			trainZ[slot] = initialZ[slot];
+		}
+		else
+		{
+			trainZ[slot] -= v * deltaTime;
+		}
+
+		// update apparent magnitude based on distance to observer
+		float scale = qPow(minDist[slot] / position[slot].length(), 2);
+		aptMag[slot] = qMax(absMag[slot] * qMin(scale, 1.f), 0.f);
+		++i;
+	}
+}
+
+void MeteorPool::buildGeometry(float thickness, float bolideSize)
+{
+	const int count = activeSlots.size();
+	// Each side of the train prism is a strip of 2*Segments vertices, with its first and last vertices
+	// repeated to join it to the other strips with degenerate triangles.
+	static const int TrainVerticesPerSide = 2*Segments+2;
+	trainVertices.resize(thickness ? count*3*TrainVerticesPerSide : 0);
+	trainColors.resize(trainVertices.size());
+	lineVertices.resize(count*2*(Segments-1));
+	lineColors.resize(lineVertices.size());
+	bolideVertices.resize(bolideSize ? count*6 : 0);
+	bolideColors.resize(bolideVertices.size());
+	bolideTexCoords.resize(bolideVertices.size());
+
+	Vec3d* trainV = trainVertices.data();
+	Vec4f* trainC = trainColors.data();
+	Vec3d* lineV = lineVertices.data();
+	Vec4f* lineC = lineColors.data();
+	Vec3d* bolideV = bolideVertices.data();
+	Vec4f* bolideC = bolideColors.data();
+	Vec2f* bolideT = bolideTexCoords.data();
+
+	Vec3d line[Segments], sideB[Segments], sideL[Segments], sideR[Segments];
+	Vec4f color[Segments];
+	foreach (int slot, activeSlots)
+	{
+		const Vec3d& pos = position.at(slot);
+		const double tz = trainZ.at(slot);
+		const float apt = aptMag.at(slot);
+
+		// train (triangular prism)
+		for (int i = 0; i < Segments; ++i)
+		{
+			const double height = tz + i*(pos[2] - tz)/(Segments-1);
+			line[i] = radiantToAltAz(slot, Vec3d(pos[0], pos[1], height));
+			if (thickness)
+			{
+				sideB[i] = radiantToAltAz(slot, Vec3d(pos[0] + thickness*0.7, pos[1] + thickness*0.7, height));
+				sideL[i] = radiantToAltAz(slot, Vec3d(pos[0], pos[1] - thickness, height));
+				sideR[i] = radiantToAltAz(slot, Vec3d(pos[0] - thickness, pos[1], height));
+			}
+			color[i] = segmentColors.at(slot*Segments+i);
+			color[i][3] = apt * ((float) i / (float) (Segments-1));
+		}
+
+		if (thickness)
+		{
+			const Vec3d* sides[3][2] = {{sideB, sideL}, {sideB, sideR}, {sideL, sideR}};
+			for (int s = 0; s < 3; ++s)
+			{
+				const Vec3d* first = sides[s][0];
+				const Vec3d* second = sides[s][1];
+				*trainV++ = first[0];
+				*trainC++ = color[0];
+				for (int i = 0; i < Segments; ++i)
+				{
+					*trainV++ = first[i];
+					*trainV++ = second[i];
+					*trainC++ = color[i];
+					*trainC++ = color[i];
+				}
+				*trainV++ = second[Segments-1];
+				*trainC++ = color[Segments-1];
+			}
+		}
+
+		for (int i = 0; i < Segments-1; ++i)
+		{
+			*lineV++ = line[i];
+			*lineV++ = line[i+1];
+			*lineC++ = color[i];
+			*lineC++ = color[i+1];
+		}
+
+		// bolide
+		if (bolideSize)
+		{
+			const Vec4f bolideColor(1, 1, 1, apt);
+			const Vec3d topLeft = radiantToAltAz(slot, Vec3d(pos[0], pos[1] - bolideSize, pos[2]));
+			const Vec3d topRight = radiantToAltAz(slot, Vec3d(pos[0] - bolideSize, pos[1], pos[2]));
+			const Vec3d bottomRight = radiantToAltAz(slot, Vec3d(pos[0], pos[1] + bolideSize, pos[2]));
+			const Vec3d bottomLeft = radiantToAltAz(slot, Vec3d(pos[0] + bolideSize, pos[1], pos[2]));
+			// the quad as a strip, with the first and last vertices repeated
+			const Vec3d quad[6] = {topLeft, topLeft, topRight, bottomLeft, bottomRight, bottomRight};
+			static const Vec2f quadTexCoords[6] = {Vec2f(1.f, 0.f), Vec2f(1.f, 0.f), Vec2f(0.f, 0.f),
+							       Vec2f(1.f, 1.f), Vec2f(0.f, 1.f), Vec2f(0.f, 1.f)};
+			for (int i = 0; i < 6; ++i)
+			{
+				*bolideV++ = quad[i];
+				*bolideC++ = bolideColor;
+				*bolideT++ = quadTexCoords[i];
+			}
+		}
+	}
+}
+
+Vec4f MeteorPool::getColorFromName(const QString& colorName)
+{
+	int R, G, B; // 0-255
+	if (colorName == QLatin1String("violet"))
+	{ // Calcium
+		R = 176;
+		G = 67;
+		B = 172;
+	}
+	else if (colorName == QLatin1String("blueGreen"))
+	{ // Magnesium
+		R = 0;
+		G = 255;
+		B = 152;
+	}
+	else if (colorName == QLatin1String("yellow"))
+	{ // Iron
+		R = 255;
+		G = 255;
+		B = 0;
+	}
+	else if (colorName == QLatin1String("orangeYellow"))
+	{ // Sodium
+		R = 255;
+		G = 160;
+		B = 0;
+	}
+	else if (colorName == QLatin1String("red"))
+	{ // atmospheric nitrogen and oxygen
+		R = 255;
+		G = 30;
+		B = 0;
+	}
+	else
+	{ // white
+		R = 255;
+		G = 255;
+		B = 255;
+	}
+
+	return Vec4f(R/255.f, G/255.f, B/255.f, 1);
+}
+
+void MeteorPool::buildColorVector(int slot, const QList<ColorPair>& colors)
+{
+	Vec4f* segColors = segmentColors.data() + slot*Segments;
+
+	// segments to be painted with each color
+	int segs = 0;
+	foreach (const ColorPair& color, colors)
+	{
+		const int n = qRound(Segments * (color.second / 100.f)); // rounds to nearest integer
+		const Vec4f rgba = getColorFromName(color.first);
+		for (int s = 0; s < n; ++s, ++segs)
+		{
+			if (segs < Segments)
+				segColors[segs] = rgba;
+		}
+	}
+
+	// make sure that all segments have been painted!
+	// use the last color to paint the last segments
+	if (segs < Segments)
+	{
+		const Vec4f rgba = getColorFromName(colors.last().first);
+		for (int s = segs; s < Segments; ++s)
+			segColors[s] = rgba;
+	}
+
+	// multi-color ?
+	// select a random segment to be the first (to alternate colors)
+	if (colors.size() > 1)
+	{
+		const int firstSegment = qMin((int) ((segs - 1) * randomUnit()), (int) Segments); // [0, segments-1]
+		std::rotate(segColors, segColors + firstSegment, segColors + Segments);
+	}
+}
+
+float MeteorPool::meteorZ(float zenithAngle, float altitude)
+{
+	float distance;
+
+	if (zenithAngle > 1.13446401f) // > 65 degrees?
+	{
+		float zcos = qCos(zenithAngle);
+		distance = qSqrt(EARTH_RADIUS2 * qPow(zcos, 2)
+				 + 2 * EARTH_RADIUS * altitude
+				 + qPow(altitude, 2));
+		distance -= EARTH_RADIUS * zcos;
+	}
+	else
+	{
+		// (first order approximation)
+		distance = altitude / qCos(zenithAngle);
+	}
+
+	return distance;
+}
+
+Vec3d MeteorPool::radiantToAltAz(int slot, Vec3d pos) const
+{
+	pos /= 1242.0; // 1242 to scale down under 1
+	pos.transfo4d(matAltAzToRadiant.at(slot));
+	return pos;
+}
+
+void MeteorPool::calculateThickness(float fov, float maxFov, float& thickness, float& bolideSize)
+{
+	thickness = 2*log(fov + 0.25)/(1.2*maxFov - (fov + 0.25)) + 0.01;
+	if (fov <= 0.5)
+	{
+		thickness = 0.013 * fov; // decreasing faster
+	}
+	else if (fov > 100.0)
+	{
+		thickness = 0; // remove prism
+	}
+
+	bolideSize = thickness*3;
+}
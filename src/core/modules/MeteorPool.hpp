@@ -0,0 +1,150 @@
+/*
+ * Stellarium
+ * Copyright (C) 2014-2015 Marcos Cardinot
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _METEORPOOL_HPP_
+#define _METEORPOOL_HPP_
+
+#include "VecMath.hpp"
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#define EARTH_RADIUS 6378.f          //! earth_radius in km
+#define EARTH_RADIUS2 40678884.f     //! earth_radius^2 in km
+#define MAX_ALTITUDE 120.f           //! max meteor altitude in km
+#define MIN_ALTITUDE 80.f            //! min meteor altitude in km
+
+//! @class MeteorPool
+//! Models the meteors of a shower, or the sporadic meteors.
+//! The meteors are stored in a pool of fixed capacity, with one array per state variable.
+//! A meteor only lasts for some amount of time, and then "dies": its slot is then reused for a new meteor.
+//! The pool is allocated when the first meteor is spawned. Once the vertex arrays have grown to their size,
+//! spawning, updating and building the geometry of the meteors does not allocate memory.
+//!
+//! The geometry of all meteors is built into a few vertex arrays in the horizontal system,
+//! so that all meteors can be drawn with one call per primitive type (see MeteorGroup).
+//! @author Marcos Cardinot <mcardinot@gmail.com>
+class MeteorPool
+{
+public:
+	//! <colorName, intensity>
+	typedef QPair<QString, int> ColorPair;
+
+	//! Number of segments along the train (useful to curve along projection distortions)
+	static const int Segments = 10;
+
+	//! Create a pool for at most capacity meteors.
+	explicit MeteorPool(int capacity=1024);
+
+	//! Maximal number of meteors alive at the same time.
+	int getCapacity() const { return capacity; }
+	//! Number of meteors alive.
+	int getActiveCount() const { return activeSlots.size(); }
+	//! Slots of the meteors alive.
+	const QVector<int>& getActiveSlots() const { return activeSlots; }
+
+	//! Start a meteor with a random trajectory.
+	//! @param radiantAltAz the radiant in the horizontal system
+	//! @param speed meteor speed in km/s
+	//! @param absMag the luminance of the meteor at a distance of 184 km [0, 1], see StelSkyDrawer::computeRCMag().
+	//! @param colors the colors of the train
+	//! @return the slot of the new meteor, or -1 if it would not be visible or the pool is full.
+	int spawn(const Vec3d& radiantAltAz, float speed, float absMag, const QList<ColorPair>& colors);
+
+	//! Get the absolute magnitude [0, 1] of the meteor in a slot.
+	float getAbsMag(int slot) const { return absMag.at(slot); }
+	//! Set the absolute magnitude [0, 1] of the meteor in a slot.
+	void setAbsMag(int slot, float mag) { absMag[slot] = mag; }
+
+	//! Update the positions of the meteors, and expire them if necessary.
+	//! @param deltaTime the time increment in seconds since the last call.
+	//! @param burning false if the time is not running at real time speed: the meteors then fade out.
+	void update(double deltaTime, bool burning);
+
+	//! Remove all meteors.
+	void clear();
+
+	//! Build the vertex arrays of all meteors alive.
+	//! @param thickness the train thickness, 0 to only draw the train lines
+	//! @param bolideSize the bolide size, 0 for no bolide
+	void buildGeometry(float thickness, float bolideSize);
+
+	//! Vertices and colors of the train prisms, as one triangle strip (meteors are separated by degenerate triangles).
+	const QVector<Vec3d>& getTrainVertices() const { return trainVertices; }
+	const QVector<Vec4f>& getTrainColors() const { return trainColors; }
+	//! Vertices and colors of the train lines, as lines.
+	const QVector<Vec3d>& getLineVertices() const { return lineVertices; }
+	const QVector<Vec4f>& getLineColors() const { return lineColors; }
+	//! Vertices, colors and texture coordinates of the bolides, as one triangle strip.
+	const QVector<Vec3d>& getBolideVertices() const { return bolideVertices; }
+	const QVector<Vec4f>& getBolideColors() const { return bolideColors; }
+	const QVector<Vec2f>& getBolideTexCoords() const { return bolideTexCoords; }
+
+	//! Number of meteors which could not be spawned because the pool was full.
+	quint64 getDroppedCount() const { return droppedCount; }
+
+	//! Calculates the train thickness and bolide size for the current field of view.
+	static void calculateThickness(float fov, float maxFov, float& thickness, float& bolideSize);
+
+	//! get RGB from color name
+	static Vec4f getColorFromName(const QString& colorName);
+
+private:
+	//! Allocate the state arrays for capacity meteors.
+	void allocate();
+
+	//! Fill the segment colors of a slot.
+	void buildColorVector(int slot, const QList<ColorPair>& colors);
+
+	//! Calculates the z-component of a meteor as a function of meteor zenith angle
+	static float meteorZ(float zenithAngle, float altitude);
+
+	//! find meteor position in horizontal coordinate system
+	Vec3d radiantToAltAz(int slot, Vec3d position) const;
+
+	const int capacity;
+
+	// Meteor state, indexed by slot
+	QVector<float> speed;                  //! Velocity of meteor in km/s.
+	QVector<Mat4d> matAltAzToRadiant;      //! Rotation matrix to convert from horizontal to radiant coordinate system.
+	QVector<Vec3d> position;               //! Meteor position in radiant coordinate system.
+	QVector<float> trainZ;                 //! z-component of the end of train in radiant coordinate system.
+	QVector<float> initialZ;               //! Initial z-component of the meteor in radiant coordinates.
+	QVector<float> finalZ;                 //! Final z-component of the meteor in radiant coordinates.
+	QVector<float> minDist;                //! Shortest distance between meteor and observer.
+	QVector<float> absMag;                 //! Absolute magnitude [0, 1]
+	QVector<float> aptMag;                 //! Apparent magnitude [0, 1]
+	QVector<Vec4f> segmentColors;          //! Segments colors of all slots, Segments per slot
+
+	QVector<int> activeSlots;
+	QVector<int> freeSlots;
+	quint64 droppedCount;
+
+	QVector<Vec3d> trainVertices;
+	QVector<Vec4f> trainColors;
+	QVector<Vec3d> lineVertices;
+	QVector<Vec4f> lineColors;
+	QVector<Vec3d> bolideVertices;
+	QVector<Vec4f> bolideColors;
+	QVector<Vec2f> bolideTexCoords;
+};
+
+#endif // _METEORPOOL_HPP_
@@ -37,6 +37,7 @@
 #include "StelMovementMgr.hpp"
 
 #include <QDebug>
+#include <QOpenGLShaderProgram>
 #include <QSettings>
 
 // Class which manages the displaying of the Milky Way
@@ -47,6 +48,11 @@ MilkyWay::MilkyWay()
 	, intensityMinFov(0.25f) // when zooming in further, MilkyWay is no longer visible.
 	, intensityMaxFov(2.5f) // when zooming out further, MilkyWay is fully visible (when enabled).
 	, vertexArray()
+	, meshShader(Q_NULLPTR)
+	, buffersFailed(false)
+	, vertexBuffer(QOpenGLBuffer::VertexBuffer)
+	, indexBuffer(QOpenGLBuffer::IndexBuffer)
+	, projectedBuffer(QOpenGLBuffer::VertexBuffer)
 {
 	setObjectName("MilkyWay");
 	fader = new LinearFader();
@@ -59,6 +65,9 @@ MilkyWay::~MilkyWay()
 	
 	delete vertexArray;
 	vertexArray = Q_NULLPTR;
+
+	delete meshShader;
+	meshShader = Q_NULLPTR;
 }
 
 void MilkyWay::init()
@@ -167,30 +176,156 @@ void MilkyWay::draw(StelCore* core)
 
 	if (withExtinction)
 	{
-		// We must process the vertices to find geometric altitudes in order to compute vertex colors.
+		// The vertex colors depend on the apparent altitudes of the vertices, like with StelCore::RefractionOn.
+		// The shader gets the geometric altitudes from the zenith (which refraction doesn't move), and refracts them.
 		// Note that there is a visible boost of extinction for higher Bortle indices. I must reflect that as well.
-		const Extinction& extinction=drawer->getExtinction();
-		vertexArray->colors.clear();
-
-		for (int i=0; i<vertexArray->vertex.size(); ++i)
-		{
-			Vec3d vertAltAz=core->j2000ToAltAz(vertexArray->vertex.at(i), StelCore::RefractionOn);
-			Q_ASSERT(fabs(vertAltAz.lengthSquared()-1.0) < 0.001);
-
-			float oneMag=0.0f;
-			extinction.forward(vertAltAz, &oneMag);
-			float extinctionFactor=std::pow(0.3f , oneMag) * (1.1f-bortle*0.1f); // drop of one magnitude: should be factor 2.5 or 40%. We take 30%, it looks more realistic.
-			Vec3f thisColor=Vec3f(c[0]*extinctionFactor, c[1]*extinctionFactor, c[2]*extinctionFactor);
-			vertexArray->colors.append(thisColor);
-		}
+		// Drop of one magnitude: should be factor 2.5 or 40%. We take 30%, it looks more realistic.
+		extinctionShading.setExtinction(drawer->getExtinction(), 0.3f, 1.1f-bortle*0.1f);
+		extinctionShading.setZenith(core->altAzToJ2000(Vec3d(0., 0., 1.), StelCore::RefractionOff));
+		extinctionShading.setRefraction(drawer->getRefraction());
 	}
 	else
-		vertexArray->colors.fill(Vec3f(c[0], c[1], c[2]));
+		extinctionShading.disable();
 
 	StelPainter sPainter(prj);
 	sPainter.setCullFace(true);
 	sPainter.setBlending(false);
 	tex->bind();
-	sPainter.drawStelVertexArray(*vertexArray);
+	// Projections with discontinuities need the removal of the triangles crossing them by drawStelVertexArray()
+	if (prj->hasDiscontinuity() || !drawBuffers(sPainter, c))
+	{
+		// Compute the same vertex colors on the CPU
+		vertexArray->colors.resize(vertexArray->vertex.size());
+		for (int i=0; i<vertexArray->vertex.size(); ++i)
+		{
+			const Vec3d& v = vertexArray->vertex.at(i);
+			vertexArray->colors[i] = c*extinctionShading.getAttenuation(Vec3f(v[0], v[1], v[2]));
+		}
+		sPainter.drawStelVertexArray(*vertexArray);
+	}
 	sPainter.setCullFace(false);
 }
+
+bool MilkyWay::initBuffers()
+{
+	if (meshShader)
+		return true;
+	if (buffersFailed)
+		return false;
+	buffersFailed = true;
+
+	QOpenGLShader vShader(QOpenGLShader::Vertex);
+	const QByteArray vsrc = QByteArray(ExtinctionShading::getShaderSource()) +
+		"attribute highp vec3 projectedVertex;\n"
+		"attribute highp vec3 vertex;\n"
+		"attribute mediump vec2 texCoord;\n"
+		"uniform mediump mat4 projectionMatrix;\n"
+		"uniform mediump vec3 color;\n"
+		"varying mediump vec2 texc;\n"
+		"varying mediump vec4 outColor;\n"
+		"void main(void)\n"
+		"{\n"
+		"    gl_Position = projectionMatrix*vec4(projectedVertex, 1.);\n"
+		"    texc = texCoord;\n"
+		"    outColor = vec4(color*extinctionAttenuation(vertex), 1.);\n"
+		"}\n";
+	QOpenGLShader fShader(QOpenGLShader::Fragment);
+	const char* fsrc =
+		"varying mediump vec2 texc;\n"
+		"varying mediump vec4 outColor;\n"
+		"uniform sampler2D tex;\n"
+		"void main(void)\n"
+		"{\n"
+		"    gl_FragColor = texture2D(tex, texc)*outColor;\n"
+		"}\n";
+	if (!vShader.compileSourceCode(vsrc) || !fShader.compileSourceCode(fsrc))
+	{
+		qWarning() << "MilkyWay: error while compiling shaders, computing the extinction on the CPU:" << vShader.log() << fShader.log();
+		return false;
+	}
+	QOpenGLShaderProgram* program = new QOpenGLShaderProgram();
+	program->addShader(&vShader);
+	program->addShader(&fShader);
+	if (!StelPainter::linkProg(program, "milkyWay"))
+	{
+		delete program;
+		return false;
+	}
+
+	// The mesh never changes, it is uploaded once
+	const int n = vertexArray->vertex.size();
+	QVector<float> data;
+	data.reserve(n*5);
+	for (int i=0; i<n; ++i)
+	{
+		const Vec3d& v = vertexArray->vertex.at(i);
+		const Vec2f& t = vertexArray->texCoords.at(i);
+		data << v[0] << v[1] << v[2] << t[0] << t[1];
+	}
+	if (!vertexBuffer.create() || !indexBuffer.create() || !projectedBuffer.create())
+	{
+		qWarning() << "MilkyWay: cannot create vertex buffers";
+		delete program;
+		return false;
+	}
+	vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	vertexBuffer.bind();
+	vertexBuffer.allocate(data.constData(), data.size()*sizeof(float));
+	vertexBuffer.release();
+	indexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	indexBuffer.bind();
+	indexBuffer.allocate(vertexArray->indices.constData(), vertexArray->indices.size()*sizeof(unsigned short));
+	indexBuffer.release();
+	projectedBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+	projectedVertices.resize(n);
+
+	meshShaderVars.projectionMatrix = program->uniformLocation("projectionMatrix");
+	meshShaderVars.color = program->uniformLocation("color");
+	meshShaderVars.tex = program->uniformLocation("tex");
+	meshShaderVars.projectedVertex = program->attributeLocation("projectedVertex");
+	meshShaderVars.vertex = program->attributeLocation("vertex");
+	meshShaderVars.texCoord = program->attributeLocation("texCoord");
+	meshShader = program;
+	buffersFailed = false;
+	return true;
+}
+
+bool MilkyWay::drawBuffers(StelPainter& painter, const Vec3f& color)
+{
+	if (!initBuffers())
+		return false;
+
+	// Only the projection is still computed by the CPU, the projectors are not linear
+	const StelProjectorP& prj = painter.getProjector();
+	prj->project(projectedVertices.size(), vertexArray->vertex.constData(), projectedVertices.data());
+	const Mat4f& m = prj->getProjectionMatrix();
+	const QMatrix4x4 qMat(m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15]);
+
+	meshShader->bind();
+	projectedBuffer.bind();
+	projectedBuffer.allocate(projectedVertices.constData(), projectedVertices.size()*sizeof(Vec3f));
+	meshShader->setAttributeBuffer(meshShaderVars.projectedVertex, GL_FLOAT, 0, 3);
+	meshShader->enableAttributeArray(meshShaderVars.projectedVertex);
+	projectedBuffer.release();
+	vertexBuffer.bind();
+	meshShader->setAttributeBuffer(meshShaderVars.vertex, GL_FLOAT, 0, 3, 5*sizeof(float));
+	meshShader->enableAttributeArray(meshShaderVars.vertex);
+	meshShader->setAttributeBuffer(meshShaderVars.texCoord, GL_FLOAT, 3*sizeof(float), 2, 5*sizeof(float));
+	meshShader->enableAttributeArray(meshShaderVars.texCoord);
+	vertexBuffer.release();
+
+	meshShader->setUniformValue(meshShaderVars.projectionMatrix, qMat);
+	meshShader->setUniformValue(meshShaderVars.color, color[0], color[1], color[2]);
+	meshShader->setUniformValue(meshShaderVars.tex, 0);
+	extinctionShading.setUniforms(*meshShader);
+
+	indexBuffer.bind();
+	painter.glFuncs()->glDrawElements(GL_TRIANGLES, vertexArray->indices.size(), GL_UNSIGNED_SHORT, Q_NULLPTR);
+	indexBuffer.release();
+
+	meshShader->disableAttributeArray(meshShaderVars.projectedVertex);
+	meshShader->disableAttributeArray(meshShaderVars.vertex);
+	meshShader->disableAttributeArray(meshShaderVars.texCoord);
+	meshShader->release();
+	return true;
+}
@@ -23,6 +23,12 @@
 #include "StelModule.hpp"
 #include "VecMath.hpp"
 #include "StelTextureTypes.hpp"
+#include "ExtinctionShading.hpp"
+
+#include <QOpenGLBuffer>
+
+class QOpenGLShaderProgram;
+class StelPainter;
 
 //! @class MilkyWay 
 //! Manages the displaying of the Milky Way.
@@ -101,6 +107,32 @@ private:
 	class LinearFader* fader;
 
 	struct StelVertexArray* vertexArray;
+
+	//! Create the shader and upload the mesh into the vertex buffers
+	bool initBuffers();
+	//! Draw the mesh from the vertex buffers, the extinction is computed by the shader.
+	//! @return false if the buffers can't be used
+	bool drawBuffers(StelPainter& painter, const Vec3f& color);
+
+	ExtinctionShading extinctionShading;
+	QOpenGLShaderProgram* meshShader;
+	struct MeshShaderVars
+	{
+		int projectionMatrix;
+		int color;
+		int tex;
+		int projectedVertex;
+		int vertex;
+		int texCoord;
+	};
+	MeshShaderVars meshShaderVars;
+	bool buffersFailed;
+	//! The J2000 positions and texture coordinates of the mesh, interleaved
+	QOpenGLBuffer vertexBuffer;
+	QOpenGLBuffer indexBuffer;
+	//! The positions projected in the current frame
+	QOpenGLBuffer projectedBuffer;
+	QVector<Vec3f> projectedVertices;
 };
 
 #endif // _MILKYWAY_HPP_
@@ -29,6 +29,7 @@
 #include "StelTranslator.hpp"
 #include "StelUtils.hpp"
 #include "StelFileMgr.hpp"
+#include "Orbit.hpp"
 
 #include <QRegExp>
 #include <QDebug>
@@ -423,6 +424,19 @@ float MinorPlanet::getVMagnitude(const StelCore* core) const
 	return apparentMagnitude;
 }
 
+Vec3d MinorPlanet::computeHeliocentricEclipticPos(const double dateJDE) const
+{
+	// orbitPtr always points to an Orbit, see SolarSystem::loadPlanets()
+	CometOrbit* orbit = dynamic_cast<CometOrbit*>(static_cast<Orbit*>(orbitPtr));
+	if (!orbit)
+		return Planet::computeHeliocentricEclipticPos(dateJDE);
+
+	// Leave the velocity and the tail flag of the shared orbit untouched
+	Vec3d pos;
+	orbit->positionAtTimevInVSOP87Coordinates(dateJDE, pos, false);
+	return pos;
+}
+
 void MinorPlanet::translateName(const StelTranslator &translator)
 {
 	nameI18 = translator.qtranslate(properName, "minor planet");
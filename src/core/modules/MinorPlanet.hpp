@@ -74,6 +74,9 @@ public:
 	// \todo Decide if this is going to be "MinorPlanet" or "Asteroid"
 	//virtual QString getType() const {return "MinorPlanet";}
 	virtual float getVMagnitude(const StelCore* core) const;
+	//! re-implementation of Planet's computeHeliocentricEclipticPos(). Minor planets may have a comet orbit,
+	//! whose default position function changes the state of the orbit, so it is called without updating it.
+	virtual Vec3d computeHeliocentricEclipticPos(const double dateJDE) const;
 	//! sets the nameI18 property with the appropriate translation.
 	//! Function overriden to handle the problem with name conflicts.
 	virtual void translateName(const StelTranslator& trans);
@@ -851,8 +851,13 @@ void NomenclatureItem::draw(StelCore* core, StelPainter *painter)
 	if (!getFlagLabels())
 		return;
 
-	const Vec3d equPos = planet->getJ2000EquatorialPos(core);
-	Vec3d XYZ = getJ2000EquatorialPos(core);
+	draw(core, painter, planet->getJ2000EquatorialPos(core), getJ2000EquatorialPos(core));
+}
+
+void NomenclatureItem::draw(StelCore* core, StelPainter *painter, const Vec3d& equPos, const Vec3d& XYZ)
+{
+	if (!getFlagLabels())
+		return;
 
 	// In case we are located at a labeled site, don't show this label or any labels within 150 km. Else we have bad flicker...
 	if (XYZ.lengthSquared() < 150.*150.*AU_KM*AU_KM )
@@ -865,7 +870,7 @@ void NomenclatureItem::draw(StelCore* core, StelPainter *painter)
 			return;
 	}
 
-	double screenSize = getAngularSize(core)*M_PI/180.*painter->getProjector()->getPixelPerRadAtCenter();
+	double screenSize = std::atan2(size*planet->getSphereScale()/AU, XYZ.length())*painter->getProjector()->getPixelPerRadAtCenter();
 
 	// We can use ratio of angular size to the FOV to checking visibility of features also!
 	// double scale = getAngularSize(core)/painter->getProjector()->getFov();
@@ -164,6 +164,10 @@ private:
 	static bool hideLocalNomenclature;
 
 	QString getNomenclatureTypeLatinString() const;
+	//! Store the J2000 position computed by NomenclatureMgr for the time @param atJDE
+	void setJ2000EquatorialPos(const Vec3d& pos, double atJDE) { XYZ = pos; jde = atJDE; }
+	//! Draw the label at the J2000 position @param pos, where @param planetPos is the position of the planet
+	void draw(StelCore* core, StelPainter* painter, const Vec3d& planetPos, const Vec3d& pos);
 
 	PlanetP planet;
 	int identificator;
@@ -35,8 +35,10 @@
 #include <QDir>
 
 NomenclatureMgr::NomenclatureMgr()
+	: flagLabels(false)
 {
 	setObjectName("NomenclatureMgr");
+	setNameIndexEnabled(true);
 	conf = StelApp::getInstance().getSettings();
 	font.setPixelSize(StelApp::getInstance().getBaseFontSize());
 	ssystem = GETSTELMODULE(SolarSystem);
@@ -87,7 +89,9 @@ void NomenclatureMgr::loadNomenclature()
 {
 	qDebug() << "Loading nomenclature for Solar system bodies ...";
 
-	nomenclatureItems.clear();	
+	nomenclatureItems.clear();
+	bodyNomenclature.clear();
+	invalidateNameIndex();
 
 	// regular expression to find the comments and empty lines
 	QRegExp commentRx("^(\\s*#.*|\\s*)$");
@@ -364,7 +368,13 @@ void NomenclatureMgr::loadNomenclature()
 				{
 					NomenclatureItemP nom = NomenclatureItemP(new NomenclatureItem(p, featureId, name, context, ntype, latitude, longitude, size));
 					if (!nom.isNull())
+					{
+						nom->setFlagLabels(flagLabels);
 						nomenclatureItems.insert(p, nom);
+						BodyNomenclature& body = bodyNomenclature[p];
+						body.items.append(nom);
+						body.index.addFeature(nom->XYZpc, size);
+					}
 
 					readOk++;
 				}				
@@ -372,6 +382,8 @@ void NomenclatureMgr::loadNomenclature()
 		}
 
 		planetSurfNamesFile.close();
+		for (auto i = bodyNomenclature.begin(); i != bodyNomenclature.end(); ++i)
+			i->index.build();
 		qDebug() << "Loaded" << readOk << "/" << totalRecords << "items of planetary surface nomenclature";
 
 	}
@@ -380,6 +392,7 @@ void NomenclatureMgr::loadNomenclature()
 void NomenclatureMgr::deinit()
 {
 	nomenclatureItems.clear();
+	bodyNomenclature.clear();
 	texPointer.clear();
 }
 
@@ -389,27 +402,45 @@ void NomenclatureMgr::draw(StelCore* core)
 	StelPainter painter(prj);
 	painter.setFont(font);
 	const SphericalCap& viewportRegion = painter.getProjector()->getBoundingCap();
+	const double pixelPerRad = painter.getProjector()->getPixelPerRadAtCenter();
+	// Labels are only drawn for features larger than 50 pixels
+	const double minAngularSize = 50./pixelPerRad;
 
-	foreach(PlanetP p, nomenclatureItems.uniqueKeys())
+	if (flagLabels && minAngularSize<M_PI_2)
 	{
-		// Early exit if the planet is not visible or too small to render the
-		// labels.
-		const Vec3d equPos = p->getJ2000EquatorialPos(core);
-		const double r = p->getRadius() * p->getSphereScale();
-		double angularSize = atan2(r, equPos.length());
-		double screenSize = angularSize * painter.getProjector()->getPixelPerRadAtCenter();
-		if (screenSize < 50) continue;
-		Vec3d n = equPos; n.normalize();
-		SphericalCap boundingCap(n, cos(angularSize));
-		if (!viewportRegion.intersects(boundingCap)) continue;
-		if (p->getVMagnitude(core) >= 20.) continue;
-
-		// Render all the items of this planet.
-		for (auto i = nomenclatureItems.find(p); i != nomenclatureItems.end() && i.key() == p; ++i)
+		for (auto b = bodyNomenclature.constBegin(); b != bodyNomenclature.constEnd(); ++b)
 		{
-			const NomenclatureItemP& nItem = i.value();
-			if (nItem)
-				nItem->draw(core, &painter);
+			const PlanetP& p = b.key();
+			// Early exit if the planet is not visible or too small to render the
+			// labels.
+			const Vec3d equPos = p->getJ2000EquatorialPos(core);
+			const double r = p->getRadius() * p->getSphereScale();
+			double angularSize = atan2(r, equPos.length());
+			double screenSize = angularSize * pixelPerRad;
+			if (screenSize < 50) continue;
+			Vec3d n = equPos; n.normalize();
+			SphericalCap boundingCap(n, cos(angularSize));
+			if (!viewportRegion.intersects(boundingCap)) continue;
+			if (p->getVMagnitude(core) >= 20.) continue;
+			if (NomenclatureItem::hideLocalNomenclature && p==core->getCurrentPlanet()) continue;
+
+			// The rotation from planetocentric to J2000 coordinates is the same for all features of the planet.
+			// See NomenclatureItem::getJ2000EquatorialPos().
+			const Mat4d rotation = core->matVsop87ToJ2000 * p->getRotEquatorialToVsop87() * Mat4d::zrotation(p->getAxisRotation()*M_PI/180.);
+			// Features smaller than this are below 50 pixels even at the nearest point of the surface
+			const float minSize = std::tan(minAngularSize) * qMax(0., equPos.length()-r) * AU / p->getSphereScale();
+
+			// Render the items of this planet on the side facing us and in the viewport.
+			visibleFeatures.clear();
+			b->index.findVisible(rotation, equPos, r, viewportRegion, minSize, visibleFeatures);
+			const double jde = core->getJDE();
+			foreach (int feature, visibleFeatures)
+			{
+				const NomenclatureItemP& nItem = b->items.at(feature);
+				const Vec3d pos = equPos + rotation * (nItem->XYZpc*r);
+				nItem->setJ2000EquatorialPos(pos, jde);
+				nItem->draw(core, &painter, equPos, pos);
+			}
 		}
 	}
 
@@ -597,8 +628,11 @@ const Vec3f& NomenclatureMgr::getColor(void) const
 
 void NomenclatureMgr::setFlagLabels(bool b)
 {
-	if (getFlagLabels() != b)
+	if (flagLabels != b)
 	{
+		flagLabels = b;
+		// no names are listed while the labels are hidden
+		invalidateNameIndex();
 		foreach (NomenclatureItemP i, nomenclatureItems)
 			i->setFlagLabels(b);
 		emit nomenclatureDisplayedChanged(b);
@@ -607,12 +641,7 @@ void NomenclatureMgr::setFlagLabels(bool b)
 
 bool NomenclatureMgr::getFlagLabels() const
 {
-	foreach (NomenclatureItemP i, nomenclatureItems)
-	{
-		if (i->getFlagLabels())
-			return true;
-	}
-	return false;
+	return flagLabels;
 }
 
 void NomenclatureMgr::setFlagHideLocalNomenclature(bool b)
@@ -632,4 +661,5 @@ void NomenclatureMgr::updateI18n()
 	const StelTranslator& trans = StelApp::getInstance().getLocaleMgr().getPlanetaryFeaturesTranslator();
 	foreach (NomenclatureItemP i, nomenclatureItems)
 		i->translateName(trans);
+	invalidateNameIndex();
 }
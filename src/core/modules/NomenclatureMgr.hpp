@@ -24,8 +24,10 @@
 #include "StelObject.hpp"
 #include "StelTextureTypes.hpp"
 #include "NomenclatureItem.hpp"
+#include "NomenclatureSurfaceIndex.hpp"
 
 #include <QFont>
+#include <QHash>
 #include <QMultiHash>
 
 class StelPainter;
@@ -141,6 +143,17 @@ private:
 	QSettings* conf;
 	StelTextureSP texPointer;	
 	QMultiHash<PlanetP, NomenclatureItemP> nomenclatureItems;
+
+	//! The items of one body, in the order of their numbers in the surface index
+	struct BodyNomenclature
+	{
+		QVector<NomenclatureItemP> items;
+		NomenclatureSurfaceIndex index;
+	};
+	QHash<PlanetP, BodyNomenclature> bodyNomenclature;
+	//! Features found by the surface index, kept to avoid reallocations
+	QVector<int> visibleFeatures;
+	bool flagLabels;
 };
 
 #endif /*_NOMENCLATUREMGR_HPP_*/
@@ -0,0 +1,170 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "NomenclatureSurfaceIndex.hpp"
+#include "StelGeodesicGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+const int NomenclatureSurfaceIndex::GridLevel;
+
+NomenclatureSurfaceIndex::NomenclatureSurfaceIndex()
+{
+	zoneStart.append(0);
+}
+
+int NomenclatureSurfaceIndex::addFeature(const Vec3d& pos, float size)
+{
+	pending.append(pos);
+	pendingSizes.append(size);
+	return pending.size()-1;
+}
+
+void NomenclatureSurfaceIndex::clear()
+{
+	pending.clear();
+	pendingSizes.clear();
+	build();
+}
+
+void NomenclatureSurfaceIndex::build()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	sizes.clear();
+	featureIds.clear();
+	zoneCenters.clear();
+	zoneAngles.clear();
+	zoneStart.clear();
+	zoneStart.append(0);
+	if (pending.isEmpty())
+		return;
+
+	const StelGeodesicGrid grid(GridLevel);
+	QVector<QVector<int> > zoneFeatures(grid.getNrOfZones());
+	for (int i=0; i<pending.size(); ++i)
+	{
+		const Vec3d& p = pending.at(i);
+		zoneFeatures[grid.getZoneNumberForPoint(Vec3f(p[0], p[1], p[2]), GridLevel)].append(i);
+	}
+
+	x.reserve(pending.size());
+	y.reserve(pending.size());
+	z.reserve(pending.size());
+	sizes.reserve(pending.size());
+	featureIds.reserve(pending.size());
+	for (int zone=0; zone<zoneFeatures.size(); ++zone)
+	{
+		QVector<int>& features = zoneFeatures[zone];
+		if (features.isEmpty())
+			continue;
+
+		// The largest features first, so that the search can stop at the first one which is too small
+		std::stable_sort(features.begin(), features.end(), [this](int a, int b) { return pendingSizes.at(a) > pendingSizes.at(b); });
+		foreach (int i, features)
+		{
+			const Vec3d& p = pending.at(i);
+			x.append(p[0]);
+			y.append(p[1]);
+			z.append(p[2]);
+			sizes.append(pendingSizes.at(i));
+			featureIds.append(i);
+		}
+
+		// Bounding cap of the triangle, around the mean of its corners
+		Vec3f corners[3];
+		grid.getTriangleCorners(GridLevel, zone, corners[0], corners[1], corners[2]);
+		Vec3d center(0.);
+		for (int c=0; c<3; ++c)
+			center += Vec3d(corners[c][0], corners[c][1], corners[c][2]);
+		center.normalize();
+		double angle = 0.;
+		for (int c=0; c<3; ++c)
+		{
+			Vec3d corner(corners[c][0], corners[c][1], corners[c][2]);
+			corner.normalize();
+			angle = qMax(angle, std::acos(qBound(-1., corner*center, 1.)));
+		}
+		// The zone lookup is done in float, and the features are not normalized exactly
+		foreach (int i, features)
+			angle = qMax(angle, std::acos(qBound(-1., pending.at(i)*center/pending.at(i).length(), 1.)));
+		zoneCenters.append(center);
+		zoneAngles.append(angle);
+		zoneStart.append(x.size());
+	}
+}
+
+int NomenclatureSurfaceIndex::findVisible(const Mat4d& rotation, const Vec3d& center, double radius, const SphericalCap& viewport,
+					  float minSize, QVector<int>& result) const
+{
+	const double dist = center.length();
+	if (dist<=0. || radius<=0.)
+		return 0;
+
+	// Direction to the observer in the planetocentric frame
+	Vec3d toObserver = rotation.transpose().multiplyWithoutTranslation(-center);
+	toObserver /= dist;
+	// A point of the surface is nearer to the observer than the center of the body if
+	// its direction is within this angle of the direction to the observer.
+	const double cosHorizon = qMin(1., 0.5*radius/dist);
+	const double horizonAngle = std::acos(cosHorizon);
+	Vec3d viewDir = viewport.n;
+	viewDir.normalize();
+	const double viewAngle = std::acos(qBound(-1., viewport.d, 1.));
+
+	int examined = 0;
+	for (int zone=0; zone<zoneCenters.size(); ++zone)
+	{
+		const Vec3d& zoneCenter = zoneCenters.at(zone);
+		const double zoneAngle = zoneAngles.at(zone);
+
+		// Zones on the far side of the body
+		if (horizonAngle+zoneAngle<M_PI && zoneCenter*toObserver<std::cos(horizonAngle+zoneAngle))
+			continue;
+
+		// Zones outside the viewport. The features of the zone lie in a ball around the surface point
+		// at the center of the zone, whose radius is the chord of the angular radius of the zone.
+		if (viewAngle<M_PI)
+		{
+			const Vec3d ballCenter = center + rotation.multiplyWithoutTranslation(zoneCenter)*radius;
+			const double ballDist = ballCenter.length();
+			const double ballRadius = 2.*radius*std::sin(0.5*zoneAngle);
+			if (ballRadius<ballDist)
+			{
+				const double limit = viewAngle + std::asin(ballRadius/ballDist);
+				if (limit<M_PI && ballCenter*viewDir<ballDist*std::cos(limit))
+					continue;
+			}
+		}
+
+		const int end = zoneStart.at(zone+1);
+		for (int i=zoneStart.at(zone); i<end; ++i)
+		{
+			if (sizes.at(i)<minSize)
+				break;
+			++examined;
+			if (x.at(i)*toObserver[0] + y.at(i)*toObserver[1] + z.at(i)*toObserver[2] >= cosHorizon)
+				result.append(featureIds.at(i));
+		}
+	}
+	return examined;
+}
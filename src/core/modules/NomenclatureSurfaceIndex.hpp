@@ -0,0 +1,88 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _NOMENCLATURESURFACEINDEX_HPP_
+#define _NOMENCLATURESURFACEINDEX_HPP_
+
+#include "VecMath.hpp"
+#include "StelSphereGeometry.hpp"
+
+#include <QVector>
+
+//! @class NomenclatureSurfaceIndex
+//! Spatial index of the surface features of one body, used to find the features which may be visible
+//! without transforming all of them.
+//! The features are given as unit vectors in the planetocentric (body-fixed) frame. build() sorts them
+//! into the zones of a small geodesic grid on the body surface, and stores them zone by zone in
+//! separate coordinate and size arrays, the largest features of a zone first.
+//!
+//! findVisible() rejects whole zones which lie behind the body as seen by the observer, or outside the
+//! viewport, and only then looks at the features of the remaining zones.
+class NomenclatureSurfaceIndex
+{
+public:
+	//! Level of the geodesic grid used for the zones (1280 zones)
+	static const int GridLevel = 3;
+
+	NomenclatureSurfaceIndex();
+
+	//! Add a feature. build() must be called before searching again.
+	//! @param pos planetocentric unit vector of the feature
+	//! @param size diameter of the feature in km
+	//! @return the number of the feature, which is what findVisible() returns
+	int addFeature(const Vec3d& pos, float size);
+	int getFeatureCount() const { return pending.size(); }
+	//! Number of zones which contain features
+	int getZoneCount() const { return zoneStart.size()-1; }
+	void clear();
+
+	//! Sort the features added so far into the zones of the index.
+	void build();
+
+	//! Find the features which may be visible.
+	//! A feature is returned if it is at least @param minSize large, lies on the side of the body facing the
+	//! observer (i.e. is nearer to the observer than the center of the body), and its zone intersects the viewport.
+	//! @param rotation rotation from the planetocentric frame to the frame of @param center and @param viewport
+	//! @param center position of the center of the body relative to the observer
+	//! @param radius radius of the body, in the units of @param center
+	//! @param viewport bounding cap of the viewport
+	//! @param result the numbers of the features are appended to it
+	//! @return the number of features which were examined
+	int findVisible(const Mat4d& rotation, const Vec3d& center, double radius, const SphericalCap& viewport,
+			float minSize, QVector<int>& result) const;
+
+private:
+	// Features in the order they were added
+	QVector<Vec3d> pending;
+	QVector<float> pendingSizes;
+
+	// Features sorted by zone, and by decreasing size in each zone
+	QVector<double> x, y, z;
+	QVector<float> sizes;
+	QVector<int> featureIds;
+
+	// Bounding caps of the zones which contain features
+	QVector<Vec3d> zoneCenters;
+	QVector<double> zoneAngles;
+	//! The features of zone i are from zoneStart[i] to zoneStart[i+1]
+	QVector<int> zoneStart;
+};
+
+#endif // _NOMENCLATURESURFACEINDEX_HPP_
@@ -743,6 +743,16 @@ void Planet::computePositionWithoutOrbits(const double dateJDE)
 	}
 }
 
+Vec3d Planet::computeHeliocentricEclipticPos(const double dateJDE) const
+{
+	Vec3d pos;
+	coordFunc(dateJDE, pos, orbitPtr);
+	const Planet* pp = parent.data();
+	if (pp && pp->parent.data())
+		pos += pp->computeHeliocentricEclipticPos(dateJDE);
+	return pos;
+}
+
 // return value in radians!
 // For Earth, this is epsilon_A, the angle between earth's rotational axis and mean ecliptic of date.
 // Details: e.g. Hilton etal, Report on Precession and the Ecliptic, Cel.Mech.Dyn.Astr.94:351-67 (2006), Fig1.
@@ -272,6 +272,9 @@ public:
 	//! Compute the position in the parent Planet coordinate system
 	void computePositionWithoutOrbits(const double dateJDE);
 	virtual void computePosition(const double dateJDE);
+	//! Compute the heliocentric ecliptic position at another date, without changing the state of this planet
+	//! or of its parents. Unlike computePosition(), this may be called from a worker thread.
+	virtual Vec3d computeHeliocentricEclipticPos(const double dateJDE) const;
 
 	//! Compute the transformation matrix from the local Planet coordinate to the parent Planet coordinate.
 	//! This requires both flavours of JD in cases involving Earth.
@@ -42,6 +42,7 @@
 #include "StelSkyDrawer.hpp"
 #include "StelUtils.hpp"
 #include "StelPainter.hpp"
+#include "StelProfiler.hpp"
 #include "TrailGroup.hpp"
 #include "RefractionExtinction.hpp"
 
@@ -90,6 +91,8 @@ SolarSystem::SolarSystem()
 	planetNameFont.setPixelSize(StelApp::getInstance().getBaseFontSize());
 	setObjectName("SolarSystem");
 	gui = dynamic_cast<StelGui*>(StelApp::getInstance().getGui());
+	// With all minor bodies loaded, scanning the names for each key typed in the search dialog is slow
+	setNameIndexEnabled(true);
 }
 
 void SolarSystem::setFontSize(float newFontSize)
@@ -406,6 +409,7 @@ void cometOrbitPosFunc(double jd,double xyz[3], void* userDataPtr)
 // Init and load the solar system data (2 files)
 void SolarSystem::loadPlanets()
 {
+	invalidateNameIndex();
 	minorBodies.clear();
 	systemMinorBodies.clear();
 	qDebug() << "Loading Solar System data (1: planets and moons) ...";
@@ -1192,6 +1196,7 @@ bool SolarSystem::loadPlanets(const QString& filePath)
 // The order is not important since the position is computed relatively to the mother body
 void SolarSystem::computePositions(double dateJDE, PlanetP observerPlanet)
 {
+	StelProfiler::Scope scope("SolarSystem: compute positions");
 	if (flagLightTravelTime)
 	{
 		foreach (PlanetP p, systemPlanets)
@@ -1281,6 +1286,7 @@ void SolarSystem::draw(StelCore* core)
 
 	if (trailFader.getInterstate()>0.0000001f)
 	{
+		StelProfiler::Scope scope("SolarSystem: trails", StelProfiler::Draw);
 		StelPainter* sPainter = new StelPainter(core->getProjection2d());
 		allTrails->setOpacity(trailFader.getInterstate());
 		allTrails->draw(core, sPainter);
@@ -1292,9 +1298,12 @@ void SolarSystem::draw(StelCore* core)
 			5.f+(core->getSkyDrawer()->getLimitMagnitude()-5.f)*1.2f) +(labelsAmount-3.f)*1.2f;
 
 	// Draw the elements
-	foreach (const PlanetP& p, systemPlanets)
 	{
-		p->draw(core, maxMagLabel, planetNameFont);
+		StelProfiler::Scope scope("SolarSystem: bodies and labels", StelProfiler::Draw);
+		foreach (const PlanetP& p, systemPlanets)
+		{
+			p->draw(core, maxMagLabel, planetNameFont);
+		}
 	}
 
 	if (GETSTELMODULE(StelObjectMgr)->getFlagSelectedObjectPointer() && getFlagPointer())
@@ -1539,6 +1548,7 @@ void SolarSystem::updateI18n()
 	const StelTranslator& trans = StelApp::getInstance().getLocaleMgr().getSkyTranslator();
 	foreach (PlanetP p, systemPlanets)
 		p->translateName(trans);
+	invalidateNameIndex();
 }
 
 void SolarSystem::setFlagTrails(bool b)
@@ -2518,6 +2528,7 @@ bool SolarSystem::removeMinorPlanet(QString name)
 		orbits.removeOne(orbPtr);
 	systemPlanets.removeOne(candidate);
 	systemMinorBodies.removeOne(candidate);
+	invalidateNameIndex();
 	candidate.clear();
 	return true;
 }
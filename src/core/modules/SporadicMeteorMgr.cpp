@@ -26,9 +26,36 @@
 #include "StelModuleMgr.hpp"
 #include "StelPainter.hpp"
 #include "StelTextureMgr.hpp"
+#include "StelUtils.hpp"
 
 #include <QSettings>
 
+namespace
+{
+	//! Random colors of a sporadic meteor
+	const QList<MeteorPool::ColorPair>& getRandColor()
+	{
+		static const QList<MeteorPool::ColorPair> white = QList<MeteorPool::ColorPair>()
+				<< MeteorPool::ColorPair("white", 100);
+		static const QList<MeteorPool::ColorPair> whiteOrange = QList<MeteorPool::ColorPair>()
+				<< MeteorPool::ColorPair("white", 80) << MeteorPool::ColorPair("orangeYellow", 20);
+		static const QList<MeteorPool::ColorPair> whiteViolet = QList<MeteorPool::ColorPair>()
+				<< MeteorPool::ColorPair("white", 80) << MeteorPool::ColorPair("violet", 20);
+		static const QList<MeteorPool::ColorPair> multi = QList<MeteorPool::ColorPair>()
+				<< MeteorPool::ColorPair("white", 70) << MeteorPool::ColorPair("orangeYellow", 10)
+				<< MeteorPool::ColorPair("yellow", 10) << MeteorPool::ColorPair("blueGreen", 10);
+
+		float prob = (float) qrand() / (float) RAND_MAX;
+		if (prob > 0.9f)
+			return multi;
+		else if (prob > 0.85f)
+			return whiteViolet;
+		else if (prob > 0.80f)
+			return whiteOrange;
+		return white;
+	}
+}
+
 SporadicMeteorMgr::SporadicMeteorMgr(int zhr, int maxv)
 	: m_zhr(zhr)
 	, m_maxVelocity(maxv)
@@ -40,16 +67,13 @@ SporadicMeteorMgr::SporadicMeteorMgr(int zhr, int maxv)
 
 SporadicMeteorMgr::~SporadicMeteorMgr()
 {
-	qDeleteAll(activeMeteors);
-	activeMeteors.clear();
-	m_bolideTexture.clear();
 }
 
 void SporadicMeteorMgr::init()
 {
-	m_bolideTexture = StelApp::getInstance().getTextureManager().createTextureThread(
+	m_meteors.setBolideTexture(StelApp::getInstance().getTextureManager().createTextureThread(
 				StelFileMgr::getInstallationDir() + "/textures/cometComa.png",
-				StelTexture::StelTextureParams(true, GL_LINEAR, GL_CLAMP_TO_EDGE));
+				StelTexture::StelTextureParams(true, GL_LINEAR, GL_CLAMP_TO_EDGE)));
 
 	QSettings* conf = StelApp::getInstance().getSettings();
 	setZHR(conf->value("astro/meteor_zhr", 10).toInt());
@@ -72,19 +96,11 @@ void SporadicMeteorMgr::update(double deltaTime)
 		return;
 	}
 
-	// step through and update all active meteors
-	foreach (SporadicMeteor* m, activeMeteors)
-	{
-		if (!m->update(deltaTime))
-		{
-			//important to delete when no longer active
-			delete m;
-			activeMeteors.removeOne(m);
-		}
-	}
-
 	StelCore* core = StelApp::getInstance().getCore();
 
+	// update all active meteors, dead ones free their slot in the pool
+	m_meteors.update(core, deltaTime);
+
 	// going forward/backward OR current ZHR is zero ?
 	// don't create new meteors
 	if(!core->getRealTimeSpeed() || m_zhr < 1)
@@ -105,15 +121,17 @@ void SporadicMeteorMgr::update(double deltaTime)
 		float prob = (float) qrand() / (float) RAND_MAX;
 		if (prob < rate)
 		{
-			SporadicMeteor* m = new SporadicMeteor(core, m_maxVelocity, m_bolideTexture);
-			if (m->isAlive())
-			{
-				activeMeteors.append(m);
-			}
-			else
-			{
-				delete m;
-			}
+			// meteor velocity
+			// (see line 460 in StelApp.cpp)
+			float speed = 11 + (m_maxVelocity - 11) * ((float) qrand() / ((float) RAND_MAX + 1)); // [11, maxVel]
+
+			// select a random radiant in a visible area
+			float rAlt = M_PI_2 * ((float) qrand() / ((double) RAND_MAX + 1));  // [0, pi/2]
+			float rAz = 2 * M_PI * ((float) qrand() / ((float) RAND_MAX + 1));  // [0, 2pi]
+			Vec3d radiant;
+			StelUtils::spheToRect(rAz, rAlt, radiant);
+
+			m_meteors.spawnAltAz(core, radiant, speed, getRandColor());
 		}
 	}
 }
@@ -131,12 +149,9 @@ void SporadicMeteorMgr::draw(StelCore* core)
 		return;
 	}
 
-	// step through and draw all active meteors
+	// draw all active meteors at once
 	StelPainter sPainter(core->getProjection(StelCore::FrameAltAz));
-	foreach (SporadicMeteor* m, activeMeteors)
-	{
-		m->draw(core, sPainter);
-	}
+	m_meteors.draw(core, sPainter);
 }
 
 void SporadicMeteorMgr::setZHR(int zhr)
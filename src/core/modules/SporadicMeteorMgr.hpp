@@ -20,7 +20,7 @@
 #ifndef _SPORADICMETEORMGR_HPP_
 #define _SPORADICMETEORMGR_HPP_
 
-#include "SporadicMeteor.hpp"
+#include "MeteorGroup.hpp"
 #include "StelModule.hpp"
 
 //! @class SporadicMeteorMgr
@@ -69,8 +69,7 @@ signals:
 	void zhrChanged(int);
 
 private:
-	QList<SporadicMeteor*> activeMeteors;
-	StelTextureSP m_bolideTexture;
+	MeteorGroup m_meteors;
 	int m_zhr;
 	int m_maxVelocity;
 	bool m_flagShow;
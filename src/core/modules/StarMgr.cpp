@@ -41,6 +41,7 @@
 #include "StelIniParser.hpp"
 #include "StelPainter.hpp"
 #include "StelJsonParser.hpp"
+#include "StelProfiler.hpp"
 #include "ZoneArray.hpp"
 #include "StelSkyDrawer.hpp"
 #include "RefractionExtinction.hpp"
@@ -139,6 +140,7 @@ StarMgr::StarMgr(void)
 	: flagStarName(false)
 	, labelsAmount(0.)
 	, gravityLabel(false)
+	, maxResidentZoneBytes(0)
 	, hipIndex(new HipIndexStruct[NR_OF_HIP+1])
 {
 	setObjectName("StarMgr");
@@ -423,6 +425,10 @@ void StarMgr::init()
 		}
 	}
 
+	// The deep catalogues are paged: their zones are read when they are first drawn, and at most
+	// this amount of memory is used for each of them.
+	if (conf->value("stars/flag_paged_catalogs", true).toBool())
+		maxResidentZoneBytes = qMax(1, conf->value("stars/max_resident_zones_mb", 64).toInt()) * Q_INT64_C(1024*1024);
 	loadData(starSettings);
 
 	populateStarsDesignations();
@@ -544,7 +550,7 @@ bool StarMgr::checkAndLoadCatalog(const QVariantMap& catDesc)
 		}
 	}
 
-	ZoneArray* z = ZoneArray::create(catalogFilePath, true);
+	ZoneArray* z = ZoneArray::create(catalogFilePath, true, maxResidentZoneBytes);
 	if (z)
 	{
 		if (z->level<gridLevels.size())
@@ -1109,7 +1115,7 @@ void StarMgr::draw(StelCore* core)
 	int maxSearchLevel = getMaxSearchLevel();
 	QVector<SphericalCap> viewportCaps = prj->getViewportConvexPolygon()->getBoundingSphericalCaps();
 	viewportCaps.append(core->getVisibleSkyArea());
-	const GeodesicSearchResult* geodesic_search_result = core->getGeodesicGrid(maxSearchLevel)->search(viewportCaps,maxSearchLevel);
+	GeodesicSearchResultP geodesic_search_result = core->getGeodesicGrid(maxSearchLevel)->search(viewportCaps,maxSearchLevel);
 
 	// Set temporary static variable for optimization
 	const float names_brightness = labelsFader.getInterstate() * starsFader.getInterstate();
@@ -1123,8 +1129,10 @@ void StarMgr::draw(StelCore* core)
 	RCMag rcmag_table[RCMAG_TABLE_SIZE];
 	
 	// Draw all the stars of all the selected zones
-	foreach(const ZoneArray* z, gridLevels)
+	StelProfiler::Scope zonesScope("StarMgr: zones", StelProfiler::Draw);
+	foreach(ZoneArray* z, gridLevels)
 	{
+		z->beginFrame();
 		int limitMagIndex=RCMAG_TABLE_SIZE;
 		const float mag_min = 0.001f*z->mag_min;
 		const float k = (0.001f*z->mag_range)/z->mag_steps; // MagStepIncrement
@@ -1228,7 +1236,7 @@ QList<StelObjectP > StarMgr::searchAround(const Vec3d& vv, double limFov, const
 	e3 *= f;
 	// Search the triangles
 	SphericalConvexPolygon c(e3, e2, e2, e0);
-	const GeodesicSearchResult* geodesic_search_result = core->getGeodesicGrid(lastMaxSearchLevel)->search(c.getBoundingSphericalCaps(),lastMaxSearchLevel);
+	GeodesicSearchResultP geodesic_search_result = core->getGeodesicGrid(lastMaxSearchLevel)->search(c.getBoundingSphericalCaps(),lastMaxSearchLevel);
 
 	// Iterate over the stars inside the triangles
 	f = cos(limFov * M_PI/180.);
@@ -416,6 +416,9 @@ private:
 
 	int maxGeodesicGridLevel;
 	int lastMaxSearchLevel;
+
+	//! Maximal size of the loaded zones of each paged catalog in bytes, 0 to load the catalogs completely
+	qint64 maxResidentZoneBytes;
 	
 	// A ZoneArray per grid level
 	QVector<ZoneArray*> gridLevels;
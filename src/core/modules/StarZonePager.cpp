@@ -0,0 +1,184 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "StarZonePager.hpp"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+
+qint64 StarZonePager::totalResidentBytes = 0;
+
+static unsigned int bswap32(unsigned int val)
+{
+	return (((val) & 0xff000000) >> 24) | (((val) & 0x00ff0000) >>  8) |
+	       (((val) & 0x0000ff00) <<  8) | (((val) & 0x000000ff) << 24);
+}
+
+StarZonePager::StarZonePager(QFile* file, int nrOfZones, int recordSize, bool byteSwap, qint64 maxResidentBytes)
+	: file(file)
+	, recordSize(recordSize)
+	, maxResidentBytes(maxResidentBytes)
+	, valid(false)
+	, nrOfRecords(0)
+	, lruHead(-1)
+	, lruTail(-1)
+	, frame(0)
+	, residentZones(0)
+	, residentBytes(0)
+	, loadCount(0)
+	, evictionCount(0)
+{
+	Q_ASSERT(file);
+	Q_ASSERT(recordSize>0);
+	if (nrOfZones<=0)
+		return;
+
+	zoneSizes.resize(nrOfZones);
+	const qint64 tableSize = sizeof(unsigned int)*nrOfZones;
+	if (file->read(reinterpret_cast<char*>(zoneSizes.data()), tableSize) != tableSize)
+	{
+		qWarning() << "StarZonePager: error reading the zone table of" << QDir::toNativeSeparators(file->fileName());
+		zoneSizes.clear();
+		return;
+	}
+
+	zoneOffsets.resize(nrOfZones);
+	qint64 offset = file->pos();
+	for (int z=0; z<nrOfZones; ++z)
+	{
+		if (byteSwap)
+			zoneSizes[z] = bswap32(zoneSizes[z]);
+		zoneOffsets[z] = offset;
+		offset += static_cast<qint64>(zoneSizes[z])*recordSize;
+		nrOfRecords += zoneSizes[z];
+	}
+	if (offset > file->size())
+	{
+		qWarning() << "StarZonePager: catalog" << QDir::toNativeSeparators(file->fileName()) << "is truncated";
+		zoneSizes.clear();
+		zoneOffsets.clear();
+		nrOfRecords = 0;
+		return;
+	}
+
+	zoneData.fill(Q_NULLPTR, nrOfZones);
+	zoneFrame.fill(0, nrOfZones);
+	lruPrev.fill(-1, nrOfZones);
+	lruNext.fill(-1, nrOfZones);
+	valid = true;
+}
+
+StarZonePager::~StarZonePager()
+{
+	clear();
+}
+
+const char* StarZonePager::getZone(int zone)
+{
+	Q_ASSERT(zone>=0 && zone<zoneSizes.size());
+	if (zoneSizes.at(zone)==0)
+		return Q_NULLPTR;
+
+	zoneFrame[zone] = frame;
+	char* data = zoneData.at(zone);
+	if (data)
+	{
+		touch(zone);
+		return data;
+	}
+
+	const qint64 size = static_cast<qint64>(zoneSizes.at(zone))*recordSize;
+	data = new char[size];
+	if (!file->seek(zoneOffsets.at(zone)) || file->read(data, size)!=size)
+	{
+		qWarning() << "StarZonePager: error reading zone" << zone << "of" << QDir::toNativeSeparators(file->fileName()) << file->errorString();
+		delete[] data;
+		return Q_NULLPTR;
+	}
+	zoneData[zone] = data;
+	++residentZones;
+	residentBytes += size;
+	totalResidentBytes += size;
+	++loadCount;
+	touch(zone);
+	trim();
+	return data;
+}
+
+void StarZonePager::clear()
+{
+	while (lruTail>=0)
+		unload(lruTail);
+}
+
+void StarZonePager::setMaxResidentBytes(qint64 bytes)
+{
+	maxResidentBytes = bytes;
+	trim();
+}
+
+void StarZonePager::touch(int zone)
+{
+	if (lruHead==zone)
+		return;
+	unlink(zone);
+	lruPrev[zone] = -1;
+	lruNext[zone] = lruHead;
+	if (lruHead>=0)
+		lruPrev[lruHead] = zone;
+	lruHead = zone;
+	if (lruTail<0)
+		lruTail = zone;
+}
+
+void StarZonePager::unlink(int zone)
+{
+	const int prev = lruPrev.at(zone);
+	const int next = lruNext.at(zone);
+	if (prev>=0)
+		lruNext[prev] = next;
+	else if (lruHead==zone)
+		lruHead = next;
+	if (next>=0)
+		lruPrev[next] = prev;
+	else if (lruTail==zone)
+		lruTail = prev;
+	lruPrev[zone] = -1;
+	lruNext[zone] = -1;
+}
+
+void StarZonePager::unload(int zone)
+{
+	unlink(zone);
+	const qint64 size = static_cast<qint64>(zoneSizes.at(zone))*recordSize;
+	delete[] zoneData.at(zone);
+	zoneData[zone] = Q_NULLPTR;
+	--residentZones;
+	residentBytes -= size;
+	totalResidentBytes -= size;
+	++evictionCount;
+}
+
+void StarZonePager::trim()
+{
+	// Zones used in the current frame are at the head of the list, so stop at the first one.
+	while (residentBytes>maxResidentBytes && lruTail>=0 && zoneFrame.at(lruTail)!=frame)
+		unload(lruTail);
+}
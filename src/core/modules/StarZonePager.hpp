@@ -0,0 +1,127 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#ifndef _STARZONEPAGER_HPP_
+#define _STARZONEPAGER_HPP_
+
+#include <QVector>
+
+class QFile;
+
+//! @class StarZonePager
+//! Loads the zones of a star catalog file on demand.
+//! The catalog starts with a table of the number of stars in each zone, followed by the star records
+//! of all zones in zone order. The pager reads the table once and turns it into a table of file offsets,
+//! so a zone can be read with a single seek when it is first needed.
+//!
+//! Loaded zones are kept in least-recently-used order. When the loaded records take more than
+//! the maximal resident size, the zones which were used least recently are unloaded again, except those
+//! used since the last call to beginFrame(): the zones needed to draw one frame always stay loaded.
+//!
+//! The pager does not interpret the records, and must only be used from the main thread.
+class StarZonePager
+{
+public:
+	//! Read the zone size table at the current position of the file.
+	//! @param file the open catalog file. It must stay open as long as the pager exists.
+	//! @param nrOfZones number of zones of the catalog
+	//! @param recordSize size of a star record in bytes
+	//! @param byteSwap whether the zone sizes are stored with the other endianness
+	//! @param maxResidentBytes the maximal size of the loaded star records
+	StarZonePager(QFile* file, int nrOfZones, int recordSize, bool byteSwap, qint64 maxResidentBytes);
+	~StarZonePager();
+
+	//! Whether the zone size table could be read.
+	bool isValid() const { return valid; }
+
+	int getNrOfZones() const { return zoneSizes.size(); }
+	//! Number of stars in a zone.
+	unsigned int getZoneSize(int zone) const { return zoneSizes.at(zone); }
+	//! Total number of stars in the catalog.
+	quint64 getNrOfRecords() const { return nrOfRecords; }
+
+	//! Get the star records of a zone, reading them from the file if the zone is not loaded.
+	//! The pointer stays valid until another zone is loaded after the next call to beginFrame().
+	//! @return the records, or Q_NULLPTR if the zone is empty or could not be read.
+	const char* getZone(int zone);
+	//! Whether the records of a zone are in memory.
+	bool isZoneResident(int zone) const { return zoneData.at(zone) != Q_NULLPTR; }
+
+	//! Start a new frame. Zones used before may be unloaded from now on.
+	void beginFrame() { ++frame; }
+
+	//! Unload all zones.
+	void clear();
+
+	//! Set the maximal size of the loaded records, and unload zones if necessary.
+	void setMaxResidentBytes(qint64 bytes);
+	qint64 getMaxResidentBytes() const { return maxResidentBytes; }
+
+	//! Number of zones in memory.
+	int getResidentZones() const { return residentZones; }
+	//! Size of the records in memory, in bytes.
+	qint64 getResidentBytes() const { return residentBytes; }
+	//! Number of zones read from the file since the pager was created.
+	quint64 getLoadCount() const { return loadCount; }
+	//! Number of zones unloaded since the pager was created.
+	quint64 getEvictionCount() const { return evictionCount; }
+
+	//! Size of the records in memory over all pagers, in bytes.
+	static qint64 getTotalResidentBytes() { return totalResidentBytes; }
+
+private:
+	Q_DISABLE_COPY(StarZonePager)
+
+	//! Move a zone to the head of the LRU list
+	void touch(int zone);
+	void unlink(int zone);
+	void unload(int zone);
+	//! Unload the least recently used zones until the records fit into maxResidentBytes
+	void trim();
+
+	QFile* file;
+	const int recordSize;
+	qint64 maxResidentBytes;
+	bool valid;
+
+	QVector<unsigned int> zoneSizes;
+	//! File offsets of the first record of each zone
+	QVector<qint64> zoneOffsets;
+	quint64 nrOfRecords;
+
+	//! Records of the loaded zones, Q_NULLPTR for the others
+	QVector<char*> zoneData;
+	//! Frame in which each zone was last used
+	QVector<quint64> zoneFrame;
+	//! Doubly linked LRU list of the loaded zones, from the most to the least recently used, -1 terminated
+	QVector<int> lruPrev;
+	QVector<int> lruNext;
+	int lruHead;
+	int lruTail;
+
+	quint64 frame;
+	int residentZones;
+	qint64 residentBytes;
+	quint64 loadCount;
+	quint64 evictionCount;
+
+	static qint64 totalResidentBytes;
+};
+
+#endif // _STARZONEPAGER_HPP_
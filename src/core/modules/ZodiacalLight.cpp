@@ -244,8 +244,7 @@ void ZodiacalLight::draw(StelCore* core)
 			Vec3d vertAltAz=core->equinoxEquToAltAz(eqPos, StelCore::RefractionOn);
 			Q_ASSERT(fabs(vertAltAz.lengthSquared()-1.0) < 0.001f);
 
-			float oneMag=0.0f;
-			extinction.forward(vertAltAz, &oneMag);
+			const float oneMag=extinction.getMagnitudeShiftFast(vertAltAz[2]);
 			float extinctionFactor=std::pow(0.4f , oneMag)/bortle; // drop of one magnitude: factor 2.5 or 40%, and further reduced by light pollution
 			Vec3f thisColor=Vec3f(c[0]*extinctionFactor, c[1]*extinctionFactor, c[2]*extinctionFactor);
 			vertexArray->colors.append(thisColor);
@@ -90,7 +90,7 @@ static inline int ReadInt(QFile& file, unsigned int &x)
 #endif
 #endif
 
-ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
+ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap, qint64 maxResidentBytes)
 {
 	QString dbStr; // for debugging output.
 	QFile* file = new QFile(catalogFilePath);
@@ -201,7 +201,7 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 #ifndef _MSC_BUILD
 				Q_ASSERT(sizeof(Star2) == 10);
 #endif
-				rval = new SpecialZoneArray<Star2>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps);
+				rval = new SpecialZoneArray<Star2>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps, maxResidentBytes);
 				if (rval == Q_NULLPTR)
 				{
 					dbStr += "error - no memory ";
@@ -222,7 +222,7 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 #ifndef _MSC_BUILD
 				Q_ASSERT(sizeof(Star3) == 6);
 #endif
-				rval = new SpecialZoneArray<Star3>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps);
+				rval = new SpecialZoneArray<Star3>(file, byte_swap, use_mmap, level, mag_min, mag_range, mag_steps, maxResidentBytes);
 				if (rval == Q_NULLPTR)
 				{
 					dbStr += "error - no memory ";
@@ -236,6 +236,8 @@ ZoneArray* ZoneArray::create(const QString& catalogFilePath, bool use_mmap)
 	if (rval && rval->isInitialized())
 	{
 		dbStr += QString("%1").arg(rval->getNrOfStars());
+		if (rval->isPaged())
+			dbStr += " (paged)";
 		qDebug() << dbStr;
 	}
 	else
@@ -255,7 +257,7 @@ ZoneArray::ZoneArray(const QString& fname, QFile* file, int level, int mag_min,
 			 int mag_range, int mag_steps)
 			: fname(fname), level(level), mag_min(mag_min),
 			  mag_range(mag_range), mag_steps(mag_steps),
-			  star_position_scale(0.0), nr_of_stars(0), zones(Q_NULLPTR), file(file)
+			  star_position_scale(0.0), nr_of_stars(0), zones(Q_NULLPTR), file(file), pager(Q_NULLPTR)
 {
 	nr_of_zones = StelGeodesicGrid::nrOfZones(level);	
 }
@@ -317,11 +319,36 @@ void SpecialZoneArray<Star>::scaleAxis()
 
 template<class Star>
 SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mmap,
-					 int level, int mag_min, int mag_range, int mag_steps)
+					 int level, int mag_min, int mag_range, int mag_steps,
+					 qint64 maxResidentBytes)
 		: ZoneArray(file->fileName(), file, level, mag_min, mag_range, mag_steps),
 		  stars(0), mmap_start(0)
 {
-	if (nr_of_zones > 0)
+	if (nr_of_zones > 0 && maxResidentBytes > 0)
+	{
+		// Only read the zone table now. The file stays open, and the pager reads the stars of a zone
+		// when it is drawn or searched for the first time.
+		zones = new SpecialZoneData<Star>[nr_of_zones];
+		pager = new StarZonePager(file, nr_of_zones, sizeof(Star), byte_swap, maxResidentBytes);
+		if (!pager->isValid() || pager->getNrOfRecords()==0)
+		{
+			delete pager;
+			pager = Q_NULLPTR;
+			delete[] getZones();
+			zones = Q_NULLPTR;
+			nr_of_zones = 0;
+		}
+		else
+		{
+			nr_of_stars = pager->getNrOfRecords();
+			for (unsigned int z=0;z<nr_of_zones;z++)
+			{
+				getZones()[z].size = pager->getZoneSize(z);
+				getZones()[z].stars = Q_NULLPTR;
+			}
+		}
+	}
+	else if (nr_of_zones > 0)
 	{
 		zones = new SpecialZoneData<Star>[nr_of_zones];
 		if (zones == Q_NULLPTR)
@@ -436,6 +463,12 @@ SpecialZoneArray<Star>::SpecialZoneArray(QFile* file, bool byte_swap,bool use_mm
 template<class Star>
 SpecialZoneArray<Star>::~SpecialZoneArray(void)
 {
+	if (pager)
+	{
+		delete pager;
+		pager = Q_NULLPTR;
+		delete file;
+	}
 	if (stars)
 	{
 		if (mmap_start != Q_NULLPTR)
@@ -458,6 +491,14 @@ SpecialZoneArray<Star>::~SpecialZoneArray(void)
 	nr_of_stars = 0;
 }
 
+template<class Star>
+qint64 SpecialZoneArray<Star>::getResidentBytes() const
+{
+	if (pager)
+		return pager->getResidentBytes();
+	return stars ? static_cast<qint64>(sizeof(Star))*nr_of_stars : 0;
+}
+
 template<class Star>
 void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsideViewport, const RCMag* rcmag_table,
 				  int limitMagIndex, StelCore* core, int maxMagStarName, float names_brightness,
@@ -486,8 +527,37 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
     
 	// Go through all stars, which are sorted by magnitude (bright stars first)
 	const SpecialZoneData<Star>* zoneToDraw = getZones() + index;
-	const Star* lastStar = zoneToDraw->getStars() + zoneToDraw->size;
-	for (const Star* s=zoneToDraw->getStars();s<lastStar;++s)
+	const Star* firstStar = getZoneStars(index);
+	if (firstStar == Q_NULLPTR)
+		return;
+
+	// If the whole zone is above the horizon and spans an altitude range over which extinction changes by less
+	// than one magnitude step, the extinction of the zone center is applied to all its stars.
+	bool withZoneExtinction=false;
+	int zoneExtMagShift=0;
+	float zoneTwinkleFactor=1.0f;
+	if (withExtinction)
+	{
+		Vec3f centerAltAz(zoneToDraw->center);
+		core->j2000ToAltAzInPlaceNoRefraction(&centerAltAz);
+		// The zone corners lie within star_position_scale*Star::MaxPosVal along each axis (see initTriangle()).
+		const float zoneRadius=std::atan(star_position_scale*Star::MaxPosVal*static_cast<float>(M_SQRT2));
+		const float centerAlt=std::asin(qBound(-1.f, centerAltAz[2], 1.f));
+		if (centerAlt-zoneRadius>0.f)
+		{
+			const float lowShift=extinction.getMagnitudeShiftFast(std::sin(centerAlt-zoneRadius));
+			const float highShift=extinction.getMagnitudeShiftFast(std::sin(qMin(static_cast<float>(M_PI_2), centerAlt+zoneRadius)));
+			if (lowShift-highShift<k)
+			{
+				withZoneExtinction=true;
+				zoneExtMagShift=(int)(extinction.getMagnitudeShiftFast(centerAltAz[2])/k);
+				zoneTwinkleFactor=qMin(1.0f, 1.0f-0.9f*centerAltAz[2]);
+			}
+		}
+	}
+
+	const Star* lastStar = firstStar + zoneToDraw->size;
+	for (const Star* s=firstStar;s<lastStar;++s)
 	{
 		// Artifical cutoff per magnitude
 		if (s->getMag() > cutoffMagStep)
@@ -521,13 +591,21 @@ void SpecialZoneArray<Star>::draw(StelPainter* sPainter, int index, bool isInsid
 
 		int extinctedMagIndex = s->getMag();
 		float twinkleFactor=1.0f; // allow height-dependent twinkle.
-		if (withExtinction)
+		if (withZoneExtinction)
+		{
+			extinctedMagIndex = s->getMag() + zoneExtMagShift;
+			if (extinctedMagIndex >= cutoffMagStep || extinctedMagIndex<0)
+				continue;
+			tmpRcmag = &rcmag_table[extinctedMagIndex];
+			twinkleFactor=zoneTwinkleFactor;
+		}
+		else if (withExtinction)
 		{
 			Vec3f altAz(vf);
 			altAz.normalize();
 			core->j2000ToAltAzInPlaceNoRefraction(&altAz);
 			float extMagShift=0.0f;
-			extinction.forward(altAz, &extMagShift);
+			extinction.forwardFast(altAz, &extMagShift);
 			extinctedMagIndex = s->getMag() + (int)(extMagShift/k);
 			if (extinctedMagIndex >= cutoffMagStep || extinctedMagIndex<0) // i.e., if extincted it is dimmer than cutoff or extinctedMagIndex is negative (missing star catalog), so remove
 				continue;
@@ -552,9 +630,13 @@ void SpecialZoneArray<Star>::searchAround(const StelCore* core, int index, const
 	static const double d2000 = 2451545.0;
 	const double movementFactor = (M_PI/180.)*(0.0001/3600.) * ((core->getJDE()-d2000)/365.25)/ star_position_scale;
 	const SpecialZoneData<Star> *const z = getZones()+index;
+	// Paged out zones are read synchronously here
+	const Star* firstStar = getZoneStars(index);
+	if (firstStar == Q_NULLPTR)
+		return;
 	Vec3f tmp;
 	Vec3f vf(v[0], v[1], v[2]);
-	for (const Star* s=z->getStars();s<z->getStars()+z->size;++s)
+	for (const Star* s=firstStar;s<firstStar+z->size;++s)
 	{
 		s->getJ2000Pos(z,movementFactor, tmp);
 		tmp.normalize();
@@ -29,6 +29,7 @@
 #include "StelCore.hpp"
 #include "StelSkyDrawer.hpp"
 #include "StarMgr.hpp"
+#include "StarZonePager.hpp"
 
 #include <QString>
 #include <QFile>
@@ -81,8 +82,11 @@ public:
 	//! loading.
 	//! @param extended_file_name path of the star catalog to load from
 	//! @param use_mmap whether or not to mmap the star catalog
+	//! @param maxResidentBytes if positive, the zones of catalogs of faint stars (Star2, Star3) are
+	//! only read when they are used, and at most this many bytes of them are kept in memory.
+	//! The Hipparcos catalog is always loaded completely.
 	//! @return an instance of SpecialZoneArray or HipZoneArray
-	static ZoneArray *create(const QString &extended_file_name, bool use_mmap);
+	static ZoneArray *create(const QString &extended_file_name, bool use_mmap, qint64 maxResidentBytes=0);
 	virtual ~ZoneArray()
 	{
 		nr_of_zones = 0;
@@ -91,6 +95,15 @@ public:
 	//! Get the total number of stars in this catalog.
 	unsigned int getNrOfStars() const { return nr_of_stars; }
 
+	//! Whether the zones are loaded on demand.
+	bool isPaged() const { return pager!=Q_NULLPTR; }
+
+	//! Get the size of the star records in memory, in bytes. For a mapped catalog, this is the mapped size.
+	virtual qint64 getResidentBytes() const = 0;
+
+	//! Start drawing a new frame. For a paged catalog, the zones used in previous frames may be unloaded from now on.
+	void beginFrame() { if (pager) pager->beginFrame(); }
+
 	//! Dummy method that does nothing. See subclass implementation.
 	virtual void updateHipIndex(HipIndexStruct hipIndex[]) const {Q_UNUSED(hipIndex);}
 
@@ -141,6 +154,8 @@ protected:
 	unsigned int nr_of_stars;
 	ZoneData *zones;
 	QFile* file;
+	//! Loads the zones on demand, or Q_NULLPTR if the whole catalog is in memory.
+	StarZonePager* pager;
 };
 
 //! @class SpecialZoneArray
@@ -160,9 +175,12 @@ public:
 	//! @param mag_min lower bound of magnitudes
 	//! @param mag_range range of magnitudes
 	//! @param mag_steps number of steps used to describe values in range
+	//! @param maxResidentBytes if positive, load the zones on demand and keep at most this many bytes of them in memory
 	SpecialZoneArray(QFile* file,bool byte_swap,bool use_mmap,int level,int mag_min,
-			 int mag_range,int mag_steps);
+			 int mag_range,int mag_steps,qint64 maxResidentBytes=0);
 	~SpecialZoneArray(void);
+
+	virtual qint64 getResidentBytes() const;
 protected:
 	//! Get an array of all SpecialZoneData objects in this catalog.
 	SpecialZoneData<Star> *getZones(void) const
@@ -170,6 +188,15 @@ protected:
 		return static_cast<SpecialZoneData<Star>*>(zones);
 	}
 
+	//! Get the stars of a zone, reading them from the catalog file first if the zone is paged out.
+	//! @return the stars, or Q_NULLPTR if the zone is empty or could not be read
+	const Star* getZoneStars(int index) const
+	{
+		if (pager)
+			return reinterpret_cast<const Star*>(pager->getZone(index));
+		return getZones()[index].getStars();
+	}
+
 	//! Draw stars and their names onto the viewport.
 	//! @param sPainter the painter to use 
 	//! @param index zone index to draw
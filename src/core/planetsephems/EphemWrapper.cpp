@@ -31,6 +31,8 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 #include "de430.hpp"
 #include "pluto.h"
 
+#include <QMutex>
+
 #define EPHEM_MERCURY_ID  0
 #define EPHEM_VENUS_ID    1
 #define EPHEM_EMB_ID    2
@@ -58,6 +60,10 @@ Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
 **            7 = uranus 
 **/
 
+// The planetary theories keep their last results in static variables and must not run in parallel.
+// Positions are computed by the main thread, but also by background tasks of plugins.
+static QMutex ephemMutex;
+
 void EphemWrapper::init_de430(const char* filepath)
 {
 	InitDE430(filepath);
@@ -97,6 +103,7 @@ bool use_de431(const double jd)
 // planet_id is ONLY one of the #defined values 0..8 above.
 void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_id)
 {
+	QMutexLocker locker(&ephemMutex);
 	bool deOk=false;
 	if(!std::isfinite(jd))
 	{
@@ -122,6 +129,7 @@ void get_planet_helio_coordsv(const double jd, double xyz[3], const int planet_i
 // For ephemerides like DE4xx, JDE0 is irrelevant.
 void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], int planet_id)
 {
+	QMutexLocker locker(&ephemMutex);
 	bool deOk=false;
 	if(!(std::isfinite(jd) && std::isfinite(jd0)))
 	{
@@ -151,6 +159,7 @@ void get_planet_helio_osculating_coordsv(double jd0, double jd, double xyz[3], i
 void get_pluto_helio_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	bool deOk=false;
 	if(!std::isfinite(jd))
 	{
@@ -194,6 +203,7 @@ void get_venus_helio_coordsv(double jd,double xyz[3], void* unused)
 void get_earth_helio_coordsv(const double jd,double xyz[3], void* unused) 
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	bool deOk=false;
 	if(!std::isfinite(jd))
 	{
@@ -303,6 +313,7 @@ void get_neptune_helio_osculating_coords(double jd0,double jd,double xyz[3])
 void get_lunar_parent_coordsv(double jde,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	bool deOk=false;
 	if(use_de430(jde))
 		deOk=GetDe430Coor(jde, EPHEM_JPL_MOON_ID, xyz, EPHEM_JPL_EARTH_ID);
@@ -315,114 +326,133 @@ void get_lunar_parent_coordsv(double jde,double xyz[3], void* unused)
 void get_phobos_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetMarsSatCoor(jd,MARS_SAT_PHOBOS,xyz);
 }
 
 void get_deimos_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetMarsSatCoor(jd,MARS_SAT_DEIMOS,xyz);
 }
 
 void get_io_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetL1Coor(jd,L1_IO,xyz);
 }
 
 void get_europa_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetL1Coor(jd,L1_EUROPA,xyz);
 }
 
 void get_ganymede_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetL1Coor(jd,L1_GANYMEDE,xyz);
 }
 
 void get_callisto_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetL1Coor(jd,L1_CALLISTO,xyz);
 }
 
 void get_mimas_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetTass17Coor(jd,TASS17_MIMAS,xyz);
 }
 
 void get_enceladus_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetTass17Coor(jd,TASS17_ENCELADUS,xyz);
 }
 
 void get_tethys_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetTass17Coor(jd,TASS17_TETHYS,xyz);
 }
 
 void get_dione_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetTass17Coor(jd,TASS17_DIONE,xyz);
 }
 
 void get_rhea_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetTass17Coor(jd,TASS17_RHEA,xyz);
 }
 
 void get_titan_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetTass17Coor(jd,TASS17_TITAN,xyz);
 }
 
 void get_hyperion_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetTass17Coor(jd,TASS17_HYPERION,xyz);
 }
 
 void get_iapetus_parent_coordsv(double jd,double xyz[3], void* unused)
 { 
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetTass17Coor(jd,TASS17_IAPETUS,xyz);
 }
 
 void get_miranda_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetGust86Coor(jd,GUST86_MIRANDA,xyz);
 }
 
 void get_ariel_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetGust86Coor(jd,GUST86_ARIEL,xyz);
 }
 
 void get_umbriel_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetGust86Coor(jd,GUST86_UMBRIEL,xyz);
 }
 
 void get_titania_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetGust86Coor(jd,GUST86_TITANIA,xyz);
 }
 
 void get_oberon_parent_coordsv(double jd,double xyz[3], void* unused)
 {
 	Q_UNUSED(unused);
+	QMutexLocker locker(&ephemMutex);
 	GetGust86Coor(jd,GUST86_OBERON,xyz);
 }
 
@@ -25,12 +25,16 @@
 #include "StelUtils.hpp"
 #include "StelTranslator.hpp"
 #include "StelLocaleMgr.hpp"
+#include "StelObserver.hpp"
+#include "StelSkyDrawer.hpp"
+#include "StelSkyCultureMgr.hpp"
 #include "StelFileMgr.hpp"
 
 #include "SolarSystem.hpp"
 #include "Planet.hpp"
 #include "NebulaMgr.hpp"
 #include "Nebula.hpp"
+#include "LandscapeMgr.hpp"
 
 #ifdef USE_STATIC_PLUGIN_SATELLITES
 #include "../plugins/Satellites/src/Satellites.hpp"
@@ -237,6 +241,10 @@ void AstroCalcDialog::createDialogContent()
 	connect(ui->saveObjectsButton, SIGNAL(clicked()), this, SLOT(saveWutObjects()));
 	connect(dsoMgr, SIGNAL(catalogFiltersChanged(Nebula::CatalogGroup)), this, SLOT(calculateWutObjects()));
 	connect(dsoMgr, SIGNAL(typeFiltersChanged(Nebula::TypeGroup)), this, SLOT(calculateWutObjects()));
+	// The size limits are not part of the key of the WUT cache, drop it before recomputing
+	connect(dsoMgr, SIGNAL(flagSizeLimitsUsageChanged(bool)), this, SLOT(clearWutCache()));
+	connect(dsoMgr, SIGNAL(minSizeLimitChanged(double)), this, SLOT(clearWutCache()));
+	connect(dsoMgr, SIGNAL(maxSizeLimitChanged(double)), this, SLOT(clearWutCache()));
 	connect(dsoMgr, SIGNAL(flagSizeLimitsUsageChanged(bool)), this, SLOT(calculateWutObjects()));
 	connect(dsoMgr, SIGNAL(minSizeLimitChanged(double)), this, SLOT(calculateWutObjects()));
 	connect(dsoMgr, SIGNAL(maxSizeLimitChanged(double)), this, SLOT(calculateWutObjects()));
@@ -3050,10 +3058,16 @@ void AstroCalcDialog::updateSolarSystemData()
 		populateCelestialBodyList();
 		populateGroupCelestialBodyList();
 		currentCelestialPositions();
+		wutCache.clear();
 		calculateWutObjects();
 	}
 }
 
+void AstroCalcDialog::clearWutCache()
+{
+	wutCache.clear();
+}
+
 void AstroCalcDialog::populateTimeIntervalsList()
 {
 	Q_ASSERT(ui->wutComboBox);
@@ -3141,409 +3155,256 @@ void AstroCalcDialog::calculateWutObjects()
 		QString categoryName = ui->wutCategoryListWidget->currentItem()->text();
 		int categoryId = wutCategories.value(categoryName);
 
-		wutObjects.clear();
-
-		QList<PlanetP> allObjects = solarSystem->getAllPlanets();
-		QVector<NebulaP> allDSO = dsoMgr->getAllDeepSkyObjects();
-		QList<StelObjectP> hipStars = starMgr->getHipparcosStars();
-		QList<StelACStarData> dblHipStars = starMgr->getHipparcosDoubleStars();
-		QList<StelACStarData> varHipStars = starMgr->getHipparcosVariableStars();
-		QList<StelACStarData> hpmHipStars = starMgr->getHipparcosHighPMStars();
-
 		const Nebula::TypeGroup& tflags = dsoMgr->getTypeFilters();
 
 		double magLimit = ui->wutMagnitudeDoubleSpinBox->value();
 		double JD = core->getJD();
-		double wutJD = (int)JD;
-		double az, alt;
-
-		// Dirty hack to calculate sunrise/sunset
-		// FIXME: This block of code should be replaced in future!
-		PlanetP sun = GETSTELMODULE(SolarSystem)->getSun();
-		double sunset = -1, sunrise = -1, midnight = -1, lc = 100.0;
-		bool flag = false;
-		for (int i=0; i<288; i++) // Check position every 5 minutes...
-		{
-			wutJD = (int)JD + i*0.0034722;
-			core->setJD(wutJD);
-			core->update(0);
-			StelUtils::rectToSphe(&az, &alt, sun->getAltAzPosAuto(core));
-			alt = std::fmod(alt,2.0*M_PI)*180./M_PI;
-			if (alt>=-7 && alt<=-5 && !flag)
-			{
-				sunset = wutJD;
-				flag = true;
-			}
-			if (alt>=-7 && alt<=-5 && flag)
-				sunrise = wutJD;
-
-			if (alt<lc)
-			{
-				midnight = wutJD;
-				lc = alt;
-			}
-		}
-		core->setJD(JD);
-
-		QList<double> wutJDList;
-		wutJDList.clear();
-
 		QComboBox* wut = ui->wutComboBox;
-		switch (wut->itemData(wut->currentIndex()).toInt())
-		{
-			case 1: // Morning
-				wutJDList << sunrise;
-				break;
-			case 2: // Night
-				wutJDList << midnight;
-				break;
-			case 3:
-				wutJDList << sunrise << midnight << sunset;
-				break;
-			default: // Evening
-				wutJDList << sunset;
-				break;
-		}
-
-		for (int i=0; i<wutJDList.count(); i++)
+		int interval = wut->itemData(wut->currentIndex()).toInt();
+
+		const StelSkyDrawer* skyDrawer = core->getSkyDrawer();
+		LandscapeMgr* lmgr = GETSTELMODULE(LandscapeMgr);
+		WutEngine::Parameters params;
+		params.magLimit = magLimit;
+		params.atmosphere = skyDrawer->getFlagHasAtmosphere();
+		params.refraction = skyDrawer->getRefraction();
+		params.extinction = skyDrawer->getExtinction();
+		if (lmgr->getFlagLandscape())
+			params.landscape = lmgr->getCurrentLandscape();
+
+		// The search covers the day of JD, so the result is the same for any time of the night
+		const StelLocation loc = core->getCurrentLocation();
+		QStringList key;
+		key << QString::number((int)JD) << loc.planetName << QString::number(loc.latitude, 'f', 6) << QString::number(loc.longitude, 'f', 6)
+		    << QString::number(loc.altitude) << QString::number(categoryId) << QString::number(interval) << QString::number(magLimit, 'f', 2)
+		    << QString::number(int(tflags)) << QString::number(params.atmosphere) << QString::number(params.extinction.getExtinctionCoefficient())
+		    << QString::number(params.extinction.getUndergroundExtinctionMode()) << QString::number(params.refraction.getPressure())
+		    << QString::number(params.refraction.getTemperature()) << (params.landscape ? lmgr->getCurrentLandscapeID() : QString())
+		    << localeMgr->getSkyLanguage() << StelApp::getInstance().getSkyCultureMgr().getCurrentSkyCultureID()
+		    << QString::number(int(dsoMgr->getCatalogFilters()));
+		const QString cacheKey = key.join('|');
+
+		if (wutCache.contains(cacheKey))
+			wutObjects = wutCache.value(cacheKey);
+		else
 		{
-			core->setJD(wutJDList.at(i));
-			core->update(0);
-
+			// Objects of the category. The state of solar system objects has to be computed at each time.
+			QList<StelObjectP> objects;
+			bool moving = false;
+			Planet::PlanetType planetType = Planet::isPlanet;
+			Nebula::TypeGroupFlags dsoGroup = Nebula::TypeOther;
+			QList<Nebula::NebulaType> dsoTypes;
 			switch (categoryId)
 			{
 				case 1: // Bright stars
-					foreach(const StelObjectP& object, hipStars)
-					{
-						if (object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					objects = starMgr->getHipparcosStars();
 					break;
 				case 2: // Bright nebulae
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						if ((bool)(tflags & Nebula::TypeBrightNebulae) && (ntype==Nebula::NebN || ntype==Nebula::NebBn || ntype==Nebula::NebEn || ntype==Nebula::NebRn || ntype==Nebula::NebHII || ntype==Nebula::NebISM || ntype==Nebula::NebCn || ntype==Nebula::NebSNR) && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeBrightNebulae;
+					dsoTypes << Nebula::NebN << Nebula::NebBn << Nebula::NebEn << Nebula::NebRn << Nebula::NebHII << Nebula::NebISM << Nebula::NebCn << Nebula::NebSNR;
 					break;
 				case 3: // Dark nebulae
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						if ((bool)(tflags & Nebula::TypeDarkNebulae) && (ntype==Nebula::NebDn || ntype==Nebula::NebMolCld || ntype==Nebula::NebYSO) && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeDarkNebulae;
+					dsoTypes << Nebula::NebDn << Nebula::NebMolCld << Nebula::NebYSO;
+					params.magnitudeRule = WutEngine::MagnitudeIgnored;
 					break;
 				case 4: // Galaxies
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						if ((bool)(tflags & Nebula::TypeGalaxies) && (ntype==Nebula::NebGx || ntype==Nebula::NebAGx || ntype==Nebula::NebRGx || ntype==Nebula::NebQSO || ntype==Nebula::NebPossQSO || ntype==Nebula::NebBLL || ntype==Nebula::NebBLA || ntype==Nebula::NebIGx) && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeGalaxies;
+					dsoTypes << Nebula::NebGx << Nebula::NebAGx << Nebula::NebRGx << Nebula::NebQSO << Nebula::NebPossQSO << Nebula::NebBLL << Nebula::NebBLA << Nebula::NebIGx;
 					break;
 				case 5: // Star clusters
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						if ((bool)(tflags & Nebula::TypeStarClusters) && (ntype==Nebula::NebCl || ntype==Nebula::NebOc || ntype==Nebula::NebGc || ntype==Nebula::NebSA || ntype==Nebula::NebSC || ntype==Nebula::NebCn) && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeStarClusters;
+					dsoTypes << Nebula::NebCl << Nebula::NebOc << Nebula::NebGc << Nebula::NebSA << Nebula::NebSC << Nebula::NebCn;
 					break;
 				case 6: // Asteroids
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isAsteroid && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isAsteroid;
 					break;
 				case 7: // Comets
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isComet && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isComet;
 					break;
 				case 8: // Plutinos
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isPlutino && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isPlutino;
 					break;
 				case 9: // Dwarf planets
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isDwarfPlanet && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isDwarfPlanet;
 					break;
 				case 10: // Cubewanos
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isCubewano && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isCubewano;
 					break;
 				case 11: // Scattered disc objects
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isSDO && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isSDO;
 					break;
 				case 12: // Oort cloud objects
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isOCO && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isOCO;
 					break;
 				case 13: // Sednoids
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isSednoid && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isSednoid;
 					break;
 				case 14: // Planetary nebulae
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						if ((bool)(tflags & Nebula::TypePlanetaryNebulae) && (ntype==Nebula::NebPn || ntype==Nebula::NebPossPN || ntype==Nebula::NebPPN) && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypePlanetaryNebulae;
+					dsoTypes << Nebula::NebPn << Nebula::NebPossPN << Nebula::NebPPN;
 					break;
 				case 15: // Bright double stars
-					foreach(const StelACStarData& dblStar, dblHipStars)
-					{
-						StelObjectP object = dblStar.firstKey();
-						if (object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					foreach(const StelACStarData& dblStar, starMgr->getHipparcosDoubleStars())
+						objects.append(dblStar.firstKey());
 					break;
 				case 16: // Bright variale stars
-					foreach(const StelACStarData& varStar, varHipStars)
-					{
-						StelObjectP object = varStar.firstKey();
-						if (object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					foreach(const StelACStarData& varStar, starMgr->getHipparcosVariableStars())
+						objects.append(varStar.firstKey());
 					break;
 				case 17: // Bright stars with high proper motion
-					foreach(const StelACStarData& hpmStar, hpmHipStars)
-					{
-						StelObjectP object = hpmStar.firstKey();
-						if (object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					foreach(const StelACStarData& hpmStar, starMgr->getHipparcosHighPMStars())
+						objects.append(hpmStar.firstKey());
 					break;
 				case 18: // Symbiotic stars
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						if ((bool)(tflags & Nebula::TypeOther) && (ntype==Nebula::NebSymbioticStar) && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeOther;
+					dsoTypes << Nebula::NebSymbioticStar;
 					break;
 				case 19: // Emission-line stars
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();						
-						if ((bool)(tflags & Nebula::TypeOther) && (ntype==Nebula::NebEmissionLineStar) && (object->getVMagnitudeWithExtinction(core)<=magLimit) && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeOther;
+					dsoTypes << Nebula::NebEmissionLineStar;
 					break;
 				case 20: // Supernova candidates
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						bool visible = ((object->getVMagnitudeWithExtinction(core)<=magLimit) || (object->getVMagnitude(core)>90.f && magLimit>=19.f));
-						if ((bool)(tflags & Nebula::TypeSupernovaRemnants) && (ntype==Nebula::NebSNC) && visible && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeSupernovaRemnants;
+					dsoTypes << Nebula::NebSNC;
+					params.magnitudeRule = WutEngine::MagnitudeLimitOrUnknown;
 					break;
 				case 21: // Supernova remnant candidates
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						bool visible = ((object->getVMagnitudeWithExtinction(core)<=magLimit) || (object->getVMagnitude(core)>90.f && magLimit>=19.f));
-						if ((bool)(tflags & Nebula::TypeSupernovaRemnants) && (ntype==Nebula::NebSNRC) && visible && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeSupernovaRemnants;
+					dsoTypes << Nebula::NebSNRC;
+					params.magnitudeRule = WutEngine::MagnitudeLimitOrUnknown;
 					break;
 				case 22: // Supernova remnants
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						bool visible = ((object->getVMagnitudeWithExtinction(core)<=magLimit) || (object->getVMagnitude(core)>90.f && magLimit>=19.f));
-						if ((bool)(tflags & Nebula::TypeSupernovaRemnants) && (ntype==Nebula::NebSNR) && visible && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeSupernovaRemnants;
+					dsoTypes << Nebula::NebSNR;
+					params.magnitudeRule = WutEngine::MagnitudeLimitOrUnknown;
 					break;
 				case 23: // Clusters of galaxies
-					foreach(const NebulaP& object, allDSO)
-					{
-						Nebula::NebulaType ntype = object->getDSOType();
-						if ((bool)(tflags & Nebula::TypeGalaxyClusters) && (ntype==Nebula::NebGxCl) && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-						{
-							QString d = object->getDSODesignation();
-							QString n = object->getNameI18n();
-
-							if (d.isEmpty() && n.isEmpty())
-								continue;
-
-							if (d.isEmpty())
-								wutObjects.insert(n, n);
-							else if (n.isEmpty())
-								wutObjects.insert(d, d);
-							else
-								wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
-						}
-					}
+					dsoGroup = Nebula::TypeGalaxyClusters;
+					dsoTypes << Nebula::NebGxCl;
 					break;
 				default: // Planets
-					foreach(const PlanetP& object, allObjects)
-					{
-						if (object->getPlanetType()==Planet::isPlanet && object->getVMagnitudeWithExtinction(core)<=magLimit && object->isAboveRealHorizon(core))
-							wutObjects.insert(object->getNameI18n(), object->getEnglishName());
-					}
+					moving = true;
+					planetType = Planet::isPlanet;
+					break;
+			}
+
+			if (!dsoTypes.isEmpty() && (bool)(tflags & dsoGroup))
+			{
+				foreach(const NebulaP& object, dsoMgr->getAllDeepSkyObjects())
+				{
+					if (dsoTypes.contains(object->getDSOType()))
+						objects.append(object);
+				}
+			}
+			if (moving)
+			{
+				foreach(const PlanetP& object, solarSystem->getAllPlanets())
+				{
+					if (object->getPlanetType()==planetType)
+						objects.append(object);
+				}
+			}
+
+			// Fixed objects hardly move in a night, so they are taken at the current time
+			QVector<WutEngine::Object> states;
+			if (!moving)
+			{
+				states.reserve(objects.size());
+				foreach(const StelObjectP& object, objects)
+					states.append(WutEngine::Object(object->getJ2000EquatorialPos(core), object->getVMagnitude(core)));
+			}
+
+			// Find sunset, sunrise and midnight, checking the position of the Sun every 5 minutes.
+			// The core is only updated at the ends of the search, the Sun is interpolated in between.
+			const Mat4d matJ2000ToEquinoxEqu = getJ2000ToEquinoxEquMatrix();
+			QVector<WutEngine::Step> searchSteps;
+			searchSteps.reserve(288);
+			for (int i=0; i<288; i++)
+				searchSteps.append(getWutStep((int)JD + i*0.0034722, matJ2000ToEquinoxEqu));
+
+			PlanetP sun = solarSystem->getSun();
+			core->setJD(searchSteps.first().JD);
+			core->update(0);
+			const Vec3d sunStart = sun->getJ2000EquatorialPos(core);
+			core->setJD(searchSteps.last().JD);
+			core->update(0);
+			const Vec3d sunEnd = sun->getJ2000EquatorialPos(core);
+			const WutEngine::NightEvents night = WutEngine::findNightEvents(searchSteps, sunStart, sunEnd, params);
+
+			QList<double> wutJDList;
+			switch (interval)
+			{
+				case 1: // Morning
+					wutJDList << night.sunrise;
+					break;
+				case 2: // Night
+					wutJDList << night.midnight;
+					break;
+				case 3:
+					wutJDList << night.sunrise << night.midnight << night.sunset;
+					break;
+				default: // Evening
+					wutJDList << night.sunset;
 					break;
 			}
+
+			QVector<WutEngine::Step> wutSteps;
+			foreach(double wutJD, wutJDList)
+			{
+				wutSteps.append(getWutStep(wutJD, matJ2000ToEquinoxEqu));
+				if (moving)
+				{
+					core->setJD(wutJD);
+					core->update(0);
+					foreach(const StelObjectP& object, objects)
+						states.append(WutEngine::Object(object->getJ2000EquatorialPos(core), object->getVMagnitude(core)));
+				}
+			}
+			core->setJD(JD);
+
+			const QVector<quint32> visibility = WutEngine::computeVisibility(states, objects.size(), wutSteps, params);
+
+			wutObjects.clear();
+			for (int i=0; i<objects.size(); i++)
+			{
+				if (visibility.at(i)==0)
+					continue;
+
+				const StelObjectP& object = objects.at(i);
+				if (dsoTypes.isEmpty())
+				{
+					wutObjects.insert(object->getNameI18n(), object->getEnglishName());
+					continue;
+				}
+
+				QString d = object.staticCast<Nebula>()->getDSODesignation();
+				QString n = object->getNameI18n();
+
+				if (d.isEmpty() && n.isEmpty())
+					continue;
+
+				if (d.isEmpty())
+					wutObjects.insert(n, n);
+				else if (n.isEmpty())
+					wutObjects.insert(d, d);
+				else
+					wutObjects.insert(QString("%1 (%2)").arg(d, n), d);
+			}
+
+			if (wutCache.size()>=WUT_CACHE_SIZE)
+				wutCache.clear();
+			wutCache.insert(cacheKey, wutObjects);
 		}
 
-		core->setJD(JD);
 		ui->wutMatchingObjectsListWidget->blockSignals(true);
 		ui->wutMatchingObjectsListWidget->clear();
 		ui->wutMatchingObjectsListWidget->addItems(wutObjects.keys());
@@ -3552,6 +3413,22 @@ void AstroCalcDialog::calculateWutObjects()
 	}
 }
 
+Mat4d AstroCalcDialog::getJ2000ToEquinoxEquMatrix() const
+{
+	const Vec3d x = core->j2000ToEquinoxEqu(Vec3d(1.,0.,0.), StelCore::RefractionOff);
+	const Vec3d y = core->j2000ToEquinoxEqu(Vec3d(0.,1.,0.), StelCore::RefractionOff);
+	const Vec3d z = core->j2000ToEquinoxEqu(Vec3d(0.,0.,1.), StelCore::RefractionOff);
+	return Mat4d(x[0], x[1], x[2], 0., y[0], y[1], y[2], 0., z[0], z[1], z[2], 0., 0., 0., 0., 1.);
+}
+
+WutEngine::Step AstroCalcDialog::getWutStep(double JD, const Mat4d& matJ2000ToEquinoxEqu) const
+{
+	// Same as StelCore::updateTransformMatrices() at JD, without changing the time of the core
+	const double JDE = JD + core->computeDeltaT(JD)/86400.;
+	const Mat4d matAltAzToEquinoxEqu = core->getCurrentObserver()->getRotAltAzToEquatorial(JD, JDE);
+	return WutEngine::Step(JD, matAltAzToEquinoxEqu.transpose()*matJ2000ToEquinoxEqu);
+}
+
 void AstroCalcDialog::selectWutObject()
 {
 	if(ui->wutMatchingObjectsListWidget->currentItem())
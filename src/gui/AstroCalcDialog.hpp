@@ -36,6 +36,7 @@
 #include "NebulaMgr.hpp"
 #include "StarMgr.hpp"
 #include "StelUtils.hpp"
+#include "WutEngine.hpp"
 
 class Ui_astroCalcDialogForm;
 class QListWidgetItem;
@@ -168,6 +169,7 @@ private slots:
 	void saveWutMagnitudeLimit(double mag);
 	void saveWutTimeInterval(int index);
 	void calculateWutObjects();
+	void clearWutCache();
 	void selectWutObject();
 	void saveWutObjects();
 
@@ -189,6 +191,16 @@ private:
 	QTimer *currentTimeLine;
 	QHash<QString,QString> wutObjects;
 	QHash<QString,int> wutCategories;
+	//! Results of calculateWutObjects() by night, location, category and settings.
+	//! The DSO size limits are not in the key, the cache is cleared when they change.
+	QHash<QString, QHash<QString,QString> > wutCache;
+	static const int WUT_CACHE_SIZE = 32;
+
+	//! The transformation from J2000 to the equatorial frame of the current date
+	Mat4d getJ2000ToEquinoxEquMatrix() const;
+	//! The time step of the WUT engine at JD.
+	//! The precession is taken from @param matJ2000ToEquinoxEqu, as it changes little in a night.
+	WutEngine::Step getWutStep(double JD, const Mat4d& matJ2000ToEquinoxEqu) const;
 
 	//! Update header names for celestial positions tables
 	void setCelestialPositionsHeaderNames();
@@ -921,6 +921,7 @@ void ConfigurationDialog::saveAllSettings()
 
 	conf->setValue("main/screenshot_dir", StelFileMgr::getScreenshotDir());
 	conf->setValue("main/invert_screenshots_colors", StelMainView::getInstance().getFlagInvertScreenShotColors());
+	conf->setValue("main/screenshot_format", StelMainView::getInstance().getScreenShotFormat());
 
 	int screenNum = qApp->desktop()->screenNumber(&StelMainView::getInstance());
 	conf->setValue("video/screen_number", screenNum);
@@ -1342,6 +1343,7 @@ void ConfigurationDialog::downloadFinished()
 	currentDownloadFile->close();
 	currentDownloadFile->deleteLater();
 	currentDownloadFile = Q_NULLPTR;
+	StelFileMgr::invalidateCache();
 	starCatalogDownloadReply->deleteLater();
 	starCatalogDownloadReply = Q_NULLPTR;
 	StelApp::getInstance().removeProgressBar(progressBar);
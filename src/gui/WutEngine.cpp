@@ -0,0 +1,178 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "WutEngine.hpp"
+#include "Landscape.hpp"
+
+#include <QtConcurrent>
+
+#include <cmath>
+
+const int WutEngine::MAX_STEPS;
+const int WutEngine::PARALLEL_BATCH_SIZE;
+
+namespace
+{
+	//! A range of objects checked by one task of WutEngine::computeVisibility()
+	struct VisibilityBlock
+	{
+		const QVector<WutEngine::Object>* objects;
+		const QVector<WutEngine::Step>* steps;
+		const WutEngine::Parameters* params;
+		int objectCount;
+		int begin;
+		int end;
+		//! Check the magnitude only, the horizon is checked afterwards
+		bool magnitudeOnly;
+		quint32* masks;
+	};
+
+	bool isBrightEnough(const WutEngine::Object& object, const Vec3d& altAzPos, const WutEngine::Parameters& params)
+	{
+		if (params.magnitudeRule==WutEngine::MagnitudeIgnored)
+			return true;
+
+		float vMag = object.vMag;
+		if (params.atmosphere)
+		{
+			Vec3d pos(altAzPos);
+			pos.normalize();
+			params.extinction.forward(pos, &vMag);
+		}
+		if (vMag<=params.magLimit)
+			return true;
+		return params.magnitudeRule==WutEngine::MagnitudeLimitOrUnknown && object.vMag>90.f && params.magLimit>=19.f;
+	}
+
+	//! The apparent horizontal position, as returned by StelObject::getAltAzPosAuto()
+	Vec3d getApparentPos(const Vec3d& altAzPos, const WutEngine::Parameters& params)
+	{
+		Vec3d pos(altAzPos);
+		if (params.atmosphere)
+			params.refraction.forward(pos);
+		return pos;
+	}
+
+	void computeBlock(VisibilityBlock& block)
+	{
+		const bool moving = block.objects->size()!=block.objectCount;
+		for (int s=0; s<block.steps->size(); ++s)
+		{
+			const Mat4d& mat = block.steps->at(s).matJ2000ToAltAz;
+			const quint32 bit = 1u<<s;
+			const WutEngine::Object* objects = block.objects->constData() + (moving ? s*block.objectCount : 0);
+			for (int i=block.begin; i<block.end; ++i)
+			{
+				const Vec3d altAzPos = mat*objects[i].j2000Pos;
+				if (!isBrightEnough(objects[i], altAzPos, *block.params))
+					continue;
+				if (block.magnitudeOnly || getApparentPos(altAzPos, *block.params)[2]>=0.)
+					block.masks[i] |= bit;
+			}
+		}
+	}
+}
+
+QVector<quint32> WutEngine::computeVisibility(const QVector<Object>& objects, int objectCount, const QVector<Step>& steps, const Parameters& params)
+{
+	Q_ASSERT(steps.size()<=MAX_STEPS);
+	Q_ASSERT(objects.size()==objectCount || objects.size()==objectCount*steps.size());
+
+	QVector<quint32> masks(objectCount, 0u);
+	if (objectCount==0 || steps.isEmpty())
+		return masks;
+
+	// Landscape::getOpacity() is not meant to be called from several threads,
+	// so with a landscape the threads only check the magnitudes
+	VisibilityBlock block = { &objects, &steps, &params, objectCount, 0, objectCount, params.landscape!=Q_NULLPTR, masks.data() };
+	if (objectCount<PARALLEL_BATCH_SIZE)
+		computeBlock(block);
+	else
+	{
+		// the objects are independent, so blocks of them can be processed in parallel
+		const int blockSize = PARALLEL_BATCH_SIZE/4;
+		QVector<VisibilityBlock> blocks;
+		blocks.reserve(objectCount/blockSize + 1);
+		for (int i=0; i<objectCount; i+=blockSize)
+		{
+			block.begin = i;
+			block.end = qMin(objectCount, i+blockSize);
+			blocks.append(block);
+		}
+		QtConcurrent::blockingMap(blocks, &computeBlock);
+	}
+
+	if (params.landscape)
+	{
+		const bool moving = objects.size()!=objectCount;
+		for (int i=0; i<objectCount; ++i)
+		{
+			if (masks.at(i)==0)
+				continue;
+			for (int s=0; s<steps.size(); ++s)
+			{
+				const quint32 bit = 1u<<s;
+				if (!(masks.at(i) & bit))
+					continue;
+				const Object& object = objects.at(moving ? s*objectCount+i : i);
+				const Vec3d pos = getApparentPos(steps.at(s).matJ2000ToAltAz*object.j2000Pos, params);
+				if (params.landscape->getOpacity(pos)>0.85f)
+					masks[i] &= ~bit;
+			}
+		}
+	}
+	return masks;
+}
+
+bool WutEngine::isVisible(const Object& object, const Mat4d& matJ2000ToAltAz, const Parameters& params)
+{
+	const Vec3d altAzPos = matJ2000ToAltAz*object.j2000Pos;
+	return isBrightEnough(object, altAzPos, params) && getApparentPos(altAzPos, params)[2]>=0.;
+}
+
+WutEngine::NightEvents WutEngine::findNightEvents(const QVector<Step>& steps, const Vec3d& sunStart, const Vec3d& sunEnd, const Parameters& params)
+{
+	NightEvents events;
+	if (steps.isEmpty())
+		return events;
+
+	const double startJD = steps.first().JD;
+	const double duration = steps.last().JD - startJD;
+	double lowest = 100.;
+	for (int i=0; i<steps.size(); ++i)
+	{
+		const Step& step = steps.at(i);
+		const double f = duration>0. ? (step.JD-startJD)/duration : 0.;
+		const Vec3d pos = getApparentPos(step.matJ2000ToAltAz*(sunStart + (sunEnd-sunStart)*f), params);
+		const double alt = std::asin(pos[2]/pos.length())*180./M_PI;
+		if (alt>=-7. && alt<=-5.)
+		{
+			if (events.sunset<0.)
+				events.sunset = step.JD;
+			events.sunrise = step.JD;
+		}
+		if (alt<lowest)
+		{
+			events.midnight = step.JD;
+			lowest = alt;
+		}
+	}
+	return events;
+}
@@ -0,0 +1,116 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _WUTENGINE_HPP_
+#define _WUTENGINE_HPP_
+
+#include "VecMath.hpp"
+#include "RefractionExtinction.hpp"
+
+#include <QVector>
+
+class Landscape;
+
+//! @class WutEngine
+//! Computes which objects are visible at some times of a night for the "What's Up Tonight" tool of the AstroCalcDialog.
+//!
+//! The engine works with copies of the J2000 positions and magnitudes of the objects, and with the transformation
+//! from J2000 to the horizontal frame at each time step, so that the global StelCore does not have to be stepped
+//! through the night. The objects are checked in parallel, applying the same rules as
+//! StelObject::getVMagnitudeWithExtinction() and StelObject::isAboveRealHorizon().
+class WutEngine
+{
+public:
+	//! How the magnitude of an object is checked against the limit
+	enum MagnitudeRule
+	{
+		MagnitudeLimit,		//!< Visible if the magnitude with extinction is not above the limit
+		MagnitudeIgnored,	//!< The magnitude is not checked (dark nebulae)
+		MagnitudeLimitOrUnknown	//!< As MagnitudeLimit, or if the magnitude is unknown (>90) and the limit at least 19
+	};
+
+	//! State of an object at a time step
+	struct Object
+	{
+		Object() : vMag(99.f) {}
+		Object(const Vec3d& j2000Pos, float vMag) : j2000Pos(j2000Pos), vMag(vMag) {}
+		//! J2000 equatorial position, as returned by StelObject::getJ2000EquatorialPos()
+		Vec3d j2000Pos;
+		//! Visual magnitude without extinction
+		float vMag;
+	};
+
+	//! A time at which the objects are checked
+	struct Step
+	{
+		Step() : JD(0.) {}
+		Step(double JD, const Mat4d& matJ2000ToAltAz) : JD(JD), matJ2000ToAltAz(matJ2000ToAltAz) {}
+		double JD;
+		//! Transformation from J2000 to the (geometric) horizontal frame at JD
+		Mat4d matJ2000ToAltAz;
+	};
+
+	//! Copies of the settings the visibility depends on
+	struct Parameters
+	{
+		Parameters() : magLimit(6.), magnitudeRule(MagnitudeLimit), atmosphere(false), landscape(Q_NULLPTR) {}
+		double magLimit;
+		MagnitudeRule magnitudeRule;
+		//! Whether extinction and refraction are applied
+		bool atmosphere;
+		Refraction refraction;
+		Extinction extinction;
+		//! The landscape which hides the objects, or Q_NULLPTR to use the mathematical horizon
+		const Landscape* landscape;
+	};
+
+	//! The times found by findNightEvents(), -1 if there is no such time.
+	struct NightEvents
+	{
+		NightEvents() : sunset(-1.), sunrise(-1.), midnight(-1.) {}
+		double sunset;
+		double sunrise;
+		double midnight;
+	};
+
+	//! Maximal number of time steps of computeVisibility()
+	static const int MAX_STEPS = 32;
+	//! Number of objects from which computeVisibility() checks them in parallel
+	static const int PARALLEL_BATCH_SIZE = 1024;
+
+	//! Check when objects are visible.
+	//! @param objects the states of the objects. Either one state per object for fixed objects (stars, DSO),
+	//! or one state per object and step, with the state of object i at step s at index s*objectCount+i.
+	//! @param objectCount the number of objects
+	//! @param steps at most MAX_STEPS time steps
+	//! @return for each object, a mask of the steps at which it is visible
+	static QVector<quint32> computeVisibility(const QVector<Object>& objects, int objectCount, const QVector<Step>& steps, const Parameters& params);
+
+	//! Check if an object is visible for a transformation from J2000 to the horizontal frame.
+	//! The landscape is not consulted, only the mathematical horizon.
+	static bool isVisible(const Object& object, const Mat4d& matJ2000ToAltAz, const Parameters& params);
+
+	//! Find the times of sunset, sunrise and lowest Sun in the time steps.
+	//! Sunset and sunrise are the first and last steps with the Sun between 5 and 7 degrees below the horizon.
+	//! The position of the Sun is interpolated between its J2000 positions at the first and last steps.
+	static NightEvents findNightEvents(const QVector<Step>& steps, const Vec3d& sunStart, const Vec3d& sunEnd, const Parameters& params);
+};
+
+#endif // _WUTENGINE_HPP_
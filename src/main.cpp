@@ -142,6 +142,24 @@ int main(int argc, char **argv)
 	QCoreApplication::addLibraryPath(appInfo.absolutePath());
 	#endif	
 
+	// Headless batch rendering still needs an OpenGL context, which Qt's "offscreen" platform plugin cannot create
+	// without an X server. Machines without a display have to provide a virtual one, e.g. with xvfb-run.
+	bool headless = QString(qgetenv("STEL_OPTS").constData()).split(" ").contains("--headless");
+	for (int i=1; i<argc && qstrcmp(argv[i], "--")!=0; ++i)
+	{
+		if (qstrcmp(argv[i], "--headless")==0)
+			headless = true;
+	}
+	#if defined(Q_OS_UNIX) && !defined(Q_OS_MAC)
+	if (headless && qEnvironmentVariableIsEmpty("DISPLAY") && qEnvironmentVariableIsEmpty("WAYLAND_DISPLAY")
+	    && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+	{
+		qCritical("ERROR --headless needs a display for its OpenGL context. Without one, run Stellarium in a virtual X server, e.g.:\n"
+			  "xvfb-run -s \"-screen 0 1920x1080x24\" stellarium --headless --startup-script ...");
+		return 1;
+	}
+	#endif
+
 	QGuiApplication::setDesktopSettingsAware(false);
 
 #ifndef USE_QUICKVIEW
@@ -166,9 +184,12 @@ int main(int argc, char **argv)
 
 	QPixmap pixmap(StelFileMgr::findFile("data/splash.png"));
 	QSplashScreen splash(pixmap);
-	splash.show();
-	splash.showMessage(StelUtils::getApplicationVersion() , Qt::AlignLeft, Qt::white);
-	app.processEvents();
+	if (!headless)
+	{
+		splash.show();
+		splash.showMessage(StelUtils::getApplicationVersion() , Qt::AlignLeft, Qt::white);
+		app.processEvents();
+	}
 
 	// Log command line arguments.
 	QString argStr;
@@ -21,6 +21,7 @@
 #include "StelMainScriptAPI.hpp"
 #include "StelMainScriptAPIProxy.hpp"
 #include "StelScriptMgr.hpp"
+#include "StelScriptWait.hpp"
 #include "StelLocaleMgr.hpp"
 
 #include "ConstellationMgr.hpp"
@@ -43,6 +44,7 @@
 #include "StelModuleMgr.hpp"
 #include "StelMovementMgr.hpp"
 #include "StelPropertyMgr.hpp"
+#include "StelProfiler.hpp"
 
 #include "StelObject.hpp"
 #include "StelObjectMgr.hpp"
@@ -65,8 +67,6 @@
 #include <QSet>
 #include <QStringList>
 #include <QTemporaryFile>
-#include <QTimer>
-#include <QEventLoop>
 
 #include <cmath>
 
@@ -292,6 +292,21 @@ void StelMainScriptAPI::screenshot(const QString& prefix, bool invert, const QSt
 	StelMainView::getInstance().setFlagInvertScreenShotColors(oldInvertSetting);
 }
 
+void StelMainScriptAPI::setScreenshotFormat(const QString& format)
+{
+	StelMainView::getInstance().setScreenShotFormat(format);
+}
+
+void StelMainScriptAPI::setProfilerEnabled(bool b)
+{
+	StelApp::getInstance().getProfiler()->setFlagEnabled(b);
+}
+
+void StelMainScriptAPI::saveProfilerTrace(const QString& fileName)
+{
+	StelApp::getInstance().saveProfilerTrace(fileName);
+}
+
 void StelMainScriptAPI::setGuiVisible(bool b)
 {
 	StelApp::getInstance().getGui()->setVisible(b);
@@ -866,9 +881,21 @@ double StelMainScriptAPI::jdFromDateString(const QString& dt, const QString& spe
 }
 
 void StelMainScriptAPI::wait(double t) {
-	QEventLoop loop;
-	QTimer::singleShot(1000*t, &loop, SLOT(quit()));
-	loop.exec();
+	if (StelMainView::getInstance().getFrameStep()>0.)
+	{
+		waitSimulatedTime(t);
+		return;
+	}
+	StelApp::getInstance().getScriptMgr().getScriptWait()->sleep(qRound(1000*t));
+}
+
+void StelMainScriptAPI::waitSimulatedTime(double t)
+{
+	// With a fixed frame step, time passes by rendering frames and not by the wall clock,
+	// so check the simulated time after each frame.
+	StelMainView& view = StelMainView::getInstance();
+	const double end = view.getSimulatedTime() + t;
+	StelApp::getInstance().getScriptMgr().getScriptWait()->waitUntil([&view, end]() { return view.getSimulatedTime() >= end; });
 }
 
 void StelMainScriptAPI::waitFor(const QString& dt, const QString& spec)
@@ -879,9 +906,12 @@ void StelMainScriptAPI::waitFor(const QString& dt, const QString& spec)
 	int interval=1000*deltaJD*86400/timeRate;
 	if (interval<=0){ qDebug() << "waitFor() called, but negative interval. (time exceeded before starting timer). Not waiting!"; return; }
 	//qDebug() << "timeSpeed is" << timeSpeed << " interval:" << interval;
-	QEventLoop loop;
-	QTimer::singleShot(interval, &loop, SLOT(quit()));
-	loop.exec();
+	if (StelMainView::getInstance().getFrameStep()>0.)
+	{
+		waitSimulatedTime(deltaJD*86400/timeRate);
+		return;
+	}
+	StelApp::getInstance().getScriptMgr().getScriptWait()->sleep(interval);
 }
 
 
@@ -309,9 +309,25 @@ public slots:
 	//! @param dir the path of the directory to save the screenshot in.  If
 	//! none is specified, the default screenshot directory will be used.
 	//! @param invert whether colors have to be inverted in the output image
-	//! @param overwrite true to use exactly the prefix as filename (plus .png), and overwrite any existing file.
+	//! @param overwrite true to use exactly the prefix as filename (plus the extension of the screenshot format), and overwrite any existing file.
+	//! @note The image is encoded and written in a background thread, so the file may appear a little later.
+	//! Without @p overwrite, consecutive calls produce a numbered frame sequence.
 	void screenshot(const QString& prefix, bool invert=false, const QString& dir="", const bool overwrite=false);
 
+	//! Set the file format of screenshots.
+	//! @param format "png" (default), "jpg", any other image format supported by Qt, or "raw"
+	//! for uncompressed RGBA pixel data without header (fastest to write).
+	void setScreenshotFormat(const QString& format);
+
+	//! Enable or disable the frame profiler, which records the time spent in each module during the last frames.
+	//! @param b if true, frames are recorded.
+	void setProfilerEnabled(bool b);
+
+	//! Save the frames recorded by the profiler as a Chrome trace file (open it in chrome://tracing).
+	//! @param fileName the file to write. If none is specified, profiler-<date>-<time>.json
+	//! is written in the user data directory.
+	void saveProfilerTrace(const QString& fileName="");
+
 	//! Show or hide the GUI (toolbars).  Note this only applies to GUI plugins which
 	//! provide the public slot "setGuiVisible(bool)".
 	//! @param b if true, show the GUI, if false, hide the GUI.
@@ -805,6 +821,8 @@ public slots:
 	// Details: https://bugs.launchpad.net/stellarium/+bug/1402200
 	// re-implemented for 0.15.1 to avoid a busy-loop.
 	//! Pauses the script for \e t seconds
+	//! When rendering with a fixed frame step (options --frame-step or --headless),
+	//! \e t is simulated time, i.e. the script waits for t/frame step frames.
 	//! @param t the number of seconds to wait
 	void wait(double t);
 
@@ -861,6 +879,10 @@ signals:
 	void requestSetDiskViewport(bool b);
 	void requestExit();
 	void requestSetHomePosition();
+
+private:
+	//! Process events until the frames rendered with a fixed frame step added up to \e t seconds
+	void waitSimulatedTime(double t);
 };
 
 #endif // _STELMAINSCRIPTAPI_HPP_
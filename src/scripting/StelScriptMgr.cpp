@@ -21,6 +21,7 @@
 
 #include "StelScriptOutput.hpp"
 #include "StelScriptMgr.hpp"
+#include "StelScriptWait.hpp"
 #include "StelMainScriptAPI.hpp"
 #include "StelModuleMgr.hpp"
 #include "LabelMgr.hpp"
@@ -79,22 +80,20 @@ QScriptValue createVec3f(QScriptContext* context, QScriptEngine *engine)
 class StelScriptEngineAgent : public QScriptEngineAgent
 {
 public:
-	explicit StelScriptEngineAgent(QScriptEngine *engine);
+	StelScriptEngineAgent(QScriptEngine *engine, StelScriptWait* scriptWait);
 	virtual ~StelScriptEngineAgent() {}
 
-	void setPauseScript(bool pause) { isPaused=pause; }
-	bool getPauseScript() { return isPaused; }
-
+	//! Stops a paused script before its next statement
 	void positionChange(qint64 scriptId, int lineNumber, int columnNumber);
 
 private:
-	bool isPaused;
-
+	StelScriptWait* scriptWait;
 };
 
 StelScriptMgr::StelScriptMgr(QObject *parent): QObject(parent)
 {
 	engine = new QScriptEngine(this);
+	scriptWait = new StelScriptWait(this);
 	connect(&StelApp::getInstance(), SIGNAL(aboutToQuit()), this, SLOT(stopScript()), Qt::DirectConnection);
 	// Scripting images
 	ScreenImageMgr* scriptImages = new ScreenImageMgr();
@@ -124,7 +123,7 @@ StelScriptMgr::StelScriptMgr(QObject *parent): QObject(parent)
 	
 	engine->setProcessEventsInterval(10);
 
-	agent = new StelScriptEngineAgent(engine);
+	agent = new StelScriptEngineAgent(engine, scriptWait);
 	engine->setAgent(agent);
 
 	initActions();
@@ -348,6 +347,7 @@ bool StelScriptMgr::runPreprocessedScript(const QString &preprocessedScript, con
 	engine->globalObject().setProperty("scriptRateReadOnly", 1.0);
 
 	scriptFileName = scriptId;
+	scriptWait->reset();
 
 	// Notify that the script starts here
 	emit(scriptRunning());
@@ -433,9 +433,8 @@ void StelScriptMgr::stopScript()
 	{
 		GETSTELMODULE(LabelMgr)->deleteAllLabels();
 		GETSTELMODULE(ScreenImageMgr)->deleteAllImages();
-		if (agent->getPauseScript()) {
-			agent->setPauseScript(false);
-		}
+		// leave any wait or pause right away, so that the engine can abort
+		scriptWait->abort();
 		QString msg = QString("INFO: asking running script to exit");
 		emit(scriptDebug(msg));
 		//qDebug() << msg;
@@ -468,11 +467,16 @@ void StelScriptMgr::setScriptRate(float r)
 }
 
 void StelScriptMgr::pauseScript() {
-	agent->setPauseScript(true);
+	scriptWait->pause();
 }
 
 void StelScriptMgr::resumeScript() {
-	agent->setPauseScript(false);
+	scriptWait->resume();
+}
+
+void StelScriptMgr::update()
+{
+	scriptWait->tick();
 }
 
 double StelScriptMgr::getScriptRate()
@@ -605,10 +609,10 @@ bool StelScriptMgr::preprocessScript(QFile &input, QString& output, const QStrin
 	return preprocessScript(s, output, scriptDir);
 }
 
-StelScriptEngineAgent::StelScriptEngineAgent(QScriptEngine *engine) 
+StelScriptEngineAgent::StelScriptEngineAgent(QScriptEngine *engine, StelScriptWait* scriptWait)
 	: QScriptEngineAgent(engine)
+	, scriptWait(scriptWait)
 {
-	isPaused = false;
 }
 
 void StelScriptEngineAgent::positionChange(qint64 scriptId, int lineNumber, int columnNumber)
@@ -617,8 +621,5 @@ void StelScriptEngineAgent::positionChange(qint64 scriptId, int lineNumber, int
 	Q_UNUSED(lineNumber);
 	Q_UNUSED(columnNumber);
 
-	while (isPaused) {
-		// TODO : sleep for 'processEventsInterval' time
-		QCoreApplication::processEvents();
-	}
+	scriptWait->waitWhilePaused();
 }
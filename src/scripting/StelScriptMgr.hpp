@@ -28,6 +28,7 @@
 
 class StelMainScriptAPI;
 class StelScriptEngineAgent;
+class StelScriptWait;
 class QScriptEngine;
 
 #ifdef ENABLE_SCRIPT_CONSOLE
@@ -59,6 +60,9 @@ public:
 	//! ID of the script which is running.
 	QString runningScriptId();
 
+	//! The object used by the script API to suspend the running script.
+	StelScriptWait* getScriptWait() { return scriptWait; }
+
 	// Pre-processor functions
 	//! Preprocess script, esp. process include instructions.
 	//! if the command line option --verbose has been given,
@@ -126,7 +130,7 @@ public slots:
 	QString getShortcut(const QString& s) const;
 
 	//! Run the script located in the given file. In essence, this calls prepareScript and runPreprocessedScript.
-	//! @note This is a blocking call! The event queue is held up by calls of QCoreApplication::processEvents().
+	//! @note This is a blocking call! Events are processed in nested event loops while the script waits, see StelScriptWait.
 	//! @param fileName the location of the file containing the script.
 	//! @param includePath the directory to use when searching for include files
 	//! in the SSC preprocessor. If empty, this will be the same as the
@@ -138,7 +142,7 @@ public slots:
 
 	//! Runs the script code given. This can be used for quick script executions, without having to create a
 	//! temporary file first.
-	//! @note This is a blocking call! The event queue is held up by calls of QCoreApplication::processEvents().
+	//! @note This is a blocking call! Events are processed in nested event loops while the script waits, see StelScriptWait.
 	//! @param scriptCode The script to execute
 	//! @param includePath If a null string (the default), no pre-processing is done. If an empty string, the default
 	//! script directories are used (script/ in both user and install directory). Otherwise, the given directory is used.
@@ -147,7 +151,7 @@ public slots:
 
 	//! Runs preprocessed script code which has been generated using runPreprocessedScript().
 	//! In general, you do not want to use this method, use runScript() or runScriptDirect() instead.
-	//! @note This is a blocking call! The event queue is held up by calls of QCoreApplication::processEvents().
+	//! @note This is a blocking call! Events are processed in nested event loops while the script waits, see StelScriptWait.
 	//! @param preprocessedScript the string containing the preprocessed script.
 	//! @param scriptId The name of the script. Usually should correspond to the file name.
 	//! @return false if the given script code could not be run, true otherwise
@@ -202,6 +206,10 @@ public slots:
 	//! Resume a paused script.
 	void resumeScript();
 
+	//! Wake up a script which waits for something to happen in the simulation.
+	//! Called by StelApp once per frame.
+	void update();
+
 private slots:
 	//! Called at the end of the running threa
 	void scriptEnded();
@@ -242,6 +250,9 @@ private:
 	
 	//Script engine agent
 	StelScriptEngineAgent *agent;
+
+	//Suspends the running script in waits and pauses
+	StelScriptWait* scriptWait;
 };
 
 #endif // _STELSCRIPTMGR_HPP_
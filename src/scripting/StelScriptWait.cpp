@@ -0,0 +1,129 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "StelScriptWait.hpp"
+
+#include <QEventLoop>
+#include <QTimer>
+
+StelScriptWait::StelScriptWait(QObject* parent)
+	: QObject(parent)
+	, paused(false)
+	, aborted(false)
+	, conditionChecks(0)
+{
+}
+
+StelScriptWait::~StelScriptWait()
+{
+	abort();
+}
+
+bool StelScriptWait::sleep(int ms)
+{
+	if (aborted)
+		return false;
+	if (ms<=0)
+		return true;
+
+	QEventLoop loop;
+	QTimer timer;
+	timer.setSingleShot(true);
+	timer.setTimerType(Qt::PreciseTimer);
+	connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+	timer.start(ms);
+	return run(loop, Q_NULLPTR, false);
+}
+
+bool StelScriptWait::waitUntil(const Condition& done)
+{
+	if (aborted)
+		return false;
+	++conditionChecks;
+	if (done())
+		return true;
+
+	QEventLoop loop;
+	return run(loop, &done, false);
+}
+
+bool StelScriptWait::waitWhilePaused()
+{
+	if (aborted)
+		return false;
+	if (!paused)
+		return true;
+
+	QEventLoop loop;
+	return run(loop, Q_NULLPTR, true);
+}
+
+bool StelScriptWait::run(QEventLoop& loop, const Condition* condition, bool pause)
+{
+	Wait wait = { &loop, condition, pause };
+	waits.append(wait);
+	loop.exec();
+	waits.removeLast();
+	return !aborted;
+}
+
+void StelScriptWait::tick()
+{
+	for (int i=0; i<waits.size(); ++i)
+	{
+		const Wait& wait = waits.at(i);
+		if (!wait.condition)
+			continue;
+		++conditionChecks;
+		if ((*wait.condition)())
+			wait.loop->quit();
+	}
+}
+
+void StelScriptWait::pause()
+{
+	paused = true;
+}
+
+void StelScriptWait::resume()
+{
+	if (!paused)
+		return;
+	paused = false;
+	foreach (const Wait& wait, waits)
+	{
+		if (wait.pause)
+			wait.loop->quit();
+	}
+}
+
+void StelScriptWait::abort()
+{
+	aborted = true;
+	paused = false;
+	foreach (const Wait& wait, waits)
+		wait.loop->quit();
+}
+
+void StelScriptWait::reset()
+{
+	paused = false;
+	aborted = false;
+}
@@ -0,0 +1,100 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _STELSCRIPTWAIT_HPP_
+#define _STELSCRIPTWAIT_HPP_
+
+#include <QObject>
+#include <QVector>
+
+#include <functional>
+
+class QEventLoop;
+
+//! @class StelScriptWait
+//! Suspends the running script until a delay has passed, a condition is met or the script is resumed.
+//! Scripts run in the main thread, so a waiting script runs a nested event loop, in which Stellarium
+//! keeps rendering. The loops are woken by timers, by tick() (called once per frame by the StelScriptMgr),
+//! or by resume() and abort(). They never poll, so a waiting or paused script costs no CPU time.
+//!
+//! Waits can be nested, e.g. when a script is paused while it waits. abort() ends all of them, and all waits
+//! return immediately until reset() is called. This lets a stopped script leave its waits right away.
+class StelScriptWait : public QObject
+{
+	Q_OBJECT
+
+public:
+	typedef std::function<bool()> Condition;
+
+	StelScriptWait(QObject* parent=Q_NULLPTR);
+	~StelScriptWait();
+
+	//! Wait for @param ms milliseconds of wall clock time.
+	//! @return false if the wait was aborted.
+	bool sleep(int ms);
+	//! Wait until @param done returns true. The condition is checked now, and then on each call to tick().
+	//! @return false if the wait was aborted.
+	bool waitUntil(const Condition& done);
+	//! Wait as long as the script is paused. Returns immediately if it is not.
+	//! @return false if the wait was aborted.
+	bool waitWhilePaused();
+
+	//! Whether a script is waiting
+	bool isWaiting() const { return !waits.isEmpty(); }
+	bool isPaused() const { return paused; }
+	bool isAborted() const { return aborted; }
+
+	//! Number of times the condition of a waitUntil() was checked
+	quint64 getConditionChecks() const { return conditionChecks; }
+
+public slots:
+	//! Check the conditions of the running waitUntil() calls. Should be called once per frame.
+	void tick();
+	//! Pause the script. It stops in waitWhilePaused() until resume() or abort() is called.
+	void pause();
+	void resume();
+	//! End all waits. Further waits return false until reset() is called.
+	void abort();
+	//! Prepare for a new script: not paused, not aborted
+	void reset();
+
+private:
+	Q_DISABLE_COPY(StelScriptWait)
+
+	struct Wait
+	{
+		QEventLoop* loop;
+		//! only set for waitUntil()
+		const Condition* condition;
+		//! true for waitWhilePaused()
+		bool pause;
+	};
+
+	//! Run @param loop until it is quit, and return false if the wait was aborted
+	bool run(QEventLoop& loop, const Condition* condition, bool pause);
+
+	//! The running waits, innermost last
+	QVector<Wait> waits;
+	bool paused;
+	bool aborted;
+	quint64 conditionChecks;
+};
+
+#endif // _STELSCRIPTWAIT_HPP_
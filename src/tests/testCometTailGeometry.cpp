@@ -0,0 +1,261 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testCometTailGeometry.hpp"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtMath>
+
+#include <cstdlib>
+
+#include "CometTailGeometry.hpp"
+
+QTEST_GUILESS_MAIN(TestCometTailGeometry)
+
+namespace
+{
+	const int nrOfComets = 500;
+
+	// How Comet computed the tail vertices before: a new paraboloid for each tail, rotated vertex by vertex.
+	void computeParabola(float parameter, float radius, float xOffset, const Mat4d& rotation, QVector<Vec3d>& vertexArr)
+	{
+		const int slices=CometTailGeometry::Slices;
+		const int stacks=CometTailGeometry::Stacks;
+		const float zshift=-0.5f*parameter;
+		if (vertexArr.size() < slices*stacks+1)
+			vertexArr.resize(slices*stacks+1);
+		float xa[2*slices];
+		float ya[2*slices];
+		float da=M_PI/slices;
+		for (int i=0; i<2*slices; ++i)
+		{
+			xa[i]=-sin(i*da);
+			ya[i]=cos(i*da);
+		}
+		vertexArr.replace(0, Vec3d(0.0, 0.0, zshift));
+		int vertexArrIndex=1;
+		for (int ring=1; ring<=stacks; ++ring)
+		{
+			float z=ring*radius/stacks; z=z*z/(2*parameter) + zshift;
+			float xShift= xOffset*z*z;
+			for (int i=ring & 1; i<2*slices; i+=2)
+			{
+				float x=xa[i]*radius*ring/stacks;
+				float y=ya[i]*radius*ring/stacks;
+				vertexArr.replace(vertexArrIndex++, Vec3d(x+xShift, y, z));
+			}
+		}
+		Vec3d* vertices=vertexArr.data();
+		for (int i=0; i<slices*stacks+1; ++i)
+			vertices[i].transfo4d(rotation);
+	}
+
+	double randomUniform(double min, double max)
+	{
+		return min + (max-min)*std::rand()/RAND_MAX;
+	}
+
+	// The tail parameters of a comet, as computed in Comet::update()
+	struct TailParameters
+	{
+		float length;
+		float radius;
+		float velocity;
+		Vec3d direction;
+
+		void randomize()
+		{
+			length=randomUniform(0.01, 1.0);
+			radius=length*randomUniform(0.025, 0.1);
+			velocity=randomUniform(0.005, 0.05);
+			direction.set(randomUniform(-1., 1.), randomUniform(-1., 1.), randomUniform(-1., 1.));
+			direction.normalize();
+		}
+
+		// The comet moves on for some time
+		void advance()
+		{
+			length*=1.001f;
+			radius*=1.0005f;
+			velocity*=0.9995f;
+			direction+=Vec3d(1e-3, -5e-4, 2e-4);
+			direction.normalize();
+		}
+
+		float gasParameter() const { return radius*radius/(2.0f*length); }
+		float dustParameter() const { return radius*radius*1.5f*1.5f/(2.0f*0.4f*length); }
+		float dustRadius() const { return 1.5f*radius; }
+		float dustOffset() const { return 25.0f*velocity; }
+		Mat4d rotation() const
+		{
+			return Mat4d::rotation(Vec3d(0.0, 0.0, 1.0)^direction, std::acos(Vec3d(0.0, 0.0, 1.0).dot(direction)));
+		}
+	};
+}
+
+void TestCometTailGeometry::testMesh()
+{
+	const QVector<unsigned short>& indices=CometTailGeometry::getIndices();
+	const QVector<float>& texCoords=CometTailGeometry::getTexCoords();
+	const int slices=CometTailGeometry::Slices;
+	const int stacks=CometTailGeometry::Stacks;
+	// an inner fan, then two triangles per slice between the rings
+	QCOMPARE(indices.size(), 3*(slices + 2*slices*(stacks-1)));
+	foreach (unsigned short i, indices)
+		QVERIFY(i < CometTailGeometry::VertexCount);
+	QCOMPARE(texCoords.size(), 2*CometTailGeometry::VertexCount);
+	foreach (float t, texCoords)
+		QVERIFY(t>=0.f && t<=1.f);
+
+	CometTailGeometry tail;
+	QVERIFY(!tail.isValid());
+	tail.setShape(0.f, 1.f, 0.f, Mat4d::identity());
+	QVERIFY(!tail.isValid());
+	tail.setShape(0.01f, 0.1f, 0.f, Mat4d::identity());
+	QVERIFY(tail.isValid());
+	QCOMPARE(tail.getUnitVertices().size(), CometTailGeometry::VertexCount);
+}
+
+void TestCometTailGeometry::testShape_data()
+{
+	QTest::addColumn<float>("parameter");
+	QTest::addColumn<float>("radius");
+	QTest::addColumn<float>("xOffset");
+	QTest::addColumn<Vec3d>("direction");
+
+	QTest::newRow("gas tail") << 0.003f << 0.05f << 0.f << Vec3d(1., 0., 0.);
+	QTest::newRow("long gas tail") << 0.0005f << 0.05f << 0.f << Vec3d(0.6, 0.8, 0.);
+	QTest::newRow("dust tail") << 0.007f << 0.075f << 0.7f << Vec3d(0., 0.6, -0.8);
+	QTest::newRow("strongly bent dust tail") << 0.0002f << 0.01f << 1.2f << Vec3d(0.36, 0.48, 0.8);
+	QTest::newRow("short dust tail") << 0.05f << 0.02f << 0.3f << Vec3d(-1., 0., 0.);
+}
+
+void TestCometTailGeometry::testShape()
+{
+	QFETCH(float, parameter);
+	QFETCH(float, radius);
+	QFETCH(float, xOffset);
+	QFETCH(Vec3d, direction);
+
+	direction.normalize();
+	const Mat4d rotation=Mat4d::rotation(Vec3d(0.0, 0.0, 1.0)^direction, std::acos(Vec3d(0.0, 0.0, 1.0).dot(direction)));
+	QVector<Vec3d> expected;
+	computeParabola(parameter, radius, xOffset, rotation, expected);
+
+	CometTailGeometry tail;
+	tail.setShape(parameter, radius, xOffset, rotation);
+	QVERIFY(tail.isValid());
+
+	// The bend is quantised: allow half a percent of the size of the tail
+	const double length=radius*radius/(2.*parameter);
+	const double tolerance=0.005*(radius + length + xOffset*length*length);
+	for (int i=0; i<CometTailGeometry::VertexCount; ++i)
+	{
+		const Vec3d v=tail.getVertex(i);
+		QVERIFY2((v-expected.at(i)).length() <= tolerance,
+			 qPrintable(QString("vertex %1: %2 instead of %3").arg(i).arg(v.toString()).arg(expected.at(i).toString())));
+	}
+}
+
+void TestCometTailGeometry::testSharedMeshes()
+{
+	CometTailGeometry::clearCache();
+	CometTailGeometry a, b;
+	a.setShape(0.003f, 0.05f, 0.f, Mat4d::identity());
+	const quint64 meshes=CometTailGeometry::getMeshCount();
+	// all gas tails have the same unit mesh
+	b.setShape(0.0005f, 0.2f, 0.f, Mat4d::xrotation(1.));
+	QCOMPARE(CometTailGeometry::getMeshCount(), meshes);
+	QVERIFY(a.getUnitVertices().constData()==b.getUnitVertices().constData());
+
+	// a dust tail with a slightly different size but the same shape reuses the mesh
+	a.setShape(0.007f, 0.075f, 0.7f, Mat4d::identity());
+	b.setShape(0.007f*1.001f, 0.075f*1.001f, 0.7f/1.001f, Mat4d::yrotation(0.5));
+	QCOMPARE(CometTailGeometry::getMeshCount(), meshes+1);
+	QVERIFY(a.getUnitVertices().constData()==b.getUnitVertices().constData());
+	// a different bend needs a new mesh
+	b.setShape(0.007f, 0.075f, 0.8f, Mat4d::identity());
+	QCOMPARE(CometTailGeometry::getMeshCount(), meshes+2);
+	QCOMPARE(CometTailGeometry::getCacheSize(), 3);
+
+	// the cache does not grow without bounds
+	for (int i=0; i<2*CometTailGeometry::MaxCacheSize; ++i)
+		a.setShape(0.007f, 0.075f, 0.7f+0.01f*i, Mat4d::identity());
+	QVERIFY(CometTailGeometry::getCacheSize() <= CometTailGeometry::MaxCacheSize);
+	// meshes in use stay valid when the cache is cleared
+	QCOMPARE(b.getUnitVertices().size(), CometTailGeometry::VertexCount);
+}
+
+void TestCometTailGeometry::benchmarkUpdate()
+{
+	// The tails of all comets are updated in every frame, like at high time rates.
+	const int frames=100;
+	std::srand(42);
+	QVector<TailParameters> comets(nrOfComets);
+	for (int i=0; i<nrOfComets; ++i)
+		comets[i].randomize();
+
+	QVector<QVector<Vec3d> > gasVertices(nrOfComets), dustVertices(nrOfComets);
+	QVector<TailParameters> state=comets;
+	QElapsedTimer timer;
+	timer.start();
+	for (int f=0; f<frames; ++f)
+	{
+		for (int i=0; i<nrOfComets; ++i)
+		{
+			TailParameters& c=state[i];
+			c.advance();
+			const Mat4d rotation=c.rotation();
+			computeParabola(c.gasParameter(), c.radius, 0.f, rotation, gasVertices[i]);
+			computeParabola(c.dustParameter(), c.dustRadius(), c.dustOffset(), rotation, dustVertices[i]);
+		}
+	}
+	const double before=timer.nsecsElapsed()*1e-6/frames;
+
+	CometTailGeometry::clearCache();
+	const quint64 meshes=CometTailGeometry::getMeshCount();
+	QVector<CometTailGeometry> gasTails(nrOfComets), dustTails(nrOfComets);
+	state=comets;
+	timer.restart();
+	for (int f=0; f<frames; ++f)
+	{
+		for (int i=0; i<nrOfComets; ++i)
+		{
+			TailParameters& c=state[i];
+			c.advance();
+			const Mat4d rotation=c.rotation();
+			gasTails[i].setShape(c.gasParameter(), c.radius, 0.f, rotation);
+			dustTails[i].setShape(c.dustParameter(), c.dustRadius(), c.dustOffset(), rotation);
+		}
+	}
+	const double after=timer.nsecsElapsed()*1e-6/frames;
+	const quint64 misses=CometTailGeometry::getMeshCount()-meshes;
+
+	qDebug() << QString("%1 comets: tail update %2 ms per frame before, %3 ms after; %4 meshes computed for %5 tails")
+		    .arg(nrOfComets).arg(before, 0, 'f', 3).arg(after, 0, 'f', 3).arg(misses).arg(2*nrOfComets*frames);
+	// Slowly changing tails keep their mesh for many frames
+	QVERIFY(misses < static_cast<quint64>(nrOfComets*frames));
+	for (int i=0; i<nrOfComets; ++i)
+	{
+		QVERIFY(gasTails[i].isValid());
+		QVERIFY(dustTails[i].isValid());
+	}
+}
@@ -43,3 +43,103 @@ void TestExtinction::testBase()
 	extCls.forward(vert, &mag);
 	QVERIFY(mag==2.25);
 }
+
+void TestExtinction::testLookupTable()
+{
+	Extinction extCls;
+	extCls.setExtinctionCoefficient(0.2f);
+	// Avoid the kink of the mirrored airmass at -2 degrees, where the table is only approximate.
+	for (float alt=-90.f; alt<=90.f; alt+=0.25f)
+	{
+		if (qAbs(alt+2.f)<0.1f)
+			continue;
+		Vec3f v(std::cos(alt*M_PI/180.f), 0.f, std::sin(alt*M_PI/180.f));
+		float mag=0.f, magFast=0.f;
+		extCls.forward(v, &mag);
+		extCls.forwardFast(v, &magFast);
+		QVERIFY2(qAbs(mag-magFast)<0.001f, qPrintable(QString("alt=%1 exact=%2 fast=%3").arg(alt).arg(mag).arg(magFast)));
+	}
+}
+
+void TestExtinction::testShading_data()
+{
+	QTest::addColumn<int>("mode");
+	QTest::newRow("underground zero") << static_cast<int>(Extinction::UndergroundExtinctionZero);
+	QTest::newRow("underground max") << static_cast<int>(Extinction::UndergroundExtinctionMax);
+	QTest::newRow("underground mirror") << static_cast<int>(Extinction::UndergroundExtinctionMirror);
+}
+
+void TestExtinction::testShading()
+{
+	QFETCH(int, mode);
+	Extinction extCls;
+	extCls.setExtinctionCoefficient(0.2f);
+	extCls.setUndergroundExtinctionMode(static_cast<Extinction::UndergroundExtinctionMode>(mode));
+	const float factor = 0.3f;
+	const float scale = 0.8f;
+
+	// The vertices are in a frame where the zenith is tilted, like J2000 positions
+	Vec3d zenith(0.3, -0.5, 0.8);
+	zenith.normalize();
+	ExtinctionShading shading;
+	shading.setExtinction(extCls, factor, scale);
+	shading.setZenith(zenith);
+	Vec3d east = Vec3d(0., 0., 1.)^zenith;
+	east.normalize();
+
+	for (float alt=-90.f; alt<=90.f; alt+=0.25f)
+	{
+		const float sinAlt = std::sin(alt*M_PI/180.f);
+		const float cosAlt = std::cos(alt*M_PI/180.f);
+		const Vec3d pos = zenith*sinAlt + east*cosAlt;
+		const float attenuation = shading.getAttenuation(Vec3f(pos[0], pos[1], pos[2]));
+
+		// The exact airmass of the extinction
+		float mag = 0.f;
+		extCls.forward(Vec3f(cosAlt, 0.f, sinAlt), &mag);
+		const float expected = std::pow(factor, mag)*scale;
+		QVERIFY2(qAbs(attenuation-expected)<=0.0001f*expected, qPrintable(QString("alt=%1 shading=%2 expected=%3").arg(alt).arg(attenuation).arg(expected)));
+
+		// The lookup table, which was used for the vertex colors before
+		if (qAbs(alt+2.f)<0.1f)
+			continue;
+		const float expectedFast = std::pow(factor, extCls.getMagnitudeShiftFast(sinAlt))*scale;
+		QVERIFY2(qAbs(attenuation-expectedFast)<=0.002f*expectedFast, qPrintable(QString("alt=%1 shading=%2 table=%3").arg(alt).arg(attenuation).arg(expectedFast)));
+	}
+
+	// The apparent altitude, as with the positions transformed with StelCore::RefractionOn before
+	Refraction refraction;
+	refraction.setPressure(1020.f);
+	refraction.setTemperature(-5.f);
+	shading.setRefraction(refraction);
+	for (float alt=-90.f; alt<=90.f; alt+=0.25f)
+	{
+		const float sinAlt = std::sin(alt*M_PI/180.f);
+		const float cosAlt = std::cos(alt*M_PI/180.f);
+		const Vec3d pos = zenith*sinAlt + east*cosAlt;
+		const float attenuation = shading.getAttenuation(Vec3f(pos[0], pos[1], pos[2]));
+
+		Vec3d apparent(cosAlt, 0., sinAlt);
+		refraction.forward(apparent);
+		apparent.normalize();
+		// Skip where the airmass jumps below the horizon, in the modes without mirroring
+		if (qAbs(apparent[2]+0.035)<0.001)
+			continue;
+		float mag = 0.f;
+		extCls.forward(apparent, &mag);
+		// Compared in magnitudes, because the airmass is steep near the horizon,
+		// where Refraction interpolates its table and the shading uses the formula.
+		const float shadingMag = std::log(attenuation/scale)/std::log(factor);
+		QVERIFY2(qAbs(shadingMag-mag)<=0.01f, qPrintable(QString("alt=%1 shading=%2mag expected=%3mag").arg(alt).arg(shadingMag).arg(mag)));
+	}
+	// Refraction lifts objects near the horizon, so they are less extinct
+	const Vec3d horizon = east;
+	const float refracted = shading.getAttenuation(Vec3f(horizon[0], horizon[1], horizon[2]));
+	ExtinctionShading geometric;
+	geometric.setExtinction(extCls, factor, scale);
+	geometric.setZenith(zenith);
+	QVERIFY(refracted > geometric.getAttenuation(Vec3f(horizon[0], horizon[1], horizon[2])));
+
+	shading.disable();
+	QCOMPARE(shading.getAttenuation(Vec3f(0.f, 0.f, -1.f)), 1.f);
+}
@@ -23,13 +23,17 @@
 #include <QObject>
 #include <QtTest>
 #include "RefractionExtinction.hpp"
+#include "ExtinctionShading.hpp"
 
 class TestExtinction : public QObject
 {
 	Q_OBJECT
 private slots:
 	void initTestCase();
-	void testBase();	
+	void testBase();
+	void testLookupTable();
+	void testShading_data();
+	void testShading();
 };
 
 #endif // _TESTEXTINCTION_HPP_
@@ -0,0 +1,338 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testHeightmap.hpp"
+
+#include "Heightmap.hpp"
+
+#include <QElapsedTimer>
+#include <QtDebug>
+
+#include <cmath>
+#include <limits>
+
+QTEST_GUILESS_MAIN(TestHeightmap)
+
+namespace
+{
+	const float NULL_HEIGHT = -123.0f;
+	const float NO_HEIGHT = -std::numeric_limits<float>::max();
+
+	//! The uniform grid Heightmap used before the BVH, as reference for the results
+	class ReferenceGrid
+	{
+	public:
+		static const int GRID_LENGTH = 60;
+
+		ReferenceGrid(const Heightmap::IdxList& indexList, const Heightmap::PosList& posList)
+			: indexList(indexList), posList(posList), grid(GRID_LENGTH*GRID_LENGTH)
+		{
+			min = Vec2f(std::numeric_limits<float>::max());
+			max = Vec2f(-std::numeric_limits<float>::max());
+			for(int i = 0;i<posList.size();++i)
+			{
+				min[0] = std::min(min[0], posList.at(i)[0]);
+				min[1] = std::min(min[1], posList.at(i)[1]);
+				max[0] = std::max(max[0], posList.at(i)[0]);
+				max[1] = std::max(max[1], posList.at(i)[1]);
+			}
+			range = max - min;
+
+			for(int i = 0;i<this->indexList.size(); i+=3)
+			{
+				const unsigned int* pTriangle = &(this->indexList.at(i));
+				Vec2f triMin(std::numeric_limits<float>::max()), triMax(-std::numeric_limits<float>::max());
+				for(int t=0; t<3; ++t)
+				{
+					const Vec3f& pos = posList.at(pTriangle[t]);
+					triMin[0] = std::min(triMin[0], pos[0]);
+					triMin[1] = std::min(triMin[1], pos[1]);
+					triMax[0] = std::max(triMax[0], pos[0]);
+					triMax[1] = std::max(triMax[1], pos[1]);
+				}
+				triMin = (triMin - min) / range;
+				triMax = (triMax - min) / range;
+				Vec2i minIdx(triMin * GRID_LENGTH);
+				minIdx = minIdx.clamp(Vec2i(0),Vec2i(GRID_LENGTH-1));
+				Vec2i maxIdx(triMax * GRID_LENGTH);
+				maxIdx = maxIdx.clamp(Vec2i(0),Vec2i(GRID_LENGTH-1));
+				for(int y = minIdx[1];y<=maxIdx[1];++y)
+				{
+					for(int x = minIdx[0];x<=maxIdx[0];++x)
+					{
+						Vec2f rectMin = min + (Vec2f(x,y) * range) / GRID_LENGTH;
+						Vec2f rectMax = min + (Vec2f(x+1,y+1) * range) / GRID_LENGTH;
+						const Vec2f t1(posList.at(pTriangle[0]).data());
+						const Vec2f t2(posList.at(pTriangle[1]).data());
+						const Vec2f t3(posList.at(pTriangle[2]).data());
+						if(triangle_intersects_bbox(t1,t2,t3,rectMin,rectMax))
+							grid[y*GRID_LENGTH + x].append(pTriangle);
+					}
+				}
+			}
+		}
+
+		float getHeight(const float x, const float y) const
+		{
+			int ix = (x - min[0]) / (range[0]) * GRID_LENGTH;
+			int iy = (y - min[1]) / (range[1]) * GRID_LENGTH;
+			if ((ix < 0) || (ix >= GRID_LENGTH) || (iy < 0) || (iy >= GRID_LENGTH))
+				return NULL_HEIGHT;
+
+			const QVector<const unsigned int*>& faces = grid.at(iy*GRID_LENGTH + ix);
+			float h = NO_HEIGHT;
+			for(int i=0; i<faces.size(); ++i)
+			{
+				float face_h = face_height_at(faces[i], x, y);
+				if(face_h > h)
+					h = face_h;
+			}
+			return h == NO_HEIGHT ? NULL_HEIGHT : h;
+		}
+
+	private:
+		float face_height_at(const unsigned int* pTriangle, const float x, const float y) const
+		{
+			const Vec3f& pVertex0 = posList.at(pTriangle[0]);
+			const Vec3f& pVertex1 = posList.at(pTriangle[1]);
+			const Vec3f& pVertex2 = posList.at(pTriangle[2]);
+			float l1,l2,l3;
+			cartesian_to_barycentric(Vec2f(pVertex0.data()),Vec2f(pVertex1.data()),Vec2f(pVertex2.data()), Vec2f(x,y), &l1, &l2, &l3);
+			if ((l1 < 0) || (l2 < 0) || (l3 < 0))
+				return NO_HEIGHT;
+			return l1*pVertex0[2] + l2*pVertex1[2] + l3*pVertex2[2];
+		}
+
+		static void cartesian_to_barycentric(const Vec2f &t1, const Vec2f &t2, const Vec2f &t3, const Vec2f &p, float *l1, float *l2, float *l3)
+		{
+			float det_T = (t2[1]-t3[1]) * (t1[0]-t3[0]) + (t3[0]-t2[0]) * (t1[1]-t3[1]);
+			*l1 = ((t2[1]-t3[1]) * (p[0]-t3[0]) + (t3[0]-t2[0]) * (p[1]-t3[1]))/det_T;
+			*l2 = ((t3[1]-t1[1]) * (p[0]-t3[0]) + (t1[0]-t3[0]) * (p[1]-t3[1]))/det_T;
+			*l3 = 1.0f - *l1 - *l2;
+		}
+
+		static bool triangle_intersects_bbox(const Vec2f& t1, const Vec2f& t2, const Vec2f& t3, const Vec2f& rMin, const Vec2f& rMax)
+		{
+			if(t1[0]>=rMin[0] && t1[0]<=rMax[0] && t1[1]>=rMin[1] && t1[1]<=rMax[1])
+				return true;
+			float l1,l2,l3;
+			cartesian_to_barycentric(t1,t2,t3,rMin,&l1,&l2,&l3);
+			if ((l1 >= 0) && (l2 >= 0) && (l3 >= 0))
+				return true;
+			return line_intersects_triangle(t1,t2,t3,rMin,Vec2f(rMin[0],rMax[1]))
+				|| line_intersects_triangle(t1,t2,t3,rMin,Vec2f(rMax[0],rMin[1]))
+				|| line_intersects_triangle(t1,t2,t3,rMax,Vec2f(rMin[0],rMax[1]))
+				|| line_intersects_triangle(t1,t2,t3,rMax,Vec2f(rMax[0],rMin[1]));
+		}
+
+		static bool sameSide(const Vec2f &p, const Vec2f &q, const Vec2f &a, const Vec2f &b)
+		{
+			float z1 = (b[0] - a[0]) * (p[1] - a[1]) - (p[0] - a[0]) * (b[1] - a[1]);
+			float z2 = (b[0] - a[0]) * (q[1] - a[1]) - (q[0] - a[0]) * (b[1] - a[1]);
+			return z1 * z2 > .0f;
+		}
+
+		static bool line_intersects_triangle(const Vec2f &t0, const Vec2f &t1, const Vec2f &t2, const Vec2f &p0, const Vec2f &p1)
+		{
+			if (sameSide(t0, t1, p0, p1) && sameSide(t0, t2, p0, p1)) return false;
+			if (!sameSide(p0, t2, t0, t1) && !sameSide(p1, t2, t0, t1)) return false;
+			if (!sameSide(p0, t0, t1, t2) && !sameSide(p1, t0, t1, t2)) return false;
+			if (!sameSide(p0, t1, t2, t0) && !sameSide(p1, t1, t2, t0)) return false;
+			return true;
+		}
+
+		Heightmap::IdxList indexList;
+		Heightmap::PosList posList;
+		QVector<QVector<const unsigned int*> > grid;
+		Vec2f min, max, range;
+	};
+
+	//! Vertices of the generated terrain per side
+	const int TERRAIN_SIZE = 250;
+	//! Extent of the terrain in x and y
+	const float TERRAIN_EXTENT = 1000.0f;
+
+	//! Maps the grid coordinate so that the vertices get much denser towards the center,
+	//! like a terrain model with a detailed scene in the middle
+	float warp(int i)
+	{
+		const float u = 2.0f * i / (TERRAIN_SIZE - 1) - 1.0f;
+		return 0.5f * TERRAIN_EXTENT * u * u * u;
+	}
+
+	//! Generates a hilly terrain with a dense center, a bridge above part of it,
+	//! and some vertical walls which can never be hit
+	void makeTerrain(Heightmap::IdxList& indices, Heightmap::PosList& positions)
+	{
+		for(int y = 0; y<TERRAIN_SIZE; ++y)
+		{
+			for(int x = 0; x<TERRAIN_SIZE; ++x)
+			{
+				const float px = warp(x);
+				const float py = warp(y);
+				positions.append(Vec3f(px, py, 20.0f * std::sin(px*0.01f) * std::cos(py*0.013f) + 0.00002f*px*py));
+			}
+		}
+		for(int y = 0; y<TERRAIN_SIZE-1; ++y)
+		{
+			for(int x = 0; x<TERRAIN_SIZE-1; ++x)
+			{
+				const unsigned int i = y*TERRAIN_SIZE + x;
+				indices << i << i+1 << i+TERRAIN_SIZE;
+				indices << i+1 << i+TERRAIN_SIZE+1 << i+TERRAIN_SIZE;
+			}
+		}
+
+		//a bridge crossing the center, which overlaps the terrain
+		const unsigned int bridge = positions.size();
+		positions << Vec3f(-300.0f, -5.0f, 40.0f) << Vec3f(300.0f, -5.0f, 45.0f) << Vec3f(300.0f, 5.0f, 45.0f) << Vec3f(-300.0f, 5.0f, 40.0f);
+		indices << bridge << bridge+1 << bridge+2 << bridge << bridge+2 << bridge+3;
+
+		//walls along the bridge
+		const unsigned int wall = positions.size();
+		positions << Vec3f(-300.0f, -5.0f, 0.0f) << Vec3f(300.0f, -5.0f, 0.0f) << Vec3f(300.0f, -5.0f, 50.0f) << Vec3f(-300.0f, -5.0f, 50.0f);
+		indices << wall << wall+1 << wall+2 << wall << wall+2 << wall+3;
+	}
+
+	//! Random sample points, some of them outside the terrain
+	void makePoints(int count, QVector<float>& x, QVector<float>& y)
+	{
+		qsrand(42);
+		x.resize(count);
+		y.resize(count);
+		for(int i = 0; i<count; ++i)
+		{
+			x[i] = (qrand() / float(RAND_MAX) - 0.5f) * TERRAIN_EXTENT * 1.1f;
+			y[i] = (qrand() / float(RAND_MAX) - 0.5f) * TERRAIN_EXTENT * 1.1f;
+		}
+	}
+
+	Heightmap::IdxList terrainIndices;
+	Heightmap::PosList terrainPositions;
+}
+
+void TestHeightmap::initTestCase()
+{
+	makeTerrain(terrainIndices, terrainPositions);
+}
+
+void TestHeightmap::testHeights()
+{
+	Heightmap heightmap;
+	heightmap.setMeshData(terrainIndices, terrainPositions);
+	heightmap.setNullHeight(NULL_HEIGHT);
+	ReferenceGrid reference(terrainIndices, terrainPositions);
+
+	QVector<float> x, y;
+	makePoints(20000, x, y);
+	//points in the dense center, and on the bridge
+	for(int i = 0; i<2000; ++i)
+	{
+		x.append(x.at(i) * 0.02f);
+		y.append(y.at(i) * 0.02f);
+	}
+
+	int outside = 0;
+	int onBridge = 0;
+	for(int i = 0; i<x.size(); ++i)
+	{
+		const float expected = reference.getHeight(x.at(i), y.at(i));
+		const float h = heightmap.getHeight(x.at(i), y.at(i));
+		if(qAbs(h - expected) > 1e-4f)
+			QFAIL(qPrintable(QString("Height at %1/%2 is %3, expected %4").arg(x.at(i)).arg(y.at(i)).arg(h).arg(expected)));
+		if(h == NULL_HEIGHT)
+			++outside;
+		else if(h >= 40.0f)
+			++onBridge;
+	}
+	QVERIFY(outside > 0);
+	QVERIFY(onBridge > 0);
+
+	//the null height is returned without mesh too
+	Heightmap empty;
+	empty.setNullHeight(NULL_HEIGHT);
+	QCOMPARE(empty.getHeight(0.0f, 0.0f), NULL_HEIGHT);
+}
+
+void TestHeightmap::testBatch()
+{
+	Heightmap heightmap;
+	heightmap.setMeshData(terrainIndices, terrainPositions);
+	heightmap.setNullHeight(NULL_HEIGHT);
+
+	//one batch below and one above the parallel threshold
+	const int counts[] = { 100, 50000 };
+	for(int c = 0; c<2; ++c)
+	{
+		QVector<float> x, y;
+		makePoints(counts[c], x, y);
+		QVector<float> heights(x.size());
+		heightmap.getHeights(x.constData(), y.constData(), heights.data(), x.size());
+		for(int i = 0; i<x.size(); ++i)
+			QCOMPARE(heights.at(i), heightmap.getHeight(x.at(i), y.at(i)));
+	}
+}
+
+void TestHeightmap::benchmarkQueries_data()
+{
+	QTest::addColumn<int>("mode");
+	QTest::newRow("uniform grid") << 0;
+	QTest::newRow("bvh") << 1;
+	QTest::newRow("bvh batch") << 2;
+}
+
+void TestHeightmap::benchmarkQueries()
+{
+	QFETCH(int, mode);
+
+	Heightmap heightmap;
+	heightmap.setMeshData(terrainIndices, terrainPositions);
+	heightmap.setNullHeight(NULL_HEIGHT);
+	ReferenceGrid reference(terrainIndices, terrainPositions);
+
+	//a walk through the dense center
+	const int count = 20000;
+	QVector<float> x(count), y(count), heights(count);
+	for(int i = 0; i<count; ++i)
+	{
+		x[i] = -50.0f + 100.0f * i / count;
+		y[i] = 30.0f * std::sin(i * 0.001f);
+	}
+
+	QElapsedTimer timer;
+	qint64 queries = 0;
+	timer.start();
+	QBENCHMARK
+	{
+		if(mode == 0)
+		{
+			for(int i = 0; i<count; ++i)
+				heights[i] = reference.getHeight(x.at(i), y.at(i));
+		}
+		else if(mode == 1)
+		{
+			for(int i = 0; i<count; ++i)
+				heights[i] = heightmap.getHeight(x.at(i), y.at(i));
+		}
+		else
+			heightmap.getHeights(x.constData(), y.constData(), heights.data(), count);
+		queries += count;
+	}
+	qDebug() << qRound64(queries / (timer.nsecsElapsed() / 1e9)) << "queries/s";
+}
@@ -0,0 +1,243 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testMeteorPool.hpp"
+
+#include <QElapsedTimer>
+#include <QtMath>
+
+#include <cstdlib>
+#include <new>
+
+#include "MeteorPool.hpp"
+
+QTEST_GUILESS_MAIN(TestMeteorPool)
+
+// Count the allocations done with operator new, which is how meteors used to be created
+static quint64 allocationCount = 0;
+
+void* operator new(std::size_t size)
+{
+	++allocationCount;
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) Q_DECL_NOTHROW
+{
+	std::free(p);
+}
+
+namespace
+{
+	const Vec3d zenith(0., 0., 1.);
+
+	QList<MeteorPool::ColorPair> whiteColors()
+	{
+		return QList<MeteorPool::ColorPair>() << MeteorPool::ColorPair("white", 100);
+	}
+
+	float randomUnit()
+	{
+		return (float) qrand() / ((float) RAND_MAX + 1);
+	}
+
+	//! A random radiant above the horizon, like the sporadic meteors
+	Vec3d randomRadiant()
+	{
+		const double alt = M_PI_2 * randomUnit();
+		const double az = 2 * M_PI * randomUnit();
+		return Vec3d(qCos(alt)*qCos(az), qCos(alt)*qSin(az), qSin(alt));
+	}
+}
+
+void TestMeteorPool::testSpawn()
+{
+	MeteorPool pool(16);
+	QCOMPARE(pool.getCapacity(), 16);
+	QCOMPARE(pool.getActiveCount(), 0);
+
+	// Meteors with the radiant at the zenith are always visible
+	const int slot = pool.spawn(zenith, 40.f, 0.8f, whiteColors());
+	QVERIFY(slot >= 0 && slot < 16);
+	QCOMPARE(pool.getActiveCount(), 1);
+	QVERIFY(pool.getAbsMag(slot) > 0.f && pool.getAbsMag(slot) <= 0.8f);
+
+	// No meteors from a radiant below the horizon, without luminance or colors
+	QCOMPARE(pool.spawn(Vec3d(1., 0., -0.5), 40.f, 0.8f, whiteColors()), -1);
+	QCOMPARE(pool.spawn(zenith, 40.f, 0.f, whiteColors()), -1);
+	QCOMPARE(pool.spawn(zenith, 40.f, 0.8f, QList<MeteorPool::ColorPair>()), -1);
+	QCOMPARE(pool.getActiveCount(), 1);
+
+	pool.clear();
+	QCOMPARE(pool.getActiveCount(), 0);
+}
+
+void TestMeteorPool::testCapacity()
+{
+	MeteorPool pool(8);
+	QList<int> slots;
+	for (int i = 0; i < 8; ++i)
+	{
+		const int slot = pool.spawn(zenith, 30.f, 0.5f, whiteColors());
+		QVERIFY(slot >= 0 && slot < 8);
+		QVERIFY(!slots.contains(slot));
+		slots << slot;
+	}
+	QCOMPARE(pool.getActiveCount(), 8);
+
+	// The pool is full
+	QCOMPARE(pool.spawn(zenith, 30.f, 0.5f, whiteColors()), -1);
+	QCOMPARE(pool.getDroppedCount(), Q_UINT64_C(1));
+	QCOMPARE(pool.getActiveCount(), 8);
+}
+
+void TestMeteorPool::testUpdate()
+{
+	MeteorPool pool(32);
+	for (int i = 0; i < 10; ++i)
+		QVERIFY(pool.spawn(zenith, 40.f, 0.8f, whiteColors()) >= 0);
+
+	// Burning meteors stay alive for a while
+	pool.update(0.1, true);
+	QCOMPARE(pool.getActiveCount(), 10);
+
+	// When the time does not run at real time speed, meteors fade out in at most half a second
+	for (int i = 0; i < 6; ++i)
+		pool.update(0.1, false);
+	QCOMPARE(pool.getActiveCount(), 0);
+
+	// The slots of dead meteors are reused
+	for (int i = 0; i < 10; ++i)
+	{
+		const int slot = pool.spawn(zenith, 40.f, 0.8f, whiteColors());
+		QVERIFY(slot >= 0 && slot < 10);
+	}
+	QCOMPARE(pool.getActiveCount(), 10);
+}
+
+void TestMeteorPool::testGeometry()
+{
+	MeteorPool pool(8);
+	const QList<MeteorPool::ColorPair> red = QList<MeteorPool::ColorPair>() << MeteorPool::ColorPair("red", 100);
+	for (int i = 0; i < 3; ++i)
+		QVERIFY(pool.spawn(zenith, 40.f, 0.8f, red) >= 0);
+	pool.update(0.1, true);
+	QCOMPARE(pool.getActiveCount(), 3);
+
+	pool.buildGeometry(0.1f, 0.3f);
+	// 3 strips of 2*Segments vertices and 2 joining vertices per train, Segments-1 lines, and a strip of 6 vertices per bolide
+	QCOMPARE(pool.getTrainVertices().size(), 3*3*(2*MeteorPool::Segments+2));
+	QCOMPARE(pool.getTrainColors().size(), pool.getTrainVertices().size());
+	QCOMPARE(pool.getLineVertices().size(), 3*2*(MeteorPool::Segments-1));
+	QCOMPARE(pool.getLineColors().size(), pool.getLineVertices().size());
+	QCOMPARE(pool.getBolideVertices().size(), 3*6);
+	QCOMPARE(pool.getBolideColors().size(), pool.getBolideVertices().size());
+	QCOMPARE(pool.getBolideTexCoords().size(), pool.getBolideVertices().size());
+
+	// The train fades from the meteor to its end
+	const QVector<Vec4f>& lineColors = pool.getLineColors();
+	const Vec4f expected = MeteorPool::getColorFromName("red");
+	for (int m = 0; m < 3; ++m)
+	{
+		const Vec4f& tail = lineColors.at(m*2*(MeteorPool::Segments-1));
+		const Vec4f& head = lineColors.at((m+1)*2*(MeteorPool::Segments-1)-1);
+		QCOMPARE(tail[3], 0.f);
+		QVERIFY(head[3] > 0.f && head[3] <= 1.f);
+		QCOMPARE(head[0], expected[0]);
+		QCOMPARE(head[1], expected[1]);
+		QCOMPARE(head[2], expected[2]);
+	}
+
+	// With the radiant at the zenith, all meteors are above the horizon
+	foreach (const Vec3d& v, pool.getLineVertices())
+		QVERIFY(v[2] > 0.);
+
+	// No prism and no bolide at wide fields of view
+	pool.buildGeometry(0.f, 0.f);
+	QVERIFY(pool.getTrainVertices().isEmpty());
+	QVERIFY(pool.getBolideVertices().isEmpty());
+	QCOMPARE(pool.getLineVertices().size(), 3*2*(MeteorPool::Segments-1));
+}
+
+void TestMeteorPool::benchmarkZhr10000()
+{
+	// Run 10 minutes of a ZHR 10000 shower at 60 frames per second, like SporadicMeteorMgr::update() does
+	const int zhr = 10000;
+	const double deltaTime = 1./60.;
+	const int warmupFrames = 60*60;
+	const int frames = 10*60*60;
+	const QList<MeteorPool::ColorPair> colors = QList<MeteorPool::ColorPair>()
+			<< MeteorPool::ColorPair("white", 80) << MeteorPool::ColorPair("orangeYellow", 20);
+
+	MeteorPool pool;
+	quint64 poolAllocations = 0;
+	quint64 geometryAllocations = 0;
+	qint64 activeSum = 0;
+	qint64 elapsedNs = 0;
+	const Vec3d* trainData = Q_NULLPTR;
+	QElapsedTimer timer;
+	for (int frame = 0; frame < warmupFrames+frames; ++frame)
+	{
+		const bool measured = frame >= warmupFrames;
+		const quint64 allocationsBefore = allocationCount;
+		timer.start();
+
+		pool.update(deltaTime, true);
+
+		// average meteors per frame
+		float mpf = zhr * deltaTime / 3600.f;
+		// maximum amount of meteors for the current frame
+		int maxMpf = qMax(qRound(mpf), 1);
+		float rate = mpf / (float) maxMpf;
+		for (int i = 0; i < maxMpf; ++i)
+		{
+			if (randomUnit() < rate)
+				pool.spawn(randomRadiant(), 11.f + 61.f*randomUnit(), randomUnit(), colors);
+		}
+
+		const quint64 allocationsAfterUpdate = allocationCount;
+		pool.buildGeometry(0.05f, 0.15f);
+		const qint64 ns = timer.nsecsElapsed();
+
+		if (measured)
+		{
+			elapsedNs += ns;
+			activeSum += pool.getActiveCount();
+			poolAllocations += allocationsAfterUpdate - allocationsBefore;
+			geometryAllocations += allocationCount - allocationsAfterUpdate;
+			// The vertex arrays only grow when more meteors are alive than ever before
+			if (pool.getTrainVertices().constData() != trainData)
+				++geometryAllocations;
+		}
+		trainData = pool.getTrainVertices().constData();
+	}
+
+	qDebug() << QString("ZHR %1: %2 meteors alive on average, %3 allocations per frame (%4 while building the geometry), %5 us per frame")
+		    .arg(zhr).arg((double)activeSum/frames, 0, 'f', 1)
+		    .arg((double)(poolAllocations+geometryAllocations)/frames, 0, 'g', 3)
+		    .arg((double)geometryAllocations/frames, 0, 'g', 3)
+		    .arg(elapsedNs/1000./frames, 0, 'f', 2);
+	QVERIFY(activeSum > 0);
+	QCOMPARE(poolAllocations, Q_UINT64_C(0));
+	QCOMPARE(pool.getDroppedCount(), Q_UINT64_C(0));
+}
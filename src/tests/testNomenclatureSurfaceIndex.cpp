@@ -0,0 +1,218 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testNomenclatureSurfaceIndex.hpp"
+
+#include <QObject>
+#include <QtDebug>
+#include <QTest>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "NomenclatureSurfaceIndex.hpp"
+#include "StelGeodesicGrid.hpp"
+
+QTEST_GUILESS_MAIN(TestNomenclatureSurfaceIndex)
+
+namespace
+{
+	// Distances in km
+	const double moonRadius = 1737.4;
+	const double moonDistance = 384400.;
+
+	double randomValue()
+	{
+		return static_cast<double>(qrand())/RAND_MAX;
+	}
+
+	Vec3d randomDirection()
+	{
+		const double lon = 2.*M_PI*randomValue();
+		const double lat = std::asin(2.*randomValue()-1.);
+		return Vec3d(std::cos(lat)*std::cos(lon), std::cos(lat)*std::sin(lon), std::sin(lat));
+	}
+
+	//! Features with sizes between 1 and 3000 km, most of them small like the craters of the Moon
+	void addRandomFeatures(NomenclatureSurfaceIndex& index, QVector<Vec3d>& positions, QVector<float>& sizes, int count)
+	{
+		for (int i=0;i<count;i++)
+		{
+			positions << randomDirection();
+			sizes << static_cast<float>(std::pow(3000., randomValue()*randomValue()));
+			QCOMPARE(index.addFeature(positions.last(), sizes.last()), i);
+		}
+		index.build();
+	}
+
+	Mat4d randomRotation()
+	{
+		return Mat4d::zrotation(2.*M_PI*randomValue()) * Mat4d::xrotation(M_PI*randomValue()) * Mat4d::zrotation(2.*M_PI*randomValue());
+	}
+
+	//! The features which are really visible, found by transforming all of them
+	QVector<int> visibleFeatures(const QVector<Vec3d>& positions, const QVector<float>& sizes, const Mat4d& rotation,
+				     const Vec3d& center, double radius, const SphericalCap& viewport, float minSize)
+	{
+		QVector<int> result;
+		for (int i=0;i<positions.size();i++)
+		{
+			if (sizes.at(i)<minSize)
+				continue;
+			const Vec3d pos = center + rotation.multiplyWithoutTranslation(positions.at(i))*radius;
+			if (pos.length()>center.length() || !viewport.contains(pos/pos.length()))
+				continue;
+			result << i;
+		}
+		return result;
+	}
+}
+
+void TestNomenclatureSurfaceIndex::testBuild()
+{
+	qsrand(1);
+	NomenclatureSurfaceIndex index;
+	QCOMPARE(index.getFeatureCount(), 0);
+	QCOMPARE(index.getZoneCount(), 0);
+
+	QVector<Vec3d> positions;
+	QVector<float> sizes;
+	addRandomFeatures(index, positions, sizes, 5000);
+	QCOMPARE(index.getFeatureCount(), 5000);
+	QVERIFY(index.getZoneCount()>0);
+	QVERIFY(index.getZoneCount()<=StelGeodesicGrid::nrOfZones(NomenclatureSurfaceIndex::GridLevel));
+
+	// An observer far away sees one half of the body, and with no size limit every feature there is examined
+	const Vec3d center(1e9, 0., 0.);
+	QVector<int> result;
+	const int examined = index.findVisible(Mat4d::identity(), center, moonRadius, SphericalCap(Vec3d(1.,0.,0.), -1.), 0.f, result);
+	std::sort(result.begin(), result.end());
+	QCOMPARE(result, visibleFeatures(positions, sizes, Mat4d::identity(), center, moonRadius, SphericalCap(Vec3d(1.,0.,0.), -1.), 0.f));
+	QVERIFY(examined<index.getFeatureCount());
+
+	index.clear();
+	QCOMPARE(index.getFeatureCount(), 0);
+	QCOMPARE(index.getZoneCount(), 0);
+	result.clear();
+	QCOMPARE(index.findVisible(Mat4d::identity(), center, moonRadius, SphericalCap(Vec3d(1.,0.,0.), -1.), 0.f, result), 0);
+	QVERIFY(result.isEmpty());
+}
+
+void TestNomenclatureSurfaceIndex::testFindVisible_data()
+{
+	QTest::addColumn<double>("distance");
+	QTest::addColumn<double>("fov");
+	QTest::addColumn<double>("offset");
+	QTest::addColumn<float>("minSize");
+	// offset is the angle between the center of the body and the center of the viewport, in radii of the body
+	QTest::newRow("whole Moon") << moonDistance << 2. << 0. << 0.f;
+	QTest::newRow("Moon limb") << moonDistance << 0.1 << 0.95 << 0.f;
+	QTest::newRow("beside the Moon") << moonDistance << 0.2 << 1.5 << 0.f;
+	QTest::newRow("large features") << moonDistance << 0.5 << 0.3 << 100.f;
+	QTest::newRow("low orbit") << 1.1*moonRadius << 40. << 0.2 << 0.f;
+	QTest::newRow("wide field") << 10.*moonRadius << 200. << 0. << 10.f;
+}
+
+void TestNomenclatureSurfaceIndex::testFindVisible()
+{
+	QFETCH(double, distance);
+	QFETCH(double, fov);
+	QFETCH(double, offset);
+	QFETCH(float, minSize);
+	qsrand(2);
+
+	NomenclatureSurfaceIndex index;
+	QVector<Vec3d> positions;
+	QVector<float> sizes;
+	addRandomFeatures(index, positions, sizes, 10000);
+
+	for (int i=0;i<20;i++)
+	{
+		const Mat4d rotation = randomRotation();
+		const Vec3d dir = randomDirection();
+		const Vec3d center = dir*distance;
+		// the viewport is offset in a random direction perpendicular to the body
+		Vec3d side = dir^randomDirection();
+		side.normalize();
+		Vec3d viewDir = dir + side*std::tan(offset*std::asin(moonRadius/distance));
+		viewDir.normalize();
+		const SphericalCap viewport(viewDir, std::cos(0.5*fov*M_PI/180.));
+
+		QVector<int> result;
+		const int examined = index.findVisible(rotation, center, moonRadius, viewport, minSize, result);
+		QVERIFY(examined>=result.size());
+		const QVector<int> expected = visibleFeatures(positions, sizes, rotation, center, moonRadius, viewport, minSize);
+		foreach (int feature, expected)
+			QVERIFY(result.contains(feature));
+		// the index does not check the viewport for each feature, but all others conditions
+		foreach (int feature, result)
+		{
+			QVERIFY(sizes.at(feature)>=minSize);
+			const Vec3d pos = center + rotation.multiplyWithoutTranslation(positions.at(feature))*moonRadius;
+			QVERIFY(pos.length()<=center.length()*(1.+1e-12));
+		}
+	}
+}
+
+void TestNomenclatureSurfaceIndex::benchmarkZoomOnMoon_data()
+{
+	QTest::addColumn<double>("fov");
+	QTest::newRow("fov 1") << 1.;
+	QTest::newRow("fov 0.3") << 0.3;
+	QTest::newRow("fov 0.1") << 0.1;
+	QTest::newRow("fov 0.03") << 0.03;
+	QTest::newRow("fov 0.01") << 0.01;
+}
+
+void TestNomenclatureSurfaceIndex::benchmarkZoomOnMoon()
+{
+	QFETCH(double, fov);
+	qsrand(3);
+
+	// About as many features as the Moon has in the nomenclature file
+	NomenclatureSurfaceIndex index;
+	QVector<Vec3d> positions;
+	QVector<float> sizes;
+	addRandomFeatures(index, positions, sizes, 9000);
+
+	// Zoom on a point between the center and the limb of the Moon, with a viewport 1000 pixels wide.
+	// Labels are drawn for features larger than 50 pixels, as in NomenclatureMgr.
+	const Mat4d rotation = randomRotation();
+	const Vec3d center(moonDistance, 0., 0.);
+	Vec3d viewDir(moonDistance, 0.5*moonRadius, 0.3*moonRadius);
+	viewDir.normalize();
+	const SphericalCap viewport(viewDir, std::cos(0.5*fov*M_PI/180.));
+	const double minAngularSize = 50.*fov*M_PI/180./1000.;
+	const float minSize = std::tan(minAngularSize)*(moonDistance-moonRadius);
+
+	QVector<int> result;
+	int examined = 0;
+	QBENCHMARK
+	{
+		result.clear();
+		examined = index.findVisible(rotation, center, moonRadius, viewport, minSize, result);
+	}
+	const int visible = visibleFeatures(positions, sizes, rotation, center, moonRadius, viewport, minSize).size();
+	qDebug() << "features:" << index.getFeatureCount() << "examined:" << examined << "returned:" << result.size() << "visible:" << visible;
+	QVERIFY(result.size()>=visible);
+	// The far side and the small features are not looked at
+	QVERIFY(examined<index.getFeatureCount()/2);
+}
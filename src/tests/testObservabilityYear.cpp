@@ -0,0 +1,229 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testObservabilityYear.hpp"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSignalSpy>
+
+#include "ObservabilityYear.hpp"
+#include "vsop87.h"
+
+QTEST_GUILESS_MAIN(TestObservabilityYear)
+
+namespace
+{
+	const int EMB = 2;
+	const int Mars = 3;
+	const int Jupiter = 4;
+
+	// The planetary theory is not reentrant, like in EphemWrapper
+	QMutex vsop87Mutex;
+
+	Vec3d vsop87Pos(int body, double jde)
+	{
+		QMutexLocker locker(&vsop87Mutex);
+		Vec3d pos;
+		GetVsop87Coor(jde, body, pos);
+		return pos;
+	}
+
+	ObservabilityYear::PositionFunc bodyPos(int body)
+	{
+		return [body](double jde) { return vsop87Pos(body, jde); };
+	}
+
+	const Mat4d matVsop87ToJ2000 = (Mat4d::xrotation(-23.4392803055555555556*(M_PI/180)) * Mat4d::zrotation(0.0000275*(M_PI/180))).transpose();
+	// Precession of some years, the exact value does not matter here
+	const Mat4d matJ2000ToEquinoxEqu = Mat4d::zrotation(0.0012) * Mat4d::xrotation(0.0005) * Mat4d::zrotation(0.0013);
+
+	ObservabilityYear::Input input2018(int planet)
+	{
+		ObservabilityYear::Input input;
+		const double jan1st = 2458119.5; // 2018-01-01 0h UT
+		for (int i=0; i<365; i++)
+			input.days.append(qMakePair(jan1st+i, jan1st+i+69.184/86400.));
+		input.matVsop87ToEquinoxEqu = matJ2000ToEquinoxEqu*matVsop87ToJ2000;
+		input.latitude = 57.4*M_PI/180.;
+		input.horizonAltitude = -0.5*M_PI/180.;
+		input.earthPos = bodyPos(EMB);
+		if (planet>=0)
+			input.planetPos = bodyPos(planet);
+		return input;
+	}
+
+	//! A body whose position is moved to the computed date, like a Planet
+	struct LiveBody
+	{
+		LiveBody(int id) : id(id) {}
+		void computePosition(double jde) { pos = vsop87Pos(id, jde); }
+		Vec3d getHeliocentricEclipticPos() const { return pos; }
+		int id;
+		Vec3d pos;
+	};
+
+	//! The serial computation the Observability plugin did before the scan moved to a worker thread
+	//! (updateSunData() and updatePlanetData()).
+	ObservabilityYear::Result serialScan(const ObservabilityYear::Input& input, int planetId)
+	{
+		ObservabilityYear::Result r;
+		const int nDays = input.days.size();
+		LiveBody earth(EMB), planet(planetId);
+		r.hasPlanet = planetId>=0;
+		for (int i=0; i<nDays; i++)
+		{
+			const double jde = input.days.at(i).second;
+			earth.computePosition(jde);
+			const Vec3d pos = earth.getHeliocentricEclipticPos();
+			const Vec3d sunPos = matJ2000ToEquinoxEqu*(matVsop87ToJ2000*(-pos));
+			double ra, dec;
+			ObservabilityYear::toRADec(sunPos, ra, dec);
+			r.earthPos.append(-pos);
+			r.sunRA.append(ra);
+			r.sunDec.append(dec);
+
+			if (r.hasPlanet)
+			{
+				planet.computePosition(jde);
+				const Vec3d pos1 = planet.getHeliocentricEclipticPos();
+				const Mat4d locTrans = matVsop87ToJ2000*Mat4d::translation(-pos);
+				ObservabilityYear::toRADec(matJ2000ToEquinoxEqu*(locTrans*pos1), ra, dec);
+				const double h = ObservabilityYear::calculateHourAngle(input.latitude, input.horizonAltitude, dec);
+				r.objectRA.append(ra);
+				r.objectDec.append(dec);
+				r.objectH0.append(h);
+				r.objectSidT[0].append(ObservabilityYear::toUnsignedRA(ra-h));
+				r.objectSidT[1].append(ObservabilityYear::toUnsignedRA(ra+h));
+			}
+		}
+		r.complete = true;
+		return r;
+	}
+
+	bool fuzzyCompare(const QVector<double>& a, const QVector<double>& b, double tolerance)
+	{
+		if (a.size()!=b.size())
+			return false;
+		for (int i=0; i<a.size(); ++i)
+		{
+			if (qAbs(a.at(i)-b.at(i))>tolerance)
+			{
+				qWarning() << "day" << i << a.at(i) << b.at(i);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// RA in hours and angles in radians. VSOP87 interpolates its elements between dates which depend
+	// on the previous calls, so results are only equal within a few milliarcseconds.
+	const double tolerance = 1e-7;
+
+	void compareResults(const ObservabilityYear::Result& r, const ObservabilityYear::Result& expected)
+	{
+		QVERIFY(r.complete);
+		QCOMPARE(r.hasPlanet, expected.hasPlanet);
+		QVERIFY(fuzzyCompare(r.sunRA, expected.sunRA, tolerance));
+		QVERIFY(fuzzyCompare(r.sunDec, expected.sunDec, tolerance));
+		QCOMPARE(r.earthPos.size(), expected.earthPos.size());
+		for (int i=0; i<r.earthPos.size(); ++i)
+			QVERIFY((r.earthPos.at(i)-expected.earthPos.at(i)).length()<1e-9);
+		QVERIFY(fuzzyCompare(r.objectRA, expected.objectRA, tolerance));
+		QVERIFY(fuzzyCompare(r.objectDec, expected.objectDec, tolerance));
+		QVERIFY(fuzzyCompare(r.objectH0, expected.objectH0, tolerance));
+		// Sidereal times near 0h may wrap to 24h
+		for (int k=0; k<2; ++k)
+		{
+			QCOMPARE(r.objectSidT[k].size(), expected.objectSidT[k].size());
+			for (int i=0; i<r.objectSidT[k].size(); ++i)
+			{
+				const double d = qAbs(r.objectSidT[k].at(i)-expected.objectSidT[k].at(i));
+				QVERIFY(d<tolerance || qAbs(d-24.)<tolerance);
+			}
+		}
+	}
+}
+
+void TestObservabilityYear::testSerial()
+{
+	const ObservabilityYear::Input sunOnly = input2018(-1);
+	compareResults(ObservabilityYear::compute(sunOnly), serialScan(sunOnly, -1));
+	QVERIFY(ObservabilityYear::compute(sunOnly).objectRA.isEmpty());
+
+	const ObservabilityYear::Input mars = input2018(Mars);
+	compareResults(ObservabilityYear::compute(mars), serialScan(mars, Mars));
+
+	// Cancelled before the first day
+	QAtomicInt cancelled(1);
+	QVERIFY(!ObservabilityYear::compute(mars, &cancelled).complete);
+}
+
+void TestObservabilityYear::testBackground()
+{
+	const ObservabilityYear::Input input = input2018(Mars);
+	QElapsedTimer timer;
+	timer.start();
+	const ObservabilityYear::Result expected = serialScan(input, Mars);
+	const qint64 serialNs = timer.nsecsElapsed();
+
+	ObservabilityYear scan;
+	QSignalSpy spy(&scan, SIGNAL(resultReady()));
+	timer.restart();
+	scan.start(input);
+	const qint64 startNs = timer.nsecsElapsed();
+	QVERIFY(scan.isRunning());
+	qDebug() << "Serial scan:" << serialNs/1000 << "us, starting the background scan:" << startNs/1000 << "us";
+	// The caller only pays for copying the input
+	QVERIFY(startNs < serialNs/2);
+
+	QVERIFY(spy.wait(10000));
+	QCOMPARE(spy.count(), 1);
+	QVERIFY(!scan.isRunning());
+	compareResults(scan.getResult(), expected);
+}
+
+void TestObservabilityYear::testRestart()
+{
+	// Changing the input cancels the running scan, only the last one is published
+	ObservabilityYear scan;
+	QSignalSpy spy(&scan, SIGNAL(resultReady()));
+	scan.start(input2018(Mars));
+	scan.start(input2018(-1));
+	const ObservabilityYear::Input input = input2018(Jupiter);
+	scan.start(input);
+	QVERIFY(spy.wait(10000));
+	QTest::qWait(100);
+	QCOMPARE(spy.count(), 1);
+	compareResults(scan.getResult(), serialScan(input, Jupiter));
+}
+
+void TestObservabilityYear::testCancel()
+{
+	ObservabilityYear scan;
+	QSignalSpy spy(&scan, SIGNAL(resultReady()));
+	scan.start(input2018(Mars));
+	scan.cancel();
+	QVERIFY(!scan.isRunning());
+	QTest::qWait(200);
+	QCOMPARE(spy.count(), 0);
+	QVERIFY(!scan.getResult().complete);
+}
@@ -20,13 +20,95 @@
 #include <QObject>
 #include <QtDebug>
 #include <QVariantList>
+#include <QVector>
 #include <QtTest>
 
+#include <cmath>
+
 #include "tests/testRefraction.hpp"
 #include "StelUtils.hpp"
 
 QTEST_GUILESS_MAIN(TestRefraction)
 
+namespace
+{
+	// The limits of refraction, see RefractionExtinction.cpp
+	const double MIN_GEO_ALTITUDE_DEG=-3.54;
+	const double TRANSITION_WIDTH_GEO_DEG=1.46;
+	const double MIN_APP_ALTITUDE_DEG=-3.21783;
+	const double TRANSITION_WIDTH_APP_DEG=1.78217;
+
+	//! Pressures (mbar) and temperatures (degrees C) at which the table is checked
+	const double conditions[][2] = { {1013., 10.}, {1010., 10.}, {1050., -30.}, {500., 40.}, {0., 10.} };
+
+	double pressureTemperatureCorrection(double pressure, double temperature)
+	{
+		return pressure/1010.*283./(273.+temperature)/60.;
+	}
+
+	//! Apparent altitude in degrees by Saemundsson's formula, with the linear transition to no refraction below the horizon
+	double analyticForward(double geoAltDeg, double correction)
+	{
+		if (geoAltDeg>MIN_GEO_ALTITUDE_DEG)
+		{
+			const double r=correction*(1.02/std::tan((geoAltDeg+10.3/(geoAltDeg+5.11))*M_PI/180.)+0.0019279);
+			return qMin(90., geoAltDeg+r);
+		}
+		if (geoAltDeg>MIN_GEO_ALTITUDE_DEG-TRANSITION_WIDTH_GEO_DEG)
+		{
+			const double r=correction*(1.02/std::tan((MIN_GEO_ALTITUDE_DEG+10.3/(MIN_GEO_ALTITUDE_DEG+5.11))*M_PI/180.)+0.0019279);
+			return geoAltDeg+r*(geoAltDeg-(MIN_GEO_ALTITUDE_DEG-TRANSITION_WIDTH_GEO_DEG))/TRANSITION_WIDTH_GEO_DEG;
+		}
+		return geoAltDeg;
+	}
+
+	double backwardPolynomial(double appAltDeg)
+	{
+		return (((((0.0444*appAltDeg+.7662)*appAltDeg+4.9746)*appAltDeg+13.599)*appAltDeg+8.052)*appAltDeg-11.308)*appAltDeg+34.341;
+	}
+
+	//! Geometric altitude in degrees by Bennett's formula, the polynomial fit below 0.22879 degrees and the transition to no refraction
+	double analyticBackward(double appAltDeg, double correction)
+	{
+		if (appAltDeg>0.22879)
+			return appAltDeg-correction*(1./std::tan((appAltDeg+7.31/(appAltDeg+4.4))*M_PI/180.)+0.0013515);
+		if (appAltDeg>MIN_APP_ALTITUDE_DEG)
+			return appAltDeg-correction*backwardPolynomial(appAltDeg);
+		if (appAltDeg>MIN_APP_ALTITUDE_DEG-TRANSITION_WIDTH_APP_DEG)
+			return appAltDeg-correction*backwardPolynomial(MIN_APP_ALTITUDE_DEG)*(appAltDeg-(MIN_APP_ALTITUDE_DEG-TRANSITION_WIDTH_APP_DEG))/TRANSITION_WIDTH_APP_DEG;
+		return appAltDeg;
+	}
+
+	//! Altitude in degrees after refraction of a vector at @param altDeg
+	double refract(const Refraction& refraction, double altDeg, bool forward)
+	{
+		Vec3d v;
+		StelUtils::spheToRect(0.7, altDeg*M_PI/180., v);
+		if (forward)
+			refraction.forward(v);
+		else
+			refraction.backward(v);
+		double lng, lat;
+		StelUtils::rectToSphe(&lng, &lat, v);
+		return lat*180./M_PI;
+	}
+
+	//! The altitudes to check: every 0.01 degrees, and finer around the table ends, the transitions and the zenith
+	QVector<double> sampleAltitudes()
+	{
+		QVector<double> altitudes;
+		for (int i=-9000; i<=9000; ++i)
+			altitudes.append(i*0.01);
+		for (int i=-1000; i<=1000; ++i)
+		{
+			altitudes.append(MIN_GEO_ALTITUDE_DEG-TRANSITION_WIDTH_GEO_DEG+i*0.0001);
+			altitudes.append(MIN_GEO_ALTITUDE_DEG+i*0.0001);
+			altitudes.append(90.-0.1+i*0.00005);
+		}
+		return altitudes;
+	}
+}
+
 void TestRefraction::initTestCase()
 {
 	Refraction refCls;
@@ -196,3 +278,112 @@ void TestRefraction::testComplexRefraction()
 							.toUtf8());
 	}
 }
+
+void TestRefraction::testForwardTable()
+{
+	// The table is interpolated linearly in the sine of the altitude. Its error is largest around the kink
+	// of the refraction at MIN_GEO_ALTITUDE_DEG, which lies inside one interval of the table.
+	const double acceptableError = 0.03/60.;
+	const double acceptableSmoothError = 0.005/60.;
+	const QVector<double> altitudes = sampleAltitudes();
+
+	for (unsigned int c=0; c<sizeof(conditions)/sizeof(conditions[0]); ++c)
+	{
+		Refraction refCls;
+		refCls.setPressure(conditions[c][0]);
+		refCls.setTemperature(conditions[c][1]);
+		const double correction = pressureTemperatureCorrection(conditions[c][0], conditions[c][1]);
+
+		double maxError = 0.;
+		foreach (double alt, altitudes)
+		{
+			const double result = refract(refCls, alt, true);
+			const double expected = analyticForward(alt, correction);
+			const double error = qAbs(result-expected);
+			const double acceptable = qAbs(alt-MIN_GEO_ALTITUDE_DEG)<0.05 ? acceptableError : acceptableSmoothError;
+			maxError = qMax(maxError, error);
+			QVERIFY2(error <= acceptable, QString("pressure=%1 temperature=%2 altitude=%3deg result=%4deg expected=%5deg error=%6' acceptable=%7'")
+							.arg(conditions[c][0])
+							.arg(conditions[c][1])
+							.arg(alt, 0, 'f', 5)
+							.arg(result, 0, 'f', 6)
+							.arg(expected, 0, 'f', 6)
+							.arg(error*60.)
+							.arg(acceptable*60.)
+							.toUtf8());
+		}
+		qDebug() << QString("pressure=%1 temperature=%2: maximum error %3'").arg(conditions[c][0]).arg(conditions[c][1]).arg(maxError*60.);
+	}
+}
+
+void TestRefraction::testBackwardFormula()
+{
+	const double acceptableError = 0.005/60.;
+	const QVector<double> altitudes = sampleAltitudes();
+
+	for (unsigned int c=0; c<sizeof(conditions)/sizeof(conditions[0]); ++c)
+	{
+		Refraction refCls;
+		refCls.setPressure(conditions[c][0]);
+		refCls.setTemperature(conditions[c][1]);
+		const double correction = pressureTemperatureCorrection(conditions[c][0], conditions[c][1]);
+
+		foreach (double alt, altitudes)
+		{
+			// Bennett's formula and the polynomial fit below it do not meet, skip the float rounding of the switch
+			if (qAbs(alt-0.22879)<0.001)
+				continue;
+			const double result = refract(refCls, alt, false);
+			const double expected = analyticBackward(alt, correction);
+			const double error = qAbs(result-expected);
+			QVERIFY2(error <= acceptableError, QString("pressure=%1 temperature=%2 altitude=%3deg result=%4deg expected=%5deg error=%6' acceptable=%7'")
+							.arg(conditions[c][0])
+							.arg(conditions[c][1])
+							.arg(alt, 0, 'f', 5)
+							.arg(result, 0, 'f', 6)
+							.arg(expected, 0, 'f', 6)
+							.arg(error*60.)
+							.arg(acceptableError*60.)
+							.toUtf8());
+		}
+	}
+}
+
+void TestRefraction::testBelowHorizonCutoff()
+{
+	Refraction refCls;
+	refCls.setPressure(1013);
+	refCls.setTemperature(10);
+
+	// Nothing is refracted below the bottom of the transition zones, which is the lower end of the table
+	const double cutoff = MIN_GEO_ALTITUDE_DEG-TRANSITION_WIDTH_GEO_DEG;
+	const double below[] = { -90., -45., -10., -5.5, cutoff-0.001, cutoff-1e-6 };
+	for (unsigned int i=0; i<sizeof(below)/sizeof(below[0]); ++i)
+	{
+		Vec3d v, w;
+		StelUtils::spheToRect(0.7, below[i]*M_PI/180., v);
+		w = v;
+		refCls.forward(w);
+		QVERIFY2(w == v, QString("forward refraction at %1deg").arg(below[i], 0, 'f', 6).toUtf8());
+		w = v;
+		refCls.backward(w);
+		QVERIFY2(w == v, QString("backward refraction at %1deg").arg(below[i], 0, 'f', 6).toUtf8());
+	}
+
+	// Continuous at the cut-off, and growing above it
+	QVERIFY(qAbs(refract(refCls, cutoff+1e-6, true)-(cutoff+1e-6)) < 1e-5);
+	QVERIFY(qAbs(refract(refCls, cutoff+1e-6, false)-(cutoff+1e-6)) < 1e-5);
+	double previous = 0.;
+	for (int i=1; i<=100; ++i)
+	{
+		const double alt = cutoff+i*TRANSITION_WIDTH_GEO_DEG/100.;
+		const double shift = refract(refCls, alt, true)-alt;
+		QVERIFY2(shift > previous, QString("refraction at %1deg is %2', below %3'").arg(alt).arg(shift*60.).arg(previous*60.).toUtf8());
+		previous = shift;
+	}
+
+	// The top of the table
+	QCOMPARE(refract(refCls, 90., true), 90.);
+	QVERIFY(refract(refCls, 89.99, true) > 89.99);
+	QVERIFY(refract(refCls, 89.99, true) <= 90.);
+}
@@ -32,6 +32,9 @@ private slots:
 	void testSaemundssonEquation();
 	void testBennettEquation();
 	void testComplexRefraction();
+	void testForwardTable();
+	void testBackwardFormula();
+	void testBelowHorizonCutoff();
 };
 
 #endif // _TESTREFRACTION_HPP_
@@ -0,0 +1,615 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testRemoteSyncReplication.hpp"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QLoggingCategory>
+#include <QScopedPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QVariant>
+#include <cmath>
+
+#include "SyncClientProtocolHandlers.hpp"
+#include "SyncMessages.hpp"
+#include "SyncServer.hpp"
+#include "SyncStateReplicator.hpp"
+
+QTEST_GUILESS_MAIN(TestRemoteSyncReplication)
+
+using namespace SyncProtocol;
+
+namespace
+{
+	//! Serialized like a StelPropertyUpdate, the name first
+	QByteArray createPayload(const QString& name, double value)
+	{
+		QByteArray payload;
+		QDataStream stream(&payload, QIODevice::WriteOnly);
+		stream.setVersion(SYNC_DATASTREAM_VERSION);
+		stream<<name.toUtf8()<<QVariant(value);
+		return payload;
+	}
+
+	QString payloadName(const QByteArray& payload)
+	{
+		QDataStream stream(payload);
+		stream.setVersion(SYNC_DATASTREAM_VERSION);
+		QByteArray name;
+		stream>>name;
+		return QString::fromUtf8(name);
+	}
+
+	bool readBundleMessage(const QByteArray& msg, SyncStateReplicator::BundlePart& part)
+	{
+		QDataStream stream(msg);
+		stream.setVersion(SYNC_DATASTREAM_VERSION);
+		SyncHeader header;
+		stream>>header;
+		return header.msgType == BUNDLE
+			&& header.dataSize + SYNC_HEADER_SIZE == msg.size()
+			&& SyncStateReplicator::readBundle(stream, header.dataSize, part);
+	}
+
+	//! Passes a BUNDLE message to the handler, like SyncRemotePeer::receiveMessage
+	bool applyBundle(SyncMessageHandler& handler, const QByteArray& msg, SyncRemotePeer& peer)
+	{
+		QDataStream stream(msg);
+		stream.setVersion(SYNC_DATASTREAM_VERSION);
+		SyncHeader header;
+		stream>>header;
+		return header.msgType == BUNDLE && handler.handleMessage(stream, header.dataSize, peer);
+	}
+
+	QByteArray serializeMessage(const SyncMessage& msg)
+	{
+		QByteArray data;
+		return data.left(static_cast<int>(msg.createFullMessage(data)));
+	}
+
+	QString stateKey(const SyncMessage& msg)
+	{
+		return QString::number(msg.getMessageType()) + '/' + msg.getStateKey();
+	}
+
+	StelPropertyUpdate createProperty(const QString& name, double value)
+	{
+		StelPropertyUpdate msg;
+		msg.propId = name;
+		msg.value = value;
+		return msg;
+	}
+
+	//! Silences the log of each message sent and received while it exists
+	class QuietPeerLog
+	{
+	public:
+		QuietPeerLog() { QLoggingCategory::setFilterRules("default.debug=false\nstel.plugin.remoteSync.*.debug=false"); }
+		~QuietPeerLog() { QLoggingCategory::setFilterRules(QString()); }
+	};
+
+	//! Stands in for the client handler of a message type, which would apply the state to the application.
+	//! Keeps the last message received for each state instead.
+	template<class T>
+	class StateRecorder : public SyncMessageHandler
+	{
+	public:
+		StateRecorder(QHash<QString, QByteArray>& state) : state(state) {}
+		bool handleMessage(QDataStream &stream, tPayloadSize dataSize, SyncRemotePeer &peer) Q_DECL_OVERRIDE
+		{
+			Q_UNUSED(peer);
+			T msg;
+			if(!msg.deserialize(stream, dataSize))
+				return false;
+			state.insert(stateKey(msg), serializeMessage(msg));
+			return true;
+		}
+	private:
+		QHash<QString, QByteArray>& state;
+	};
+
+	//! The connection handling of a SyncClient, with the message handlers which don't need the application
+	class LoopbackClient
+	{
+	public:
+		LoopbackClient(quint16 port)
+			: bundleHandler(handlerList)
+			, timeRecorder(state)
+			, propertyRecorder(state)
+			, viewRecorder(state)
+			, fovRecorder(state)
+		{
+			handlerList.resize(MSGTYPE_SIZE);
+			handlerList[SERVER_CHALLENGE] = &authHandler;
+			handlerList[SERVER_CHALLENGERESPONSEVALID] = &authHandler;
+			handlerList[ALIVE] = &aliveHandler;
+			handlerList[BUNDLE] = &bundleHandler;
+			handlerList[TIME] = &timeRecorder;
+			handlerList[STELPROPERTY] = &propertyRecorder;
+			handlerList[VIEW] = &viewRecorder;
+			handlerList[FOV] = &fovRecorder;
+
+			QTcpSocket* socket = new QTcpSocket();
+			peer = new SyncRemotePeer(socket, true, handlerList);
+			socket->connectToHost(QHostAddress::LocalHost, port);
+		}
+		~LoopbackClient() { delete peer; }
+
+		SyncRemotePeer* peer;
+		QVector<SyncMessageHandler*> handlerList;
+		ClientAuthHandler authHandler;
+		ClientAliveHandler aliveHandler;
+		ClientBundleHandler bundleHandler;
+		//! the state received from the server, by stateKey()
+		QHash<QString, QByteArray> state;
+	private:
+		StateRecorder<Time> timeRecorder;
+		StateRecorder<StelPropertyUpdate> propertyRecorder;
+		StateRecorder<View> viewRecorder;
+		StateRecorder<Fov> fovRecorder;
+	};
+
+	//! A SyncServer and its clients in one process, connected over the loopback interface.
+	//! The server runs without SyncServerEventSenders, the state changes are passed to SyncServer::broadcastMessage
+	//! like the senders do.
+	class LoopbackHarness
+	{
+	public:
+		LoopbackHarness(bool coalesced, bool compression)
+		{
+			server.setCoalescedReplication(coalesced);
+			server.setBundleCompression(compression);
+			started = server.start(0);
+		}
+		~LoopbackHarness()
+		{
+			qDeleteAll(clients);
+			clients.clear();
+			// SyncServer::stop() expects the clients to disconnect
+			waitFor(&LoopbackHarness::isServerUpToDate);
+		}
+
+		bool isStarted() const { return started; }
+
+		//! Connects a new client, and waits until the server has authenticated it
+		bool connectClient()
+		{
+			clients.append(new LoopbackClient(server.getPort()));
+			return waitFor(&LoopbackHarness::isAuthenticated);
+		}
+
+		bool disconnectClient(int i)
+		{
+			delete clients.takeAt(i);
+			return waitFor(&LoopbackHarness::isServerUpToDate);
+		}
+
+		void setState(const SyncMessage& msg)
+		{
+			state.insert(stateKey(msg), serializeMessage(msg));
+			server.broadcastMessage(msg);
+		}
+
+		//! Ends the frame of the server, and waits until each client has the state of the server.
+		//! With coalesced replication, this also needs the acknowledgements of the clients,
+		//! because the server stops sending bundles to clients which don't acknowledge them.
+		bool endFrame()
+		{
+			server.update();
+			return waitFor(&LoopbackHarness::isConsistent);
+		}
+
+		const QList<LoopbackClient*>& getClients() const { return clients; }
+
+		//! Traffic between the server and the clients
+		quint64 getBytes() const
+		{
+			quint64 bytes = 0;
+			foreach(const LoopbackClient* c, clients)
+				bytes += c->peer->getBytesSent() + c->peer->getBytesReceived();
+			return bytes;
+		}
+		quint64 getMessages() const
+		{
+			quint64 messages = 0;
+			foreach(const LoopbackClient* c, clients)
+				messages += c->peer->getMessagesSent() + c->peer->getMessagesReceived();
+			return messages;
+		}
+
+	private:
+		//! Processes the socket events until the condition is met
+		bool waitFor(bool (LoopbackHarness::*condition)() const)
+		{
+			QElapsedTimer timer;
+			timer.start();
+			while(!(this->*condition)())
+			{
+				if(timer.elapsed() > 5000)
+					return false;
+				QCoreApplication::processEvents();
+			}
+			return true;
+		}
+
+		bool isAuthenticated() const
+		{
+			foreach(const LoopbackClient* c, clients)
+			{
+				if(!c->peer->isAuthenticated())
+					return false;
+			}
+			return true;
+		}
+
+		bool isServerUpToDate() const
+		{
+			return server.getClientCount() == clients.size();
+		}
+
+		bool isConsistent() const
+		{
+			foreach(const LoopbackClient* c, clients)
+			{
+				if(c->state != state)
+					return false;
+			}
+			return true;
+		}
+
+		QuietPeerLog quietPeerLog;
+		SyncServer server;
+		bool started;
+		QList<LoopbackClient*> clients;
+		//! the state of the server, by stateKey()
+		QHash<QString, QByteArray> state;
+	};
+
+	const int NrOfProperties = 300;
+	const int NrOfAnimatedProperties = 40;
+
+	QString propertyName(int i)
+	{
+		return QString("StelModule%1.property%2").arg(i/10).arg(i%10);
+	}
+
+	void setView(LoopbackHarness& harness, double azimuth)
+	{
+		View view;
+		view.viewAltAz.set(std::cos(azimuth), std::sin(azimuth), 0.);
+		harness.setState(view);
+	}
+
+	void setTime(LoopbackHarness& harness, double jDay)
+	{
+		Time time;
+		time.lastTimeSyncTime = 0;
+		time.jDay = jDay;
+		time.timeRate = 1./86400.;
+		harness.setState(time);
+	}
+
+	void setInitialState(LoopbackHarness& harness)
+	{
+		setTime(harness, 2458000.5);
+		setView(harness, 0.);
+		Fov fov;
+		fov.fov = 60.;
+		harness.setState(fov);
+		for(int i=0; i<NrOfProperties; ++i)
+			harness.setState(createProperty(propertyName(i), i));
+	}
+
+	//! A frame of a show: time and view move, and some properties are animated.
+	//! Animated properties are usually set several times per frame, e.g. by a fader and by a script.
+	void animateFrame(LoopbackHarness& harness, int frame)
+	{
+		setTime(harness, 2458000.5 + frame/86400.0);
+		setView(harness, frame*0.01);
+		for(int i=0; i<NrOfAnimatedProperties; ++i)
+		{
+			harness.setState(createProperty(propertyName(i*7), frame + i*0.5));
+			harness.setState(createProperty(propertyName(i*7), frame + i));
+		}
+	}
+}
+
+void TestRemoteSyncReplication::testDelta()
+{
+	SyncStateReplicator replicator;
+	const QUuid client = QUuid::createUuid();
+	replicator.setField(STELPROPERTY, "a", createPayload("a", 1.0));
+	replicator.setField(STELPROPERTY, "b", createPayload("b", 2.0));
+	replicator.setField(FOV, QString(), createPayload("fov", 60.0));
+	QVERIFY(replicator.commitFrame());
+	QCOMPARE(replicator.getFieldCount(), 3);
+	replicator.addClient(client);
+
+	// a new client gets a snapshot
+	QVector<QByteArray> messages;
+	QCOMPARE(replicator.createBundle(client, messages), 1);
+	SyncStateReplicator::BundlePart part;
+	QVERIFY(readBundleMessage(messages.first(), part));
+	QCOMPARE(part.frame, 1u);
+	QCOMPARE(part.baseFrame, 0u);
+	QVERIFY(part.flags & SyncStateReplicator::LastPart);
+	QCOMPARE(part.fields.size(), 3);
+	QCOMPARE(payloadName(part.fields.at(1).payload), QString("b"));
+
+	// nothing to send until something changes
+	messages.clear();
+	QCOMPARE(replicator.createBundle(client, messages), 0);
+	replicator.acknowledge(client, 1);
+	QCOMPARE(replicator.getAcknowledgedFrame(client), 1u);
+	replicator.setField(STELPROPERTY, "a", createPayload("a", 1.0));
+	QVERIFY(!replicator.commitFrame());
+
+	// only the last value of a changed field is sent
+	replicator.setField(STELPROPERTY, "a", createPayload("a", 3.0));
+	replicator.setField(STELPROPERTY, "a", createPayload("a", 4.0));
+	QVERIFY(replicator.commitFrame());
+	QCOMPARE(replicator.createBundle(client, messages), 1);
+	QVERIFY(readBundleMessage(messages.first(), part));
+	QCOMPARE(part.frame, 2u);
+	QCOMPARE(part.baseFrame, 1u);
+	QCOMPARE(part.fields.size(), 1);
+	QCOMPARE(part.fields.first().msgType, static_cast<quint8>(STELPROPERTY));
+	QCOMPARE(part.fields.first().payload, createPayload("a", 4.0));
+
+	// a client can't acknowledge a frame it was not sent
+	replicator.acknowledge(client, 5);
+	QCOMPARE(replicator.getAcknowledgedFrame(client), 1u);
+}
+
+void TestRemoteSyncReplication::testFlowControl()
+{
+	SyncStateReplicator replicator;
+	replicator.setMaxFramesInFlight(2);
+	const QUuid client = QUuid::createUuid();
+	replicator.addClient(client);
+
+	QVector<QByteArray> messages;
+	for(int frame=1; frame<=4; ++frame)
+	{
+		replicator.setField(STELPROPERTY, "a", createPayload("a", frame));
+		replicator.setField(STELPROPERTY, QString::number(frame), createPayload(QString::number(frame), frame));
+		QVERIFY(replicator.commitFrame());
+		messages.clear();
+		// the client does not acknowledge, so it is skipped after two bundles
+		QCOMPARE(replicator.createBundle(client, messages), frame<=2 ? 1 : 0);
+	}
+
+	// when it catches up, a single delta contains the changes of the frames it missed
+	replicator.acknowledge(client, 2);
+	messages.clear();
+	QCOMPARE(replicator.createBundle(client, messages), 1);
+	SyncStateReplicator::BundlePart part;
+	QVERIFY(readBundleMessage(messages.first(), part));
+	QCOMPARE(part.frame, 4u);
+	QCOMPARE(part.baseFrame, 2u);
+	QCOMPARE(part.fields.size(), 3);
+	QCOMPARE(part.fields.first().payload, createPayload("a", 4));
+}
+
+void TestRemoteSyncReplication::testSplitAndCompression()
+{
+	const int nrOfFields = 2000;
+	qint64 sizes[2];
+	for(int compression=0; compression<2; ++compression)
+	{
+		SyncStateReplicator replicator;
+		replicator.setCompressionEnabled(compression);
+		for(int i=0; i<nrOfFields; ++i)
+			replicator.setField(STELPROPERTY, propertyName(i), createPayload(propertyName(i) + QString(40, 'x'), i));
+		replicator.commitFrame();
+
+		const QUuid client = QUuid::createUuid();
+		replicator.addClient(client);
+		QVector<QByteArray> messages;
+		replicator.createBundle(client, messages);
+
+		sizes[compression] = 0;
+		int fields = 0;
+		for(int i=0; i<messages.size(); ++i)
+		{
+			QVERIFY(messages.at(i).size() <= SYNC_MAX_MESSAGE_SIZE);
+			SyncStateReplicator::BundlePart part;
+			QVERIFY(readBundleMessage(messages.at(i), part));
+			QCOMPARE(part.baseFrame, 0u);
+			QCOMPARE(bool(part.flags & SyncStateReplicator::LastPart), i == messages.size()-1);
+			QCOMPARE(bool(part.flags & SyncStateReplicator::Compressed), bool(compression));
+			QCOMPARE(payloadName(part.fields.first().payload), propertyName(fields) + QString(40, 'x'));
+			fields += part.fields.size();
+			sizes[compression] += messages.at(i).size();
+		}
+		QCOMPARE(fields, nrOfFields);
+		if(!compression)
+			QVERIFY(messages.size() > 1);
+	}
+	qDebug() << QString("snapshot of %1 fields: %2 bytes, %3 bytes compressed").arg(nrOfFields).arg(sizes[0]).arg(sizes[1]);
+	QVERIFY(sizes[1] < sizes[0]);
+}
+
+void TestRemoteSyncReplication::testClientBundleHandler()
+{
+	// the client end of a connection, the acknowledgements are read from the other end
+	QTcpServer tcpServer;
+	QVERIFY(tcpServer.listen(QHostAddress::LocalHost));
+	QTcpSocket* socket = new QTcpSocket();
+	socket->connectToHost(QHostAddress::LocalHost, tcpServer.serverPort());
+	QVERIFY(socket->waitForConnected(5000));
+	QVERIFY(tcpServer.waitForNewConnection(5000));
+	QScopedPointer<QTcpSocket> serverSocket(tcpServer.nextPendingConnection());
+
+	QHash<QString, QByteArray> state;
+	StateRecorder<StelPropertyUpdate> recorder(state);
+	QVector<SyncMessageHandler*> handlerList(MSGTYPE_SIZE, Q_NULLPTR);
+	handlerList[STELPROPERTY] = &recorder;
+	ClientBundleHandler handler(handlerList);
+	SyncRemotePeer peer(socket, true, handlerList);
+
+	// frame 1 is a snapshot split into several parts, frames 2 and 3 are deltas
+	const int nrOfFields = 2000;
+	SyncStateReplicator replicator;
+	replicator.setCompressionEnabled(false);
+	const QUuid client = QUuid::createUuid();
+	replicator.addClient(client);
+	QVector<QByteArray> bundles[3];
+	for(int i=0; i<nrOfFields; ++i)
+		replicator.setField(createProperty(propertyName(i) + QString(40, 'x'), i));
+	for(int frame=1; frame<=3; ++frame)
+	{
+		replicator.setField(createProperty("a", frame));
+		QVERIFY(replicator.commitFrame());
+		replicator.createBundle(client, bundles[frame-1]);
+	}
+	QVERIFY(bundles[0].size() > 1);
+
+	// the state is applied part by part, but only the complete bundle is acknowledged
+	for(int i=0; i<bundles[0].size(); ++i)
+	{
+		QVERIFY(applyBundle(handler, bundles[0].at(i), peer));
+		QCOMPARE(handler.getAppliedFrame(), i == bundles[0].size()-1 ? 1u : 0u);
+	}
+	QCOMPARE(state.size(), nrOfFields + 1);
+	QCOMPARE(state.value(stateKey(createProperty("a", 1))), serializeMessage(createProperty("a", 1)));
+
+	// a delta against a frame the client has not applied is rejected
+	QVERIFY(!applyBundle(handler, bundles[2].first(), peer));
+	QCOMPARE(handler.getAppliedFrame(), 1u);
+	QCOMPARE(state.value(stateKey(createProperty("a", 1))), serializeMessage(createProperty("a", 1)));
+
+	QVERIFY(applyBundle(handler, bundles[1].first(), peer));
+	QVERIFY(applyBundle(handler, bundles[2].first(), peer));
+	QCOMPARE(handler.getAppliedFrame(), 3u);
+	QCOMPARE(state.value(stateKey(createProperty("a", 3))), serializeMessage(createProperty("a", 3)));
+
+	// a snapshot can be applied to any state
+	const QUuid otherClient = QUuid::createUuid();
+	replicator.addClient(otherClient);
+	QVector<QByteArray> snapshot;
+	replicator.createBundle(otherClient, snapshot);
+	foreach(const QByteArray& part, snapshot)
+		QVERIFY(applyBundle(handler, part, peer));
+	QCOMPARE(handler.getAppliedFrame(), 3u);
+
+	// one acknowledgement for each completely applied bundle
+	const quint32 expectedAcks[] = { 1u, 2u, 3u, 3u };
+	const int nrOfAcks = sizeof(expectedAcks)/sizeof(expectedAcks[0]);
+	const int ackSize = SyncStateReplicator::createAck(0).size();
+	socket->flush();
+	while(serverSocket->bytesAvailable() < nrOfAcks*ackSize)
+		QVERIFY(serverSocket->waitForReadyRead(5000));
+	QCOMPARE(serverSocket->bytesAvailable(), qint64(nrOfAcks*ackSize));
+	QDataStream stream(serverSocket.data());
+	stream.setVersion(SYNC_DATASTREAM_VERSION);
+	for(int i=0; i<nrOfAcks; ++i)
+	{
+		SyncHeader header;
+		stream>>header;
+		QCOMPARE(header.msgType, static_cast<quint8>(BUNDLE_ACK));
+		quint32 frame = 0;
+		QVERIFY(SyncStateReplicator::readAck(stream, header.dataSize, frame));
+		QCOMPARE(frame, expectedAcks[i]);
+	}
+}
+
+void TestRemoteSyncReplication::testSnapshotOnReconnect()
+{
+	// Without coalesced replication, new clients get the current state from the SyncServerEventSenders,
+	// which need the application. With it, the server sends them a snapshot of the replicated state.
+	LoopbackHarness harness(true, true);
+	QVERIFY(harness.isStarted());
+	setInitialState(harness);
+	for(int i=0; i<3; ++i)
+		QVERIFY(harness.connectClient());
+
+	for(int frame=1; frame<=50; ++frame)
+	{
+		if(frame == 20)
+			QVERIFY(harness.disconnectClient(1));
+		if(frame == 30)
+			QVERIFY(harness.connectClient());
+		animateFrame(harness, frame);
+		QVERIFY(harness.endFrame());
+	}
+	QCOMPARE(harness.getClients().size(), 3);
+
+	// the reconnected client started with a snapshot, and got the same deltas as the others from then on
+	foreach(const LoopbackClient* c, harness.getClients())
+		QCOMPARE(c->bundleHandler.getAppliedFrame(), 50u);
+}
+
+void TestRemoteSyncReplication::benchmarkLoopback_data()
+{
+	QTest::addColumn<int>("nrOfClients");
+	QTest::newRow("1 client") << 1;
+	QTest::newRow("4 clients") << 4;
+	QTest::newRow("16 clients") << 16;
+}
+
+void TestRemoteSyncReplication::benchmarkLoopback()
+{
+	QFETCH(int, nrOfClients);
+	const int nrOfFrames = 300;
+	const char* modes[3] = { "immediate", "coalesced", "coalesced+compressed" };
+	quint64 bytes[3];
+	quint64 messages[3];
+	double seconds[3];
+
+	for(int mode=0; mode<3; ++mode)
+	{
+		LoopbackHarness harness(mode>0, mode==2);
+		QVERIFY(harness.isStarted());
+		// the clients connect first, because only coalesced replication sends the current state to new clients
+		for(int i=0; i<nrOfClients; ++i)
+			QVERIFY(harness.connectClient());
+		const quint64 handshakeBytes = harness.getBytes();
+		const quint64 handshakeMessages = harness.getMessages();
+		setInitialState(harness);
+		QVERIFY(harness.endFrame());
+
+		QElapsedTimer timer;
+		timer.start();
+		for(int frame=1; frame<=nrOfFrames; ++frame)
+		{
+			animateFrame(harness, frame);
+			QVERIFY(harness.endFrame());
+		}
+		seconds[mode] = qMax(timer.nsecsElapsed(), Q_INT64_C(1))*1e-9;
+		bytes[mode] = harness.getBytes() - handshakeBytes;
+		messages[mode] = harness.getMessages() - handshakeMessages;
+	}
+
+	for(int mode=0; mode<3; ++mode)
+	{
+		qDebug() << QString("%1 clients, %2: %3 messages/s, %4 kB/s, %5 bytes per client and frame")
+			    .arg(nrOfClients).arg(modes[mode])
+			    .arg(messages[mode]/seconds[mode], 0, 'f', 0)
+			    .arg(bytes[mode]/seconds[mode]/1024., 0, 'f', 0)
+			    .arg(double(bytes[mode])/nrOfClients/nrOfFrames, 0, 'f', 0);
+	}
+
+	QVERIFY(messages[1] < messages[0]);
+	QVERIFY(bytes[1] < bytes[0]);
+	QVERIFY(bytes[2] < bytes[1]);
+}
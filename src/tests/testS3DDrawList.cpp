@@ -0,0 +1,306 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testS3DDrawList.hpp"
+
+#include "S3DDrawList.hpp"
+#include "Frustum.hpp"
+#include "GLFuncs.hpp"
+
+#include <QMatrix4x4>
+#include <QSet>
+#include <QtDebug>
+
+QTEST_GUILESS_MAIN(TestS3DDrawList)
+
+#ifndef QT_OPENGL_ES_2
+//normally defined by S3DRenderer, only used for debug drawing
+GLExtFuncs* glExtFuncs = Q_NULLPTR;
+#endif
+
+namespace
+{
+	//! The synthetic scene has GRID x GRID objects
+	const int GRID = 64;
+	const int GROUPS_PER_OBJECT = 3;
+	const int MATERIALS = 32;
+
+	//! A town-like scene: a grid of buildings, each with a few material groups stacked on each other
+	StelOBJ::ObjectList makeScene()
+	{
+		StelOBJ::ObjectList objects;
+		objects.reserve(GRID*GRID);
+		int startIndex = 0;
+		for(int y=0; y<GRID; ++y)
+		{
+			for(int x=0; x<GRID; ++x)
+			{
+				StelOBJ::Object obj;
+				const float ox = (x - GRID/2) * 10.0f;
+				const float oy = (y - GRID/2) * 10.0f;
+				for(int g=0; g<GROUPS_PER_OBJECT; ++g)
+				{
+					StelOBJ::MaterialGroup grp;
+					grp.startIndex = startIndex;
+					grp.indexCount = 36;
+					startIndex += grp.indexCount;
+					grp.objectIndex = objects.size();
+					grp.materialIndex = (x*7 + y*13 + g*5) % MATERIALS;
+					grp.boundingbox = AABBox(Vec3f(ox, oy, g*3.0f), Vec3f(ox+4.0f, oy+4.0f, g*3.0f+3.0f));
+					grp.centroid = Vec3f(ox+2.0f, oy+2.0f, g*3.0f+1.5f);
+					obj.boundingbox.expand(grp.boundingbox);
+					obj.groups.append(grp);
+				}
+				objects.append(obj);
+			}
+		}
+		return objects;
+	}
+
+	void makeMaterials(QVector<S3DDrawList::MaterialMode>& modes, QVector<uint>& keys)
+	{
+		modes.resize(MATERIALS);
+		keys.resize(MATERIALS);
+		for(int i=0; i<MATERIALS; ++i)
+		{
+			if(i%8 == 0)
+				modes[i] = S3DDrawList::Skip;
+			else if(i%8 == 1)
+				modes[i] = S3DDrawList::Transparent;
+			else
+				modes[i] = S3DDrawList::Opaque;
+			//fewer shaders than materials, and not in material order
+			keys[i] = (i*3) % 5;
+		}
+	}
+
+	//! A view from slightly above the ground, off-center to avoid symmetries
+	QMatrix4x4 viewMatrix()
+	{
+		QMatrix4x4 proj;
+		proj.perspective(60.0f, 1.5f, 0.5f, 250.0f);
+		QMatrix4x4 view;
+		view.lookAt(QVector3D(3.3f, 1.7f, 2.0f), QVector3D(100.0f, 31.0f, 1.0f), QVector3D(0.0f, 0.0f, 1.0f));
+		return proj * view;
+	}
+
+	//! An orthographic light projection covering a part of the scene, like a shadow cascade
+	QMatrix4x4 lightMatrix()
+	{
+		QMatrix4x4 proj;
+		proj.ortho(-60.0f, 40.0f, -35.0f, 55.0f, 1.0f, 400.0f);
+		QMatrix4x4 view;
+		view.lookAt(QVector3D(120.0f, -80.0f, 150.0f), QVector3D(0.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f));
+		return proj * view;
+	}
+
+	//! Brute force test in clip space: a box is outside if all corners are outside of the same clip plane
+	bool isOutside(const QMatrix4x4& mvp, const AABBox& box)
+	{
+		int outside[6] = {0, 0, 0, 0, 0, 0};
+		for(int i=0; i<AABBox::CORNERCOUNT; ++i)
+		{
+			const Vec3f c = box.getCorner(static_cast<AABBox::Corner>(i));
+			const QVector4D p = mvp * QVector4D(c[0], c[1], c[2], 1.0f);
+			if(p.x() < -p.w()) ++outside[0];
+			if(p.x() >  p.w()) ++outside[1];
+			if(p.y() < -p.w()) ++outside[2];
+			if(p.y() >  p.w()) ++outside[3];
+			if(p.z() < -p.w()) ++outside[4];
+			if(p.z() >  p.w()) ++outside[5];
+		}
+		for(int i=0; i<6; ++i)
+			if(outside[i] == AABBox::CORNERCOUNT)
+				return true;
+		return false;
+	}
+}
+
+void TestS3DDrawList::testFrustumFromMatrix()
+{
+	QMatrix4x4 proj;
+	proj.perspective(90.0f, 1.0f, 1.0f, 100.0f);
+	QMatrix4x4 view;
+	view.lookAt(QVector3D(0.0f, 0.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f));
+
+	Frustum frustum;
+	frustum.setFromMatrix(proj * view);
+
+	QCOMPARE(frustum.pointInFrustum(Vec3f(10.0f, 0.0f, 0.0f)), static_cast<int>(Frustum::INSIDE));
+	QCOMPARE(frustum.pointInFrustum(Vec3f(10.0f, 9.0f, -9.0f)), static_cast<int>(Frustum::INSIDE));
+	QCOMPARE(frustum.pointInFrustum(Vec3f(-10.0f, 0.0f, 0.0f)), static_cast<int>(Frustum::OUTSIDE));
+	QCOMPARE(frustum.pointInFrustum(Vec3f(0.5f, 0.0f, 0.0f)), static_cast<int>(Frustum::OUTSIDE));
+	QCOMPARE(frustum.pointInFrustum(Vec3f(101.0f, 0.0f, 0.0f)), static_cast<int>(Frustum::OUTSIDE));
+	QCOMPARE(frustum.pointInFrustum(Vec3f(10.0f, 11.0f, 0.0f)), static_cast<int>(Frustum::OUTSIDE));
+
+	//with a 90 degree fov, the far corners are at +-far in both directions
+	const Vec3f& ftl = frustum.getCorner(Frustum::FTL);
+	QVERIFY(qAbs(ftl[0] - 100.0f) < 1e-2f);
+	QVERIFY(qAbs(qAbs(ftl[1]) - 100.0f) < 1e-2f);
+	QVERIFY(qAbs(ftl[2] - 100.0f) < 1e-2f);
+	QVERIFY(qAbs(frustum.bbox.min[0] - 1.0f) < 1e-3f);
+	QVERIFY(qAbs(frustum.bbox.max[0] - 100.0f) < 1e-2f);
+
+	QCOMPARE(frustum.boxInFrustum(AABBox(Vec3f(-5.0f, -1.0f, -1.0f), Vec3f(5.0f, 1.0f, 1.0f))), static_cast<int>(Frustum::INSIDE));
+	QCOMPARE(frustum.boxInFrustum(AABBox(Vec3f(-5.0f, -1.0f, -1.0f), Vec3f(-2.0f, 1.0f, 1.0f))), static_cast<int>(Frustum::OUTSIDE));
+}
+
+void TestS3DDrawList::testCulling_data()
+{
+	QTest::addColumn<QMatrix4x4>("mvp");
+	QTest::newRow("view") << viewMatrix();
+	QTest::newRow("light") << lightMatrix();
+}
+
+void TestS3DDrawList::testCulling()
+{
+	QFETCH(QMatrix4x4, mvp);
+
+	const StelOBJ::ObjectList objects = makeScene();
+	QVector<S3DDrawList::MaterialMode> modes;
+	QVector<uint> keys;
+	makeMaterials(modes, keys);
+
+	Frustum frustum;
+	frustum.setFromMatrix(mvp);
+	S3DDrawList list;
+	list.build(objects, modes, keys, &frustum, Vec3f(0.0f));
+
+	QSet<const StelOBJ::MaterialGroup*> drawn;
+	foreach(const StelOBJ::MaterialGroup* grp, list.getOpaqueGroups())
+		drawn.insert(grp);
+	foreach(const StelOBJ::MaterialGroup* grp, list.getTransparentGroups())
+		drawn.insert(grp);
+	QCOMPARE(drawn.size(), list.getOpaqueGroups().size() + list.getTransparentGroups().size());
+
+	//every visible group must be drawn, and every group outside must be culled
+	int expectedCulled = 0;
+	int total = 0;
+	foreach(const StelOBJ::Object& obj, objects)
+	{
+		foreach(const StelOBJ::MaterialGroup& grp, obj.groups)
+		{
+			if(modes.at(grp.materialIndex) == S3DDrawList::Skip)
+			{
+				QVERIFY(!drawn.contains(&grp));
+				continue;
+			}
+			++total;
+			const bool outside = isOutside(mvp, grp.boundingbox);
+			if(outside)
+				++expectedCulled;
+			QCOMPARE(drawn.contains(&grp), !outside);
+		}
+	}
+	QCOMPARE(list.getCulledCount(), expectedCulled);
+	QCOMPARE(drawn.size() + expectedCulled, total);
+	//the test is meaningless if everything or nothing is culled
+	QVERIFY(expectedCulled > 0);
+	QVERIFY(expectedCulled < total);
+	qDebug() << "Culled" << expectedCulled << "of" << total << "groups";
+}
+
+void TestS3DDrawList::testSorting()
+{
+	const StelOBJ::ObjectList objects = makeScene();
+	QVector<S3DDrawList::MaterialMode> modes;
+	QVector<uint> keys;
+	makeMaterials(modes, keys);
+
+	const Vec3f eye(3.3f, 1.7f, 2.0f);
+	S3DDrawList list;
+	list.build(objects, modes, keys, Q_NULLPTR, eye);
+	QCOMPARE(list.getCulledCount(), 0);
+
+	int opaqueCount = 0;
+	int transparentCount = 0;
+	foreach(const StelOBJ::Object& obj, objects)
+	{
+		foreach(const StelOBJ::MaterialGroup& grp, obj.groups)
+		{
+			if(modes.at(grp.materialIndex) == S3DDrawList::Opaque)
+				++opaqueCount;
+			else if(modes.at(grp.materialIndex) == S3DDrawList::Transparent)
+				++transparentCount;
+		}
+	}
+
+	//opaque groups are ordered by key, then material, so each material is set up only once
+	const QVector<const StelOBJ::MaterialGroup*>& opaque = list.getOpaqueGroups();
+	QCOMPARE(opaque.size(), opaqueCount);
+	int materialSwitches = 0;
+	for(int i=0; i<opaque.size(); ++i)
+	{
+		QCOMPARE(modes.at(opaque.at(i)->materialIndex), S3DDrawList::Opaque);
+		if(i == 0)
+		{
+			++materialSwitches;
+			continue;
+		}
+		const StelOBJ::MaterialGroup* prev = opaque.at(i-1);
+		const StelOBJ::MaterialGroup* cur = opaque.at(i);
+		QVERIFY(keys.at(prev->materialIndex) <= keys.at(cur->materialIndex));
+		if(prev->materialIndex != cur->materialIndex)
+		{
+			++materialSwitches;
+			if(keys.at(prev->materialIndex) == keys.at(cur->materialIndex))
+				QVERIFY(prev->materialIndex < cur->materialIndex);
+		}
+		else
+			QVERIFY(prev->startIndex < cur->startIndex);
+	}
+	QCOMPARE(materialSwitches, MATERIALS - MATERIALS/8*2);
+
+	//transparent groups are drawn back to front
+	const QVector<const StelOBJ::MaterialGroup*>& transparent = list.getTransparentGroups();
+	QCOMPARE(transparent.size(), transparentCount);
+	for(int i=1; i<transparent.size(); ++i)
+	{
+		QCOMPARE(modes.at(transparent.at(i)->materialIndex), S3DDrawList::Transparent);
+		QVERIFY((transparent.at(i-1)->centroid - eye).lengthSquared() >= (transparent.at(i)->centroid - eye).lengthSquared());
+	}
+}
+
+void TestS3DDrawList::benchmarkBuild_data()
+{
+	QTest::addColumn<bool>("cull");
+	QTest::newRow("sort only") << false;
+	QTest::newRow("cull and sort") << true;
+}
+
+void TestS3DDrawList::benchmarkBuild()
+{
+	QFETCH(bool, cull);
+
+	const StelOBJ::ObjectList objects = makeScene();
+	QVector<S3DDrawList::MaterialMode> modes;
+	QVector<uint> keys;
+	makeMaterials(modes, keys);
+
+	Frustum frustum;
+	S3DDrawList list;
+	QBENCHMARK
+	{
+		//the frustum is set up each pass in the renderer too
+		frustum.setFromMatrix(viewMatrix());
+		list.build(objects, modes, keys, cull ? &frustum : Q_NULLPTR, Vec3f(3.3f, 1.7f, 2.0f));
+	}
+	qDebug() << objects.size()*GROUPS_PER_OBJECT << "groups," << list.getCulledCount() << "culled,"
+		 << list.getOpaqueGroups().size() + list.getTransparentGroups().size() << "drawn";
+}
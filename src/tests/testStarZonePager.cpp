@@ -0,0 +1,313 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStarZonePager.hpp"
+
+#include <QDataStream>
+#include <QFile>
+
+#include "StarZonePager.hpp"
+
+QTEST_GUILESS_MAIN(TestStarZonePager)
+
+namespace
+{
+	const unsigned int CatalogMagic = 0x835f040a;
+	const int NrOfLevels = 3;
+	const qint64 HeaderSize = 8*4;
+
+	int nrOfZones(int level)
+	{
+		return 20<<(2*level);
+	}
+
+	int recordSize(int level)
+	{
+		// like the deep catalogs: Star2 records first, then Star3
+		return level==0 ? 10 : 6;
+	}
+
+	unsigned int zoneSize(int level, int zone)
+	{
+		// Some zones are empty
+		return (zone*7+level)%13;
+	}
+
+	char recordByte(int zone, int star, int byte)
+	{
+		return static_cast<char>((zone*31+star*7+byte)&0xff);
+	}
+
+	bool checkZone(const char* data, int level, int zone)
+	{
+		for (unsigned int s=0; s<zoneSize(level, zone); ++s)
+			for (int b=0; b<recordSize(level); ++b)
+				if (data[s*recordSize(level)+b]!=recordByte(zone, s, b))
+					return false;
+		return true;
+	}
+
+	qint64 zoneBytes(int level, int zone)
+	{
+		return static_cast<qint64>(zoneSize(level, zone))*recordSize(level);
+	}
+
+	//! Write a catalog in the format of the star catalogs, with the zone table in native byte order or swapped
+	bool writeCatalog(const QString& path, int level, bool swapped)
+	{
+		QFile file(path);
+		if (!file.open(QIODevice::WriteOnly))
+			return false;
+		QDataStream out(&file);
+		out.setByteOrder(swapped==(QSysInfo::ByteOrder==QSysInfo::LittleEndian) ? QDataStream::BigEndian : QDataStream::LittleEndian);
+		out << CatalogMagic << quint32(level==0 ? 1 : 2) << quint32(0) << quint32(0) << quint32(level)
+		    << quint32(6000+1500*level) << quint32(1500) << quint32(level==0 ? 127 : 31);
+		for (int z=0; z<nrOfZones(level); ++z)
+			out << quint32(zoneSize(level, z));
+		for (int z=0; z<nrOfZones(level); ++z)
+			for (unsigned int s=0; s<zoneSize(level, z); ++s)
+				for (int b=0; b<recordSize(level); ++b)
+					out << static_cast<qint8>(recordByte(z, s, b));
+		return out.status()==QDataStream::Ok;
+	}
+
+	//! Open a catalog and skip its header, like ZoneArray::create() does
+	bool openCatalog(QFile& file)
+	{
+		return file.open(QIODevice::ReadOnly) && file.seek(HeaderSize);
+	}
+}
+
+void TestStarZonePager::initTestCase()
+{
+	QVERIFY(tempDir.isValid());
+	for (int level=0; level<NrOfLevels; ++level)
+	{
+		const QString path = tempDir.path()+QString("/stars_%1.cat").arg(level);
+		QVERIFY(writeCatalog(path, level, false));
+		catalogs << path;
+	}
+}
+
+void TestStarZonePager::testZoneTable()
+{
+	for (int level=0; level<NrOfLevels; ++level)
+	{
+		QFile file(catalogs.at(level));
+		QVERIFY(openCatalog(file));
+		StarZonePager pager(&file, nrOfZones(level), recordSize(level), false, 1024*1024);
+		QVERIFY(pager.isValid());
+		QCOMPARE(pager.getNrOfZones(), nrOfZones(level));
+		quint64 total = 0;
+		for (int z=0; z<nrOfZones(level); ++z)
+		{
+			QCOMPARE(pager.getZoneSize(z), zoneSize(level, z));
+			QVERIFY(!pager.isZoneResident(z));
+			total += zoneSize(level, z);
+		}
+		QCOMPARE(pager.getNrOfRecords(), total);
+		// Nothing is read before the zones are used
+		QCOMPARE(pager.getResidentZones(), 0);
+		QCOMPARE(pager.getResidentBytes(), Q_INT64_C(0));
+		QCOMPARE(pager.getLoadCount(), Q_UINT64_C(0));
+	}
+}
+
+void TestStarZonePager::testLoadOnDemand()
+{
+	const int level = 1;
+	QFile file(catalogs.at(level));
+	QVERIFY(openCatalog(file));
+	StarZonePager pager(&file, nrOfZones(level), recordSize(level), false, 1024*1024);
+	QVERIFY(pager.isValid());
+
+	qint64 expectedBytes = 0;
+	int expectedZones = 0;
+	const int zones[] = {1, 5, 42, 79};
+	for (int z : zones)
+	{
+		QVERIFY(zoneSize(level, z)>0);
+		const char* data = pager.getZone(z);
+		QVERIFY(data!=Q_NULLPTR);
+		QVERIFY(checkZone(data, level, z));
+		QVERIFY(pager.isZoneResident(z));
+		expectedBytes += zoneBytes(level, z);
+		++expectedZones;
+		QCOMPARE(pager.getResidentBytes(), expectedBytes);
+		QCOMPARE(pager.getResidentZones(), expectedZones);
+	}
+	QCOMPARE(pager.getLoadCount(), Q_UINT64_C(4));
+
+	// Loaded zones are not read again
+	QVERIFY(checkZone(pager.getZone(42), level, 42));
+	QCOMPARE(pager.getLoadCount(), Q_UINT64_C(4));
+
+	// Empty zones are never loaded
+	QCOMPARE(zoneSize(level, 11), 0u);
+	QVERIFY(pager.getZone(11)==Q_NULLPTR);
+	QVERIFY(!pager.isZoneResident(11));
+	QCOMPARE(pager.getLoadCount(), Q_UINT64_C(4));
+
+	pager.clear();
+	QCOMPARE(pager.getResidentZones(), 0);
+	QCOMPARE(pager.getResidentBytes(), Q_INT64_C(0));
+}
+
+void TestStarZonePager::testResidentLimit()
+{
+	const int level = 2;
+	const qint64 maxBytes = 200;
+	QFile file(catalogs.at(level));
+	QVERIFY(openCatalog(file));
+	StarZonePager pager(&file, nrOfZones(level), recordSize(level), false, maxBytes);
+	QVERIFY(pager.isValid());
+
+	// One zone per frame, the least recently used zones are unloaded
+	for (int z=0; z<nrOfZones(level); ++z)
+	{
+		pager.beginFrame();
+		const char* data = pager.getZone(z);
+		QVERIFY(zoneSize(level, z)==0 || checkZone(data, level, z));
+		QVERIFY(pager.getResidentBytes()<=maxBytes);
+	}
+	QVERIFY(pager.getEvictionCount()>0);
+	QVERIFY(!pager.isZoneResident(1));
+	QVERIFY(pager.isZoneResident(nrOfZones(level)-1));
+	QCOMPARE(pager.getLoadCount()-pager.getEvictionCount(), static_cast<quint64>(pager.getResidentZones()));
+
+	// An unloaded zone is read again with the same content
+	const quint64 loads = pager.getLoadCount();
+	pager.beginFrame();
+	QVERIFY(checkZone(pager.getZone(1), level, 1));
+	QCOMPARE(pager.getLoadCount(), loads+1);
+
+	// Lowering the limit unloads zones from earlier frames
+	pager.beginFrame();
+	pager.setMaxResidentBytes(0);
+	QCOMPARE(pager.getResidentZones(), 0);
+	QCOMPARE(pager.getResidentBytes(), Q_INT64_C(0));
+}
+
+void TestStarZonePager::testFrameZonesStayLoaded()
+{
+	const int level = 1;
+	QFile file(catalogs.at(level));
+	QVERIFY(openCatalog(file));
+	StarZonePager pager(&file, nrOfZones(level), recordSize(level), false, 1);
+	QVERIFY(pager.isValid());
+
+	// The limit is exceeded while a frame needs the zones
+	pager.beginFrame();
+	QList<const char*> frameData;
+	for (int z=1; z<=5; ++z)
+		frameData << pager.getZone(z);
+	QCOMPARE(pager.getResidentZones(), 5);
+	for (int z=1; z<=5; ++z)
+	{
+		QVERIFY(pager.isZoneResident(z));
+		QVERIFY(checkZone(frameData.at(z-1), level, z));
+	}
+
+	// ...and the zones of the previous frame are unloaded as soon as another one is read
+	pager.beginFrame();
+	QVERIFY(checkZone(pager.getZone(3), level, 3));
+	QCOMPARE(pager.getResidentZones(), 5);
+	QVERIFY(checkZone(pager.getZone(6), level, 6));
+	QCOMPARE(pager.getResidentZones(), 2);
+	QVERIFY(pager.isZoneResident(3));
+	QVERIFY(pager.isZoneResident(6));
+	QCOMPARE(pager.getResidentBytes(), zoneBytes(level, 3)+zoneBytes(level, 6));
+}
+
+void TestStarZonePager::testMultiLevel()
+{
+	const qint64 baseTotal = StarZonePager::getTotalResidentBytes();
+	const qint64 maxBytes = 512;
+	QList<QFile*> files;
+	QList<StarZonePager*> pagers;
+	for (int level=0; level<NrOfLevels; ++level)
+	{
+		QFile* file = new QFile(catalogs.at(level));
+		QVERIFY(openCatalog(*file));
+		files << file;
+		pagers << new StarZonePager(file, nrOfZones(level), recordSize(level), false, maxBytes);
+		QVERIFY(pagers.last()->isValid());
+	}
+	QCOMPARE(StarZonePager::getTotalResidentBytes(), baseTotal);
+
+	// Draw a few frames over the whole sky, zone after zone on all levels
+	for (int frame=0; frame<3; ++frame)
+	{
+		for (int level=0; level<NrOfLevels; ++level)
+		{
+			for (int z=0; z<nrOfZones(level); ++z)
+			{
+				pagers.at(level)->beginFrame();
+				const char* data = pagers.at(level)->getZone(z);
+				QVERIFY(zoneSize(level, z)==0 || checkZone(data, level, z));
+			}
+		}
+	}
+
+	qint64 sum = 0;
+	for (int level=0; level<NrOfLevels; ++level)
+	{
+		QVERIFY(pagers.at(level)->getResidentBytes()<=maxBytes);
+		sum += pagers.at(level)->getResidentBytes();
+	}
+	QCOMPARE(StarZonePager::getTotalResidentBytes(), baseTotal+sum);
+	QVERIFY(sum<=NrOfLevels*maxBytes);
+
+	qDeleteAll(pagers);
+	qDeleteAll(files);
+	QCOMPARE(StarZonePager::getTotalResidentBytes(), baseTotal);
+}
+
+void TestStarZonePager::testInvalidCatalog()
+{
+	const int level = 1;
+
+	// Zone table in the other byte order
+	const QString swappedPath = tempDir.path()+"/swapped.cat";
+	QVERIFY(writeCatalog(swappedPath, level, true));
+	QFile swapped(swappedPath);
+	QVERIFY(openCatalog(swapped));
+	StarZonePager swappedPager(&swapped, nrOfZones(level), recordSize(level), true, 1024);
+	QVERIFY(swappedPager.isValid());
+	QCOMPARE(swappedPager.getZoneSize(5), zoneSize(level, 5));
+	QVERIFY(checkZone(swappedPager.getZone(5), level, 5));
+
+	// Truncated star records
+	const QString truncatedPath = tempDir.path()+"/truncated.cat";
+	QVERIFY(QFile::copy(catalogs.at(level), truncatedPath));
+	QFile truncated(truncatedPath);
+	QVERIFY(truncated.resize(truncated.size()-1));
+	QVERIFY(openCatalog(truncated));
+	StarZonePager truncatedPager(&truncated, nrOfZones(level), recordSize(level), false, 1024);
+	QVERIFY(!truncatedPager.isValid());
+	QCOMPARE(truncatedPager.getNrOfRecords(), Q_UINT64_C(0));
+
+	// Truncated zone table
+	truncated.close();
+	QVERIFY(truncated.resize(HeaderSize+10));
+	QVERIFY(openCatalog(truncated));
+	StarZonePager tablePager(&truncated, nrOfZones(level), recordSize(level), false, 1024);
+	QVERIFY(!tablePager.isValid());
+}
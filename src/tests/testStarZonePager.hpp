@@ -0,0 +1,46 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#ifndef _TESTSTARZONEPAGER_HPP_
+#define _TESTSTARZONEPAGER_HPP_
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+class TestStarZonePager : public QObject
+{
+Q_OBJECT
+private slots:
+	void initTestCase();
+	void testZoneTable();
+	void testLoadOnDemand();
+	void testResidentLimit();
+	void testFrameZonesStayLoaded();
+	void testMultiLevel();
+	void testInvalidCatalog();
+
+private:
+	QTemporaryDir tempDir;
+	//! Paths of the synthetic catalogs, one per level
+	QStringList catalogs;
+};
+
+#endif // _TESTSTARZONEPAGER_HPP_
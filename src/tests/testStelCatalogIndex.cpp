@@ -0,0 +1,273 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStelCatalogIndex.hpp"
+
+#include <QElapsedTimer>
+#include <QSet>
+
+#include <random>
+
+#include "StelCatalogIndex.hpp"
+
+QTEST_GUILESS_MAIN(TestStelCatalogIndex)
+
+namespace
+{
+struct TestObject
+{
+	TestObject(int id, const Vec3d& pos) : id(id), pos(pos) {}
+	int id;
+	Vec3d pos;
+};
+typedef QSharedPointer<TestObject> TestObjectP;
+typedef StelCatalogIndex<TestObject> TestIndex;
+
+std::mt19937 generator(42);
+
+Vec3d randomPosition()
+{
+	std::normal_distribution<double> normal;
+	Vec3d v(normal(generator), normal(generator), normal(generator));
+	v.normalize();
+	return v;
+}
+
+//! A random position inside the cap
+Vec3d randomPositionIn(const SphericalCap& cap)
+{
+	Vec3d v;
+	do
+	{
+		v = randomPosition();
+	} while (!cap.contains(v));
+	return v;
+}
+
+//! A random position outside the cap
+Vec3d randomPositionOutside(const SphericalCap& cap)
+{
+	Vec3d v;
+	do
+	{
+		v = randomPosition();
+	} while (cap.contains(v));
+	return v;
+}
+
+void insert(TestIndex& index, const Vec3d& pos)
+{
+	index.insert(TestObjectP(new TestObject(index.size(), pos)), pos, QStringList(QString("Object %1").arg(index.size())));
+}
+
+QSet<int> ids(const QVector<TestObjectP>& objects)
+{
+	QSet<int> result;
+	foreach (const TestObjectP& obj, objects)
+		result.insert(obj->id);
+	return result;
+}
+
+QSet<int> linearSearch(const TestIndex& index, const SphericalRegion& region)
+{
+	QSet<int> result;
+	foreach (const TestObjectP& obj, index.getObjects())
+	{
+		if (region.contains(obj->pos))
+			result.insert(obj->id);
+	}
+	return result;
+}
+
+//! Stand-in for the per object work of a draw() method: a projection and a magnitude test
+double drawObjects(const QVector<TestObjectP>& objects, const Vec3d& center)
+{
+	double sum = 0.;
+	foreach (const TestObjectP& obj, objects)
+	{
+		const double d = obj->pos.dot(center);
+		if (d > 0.)
+			sum += obj->pos[0]/d + obj->pos[1]/d;
+	}
+	return sum;
+}
+
+//! Measure the average time of culling and drawing a frame with the index, and with a scan of all the objects
+void measureFrame(const TestIndex& index, const SphericalCap& viewport, int frames, double& indexedUs, double& linearUs, int& visible)
+{
+	QVector<TestObjectP> found;
+	QVector<TestObjectP> scanned;
+	double sum = 0.;
+	QElapsedTimer timer;
+
+	timer.start();
+	for (int i=0; i<frames; ++i)
+	{
+		index.findInRegion(&viewport, found);
+		sum += drawObjects(found, viewport.n);
+	}
+	indexedUs = timer.nsecsElapsed()/1000./frames;
+
+	timer.start();
+	for (int i=0; i<frames; ++i)
+	{
+		scanned.clear();
+		foreach (const TestObjectP& obj, index.getObjects())
+		{
+			if (viewport.contains(obj->pos))
+				scanned.append(obj);
+		}
+		sum -= drawObjects(scanned, viewport.n);
+	}
+	linearUs = timer.nsecsElapsed()/1000./frames;
+
+	QVERIFY(std::fabs(sum) < 1e-6*frames*(found.size()+1));
+	QCOMPARE(found.size(), scanned.size());
+	visible = found.size();
+}
+}
+
+void TestStelCatalogIndex::testFindInRegion()
+{
+	TestIndex index;
+	for (int i=0; i<20000; ++i)
+		insert(index, randomPosition());
+	QCOMPARE(index.size(), 20000);
+
+	QVector<TestObjectP> found;
+	// Caps of several sizes
+	for (int i=0; i<20; ++i)
+	{
+		const SphericalCap cap(randomPosition(), std::cos((0.5+i*4.)*M_PI/180.));
+		index.findInRegion(&cap, found);
+		QCOMPARE(ids(found), linearSearch(index, cap));
+	}
+
+	// A square field like a viewport, seen along the x axis
+	const double t = std::tan(10.*M_PI/180.);
+	Vec3d a(1,-t,-t), b(1,-t,t), c(1,t,t), d(1,t,-t);
+	a.normalize(); b.normalize(); c.normalize(); d.normalize();
+	const SphericalConvexPolygon square(a, b, c, d);
+	QVERIFY(square.checkValid());
+	index.findInRegion(&square, found);
+	QVERIFY(!found.isEmpty());
+	QCOMPARE(ids(found), linearSearch(index, square));
+
+	// The result is cleared before each search
+	const SphericalCap empty(Vec3d(0,0,1), 1.);
+	index.findInRegion(&empty, found);
+	QVERIFY(found.isEmpty());
+
+	index.clear();
+	QVERIFY(index.isEmpty());
+	index.findInRegion(&square, found);
+	QVERIFY(found.isEmpty());
+}
+
+void TestStelCatalogIndex::testSearchAround()
+{
+	TestIndex index;
+	for (int i=0; i<5000; ++i)
+		insert(index, randomPosition());
+
+	for (int i=0; i<10; ++i)
+	{
+		// The position does not need to be normalized
+		const Vec3d v = randomPosition()*3.;
+		const double fov = 2.+i;
+		QSet<int> expected;
+		foreach (const TestObjectP& obj, index.getObjects())
+		{
+			Vec3d n(v);
+			n.normalize();
+			if (obj->pos.dot(n) >= std::cos(fov*M_PI/180.))
+				expected.insert(obj->id);
+		}
+		QCOMPARE(ids(index.searchAround(v, fov)), expected);
+	}
+}
+
+void TestStelCatalogIndex::testSearchByName()
+{
+	TestIndex index;
+	const TestObjectP first(new TestObject(0, Vec3d(1,0,0)));
+	const TestObjectP second(new TestObject(1, Vec3d(0,1,0)));
+	index.insert(first, first->pos, QStringList() << "Nova Cygni 1975" << "V1500 Cyg");
+	index.insert(second, second->pos, QStringList() << "Other" << "V1500 CYG" << QString());
+
+	QCOMPARE(index.searchByName("nova cygni 1975"), first);
+	QCOMPARE(index.searchByName("NOVA CYGNI 1975"), first);
+	// The first inserted object wins when names are shared
+	QCOMPARE(index.searchByName("v1500 cyg"), first);
+	QCOMPARE(index.searchByName("Other"), second);
+	QVERIFY(index.searchByName("Unknown").isNull());
+	QVERIFY(index.searchByName(QString()).isNull());
+}
+
+void TestStelCatalogIndex::benchmarkCatalogSize()
+{
+	// The same 1000 objects are in the field of view, the rest of the catalog is outside.
+	// The cost of a frame should depend on the visible objects, not on the size of the catalog.
+	const SphericalCap viewport(Vec3d(0.3,0.5,0.8)/Vec3d(0.3,0.5,0.8).length(), std::cos(5.*M_PI/180.));
+	const int sizes[] = {10000, 100000, 500000};
+	double firstIndexedUs = 0.;
+	for (int s=0; s<3; ++s)
+	{
+		TestIndex index;
+		for (int i=0; i<1000; ++i)
+			insert(index, randomPositionIn(viewport));
+		while (index.size()<sizes[s])
+			insert(index, randomPositionOutside(viewport));
+
+		double indexedUs, linearUs;
+		int visible;
+		measureFrame(index, viewport, 100, indexedUs, linearUs, visible);
+		QCOMPARE(visible, 1000);
+		qDebug() << QString("%1 objects, %2 visible: %3 us per frame with the index, %4 us scanning all objects")
+			    .arg(sizes[s]).arg(visible).arg(indexedUs, 0, 'f', 1).arg(linearUs, 0, 'f', 1);
+		if (s==0)
+			firstIndexedUs = indexedUs;
+		else
+			QVERIFY(indexedUs < linearUs);
+	}
+	QVERIFY(firstIndexedUs > 0.);
+}
+
+void TestStelCatalogIndex::benchmarkVisibleObjects()
+{
+	// A fixed catalog seen with a growing field of view: the cost grows with the visible objects
+	TestIndex index;
+	for (int i=0; i<200000; ++i)
+		insert(index, randomPosition());
+
+	const double fovs[] = {2., 8., 30., 90.};
+	int lastVisible = 0;
+	for (int f=0; f<4; ++f)
+	{
+		const SphericalCap viewport(Vec3d(0,0,1), std::cos(fovs[f]/2.*M_PI/180.));
+		double indexedUs, linearUs;
+		int visible;
+		measureFrame(index, viewport, 50, indexedUs, linearUs, visible);
+		qDebug() << QString("field of view %1 deg, %2 of %3 objects visible: %4 us per frame with the index, %5 us scanning all objects")
+			    .arg(fovs[f]).arg(visible).arg(index.size()).arg(indexedUs, 0, 'f', 1).arg(linearUs, 0, 'f', 1);
+		QVERIFY(visible > lastVisible);
+		lastVisible = visible;
+	}
+}
@@ -28,11 +28,40 @@
 #include <QDebug>
 #include <QTest>
 #include <QRegExp>
+#include <QFileSystemWatcher>
+#include <QThread>
 
 #include "StelFileMgr.hpp"
 
 QTEST_GUILESS_MAIN(TestStelFileMgr)
 
+namespace
+{
+	//! Looks up a file in another thread than the one of the file system watcher
+	class FindFileThread : public QThread
+	{
+	public:
+		FindFileThread(const QString& path) : path(path) {}
+		QString result;
+	protected:
+		void run() Q_DECL_OVERRIDE
+		{
+			result = StelFileMgr::findFile(path);
+		}
+	private:
+		QString path;
+	};
+
+	bool createFile(const QString& path)
+	{
+		QFile f(path);
+		if (!f.open(QIODevice::WriteOnly))
+			return false;
+		f.close();
+		return true;
+	}
+}
+
 void TestStelFileMgr::initTestCase()
 {
 	partialPath1 = "testfilemgr/path1";
@@ -286,3 +315,151 @@ void TestStelFileMgr::testListContentsDirAbs()
 	QVERIFY(resultSetQuery==resultSetQueryExpected);
 }
 
+
+void TestStelFileMgr::testFindFileCache()
+{
+	QStringList paths;
+	paths << "landscapes" << "landscapes/ls1" << "landscapes/ls1/landscape.ini" << "landscapes/ls2/landscape.ini"
+	      << "landscapes/ls3/landscape.ini" << "landscapes/dummy.txt" << "landscapes/emptydir" << "config.ini"
+	      << "inboth.txt" << "notexists" << "notexists/landscape.ini" << "landscapes/ls4/landscape.ini"
+	      << "config.ini/notexists";
+	QList<StelFileMgr::Flags> flagList;
+	flagList << (StelFileMgr::Flags)0 << StelFileMgr::File << StelFileMgr::Directory;
+
+	// Look up every path several times, like the textures of a landscape are.
+	// Files which are not found are only cached in watched directories.
+	QFileSystemWatcher watcher;
+	QStringList uncachedResults, cachedResults;
+	StelFileMgr::setCacheEnabled(false);
+	int queries = StelFileMgr::getFileSystemQueryCount();
+	for (int i=0;i<3;i++)
+		foreach (StelFileMgr::Flags flags, flagList)
+			foreach (const QString& path, paths)
+				uncachedResults << StelFileMgr::findFile(path, flags);
+	const int uncachedQueries = StelFileMgr::getFileSystemQueryCount() - queries;
+
+	StelFileMgr::setCacheEnabled(true);
+	StelFileMgr::setFileSystemWatcher(&watcher);
+	queries = StelFileMgr::getFileSystemQueryCount();
+	for (int i=0;i<3;i++)
+		foreach (StelFileMgr::Flags flags, flagList)
+			foreach (const QString& path, paths)
+				cachedResults << StelFileMgr::findFile(path, flags);
+	const int cachedQueries = StelFileMgr::getFileSystemQueryCount() - queries;
+
+	qDebug() << "file system queries without cache:" << uncachedQueries << "with cache:" << cachedQueries;
+	QCOMPARE(cachedResults, uncachedResults);
+	// each directory of the search paths which is needed is watched and listed once
+	QVERIFY(cachedQueries>0);
+	QVERIFY(cachedQueries<=20);
+	QVERIFY(cachedQueries<uncachedQueries/5);
+
+	// Found again without any query
+	queries = StelFileMgr::getFileSystemQueryCount();
+	QVERIFY(!StelFileMgr::findFile("landscapes/ls1/landscape.ini").isEmpty());
+	QVERIFY(StelFileMgr::findFile("notexists").isEmpty());
+	QCOMPARE(StelFileMgr::getFileSystemQueryCount(), queries);
+
+	QCOMPARE(StelFileMgr::findFileInAllPaths("inboth.txt").size(), 2);
+	QCOMPARE(StelFileMgr::findFileInAllPaths("landscapes/ls1", StelFileMgr::Directory).size(), 2);
+	QCOMPARE(StelFileMgr::findFileInAllPaths("landscapes/ls1", StelFileMgr::File).size(), 0);
+	QCOMPARE(StelFileMgr::getFileSystemQueryCount(), queries);
+
+	// Paths which are not plain names are not looked up in the cache
+	QVERIFY(!StelFileMgr::findFile("landscapes/../config.ini").isEmpty());
+	QVERIFY(StelFileMgr::getFileSystemQueryCount()>queries);
+
+	// Without a watcher, files which were not found are looked up again
+	StelFileMgr::setFileSystemWatcher(Q_NULLPTR);
+	QVERIFY(StelFileMgr::findFile("notexists").isEmpty());
+	queries = StelFileMgr::getFileSystemQueryCount();
+	QVERIFY(StelFileMgr::findFile("notexists").isEmpty());
+	QVERIFY(StelFileMgr::getFileSystemQueryCount()>queries);
+}
+
+void TestStelFileMgr::testCacheInvalidation()
+{
+	StelFileMgr::setCacheEnabled(true);
+	const QString newFile = partialPath2 + "/landscapes/ls3/new.txt";
+	QVERIFY(StelFileMgr::findFile("landscapes/ls3/new.txt").isEmpty());
+
+	// Written without StelFileMgr into directories which are not watched: found by the next lookup
+	QVERIFY(createFile(newFile));
+	QVERIFY(!StelFileMgr::findFile("landscapes/ls3/new.txt").isEmpty());
+	QVERIFY(!StelFileMgr::findFile("landscapes/ls3/new.txt", StelFileMgr::File).isEmpty());
+	QCOMPARE(StelFileMgr::findFileInAllPaths("landscapes/ls3/new.txt").size(), 1);
+
+	// ... also in a new directory, and where it overrides a file of a later search path
+	QVERIFY(StelFileMgr::findFile("landscapes/ls5/landscape.ini").isEmpty());
+	QVERIFY(QDir().mkdir(partialPath1 + "/landscapes/ls5"));
+	QVERIFY(!StelFileMgr::findFile("landscapes/ls5", StelFileMgr::Directory).isEmpty());
+	QVERIFY(createFile(partialPath1 + "/landscapes/ls5/landscape.ini"));
+	QVERIFY(!StelFileMgr::findFile("landscapes/ls5/landscape.ini").isEmpty());
+	QVERIFY(StelFileMgr::findFile("landscapes/dummy.txt").startsWith(workingDir + "/" + partialPath2));
+	QVERIFY(createFile(partialPath1 + "/landscapes/dummy.txt"));
+	QVERIFY(StelFileMgr::findFile("landscapes/dummy.txt").startsWith("./" + partialPath1));
+
+	// Removed without StelFileMgr: gone after the cache is invalidated
+	QVERIFY(QFile::remove(newFile));
+	QVERIFY(QFile::remove(partialPath1 + "/landscapes/dummy.txt"));
+	QVERIFY(QFile::remove(partialPath1 + "/landscapes/ls5/landscape.ini"));
+	QVERIFY(QDir(partialPath1 + "/landscapes").rmdir("ls5"));
+	StelFileMgr::invalidateCache();
+	QVERIFY(StelFileMgr::findFile("landscapes/ls3/new.txt").isEmpty());
+	QVERIFY(StelFileMgr::findFile("landscapes/ls5", StelFileMgr::Directory).isEmpty());
+	QVERIFY(StelFileMgr::findFile("landscapes/dummy.txt").startsWith(workingDir + "/" + partialPath2));
+
+	// Created with StelFileMgr: found immediately
+	QVERIFY(StelFileMgr::findFile("landscapes/newdir", StelFileMgr::Directory).isEmpty());
+	QVERIFY(StelFileMgr::mkDir(workingDir + "/" + partialPath1 + "/landscapes/newdir"));
+	QVERIFY(!StelFileMgr::findFile("landscapes/newdir", StelFileMgr::Directory).isEmpty());
+	QVERIFY(QDir(workingDir + "/" + partialPath1 + "/landscapes").rmdir("newdir"));
+	StelFileMgr::invalidateCache();
+
+	// Writable lookups are never cached
+	QVERIFY(!StelFileMgr::findFile("landscapes/ls2", StelFileMgr::Writable).isEmpty());
+}
+
+void TestStelFileMgr::testFileSystemWatcher()
+{
+	StelFileMgr::setCacheEnabled(true);
+	QFileSystemWatcher watcher;
+	StelFileMgr::setFileSystemWatcher(&watcher);
+
+	QVERIFY(StelFileMgr::findFile("landscapes/ls1/watched.txt").isEmpty());
+	QVERIFY(!watcher.directories().isEmpty());
+	// Not found in watched directories without looking again
+	int queries = StelFileMgr::getFileSystemQueryCount();
+	QVERIFY(StelFileMgr::findFile("landscapes/ls1/watched.txt").isEmpty());
+	QCOMPARE(StelFileMgr::getFileSystemQueryCount(), queries);
+	QFile f(partialPath2 + "/landscapes/ls1/watched.txt");
+	QVERIFY(f.open(QIODevice::WriteOnly));
+	f.close();
+	QTRY_VERIFY(!StelFileMgr::findFile("landscapes/ls1/watched.txt").isEmpty());
+	QVERIFY(f.remove());
+	QTRY_VERIFY(StelFileMgr::findFile("landscapes/ls1/watched.txt").isEmpty());
+
+	// A directory listed first in another thread is not watched, but its new files are still found
+	FindFileThread before("landscapes/ls2/worker.txt");
+	before.start();
+	QVERIFY(before.wait(10000));
+	QVERIFY(before.result.isEmpty());
+	QVERIFY(createFile(partialPath1 + "/landscapes/ls2/worker.txt"));
+	FindFileThread after("landscapes/ls2/worker.txt");
+	after.start();
+	QVERIFY(after.wait(10000));
+	QVERIFY(!after.result.isEmpty());
+	QVERIFY(QFile::remove(partialPath1 + "/landscapes/ls2/worker.txt"));
+	StelFileMgr::invalidateCache();
+
+	// ... and it is watched once it is used in the thread of the watcher
+	QVERIFY(StelFileMgr::findFile("landscapes/ls2/main.txt").isEmpty());
+	queries = StelFileMgr::getFileSystemQueryCount();
+	QVERIFY(StelFileMgr::findFile("landscapes/ls2/main.txt").isEmpty());
+	QCOMPARE(StelFileMgr::getFileSystemQueryCount(), queries);
+	QVERIFY(createFile(partialPath1 + "/landscapes/ls2/main.txt"));
+	QTRY_VERIFY(!StelFileMgr::findFile("landscapes/ls2/main.txt").isEmpty());
+	QVERIFY(QFile::remove(partialPath1 + "/landscapes/ls2/main.txt"));
+
+	StelFileMgr::setFileSystemWatcher(Q_NULLPTR);
+}
@@ -48,6 +48,9 @@ private slots:
 	void testListContentsFileAbs();
 	void testListContentsDir();
 	void testListContentsDirAbs();
+	void testFindFileCache();
+	void testCacheInvalidation();
+	void testFileSystemWatcher();
 
 private:
 	QTemporaryDir tempDir;
@@ -0,0 +1,296 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStelGeodesicGrid.hpp"
+
+#include <QObject>
+#include <QtDebug>
+#include <QTest>
+#include <QThread>
+
+#include <cmath>
+#include <cstdlib>
+
+#include "StelGeodesicGrid.hpp"
+
+QTEST_GUILESS_MAIN(TestStelGeodesicGrid)
+
+namespace
+{
+	enum ZoneState
+	{
+		Outside = 0,
+		Inside,
+		Border
+	};
+
+	//! A square viewport like the one searched by StarMgr
+	struct Viewport
+	{
+		Vec3d center, east, north;
+		double halfWidth;
+		QVector<SphericalCap> caps;
+	};
+
+	Viewport makeViewport(double ra, double dec, double halfWidth)
+	{
+		Viewport vp;
+		vp.center.set(std::cos(dec)*std::cos(ra), std::cos(dec)*std::sin(ra), std::sin(dec));
+		vp.east.set(-std::sin(ra), std::cos(ra), 0.);
+		vp.north = vp.center^vp.east;
+		vp.halfWidth = halfWidth;
+		// the border planes go through the origin, so the search is exact
+		const Vec3d sides[4] = {vp.east, -vp.east, vp.north, -vp.north};
+		for (int i=0;i<4;i++)
+			vp.caps << SphericalCap(vp.center*std::sin(halfWidth) - sides[i]*std::cos(halfWidth), 0.);
+		return vp;
+	}
+
+	double randomValue()
+	{
+		return static_cast<double>(qrand())/RAND_MAX;
+	}
+
+	QList<Viewport> randomViewports(int count, double halfWidth)
+	{
+		QList<Viewport> viewports;
+		for (int i=0;i<count;i++)
+			viewports << makeViewport(2.*M_PI*randomValue(), std::asin(2.*randomValue()-1.), halfWidth);
+		return viewports;
+	}
+
+	QVector<int> zoneStates(const GeodesicSearchResult& result, int level)
+	{
+		QVector<int> states(StelGeodesicGrid::nrOfZones(level), Outside);
+		int zone;
+		for (GeodesicSearchInsideIterator it(result, level);(zone = it.next()) >= 0;)
+			states[zone] = Inside;
+		for (GeodesicSearchBorderIterator it(result, level);(zone = it.next()) >= 0;)
+			states[zone] = Border;
+		return states;
+	}
+
+	//! Number of random points around the viewport which lie in a zone of the wrong state
+	int countErrors(const StelGeodesicGrid& grid, const GeodesicSearchResult& result, const Viewport& vp, int level)
+	{
+		const QVector<int> states = zoneStates(result, level);
+		int errors = 0;
+		for (int i=0;i<2000;i++)
+		{
+			Vec3d p = vp.center + vp.east*(4.*vp.halfWidth*(randomValue()-0.5)) + vp.north*(4.*vp.halfWidth*(randomValue()-0.5));
+			p.normalize();
+			bool inside = true;
+			double minDist = 1.;
+			foreach (const SphericalCap& cap, vp.caps)
+			{
+				const double dist = p*cap.n - cap.d;
+				inside = inside && dist >= 0.;
+				minDist = qMin(minDist, std::fabs(dist));
+			}
+			// avoid rounding problems of the float zone lookup
+			if (minDist < 0.00001)
+				continue;
+			const int state = states.at(grid.getZoneNumberForPoint(Vec3f(p[0], p[1], p[2]), level));
+			if ((inside && state==Outside) || (!inside && state==Inside))
+				errors++;
+		}
+		return errors;
+	}
+
+	class SearchThread : public QThread
+	{
+	public:
+		SearchThread(const StelGeodesicGrid& grid, const QList<Viewport>& viewports, int level)
+			: grid(grid), viewports(viewports), level(level), consistent(true) {}
+		void run() Q_DECL_OVERRIDE
+		{
+			states.resize(viewports.size());
+			for (int round=0;round<10;round++)
+			{
+				for (int i=0;i<viewports.size();i++)
+				{
+					GeodesicSearchResultP result = grid.search(viewports.at(i).caps, level);
+					const QVector<int> s = zoneStates(*result, level);
+					if (round==0)
+						states[i] = s;
+					else if (s!=states.at(i))
+						consistent = false;
+				}
+			}
+		}
+		const StelGeodesicGrid& grid;
+		const QList<Viewport> viewports;
+		const int level;
+		QVector<QVector<int> > states;
+		bool consistent;
+	};
+}
+
+void TestStelGeodesicGrid::testSearch_data()
+{
+	QTest::addColumn<int>("level");
+	QTest::addColumn<double>("margin");
+	QTest::newRow("level 3, no margin") << 3 << 0.;
+	QTest::newRow("level 3, margin") << 3 << 0.0001;
+	QTest::newRow("level 5, no margin") << 5 << 0.;
+	QTest::newRow("level 5, margin") << 5 << 0.0001;
+}
+
+void TestStelGeodesicGrid::testSearch()
+{
+	QFETCH(int, level);
+	QFETCH(double, margin);
+	qsrand(level);
+
+	StelGeodesicGrid grid(level);
+	grid.setSearchMargin(margin);
+	StelGeodesicGrid exactGrid(level);
+	exactGrid.setSearchMargin(0.);
+	// the normals of the moved viewport differ by less than the shift
+	const double shift = 0.000025;
+
+	foreach (const Viewport& vp, randomViewports(20, 0.2+0.3*randomValue()))
+	{
+		GeodesicSearchResultP result = grid.search(vp.caps, level);
+		QCOMPARE(countErrors(grid, *result, vp, level), 0);
+
+		const Viewport moved = makeViewport(std::atan2(vp.center[1], vp.center[0])+shift, std::asin(vp.center[2]), vp.halfWidth);
+		const int hits = grid.getSearchCacheHits();
+		GeodesicSearchResultP movedResult = grid.search(moved.caps, level);
+		QCOMPARE(grid.getSearchCacheHits()-hits, margin>0. ? 1 : 0);
+		QCOMPARE(movedResult==result, margin>0.);
+		QCOMPARE(countErrors(grid, *movedResult, moved, level), 0);
+
+		// Zones inside or outside the region within the margin are inside or outside the moved region
+		const QVector<int> states = zoneStates(*movedResult, level);
+		const QVector<int> exactStates = zoneStates(*exactGrid.search(moved.caps, level), level);
+		for (int z=0;z<states.size();z++)
+		{
+			if (states.at(z)!=Border)
+				QCOMPARE(states.at(z), exactStates.at(z));
+		}
+	}
+}
+
+void TestStelGeodesicGrid::testSearchCache()
+{
+	const int level = 4;
+	StelGeodesicGrid grid(level);
+	qsrand(1);
+	const QList<Viewport> viewports = randomViewports(StelGeodesicGrid::SearchCacheSize+1, 0.3);
+
+	// Alternating regions are all cached
+	QList<GeodesicSearchResultP> results;
+	for (int i=0;i<3;i++)
+		results << grid.search(viewports.at(i).caps, level);
+	QCOMPARE(grid.getSearchCacheMisses(), 3);
+	for (int round=0;round<5;round++)
+	{
+		for (int i=0;i<3;i++)
+			QVERIFY(grid.search(viewports.at(i).caps, level)==results.at(i));
+	}
+	QCOMPARE(grid.getSearchCacheHits(), 15);
+	QCOMPARE(grid.getSearchCacheMisses(), 3);
+
+	// Another search level is another search
+	QVERIFY(grid.search(viewports.at(0).caps, level-1)!=results.at(0));
+	QCOMPARE(grid.getSearchCacheMisses(), 4);
+
+	// The least recently used result is evicted
+	for (int i=3;i<viewports.size();i++)
+		grid.search(viewports.at(i).caps, level);
+	QCOMPARE(grid.getSearchCacheMisses(), 3+1+viewports.size()-3);
+	GeodesicSearchResultP evicted = grid.search(viewports.at(1).caps, level);
+	QVERIFY(evicted!=results.at(1));
+	QCOMPARE(zoneStates(*evicted, level), zoneStates(*results.at(1), level));
+	QCOMPARE(grid.getSearchCacheMisses(), 3+1+viewports.size()-3+1);
+
+	// A result remains valid after its grid is deleted
+	{
+		StelGeodesicGrid* tmpGrid = new StelGeodesicGrid(level);
+		GeodesicSearchResultP result = tmpGrid->search(viewports.at(1).caps, level);
+		delete tmpGrid;
+		QCOMPARE(zoneStates(*result, level), zoneStates(*evicted, level));
+	}
+
+	// Changing the margin clears the cache
+	const int misses = grid.getSearchCacheMisses();
+	grid.setSearchMargin(grid.getSearchMargin()*2.);
+	grid.search(viewports.at(1).caps, level);
+	QCOMPARE(grid.getSearchCacheMisses(), misses+1);
+}
+
+void TestStelGeodesicGrid::testConcurrentSearch()
+{
+	const int level = 5;
+	qsrand(2);
+	// more regions than cached results, so that the threads compute and evict results concurrently
+	const QList<Viewport> viewports = randomViewports(2*StelGeodesicGrid::SearchCacheSize, 0.4);
+	StelGeodesicGrid grid(level);
+
+	QList<SearchThread*> threads;
+	for (int i=0;i<4;i++)
+	{
+		threads << new SearchThread(grid, viewports, level);
+		threads.last()->start();
+	}
+	foreach (SearchThread* thread, threads)
+		QVERIFY(thread->wait(60000));
+
+	StelGeodesicGrid referenceGrid(level);
+	foreach (SearchThread* thread, threads)
+	{
+		QVERIFY(thread->consistent);
+		for (int i=0;i<viewports.size();i++)
+			QCOMPARE(thread->states.at(i), zoneStates(*referenceGrid.search(viewports.at(i).caps, level), level));
+	}
+	qDeleteAll(threads);
+	QCOMPARE(grid.getSearchCacheHits()+grid.getSearchCacheMisses(), 4*10*viewports.size());
+}
+
+void TestStelGeodesicGrid::benchmarkMovingViewport_data()
+{
+	QTest::addColumn<double>("margin");
+	QTest::addColumn<double>("step");
+	QTest::newRow("still viewport") << 0. << 0.;
+	QTest::newRow("moving viewport, no margin") << 0. << 0.00001;
+	QTest::newRow("moving viewport, margin") << 0.00005 << 0.00001;
+}
+
+void TestStelGeodesicGrid::benchmarkMovingViewport()
+{
+	QFETCH(double, margin);
+	QFETCH(double, step);
+	const int level = 7;
+	StelGeodesicGrid grid(level);
+	grid.setSearchMargin(margin);
+	// the viewport and two other regions searched in each frame
+	const Viewport region1 = makeViewport(1., 0.5, 0.05);
+	const Viewport region2 = makeViewport(2., -0.5, 0.05);
+	int frame = 0;
+	QBENCHMARK
+	{
+		const Viewport vp = makeViewport(step*frame++, 0.3, 0.4);
+		grid.search(vp.caps, level);
+		grid.search(region1.caps, level);
+		grid.search(region2.caps, level);
+	}
+	qDebug() << "cache hits:" << grid.getSearchCacheHits() << "misses:" << grid.getSearchCacheMisses();
+}
@@ -0,0 +1,287 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+
+#include "tests/testStelLocationIndex.hpp"
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+#include "StelLocationIndex.hpp"
+
+QTEST_GUILESS_MAIN(TestStelLocationIndex)
+
+namespace
+{
+	typedef QMap<QString, StelLocation> Locations;
+
+	//! Tolerance in degrees for locations on the border of a search cap. The index computes in floats.
+	const double BORDER_TOLERANCE=0.01;
+
+	//! Angular distance in degrees by the haversine formula in double precision.
+	double bruteDistance(double long1, double lat1, double long2, double lat2)
+	{
+		const double d2r=M_PI/180.;
+		const double sinDLat=std::sin(0.5*(lat2-lat1)*d2r);
+		const double sinDLong=std::sin(0.5*(long2-long1)*d2r);
+		const double h=sinDLat*sinDLat+std::cos(lat1*d2r)*std::cos(lat2*d2r)*sinDLong*sinDLong;
+		return 2.*std::asin(std::sqrt(qBound(0., h, 1.)))/d2r;
+	}
+
+	StelLocation makeLocation(const QString& planet, const QString& country, float longitude, float latitude)
+	{
+		StelLocation loc;
+		loc.planetName=planet;
+		loc.country=country;
+		loc.longitude=longitude;
+		loc.latitude=latitude;
+		return loc;
+	}
+
+	//! Scattered locations on Earth, plus some at the poles, on the date line and on top of each other,
+	//! and a few on Mars which must never be found by queries for Earth.
+	Locations makeLocations(int count)
+	{
+		Locations locations;
+		qsrand(20180101);
+		for (int i=0; i<count; ++i)
+		{
+			const float longitude=qrand()*360.f/RAND_MAX-180.f;
+			// uniform over the sphere
+			const float latitude=std::asin(2.f*qrand()/RAND_MAX-1.f)*180.f/M_PI;
+			locations.insert(QString("Earth %1").arg(i), makeLocation("Earth", QString("Country %1").arg(i%7), longitude, latitude));
+		}
+		const float special[][2] = {
+			{0.f, 90.f}, {123.f, 90.f}, {-45.f, 89.9f}, {170.f, 89.5f},
+			{0.f, -90.f}, {-77.f, -90.f}, {10.f, -89.95f},
+			{180.f, 0.f}, {-180.f, 0.5f}, {179.99f, -0.5f}, {-179.99f, 10.f}, {179.5f, 45.f}, {-179.5f, 45.f},
+			{0.f, 0.f}, {-0.01f, 0.f}, {0.01f, 0.f},
+			{13.4f, 52.5f}, {13.4f, 52.5f}, {13.4f, 52.5f}
+		};
+		for (unsigned int i=0; i<sizeof(special)/sizeof(special[0]); ++i)
+			locations.insert(QString("Special %1").arg(i), makeLocation("Earth", "Special", special[i][0], special[i][1]));
+		for (int i=0; i<20; ++i)
+			locations.insert(QString("Mars %1").arg(i), makeLocation("Mars", "Special", i*18.f-180.f, i*9.f-90.f));
+		return locations;
+	}
+
+	//! The locations of @param planet with their distance, sorted by increasing distance.
+	QVector<QPair<double, QString> > bruteDistances(const Locations& locations, const QString& planet, float longitude, float latitude)
+	{
+		QVector<QPair<double, QString> > result;
+		for (Locations::ConstIterator iter=locations.constBegin(); iter!=locations.constEnd(); ++iter)
+		{
+			if (iter->planetName==planet)
+				result.append(qMakePair(bruteDistance(longitude, latitude, iter->longitude, iter->latitude), iter.key()));
+		}
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	//! Common query centers: the poles, both sides of the date line, longitude 0 and some ordinary places.
+	void addCenters(const char* query)
+	{
+		const struct { const char* name; float longitude, latitude; } centers[] = {
+			{"north pole", 0.f, 90.f},
+			{"near north pole", 100.f, 89.7f},
+			{"south pole", -30.f, -90.f},
+			{"near south pole", -170.f, -89.2f},
+			{"date line east", 180.f, 0.f},
+			{"date line west", -180.f, 0.2f},
+			{"west of date line", 179.8f, 44.8f},
+			{"east of date line", -179.8f, -30.f},
+			{"prime meridian", 0.f, 0.f},
+			{"Berlin", 13.4f, 52.5f},
+			{"Cape Town", 18.4f, -33.9f},
+			{"high latitude", -60.f, 78.f}
+		};
+		for (unsigned int i=0; i<sizeof(centers)/sizeof(centers[0]); ++i)
+		{
+			QTest::newRow(qPrintable(QString("%1, %2").arg(centers[i].name).arg(query)))
+				<< centers[i].longitude << centers[i].latitude;
+		}
+	}
+
+	Locations testLocations;
+	StelLocationIndex testIndex;
+}
+
+void TestStelLocationIndex::initTestCase()
+{
+	testLocations=makeLocations(5000);
+	testIndex.build(testLocations);
+}
+
+void TestStelLocationIndex::testEmptyIndex()
+{
+	StelLocationIndex index;
+	QVERIFY(index.findWithin("Earth", 0.f, 0.f, 180.f).isEmpty());
+	QVERIFY(index.findNearest("Earth", 0.f, 90.f, 10).isEmpty());
+	QVERIFY(index.findInCountry("Special").isEmpty());
+
+	index.build(Locations());
+	QVERIFY(index.findWithin("Earth", 0.f, 0.f, 180.f).isEmpty());
+	QVERIFY(index.findNearest("Earth", 0.f, 0.f, 1).isEmpty());
+
+	// A planet without locations, and an index cleared after use
+	QVERIFY(testIndex.findWithin("Jupiter", 0.f, 0.f, 180.f).isEmpty());
+	QVERIFY(testIndex.findNearest("Jupiter", 0.f, 0.f, 5).isEmpty());
+	index.build(testLocations);
+	QVERIFY(!index.findNearest("Earth", 0.f, 0.f, 1).isEmpty());
+	index.clear();
+	QVERIFY(index.findWithin("Earth", 0.f, 0.f, 180.f).isEmpty());
+	QVERIFY(index.findInCountry("Special").isEmpty());
+}
+
+void TestStelLocationIndex::testFindWithin_data()
+{
+	QTest::addColumn<float>("longitude");
+	QTest::addColumn<float>("latitude");
+	addCenters("within");
+}
+
+void TestStelLocationIndex::testFindWithin()
+{
+	QFETCH(float, longitude);
+	QFETCH(float, latitude);
+	const QVector<QPair<double, QString> > expected=bruteDistances(testLocations, "Earth", longitude, latitude);
+
+	const float radii[] = { 0.f, 0.3f, 1.f, 2.5f, 10.f, 45.f, 89.f, 91.f, 135.f, 179.5f, 180.f, 200.f };
+	for (unsigned int r=0; r<sizeof(radii)/sizeof(radii[0]); ++r)
+	{
+		const float radius=radii[r];
+		const QVector<QPair<float, QString> > found=testIndex.findWithin("Earth", longitude, latitude, radius);
+		QSet<QString> foundIds;
+		for (int i=0; i<found.size(); ++i)
+		{
+			QVERIFY2(!foundIds.contains(found.at(i).second), qPrintable(QString("%1 found twice within %2").arg(found.at(i).second).arg(radius)));
+			foundIds.insert(found.at(i).second);
+		}
+		for (int i=0; i<expected.size(); ++i)
+		{
+			const double distance=expected.at(i).first;
+			const QString& id=expected.at(i).second;
+			if (radius<180.f && std::fabs(distance-radius)<BORDER_TOLERANCE)
+			{
+				foundIds.remove(id);
+				continue;
+			}
+			if (distance<radius || radius>=180.f)
+			{
+				QVERIFY2(foundIds.remove(id), qPrintable(QString("%1 at %2 deg not found within %3").arg(id).arg(distance).arg(radius)));
+			}
+		}
+		// Everything left was found, but is outside of the radius (or on another planet)
+		QVERIFY2(foundIds.isEmpty(), qPrintable(QString("%1 found within %2").arg(QStringList(foundIds.toList()).join(", ")).arg(radius)));
+	}
+}
+
+void TestStelLocationIndex::testFindNearest_data()
+{
+	QTest::addColumn<float>("longitude");
+	QTest::addColumn<float>("latitude");
+	addCenters("nearest");
+}
+
+void TestStelLocationIndex::testFindNearest()
+{
+	QFETCH(float, longitude);
+	QFETCH(float, latitude);
+	const QVector<QPair<double, QString> > expected=bruteDistances(testLocations, "Earth", longitude, latitude);
+
+	// k larger than the number of locations returns all of them
+	const int counts[] = { 0, 1, 2, 3, 10, 100, 1000, expected.size()-1, expected.size(), expected.size()+1, 10*expected.size() };
+	for (unsigned int c=0; c<sizeof(counts)/sizeof(counts[0]); ++c)
+	{
+		const int count=counts[c];
+		const QStringList found=testIndex.findNearest("Earth", longitude, latitude, count);
+		QCOMPARE(found.size(), qBound(0, count, expected.size()));
+		QCOMPARE(found.toSet().size(), found.size());
+		// Compare the distances instead of the IDs, equally distant locations may come in any order
+		for (int i=0; i<found.size(); ++i)
+		{
+			const Locations::ConstIterator loc=testLocations.constFind(found.at(i));
+			QVERIFY(loc!=testLocations.constEnd());
+			QCOMPARE(loc->planetName, QString("Earth"));
+			const double distance=bruteDistance(longitude, latitude, loc->longitude, loc->latitude);
+			QVERIFY2(std::fabs(distance-expected.at(i).first)<BORDER_TOLERANCE,
+				 qPrintable(QString("%1. nearest for k=%2 is %3 at %4 deg, expected %5 at %6 deg")
+					    .arg(i+1).arg(count).arg(found.at(i)).arg(distance)
+					    .arg(expected.at(i).second).arg(expected.at(i).first)));
+		}
+	}
+}
+
+void TestStelLocationIndex::testFindInCountry()
+{
+	QMap<QString, QStringList> expected;
+	for (Locations::ConstIterator iter=testLocations.constBegin(); iter!=testLocations.constEnd(); ++iter)
+		expected[iter->country].append(iter.key());
+	for (QMap<QString, QStringList>::ConstIterator iter=expected.constBegin(); iter!=expected.constEnd(); ++iter)
+	{
+		QStringList found=testIndex.findInCountry(iter.key());
+		found.sort();
+		QStringList ids=iter.value();
+		ids.sort();
+		QCOMPARE(found, ids);
+	}
+	QVERIFY(testIndex.findInCountry("Atlantis").isEmpty());
+}
+
+void TestStelLocationIndex::benchmarkFindWithin()
+{
+	// About the size of the location database
+	const Locations locations=makeLocations(150000);
+	StelLocationIndex index;
+	QElapsedTimer timer;
+	timer.start();
+	index.build(locations);
+	qDebug() << "Building the index of" << locations.size() << "locations:" << timer.elapsed() << "ms";
+
+	int found=0;
+	timer.restart();
+	for (int i=0; i<100; ++i)
+		found+=index.findWithin("Earth", i*3.6f-180.f, i*1.6f-80.f, 1.f).size();
+	const qint64 indexed=qMax(timer.nsecsElapsed(), Q_INT64_C(1));
+	int bruteFound=0;
+	timer.restart();
+	for (int i=0; i<100; ++i)
+	{
+		for (Locations::ConstIterator iter=locations.constBegin(); iter!=locations.constEnd(); ++iter)
+		{
+			if (iter->planetName=="Earth" && bruteDistance(i*3.6f-180.f, i*1.6f-80.f, iter->longitude, iter->latitude)<=1.)
+				++bruteFound;
+		}
+	}
+	const qint64 brute=timer.nsecsElapsed();
+	qDebug() << "100 queries of 1 deg radius:" << indexed/1000 << "us indexed," << brute/1000 << "us scanning all locations";
+	QVERIFY(qAbs(found-bruteFound)<=2);
+
+	QBENCHMARK
+	{
+		index.findNearest("Earth", 13.4f, 52.5f, 20);
+	}
+}
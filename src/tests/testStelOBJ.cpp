@@ -0,0 +1,252 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStelOBJ.hpp"
+
+#include "StelOBJ.hpp"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QtDebug>
+
+#include <cmath>
+
+QTEST_GUILESS_MAIN(TestStelOBJ)
+
+namespace
+{
+	//! Grid size of the generated terrain, which gives a file of several MB
+	const int GRID = 400;
+
+	//! Writes a terrain on a GRID x GRID grid, in two objects, with a material per band of rows.
+	//! With @p relative, the faces of the second object reference their vertices with negative indices,
+	//! which resolve to the positions at the start of the file, many chunks before.
+	void writeTerrain(const QString& path, bool relative)
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+		QTextStream out(&file);
+		out << "# generated terrain\n";
+		out << "mtllib terrain.mtl\n";
+		for(int y = 0; y<GRID; ++y)
+			for(int x = 0; x<GRID; ++x)
+				out << "v " << x << ' ' << y << ' ' << 10.0*std::sin(x*0.05)*std::cos(y*0.07) << '\n';
+		for(int y = 0; y<GRID; ++y)
+			for(int x = 0; x<GRID; ++x)
+				out << "vt " << x/double(GRID) << ' ' << y/double(GRID) << '\n';
+
+		const int count = GRID*GRID;
+		for(int y = 0; y<GRID-1; ++y)
+		{
+			if(y==0)
+				out << "o north\n";
+			else if(y==GRID/2)
+				out << "o south\n";
+			if(y%20==0)
+				out << "usemtl " << ((y/20)%2 ? "rock" : "grass") << '\n';
+			for(int x = 0; x<GRID-1; ++x)
+			{
+				int idx[4] = { y*GRID+x+1, y*GRID+x+2, (y+1)*GRID+x+2, (y+1)*GRID+x+1 };
+				out << 'f';
+				for(int i = 0; i<4; ++i)
+				{
+					const int ref = (relative && y>=GRID/2) ? idx[i]-count-1 : idx[i];
+					out << ' ' << ref << '/' << ref;
+				}
+				out << '\n';
+			}
+		}
+	}
+
+	void writeMaterials(const QString& path, float rockShininess)
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Text));
+		QTextStream out(&file);
+		out << "newmtl grass\nKd 0.1 0.6 0.1\nmap_Kd grass.png\n\n";
+		out << "newmtl rock\nKd 0.5 0.5 0.5\nNs " << rockShininess << "\nbump_multiplier 0.5\n";
+	}
+
+	const StelOBJ::Material& material(const StelOBJ& obj, const QString& name)
+	{
+		const StelOBJ::MaterialList& list = obj.getMaterialList();
+		for(int i = 0; i<list.size(); ++i)
+			if(list.at(i).name==name)
+				return list.at(i);
+		return list.first();
+	}
+
+	void compare(const StelOBJ& a, const StelOBJ& b)
+	{
+		QVERIFY(a.getVertexList()==b.getVertexList());
+		QVERIFY(a.getIndexList()==b.getIndexList());
+
+		QCOMPARE(a.getMaterialList().size(), b.getMaterialList().size());
+		for(int i = 0; i<a.getMaterialList().size(); ++i)
+		{
+			const StelOBJ::Material& ma = a.getMaterialList().at(i);
+			const StelOBJ::Material& mb = b.getMaterialList().at(i);
+			QCOMPARE(ma.name, mb.name);
+			QCOMPARE(ma.Kd, mb.Kd);
+			QCOMPARE(ma.Ns, mb.Ns);
+			QCOMPARE(ma.map_Kd, mb.map_Kd);
+			QCOMPARE(ma.additionalParams, mb.additionalParams);
+		}
+
+		QCOMPARE(a.getObjectList().size(), b.getObjectList().size());
+		QCOMPARE(a.getObjectMap(), b.getObjectMap());
+		for(int i = 0; i<a.getObjectList().size(); ++i)
+		{
+			const StelOBJ::Object& oa = a.getObjectList().at(i);
+			const StelOBJ::Object& ob = b.getObjectList().at(i);
+			QCOMPARE(oa.name, ob.name);
+			QCOMPARE(oa.groups.size(), ob.groups.size());
+			QCOMPARE(oa.boundingbox.min, ob.boundingbox.min);
+			QCOMPARE(oa.boundingbox.max, ob.boundingbox.max);
+			for(int j = 0; j<oa.groups.size(); ++j)
+			{
+				QCOMPARE(oa.groups.at(j).startIndex, ob.groups.at(j).startIndex);
+				QCOMPARE(oa.groups.at(j).indexCount, ob.groups.at(j).indexCount);
+				QCOMPARE(oa.groups.at(j).materialIndex, ob.groups.at(j).materialIndex);
+				QCOMPARE(oa.groups.at(j).centroid, ob.groups.at(j).centroid);
+			}
+		}
+
+		QCOMPARE(a.getAABBox().min, b.getAABBox().min);
+		QCOMPARE(a.getAABBox().max, b.getAABBox().max);
+		QCOMPARE(a.getCentroid(), b.getCentroid());
+	}
+}
+
+void TestStelOBJ::initTestCase()
+{
+	QVERIFY(dir.isValid());
+	modelFile = dir.path() + "/terrain.obj";
+	referenceFile = dir.path() + "/reference.obj";
+	writeMaterials(dir.path() + "/terrain.mtl", 20.f);
+	writeTerrain(modelFile, true);
+	writeTerrain(referenceFile, false);
+	QVERIFY(QFileInfo(modelFile).size() > 4*(1<<20));
+}
+
+void TestStelOBJ::testParse()
+{
+	StelOBJ obj;
+	QVERIFY(obj.load(modelFile));
+	QVERIFY(!obj.isLoadedFromCache());
+
+	QCOMPARE(obj.getVertexList().size(), GRID*GRID);
+	QCOMPARE(int(obj.getFaceCount()), 2*(GRID-1)*(GRID-1));
+	QCOMPARE(obj.getMaterialList().size(), 2);
+	QCOMPARE(obj.getObjectList().size(), 2);
+	QCOMPARE(obj.getObjectList().at(0).name, QString("north"));
+	QCOMPARE(obj.getObjectList().at(1).name, QString("south"));
+	// a group per band of 20 rows
+	QCOMPARE(obj.getObjectList().at(0).groups.size() + obj.getObjectList().at(1).groups.size(), (GRID-1+19)/20);
+	QCOMPARE(obj.getAABBox().min[0], 0.f);
+	QCOMPARE(obj.getAABBox().max[1], float(GRID-1));
+
+	// relative references in other chunks resolve to the same vertices as absolute ones
+	StelOBJ reference;
+	QVERIFY(reference.load(referenceFile));
+	compare(obj, reference);
+}
+
+void TestStelOBJ::testCache()
+{
+	const QString cacheFile = StelOBJ::getCacheFileName(modelFile);
+	QCOMPARE(cacheFile, QFileInfo(modelFile).absoluteFilePath() + ".cache");
+	QFile::remove(cacheFile);
+
+	StelOBJ parsed;
+	QVERIFY(parsed.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(!parsed.isLoadedFromCache());
+	QVERIFY(QFile::exists(cacheFile));
+
+	StelOBJ cached;
+	QVERIFY(cached.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(cached.isLoadedFromCache());
+	QVERIFY(cached.isLoaded());
+	compare(parsed, cached);
+
+	// a damaged cache is ignored, and written again
+	QFile file(cacheFile);
+	QVERIFY(file.open(QIODevice::ReadWrite));
+	QVERIFY(file.resize(file.size() - 100));
+	file.close();
+	StelOBJ reparsed;
+	QVERIFY(reparsed.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(!reparsed.isLoadedFromCache());
+	compare(parsed, reparsed);
+	QVERIFY(cached.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(cached.isLoadedFromCache());
+}
+
+void TestStelOBJ::testCacheInvalidation()
+{
+	StelOBJ obj;
+	QVERIFY(obj.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(obj.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(obj.isLoadedFromCache());
+
+	// other load options
+	QVERIFY(obj.load(modelFile, StelOBJ::XZY, true));
+	QVERIFY(!obj.isLoadedFromCache());
+	QCOMPARE(obj.getAABBox().min[2], 0.f);
+	QVERIFY(obj.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(!obj.isLoadedFromCache());
+
+	// changed materials
+	writeMaterials(dir.path() + "/terrain.mtl", 50.f);
+	QVERIFY(obj.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(!obj.isLoadedFromCache());
+	QCOMPARE(material(obj, "rock").Ns, 50.f);
+	QVERIFY(obj.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(obj.isLoadedFromCache());
+	QCOMPARE(material(obj, "rock").Ns, 50.f);
+
+	// changed model
+	QFile file(modelFile);
+	QVERIFY(file.open(QIODevice::Append | QIODevice::Text));
+	file.write("# changed\n");
+	file.close();
+	QVERIFY(obj.load(modelFile, StelOBJ::XYZ, true));
+	QVERIFY(!obj.isLoadedFromCache());
+}
+
+void TestStelOBJ::benchmarkLoad()
+{
+	QFile::remove(StelOBJ::getCacheFileName(modelFile));
+	QElapsedTimer timer;
+	timer.start();
+	StelOBJ parsed;
+	QVERIFY(parsed.load(modelFile, StelOBJ::XYZ, true));
+	const qint64 parseTime = timer.restart();
+	StelOBJ cached;
+	QVERIFY(cached.load(modelFile, StelOBJ::XYZ, true));
+	const qint64 cacheTime = timer.elapsed();
+	QVERIFY(cached.isLoadedFromCache());
+
+	qDebug() << "Loading" << parsed.getFaceCount() << "faces:" << parseTime << "ms parsing (with writing the cache),"
+		 << cacheTime << "ms from the cache";
+	QVERIFY(cacheTime <= parseTime);
+}
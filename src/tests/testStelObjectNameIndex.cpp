@@ -0,0 +1,221 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStelObjectNameIndex.hpp"
+
+#include <QObject>
+#include <QtDebug>
+#include <QTest>
+
+#include <cstdlib>
+
+#include "StelObjectNameIndex.hpp"
+
+QTEST_GUILESS_MAIN(TestStelObjectNameIndex)
+
+namespace
+{
+	//! What StelObjectModule::listMatchingObjects() does without an index
+	QStringList scanNames(const QStringList& names, const QString& objPrefix, int maxNbItem, bool useStartOfWords)
+	{
+		QStringList result;
+		if (maxNbItem <= 0)
+			return result;
+		foreach (const QString& name, names)
+		{
+			if (!StelObjectNameIndex::matchName(name, objPrefix, useStartOfWords))
+				continue;
+			result.append(name);
+			if (result.size() >= maxNbItem)
+				break;
+		}
+		result.sort();
+		return result;
+	}
+
+	QString randomName()
+	{
+		static const char* const syllables[] = { "ka", "ro", "mi", "ne", "ta", "lu", "san", "vor", "el", "is", "ber", "gan", "po", "di", "ash" };
+		static const int count = sizeof(syllables)/sizeof(syllables[0]);
+		QString name;
+		const int n = 2 + qrand()%3;
+		for (int i=0;i<n;i++)
+			name += syllables[qrand()%count];
+		name[0] = name.at(0).toUpper();
+		return name;
+	}
+
+	//! Names like those of the minor bodies: numbered, provisional designations and comets
+	QStringList syntheticCorpus(int count)
+	{
+		QStringList names;
+		for (int i=0;i<count;i++)
+		{
+			switch (qrand()%4)
+			{
+				case 0:
+					names << QString("(%1) %2").arg(i+1).arg(randomName());
+					break;
+				case 1:
+					names << QString("%1 %2%3%4").arg(1900+qrand()%120).arg(QChar('A'+qrand()%24)).arg(QChar('A'+qrand()%25)).arg(qrand()%300);
+					break;
+				case 2:
+					names << QString("C/%1 %2 (%3)").arg(1900+qrand()%120).arg(QChar('A'+qrand()%24)).arg(randomName());
+					break;
+				default:
+					names << randomName();
+			}
+		}
+		return names;
+	}
+
+	const QStringList& largeCorpus()
+	{
+		static QStringList names;
+		if (names.isEmpty())
+		{
+			qsrand(500);
+			names = syntheticCorpus(500000);
+		}
+		return names;
+	}
+}
+
+void TestStelObjectNameIndex::testFoldName_data()
+{
+	QTest::addColumn<QString>("name");
+	QTest::addColumn<QString>("folded");
+	QTest::newRow("ascii") << "Ceres" << "ceres";
+	QTest::newRow("acute") << QString::fromUtf8("Éris") << "eris";
+	QTest::newRow("umlauts") << QString::fromUtf8("Wöhler Über Ärger") << "wohler uber arger";
+	QTest::newRow("caron") << QString::fromUtf8("Šenon Čapek") << "senon capek";
+	QTest::newRow("greek") << QString::fromUtf8("Ἀφροδίτη") << QString::fromUtf8("αφροδιτη");
+	QTest::newRow("digits") << "(1) Ceres" << "(1) ceres";
+}
+
+void TestStelObjectNameIndex::testFoldName()
+{
+	QFETCH(QString, name);
+	QFETCH(QString, folded);
+	QCOMPARE(StelObjectNameIndex::foldName(name), folded);
+	QCOMPARE(StelObjectNameIndex::foldName(name.toUpper()), folded);
+	QCOMPARE(StelObjectNameIndex::foldName(name).size(), name.size());
+}
+
+void TestStelObjectNameIndex::testMatching_data()
+{
+	QTest::addColumn<QString>("objPrefix");
+	QTest::addColumn<int>("maxNbItem");
+	QTest::newRow("common letter") << "a" << 5;
+	QTest::newRow("word") << "ceres" << 5;
+	QTest::newRow("upper case") << "CERES" << 20;
+	QTest::newRow("diacritics in name") << "eris" << 20;
+	QTest::newRow("diacritics in text") << QString::fromUtf8("Éri") << 20;
+	QTest::newRow("number") << "(1" << 8;
+	QTest::newRow("inside") << "ll" << 20;
+	QTest::newRow("greek") << QString::fromUtf8("φρο") << 5;
+	QTest::newRow("no match") << "xyzzy" << 5;
+	QTest::newRow("empty") << "" << 5;
+	QTest::newRow("no items") << "a" << 0;
+}
+
+void TestStelObjectNameIndex::testMatching()
+{
+	QFETCH(QString, objPrefix);
+	QFETCH(int, maxNbItem);
+
+	// Enough names that the index is used for rare text
+	qsrand(7);
+	QStringList names = syntheticCorpus(2000);
+	names << "(1) Ceres" << "Ceres" << QString::fromUtf8("(136199) Éris") << "Eris" << QString::fromUtf8("ERİS")
+	      << "Halley" << "1P/Halley" << QString::fromUtf8("Ἀφροδίτη") << QString::fromUtf8("Wöhler") << "" << "Ceres";
+	names += syntheticCorpus(2000);
+
+	StelObjectNameIndex index;
+	QVERIFY(!index.isValid());
+	index.setNames(names);
+	QVERIFY(index.isValid());
+	QCOMPARE(index.size(), names.size());
+	for (int startOfWords=0;startOfWords<2;startOfWords++)
+		QCOMPARE(index.listMatching(objPrefix, maxNbItem, startOfWords), scanNames(names, objPrefix, maxNbItem, startOfWords));
+
+	index.clear();
+	QVERIFY(!index.isValid());
+	QVERIFY(index.listMatching(objPrefix, maxNbItem, false).isEmpty());
+}
+
+void TestStelObjectNameIndex::testRandomCorpus()
+{
+	qsrand(11);
+	const QStringList names = syntheticCorpus(20000);
+	StelObjectNameIndex index;
+	index.setNames(names);
+
+	for (int i=0;i<500;i++)
+	{
+		// parts of existing names, and random text
+		const QString& name = names.at(qrand()%names.size());
+		const int start = name.isEmpty() ? 0 : qrand()%name.size();
+		QString text = name.mid(start, 1+qrand()%6);
+		if (i%3==0)
+			text = text.toUpper();
+		else if (i%7==0)
+			text = randomName().left(1+qrand()%4);
+		const int maxNbItem = 1+qrand()%15;
+		for (int startOfWords=0;startOfWords<2;startOfWords++)
+			QCOMPARE(index.listMatching(text, maxNbItem, startOfWords), scanNames(names, text, maxNbItem, startOfWords));
+	}
+}
+
+void TestStelObjectNameIndex::benchmarkLookup_data()
+{
+	QTest::addColumn<bool>("useIndex");
+	QTest::addColumn<bool>("useStartOfWords");
+	QTest::newRow("scan, start of names") << false << true;
+	QTest::newRow("index, start of names") << true << true;
+	QTest::newRow("scan, anywhere") << false << false;
+	QTest::newRow("index, anywhere") << true << false;
+}
+
+void TestStelObjectNameIndex::benchmarkLookup()
+{
+	QFETCH(bool, useIndex);
+	QFETCH(bool, useStartOfWords);
+
+	const QStringList& names = largeCorpus();
+	StelObjectNameIndex index;
+	index.setNames(names);
+	// what is typed in the search dialog, one key after the other
+	const QStringList keys = QStringList() << "H" << "Ha" << "Hal" << "Hall" << "Halle" << "Halley"
+					       << "(4" << "(41" << "(417" << "(4179" << "(41793" << "(41793)";
+	// build the index before timing
+	index.listMatching("Halley", 5, useStartOfWords);
+
+	QBENCHMARK
+	{
+		foreach (const QString& key, keys)
+		{
+			if (useIndex)
+				index.listMatching(key, 8, useStartOfWords);
+			else
+				scanNames(names, key, 8, useStartOfWords);
+		}
+	}
+}
@@ -0,0 +1,150 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+#include "tests/testStelProfiler.hpp"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include "StelProfiler.hpp"
+
+QTEST_GUILESS_MAIN(TestStelProfiler)
+
+namespace
+{
+	void busyWait(qint64 microSeconds)
+	{
+		QElapsedTimer t;
+		t.start();
+		while (t.nsecsElapsed() < microSeconds*1000)
+			;
+	}
+
+	void recordFrames(StelProfiler& profiler, int count)
+	{
+		for (int i=0; i<count; ++i)
+		{
+			profiler.beginFrame();
+			{
+				StelProfiler::Scope outer("Outer");
+				busyWait(100);
+				StelProfiler::Scope inner(QString("Inner"), StelProfiler::Draw);
+				busyWait(300);
+			}
+			profiler.endFrame();
+		}
+	}
+}
+
+void TestStelProfiler::testDisabled()
+{
+	StelProfiler profiler;
+	QVERIFY(!profiler.getFlagEnabled());
+	profiler.beginFrame();
+	QVERIFY(!StelProfiler::isRecording());
+	{
+		StelProfiler::Scope scope("Nothing");
+	}
+	profiler.endFrame();
+	QCOMPARE(profiler.getSummary().size(), 1);
+
+	profiler.setFlagOverlayDisplayed(true);
+	QVERIFY(profiler.getFlagEnabled());
+	profiler.setFlagEnabled(false);
+	QVERIFY(!profiler.getFlagOverlayDisplayed());
+}
+
+void TestStelProfiler::testSummary()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	recordFrames(profiler, 10);
+	QVERIFY(!StelProfiler::isRecording());
+
+	const QStringList summary = profiler.getSummary();
+	// Frame line, column titles, one line per scope
+	QCOMPARE(summary.size(), 4);
+	QVERIFY(summary.at(0).contains("average of 10 frames"));
+	// Sorted by CPU time, the outer scope includes the inner one
+	QVERIFY(summary.at(2).endsWith("update Outer"));
+	QVERIFY(summary.at(3).endsWith("draw   Inner"));
+	const double outerMs = summary.at(2).left(7).trimmed().toDouble();
+	const double innerMs = summary.at(3).left(7).trimmed().toDouble();
+	QVERIFY(innerMs >= 0.3);
+	QVERIFY(outerMs >= innerMs + 0.1);
+	// No OpenGL context, no GPU times
+	QCOMPARE(summary.at(3).mid(8, 7).trimmed(), QString("-"));
+}
+
+void TestStelProfiler::testHistory()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	recordFrames(profiler, StelProfiler::HistorySize + 10);
+	QVERIFY(profiler.getSummary().at(0).contains(QString("average of %1 frames").arg(StelProfiler::HistorySize)));
+
+	profiler.clear();
+	QCOMPARE(profiler.getSummary().size(), 1);
+}
+
+void TestStelProfiler::testTrace()
+{
+	StelProfiler profiler;
+	profiler.setFlagEnabled(true);
+	recordFrames(profiler, 5);
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName = dir.path() + "/trace.json";
+	QVERIFY(profiler.saveTrace(fileName));
+
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QJsonParseError error;
+	const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+	QCOMPARE(error.error, QJsonParseError::NoError);
+	const QJsonArray events = doc.object().value("traceEvents").toArray();
+	// 3 metadata events, and per frame the frame itself and the two scopes
+	QCOMPARE(events.size(), 3 + 5*3);
+
+	double frameTs = -1., lastFrameTs = -1.;
+	for (int i=3; i<events.size(); ++i)
+	{
+		const QJsonObject e = events.at(i).toObject();
+		QCOMPARE(e.value("ph").toString(), QString("X"));
+		QCOMPARE(e.value("tid").toInt(), 1);
+		const double ts = e.value("ts").toDouble();
+		if (e.value("name").toString()=="Frame")
+		{
+			// Oldest frame first
+			QVERIFY(ts > lastFrameTs);
+			lastFrameTs = frameTs = ts;
+		}
+		else
+		{
+			QVERIFY(frameTs >= 0.);
+			QVERIFY(ts >= frameTs);
+			QVERIFY(e.value("dur").toDouble() >= 100.);
+		}
+	}
+}
@@ -0,0 +1,210 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStelScriptWait.hpp"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+
+#include <cmath>
+#include <ctime>
+
+#include "StelScriptWait.hpp"
+
+QTEST_GUILESS_MAIN(TestStelScriptWait)
+
+namespace
+{
+	//! Stands in for the render loop: ticks the wait once per frame, and records the frame intervals
+	class FrameLoop
+	{
+	public:
+		FrameLoop(StelScriptWait* scriptWait, int intervalMs=16)
+			: scriptWait(scriptWait)
+			, lastFrameNs(0)
+			, frames(0)
+		{
+			timer.setTimerType(Qt::PreciseTimer);
+			timer.setInterval(intervalMs);
+			QObject::connect(&timer, &QTimer::timeout, [this]() { frame(); });
+			clock.start();
+			timer.start();
+		}
+
+		int getFrames() const { return frames; }
+
+		//! Mean and standard deviation of the frame intervals in ms
+		void getStatistics(double& mean, double& stdDev) const
+		{
+			mean = stdDev = 0.;
+			if (intervals.isEmpty())
+				return;
+			foreach (double dt, intervals)
+				mean += dt;
+			mean /= intervals.size();
+			foreach (double dt, intervals)
+				stdDev += (dt-mean)*(dt-mean);
+			stdDev = std::sqrt(stdDev/intervals.size());
+		}
+
+	private:
+		void frame()
+		{
+			const qint64 now = clock.nsecsElapsed();
+			if (frames>0)
+				intervals.append((now-lastFrameNs)*1e-6);
+			lastFrameNs = now;
+			++frames;
+			if (scriptWait)
+				scriptWait->tick();
+		}
+
+		StelScriptWait* scriptWait;
+		QTimer timer;
+		QElapsedTimer clock;
+		qint64 lastFrameNs;
+		int frames;
+		QVector<double> intervals;
+	};
+
+	//! CPU time used by the process, in seconds
+	double cpuTime()
+	{
+		return static_cast<double>(std::clock())/CLOCKS_PER_SEC;
+	}
+}
+
+void TestStelScriptWait::testSleep()
+{
+	StelScriptWait scriptWait;
+	QElapsedTimer timer;
+	timer.start();
+	QVERIFY(scriptWait.sleep(50));
+	QVERIFY(timer.elapsed() >= 45);
+	QVERIFY(!scriptWait.isWaiting());
+	QVERIFY(scriptWait.sleep(0));
+}
+
+void TestStelScriptWait::testWaitUntil()
+{
+	StelScriptWait scriptWait;
+	FrameLoop frameLoop(&scriptWait, 5);
+	QVERIFY(scriptWait.waitUntil([&frameLoop]() { return frameLoop.getFrames()>=10; }));
+	QVERIFY(frameLoop.getFrames()>=10);
+	// The condition is checked once before waiting, then once per frame, and never polled
+	QVERIFY(scriptWait.getConditionChecks() <= static_cast<quint64>(frameLoop.getFrames())+1);
+
+	// A condition which is met already does not wait
+	QVERIFY(scriptWait.waitUntil([]() { return true; }));
+}
+
+void TestStelScriptWait::testPauseResume()
+{
+	StelScriptWait scriptWait;
+	QVERIFY(scriptWait.waitWhilePaused());
+
+	scriptWait.pause();
+	QVERIFY(scriptWait.isPaused());
+	QTimer::singleShot(50, &scriptWait, SLOT(resume()));
+	QElapsedTimer timer;
+	timer.start();
+	QVERIFY(scriptWait.waitWhilePaused());
+	QVERIFY(timer.elapsed() >= 45);
+	QVERIFY(!scriptWait.isPaused());
+
+	// resuming does not end a sleep
+	QTimer::singleShot(10, &scriptWait, SLOT(pause()));
+	QTimer::singleShot(20, &scriptWait, SLOT(resume()));
+	timer.restart();
+	QVERIFY(scriptWait.sleep(100));
+	QVERIFY(timer.elapsed() >= 95);
+}
+
+void TestStelScriptWait::testAbort()
+{
+	StelScriptWait scriptWait;
+	bool innerResult = true;
+
+	// a script paused inside a wait, then stopped
+	QTimer::singleShot(10, [&scriptWait, &innerResult]() {
+		scriptWait.pause();
+		innerResult = scriptWait.waitWhilePaused();
+	});
+	QTimer::singleShot(30, &scriptWait, SLOT(abort()));
+	QElapsedTimer timer;
+	timer.start();
+	QVERIFY(!scriptWait.sleep(10000));
+	QVERIFY(timer.elapsed() < 5000);
+	QVERIFY(!innerResult);
+	QVERIFY(!scriptWait.isWaiting());
+
+	// the script does not wait any more until the next one starts
+	QVERIFY(scriptWait.isAborted());
+	QVERIFY(!scriptWait.sleep(10000));
+	QVERIFY(!scriptWait.waitUntil([]() { return false; }));
+	scriptWait.reset();
+	QVERIFY(scriptWait.sleep(1));
+}
+
+void TestStelScriptWait::benchmarkIdleWait()
+{
+	const int waitMs = 1000;
+	const char* modes[2] = { "event loop", "busy loop (before)" };
+	double cpu[2];
+	for (int mode=0; mode<2; ++mode)
+	{
+		StelScriptWait scriptWait;
+		FrameLoop frameLoop(&scriptWait);
+		QElapsedTimer wallClock;
+		wallClock.start();
+		const double cpuStart = cpuTime();
+
+		scriptWait.pause();
+		QTimer::singleShot(waitMs, &scriptWait, SLOT(resume()));
+		if (mode==0)
+			scriptWait.waitWhilePaused();
+		else
+		{
+			// how StelScriptEngineAgent used to wait
+			while (scriptWait.isPaused())
+				QCoreApplication::processEvents();
+		}
+
+		cpu[mode] = cpuTime()-cpuStart;
+		const double wall = wallClock.nsecsElapsed()*1e-9;
+		double mean, stdDev;
+		frameLoop.getStatistics(mean, stdDev);
+		qDebug() << QString("paused script, %1: %2% CPU, %3 frames, frame interval %4 +- %5 ms")
+			    .arg(modes[mode])
+			    .arg(100.*cpu[mode]/wall, 0, 'f', 1)
+			    .arg(frameLoop.getFrames())
+			    .arg(mean, 0, 'f', 2)
+			    .arg(stdDev, 0, 'f', 2);
+		QVERIFY(frameLoop.getFrames() > 0);
+	}
+#ifndef Q_OS_WIN
+	// std::clock() measures the CPU time of the process except on Windows, where it is the wall clock time
+	QVERIFY(cpu[0] < 0.3*waitMs/1000.);
+	QVERIFY(cpu[0] < cpu[1]);
+#endif
+}
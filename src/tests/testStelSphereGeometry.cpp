@@ -23,6 +23,7 @@
 #include <QtDebug>
 #include <QBuffer>
 #include <QTest>
+#include <QThread>
 
 #include <stdexcept>
 
@@ -544,3 +545,102 @@ void TestStelSphericalGeometry::benchmarkCreatePolygon()
 		SphericalPolygon holySquare(contours);
 	}
 }
+
+namespace
+{
+	// Queries the same regions from several threads, while their caches fill up
+	class QueryThread : public QThread
+	{
+	public:
+		QueryThread(const SphericalConvexPolygon& convex, const SphericalPolygon& polygon)
+			: convex(convex), polygon(polygon), area(0.), contained(false) {}
+		void run() Q_DECL_OVERRIDE
+		{
+			for (int i=0; i<20; ++i)
+			{
+				area = convex.getArea() + polygon.getArea();
+				contained = polygon.contains(convex);
+			}
+		}
+		const SphericalConvexPolygon& convex;
+		const SphericalPolygon& polygon;
+		double area;
+		bool contained;
+	};
+}
+
+void TestStelSphericalGeometry::testCachedGeometry()
+{
+	SphericalConvexPolygon cvx(smallSquareConvex);
+	const double smallArea = cvx.getOctahedronPolygon().getArea();
+	QVERIFY(std::fabs(cvx.getArea()-smallArea)<0.000001);
+	QVERIFY(std::fabs(cvx.getArea()-smallArea)<0.000001);
+	QVERIFY(bigSquare.contains(cvx));
+
+	// Changing the contour drops the cached polygon and area
+	cvx.setContour(bigSquareConvex.getConvexContour());
+	QVERIFY(cvx.getArea()>smallArea);
+	QVERIFY(std::fabs(cvx.getArea()-bigSquare.getArea())<0.000001);
+	QVERIFY(std::fabs(cvx.getOctahedronPolygon().getArea()-bigSquare.getArea())<0.000001);
+	QVERIFY(!smallSquare.contains(cvx));
+
+	SphericalPolygon poly(smallSquare);
+	QVERIFY(std::fabs(poly.getArea()-smallArea)<0.000001);
+	poly.setContours(QVector<QVector<Vec3d> >() << bigSquareConvex.getConvexContour());
+	QVERIFY(std::fabs(poly.getArea()-bigSquare.getArea())<0.000001);
+
+	// Copies have their own cache
+	SphericalConvexPolygon copy(cvx);
+	copy.setContour(smallSquareConvex.getConvexContour());
+	QVERIFY(std::fabs(copy.getArea()-smallArea)<0.000001);
+	QVERIFY(std::fabs(cvx.getArea()-bigSquare.getArea())<0.000001);
+
+	// The caches can be filled by several threads at once
+	SphericalConvexPolygon sharedConvex(smallSquareConvex);
+	SphericalPolygon sharedPolygon(bigSquare.getOctahedronPolygon());
+	QList<QueryThread*> threads;
+	for (int i=0; i<4; ++i)
+		threads << new QueryThread(sharedConvex, sharedPolygon);
+	foreach (QueryThread* t, threads)
+		t->start();
+	foreach (QueryThread* t, threads)
+	{
+		QVERIFY(t->wait(60000));
+		QVERIFY(std::fabs(t->area-smallArea-bigSquare.getArea())<0.000001);
+		QVERIFY(t->contained);
+	}
+	qDeleteAll(threads);
+}
+
+void TestStelSphericalGeometry::benchmarkRepeatedQueries_data()
+{
+	QTest::addColumn<bool>("cached");
+	QTest::newRow("new region for each query") << false;
+	QTest::newRow("same region") << true;
+}
+
+void TestStelSphericalGeometry::benchmarkRepeatedQueries()
+{
+	// A footprint tested again and again against the same outlines, like a sky image or an ocular field of view.
+	// A copy of a region has an empty cache, so it behaves as the regions did before they memoised their geometry.
+	QFETCH(bool, cached);
+	const SphericalConvexPolygon footprint(smallSquareConvex);
+	bool contained = false;
+	double area = 0.;
+	QBENCHMARK {
+		if (cached)
+		{
+			contained = holySquare.contains(footprint) || bigSquare.contains(footprint);
+			area = footprint.getIntersection(bigSquare)->getArea() + bigSquare.getArea();
+		}
+		else
+		{
+			const SphericalConvexPolygon footprintCopy(footprint);
+			const SphericalPolygon bigSquareCopy(bigSquare);
+			contained = holySquare.contains(footprintCopy) || bigSquareCopy.contains(footprintCopy);
+			area = footprintCopy.getIntersection(bigSquareCopy)->getArea() + bigSquareCopy.getArea();
+		}
+	}
+	QVERIFY(contained);
+	QVERIFY(area>0.);
+}
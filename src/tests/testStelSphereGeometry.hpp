@@ -44,6 +44,9 @@ private slots:
 	void benchmarkGetIntersection();
 	void testSerialize();
 	void benchmarkCreatePolygon();
+	void testCachedGeometry();
+	void benchmarkRepeatedQueries_data();
+	void benchmarkRepeatedQueries();
 private:
 	SphericalPolygon holySquare;
 	SphericalPolygon bigSquare;
@@ -0,0 +1,164 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+
+#include "tests/testStelTimeZoneCache.hpp"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTimeZone>
+#include <QVector>
+
+#include "StelTimeZoneCache.hpp"
+
+QTEST_GUILESS_MAIN(TestStelTimeZoneCache)
+
+namespace
+{
+	const qint64 MSecsPerDay = Q_INT64_C(86400000);
+
+	//! The offset as StelCore::getUTCOffset() computed it before the cache
+	int directOffset(const QTimeZone& tz, qint64 msecsUtc, bool useDST)
+	{
+		const QDateTime universal = QDateTime::fromMSecsSinceEpoch(msecsUtc, Qt::UTC);
+		return useDST ? tz.offsetFromUtc(universal) : tz.standardTimeOffset(universal);
+	}
+}
+
+void TestStelTimeZoneCache::testJulianDay()
+{
+	QCOMPARE(StelTimeZoneCache::jdToMSecsSinceEpoch(2440587.5), Q_INT64_C(0));
+	// J2000.0 is 2000-01-01T12:00:00 UTC
+	QCOMPARE(StelTimeZoneCache::jdToMSecsSinceEpoch(2451545.0), Q_INT64_C(946728000000));
+	// rounded to the second
+	QCOMPARE(StelTimeZoneCache::jdToMSecsSinceEpoch(2440587.5+0.4/86400.), Q_INT64_C(0));
+	QCOMPARE(StelTimeZoneCache::jdToMSecsSinceEpoch(2440587.5+0.6/86400.), Q_INT64_C(1000));
+	QCOMPARE(StelTimeZoneCache::jdToMSecsSinceEpoch(2440587.5-0.6/86400.), Q_INT64_C(-1000));
+	// the ends of the table
+	QCOMPARE(StelTimeZoneCache::jdToMSecsSinceEpoch(2378496.5), StelTimeZoneCache::CACHE_BEGIN);
+	QCOMPARE(StelTimeZoneCache::jdToMSecsSinceEpoch(2524593.5), StelTimeZoneCache::CACHE_END);
+}
+
+void TestStelTimeZoneCache::testInvalidZone()
+{
+	StelTimeZoneCache cache;
+	int shift = 42;
+	QVERIFY(!cache.offset("No/Such_Zone", 0, true, &shift));
+	QVERIFY(!cache.offset("No/Such_Zone", StelTimeZoneCache::CACHE_END+MSecsPerDay, false, &shift));
+	QCOMPARE(shift, 42);
+}
+
+void TestStelTimeZoneCache::testOffsets_data()
+{
+	QTest::addColumn<QString>("zone");
+	QTest::newRow("UTC") << "UTC";
+	QTest::newRow("Europe/Berlin") << "Europe/Berlin";
+	QTest::newRow("America/New_York") << "America/New_York";
+	// DST shifts by 30 minutes
+	QTest::newRow("Australia/Lord_Howe") << "Australia/Lord_Howe";
+	QTest::newRow("Asia/Kathmandu") << "Asia/Kathmandu";
+	// skipped a day when it moved across the date line in 2011
+	QTest::newRow("Pacific/Apia") << "Pacific/Apia";
+	// DST suspended during Ramadan
+	QTest::newRow("Africa/Casablanca") << "Africa/Casablanca";
+}
+
+void TestStelTimeZoneCache::testOffsets()
+{
+	QFETCH(QString, zone);
+	const QTimeZone tz(zone.toUtf8());
+	if (!tz.isValid())
+		QSKIP("The time zone is not available on this system");
+
+	// A century beyond both ends of the table, at varying times of day
+	QVector<qint64> times;
+	const qint64 from = StelTimeZoneCache::CACHE_BEGIN - 36525*MSecsPerDay;
+	const qint64 to = StelTimeZoneCache::CACHE_END + 36525*MSecsPerDay;
+	for (qint64 t=from; t<to; t+=13*MSecsPerDay+3600000)
+		times.append(t);
+	// The ends of the table, and dates far outside of it
+	times << StelTimeZoneCache::CACHE_BEGIN-1 << StelTimeZoneCache::CACHE_BEGIN
+	      << StelTimeZoneCache::CACHE_END-1 << StelTimeZoneCache::CACHE_END
+	      << StelTimeZoneCache::jdToMSecsSinceEpoch(0.) << StelTimeZoneCache::jdToMSecsSinceEpoch(5373484.5);
+	// Around each transition in the table
+	const QTimeZone::OffsetDataList transitions = tz.transitions(QDateTime::fromMSecsSinceEpoch(StelTimeZoneCache::CACHE_BEGIN, Qt::UTC),
+								     QDateTime::fromMSecsSinceEpoch(StelTimeZoneCache::CACHE_END, Qt::UTC));
+	foreach (const QTimeZone::OffsetData& transition, transitions)
+	{
+		const qint64 at = transition.atUtc.toMSecsSinceEpoch();
+		times << at-1 << at << at+1;
+	}
+
+	StelTimeZoneCache cache;
+	for (int useDST=0; useDST<2; ++useDST)
+	{
+		foreach (qint64 t, times)
+		{
+			int cached = 0;
+			QVERIFY(cache.offset(zone, t, useDST, &cached));
+			const int direct = directOffset(tz, t, useDST);
+			if (cached!=direct)
+				QFAIL(qPrintable(QString("%1 at %2, DST %3: cached %4s, direct %5s").arg(zone)
+						 .arg(QDateTime::fromMSecsSinceEpoch(t, Qt::UTC).toString(Qt::ISODate))
+						 .arg(useDST).arg(cached).arg(direct)));
+		}
+	}
+	qDebug() << QString("%1: %2 dates, %3 transitions").arg(zone).arg(times.size()).arg(transitions.size());
+}
+
+void TestStelTimeZoneCache::benchmarkOffset()
+{
+	const QString zone("Europe/Berlin");
+	const QTimeZone tz(zone.toUtf8());
+	if (!tz.isValid())
+		QSKIP("The time zone is not available on this system");
+
+	// The dates of a yearly ephemeris with hourly steps
+	const int nrOfDates = 24*365;
+	const qint64 start = StelTimeZoneCache::jdToMSecsSinceEpoch(2458119.5);
+	StelTimeZoneCache cache;
+	int shift = 0;
+	// Build the table before measuring
+	cache.offset(zone, start, true, &shift);
+
+	QElapsedTimer timer;
+	timer.start();
+	qint64 sum = 0;
+	for (int i=0; i<nrOfDates; ++i)
+		sum += directOffset(tz, start+i*Q_INT64_C(3600000), true);
+	const double directSeconds = qMax(timer.nsecsElapsed(), Q_INT64_C(1))*1e-9;
+
+	timer.restart();
+	qint64 cachedSum = 0;
+	for (int i=0; i<nrOfDates; ++i)
+	{
+		cache.offset(zone, start+i*Q_INT64_C(3600000), true, &shift);
+		cachedSum += shift;
+	}
+	const double cachedSeconds = qMax(timer.nsecsElapsed(), Q_INT64_C(1))*1e-9;
+	QCOMPARE(cachedSum, sum);
+	qDebug() << QString("%1 offsets/s direct, %2 offsets/s cached").arg(nrOfDates/directSeconds, 0, 'f', 0).arg(nrOfDates/cachedSeconds, 0, 'f', 0);
+
+	QBENCHMARK
+	{
+		for (int i=0; i<nrOfDates; ++i)
+			cache.offset(zone, start+i*Q_INT64_C(3600000), true, &shift);
+	}
+}
@@ -0,0 +1,240 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testStelTranslator.hpp"
+
+#include <QObject>
+#include <QThread>
+#include <QTranslator>
+#include <QtDebug>
+#include <QTest>
+
+#include "StelTranslator.hpp"
+#include "StelFileMgr.hpp"
+
+QTEST_GUILESS_MAIN(TestStelTranslator)
+
+namespace
+{
+	//! Translates many strings, some with plural forms, from a worker thread
+	class TranslatingThread : public QThread
+	{
+	public:
+		TranslatingThread(const StelTranslator& trans, int first) : trans(trans), first(first), errors(0) {}
+		int getErrors() const { return errors; }
+	protected:
+		void run() Q_DECL_OVERRIDE
+		{
+			for (int i=0; i<30000; ++i)
+			{
+				const QString s = QString("object %1").arg((first+i)%500);
+				if (trans.qtranslate(s) != s)
+					++errors;
+				if (trans.qtranslate("%1 day", "duration", first+i) != "%1 day")
+					++errors;
+			}
+		}
+	private:
+		const StelTranslator& trans;
+		int first;
+		int errors;
+	};
+
+	//! What StelTranslator::qtranslate() did before the memo
+	QString translateDirectly(const QTranslator& translator, const QString& s, const QString& c = QString(), int n = -1)
+	{
+		if (s.isEmpty())
+			return "";
+		QString res = translator.translate("", s.toUtf8().constData(), c.toUtf8().constData(), n);
+		if (res.isEmpty())
+			return s;
+		return res;
+	}
+
+	//! Language for which no catalog is built, so that strings come back unchanged
+	const QString untranslatedLang("xx");
+	//! Language whose catalog the tests depend on (see src/CMakeLists.txt)
+	const QString catalogLang("de");
+
+	//! Loads the catalog the StelTranslator of catalogLang uses
+	bool loadCatalog(QTranslator& translator)
+	{
+		return translator.load(StelFileMgr::getLocaleDir()+"/stellarium/"+catalogLang+".qm") && !translator.isEmpty();
+	}
+}
+
+void TestStelTranslator::testUntranslated()
+{
+	// there is no catalog for the language, so strings are returned unchanged
+	StelTranslator trans("stellarium", untranslatedLang);
+	for (int i=0; i<2; ++i)
+	{
+		QCOMPARE(trans.qtranslate(QString()), QString(""));
+		QCOMPARE(trans.qtranslate(""), QString(""));
+		QCOMPARE(trans.qtranslate("Magnitude"), QString("Magnitude"));
+		QCOMPARE(trans.qtranslate(QString("Magnitude")), QString("Magnitude"));
+		QCOMPARE(trans.qtranslate("Full Moon", "Moon phase"), QString("Full Moon"));
+		QCOMPARE(trans.qtranslate(QString("Full Moon"), QString("Moon phase")), QString("Full Moon"));
+		QCOMPARE(trans.qtranslate("%1 day", "", 3), QString("%1 day"));
+		QCOMPARE(trans.qtranslate(QString::fromUtf8("Große Wagen")), QString::fromUtf8("Große Wagen"));
+		QCOMPARE(trans.qtranslate("Große Wagen"), QString::fromUtf8("Große Wagen"));
+		QVERIFY(trans.tryQtranslate("Magnitude").isEmpty());
+	}
+}
+
+void TestStelTranslator::testReusedBuffer()
+{
+	// a character array which is not a literal goes through the memo of literals too
+	StelTranslator trans("stellarium", untranslatedLang);
+	char buffer[32];
+	qstrcpy(buffer, "Magnitude");
+	QCOMPARE(trans.qtranslate(buffer), QString("Magnitude"));
+	qstrcpy(buffer, "Distance");
+	QCOMPARE(trans.qtranslate(buffer), QString("Distance"));
+	char context[16];
+	qstrcpy(context, "distance");
+	QCOMPARE(trans.qtranslate(buffer, context), QString("Distance"));
+	qstrcpy(buffer, "km");
+	QCOMPARE(trans.qtranslate(buffer, context), QString("km"));
+}
+
+void TestStelTranslator::testCatalog()
+{
+	QTranslator translator;
+	if (!loadCatalog(translator))
+		QSKIP("The translations have not been built");
+	StelTranslator trans("stellarium", catalogLang);
+	QCOMPARE(translateDirectly(translator, "Magnitude"), QString("Visuelle Helligkeit"));
+	for (int i=0; i<2; ++i)
+	{
+		QCOMPARE(trans.qtranslate(QString("Magnitude")), translateDirectly(translator, "Magnitude"));
+		QCOMPARE(trans.qtranslate("Magnitude"), translateDirectly(translator, "Magnitude"));
+		QCOMPARE(trans.qtranslate(QString("Full Moon"), QString("Moon phase")), translateDirectly(translator, "Full Moon", "Moon phase"));
+		QCOMPARE(trans.qtranslate("Full Moon", "Moon phase"), translateDirectly(translator, "Full Moon", "Moon phase"));
+		QCOMPARE(trans.qtranslate("AU", "distance, astronomical unit"), translateDirectly(translator, "AU", "distance, astronomical unit"));
+		QCOMPARE(trans.tryQtranslate("Magnitude"), translateDirectly(translator, "Magnitude"));
+		// a string missing from the catalog is still returned unchanged
+		QCOMPARE(trans.qtranslate("object 1"), QString("object 1"));
+		QVERIFY(trans.tryQtranslate("object 1").isEmpty());
+	}
+}
+
+void TestStelTranslator::testThreads()
+{
+	StelTranslator trans("stellarium", untranslatedLang);
+	QList<TranslatingThread*> threads;
+	for (int i=0; i<4; ++i)
+		threads << new TranslatingThread(trans, i*1000);
+	foreach (TranslatingThread* thread, threads)
+		thread->start();
+	foreach (TranslatingThread* thread, threads)
+	{
+		QVERIFY(thread->wait(60000));
+		QCOMPARE(thread->getErrors(), 0);
+	}
+	qDeleteAll(threads);
+}
+
+void TestStelTranslator::benchmarkInfoString_data()
+{
+	QTest::addColumn<int>("mode");
+	QTest::newRow("QTranslator") << 0;
+	QTest::newRow("memo") << 1;
+	QTest::newRow("memo, literals") << 2;
+}
+
+void TestStelTranslator::benchmarkInfoString()
+{
+	QFETCH(int, mode);
+
+	// The translations which Planet::getInfoString() looks up for each of the planets.
+	// The planets themselves can't be created without the application, so the lookups are replayed
+	// against a real catalog, which both the QTranslator and the memo have to search.
+	QTranslator translator;
+	if (!loadCatalog(translator))
+		QSKIP("The translations have not been built");
+	StelTranslator trans("stellarium", catalogLang);
+	const QStringList strings = QStringList() << "Type" << "Magnitude" << "Absolute Magnitude" << "Mean Opposition Magnitude"
+						  << "Distance from Sun" << "Distance" << "Apparent diameter" << "Sidereal period"
+						  << "Sidereal day" << "Mean solar day" << "Phase angle" << "Elongation" << "Illuminated"
+						  << "Albedo" << "Phase";
+	const QString distance("distance");
+
+	QString expected;
+	foreach (const QString& s, strings)
+		expected += translateDirectly(translator, s);
+	expected += translateDirectly(translator, "AU", "distance, astronomical unit");
+	expected += translateDirectly(translator, "km", distance);
+	expected += translateDirectly(translator, "days", "duration");
+	expected += translateDirectly(translator, "Full Moon", "Moon phase");
+	QVERIFY(expected.startsWith("Typ"));
+	QVERIFY(expected.endsWith("Vollmond"));
+
+	QString info;
+
+	QBENCHMARK
+	{
+		for (int planet=0; planet<10; ++planet)
+		{
+			info.clear();
+			switch (mode)
+			{
+				case 0:
+					foreach (const QString& s, strings)
+						info += translateDirectly(translator, s);
+					info += translateDirectly(translator, "AU", "distance, astronomical unit");
+					info += translateDirectly(translator, "km", distance);
+					info += translateDirectly(translator, "days", "duration");
+					info += translateDirectly(translator, "Full Moon", "Moon phase");
+					break;
+				case 1:
+					foreach (const QString& s, strings)
+						info += trans.qtranslate(s);
+					info += trans.qtranslate(QString("AU"), QString("distance, astronomical unit"));
+					info += trans.qtranslate(QString("km"), distance);
+					info += trans.qtranslate(QString("days"), QString("duration"));
+					info += trans.qtranslate(QString("Full Moon"), QString("Moon phase"));
+					break;
+				default:
+					info += trans.qtranslate("Type");
+					info += trans.qtranslate("Magnitude");
+					info += trans.qtranslate("Absolute Magnitude");
+					info += trans.qtranslate("Mean Opposition Magnitude");
+					info += trans.qtranslate("Distance from Sun");
+					info += trans.qtranslate("Distance");
+					info += trans.qtranslate("Apparent diameter");
+					info += trans.qtranslate("Sidereal period");
+					info += trans.qtranslate("Sidereal day");
+					info += trans.qtranslate("Mean solar day");
+					info += trans.qtranslate("Phase angle");
+					info += trans.qtranslate("Elongation");
+					info += trans.qtranslate("Illuminated");
+					info += trans.qtranslate("Albedo");
+					info += trans.qtranslate("Phase");
+					info += trans.qtranslate("AU", "distance, astronomical unit");
+					info += trans.qtranslate("km", "distance");
+					info += trans.qtranslate("days", "duration");
+					info += trans.qtranslate("Full Moon", "Moon phase");
+					break;
+			}
+		}
+	}
+	QCOMPARE(info, expected);
+}
@@ -0,0 +1,570 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testTelescopeTransport.hpp"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QObject>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QtDebug>
+#include <QTest>
+
+#include <cmath>
+#include <cstring>
+
+#include "Server.hpp"
+#include "Socket.hpp"
+#include "TelescopePositionQueue.hpp"
+#include "TelescopeServerTransport.hpp"
+#include "TelescopeTcpTransport.hpp"
+
+QTEST_GUILESS_MAIN(TestTelescopeTransport)
+
+namespace
+{
+	//! RA 6h and Dec +30 deg in the units of the Stellarium telescope control protocol
+	const unsigned int RA_6H = 0x40000000u;
+	const int DEC_30 = 0x15555555;
+
+	Vec3d toVector(unsigned int raInt, int decInt)
+	{
+		const double ra  =  raInt * (M_PI/(unsigned int)0x80000000);
+		const double dec = decInt * (M_PI/(unsigned int)0x80000000);
+		return Vec3d(std::cos(ra)*std::cos(dec), std::sin(ra)*std::cos(dec), std::sin(dec));
+	}
+
+	//! Wait until @param condition is true, processing the events of the main thread
+	template <class Condition>
+	bool waitFor(Condition condition, int timeout = 5000)
+	{
+		const qint64 end = getNow() + timeout*1000LL;
+		while (!condition())
+		{
+			if (getNow() > end)
+				return false;
+			QTest::qWait(5);
+		}
+		return true;
+	}
+
+	//! A telescope mount on the loopback interface, which speaks the Stellarium telescope control protocol
+	//! (like the telescope server executables) or answers the LX200 position queries (like a mount on a serial port).
+	//! It runs in its own thread, as a real telescope would.
+	class FakeMount
+	{
+	public:
+		enum Protocol { Binary, Lx200 };
+
+		//! @param interval interval of the position messages of the binary protocol, in ms
+		FakeMount(Protocol protocol, int interval = 20)
+			: protocol(protocol)
+			, interval(interval)
+			, raInt(RA_6H)
+			, decInt(DEC_30)
+			, gotoCount(0)
+			, port(0)
+			, context(new QObject())
+			, server(Q_NULLPTR)
+		{
+			thread.start();
+			context->moveToThread(&thread);
+			run([this]() { listen(); });
+		}
+
+		~FakeMount()
+		{
+			run([this]() { context->deleteLater(); });
+			thread.quit();
+			thread.wait();
+		}
+
+		quint16 getPort() const { return port; }
+		unsigned int getRa() const { return static_cast<unsigned int>(raInt.load()); }
+		int getDec() const { return decInt.load(); }
+		int getGotoCount() const { return gotoCount.load(); }
+
+		//! Drop the connections, like a telescope server which has been restarted
+		void closeConnections()
+		{
+			run([this]()
+			{
+				foreach (QTcpSocket* socket, buffers.keys())
+					socket->abort();
+			});
+		}
+
+	private:
+		//! Run @param function in the thread of the mount, and wait for it
+		template <class Function>
+		void run(Function function)
+		{
+			QSemaphore done;
+			QTimer::singleShot(0, context, [&]() { function(); done.release(); });
+			done.acquire();
+		}
+
+		void listen()
+		{
+			server = new QTcpServer(context);
+			server->listen(QHostAddress::LocalHost, 0);
+			port = server->serverPort();
+			QObject::connect(server, &QTcpServer::newConnection, context, [this]() { accept(); });
+			if (protocol == Binary)
+			{
+				QTimer* timer = new QTimer(context);
+				QObject::connect(timer, &QTimer::timeout, context, [this]() { sendPositions(); });
+				timer->start(interval);
+			}
+		}
+
+		void accept()
+		{
+			while (server->hasPendingConnections())
+			{
+				QTcpSocket* socket = server->nextPendingConnection();
+				socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+				buffers.insert(socket, QByteArray());
+				QObject::connect(socket, &QTcpSocket::readyRead, context, [this, socket]() { readCommands(socket); });
+				QObject::connect(socket, &QTcpSocket::disconnected, context, [this, socket]()
+				{
+					buffers.remove(socket);
+					socket->deleteLater();
+				});
+			}
+		}
+
+		//! MessageCurrentPosition of the Stellarium telescope control protocol
+		void sendPositions()
+		{
+			char packet[24];
+			char* p = packet;
+			*p++ = 24;
+			*p++ = 0;
+			*p++ = 0;
+			*p++ = 0;
+			qint64 now = getNow();
+			for (int i=0; i<8; ++i, now>>=8)
+				*p++ = now;
+			unsigned int ra = getRa();
+			for (int i=0; i<4; ++i, ra>>=8)
+				*p++ = ra;
+			int dec = getDec();
+			for (int i=0; i<4; ++i, dec>>=8)
+				*p++ = dec;
+			for (int i=0; i<4; ++i)
+				*p++ = 0;
+			foreach (QTcpSocket* socket, buffers.keys())
+				socket->write(packet, sizeof(packet));
+		}
+
+		void readCommands(QTcpSocket* socket)
+		{
+			QByteArray& buffer = buffers[socket];
+			buffer += socket->readAll();
+			if (protocol == Binary)
+			{
+				// MessageGoto
+				while (buffer.size() >= 20)
+				{
+					const unsigned char* p = reinterpret_cast<const unsigned char*>(buffer.constData());
+					raInt.store(static_cast<int>(p[12] | (p[13]<<8) | (p[14]<<16) | (static_cast<unsigned int>(p[15])<<24)));
+					decInt.store(static_cast<int>(p[16] | (p[17]<<8) | (p[18]<<16) | (static_cast<unsigned int>(p[19])<<24)));
+					gotoCount.ref();
+					buffer.remove(0, 20);
+				}
+				return;
+			}
+
+			int end;
+			while ((end = buffer.indexOf('#')) >= 0)
+			{
+				const QByteArray command = buffer.left(end);
+				buffer.remove(0, end + 1);
+				if (command == ":GR")
+				{
+					const int seconds = static_cast<int>(getRa() * (86400.0/4294967296.0));
+					socket->write(QString("%1:%2:%3#").arg(seconds/3600, 2, 10, QChar('0')).arg((seconds/60)%60, 2, 10, QChar('0'))
+						      .arg(seconds%60, 2, 10, QChar('0')).toLatin1());
+				}
+				else if (command == ":GD")
+				{
+					const int seconds = static_cast<int>(getDec() * (360*3600.0/4294967296.0));
+					const int a = qAbs(seconds);
+					socket->write(QString("%1%2*%3:%4#").arg(seconds < 0 ? '-' : '+').arg(a/3600, 2, 10, QChar('0'))
+						      .arg((a/60)%60, 2, 10, QChar('0')).arg(a%60, 2, 10, QChar('0')).toLatin1());
+				}
+			}
+		}
+
+		Protocol protocol;
+		int interval;
+		QAtomicInt raInt;
+		QAtomicInt decInt;
+		QAtomicInt gotoCount;
+		quint16 port;
+		QThread thread;
+		QObject* context;
+		QTcpServer* server;
+		QHash<QTcpSocket*, QByteArray> buffers;
+	};
+
+	class Lx200Client;
+
+	//! Non-blocking socket of Lx200Client, multiplexed with select() like the serial ports of the telescope servers
+	class Lx200Connection : public Socket
+	{
+	public:
+		Lx200Connection(Lx200Client& client, SOCKET fd);
+		void send(const QByteArray& data) { writeBuffer += data; }
+		void prepareSelectFds(fd_set& readFds, fd_set& writeFds, int& fdMax) Q_DECL_OVERRIDE
+		{
+			if (IS_INVALID_SOCKET(fd))
+				return;
+			if (fdMax < (int)fd)
+				fdMax = (int)fd;
+			FD_SET(fd, &readFds);
+			if (!writeBuffer.isEmpty())
+				FD_SET(fd, &writeFds);
+		}
+		void handleSelectFds(const fd_set& readFds, const fd_set& writeFds) Q_DECL_OVERRIDE;
+
+	private:
+		Lx200Client& client;
+		QByteArray readBuffer;
+		QByteArray writeBuffer;
+	};
+
+	//! The part of TelescopeClientDirectLx200 which runs in the I/O thread, talking to the mount over
+	//! the loopback interface instead of a serial port: it polls the position with :GR# and :GD#,
+	//! and reports it to its TelescopeServerTransport.
+	class Lx200Client : public Server
+	{
+	public:
+		static const long long int POLL_INTERVAL = 20000;
+
+		Lx200Client(quint16 port)
+			: transport(Q_NULLPTR)
+			, connection(Q_NULLPTR)
+			, waiting(false)
+			, requestTime(0)
+			, nextPoll(0)
+		{
+			SOCKET fd = socket(AF_INET, SOCK_STREAM, 0);
+			struct sockaddr_in address;
+			memset(&address, 0, sizeof(address));
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0)
+				SETNONBLOCK(fd);
+			connection = new Lx200Connection(*this, fd);
+			addConnection(connection);
+			transport = new TelescopeServerTransport(*this, Q_NULLPTR);
+		}
+
+		void step(long long int timeout_micros) Q_DECL_OVERRIDE
+		{
+			const long long int now = GetNow();
+			if (!waiting && now >= nextPoll)
+			{
+				connection->send(":GR#:GD#");
+				waiting = true;
+				requestTime = now;
+				nextPoll = now + POLL_INTERVAL;
+			}
+			Server::step(timeout_micros);
+		}
+
+		//! The mount has answered both queries
+		void positionReceived(unsigned int raInt, int decInt)
+		{
+			// as in TelescopeClientDirectLx200, the server time is when the position was asked
+			transport->reportPosition(toVector(raInt, decInt), requestTime, 0);
+			waiting = false;
+		}
+
+		TelescopeServerTransport* transport;
+
+	private:
+		void gotoReceived(unsigned int, int) Q_DECL_OVERRIDE {}
+
+		Lx200Connection* connection;
+		bool waiting;
+		long long int requestTime;
+		long long int nextPoll;
+	};
+
+	Lx200Connection::Lx200Connection(Lx200Client& client, SOCKET fd)
+		: Socket(client, fd)
+		, client(client)
+	{
+	}
+
+	void Lx200Connection::handleSelectFds(const fd_set& readFds, const fd_set& writeFds)
+	{
+		if (IS_INVALID_SOCKET(fd))
+			return;
+		if (FD_ISSET(fd, &writeFds))
+		{
+			const int rc = writeNonblocking(writeBuffer.constData(), writeBuffer.size());
+			if (rc > 0)
+				writeBuffer.remove(0, rc);
+		}
+		if (FD_ISSET(fd, &readFds))
+		{
+			char data[256];
+			const int rc = readNonblocking(data, sizeof(data));
+			if (rc <= 0)
+			{
+				hangup();
+				return;
+			}
+			readBuffer.append(data, rc);
+			// "HH:MM:SS#sDD*MM:SS#"
+			const int first = readBuffer.indexOf('#');
+			const int second = first < 0 ? -1 : readBuffer.indexOf('#', first + 1);
+			if (second < 0)
+				return;
+			const QList<QByteArray> ra = readBuffer.left(first).split(':');
+			const QByteArray dec = readBuffer.mid(first + 1, second - first - 1);
+			readBuffer.remove(0, second + 1);
+			if (ra.size() != 3 || dec.size() != 9)
+				return;
+			const int raSeconds = ra.at(0).toInt()*3600 + ra.at(1).toInt()*60 + ra.at(2).toInt();
+			int decSeconds = dec.mid(1, 2).toInt()*3600 + dec.mid(4, 2).toInt()*60 + dec.mid(7, 2).toInt();
+			if (dec.at(0) == '-')
+				decSeconds = -decSeconds;
+			client.positionReceived((unsigned int)std::floor(raSeconds * (4294967296.0/86400.0)),
+						(int)std::floor(decSeconds * (4294967296.0/(360*3600.0))));
+		}
+	}
+
+	//! Pushes numbered positions as fast as the queue takes them
+	class ProducerThread : public QThread
+	{
+	public:
+		ProducerThread(TelescopePositionQueue& queue, int count) : queue(queue), count(count) {}
+	protected:
+		void run() Q_DECL_OVERRIDE
+		{
+			Position position;
+			position.pos = Vec3d(1., 0., 0.);
+			position.status = 0;
+			for (int i=0; i<count; ++i)
+			{
+				position.server_micros = i;
+				position.client_micros = i;
+				while (!queue.push(position))
+					QThread::yieldCurrentThread();
+			}
+		}
+	private:
+		TelescopePositionQueue& queue;
+		int count;
+	};
+}
+
+void TestTelescopeTransport::testPositionQueue()
+{
+	TelescopePositionQueue queue;
+	Position position;
+	QVERIFY(queue.isEmpty());
+	QVERIFY(!queue.pop(position));
+
+	position.pos = Vec3d(0., 1., 0.);
+	position.status = 0;
+	for (int i=0; i<TelescopePositionQueue::CAPACITY; ++i)
+	{
+		position.server_micros = i;
+		QVERIFY(queue.push(position));
+	}
+	position.server_micros = -1;
+	QVERIFY(!queue.push(position));
+	QCOMPARE(queue.getDroppedCount(), 1);
+
+	for (int i=0; i<TelescopePositionQueue::CAPACITY; ++i)
+	{
+		QVERIFY(queue.pop(position));
+		QCOMPARE(position.server_micros, qint64(i));
+	}
+	QVERIFY(queue.isEmpty());
+	QVERIFY(!queue.pop(position));
+
+	// wrap around
+	for (int i=0; i<3*TelescopePositionQueue::CAPACITY; ++i)
+	{
+		position.server_micros = i;
+		QVERIFY(queue.push(position));
+		QVERIFY(queue.pop(position));
+		QCOMPARE(position.server_micros, qint64(i));
+	}
+}
+
+void TestTelescopeTransport::testConcurrentQueue()
+{
+	const int count = 200000;
+	TelescopePositionQueue queue;
+	ProducerThread producer(queue, count);
+	producer.start();
+	Position position;
+	int next = 0;
+	while (next < count)
+	{
+		if (!queue.pop(position))
+		{
+			QThread::yieldCurrentThread();
+			continue;
+		}
+		if (position.server_micros != next)
+			QFAIL(qPrintable(QString("position %1 received instead of %2").arg(position.server_micros).arg(next)));
+		++next;
+	}
+	QVERIFY(producer.wait(10000));
+	QVERIFY(queue.isEmpty());
+}
+
+void TestTelescopeTransport::testBinaryProtocol()
+{
+	FakeMount mount(FakeMount::Binary);
+	QThread ioThread;
+	ioThread.start();
+	TelescopeTcpTransport* transport = new TelescopeTcpTransport("test", QHostAddress::LocalHost, mount.getPort());
+	transport->startInThread(&ioThread);
+
+	QVERIFY(waitFor([transport]() { return transport->isConnected(); }));
+	Position position;
+	QVERIFY(waitFor([&]() { return transport->getPositions().pop(position); }));
+	QVERIFY((position.pos - toVector(RA_6H, DEC_30)).length() < 1e-9);
+	QVERIFY(position.client_micros >= position.server_micros);
+
+	// the mount goes to the requested position at once
+	const unsigned int ra = 0xC0000000u;
+	const int dec = -DEC_30;
+	QMetaObject::invokeMethod(transport, "sendGoto", Qt::QueuedConnection, Q_ARG(unsigned int, ra), Q_ARG(int, dec));
+	QVERIFY(waitFor([&]() { return mount.getGotoCount() == 1; }));
+	QCOMPARE(mount.getRa(), ra);
+	QCOMPARE(mount.getDec(), dec);
+	QVERIFY(waitFor([&]()
+	{
+		return transport->getPositions().pop(position) && (position.pos - toVector(ra, dec)).length() < 1e-9;
+	}));
+	QCOMPARE(transport->getDisconnectionCount(), 0);
+
+	transport->destroy();
+	ioThread.quit();
+	ioThread.wait();
+}
+
+void TestTelescopeTransport::testReconnect()
+{
+	FakeMount mount(FakeMount::Binary);
+	QThread ioThread;
+	ioThread.start();
+	TelescopeTcpTransport* transport = new TelescopeTcpTransport("test", QHostAddress::LocalHost, mount.getPort());
+	transport->startInThread(&ioThread);
+	QVERIFY(waitFor([transport]() { return transport->isConnected(); }));
+
+	mount.closeConnections();
+	QVERIFY(waitFor([transport]() { return !transport->isConnected(); }));
+	QCOMPARE(transport->getDisconnectionCount(), 1);
+	QVERIFY(waitFor([transport]() { return transport->isConnected(); }, 3*TelescopeTcpTransport::RECONNECT_INTERVAL));
+
+	transport->destroy();
+	ioThread.quit();
+	ioThread.wait();
+}
+
+void TestTelescopeTransport::benchmarkFrames_data()
+{
+	QTest::addColumn<int>("protocol");
+	QTest::addColumn<bool>("useIoThread");
+	QTest::newRow("binary, frame loop") << int(FakeMount::Binary) << false;
+	QTest::newRow("binary, I/O thread") << int(FakeMount::Binary) << true;
+	QTest::newRow("LX200, frame loop") << int(FakeMount::Lx200) << false;
+	QTest::newRow("LX200, I/O thread") << int(FakeMount::Lx200) << true;
+}
+
+void TestTelescopeTransport::benchmarkFrames()
+{
+	QFETCH(int, protocol);
+	QFETCH(bool, useIoThread);
+
+	// The frame loop does what TelescopeControl::update() did before and does now:
+	// before, the TCP socket was served by the main event loop and the serial servers were stepped with a 10 ms select();
+	// now, it only takes the positions out of the queue.
+	FakeMount mount(FakeMount::Protocol(protocol));
+	QThread ioThread;
+	ioThread.start();
+	TelescopeTransport* transport;
+	Lx200Client* lx200 = Q_NULLPTR;
+	if (protocol == FakeMount::Binary)
+		transport = new TelescopeTcpTransport("test", QHostAddress::LocalHost, mount.getPort());
+	else
+	{
+		lx200 = new Lx200Client(mount.getPort());
+		transport = lx200->transport;
+	}
+	if (useIoThread)
+		transport->startInThread(&ioThread);
+	else if (protocol == FakeMount::Binary)
+		transport->startInThread(Q_NULLPTR);
+
+	const int frames = 150;
+	qint64 totalFrameTime = 0;
+	qint64 maxFrameTime = 0;
+	qint64 totalLatency = 0;
+	int received = 0;
+	for (int frame=0; frame<frames; ++frame)
+	{
+		const qint64 start = getNow();
+		if (!useIoThread)
+		{
+			if (lx200)
+				lx200->step(10000);
+			else
+				QCoreApplication::processEvents();
+		}
+		Position position;
+		while (transport->getPositions().pop(position))
+		{
+			totalLatency += getNow() - position.server_micros;
+			++received;
+		}
+		const qint64 frameTime = getNow() - start;
+		totalFrameTime += frameTime;
+		maxFrameTime = qMax(maxFrameTime, frameTime);
+		// drawing the rest of the frame
+		QThread::msleep(10);
+	}
+
+	qDebug() << QTest::currentDataTag() << "- telescope time per frame: mean" << totalFrameTime/frames << "us, max" << maxFrameTime
+		 << "us; positions:" << received << ", mean latency" << (received ? totalLatency/received : 0) << "us";
+	QVERIFY(received > 0);
+
+	transport->destroy();
+	ioThread.quit();
+	ioThread.wait();
+	delete lx200;
+}
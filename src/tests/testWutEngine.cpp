@@ -0,0 +1,293 @@
+/*
+ * Stellarium
+ * Copyright (C) 2018 Stellarium Developers
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA  02110-1335, USA.
+ */
+
+
+#include "tests/testWutEngine.hpp"
+
+#include "WutEngine.hpp"
+
+#include <QElapsedTimer>
+#include <QtDebug>
+
+#include <cmath>
+#include <cstdlib>
+
+QTEST_GUILESS_MAIN(TestWutEngine)
+
+namespace
+{
+	// Vienna, in the night of 2018-09-15/16. The search of the night starts at noon UT.
+	const double LATITUDE = 48.2;
+	const double LONGITUDE = 16.37;
+	const double START_JD = 2458377.;
+	const double SEARCH_STEP = 0.0034722;
+	const int SEARCH_STEPS = 288;
+
+	//! Local mean sidereal time (degrees)
+	double siderealTime(double JD)
+	{
+		return 280.46061837 + 360.98564736629*(JD-2451545.) + LONGITUDE;
+	}
+
+	//! Transformation from the equatorial to the horizontal frame, as computed by StelObserver
+	WutEngine::Step makeStep(double JD)
+	{
+		const Mat4d matAltAzToEqu = Mat4d::zrotation(siderealTime(JD)*M_PI/180.) * Mat4d::yrotation((90.-LATITUDE)*M_PI/180.);
+		return WutEngine::Step(JD, matAltAzToEqu.transpose());
+	}
+
+	Vec3d equatorialPos(double ra, double dec)
+	{
+		return Vec3d(std::cos(dec)*std::cos(ra), std::cos(dec)*std::sin(ra), std::sin(dec));
+	}
+
+	//! Geometric altitude (radians) from the classic formula sin(h) = sin(phi)sin(dec) + cos(phi)cos(dec)cos(H)
+	double altitude(double JD, const Vec3d& pos)
+	{
+		const double ra = std::atan2(pos[1], pos[0]);
+		const double dec = std::asin(pos[2]/pos.length());
+		const double phi = LATITUDE*M_PI/180.;
+		const double H = siderealTime(JD)*M_PI/180. - ra;
+		return std::asin(std::sin(phi)*std::sin(dec) + std::cos(phi)*std::cos(dec)*std::cos(H));
+	}
+
+	//! The rule of the previous implementation, which checked getVMagnitudeWithExtinction() and isAboveRealHorizon()
+	//! of each object after moving the core to JD
+	bool isVisibleReference(double JD, const WutEngine::Object& object, const WutEngine::Parameters& params)
+	{
+		const double alt = altitude(JD, object.j2000Pos);
+		Vec3d altAzPos(std::cos(alt), 0., std::sin(alt));
+		float vMag = object.vMag;
+		if (params.atmosphere)
+			params.extinction.forward(altAzPos, &vMag);
+		bool visible = vMag<=params.magLimit;
+		if (params.magnitudeRule==WutEngine::MagnitudeIgnored)
+			visible = true;
+		else if (params.magnitudeRule==WutEngine::MagnitudeLimitOrUnknown)
+			visible = visible || (object.vMag>90.f && params.magLimit>=19.f);
+		if (params.atmosphere)
+			params.refraction.forward(altAzPos);
+		return visible && altAzPos[2]>=0.;
+	}
+
+	//! Random stars, a few of them without a magnitude
+	QVector<WutEngine::Object> makeCatalog(int count)
+	{
+		qsrand(1);
+		QVector<WutEngine::Object> objects;
+		objects.reserve(count);
+		for (int i=0; i<count; ++i)
+		{
+			const double ra = 2.*M_PI*qrand()/RAND_MAX;
+			const double dec = std::asin(2.*qrand()/RAND_MAX - 1.);
+			const float vMag = (i%50==0) ? 99.f : -1.f + 15.f*qrand()/RAND_MAX;
+			objects.append(WutEngine::Object(equatorialPos(ra, dec), vMag));
+		}
+		return objects;
+	}
+
+	//! Evening, midnight and morning of the night
+	QVector<WutEngine::Step> makeNightSteps()
+	{
+		QVector<WutEngine::Step> steps;
+		steps << makeStep(START_JD + 0.23) << makeStep(START_JD + 0.46) << makeStep(START_JD + 0.69);
+		return steps;
+	}
+
+	//! Low precision position of the Sun (Astronomical Almanac), at 1 AU
+	Vec3d sunPos(double JD)
+	{
+		const double n = JD - 2451545.;
+		const double L = 280.460 + 0.9856474*n;
+		const double g = (357.528 + 0.9856003*n)*M_PI/180.;
+		const double lambda = (L + 1.915*std::sin(g) + 0.020*std::sin(2.*g))*M_PI/180.;
+		const double eps = (23.439 - 0.0000004*n)*M_PI/180.;
+		return Vec3d(std::cos(lambda), std::cos(eps)*std::sin(lambda), std::sin(eps)*std::sin(lambda));
+	}
+}
+
+void TestWutEngine::testVisibility_data()
+{
+	QTest::addColumn<bool>("atmosphere");
+	QTest::addColumn<int>("magnitudeRule");
+	QTest::addColumn<double>("magLimit");
+	QTest::newRow("no atmosphere") << false << int(WutEngine::MagnitudeLimit) << 6.;
+	QTest::newRow("atmosphere") << true << int(WutEngine::MagnitudeLimit) << 6.;
+	QTest::newRow("faint limit") << true << int(WutEngine::MagnitudeLimit) << 12.;
+	QTest::newRow("magnitude ignored") << true << int(WutEngine::MagnitudeIgnored) << 6.;
+	QTest::newRow("unknown magnitude") << true << int(WutEngine::MagnitudeLimitOrUnknown) << 19.;
+}
+
+void TestWutEngine::testVisibility()
+{
+	QFETCH(bool, atmosphere);
+	QFETCH(int, magnitudeRule);
+	QFETCH(double, magLimit);
+
+	WutEngine::Parameters params;
+	params.atmosphere = atmosphere;
+	params.magnitudeRule = static_cast<WutEngine::MagnitudeRule>(magnitudeRule);
+	params.magLimit = magLimit;
+	params.extinction.setExtinctionCoefficient(0.2f);
+
+	// large enough to be checked in parallel
+	const QVector<WutEngine::Object> objects = makeCatalog(5*WutEngine::PARALLEL_BATCH_SIZE + 17);
+	const QVector<WutEngine::Step> steps = makeNightSteps();
+	const QVector<quint32> visibility = WutEngine::computeVisibility(objects, objects.size(), steps, params);
+	QCOMPARE(visibility.size(), objects.size());
+
+	int visible = 0;
+	for (int i=0; i<objects.size(); ++i)
+	{
+		quint32 expected = 0;
+		for (int s=0; s<steps.size(); ++s)
+		{
+			if (isVisibleReference(steps.at(s).JD, objects.at(i), params))
+				expected |= 1u<<s;
+			QCOMPARE(WutEngine::isVisible(objects.at(i), steps.at(s).matJ2000ToAltAz, params), (expected & (1u<<s))!=0);
+		}
+		if (visibility.at(i)!=expected)
+			QFAIL(qPrintable(QString("object %1: mask %2, expected %3").arg(i).arg(visibility.at(i)).arg(expected)));
+		if (expected)
+			++visible;
+	}
+	// the catalog has objects on both sides of the limits
+	QVERIFY(visible>0);
+	QVERIFY(visible<objects.size());
+}
+
+void TestWutEngine::testMovingObjects()
+{
+	WutEngine::Parameters params;
+	params.atmosphere = true;
+
+	// each object moves by some degrees between the steps
+	const QVector<WutEngine::Object> catalog = makeCatalog(300);
+	const QVector<WutEngine::Step> steps = makeNightSteps();
+	QVector<WutEngine::Object> objects;
+	for (int s=0; s<steps.size(); ++s)
+	{
+		const Mat4d motion = Mat4d::zrotation(0.1*s);
+		foreach(const WutEngine::Object& object, catalog)
+			objects.append(WutEngine::Object(motion*object.j2000Pos, object.vMag - 0.5f*s));
+	}
+
+	const QVector<quint32> visibility = WutEngine::computeVisibility(objects, catalog.size(), steps, params);
+	QCOMPARE(visibility.size(), catalog.size());
+	for (int i=0; i<catalog.size(); ++i)
+	{
+		quint32 expected = 0;
+		for (int s=0; s<steps.size(); ++s)
+		{
+			if (isVisibleReference(steps.at(s).JD, objects.at(s*catalog.size()+i), params))
+				expected |= 1u<<s;
+		}
+		QCOMPARE(visibility.at(i), expected);
+	}
+}
+
+void TestWutEngine::testNightEvents_data()
+{
+	QTest::addColumn<bool>("atmosphere");
+	QTest::newRow("no atmosphere") << false;
+	QTest::newRow("atmosphere") << true;
+}
+
+void TestWutEngine::testNightEvents()
+{
+	QFETCH(bool, atmosphere);
+
+	WutEngine::Parameters params;
+	params.atmosphere = atmosphere;
+
+	// The search of the previous implementation, which moved the core to each step
+	double sunset = -1, sunrise = -1, midnight = -1, lc = 100.0;
+	QVector<WutEngine::Step> steps;
+	for (int i=0; i<SEARCH_STEPS; i++)
+	{
+		const double JD = START_JD + i*SEARCH_STEP;
+		steps.append(makeStep(JD));
+
+		const double h = altitude(JD, sunPos(JD));
+		Vec3d altAzPos(std::cos(h), 0., std::sin(h));
+		if (atmosphere)
+			params.refraction.forward(altAzPos);
+		const double alt = std::asin(altAzPos[2]/altAzPos.length())*180./M_PI;
+		if (alt>=-7 && alt<=-5 && sunset<0)
+			sunset = JD;
+		if (alt>=-7 && alt<=-5)
+			sunrise = JD;
+		if (alt<lc)
+		{
+			midnight = JD;
+			lc = alt;
+		}
+	}
+	QVERIFY(sunset>0. && sunrise>sunset);
+
+	// The engine interpolates the Sun, so it may cross a limit one step earlier or later
+	const WutEngine::NightEvents events = WutEngine::findNightEvents(steps, sunPos(steps.first().JD), sunPos(steps.last().JD), params);
+	QVERIFY2(std::fabs(events.sunset-sunset)<=SEARCH_STEP*1.01, qPrintable(QString("sunset %1, expected %2").arg(events.sunset, 0, 'f', 5).arg(sunset, 0, 'f', 5)));
+	QVERIFY2(std::fabs(events.sunrise-sunrise)<=SEARCH_STEP*1.01, qPrintable(QString("sunrise %1, expected %2").arg(events.sunrise, 0, 'f', 5).arg(sunrise, 0, 'f', 5)));
+	QVERIFY2(std::fabs(events.midnight-midnight)<=SEARCH_STEP*1.01, qPrintable(QString("midnight %1, expected %2").arg(events.midnight, 0, 'f', 5).arg(midnight, 0, 'f', 5)));
+}
+
+void TestWutEngine::benchmarkVisibility_data()
+{
+	QTest::addColumn<bool>("serial");
+	QTest::newRow("serial") << true;
+	QTest::newRow("engine") << false;
+}
+
+void TestWutEngine::benchmarkVisibility()
+{
+	QFETCH(bool, serial);
+
+	WutEngine::Parameters params;
+	params.atmosphere = true;
+	params.magLimit = 8.;
+
+	// about the size of the Hipparcos and DSO catalogues, at the three times of a night
+	const QVector<WutEngine::Object> objects = makeCatalog(100000);
+	const QVector<WutEngine::Step> steps = makeNightSteps();
+	QVector<quint32> visibility(objects.size());
+
+	QElapsedTimer timer;
+	qint64 checks = 0;
+	timer.start();
+	QBENCHMARK
+	{
+		if (serial)
+		{
+			// one object after the other, as the dialog did
+			for (int s=0; s<steps.size(); ++s)
+			{
+				for (int i=0; i<objects.size(); ++i)
+				{
+					if (WutEngine::isVisible(objects.at(i), steps.at(s).matJ2000ToAltAz, params))
+						visibility[i] |= 1u<<s;
+				}
+			}
+		}
+		else
+			visibility = WutEngine::computeVisibility(objects, objects.size(), steps, params);
+		checks += objects.size()*steps.size();
+	}
+	qDebug() << qRound64(checks / (timer.nsecsElapsed() / 1e9)) << "checks/s";
+}